@@ -0,0 +1,80 @@
+// Arc and Rc against std::shared_ptr
+#include "bench_common.hpp"
+#include "../include/rusty/arc.hpp"
+#include "../include/rusty/rc.hpp"
+#include <memory>
+
+struct RustyArc {
+    typedef rusty::Arc<uint64_t> Ptr;
+    static Ptr make(uint64_t x) { return Ptr::make(x); }
+    static Ptr clone(const Ptr& p) { return p.clone(); }
+};
+
+struct RustyRc {
+    typedef rusty::Rc<uint64_t> Ptr;
+    static Ptr make(uint64_t x) { return Ptr::make(x); }
+    static Ptr clone(const Ptr& p) { return p.clone(); }
+};
+
+struct StdShared {
+    typedef std::shared_ptr<uint64_t> Ptr;
+    static Ptr make(uint64_t x) { return std::make_shared<uint64_t>(x); }
+    static Ptr clone(const Ptr& p) { return p; }
+};
+
+// One allocation for the count and the value, then the drop
+template<typename A>
+void BM_Make(benchmark::State& state) {
+    uint64_t i = 0;
+    for (auto _ : state) {
+        typename A::Ptr p = A::make(i++);
+        benchmark::DoNotOptimize(p);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()));
+}
+
+// n handles to one value: n count increments, then n decrements
+template<typename A>
+void BM_CloneDrop(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    typename A::Ptr p = A::make(1);
+    std::vector<typename A::Ptr> handles;
+    handles.reserve(n);
+    for (auto _ : state) {
+        for (size_t i = 0; i < n; i++) handles.push_back(A::clone(p));
+        handles.clear();
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+
+// n separately allocated values read through their handles
+template<typename A>
+void BM_Deref(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    std::vector<typename A::Ptr> handles;
+    handles.reserve(n);
+    for (size_t i = 0; i < n; i++) handles.push_back(A::make(i));
+    for (auto _ : state) {
+        uint64_t total = 0;
+        for (const typename A::Ptr& h : handles) total += *h;
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+    bench::report_footprint(state, n, [&] {
+        std::vector<typename A::Ptr> more;
+        more.reserve(n);
+        for (size_t i = 0; i < n; i++) more.push_back(A::make(i));
+        return more;
+    });
+}
+
+#define RUSTY_BENCH_PTR(A)                                     \
+    BENCHMARK_TEMPLATE(BM_Make, A);                            \
+    BENCHMARK_TEMPLATE(BM_CloneDrop, A)->Apply(bench::sizes); \
+    BENCHMARK_TEMPLATE(BM_Deref, A)->Apply(bench::sizes)
+
+RUSTY_BENCH_PTR(RustyArc);
+RUSTY_BENCH_PTR(RustyRc);
+RUSTY_BENCH_PTR(StdShared);
+
+BENCHMARK_MAIN();
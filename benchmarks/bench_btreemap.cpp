@@ -0,0 +1,121 @@
+// BTreeMap against std::map
+#include "bench_common.hpp"
+#include "../include/rusty/btreemap.hpp"
+#include <map>
+
+struct RustyTree {
+    typedef rusty::BTreeMap<uint64_t, uint64_t> Map;
+    static void insert(Map& m, uint64_t k, uint64_t v) { m.insert(k, v); }
+    static bool contains(const Map& m, uint64_t k) { return m.contains_key(k); }
+    static void erase(Map& m, uint64_t k) { m.remove(k); }
+    static uint64_t sum(const Map& m) {
+        uint64_t total = 0;
+        for (auto kv : m) total += kv.second;
+        return total;
+    }
+};
+
+struct StdTree {
+    typedef std::map<uint64_t, uint64_t> Map;
+    static void insert(Map& m, uint64_t k, uint64_t v) { m.emplace(k, v); }
+    static bool contains(const Map& m, uint64_t k) { return m.find(k) != m.end(); }
+    static void erase(Map& m, uint64_t k) { m.erase(k); }
+    static uint64_t sum(const Map& m) {
+        uint64_t total = 0;
+        for (const auto& kv : m) total += kv.second;
+        return total;
+    }
+};
+
+template<typename A>
+typename A::Map build(const std::vector<uint64_t>& keys) {
+    typename A::Map m;
+    for (uint64_t k : keys) A::insert(m, k, k);
+    return m;
+}
+
+template<typename A>
+void BM_Insert(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    std::vector<uint64_t> keys = bench::keys(n);
+    for (auto _ : state) {
+        typename A::Map m = build<A>(keys);
+        benchmark::DoNotOptimize(m);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+    bench::report_footprint(state, n, [&] { return build<A>(keys); });
+}
+
+// Keys arriving in order, the case B-tree bulk building is tuned for
+template<typename A>
+void BM_InsertSorted(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    for (auto _ : state) {
+        typename A::Map m;
+        for (uint64_t k = 0; k < n; k++) A::insert(m, k, k);
+        benchmark::DoNotOptimize(m);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+
+template<typename A>
+void lookup(benchmark::State& state, bool hit) {
+    size_t n = size_t(state.range(0));
+    std::vector<uint64_t> keys = bench::keys(n);
+    typename A::Map m = build<A>(keys);
+    std::vector<uint64_t> probes = bench::probes(hit ? keys : bench::miss_keys(n));
+    for (auto _ : state) {
+        size_t found = 0;
+        for (uint64_t k : probes) found += A::contains(m, k);
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(probes.size()));
+}
+
+template<typename A>
+void BM_LookupHit(benchmark::State& state) { lookup<A>(state, true); }
+
+template<typename A>
+void BM_LookupMiss(benchmark::State& state) { lookup<A>(state, false); }
+
+// Erase the oldest key and insert a fresh one, keeping n live keys; this
+// exercises node merging and splitting
+template<typename A>
+void BM_EraseChurn(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    std::vector<uint64_t> live = bench::keys(n);
+    typename A::Map m = build<A>(live);
+    uint64_t next = n;
+    size_t oldest = 0;
+    for (auto _ : state) {
+        for (size_t i = 0; i < bench::OPS_PER_ITERATION; i++) {
+            A::erase(m, live[oldest]);
+            uint64_t k = bench::splitmix64(2 * next++);
+            A::insert(m, k, k);
+            live[oldest] = k;
+            if (++oldest == n) oldest = 0;
+        }
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(bench::OPS_PER_ITERATION));
+}
+
+template<typename A>
+void BM_Iterate(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    typename A::Map m = build<A>(bench::keys(n));
+    for (auto _ : state) benchmark::DoNotOptimize(A::sum(m));
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+
+#define RUSTY_BENCH_TREE(A)                                      \
+    BENCHMARK_TEMPLATE(BM_Insert, A)->Apply(bench::sizes);       \
+    BENCHMARK_TEMPLATE(BM_InsertSorted, A)->Apply(bench::sizes); \
+    BENCHMARK_TEMPLATE(BM_LookupHit, A)->Apply(bench::sizes);    \
+    BENCHMARK_TEMPLATE(BM_LookupMiss, A)->Apply(bench::sizes);   \
+    BENCHMARK_TEMPLATE(BM_EraseChurn, A)->Apply(bench::sizes);   \
+    BENCHMARK_TEMPLATE(BM_Iterate, A)->Apply(bench::sizes)
+
+RUSTY_BENCH_TREE(RustyTree);
+RUSTY_BENCH_TREE(StdTree);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,84 @@
+#ifndef RUSTY_BENCH_COMMON_HPP
+#define RUSTY_BENCH_COMMON_HPP
+
+// Shared helpers for the rusty container benchmarks
+//
+// Every size-parameterized benchmark runs for n = 10, 100, ... up to
+// RUSTY_BENCH_MAX_SIZE (default 10^6). 10^8 works, but the node-based
+// baselines (std::map, std::unordered_map) then need about 10 GB.
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace bench {
+
+inline int64_t max_size() {
+    const char* env = std::getenv("RUSTY_BENCH_MAX_SIZE");
+    int64_t n = env ? std::strtoll(env, nullptr, 10) : 0;
+    return n > 0 ? n : 1000000;
+}
+
+inline void sizes(benchmark::internal::Benchmark* b) {
+    for (int64_t n = 10; n <= max_size(); n *= 10) b->Arg(n);
+}
+
+// Lookups and churn steps done per benchmark iteration, whatever n is
+constexpr size_t OPS_PER_ITERATION = 4096;
+
+inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// n distinct pseudo-random keys. Even counters feed the keys that get
+// inserted and odd ones the misses, so the two streams never collide.
+inline std::vector<uint64_t> keys(size_t n, uint64_t stream = 0) {
+    std::vector<uint64_t> out(n);
+    for (size_t i = 0; i < n; i++) out[i] = splitmix64(2 * i + stream);
+    return out;
+}
+
+inline std::vector<uint64_t> miss_keys(size_t n) { return keys(n, 1); }
+
+// OPS_PER_ITERATION keys drawn from keys, so lookups hit random places
+// of a large table rather than walking it in insertion order
+inline std::vector<uint64_t> probes(const std::vector<uint64_t>& keys) {
+    std::vector<uint64_t> out(OPS_PER_ITERATION);
+    for (size_t i = 0; i < out.size(); i++) out[i] = keys[splitmix64(i + 12345) % keys.size()];
+    return out;
+}
+
+// Bytes currently allocated from the heap. glibc counts chunks parked in
+// its per-thread cache as in use, so run_benchmarks.sh turns the cache off
+// to keep small footprints from reading as zero.
+inline size_t heap_in_use() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+// Report what building a container of n elements costs in heap bytes
+template<typename Build>
+void report_footprint(benchmark::State& state, size_t n, Build build) {
+    size_t before = heap_in_use();
+    auto container = build();
+    size_t after = heap_in_use();
+    benchmark::DoNotOptimize(container);
+    state.counters["bytes"] = double(after - before);
+    state.counters["bytes_per_elem"] = double(after - before) / double(n);
+}
+
+} // namespace bench
+
+#endif // RUSTY_BENCH_COMMON_HPP
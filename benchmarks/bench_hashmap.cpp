@@ -0,0 +1,183 @@
+// HashMap / HashSet against std::unordered_map / unordered_set and, when
+// available, absl::flat_hash_map / flat_hash_set
+#include "bench_common.hpp"
+#include "../include/rusty/hashmap.hpp"
+#include "../include/rusty/hashset.hpp"
+#include <unordered_map>
+#include <unordered_set>
+
+#if defined(RUSTY_BENCH_ABSL)
+#include <absl/container/flat_hash_map.h>
+#include <absl/container/flat_hash_set.h>
+#endif
+
+// Adapters give every table the same five operations
+struct RustyMap {
+    typedef rusty::HashMap<uint64_t, uint64_t> Map;
+    static Map make(size_t n) { return Map::with_capacity(n); }
+    static void insert(Map& m, uint64_t k, uint64_t v) { m.insert(k, v); }
+    static bool contains(const Map& m, uint64_t k) { return m.contains_key(k); }
+    static void erase(Map& m, uint64_t k) { m.remove(k); }
+    static uint64_t sum(const Map& m) {
+        uint64_t total = 0;
+        for (auto kv : m) total += kv.second;
+        return total;
+    }
+};
+
+template<typename M>
+struct StdLikeMap {
+    typedef M Map;
+    static Map make(size_t n) {
+        Map m;
+        m.reserve(n);
+        return m;
+    }
+    static void insert(Map& m, uint64_t k, uint64_t v) { m.emplace(k, v); }
+    static bool contains(const Map& m, uint64_t k) { return m.find(k) != m.end(); }
+    static void erase(Map& m, uint64_t k) { m.erase(k); }
+    static uint64_t sum(const Map& m) {
+        uint64_t total = 0;
+        for (const auto& kv : m) total += kv.second;
+        return total;
+    }
+};
+
+struct RustySet {
+    typedef rusty::HashSet<uint64_t> Map;
+    static Map make(size_t n) { return Map::with_capacity(n); }
+    static void insert(Map& m, uint64_t k, uint64_t) { m.insert(k); }
+    static bool contains(const Map& m, uint64_t k) { return m.contains(k); }
+    static void erase(Map& m, uint64_t k) { m.remove(k); }
+    static uint64_t sum(const Map& m) {
+        uint64_t total = 0;
+        for (uint64_t k : m) total += k;
+        return total;
+    }
+};
+
+template<typename S>
+struct StdLikeSet {
+    typedef S Map;
+    static Map make(size_t n) {
+        Map m;
+        m.reserve(n);
+        return m;
+    }
+    static void insert(Map& m, uint64_t k, uint64_t) { m.insert(k); }
+    static bool contains(const Map& m, uint64_t k) { return m.find(k) != m.end(); }
+    static void erase(Map& m, uint64_t k) { m.erase(k); }
+    static uint64_t sum(const Map& m) {
+        uint64_t total = 0;
+        for (uint64_t k : m) total += k;
+        return total;
+    }
+};
+
+typedef StdLikeMap<std::unordered_map<uint64_t, uint64_t>> StdMap;
+typedef StdLikeSet<std::unordered_set<uint64_t>> StdSet;
+#if defined(RUSTY_BENCH_ABSL)
+typedef StdLikeMap<absl::flat_hash_map<uint64_t, uint64_t>> AbslMap;
+typedef StdLikeSet<absl::flat_hash_set<uint64_t>> AbslSet;
+#endif
+
+template<typename A>
+typename A::Map build(const std::vector<uint64_t>& keys) {
+    typename A::Map m = A::make(0);
+    for (uint64_t k : keys) A::insert(m, k, k);
+    return m;
+}
+
+// Insert n keys into an empty table, growing it as it goes
+template<typename A>
+void BM_Insert(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    std::vector<uint64_t> keys = bench::keys(n);
+    for (auto _ : state) {
+        typename A::Map m = build<A>(keys);
+        benchmark::DoNotOptimize(m);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+    bench::report_footprint(state, n, [&] { return build<A>(keys); });
+}
+
+// Insert n keys into a table reserved for them
+template<typename A>
+void BM_InsertReserved(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    std::vector<uint64_t> keys = bench::keys(n);
+    for (auto _ : state) {
+        typename A::Map m = A::make(n);
+        for (uint64_t k : keys) A::insert(m, k, k);
+        benchmark::DoNotOptimize(m);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+
+template<typename A>
+void lookup(benchmark::State& state, bool hit) {
+    size_t n = size_t(state.range(0));
+    std::vector<uint64_t> keys = bench::keys(n);
+    typename A::Map m = build<A>(keys);
+    std::vector<uint64_t> probes = bench::probes(hit ? keys : bench::miss_keys(n));
+    for (auto _ : state) {
+        size_t found = 0;
+        for (uint64_t k : probes) found += A::contains(m, k);
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(probes.size()));
+}
+
+template<typename A>
+void BM_LookupHit(benchmark::State& state) { lookup<A>(state, true); }
+
+template<typename A>
+void BM_LookupMiss(benchmark::State& state) { lookup<A>(state, false); }
+
+// Erase the oldest key and insert a fresh one, keeping n live keys; open
+// addressing tables accumulate tombstones here
+template<typename A>
+void BM_EraseChurn(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    std::vector<uint64_t> live = bench::keys(n);
+    typename A::Map m = build<A>(live);
+    uint64_t next = n;
+    size_t oldest = 0;
+    for (auto _ : state) {
+        for (size_t i = 0; i < bench::OPS_PER_ITERATION; i++) {
+            A::erase(m, live[oldest]);
+            uint64_t k = bench::splitmix64(2 * next++);
+            A::insert(m, k, k);
+            live[oldest] = k;
+            if (++oldest == n) oldest = 0;
+        }
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(bench::OPS_PER_ITERATION));
+}
+
+template<typename A>
+void BM_Iterate(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    typename A::Map m = build<A>(bench::keys(n));
+    for (auto _ : state) benchmark::DoNotOptimize(A::sum(m));
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+
+#define RUSTY_BENCH_TABLE(A)                                       \
+    BENCHMARK_TEMPLATE(BM_Insert, A)->Apply(bench::sizes);         \
+    BENCHMARK_TEMPLATE(BM_InsertReserved, A)->Apply(bench::sizes); \
+    BENCHMARK_TEMPLATE(BM_LookupHit, A)->Apply(bench::sizes);      \
+    BENCHMARK_TEMPLATE(BM_LookupMiss, A)->Apply(bench::sizes);     \
+    BENCHMARK_TEMPLATE(BM_EraseChurn, A)->Apply(bench::sizes);     \
+    BENCHMARK_TEMPLATE(BM_Iterate, A)->Apply(bench::sizes)
+
+RUSTY_BENCH_TABLE(RustyMap);
+RUSTY_BENCH_TABLE(StdMap);
+RUSTY_BENCH_TABLE(RustySet);
+RUSTY_BENCH_TABLE(StdSet);
+#if defined(RUSTY_BENCH_ABSL)
+RUSTY_BENCH_TABLE(AbslMap);
+RUSTY_BENCH_TABLE(AbslSet);
+#endif
+
+BENCHMARK_MAIN();
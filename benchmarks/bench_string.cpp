@@ -0,0 +1,100 @@
+// String against std::string
+#include "bench_common.hpp"
+#include "../include/rusty/string.hpp"
+#include <string>
+
+struct RustyString {
+    typedef rusty::String Text;
+    static Text make() { return Text::new_(); }
+    static void append(Text& s, const char* piece) { s.push_str(piece); }
+    static bool contains(const Text& s, const char* needle) { return s.contains(rusty::str(needle)); }
+    static Text clone(const Text& s) { return s.clone(); }
+    static size_t len(const Text& s) { return s.len(); }
+    static const char* data(const Text& s) { return s.as_ptr(); }
+};
+
+struct StdString {
+    typedef std::string Text;
+    static Text make() { return Text(); }
+    static void append(Text& s, const char* piece) { s.append(piece); }
+    static bool contains(const Text& s, const char* needle) { return s.find(needle) != Text::npos; }
+    static Text clone(const Text& s) { return s; }
+    static size_t len(const Text& s) { return s.size(); }
+    static const char* data(const Text& s) { return s.data(); }
+};
+
+// Roughly n bytes of words, with no 'z' anywhere so misses scan it all
+template<typename A>
+typename A::Text build(size_t n) {
+    static const char* const words[] = {"alpha ", "bravo ", "charlie ", "delta ", "echo "};
+    typename A::Text s = A::make();
+    for (size_t i = 0; A::len(s) < n; i++) A::append(s, words[bench::splitmix64(i) % 5]);
+    return s;
+}
+
+// Appending short pieces until the string holds n bytes
+template<typename A>
+void BM_PushStr(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    for (auto _ : state) {
+        typename A::Text s = build<A>(n);
+        benchmark::DoNotOptimize(s);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(n));
+    bench::report_footprint(state, n, [&] { return build<A>(n); });
+}
+
+template<typename A>
+void BM_FindHit(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    typename A::Text s = build<A>(n);
+    A::append(s, "zulu");
+    for (auto _ : state) benchmark::DoNotOptimize(A::contains(s, "zulu"));
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(A::len(s)));
+}
+
+template<typename A>
+void BM_FindMiss(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    typename A::Text s = build<A>(n);
+    for (auto _ : state) benchmark::DoNotOptimize(A::contains(s, "zulu"));
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(A::len(s)));
+}
+
+// String keeps up to 23 bytes inline, libstdc++'s std::string up to 15
+template<typename A>
+void BM_Clone(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    typename A::Text s = build<A>(n);
+    for (auto _ : state) {
+        typename A::Text copy = A::clone(s);
+        benchmark::DoNotOptimize(copy);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(A::len(s)));
+}
+
+// Walking the bytes through data(), the loop callers write by hand
+template<typename A>
+void BM_ByteScan(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    typename A::Text s = build<A>(n);
+    for (auto _ : state) {
+        const char* p = A::data(s);
+        size_t spaces = 0;
+        for (size_t i = 0; i < A::len(s); i++) spaces += p[i] == ' ';
+        benchmark::DoNotOptimize(spaces);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(A::len(s)));
+}
+
+#define RUSTY_BENCH_TEXT(A)                                  \
+    BENCHMARK_TEMPLATE(BM_PushStr, A)->Apply(bench::sizes);  \
+    BENCHMARK_TEMPLATE(BM_FindHit, A)->Apply(bench::sizes);  \
+    BENCHMARK_TEMPLATE(BM_FindMiss, A)->Apply(bench::sizes); \
+    BENCHMARK_TEMPLATE(BM_Clone, A)->Apply(bench::sizes);    \
+    BENCHMARK_TEMPLATE(BM_ByteScan, A)->Apply(bench::sizes)
+
+RUSTY_BENCH_TEXT(RustyString);
+RUSTY_BENCH_TEXT(StdString);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,101 @@
+// Vec against std::vector
+#include "bench_common.hpp"
+#include "../include/rusty/vec.hpp"
+
+struct RustyVec {
+    typedef rusty::Vec<uint64_t> Seq;
+    static Seq make(size_t n) { return Seq::with_capacity(n); }
+    static void push(Seq& v, uint64_t x) { v.push(x); }
+    static Seq clone(const Seq& v) { return v.clone(); }
+};
+
+struct StdVec {
+    typedef std::vector<uint64_t> Seq;
+    static Seq make(size_t n) {
+        Seq v;
+        v.reserve(n);
+        return v;
+    }
+    static void push(Seq& v, uint64_t x) { v.push_back(x); }
+    static Seq clone(const Seq& v) { return v; }
+};
+
+template<typename A>
+typename A::Seq build(size_t n) {
+    typename A::Seq v = A::make(0);
+    for (size_t i = 0; i < n; i++) A::push(v, i);
+    return v;
+}
+
+// Push n elements onto an empty vector, growing it as it goes
+template<typename A>
+void BM_Push(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    for (auto _ : state) {
+        typename A::Seq v = build<A>(n);
+        benchmark::DoNotOptimize(v);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+    bench::report_footprint(state, n, [&] { return build<A>(n); });
+}
+
+template<typename A>
+void BM_PushReserved(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    for (auto _ : state) {
+        typename A::Seq v = A::make(n);
+        for (size_t i = 0; i < n; i++) A::push(v, i);
+        benchmark::DoNotOptimize(v);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+
+// Indexing at random positions, which pays for any bounds checks
+template<typename A>
+void BM_RandomIndex(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    typename A::Seq v = build<A>(n);
+    std::vector<size_t> at(bench::OPS_PER_ITERATION);
+    for (size_t i = 0; i < at.size(); i++) at[i] = bench::splitmix64(i) % n;
+    for (auto _ : state) {
+        uint64_t total = 0;
+        for (size_t i : at) total += v[i];
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(at.size()));
+}
+
+template<typename A>
+void BM_Iterate(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    typename A::Seq v = build<A>(n);
+    for (auto _ : state) {
+        uint64_t total = 0;
+        for (uint64_t x : v) total += x;
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(n));
+}
+
+template<typename A>
+void BM_Clone(benchmark::State& state) {
+    size_t n = size_t(state.range(0));
+    typename A::Seq v = build<A>(n);
+    for (auto _ : state) {
+        typename A::Seq copy = A::clone(v);
+        benchmark::DoNotOptimize(copy);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(n * sizeof(uint64_t)));
+}
+
+#define RUSTY_BENCH_SEQ(A)                                       \
+    BENCHMARK_TEMPLATE(BM_Push, A)->Apply(bench::sizes);         \
+    BENCHMARK_TEMPLATE(BM_PushReserved, A)->Apply(bench::sizes); \
+    BENCHMARK_TEMPLATE(BM_RandomIndex, A)->Apply(bench::sizes);  \
+    BENCHMARK_TEMPLATE(BM_Iterate, A)->Apply(bench::sizes);      \
+    BENCHMARK_TEMPLATE(BM_Clone, A)->Apply(bench::sizes)
+
+RUSTY_BENCH_SEQ(RustyVec);
+RUSTY_BENCH_SEQ(StdVec);
+
+BENCHMARK_MAIN();
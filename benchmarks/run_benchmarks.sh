@@ -0,0 +1,74 @@
+#!/bin/bash
+
+# Script to compile and run the rusty container benchmarks
+#
+# Needs Google Benchmark (libbenchmark-dev); absl::flat_hash_map is added
+# to the hash table runs when pkg-config can find it. Extra arguments go
+# to every binary, e.g.
+#   ./run_benchmarks.sh --benchmark_filter=Lookup --benchmark_format=csv
+# RUSTY_BENCH_MAX_SIZE raises or lowers the largest n (default 1000000).
+
+cd "$(dirname "$0")"
+
+echo "Building and running Rusty benchmarks..."
+echo "========================================"
+
+GREEN='\033[0;32m'
+RED='\033[0;31m'
+NC='\033[0m' # No Color
+
+FAILED=0
+
+CXX="${CXX:-clang++}"
+CXXFLAGS="-O2 -DNDEBUG -std=c++17 -Wall -Wextra -I../include"
+LIBS="-lbenchmark -pthread"
+
+ABSL_LIBS=""
+if pkg-config --exists absl_flat_hash_map absl_flat_hash_set 2>/dev/null; then
+    ABSL_LIBS="$(pkg-config --cflags --libs absl_flat_hash_map absl_flat_hash_set)"
+fi
+
+BENCHMARKS=(
+    "bench_vec"
+    "bench_hashmap"
+    "bench_btreemap"
+    "bench_string"
+    "bench_arc"
+)
+
+# glibc's per-thread cache hides small allocations from mallinfo2, which
+# the footprint counters read
+export GLIBC_TUNABLES="glibc.malloc.tcache_count=0${GLIBC_TUNABLES:+:$GLIBC_TUNABLES}"
+
+mkdir -p build
+
+for bench in "${BENCHMARKS[@]}"; do
+    echo ""
+    echo "Building $bench..."
+
+    extra=""
+    if [ "$bench" = "bench_hashmap" ] && [ -n "$ABSL_LIBS" ]; then
+        extra="-DRUSTY_BENCH_ABSL $ABSL_LIBS"
+    fi
+
+    if $CXX $CXXFLAGS "$bench.cpp" -o "build/$bench" $LIBS $extra; then
+        echo "Running $bench..."
+        if ! "./build/$bench" "$@"; then
+            echo -e "${RED}✗ $bench failed${NC}"
+            ((FAILED++))
+        fi
+    else
+        echo -e "${RED}✗ $bench compilation failed${NC}"
+        ((FAILED++))
+    fi
+done
+
+echo ""
+echo "========================================"
+if [ $FAILED -eq 0 ]; then
+    echo -e "${GREEN}All benchmarks ran${NC}"
+    exit 0
+else
+    echo -e "${RED}$FAILED benchmarks failed${NC}"
+    exit 1
+fi
@@ -12,7 +12,6 @@ OS=$(uname -s)
 ARCH=$(uname -m)
 
 # Set up environment for build
-export Z3_SYS_Z3_HEADER=/opt/homebrew/include/z3.h
 export DYLD_LIBRARY_PATH=/opt/homebrew/Cellar/llvm/19.1.7/lib:$DYLD_LIBRARY_PATH
 
 # Build release version
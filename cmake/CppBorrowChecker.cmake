@@ -11,6 +11,9 @@
 #   # Or enable for specific targets
 #   add_borrow_check_target(my_target)
 #   
+#   # Or check all of a target's sources with one batch checker run
+#   add_borrow_check_batch(my_target)
+#   
 #   # Or run on specific files
 #   add_borrow_check(my_file.cpp)
 
@@ -35,9 +38,18 @@ endif()
 option(ENABLE_BORROW_CHECKING "Enable C++ Borrow Checking" OFF)
 option(BORROW_CHECK_FATAL "Make borrow check failures fatal" OFF)
 
+option(BORROW_CHECK_BATCH "Check each target's sources with one batch checker run" OFF)
+
 # Set default include paths for the checker
 set(BORROW_CHECKER_INCLUDE_PATHS "" CACHE STRING "Additional include paths for borrow checker")
 
+# Settings of batch runs
+set(BORROW_CHECK_HEADER_CACHE "${CMAKE_BINARY_DIR}/rusty-headers.bin" CACHE FILEPATH
+    "Header signature cache shared by batch checker runs (empty to disable)")
+option(BORROW_CHECK_INCREMENTAL "Re-check only changed functions in batch checker runs" ON)
+set(BORROW_CHECK_PCH "" CACHE FILEPATH "Header to precompile for batch checker runs")
+set(BORROW_CHECK_JOBS "" CACHE STRING "Files each batch checker run checks at once (default: all CPUs)")
+
 # Function to add borrow checking for a single file
 function(add_borrow_check SOURCE_FILE)
     if(NOT CPP_BORROW_CHECKER)
@@ -96,6 +108,11 @@ function(add_borrow_check_target TARGET_NAME)
         return()
     endif()
     
+    if(BORROW_CHECK_BATCH)
+        add_borrow_check_batch(${TARGET_NAME})
+        return()
+    endif()
+    
     # Get source files from target
     get_target_property(SOURCES ${TARGET_NAME} SOURCES)
     
@@ -139,6 +156,95 @@ function(add_borrow_check_target TARGET_NAME)
     endforeach()
 endfunction()
 
+# Function to check all sources of a target with one batch checker run.
+#
+# The target's sources, include directories, definitions and C++ standard
+# are written to a compile_commands.json of its own at generate time. One
+# custom command checks it, sharing the header cache and, with
+# BORROW_CHECK_INCREMENTAL, reusing the results of unchanged functions.
+# The command's outputs are one stamp per source file, which the checker
+# touches for each file without violations.
+function(add_borrow_check_batch TARGET_NAME)
+    if(NOT CPP_BORROW_CHECKER)
+        return()
+    endif()
+    
+    if(NOT ENABLE_BORROW_CHECKING)
+        return()
+    endif()
+    
+    get_target_property(SOURCES ${TARGET_NAME} SOURCES)
+    get_target_property(SOURCE_DIR ${TARGET_NAME} SOURCE_DIR)
+    set(CHECK_DIR ${CMAKE_CURRENT_BINARY_DIR}/borrow_check_${TARGET_NAME})
+    set(DATABASE ${CHECK_DIR}/compile_commands.json)
+    
+    # The target's flags as JSON strings; the generator expressions are
+    # evaluated when the database is generated
+    set(INCLUDES "$<TARGET_PROPERTY:${TARGET_NAME},INCLUDE_DIRECTORIES>")
+    set(DEFINES "$<TARGET_PROPERTY:${TARGET_NAME},COMPILE_DEFINITIONS>")
+    set(STANDARD "$<TARGET_PROPERTY:${TARGET_NAME},CXX_STANDARD>")
+    set(NEXT "\"$<COMMA> \"")
+    set(ARGUMENTS "\"c++\"")
+    foreach(DIR ${BORROW_CHECKER_INCLUDE_PATHS})
+        string(APPEND ARGUMENTS ", \"-I${DIR}\"")
+    endforeach()
+    string(APPEND ARGUMENTS "$<$<BOOL:${INCLUDES}>:$<COMMA> \"-I$<JOIN:${INCLUDES},${NEXT}-I>\">")
+    string(APPEND ARGUMENTS "$<$<BOOL:${DEFINES}>:$<COMMA> \"-D$<JOIN:${DEFINES},${NEXT}-D>\">")
+    string(APPEND ARGUMENTS "$<$<BOOL:${STANDARD}>:$<COMMA> \"-std=c++${STANDARD}\">")
+    
+    set(ENTRIES)
+    set(CHECKED_SOURCES)
+    set(STAMPS)
+    foreach(SOURCE ${SOURCES})
+        # Only check .cpp files
+        if(SOURCE MATCHES "\\.(cpp|cc|cxx)$")
+            get_filename_component(SOURCE_ABS ${SOURCE} ABSOLUTE BASE_DIR ${SOURCE_DIR})
+            # The checker names stamps the same way
+            string(REGEX REPLACE "[^A-Za-z0-9_.-]" "_" STAMP ${SOURCE_ABS})
+            list(APPEND STAMPS ${CHECK_DIR}/stamps/${STAMP}.stamp)
+            list(APPEND CHECKED_SOURCES ${SOURCE_ABS})
+            list(APPEND ENTRIES "  {\"directory\": \"${CHECK_DIR}\", \"file\": \"${SOURCE_ABS}\", \"arguments\": [${ARGUMENTS}]}")
+        endif()
+    endforeach()
+    
+    if(NOT ENTRIES)
+        return()
+    endif()
+    
+    list(JOIN ENTRIES ",\n" ENTRIES)
+    file(GENERATE OUTPUT ${DATABASE} CONTENT "[\n${ENTRIES}\n]\n")
+    
+    set(CHECK_ARGS --compile-commands ${DATABASE} --stamp-dir ${CHECK_DIR}/stamps)
+    if(BORROW_CHECK_HEADER_CACHE)
+        list(APPEND CHECK_ARGS --header-cache ${BORROW_CHECK_HEADER_CACHE})
+    endif()
+    if(BORROW_CHECK_INCREMENTAL)
+        list(APPEND CHECK_ARGS --incremental)
+    endif()
+    if(BORROW_CHECK_PCH)
+        list(APPEND CHECK_ARGS --pch ${BORROW_CHECK_PCH})
+    endif()
+    if(BORROW_CHECK_JOBS)
+        list(APPEND CHECK_ARGS --jobs ${BORROW_CHECK_JOBS})
+    endif()
+    
+    list(LENGTH CHECKED_SOURCES FILE_COUNT)
+    add_custom_command(
+        OUTPUT ${STAMPS}
+        COMMAND ${CPP_BORROW_CHECKER} ${CHECK_ARGS}
+        DEPENDS ${CHECKED_SOURCES} ${DATABASE}
+        WORKING_DIRECTORY ${CHECK_DIR}
+        COMMENT "Borrow checking ${FILE_COUNT} file(s) of ${TARGET_NAME}"
+        VERBATIM
+    )
+    
+    add_custom_target(borrow_check_${TARGET_NAME}
+        DEPENDS ${STAMPS}
+    )
+    
+    add_dependencies(${TARGET_NAME} borrow_check_${TARGET_NAME})
+endfunction()
+
 # Function to enable borrow checking globally
 function(enable_borrow_checking)
     if(NOT CPP_BORROW_CHECKER)
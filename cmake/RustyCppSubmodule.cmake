@@ -10,7 +10,9 @@
 #   # Then use the same functions as before:
 #   enable_borrow_checking()
 #   add_borrow_check_target(my_target)
+#   add_borrow_check_batch(my_target)
 #   add_borrow_check(my_file.cpp)
+#   add_rusty_module(rusty_module)  # import rusty; (CMake 3.28+)
 
 # Detect the rusty-cpp directory (should be the parent of this cmake file)
 get_filename_component(RUSTYCPP_DIR "${CMAKE_CURRENT_LIST_DIR}/.." ABSOLUTE)
@@ -23,6 +25,14 @@ set_property(CACHE RUSTYCPP_BUILD_TYPE PROPERTY STRINGS "debug" "release")
 option(ENABLE_BORROW_CHECKING "Enable C++ Borrow Checking" OFF)
 option(BORROW_CHECK_FATAL "Make borrow check failures fatal" OFF)
 option(RUSTYCPP_SKIP_DEPENDENCY_CHECK "Skip dependency checking for RustyCpp" OFF)
+option(BORROW_CHECK_BATCH "Check each target's sources with one batch checker run" OFF)
+
+# Settings of batch runs
+set(BORROW_CHECK_HEADER_CACHE "${CMAKE_BINARY_DIR}/rusty-headers.bin" CACHE FILEPATH
+    "Header signature cache shared by batch checker runs (empty to disable)")
+option(BORROW_CHECK_INCREMENTAL "Re-check only changed functions in batch checker runs" ON)
+set(BORROW_CHECK_PCH "" CACHE FILEPATH "Header to precompile for batch checker runs")
+set(BORROW_CHECK_JOBS "" CACHE STRING "Files each batch checker run checks at once (default: all CPUs)")
 
 # Function to check if a command exists
 function(check_command_exists CMD VAR)
@@ -129,36 +139,6 @@ function(check_rustycpp_dependencies)
         endif()
     endif()
     
-    # Check for Z3 (required for constraint solving)
-    find_path(Z3_INCLUDE_DIR z3.h
-        PATHS
-            /usr/include
-            /usr/local/include
-            /opt/homebrew/include
-    )
-    
-    find_library(Z3_LIBRARY
-        NAMES z3
-        PATHS
-            /usr/lib
-            /usr/local/lib
-            /usr/lib/x86_64-linux-gnu
-            /opt/homebrew/lib
-    )
-    
-    if(NOT Z3_INCLUDE_DIR OR NOT Z3_LIBRARY)
-        message(WARNING "Z3 solver not found.")
-        message(WARNING "Please install Z3 development packages:")
-        message(WARNING "  Ubuntu/Debian: sudo apt-get install libz3-dev")
-        message(WARNING "  Fedora/RHEL: sudo dnf install z3-devel")
-        message(WARNING "  macOS: brew install z3")
-        set(MISSING_DEPS TRUE)
-    else()
-        message(STATUS "Found Z3: ${Z3_LIBRARY}")
-        message(STATUS "Found Z3 headers: ${Z3_INCLUDE_DIR}")
-        set(ENV{Z3_SYS_Z3_HEADER} "${Z3_INCLUDE_DIR}/z3.h")
-    endif()
-    
     if(MISSING_DEPS)
         message(FATAL_ERROR "Missing required dependencies for RustyCpp. "
                 "Please install them or set RUSTYCPP_SKIP_DEPENDENCY_CHECK=ON to skip this check.")
@@ -194,10 +174,6 @@ function(create_rustycpp_build_target)
         list(APPEND BUILD_ENV "LLVM_CONFIG_PATH=$ENV{LLVM_CONFIG_PATH}")
     endif()
     
-    if(DEFINED ENV{Z3_SYS_Z3_HEADER})
-        list(APPEND BUILD_ENV "Z3_SYS_Z3_HEADER=$ENV{Z3_SYS_Z3_HEADER}")
-    endif()
-    
     # Create a custom target to build the rusty-cpp-checker
     if(BUILD_ENV)
         add_custom_target(build_rusty_cpp_checker
@@ -303,6 +279,11 @@ function(add_borrow_check_target TARGET_NAME)
         return()
     endif()
     
+    if(BORROW_CHECK_BATCH)
+        add_borrow_check_batch(${TARGET_NAME})
+        return()
+    endif()
+    
     # Get source files from target
     get_target_property(SOURCES ${TARGET_NAME} SOURCES)
     
@@ -397,6 +378,92 @@ function(add_borrow_check_target TARGET_NAME)
     add_dependencies(${TARGET_NAME} ${ALL_CHECKS_TARGET})
 endfunction()
 
+# Function to check all sources of a target with one batch checker run.
+#
+# The target's sources, include directories, definitions and C++ standard
+# are written to a compile_commands.json of its own at generate time. One
+# custom command checks it, sharing the header cache and, with
+# BORROW_CHECK_INCREMENTAL, reusing the results of unchanged functions.
+# The command's outputs are one stamp per source file, which the checker
+# touches for each file without violations.
+function(add_borrow_check_batch TARGET_NAME)
+    if(NOT ENABLE_BORROW_CHECKING)
+        return()
+    endif()
+    
+    get_target_property(SOURCES ${TARGET_NAME} SOURCES)
+    get_target_property(SOURCE_DIR ${TARGET_NAME} SOURCE_DIR)
+    set(CHECK_DIR ${CMAKE_CURRENT_BINARY_DIR}/borrow_check_${TARGET_NAME})
+    set(DATABASE ${CHECK_DIR}/compile_commands.json)
+    
+    # The target's flags as JSON strings; the generator expressions are
+    # evaluated when the database is generated
+    set(INCLUDES "$<TARGET_PROPERTY:${TARGET_NAME},INCLUDE_DIRECTORIES>")
+    set(DEFINES "$<TARGET_PROPERTY:${TARGET_NAME},COMPILE_DEFINITIONS>")
+    set(STANDARD "$<TARGET_PROPERTY:${TARGET_NAME},CXX_STANDARD>")
+    set(NEXT "\"$<COMMA> \"")
+    set(ARGUMENTS "\"c++\"")
+    foreach(DIR ${BORROW_CHECKER_INCLUDE_PATHS})
+        string(APPEND ARGUMENTS ", \"-I${DIR}\"")
+    endforeach()
+    string(APPEND ARGUMENTS "$<$<BOOL:${INCLUDES}>:$<COMMA> \"-I$<JOIN:${INCLUDES},${NEXT}-I>\">")
+    string(APPEND ARGUMENTS "$<$<BOOL:${DEFINES}>:$<COMMA> \"-D$<JOIN:${DEFINES},${NEXT}-D>\">")
+    string(APPEND ARGUMENTS "$<$<BOOL:${STANDARD}>:$<COMMA> \"-std=c++${STANDARD}\">")
+    
+    set(ENTRIES)
+    set(CHECKED_SOURCES)
+    set(STAMPS)
+    foreach(SOURCE ${SOURCES})
+        # Only check .cpp files
+        if(SOURCE MATCHES "\\.(cpp|cc|cxx)$")
+            get_filename_component(SOURCE_ABS ${SOURCE} ABSOLUTE BASE_DIR ${SOURCE_DIR})
+            # The checker names stamps the same way
+            string(REGEX REPLACE "[^A-Za-z0-9_.-]" "_" STAMP ${SOURCE_ABS})
+            list(APPEND STAMPS ${CHECK_DIR}/stamps/${STAMP}.stamp)
+            list(APPEND CHECKED_SOURCES ${SOURCE_ABS})
+            list(APPEND ENTRIES "  {\"directory\": \"${CHECK_DIR}\", \"file\": \"${SOURCE_ABS}\", \"arguments\": [${ARGUMENTS}]}")
+        endif()
+    endforeach()
+    
+    if(NOT ENTRIES)
+        return()
+    endif()
+    
+    list(JOIN ENTRIES ",\n" ENTRIES)
+    file(GENERATE OUTPUT ${DATABASE} CONTENT "[\n${ENTRIES}\n]\n")
+    
+    set(CHECK_ARGS --compile-commands ${DATABASE} --stamp-dir ${CHECK_DIR}/stamps)
+    if(BORROW_CHECK_HEADER_CACHE)
+        list(APPEND CHECK_ARGS --header-cache ${BORROW_CHECK_HEADER_CACHE})
+    endif()
+    if(BORROW_CHECK_INCREMENTAL)
+        list(APPEND CHECK_ARGS --incremental)
+    endif()
+    if(BORROW_CHECK_PCH)
+        list(APPEND CHECK_ARGS --pch ${BORROW_CHECK_PCH})
+    endif()
+    if(BORROW_CHECK_JOBS)
+        list(APPEND CHECK_ARGS --jobs ${BORROW_CHECK_JOBS})
+    endif()
+    
+    list(LENGTH CHECKED_SOURCES FILE_COUNT)
+    add_custom_command(
+        OUTPUT ${STAMPS}
+        COMMAND ${CPP_BORROW_CHECKER} ${CHECK_ARGS}
+        DEPENDS ${CHECKED_SOURCES} ${DATABASE} ${CPP_BORROW_CHECKER}
+        WORKING_DIRECTORY ${CHECK_DIR}
+        COMMENT "Borrow checking ${FILE_COUNT} file(s) of ${TARGET_NAME}"
+        VERBATIM
+    )
+    
+    add_custom_target(borrow_check_${TARGET_NAME}
+        DEPENDS ${STAMPS}
+    )
+    ensure_checker_built(borrow_check_${TARGET_NAME})
+    
+    add_dependencies(${TARGET_NAME} borrow_check_${TARGET_NAME})
+endfunction()
+
 # Function to enable borrow checking globally
 function(enable_borrow_checking)
     set(ENABLE_BORROW_CHECKING ON PARENT_SCOPE)
@@ -436,6 +503,28 @@ function(setup_borrow_checker_compile_commands)
     ensure_checker_built(borrow_check_with_compile_commands)
 endfunction()
 
+# Function to build the rusty headers as a C++20 module, so sources can
+# `import rusty;` instead of reparsing rusty.hpp in every TU
+# Usage: add_rusty_module(rusty_module)
+#        target_link_libraries(my_target PRIVATE rusty_module)
+function(add_rusty_module TARGET_NAME)
+    if(CMAKE_VERSION VERSION_LESS 3.28)
+        message(WARNING "add_rusty_module needs CMake 3.28 or later; include rusty/rusty.hpp instead")
+        return()
+    endif()
+
+    find_package(Threads REQUIRED)
+    add_library(${TARGET_NAME} STATIC)
+    target_sources(${TARGET_NAME}
+        PUBLIC FILE_SET CXX_MODULES
+        BASE_DIRS ${RUSTYCPP_DIR}/include/rusty
+        FILES ${RUSTYCPP_DIR}/include/rusty/rusty.cppm
+    )
+    target_include_directories(${TARGET_NAME} PUBLIC ${RUSTYCPP_DIR}/include)
+    target_compile_features(${TARGET_NAME} PUBLIC cxx_std_20)
+    target_link_libraries(${TARGET_NAME} PUBLIC Threads::Threads)
+endfunction()
+
 # Macro to mark files as safe
 macro(mark_safe)
     foreach(FILE ${ARGN})
@@ -0,0 +1,161 @@
+#ifndef RUSTY_ALLOC_HPP
+#define RUSTY_ALLOC_HPP
+
+#include <cstddef>  // for size_t, max_align_t
+#include <cstdlib>  // for malloc, realloc, free
+#include <cstring>  // for memcpy
+#include <new>      // for std::bad_alloc
+#include <type_traits>
+#include <utility>
+#include "alloc_observer.hpp"
+
+// Allocator support for rusty containers
+// Modeled after Rust's allocator_api (Allocator trait + Global)
+//
+// An allocator is any copyable type with:
+//   void* allocate(size_t size, size_t align);               // nullptr on failure
+//   void  deallocate(void* ptr, size_t size, size_t align);
+// and optionally:
+//   void* reallocate(void* ptr, size_t old_size, size_t new_size, size_t align);
+//
+// reallocate is only used for trivially relocatable contents (see
+// relocate.hpp). Allocators without it fall back to allocate + memcpy +
+// deallocate.
+//
+// Allocators may carry state (e.g. a pointer to an arena or a NUMA-local
+// pool). Containers store their allocator by value, move it along with
+// their storage and copy it into clones. Stateless allocators take no
+// space inside the container. Whatever the allocator, containers report
+// their blocks to the observer in alloc_observer.hpp.
+
+// @safe
+namespace rusty {
+
+// Global - the default allocator, backed by malloc/realloc/free
+struct Global {
+    void* allocate(size_t size, size_t align) {
+#if __cpp_aligned_new
+        if (align > alignof(std::max_align_t)) {
+            return ::operator new(size, std::align_val_t(align), std::nothrow);
+        }
+#elif defined(__unix__) || defined(__APPLE__)
+        // Pre-C++17: posix_memalign blocks are released with free()
+        if (align > alignof(std::max_align_t)) {
+            void* ptr = nullptr;
+            return posix_memalign(&ptr, align, size) == 0 ? ptr : nullptr;
+        }
+#else
+        (void)align;
+#endif
+        return std::malloc(size);
+    }
+
+    void deallocate(void* ptr, size_t size, size_t align) {
+        (void)size;
+#if __cpp_aligned_new
+        if (align > alignof(std::max_align_t)) {
+            ::operator delete(ptr, std::align_val_t(align));
+            return;
+        }
+#else
+        (void)align;
+#endif
+        std::free(ptr);
+    }
+
+    void* reallocate(void* ptr, size_t old_size, size_t new_size, size_t align) {
+        if (align > alignof(std::max_align_t)) {
+            void* new_ptr = allocate(new_size, align);
+            if (new_ptr && ptr) {
+                std::memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+                deallocate(ptr, old_size, align);
+            }
+            return new_ptr;
+        }
+        return std::realloc(ptr, new_size);
+    }
+
+    bool operator==(const Global&) const { return true; }
+    bool operator!=(const Global&) const { return false; }
+};
+
+// Why a fallible allocation (try_reserve, try_push, ...) failed
+// Equivalent to Rust's TryReserveError
+struct AllocError {
+    size_t size;   // bytes requested; 0 when the size overflowed size_t
+    size_t align;
+
+    bool is_capacity_overflow() const { return size == 0; }
+
+    static AllocError capacity_overflow() {
+        AllocError err = {0, 0};
+        return err;
+    }
+};
+
+// Detect an optional reallocate() member
+template<typename A, typename = void>
+struct alloc_has_reallocate : std::false_type {};
+
+template<typename A>
+struct alloc_has_reallocate<A, decltype(void(std::declval<A&>().reallocate(
+    static_cast<void*>(nullptr), size_t(0), size_t(0), size_t(0))))> : std::true_type {};
+
+namespace detail {
+
+template<typename A>
+void* alloc_reallocate(A& alloc, void* ptr, size_t old_size, size_t new_size,
+                       size_t align, std::true_type) {
+    return alloc.reallocate(ptr, old_size, new_size, align);
+}
+
+template<typename A>
+void* alloc_reallocate(A& alloc, void* ptr, size_t old_size, size_t new_size,
+                       size_t align, std::false_type) {
+    void* new_ptr = alloc.allocate(new_size, align);
+    if (new_ptr && ptr) {
+        std::memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+        alloc.deallocate(ptr, old_size, align);
+    }
+    return new_ptr;
+}
+
+// Holds an allocator with the empty base optimization, so a stateless
+// allocator such as Global does not grow the container
+template<typename A>
+class AllocHolder : private A {
+public:
+    AllocHolder() = default;
+    explicit AllocHolder(const A& alloc) : A(alloc) {}
+
+    A& alloc() { return *this; }
+    const A& alloc() const { return *this; }
+};
+
+} // namespace detail
+
+// Allocate or throw std::bad_alloc
+template<typename A>
+void* alloc_or_throw(A& alloc, size_t size, size_t align) {
+    void* ptr = alloc.allocate(size, align);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+// Resize a block whose contents may be copied bitwise, or throw std::bad_alloc.
+// On failure the original block is left untouched.
+template<typename A>
+void* realloc_or_throw(A& alloc, void* ptr, size_t old_size, size_t new_size, size_t align) {
+    void* new_ptr = detail::alloc_reallocate(alloc, ptr, old_size, new_size, align,
+                                             alloc_has_reallocate<A>());
+    if (!new_ptr) {
+        throw std::bad_alloc();
+    }
+    return new_ptr;
+}
+
+} // namespace rusty
+
+#endif // RUSTY_ALLOC_HPP
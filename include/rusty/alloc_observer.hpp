@@ -0,0 +1,257 @@
+#ifndef RUSTY_ALLOC_OBSERVER_HPP
+#define RUSTY_ALLOC_OBSERVER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// Allocation observer for rusty containers
+//
+// Vec, String, HashMap, BTreeMap, Box, Arc and Rc report every block they
+// take or give back, whatever their allocator, to the observer installed
+// with set_alloc_observer(). Containers built on these (HashSet, VecDeque,
+// SmallVec's spill, ...) are reported as the one they use underneath.
+// A reallocation is reported as a free of the old block and an allocation
+// of the new one. Box reports the pointer it adopts or gives up, so
+// Box::from_raw / into_raw stay balanced.
+//
+// Events carry the innermost AllocSite of the calling thread, a cheap
+// call-site label; an observer that wants stacks can take them itself.
+//
+//   rusty::AllocTally tally;
+//   rusty::set_alloc_observer(&tally);
+//   {
+//       rusty::AllocSite site("session-cache");
+//       cache.insert(key, value);
+//   }
+//   tally.live_bytes(rusty::AllocKind::HashMap);
+//
+// With no observer installed each allocation pays one atomic load. An
+// observer must stay alive until no thread can still be calling it; the
+// simplest rule is to install one for the life of the process. Allocations
+// made by the observer itself are not reported.
+
+// @safe
+namespace rusty {
+
+enum class AllocKind : uint8_t {
+    Vec,
+    String,
+    HashMap,
+    BTreeMap,
+    Box,
+    Arc,
+    Rc,
+};
+
+constexpr size_t ALLOC_KINDS = 7;
+
+inline const char* alloc_kind_name(AllocKind kind) {
+    static const char* const names[ALLOC_KINDS] = {
+        "Vec", "String", "HashMap", "BTreeMap", "Box", "Arc", "Rc"};
+    return names[static_cast<size_t>(kind)];
+}
+
+struct AllocEvent {
+    AllocKind kind;
+    const void* ptr;
+    size_t size;
+    const char* site;  // Innermost AllocSite label, or nullptr
+};
+
+class AllocObserver {
+public:
+    virtual void on_alloc(const AllocEvent& event) = 0;
+    virtual void on_dealloc(const AllocEvent& event) = 0;
+
+protected:
+    ~AllocObserver() {}
+};
+
+namespace detail {
+
+inline std::atomic<AllocObserver*>& alloc_observer_slot() {
+    static std::atomic<AllocObserver*> slot(nullptr);
+    return slot;
+}
+
+struct AllocThreadState {
+    const char* site;
+    bool in_observer;
+};
+
+inline AllocThreadState& alloc_thread_state() {
+    static thread_local AllocThreadState state = {nullptr, false};
+    return state;
+}
+
+inline void notify_alloc_observer(AllocObserver* observer, AllocKind kind, const void* ptr,
+                                  size_t size, bool alloc) {
+    AllocThreadState& state = alloc_thread_state();
+    if (state.in_observer) return;
+    state.in_observer = true;
+    AllocEvent event = {kind, ptr, size, state.site};
+    if (alloc) observer->on_alloc(event); else observer->on_dealloc(event);
+    state.in_observer = false;
+}
+
+// Report a block a container took; ptr may be null after a failed attempt
+inline void observe_alloc(AllocKind kind, const void* ptr, size_t size) {
+    AllocObserver* observer = alloc_observer_slot().load(std::memory_order_acquire);
+    if (observer && ptr) notify_alloc_observer(observer, kind, ptr, size, true);
+}
+
+// Report a block a container is about to give back
+inline void observe_dealloc(AllocKind kind, const void* ptr, size_t size) {
+    AllocObserver* observer = alloc_observer_slot().load(std::memory_order_acquire);
+    if (observer && ptr) notify_alloc_observer(observer, kind, ptr, size, false);
+}
+
+// Report a successful reallocation of old_ptr to new_ptr
+inline void observe_realloc(AllocKind kind, const void* old_ptr, size_t old_size,
+                            const void* new_ptr, size_t new_size) {
+    AllocObserver* observer = alloc_observer_slot().load(std::memory_order_acquire);
+    if (!observer || !new_ptr) return;
+    if (old_ptr) notify_alloc_observer(observer, kind, old_ptr, old_size, false);
+    notify_alloc_observer(observer, kind, new_ptr, new_size, true);
+}
+
+} // namespace detail
+
+// Install observer (nullptr to stop observing); returns the previous one
+inline AllocObserver* set_alloc_observer(AllocObserver* observer) {
+    return detail::alloc_observer_slot().exchange(observer, std::memory_order_acq_rel);
+}
+
+inline AllocObserver* alloc_observer() {
+    return detail::alloc_observer_slot().load(std::memory_order_acquire);
+}
+
+// Labels the allocations the current thread makes while it lives. Sites
+// nest; label is not copied, so pass a string literal or other static text.
+class AllocSite {
+    const char* prev_;
+
+public:
+    explicit AllocSite(const char* label) : prev_(detail::alloc_thread_state().site) {
+        detail::alloc_thread_state().site = label;
+    }
+
+    ~AllocSite() { detail::alloc_thread_state().site = prev_; }
+
+    AllocSite(const AllocSite&) = delete;
+    AllocSite& operator=(const AllocSite&) = delete;
+
+    static const char* current() { return detail::alloc_thread_state().site; }
+};
+
+// An observer that counts blocks and bytes per AllocKind and per AllocSite
+// label. Kind totals are lock-free. Site rows are matched by label pointer
+// under a mutex. Row 0 (label nullptr) takes allocations made outside any
+// AllocSite and every label past MAX_SITES. Blocks allocated before the
+// tally was installed may still be freed into it, so live counts are signed.
+class AllocTally : public AllocObserver {
+public:
+    static constexpr size_t MAX_SITES = 64;
+
+    struct Counts {
+        uint64_t allocs;
+        uint64_t deallocs;
+        uint64_t bytes_allocated;
+        uint64_t bytes_freed;
+
+        int64_t live_blocks() const { return int64_t(allocs - deallocs); }
+        int64_t live_bytes() const { return int64_t(bytes_allocated - bytes_freed); }
+    };
+
+    struct SiteRow {
+        const char* site;
+        Counts kinds[ALLOC_KINDS];
+    };
+
+    AllocTally() : site_count_(1) {
+        for (size_t i = 0; i < ALLOC_KINDS; i++) {
+            allocs_[i].store(0, std::memory_order_relaxed);
+            deallocs_[i].store(0, std::memory_order_relaxed);
+            bytes_allocated_[i].store(0, std::memory_order_relaxed);
+            bytes_freed_[i].store(0, std::memory_order_relaxed);
+        }
+        sites_[0].site = nullptr;
+        for (size_t k = 0; k < ALLOC_KINDS; k++) sites_[0].kinds[k] = Counts();
+    }
+
+    void on_alloc(const AllocEvent& event) override {
+        size_t k = static_cast<size_t>(event.kind);
+        allocs_[k].fetch_add(1, std::memory_order_relaxed);
+        bytes_allocated_[k].fetch_add(event.size, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> guard(lock_);
+        Counts& c = row(event.site).kinds[k];
+        c.allocs++;
+        c.bytes_allocated += event.size;
+    }
+
+    void on_dealloc(const AllocEvent& event) override {
+        size_t k = static_cast<size_t>(event.kind);
+        deallocs_[k].fetch_add(1, std::memory_order_relaxed);
+        bytes_freed_[k].fetch_add(event.size, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> guard(lock_);
+        Counts& c = row(event.site).kinds[k];
+        c.deallocs++;
+        c.bytes_freed += event.size;
+    }
+
+    Counts counts(AllocKind kind) const {
+        size_t k = static_cast<size_t>(kind);
+        Counts c = {allocs_[k].load(std::memory_order_relaxed),
+                    deallocs_[k].load(std::memory_order_relaxed),
+                    bytes_allocated_[k].load(std::memory_order_relaxed),
+                    bytes_freed_[k].load(std::memory_order_relaxed)};
+        return c;
+    }
+
+    int64_t live_bytes(AllocKind kind) const { return counts(kind).live_bytes(); }
+
+    // Counts for one site label and kind. A block freed under a different
+    // site than it was allocated under is charged to each site separately.
+    Counts site_counts(const char* site, AllocKind kind) const {
+        std::lock_guard<std::mutex> guard(lock_);
+        for (size_t i = 0; i < site_count_; i++) {
+            if (sites_[i].site == site) return sites_[i].kinds[static_cast<size_t>(kind)];
+        }
+        Counts none = {0, 0, 0, 0};
+        return none;
+    }
+
+    // Call f(const SiteRow&) for the unlabeled row, then every site seen
+    template<typename F>
+    void for_each_site(F f) const {
+        std::lock_guard<std::mutex> guard(lock_);
+        for (size_t i = 0; i < site_count_; i++) f(sites_[i]);
+    }
+
+private:
+    std::atomic<uint64_t> allocs_[ALLOC_KINDS];
+    std::atomic<uint64_t> deallocs_[ALLOC_KINDS];
+    std::atomic<uint64_t> bytes_allocated_[ALLOC_KINDS];
+    std::atomic<uint64_t> bytes_freed_[ALLOC_KINDS];
+
+    mutable std::mutex lock_;
+    SiteRow sites_[MAX_SITES];
+    size_t site_count_;
+
+    SiteRow& row(const char* site) {
+        for (size_t i = 0; i < site_count_; i++) {
+            if (sites_[i].site == site) return sites_[i];
+        }
+        if (site_count_ == MAX_SITES) return sites_[0];
+        SiteRow& r = sites_[site_count_++];
+        r.site = site;
+        for (size_t k = 0; k < ALLOC_KINDS; k++) r.kinds[k] = Counts();
+        return r;
+    }
+};
+
+} // namespace rusty
+
+#endif // RUSTY_ALLOC_OBSERVER_HPP
@@ -4,7 +4,15 @@
 #include <atomic>
 #include <cassert>
 #include <cstddef>  // for size_t
+#include <new>      // for placement new
 #include <utility>  // for std::move, std::forward
+#include "alloc.hpp"
+#include "fwd.hpp"
+#include "marker.hpp"
+#include "rc.hpp"
+#include "niche.hpp"
+#include "relocate.hpp"
+#include "traits.hpp"
 
 // Arc<T> - Atomically Reference Counted pointer
 // Equivalent to Rust's Arc<T>
@@ -14,69 +22,173 @@
 // - Shared ownership across threads
 // - Automatic deallocation when last Arc is dropped
 // - Immutable access only (use Mutex/RwLock for mutation)
+//
+// The value and both counts live in a single allocation. Arc::make()
+// constructs the value in place, and ArcWeak<T> observes it without
+// keeping it alive: the value is dropped with the last Arc, the block is
+// freed with the last ArcWeak (all Arcs together hold one weak reference,
+// as in Rust).
+//
+// Layout: with Align = 0 the counts and the value are packed together.
+// A nonzero Align (a power of two, e.g. CacheAlignedArc<T> with 64) puts
+// the counts and the value on separate Align-byte boundaries and pads the
+// block to a multiple of Align. Cloning and dropping from many threads
+// then writes only the counts' cache line, never the lines that readers
+// of the value or of neighbouring allocations are using.
 
 // @safe
 namespace rusty {
 
-template<typename T>
-class Arc {
-private:
-    struct ControlBlock {
+namespace detail {
+
+template<typename T, size_t Align>
+struct ArcBlock {
+    struct Counts {
+        std::atomic<size_t> strong;
+        std::atomic<size_t> weak;   // ArcWeaks plus one for all Arcs together
+    };
+
+    // The value is destroyed before the block when ArcWeaks outlive it
+    union Storage {
         T value;
-        std::atomic<size_t> ref_count;
-        
-        template<typename... Args>
-        ControlBlock(Args&&... args) 
-            : value(std::forward<Args>(args)...), ref_count(1) {}
+        Storage() {}
+        ~Storage() {}
     };
-    
+
+    // Weak count value while Arc::get_mut() checks for uniqueness
+    static constexpr size_t WEAK_LOCKED = ~size_t(0);
+
+    static constexpr size_t COUNTS_ALIGN = Align > alignof(Counts) ? Align : alignof(Counts);
+    static constexpr size_t VALUE_ALIGN = Align > alignof(T) ? Align : alignof(T);
+
+    alignas(COUNTS_ALIGN) Counts counts;
+    alignas(VALUE_ALIGN) Storage storage;
+
+    ArcBlock() {
+        counts.strong.store(1, std::memory_order_relaxed);
+        counts.weak.store(1, std::memory_order_relaxed);
+    }
+
+    template<typename... Args>
+    static ArcBlock* create(Args&&... args) {
+        Global alloc;
+        void* raw = alloc_or_throw(alloc, sizeof(ArcBlock), alignof(ArcBlock));
+        ArcBlock* block = new (raw) ArcBlock();
+        try {
+            new (&block->storage.value) T(std::forward<Args>(args)...);
+        } catch (...) {
+            block->~ArcBlock();
+            alloc.deallocate(raw, sizeof(ArcBlock), alignof(ArcBlock));
+            throw;
+        }
+        detail::observe_alloc(AllocKind::Arc, raw, sizeof(ArcBlock));
+        return block;
+    }
+
+    // Drop one strong reference, dropping the value after the last
+    void release_strong() {
+        if (counts.strong.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            // We were the last reference
+            std::atomic_thread_fence(std::memory_order_acquire);
+            storage.value.~T();
+            release_weak();
+        }
+    }
+
+    // Drop one weak reference, freeing the block after the last
+    void release_weak() {
+        if (counts.weak.fetch_sub(1, std::memory_order_release) == 1) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            this->~ArcBlock();
+            detail::observe_dealloc(AllocKind::Arc, this, sizeof(ArcBlock));
+            Global().deallocate(this, sizeof(ArcBlock), alignof(ArcBlock));
+        }
+    }
+};
+
+} // namespace detail
+
+template<typename T, size_t Align>
+class Arc {
+private:
+    static_assert((Align & (Align - 1)) == 0, "Arc alignment must be a power of two");
+
+    friend class ArcWeak<T, Align>;
+    friend class ArcSwap<T, Align>;
+    using ControlBlock = detail::ArcBlock<T, Align>;
+
     ControlBlock* ptr;
-    
+
     void increment() {
         if (ptr) {
-            ptr->ref_count.fetch_add(1, std::memory_order_relaxed);
+            ptr->counts.strong.fetch_add(1, std::memory_order_relaxed);
         }
     }
-    
+
     void decrement() {
         if (ptr) {
-            if (ptr->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-                // We were the last reference
-                std::atomic_thread_fence(std::memory_order_acquire);
-                delete ptr;
-            }
+            ptr->release_strong();
+        }
+    }
+
+    // Sole owner with no ArcWeak that could upgrade
+    // The weak count is locked while strong is read, so a concurrent
+    // downgrade from another Arc cannot slip in between (as in Rust)
+    bool is_unique() const {
+        size_t one = 1;
+        if (!ptr->counts.weak.compare_exchange_strong(one, ControlBlock::WEAK_LOCKED,
+                                                      std::memory_order_acquire,
+                                                      std::memory_order_relaxed)) {
+            return false;
         }
+        bool unique = ptr->counts.strong.load(std::memory_order_acquire) == 1;
+        ptr->counts.weak.store(1, std::memory_order_release);
+        return unique;
     }
     
+    // Private constructor from control block (takes over one strong count)
+    explicit Arc(ControlBlock* p) : ptr(p) {}
+
 public:
     // Default constructor - creates empty Arc
     Arc() : ptr(nullptr) {}
-    
+
     // Rust-idiomatic factory method - Arc::new()
     // @lifetime: owned
-    static Arc<T> new_(T value) {
-        return Arc<T>(new ControlBlock(std::move(value)));
+    static Arc new_(T value) {
+        return Arc(ControlBlock::create(std::move(value)));
     }
-    
-    // C++-friendly factory method (kept for compatibility)
+
+    // Construct the value in place from constructor arguments
     // @lifetime: owned
-    static Arc<T> make(T value) {
-        return Arc<T>(new ControlBlock(std::move(value)));
+    template<typename... Args>
+    static Arc make(Args&&... args) {
+        return Arc(ControlBlock::create(std::forward<Args>(args)...));
     }
-    
-    // Private constructor from control block
-    explicit Arc(ControlBlock* p) : ptr(p) {}
-    
+
+    // Upgrade a thread-local Rc once the value has to be shared across
+    // threads. Code that clones heavily inside one thread can keep Rc's
+    // plain counter and pay for atomics only from here on. The value is
+    // moved when rc is the sole owner and cloned otherwise.
+    // @lifetime: owned
+    static Arc from_rc(Rc<T> rc) {
+        if (!rc.is_valid()) return Arc();
+        if (T* unique = rc.get_mut()) {
+            return make(std::move(*unique));
+        }
+        return make(detail::clone_value(*rc));
+    }
+
     // Copy constructor - increases reference count
     Arc(const Arc& other) : ptr(other.ptr) {
         increment();
     }
-    
+
     // Move constructor - no ref count change
     Arc(Arc&& other) noexcept : ptr(other.ptr) {
         other.ptr = nullptr;
     }
-    
+
     // Copy assignment
     Arc& operator=(const Arc& other) {
         if (this != &other) {
@@ -86,7 +198,7 @@ public:
         }
         return *this;
     }
-    
+
     // Move assignment
     Arc& operator=(Arc&& other) noexcept {
         if (this != &other) {
@@ -96,77 +208,252 @@ public:
         }
         return *this;
     }
-    
+
     // Destructor
     ~Arc() {
         decrement();
     }
-    
+
     // Dereference - get immutable reference
     // @lifetime: (&'a) -> &'a
     const T& operator*() const {
         assert(ptr != nullptr);
-        return ptr->value;
+        return ptr->storage.value;
     }
-    
+
     // Arrow operator - access members
     // @lifetime: (&'a) -> &'a
     const T* operator->() const {
         assert(ptr != nullptr);
-        return &ptr->value;
+        return &ptr->storage.value;
     }
-    
+
     // Get raw pointer
     // @lifetime: (&'a) -> &'a
     const T* get() const {
-        return ptr ? &ptr->value : nullptr;
+        return ptr ? &ptr->storage.value : nullptr;
     }
-    
+
     // Check if Arc contains a value
     bool is_valid() const {
         return ptr != nullptr;
     }
-    
+
     // Explicit bool conversion
     explicit operator bool() const {
         return is_valid();
     }
-    
+
     // Get current reference count
     size_t strong_count() const {
-        return ptr ? ptr->ref_count.load(std::memory_order_relaxed) : 0;
+        return ptr ? ptr->counts.strong.load(std::memory_order_relaxed) : 0;
     }
-    
+
+    // Number of ArcWeaks pointing at the value
+    size_t weak_count() const {
+        if (!ptr) return 0;
+        size_t n = ptr->counts.weak.load(std::memory_order_relaxed);
+        return n == ControlBlock::WEAK_LOCKED ? 0 : n - 1;
+    }
+
+    // True when both point at the same allocation
+    static bool ptr_eq(const Arc& a, const Arc& b) {
+        return a.ptr == b.ptr;
+    }
+
     // Clone - explicitly create a new Arc to the same value
     Arc clone() const {
         return Arc(*this);
     }
-    
+
+    // Create a weak reference to the value
+    // @lifetime: owned
+    ArcWeak<T, Align> downgrade() const {
+        return ArcWeak<T, Align>(*this);
+    }
+
     // Try to get mutable reference if we're the only owner
-    // Returns nullptr if there are other references
+    // Returns nullptr if there are other references (strong or weak)
     // @lifetime: (&'a mut) -> &'a mut
     T* get_mut() {
-        if (ptr && ptr->ref_count.load(std::memory_order_relaxed) == 1) {
-            return &ptr->value;
+        if (ptr && is_unique()) {
+            return &ptr->storage.value;
         }
         return nullptr;
     }
+
+    // Clone-on-write mutable access (Rust's Arc::make_mut)
+    // Shared values are cloned into a fresh allocation first; a sole
+    // owner with outstanding ArcWeaks moves the value out instead, which
+    // leaves those weaks expired
+    // @lifetime: (&'a mut) -> &'a mut
+    T& make_mut() {
+        assert(ptr != nullptr);
+        size_t one = 1;
+        if (!ptr->counts.strong.compare_exchange_strong(one, 0, std::memory_order_acquire,
+                                                        std::memory_order_relaxed)) {
+            // Other Arcs exist: clone
+            *this = make(detail::clone_value(ptr->storage.value));
+        } else if (ptr->counts.weak.load(std::memory_order_relaxed) != 1) {
+            // Only ArcWeaks remain and they can no longer upgrade: move out
+            ControlBlock* old = ptr;
+            ptr = ControlBlock::create(std::move(old->storage.value));
+            old->storage.value.~T();
+            old->release_weak();
+        } else {
+            // We were the only reference after all
+            ptr->counts.strong.store(1, std::memory_order_release);
+        }
+        return ptr->storage.value;
+    }
+};
+
+// Weak reference to an Arc's value (Rust's sync::Weak)
+template<typename T, size_t Align>
+class ArcWeak {
+private:
+    using ControlBlock = detail::ArcBlock<T, Align>;
+
+    ControlBlock* ptr;
+
+public:
+    // Empty weak that never upgrades (Rust's Weak::new)
+    ArcWeak() : ptr(nullptr) {}
+
+    // @lifetime: owned
+    static ArcWeak new_() {
+        return ArcWeak();
+    }
+
+    // Downgrade from Arc
+    explicit ArcWeak(const Arc<T, Align>& arc) : ptr(arc.ptr) {
+        if (!ptr) return;
+        size_t n = ptr->counts.weak.load(std::memory_order_relaxed);
+        for (;;) {
+            // Wait out a concurrent Arc::get_mut() uniqueness check
+            if (n == ControlBlock::WEAK_LOCKED) {
+                n = ptr->counts.weak.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (ptr->counts.weak.compare_exchange_weak(n, n + 1, std::memory_order_acquire,
+                                                       std::memory_order_relaxed)) {
+                return;
+            }
+        }
+    }
+
+    ArcWeak(const ArcWeak& other) : ptr(other.ptr) {
+        if (ptr) {
+            ptr->counts.weak.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    ArcWeak(ArcWeak&& other) noexcept : ptr(other.ptr) {
+        other.ptr = nullptr;
+    }
+
+    ArcWeak& operator=(const ArcWeak& other) {
+        if (this != &other) {
+            ArcWeak copy(other);
+            std::swap(ptr, copy.ptr);
+        }
+        return *this;
+    }
+
+    ArcWeak& operator=(ArcWeak&& other) noexcept {
+        if (this != &other) {
+            if (ptr) ptr->release_weak();
+            ptr = other.ptr;
+            other.ptr = nullptr;
+        }
+        return *this;
+    }
+
+    ~ArcWeak() {
+        if (ptr) ptr->release_weak();
+    }
+
+    // Try to upgrade to Arc; returns an empty Arc once the value is gone
+    // @lifetime: owned
+    Arc<T, Align> upgrade() const {
+        if (!ptr) return Arc<T, Align>();
+        size_t n = ptr->counts.strong.load(std::memory_order_relaxed);
+        while (n != 0) {
+            if (ptr->counts.strong.compare_exchange_weak(n, n + 1, std::memory_order_acquire,
+                                                         std::memory_order_relaxed)) {
+                return Arc<T, Align>(ptr);
+            }
+        }
+        return Arc<T, Align>();
+    }
+
+    bool expired() const {
+        return strong_count() == 0;
+    }
+
+    size_t strong_count() const {
+        return ptr ? ptr->counts.strong.load(std::memory_order_relaxed) : 0;
+    }
+
+    // Number of ArcWeaks (0 once the value is gone, as in Rust)
+    size_t weak_count() const {
+        if (!ptr || ptr->counts.strong.load(std::memory_order_relaxed) == 0) return 0;
+        return ptr->counts.weak.load(std::memory_order_relaxed) - 1;
+    }
+
+    // Clone - explicitly create another weak reference
+    ArcWeak clone() const {
+        return ArcWeak(*this);
+    }
 };
 
+// Arc whose counts and value sit on separate cache lines
+template<typename T>
+using CacheAlignedArc = Arc<T, 64>;
+
+// Arc and ArcWeak only hold a pointer to their control block, so they can
+// be relocated bitwise
+template<typename T, size_t Align>
+struct is_trivially_relocatable<Arc<T, Align>> : std::true_type {};
+
+template<typename T, size_t Align>
+struct is_trivially_relocatable<ArcWeak<T, Align>> : std::true_type {};
+
+// Empty handles are null, so Option stores None as a null pointer
+template<typename T, size_t Align>
+struct niche_traits<Arc<T, Align>> : null_pointer_niche {};
+
+template<typename T, size_t Align>
+struct niche_traits<ArcWeak<T, Align>> : null_pointer_niche {};
+
+// Every clone shares the value, and the last one to go drops it on whichever
+// thread that is: T must be both Send and Sync
+template<typename T, size_t Align>
+struct is_send<Arc<T, Align>> : detail::all_of<is_send<T>::value, is_sync<T>::value> {};
+
+template<typename T, size_t Align>
+struct is_sync<Arc<T, Align>> : detail::all_of<is_send<T>::value, is_sync<T>::value> {};
+
+template<typename T, size_t Align>
+struct is_send<ArcWeak<T, Align>> : detail::all_of<is_send<T>::value, is_sync<T>::value> {};
+
+template<typename T, size_t Align>
+struct is_sync<ArcWeak<T, Align>> : detail::all_of<is_send<T>::value, is_sync<T>::value> {};
+
 // Rust-idiomatic factory function
 template<typename T, typename... Args>
 // @lifetime: owned
 Arc<T> arc(Args&&... args) {
-    return Arc<T>::new_(T(std::forward<Args>(args)...));
+    return Arc<T>::make(std::forward<Args>(args)...);
 }
 
 // C++-friendly factory function (kept for compatibility)
 template<typename T, typename... Args>
 // @lifetime: owned
 Arc<T> make_arc(Args&&... args) {
-    return Arc<T>::make(T(std::forward<Args>(args)...));
+    return Arc<T>::make(std::forward<Args>(args)...);
 }
 
 } // namespace rusty
 
-#endif // RUSTY_ARC_HPP
\ No newline at end of file
+#endif // RUSTY_ARC_HPP
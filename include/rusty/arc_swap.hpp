@@ -0,0 +1,346 @@
+#ifndef RUSTY_ARC_SWAP_HPP
+#define RUSTY_ARC_SWAP_HPP
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include "alloc.hpp"
+#include "arc.hpp"
+
+// ArcSwap<T> - an atomically replaceable Arc<T>
+// Equivalent to Rust's arc_swap::ArcSwap
+//
+// Readers call load() and get a Guard that dereferences to the current
+// value without touching its reference count; writers publish a new Arc
+// with store()/swap() without ever waiting for readers.
+//
+// Reclamation uses arc-swap's "debt" scheme, a hazard-pointer variant:
+// - Every thread owns a few debt slots in a global registry. load()
+//   writes the pointer it read into a free slot, then re-reads the
+//   ArcSwap; if the pointer is unchanged the slot protects it and the
+//   Guard reads through it.
+// - A writer that swapped out an old pointer walks the registry and,
+//   for every slot still holding it, adds one strong count on the
+//   reader's behalf and clears the slot ("pays the debt").
+// - Dropping a Guard clears its slot; if a writer already cleared it,
+//   the Guard owns a strong count and releases it instead.
+// load() therefore never blocks, and a swapped-out value lives exactly as
+// long as the last Guard or Arc observing it.
+//
+// Guards are meant to be short-lived and must be dropped on the thread
+// that created them. Each thread has GUARD_SLOTS slots; a load() beyond
+// that takes a full strong reference (still lock-free, just slower).
+// Use load_full() for an Arc that is kept around.
+
+// @safe
+namespace rusty {
+namespace detail {
+
+// A thread's debt slots; nodes are never freed, only reused by later threads
+struct alignas(64) DebtNode {
+    static constexpr size_t GUARD_SLOTS = 8;
+
+    std::atomic<void*> slots[GUARD_SLOTS];
+    std::atomic<void*> transient;   // used inside load_full() only
+    std::atomic<bool> in_use;
+    uint32_t owned;                 // Guard-held slots, owning thread only
+    DebtNode* next;                 // immutable once published
+
+    DebtNode() : owned(0), next(nullptr) {
+        for (auto& slot : slots) slot.store(nullptr, std::memory_order_relaxed);
+        transient.store(nullptr, std::memory_order_relaxed);
+        in_use.store(true, std::memory_order_relaxed);
+    }
+};
+
+inline std::atomic<DebtNode*>& debt_list_head() {
+    static std::atomic<DebtNode*> head(nullptr);
+    return head;
+}
+
+// Claim a node released by an exited thread, or publish a new one
+inline DebtNode* claim_debt_node() {
+    std::atomic<DebtNode*>& head = debt_list_head();
+    for (DebtNode* node = head.load(std::memory_order_acquire); node; node = node->next) {
+        bool expected = false;
+        if (!node->in_use.load(std::memory_order_relaxed) &&
+            node->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return node;
+        }
+    }
+    Global alloc;
+    DebtNode* node = new (alloc_or_throw(alloc, sizeof(DebtNode), alignof(DebtNode))) DebtNode();
+    DebtNode* first = head.load(std::memory_order_relaxed);
+    do {
+        node->next = first;
+    } while (!head.compare_exchange_weak(first, node, std::memory_order_release,
+                                         std::memory_order_relaxed));
+    return node;
+}
+
+struct DebtHandle {
+    DebtNode* node;
+
+    DebtHandle() : node(nullptr) {}
+    ~DebtHandle() {
+        if (node) {
+            node->owned = 0;
+            node->in_use.store(false, std::memory_order_release);
+        }
+    }
+};
+
+inline DebtNode& local_debts() {
+    static thread_local DebtHandle handle;
+    if (!handle.node) handle.node = claim_debt_node();
+    return *handle.node;
+}
+
+// Writer side: turn every outstanding debt on ptr into a strong count
+// The caller must itself hold a strong count on ptr
+template<typename Block>
+void pay_debts(Block* ptr) {
+    for (DebtNode* node = debt_list_head().load(std::memory_order_acquire); node;
+         node = node->next) {
+        auto pay = [ptr](std::atomic<void*>& slot) {
+            if (slot.load(std::memory_order_seq_cst) != ptr) return;
+            ptr->counts.strong.fetch_add(1, std::memory_order_relaxed);
+            void* expected = ptr;
+            if (!slot.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel)) {
+                // The reader finished first; take the count back
+                ptr->counts.strong.fetch_sub(1, std::memory_order_relaxed);
+            }
+        };
+        for (auto& slot : node->slots) pay(slot);
+        pay(node->transient);
+    }
+}
+
+} // namespace detail
+
+template<typename T, size_t Align>
+class ArcSwap {
+private:
+    using ControlBlock = detail::ArcBlock<T, Align>;
+
+    std::atomic<ControlBlock*> ptr_;
+
+    // Swap in a block whose strong count we own; return the old one's count
+    ControlBlock* exchange(ControlBlock* next) {
+        ControlBlock* old = ptr_.exchange(next, std::memory_order_seq_cst);
+        if (old) detail::pay_debts(old);
+        return old;
+    }
+
+    static ControlBlock* into_raw(Arc<T, Align>& arc) {
+        ControlBlock* block = arc.ptr;
+        arc.ptr = nullptr;
+        return block;
+    }
+
+public:
+    // Read access to the value current at load() time
+    class Guard {
+    private:
+        friend class ArcSwap;
+
+        ControlBlock* ptr_;
+        detail::DebtNode* node_;
+        int slot_;   // -1 when the Guard owns a strong count instead
+
+        Guard(ControlBlock* ptr, detail::DebtNode* node, int slot)
+            : ptr_(ptr), node_(node), slot_(slot) {}
+
+        void release() {
+            if (!ptr_) return;
+            if (slot_ >= 0) {
+                void* expected = ptr_;
+                bool cleared = node_->slots[slot_].compare_exchange_strong(
+                    expected, nullptr, std::memory_order_acq_rel);
+                node_->owned &= ~(uint32_t(1) << slot_);
+                if (cleared) return;
+            }
+            // A writer paid our debt (or we never had a slot)
+            ptr_->release_strong();
+        }
+
+    public:
+        Guard(Guard&& other) noexcept : ptr_(other.ptr_), node_(other.node_), slot_(other.slot_) {
+            other.ptr_ = nullptr;
+        }
+
+        Guard& operator=(Guard&& other) noexcept {
+            if (this != &other) {
+                release();
+                ptr_ = other.ptr_;
+                node_ = other.node_;
+                slot_ = other.slot_;
+                other.ptr_ = nullptr;
+            }
+            return *this;
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        ~Guard() { release(); }
+
+        // @lifetime: (&'a) -> &'a
+        const T& operator*() const {
+            assert(ptr_ != nullptr);
+            return ptr_->storage.value;
+        }
+
+        // @lifetime: (&'a) -> &'a
+        const T* operator->() const {
+            assert(ptr_ != nullptr);
+            return &ptr_->storage.value;
+        }
+
+        // @lifetime: (&'a) -> &'a
+        const T* get() const { return ptr_ ? &ptr_->storage.value : nullptr; }
+
+        bool is_valid() const { return ptr_ != nullptr; }
+        explicit operator bool() const { return is_valid(); }
+
+        // Upgrade to an Arc that may outlive the Guard
+        // @lifetime: owned
+        Arc<T, Align> to_arc() const {
+            if (ptr_) ptr_->counts.strong.fetch_add(1, std::memory_order_relaxed);
+            return Arc<T, Align>(ptr_);
+        }
+    };
+
+    // Takes over the Arc (which may be empty)
+    explicit ArcSwap(Arc<T, Align> initial = Arc<T, Align>()) : ptr_(into_raw(initial)) {}
+
+    // @lifetime: owned
+    static ArcSwap new_(Arc<T, Align> initial) {
+        return ArcSwap(std::move(initial));
+    }
+
+    // @lifetime: owned
+    static ArcSwap from_pointee(T value) {
+        return ArcSwap(Arc<T, Align>::new_(std::move(value)));
+    }
+
+    // Moving needs exclusive access, so no load() can be running
+    ArcSwap(ArcSwap&& other) noexcept
+        : ptr_(other.ptr_.exchange(nullptr, std::memory_order_relaxed)) {}
+
+    ArcSwap(const ArcSwap&) = delete;
+    ArcSwap& operator=(const ArcSwap&) = delete;
+
+    ~ArcSwap() {
+        // Guards may outlive the ArcSwap: pay them before dropping our count
+        ControlBlock* old = exchange(nullptr);
+        if (old) old->release_strong();
+    }
+
+    // @lifetime: (&'a) -> &'a
+    Guard load() const {
+        ControlBlock* ptr = ptr_.load(std::memory_order_acquire);
+        if (!ptr) return Guard(nullptr, nullptr, -1);
+
+        detail::DebtNode& node = detail::local_debts();
+        uint32_t free_slots = ~node.owned & ((uint32_t(1) << detail::DebtNode::GUARD_SLOTS) - 1);
+        if (free_slots == 0) {
+            Arc<T, Align> full = load_full();
+            return Guard(into_raw(full), nullptr, -1);
+        }
+        int slot = __builtin_ctz(free_slots);
+
+        for (;;) {
+            node.slots[slot].store(ptr, std::memory_order_seq_cst);
+            ControlBlock* now = ptr_.load(std::memory_order_seq_cst);
+            if (now == ptr) {
+                node.owned |= uint32_t(1) << slot;
+                return Guard(ptr, &node, slot);
+            }
+            void* expected = ptr;
+            if (!node.slots[slot].compare_exchange_strong(expected, nullptr,
+                                                          std::memory_order_acq_rel)) {
+                // A writer paid for ptr in the meantime: we hold a count on it
+                return Guard(ptr, nullptr, -1);
+            }
+            if (!now) return Guard(nullptr, nullptr, -1);
+            ptr = now;
+        }
+    }
+
+    // Load as a full Arc (one strong count increment)
+    // @lifetime: owned
+    Arc<T, Align> load_full() const {
+        detail::DebtNode& node = detail::local_debts();
+        for (;;) {
+            ControlBlock* ptr = ptr_.load(std::memory_order_acquire);
+            if (!ptr) return Arc<T, Align>();
+            node.transient.store(ptr, std::memory_order_seq_cst);
+            bool protected_ = ptr_.load(std::memory_order_seq_cst) == ptr;
+            if (protected_) {
+                ptr->counts.strong.fetch_add(1, std::memory_order_relaxed);
+            }
+            void* expected = ptr;
+            bool cleared = node.transient.compare_exchange_strong(expected, nullptr,
+                                                                  std::memory_order_acq_rel);
+            if (protected_ && !cleared) {
+                // Counted twice: by us and by a writer paying the debt
+                ptr->counts.strong.fetch_sub(1, std::memory_order_relaxed);
+            }
+            if (protected_ || !cleared) {
+                return Arc<T, Align>(ptr);
+            }
+        }
+    }
+
+    // Publish a new value; the old one is dropped once no reader sees it
+    void store(Arc<T, Align> next) {
+        ControlBlock* old = exchange(into_raw(next));
+        if (old) old->release_strong();
+    }
+
+    // Publish a new value and return the previous one
+    // @lifetime: owned
+    Arc<T, Align> swap(Arc<T, Align> next) {
+        return Arc<T, Align>(exchange(into_raw(next)));
+    }
+
+    // Store next only if current is still published; returns the value
+    // that was published (equal to current on success)
+    // @lifetime: owned
+    Arc<T, Align> compare_and_swap(const Arc<T, Align>& current, Arc<T, Align> next) {
+        ControlBlock* expected = current.ptr;
+        if (ptr_.compare_exchange_strong(expected, next.ptr, std::memory_order_seq_cst)) {
+            next.ptr = nullptr;
+            if (expected) detail::pay_debts(expected);
+            return Arc<T, Align>(expected);
+        }
+        return load_full();
+    }
+
+    // Read-copy-update: retry f(current) until it is published unchanged
+    // f must not be null-dereferencing: the ArcSwap has to hold a value
+    template<typename F>
+    void rcu(F f) {
+        for (;;) {
+            Arc<T, Align> current = load_full();
+            assert(current.is_valid());
+            Arc<T, Align> next = Arc<T, Align>::make(f(*current));
+            Arc<T, Align> previous = compare_and_swap(current, std::move(next));
+            if (Arc<T, Align>::ptr_eq(previous, current)) return;
+        }
+    }
+};
+
+template<typename T, size_t Align>
+struct is_send<ArcSwap<T, Align>> : is_send<Arc<T, Align>> {};
+
+template<typename T, size_t Align>
+struct is_sync<ArcSwap<T, Align>> : is_sync<Arc<T, Align>> {};
+
+} // namespace rusty
+
+#endif // RUSTY_ARC_SWAP_HPP
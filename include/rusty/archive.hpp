@@ -0,0 +1,1092 @@
+#ifndef RUSTY_ARCHIVE_HPP
+#define RUSTY_ARCHIVE_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>  // for std::equal_to
+#include <iterator>    // for std::make_move_iterator
+#include <type_traits>
+#include <utility>
+#include "btreemap.hpp"
+#include "hashmap.hpp"
+#include "iter.hpp"
+#include "mmap.hpp"
+#include "option.hpp"
+#include "result.hpp"
+#include "slice.hpp"
+#include "string.hpp"
+#include "vec.hpp"
+
+// archive - A compact binary format for rusty containers that can be
+// read in place
+// Modeled on Rust's rkyv
+//
+//   Vec<uint8_t> bytes = rusty::archive::to_bytes(routes);   // HashMap<String, uint32_t>
+//   auto view = rusty::archive::access<HashMap<String, uint32_t>>(bytes.as_slice());
+//   uint32_t port = view.unwrap()->get("api").unwrap();      // no deserialization
+//   auto copy = rusty::archive::from_bytes<HashMap<String, uint32_t>>(bytes.as_slice());
+//
+// An archive is a header followed by the archived form of each object,
+// children before parents. Archived<T> is a plain struct whose pointers
+// are self-relative offsets, so the bytes can be used from any address
+// (a read buffer or an mmap) without fixing anything up:
+// - Integers, floats, enums and types marked is_archive_pod are stored
+//   as they are
+// - String becomes ArchivedString, Vec<T> ArchivedVec<Archived<T>>,
+//   Option<T> ArchivedOption and std::pair ArchivedPair
+// - HashMap becomes ArchivedHashMap: a freshly built SwissTable with the
+//   same control bytes, 7-bit tags and group probing as HashMap, holding
+//   the archived entries inline, so get() is one hash and a group match
+// - BTreeMap becomes ArchivedBTreeMap: its entries in key order under a
+//   static B-tree of separator keys
+//
+// access() checks the whole archive once (header, bounds, alignment and
+// table invariants) in O(size) without allocating; access_unchecked() is
+// O(1) for bytes this process wrote or already checked. Archives use the
+// writer's byte order and are rejected on a machine with the other one.
+// Lookups hash the query with a default-constructed Hash, so the reader
+// must use the same hash function as the writer (FxHash is stable).
+//
+// Other types are archived by specializing Archiver<T> (see the POD and
+// String archivers below for the four functions it needs).
+
+// @safe
+namespace rusty {
+
+struct ArchiveError {
+    const char* message;
+
+    bool operator==(const ArchiveError& other) const {
+        return std::strcmp(message, other.message) == 0;
+    }
+};
+
+// The archived form of T, and how to write and read it
+template<typename T, typename Enable = void>
+struct Archiver;
+
+template<typename T>
+using Archived = typename Archiver<T>::Archived;
+
+// Types stored byte for byte. Specialize to true for trivially copyable
+// structs without pointers.
+template<typename T>
+struct is_archive_pod
+    : std::integral_constant<bool, std::is_arithmetic<T>::value || std::is_enum<T>::value> {};
+
+namespace detail {
+
+// Mirrored control bytes after a table: enough for the widest Group
+constexpr size_t ARCHIVE_CTRL_TAIL = 32;
+
+} // namespace detail
+
+// Offset from this field to the target, so archives need no relocation
+template<typename T>
+struct RelPtr {
+    int64_t offset;
+
+    static RelPtr between(size_t self_pos, size_t target_pos) {
+        RelPtr p;
+        p.offset = static_cast<int64_t>(target_pos) - static_cast<int64_t>(self_pos);
+        return p;
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const T* get() const {
+        return reinterpret_cast<const T*>(reinterpret_cast<uintptr_t>(this) + static_cast<uintptr_t>(offset));
+    }
+};
+
+// Builds an archive in a growing byte buffer
+class ArchiveWriter {
+private:
+    Vec<uint8_t> bytes_;
+
+public:
+    ArchiveWriter() : bytes_() {}
+
+    size_t pos() const { return bytes_.len(); }
+
+    // Pad to a multiple of align, then append n zero bytes; returns where
+    // they start
+    size_t reserve(size_t n, size_t align) {
+        size_t at = detail::align_to(bytes_.len(), align);
+        bytes_.resize(at + n, 0);
+        return at;
+    }
+
+    size_t write(const void* data, size_t n, size_t align) {
+        size_t at = reserve(n, align);
+        if (n) std::memcpy(bytes_.as_mut_ptr() + at, data, n);
+        return at;
+    }
+
+    // Store a value into bytes already reserved
+    template<typename A>
+    void put(size_t at, const A& value) {
+        static_assert(std::is_trivially_copyable<A>::value, "archived types are plain bytes");
+        std::memcpy(bytes_.as_mut_ptr() + at, &value, sizeof(A));
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    uint8_t* at(size_t pos) { return bytes_.as_mut_ptr() + pos; }
+
+    // @lifetime: owned
+    Vec<uint8_t> finish() { return std::move(bytes_); }
+};
+
+// The byte range access() checks every offset against
+struct ArchiveBounds {
+    const uint8_t* begin;
+    const uint8_t* end;
+
+    bool contains(const void* p, size_t size, size_t align) const {
+        uintptr_t a = reinterpret_cast<uintptr_t>(p);
+        uintptr_t lo = reinterpret_cast<uintptr_t>(begin);
+        uintptr_t hi = reinterpret_cast<uintptr_t>(end);
+        return a >= lo && a <= hi && size <= hi - a && a % align == 0;
+    }
+
+    template<typename T>
+    bool contains_array(const T* p, uint64_t count) const {
+        return count <= SIZE_MAX / sizeof(T) && contains(p, size_t(count) * sizeof(T), alignof(T));
+    }
+};
+
+namespace detail {
+
+// Key comparisons on Archiver<K>::View values
+template<typename A>
+bool archive_view_eq(const A& a, const A& b) { return a == b; }
+
+template<typename A>
+bool archive_view_less(const A& a, const A& b) { return a < b; }
+
+inline bool archive_view_less(str a, str b) { return a.as_str() < b.as_str(); }
+
+struct ArchiveNoResolver {};
+
+} // namespace detail
+
+// Plain values: stored in place, nothing out of line
+template<typename T>
+struct Archiver<T, typename std::enable_if<is_archive_pod<T>::value>::type> {
+    typedef T Archived;
+    typedef T View;  // What lookups by this key take
+    typedef detail::ArchiveNoResolver Resolver;
+
+    // Write everything the archived form points to; returns what
+    // resolve() needs to fill in the offsets
+    static Resolver serialize(const T&, ArchiveWriter&) { return Resolver(); }
+
+    // Write the archived form into the sizeof(Archived) bytes at at
+    static void resolve(const T& value, const Resolver&, size_t at, ArchiveWriter& w) {
+        w.put(at, value);
+    }
+
+    static bool verify(const Archived& a, const ArchiveBounds&) {
+        if (std::is_same<T, bool>::value) {
+            uint8_t byte;
+            std::memcpy(&byte, &a, 1);
+            return byte <= 1;
+        }
+        return true;
+    }
+
+    static T deserialize(const Archived& a) { return a; }
+    static View view(const Archived& a) { return a; }
+};
+
+class ArchivedString {
+private:
+    template<typename, typename> friend struct Archiver;
+
+    RelPtr<char> ptr_;
+    uint64_t len_;
+
+public:
+    size_t len() const { return static_cast<size_t>(len_); }
+    bool is_empty() const { return len_ == 0; }
+
+    // NUL-terminated
+    // @lifetime: (&'a) -> &'a
+    const char* as_ptr() const { return ptr_.get(); }
+
+    // @lifetime: (&'a) -> &'a
+    std::string_view as_str() const { return std::string_view(as_ptr(), len()); }
+
+    // @lifetime: (&'a) -> &'a
+    str as_ref() const { return str(as_ptr(), len()); }
+
+    bool operator==(str other) const { return as_ref() == other; }
+    bool operator!=(str other) const { return !(as_ref() == other); }
+};
+
+template<typename Alloc>
+struct Archiver<BasicString<Alloc>> {
+    typedef ArchivedString Archived;
+    typedef str View;
+    struct Resolver {
+        size_t pos;
+    };
+
+    static Resolver serialize(const BasicString<Alloc>& s, ArchiveWriter& w) {
+        size_t pos = w.reserve(s.len() + 1, 1);
+        if (s.len()) std::memcpy(w.at(pos), s.as_ptr(), s.len());
+        Resolver r = {pos};
+        return r;
+    }
+
+    static void resolve(const BasicString<Alloc>& s, const Resolver& r, size_t at, ArchiveWriter& w) {
+        ArchivedString a;
+        a.ptr_ = RelPtr<char>::between(at + offsetof(ArchivedString, ptr_), r.pos);
+        a.len_ = s.len();
+        w.put(at, a);
+    }
+
+    static bool verify(const Archived& a, const ArchiveBounds& b) {
+        return a.len_ < SIZE_MAX && b.contains(a.as_ptr(), size_t(a.len_) + 1, 1) && a.as_ptr()[a.len()] == '\0';
+    }
+
+    // @lifetime: owned
+    static BasicString<Alloc> deserialize(const Archived& a) { return BasicString<Alloc>::from(a.as_str()); }
+
+    static View view(const Archived& a) { return a.as_ref(); }
+};
+
+// A contiguous run of archived elements
+template<typename T>
+class ArchivedVec {
+private:
+    template<typename, typename> friend struct Archiver;
+
+    RelPtr<T> ptr_;
+    uint64_t len_;
+
+public:
+    size_t len() const { return static_cast<size_t>(len_); }
+    bool is_empty() const { return len_ == 0; }
+
+    // @lifetime: (&'a) -> &'a
+    const T* as_ptr() const { return ptr_.get(); }
+
+    // @lifetime: (&'a) -> &'a
+    Slice<T> as_slice() const { return Slice<T>(as_ptr(), len()); }
+
+    // @lifetime: (&'a) -> &'a
+    const T& operator[](size_t index) const {
+        assert(index < len() && "ArchivedVec index out of bounds");
+        return as_ptr()[index];
+    }
+
+    // @lifetime: (&'a) -> &'a
+    Option<const T&> get(size_t index) const {
+        if (index >= len()) return None;
+        return Option<const T&>(as_ptr()[index]);
+    }
+
+    // @lifetime: (&'a) -> &'a
+    SliceIter<T> iter() const { return SliceIter<T>(as_ptr(), as_ptr() + len()); }
+
+    // @lifetime: (&'a) -> &'a
+    const T* begin() const { return as_ptr(); }
+    // @lifetime: (&'a) -> &'a
+    const T* end() const { return as_ptr() + len(); }
+};
+
+namespace detail {
+
+// Write n elements' out-of-line data, then their archived forms as one
+// array; returns the array's position
+template<typename T, typename Get>
+size_t archive_array(size_t n, Get get, ArchiveWriter& w) {
+    typedef Archiver<T> A;
+    Vec<typename A::Resolver> resolvers = Vec<typename A::Resolver>::with_capacity(n);
+    for (size_t i = 0; i < n; i++) {
+        resolvers.push(A::serialize(get(i), w));
+    }
+    size_t pos = w.reserve(n * sizeof(typename A::Archived), alignof(typename A::Archived));
+    for (size_t i = 0; i < n; i++) {
+        A::resolve(get(i), resolvers[i], pos + i * sizeof(typename A::Archived), w);
+    }
+    return pos;
+}
+
+template<typename T>
+bool verify_array(const Archived<T>* p, size_t n, const ArchiveBounds& b) {
+    if (!b.contains_array(p, n)) return false;
+    if (is_archive_pod<T>::value && !std::is_same<T, bool>::value) return true;
+    for (size_t i = 0; i < n; i++) {
+        if (!Archiver<T>::verify(p[i], b)) return false;
+    }
+    return true;
+}
+
+} // namespace detail
+
+template<typename T, typename Alloc>
+struct Archiver<Vec<T, Alloc>> {
+    typedef ArchivedVec<rusty::Archived<T>> Archived;
+    struct Resolver {
+        size_t pos;
+    };
+
+    static Resolver serialize(const Vec<T, Alloc>& v, ArchiveWriter& w) {
+        Resolver r;
+        if (is_archive_pod<T>::value) {
+            r.pos = w.write(v.as_ptr(), v.len() * sizeof(T), alignof(T));
+        } else {
+            r.pos = detail::archive_array<T>(v.len(), [&v](size_t i) -> const T& { return v[i]; }, w);
+        }
+        return r;
+    }
+
+    static void resolve(const Vec<T, Alloc>& v, const Resolver& r, size_t at, ArchiveWriter& w) {
+        Archived a;
+        a.ptr_ = RelPtr<rusty::Archived<T>>::between(at + offsetof(Archived, ptr_), r.pos);
+        a.len_ = v.len();
+        w.put(at, a);
+    }
+
+    static bool verify(const Archived& a, const ArchiveBounds& b) {
+        return detail::verify_array<T>(a.as_ptr(), a.len_ <= SIZE_MAX ? size_t(a.len_) : SIZE_MAX, b);
+    }
+
+    // @lifetime: owned
+    static Vec<T, Alloc> deserialize(const Archived& a) {
+        Vec<T, Alloc> out = Vec<T, Alloc>::with_capacity(a.len());
+        deserialize_into(out, a, is_archive_pod<T>());
+        return out;
+    }
+
+private:
+    static void deserialize_into(Vec<T, Alloc>& out, const Archived& a, std::true_type) {
+        out.extend_from_slice(reinterpret_cast<const T*>(a.as_ptr()), a.len());
+    }
+
+    static void deserialize_into(Vec<T, Alloc>& out, const Archived& a, std::false_type) {
+        for (size_t i = 0; i < a.len(); i++) {
+            out.push(Archiver<T>::deserialize(a[i]));
+        }
+    }
+};
+
+template<typename A, typename B>
+struct ArchivedPair {
+    A first;
+    B second;
+};
+
+template<typename A, typename B>
+struct Archiver<std::pair<A, B>> {
+    typedef ArchivedPair<rusty::Archived<A>, rusty::Archived<B>> Archived;
+    struct Resolver {
+        typename Archiver<A>::Resolver first;
+        typename Archiver<B>::Resolver second;
+    };
+
+    static Resolver serialize(const std::pair<A, B>& p, ArchiveWriter& w) {
+        Resolver r = {Archiver<A>::serialize(p.first, w), Archiver<B>::serialize(p.second, w)};
+        return r;
+    }
+
+    static void resolve(const std::pair<A, B>& p, const Resolver& r, size_t at, ArchiveWriter& w) {
+        Archiver<A>::resolve(p.first, r.first, at + offsetof(Archived, first), w);
+        Archiver<B>::resolve(p.second, r.second, at + offsetof(Archived, second), w);
+    }
+
+    static bool verify(const Archived& a, const ArchiveBounds& b) {
+        return Archiver<A>::verify(a.first, b) && Archiver<B>::verify(a.second, b);
+    }
+
+    // @lifetime: owned
+    static std::pair<A, B> deserialize(const Archived& a) {
+        return std::pair<A, B>(Archiver<A>::deserialize(a.first), Archiver<B>::deserialize(a.second));
+    }
+};
+
+template<typename T>
+class ArchivedOption {
+private:
+    template<typename, typename> friend struct Archiver;
+
+    T value_;  // Zero bytes when None
+    uint8_t some_;
+
+public:
+    bool is_some() const { return some_ != 0; }
+    bool is_none() const { return some_ == 0; }
+
+    // @lifetime: (&'a) -> &'a
+    Option<const T&> as_ref() const {
+        if (!is_some()) return None;
+        return Option<const T&>(value_);
+    }
+};
+
+template<typename T>
+struct Archiver<Option<T>> {
+    typedef ArchivedOption<rusty::Archived<T>> Archived;
+    struct Resolver {
+        typename Archiver<T>::Resolver value;
+    };
+
+    static Resolver serialize(const Option<T>& o, ArchiveWriter& w) {
+        Resolver r = Resolver();
+        if (o.is_some()) r.value = Archiver<T>::serialize(o.unwrap_ref(), w);
+        return r;
+    }
+
+    static void resolve(const Option<T>& o, const Resolver& r, size_t at, ArchiveWriter& w) {
+        if (o.is_none()) return;  // Already zero
+        Archiver<T>::resolve(o.unwrap_ref(), r.value, at + offsetof(Archived, value_), w);
+        w.at(at + offsetof(Archived, some_))[0] = 1;
+    }
+
+    static bool verify(const Archived& a, const ArchiveBounds& b) {
+        if (a.some_ > 1) return false;
+        return a.is_none() || Archiver<T>::verify(a.value_, b);
+    }
+
+    // @lifetime: owned
+    static Option<T> deserialize(const Archived& a) {
+        if (a.is_none()) return None;
+        return Option<T>(Archiver<T>::deserialize(a.value_));
+    }
+};
+
+// A read-only SwissTable over archived entries
+// The control bytes use HashMap's encoding and probing; the group width
+// the writer probed with is recorded, so a reader built with a different
+// Group backend scans the same windows.
+template<typename K, typename V, typename Hash = FxHash<K>>
+class ArchivedHashMap {
+public:
+    typedef rusty::Archived<K> ArchivedKey;
+    typedef rusty::Archived<V> ArchivedValue;
+    typedef ArchivedPair<ArchivedKey, ArchivedValue> Entry;
+    typedef typename Archiver<K>::View View;
+
+private:
+    template<typename, typename> friend struct Archiver;
+
+    // [ctrl; buckets + ARCHIVE_CTRL_TAIL] [Entry; buckets]
+    RelPtr<uint8_t> ctrl_;
+    uint64_t buckets_;      // Zero or a power of two
+    uint64_t len_;
+    uint64_t group_width_;  // Probe stride used by the writer
+
+    static size_t entries_offset(size_t buckets) {
+        return detail::align_to(buckets + detail::ARCHIVE_CTRL_TAIL, alignof(Entry));
+    }
+
+    const Entry* entries() const {
+        return reinterpret_cast<const Entry*>(ctrl_.get() + entries_offset(size_t(buckets_)));
+    }
+
+    const Entry* find(View key) const {
+        if (len_ == 0) return nullptr;
+        size_t hash = Hash()(key);
+        size_t mask = size_t(buckets_) - 1;
+        size_t width = size_t(group_width_);
+        const uint8_t* ctrl = ctrl_.get();
+        const Entry* slots = entries();
+        uint8_t h2 = h2_hash(hash);
+        size_t pos = h1_hash(hash) & mask;
+        size_t stride = 0;
+        while (true) {
+            // One writer-width window, in however many loads it takes here
+            bool saw_empty = false;
+            for (size_t o = 0; o < width; o += GROUP_SIZE) {
+                Group g = Group::load(ctrl + pos + o);
+                BitMask matches = g.match_byte(h2);
+                while (matches) {
+                    size_t bit = o + matches.lowest();
+                    if (bit < width) {
+                        const Entry& e = slots[(pos + bit) & mask];
+                        if (detail::archive_view_eq(Archiver<K>::view(e.first), key)) return &e;
+                    }
+                    matches.clear_lowest();
+                }
+                BitMask empty = g.match_empty();
+                if (empty && o + empty.lowest() < width) saw_empty = true;
+            }
+            if (saw_empty) return nullptr;
+            stride += width;
+            pos = (pos + stride) & mask;
+        }
+    }
+
+public:
+    size_t len() const { return static_cast<size_t>(len_); }
+    bool is_empty() const { return len_ == 0; }
+
+    // @lifetime: (&'a) -> &'a
+    Option<const ArchivedValue&> get(View key) const {
+        const Entry* e = find(key);
+        if (!e) return None;
+        return Option<const ArchivedValue&>(e->second);
+    }
+
+    bool contains_key(View key) const { return find(key) != nullptr; }
+
+    // @lifetime: (&'a) -> &'a
+    Option<std::pair<const ArchivedKey*, const ArchivedValue*>> get_key_value(View key) const {
+        const Entry* e = find(key);
+        if (!e) return None;
+        return Option<std::pair<const ArchivedKey*, const ArchivedValue*>>(std::make_pair(&e->first, &e->second));
+    }
+
+    // Entries in bucket order
+    class Iter : public Iterator<Iter, const Entry&> {
+    private:
+        const uint8_t* ctrl_;
+        const Entry* entries_;
+        size_t index_;
+        size_t remaining_;
+
+    public:
+        Iter(const uint8_t* ctrl, const Entry* entries, size_t len)
+            : ctrl_(ctrl), entries_(entries), index_(0), remaining_(len) {}
+
+        template<typename F>
+        bool next_with(F&& f) {
+            if (remaining_ == 0) return false;
+            while (!is_full(ctrl_[index_])) {
+                index_++;
+            }
+            remaining_--;
+            f(entries_[index_++]);
+            return true;
+        }
+
+        size_t len() const { return remaining_; }
+        size_t size_hint() const { return remaining_; }
+    };
+
+    // Items are const Entry&, with .first and .second
+    // @lifetime: (&'a) -> &'a
+    Iter iter() const {
+        if (len_ == 0) return Iter(nullptr, nullptr, 0);
+        return Iter(ctrl_.get(), entries(), len());
+    }
+};
+
+template<typename K, typename V, typename Hash, typename KeyEqual, typename Alloc, typename Layout>
+struct Archiver<HashMap<K, V, Hash, KeyEqual, Alloc, Layout>> {
+    typedef HashMap<K, V, Hash, KeyEqual, Alloc, Layout> Map;
+    typedef ArchivedHashMap<K, V, Hash> Archived;
+    typedef typename Archived::Entry Entry;
+    struct Resolver {
+        size_t pos;
+        size_t buckets;
+    };
+
+    static Resolver serialize(const Map& map, ArchiveWriter& w) {
+        Resolver r = {0, 0};
+        size_t n = map.len();
+        if (n == 0) return r;
+
+        Vec<std::pair<const K*, const V*>> entries = Vec<std::pair<const K*, const V*>>::with_capacity(n);
+        map.iter().for_each([&entries](std::pair<const K&, const V&> kv) {
+            entries.push(std::make_pair(&kv.first, &kv.second));
+        });
+        Vec<typename Archiver<K>::Resolver> keys = Vec<typename Archiver<K>::Resolver>::with_capacity(n);
+        Vec<typename Archiver<V>::Resolver> values = Vec<typename Archiver<V>::Resolver>::with_capacity(n);
+        for (size_t i = 0; i < n; i++) {
+            keys.push(Archiver<K>::serialize(*entries[i].first, w));
+            values.push(Archiver<V>::serialize(*entries[i].second, w));
+        }
+
+        // Place every entry as HashMap would in a fresh table
+        size_t buckets = items_to_buckets(n);
+        size_t mask = buckets - 1;
+        size_t offset = Archived::entries_offset(buckets);
+        r.buckets = buckets;
+        r.pos = w.reserve(offset + buckets * sizeof(Entry), alignof(Entry));
+        uint8_t* ctrl = w.at(r.pos);
+        std::memset(ctrl, EMPTY, buckets + detail::ARCHIVE_CTRL_TAIL);
+        Vec<size_t> slots = Vec<size_t>::with_capacity(n);
+        Hash hasher;
+        for (size_t i = 0; i < n; i++) {
+            size_t hash = hasher(*entries[i].first);
+            ProbeSeq seq(hash, mask);
+            BitMask free = Group::load(ctrl + seq.offset()).match_empty();
+            while (!free) {
+                seq.next();
+                free = Group::load(ctrl + seq.offset()).match_empty();
+            }
+            size_t slot = (seq.offset() + free.lowest()) & mask;
+            for (size_t mirror = slot; mirror < buckets + detail::ARCHIVE_CTRL_TAIL; mirror += buckets) {
+                ctrl[mirror] = h2_hash(hash);
+            }
+            slots.push(slot);
+        }
+
+        size_t base = r.pos + offset;
+        for (size_t i = 0; i < n; i++) {
+            size_t at = base + slots[i] * sizeof(Entry);
+            Archiver<K>::resolve(*entries[i].first, keys[i], at + offsetof(Entry, first), w);
+            Archiver<V>::resolve(*entries[i].second, values[i], at + offsetof(Entry, second), w);
+        }
+        return r;
+    }
+
+    static void resolve(const Map& map, const Resolver& r, size_t at, ArchiveWriter& w) {
+        Archived a;
+        a.ctrl_ = RelPtr<uint8_t>::between(at + offsetof(Archived, ctrl_), r.pos);
+        a.buckets_ = r.buckets;
+        a.len_ = map.len();
+        a.group_width_ = GROUP_SIZE;
+        w.put(at, a);
+    }
+
+    static bool verify(const Archived& a, const ArchiveBounds& b) {
+        if (a.buckets_ == 0) return a.len_ == 0;
+        uint64_t buckets = a.buckets_;
+        uint64_t width = a.group_width_;
+        if ((buckets & (buckets - 1)) != 0 || buckets > (uint64_t(1) << 48)) return false;
+        if ((width != 8 && width != 16 && width != 32) || buckets < width) return false;
+        size_t offset = Archived::entries_offset(size_t(buckets));
+        const uint8_t* ctrl = a.ctrl_.get();
+        if (!b.contains(ctrl, offset + size_t(buckets) * sizeof(Entry), alignof(Entry))) return false;
+
+        // Control bytes are EMPTY or tags, with at least one EMPTY to end
+        // every probe, and the tail mirrors the start
+        size_t full = 0;
+        for (size_t i = 0; i < buckets; i++) {
+            if (is_full(ctrl[i])) full++;
+            else if (ctrl[i] != EMPTY) return false;
+        }
+        if (full != a.len_ || full == buckets) return false;
+        for (size_t i = 0; i < detail::ARCHIVE_CTRL_TAIL; i++) {
+            if (ctrl[buckets + i] != ctrl[i & (buckets - 1)]) return false;
+        }
+        const Entry* entries = a.entries();
+        for (size_t i = 0; i < buckets; i++) {
+            if (!is_full(ctrl[i])) continue;
+            if (!Archiver<K>::verify(entries[i].first, b) || !Archiver<V>::verify(entries[i].second, b)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // @lifetime: owned
+    static Map deserialize(const Archived& a) {
+        Map out = Map::with_capacity(a.len());
+        a.iter().for_each([&out](const Entry& e) {
+            out.insert(Archiver<K>::deserialize(e.first), Archiver<V>::deserialize(e.second));
+        });
+        return out;
+    }
+};
+
+namespace detail {
+
+// Keys per node of ArchivedBTreeMap's index
+constexpr size_t ARCHIVE_BTREE_FANOUT = 16;
+
+// Index levels above n entries: level k holds the key of every
+// FANOUT^k-th entry, up to the first level of at most FANOUT keys
+inline size_t archive_btree_levels(size_t n, size_t* lens) {
+    size_t depth = 0;
+    lens[0] = n;
+    while (lens[depth] > ARCHIVE_BTREE_FANOUT) {
+        lens[depth + 1] = (lens[depth] + ARCHIVE_BTREE_FANOUT - 1) / ARCHIVE_BTREE_FANOUT;
+        depth++;
+    }
+    return depth;
+}
+
+// Enough for SIZE_MAX entries
+constexpr size_t ARCHIVE_BTREE_MAX_DEPTH = 17;
+
+} // namespace detail
+
+// Read-only sorted entries under a static B-tree index
+// The order is the natural order of the keys (bytes for strings), which is
+// BTreeMap's order for the default Compare.
+//
+// A binary search over n entries touches log2(n) cache lines and, in a
+// mapped file, as many pages. The index stores every 16th key, every
+// 256th and so on, top level first, each level as one array; a lookup
+// scans one node of 16 keys per level and then 16 entries, so it touches
+// log16(n) places, and the upper levels stay in cache.
+template<typename K, typename V>
+class ArchivedBTreeMap {
+public:
+    typedef rusty::Archived<K> ArchivedKey;
+    typedef rusty::Archived<V> ArchivedValue;
+    typedef ArchivedPair<ArchivedKey, ArchivedValue> Entry;
+    typedef typename Archiver<K>::View View;
+
+private:
+    template<typename, typename> friend struct Archiver;
+
+    ArchivedVec<Entry> entries_;
+    ArchivedVec<ArchivedKey> index_;  // Top level first
+    uint64_t depth_;
+
+    static bool key_less(const ArchivedKey& a, View key) {
+        return detail::archive_view_less(Archiver<K>::view(a), key);
+    }
+
+    // First entry whose key is not less than key
+    size_t lower_bound(View key) const {
+        const size_t F = detail::ARCHIVE_BTREE_FANOUT;
+        size_t lens[detail::ARCHIVE_BTREE_MAX_DEPTH];
+        size_t depth = detail::archive_btree_levels(entries_.len(), lens);
+
+        // Find the last separator below key within the node [lo, hi) on
+        // each level; the answer lies under it
+        const ArchivedKey* level = index_.as_ptr();
+        size_t lo = 0;
+        size_t hi = lens[depth];
+        for (size_t k = depth; k > 0; k--) {
+            size_t i = lo;
+            while (i + 1 < hi && key_less(level[i + 1], key)) i++;
+            level += lens[k];
+            lo = i * F;
+            hi = lo + F < lens[k - 1] ? lo + F : lens[k - 1];
+        }
+
+        const Entry* base = entries_.as_ptr();
+        size_t n = hi - lo;
+        while (n > 0) {
+            size_t half = n / 2;
+            if (key_less(base[lo + half].first, key)) {
+                lo += half + 1;
+                n -= half + 1;
+            } else {
+                n = half;
+            }
+        }
+        return lo;
+    }
+
+    const Entry* find(View key) const {
+        size_t i = lower_bound(key);
+        if (i == entries_.len()) return nullptr;
+        const Entry& e = entries_.as_ptr()[i];
+        return detail::archive_view_less(key, Archiver<K>::view(e.first)) ? nullptr : &e;
+    }
+
+public:
+    size_t len() const { return entries_.len(); }
+    bool is_empty() const { return entries_.is_empty(); }
+
+    // @lifetime: (&'a) -> &'a
+    Option<const ArchivedValue&> get(View key) const {
+        const Entry* e = find(key);
+        if (!e) return None;
+        return Option<const ArchivedValue&>(e->second);
+    }
+
+    bool contains_key(View key) const { return find(key) != nullptr; }
+
+    // Entries with lo <= key < hi
+    // @lifetime: (&'a) -> &'a
+    Slice<Entry> range(View lo, View hi) const {
+        size_t start = lower_bound(lo);
+        size_t end = lower_bound(hi);
+        if (end < start) end = start;
+        return Slice<Entry>(entries_.as_ptr() + start, end - start);
+    }
+
+    // @lifetime: (&'a) -> &'a
+    Option<const Entry&> first_key_value() const { return entries_.get(0); }
+
+    // @lifetime: (&'a) -> &'a
+    Option<const Entry&> last_key_value() const {
+        if (entries_.is_empty()) return None;
+        return entries_.get(entries_.len() - 1);
+    }
+
+    // All entries in key order
+    // @lifetime: (&'a) -> &'a
+    Slice<Entry> as_slice() const { return entries_.as_slice(); }
+
+    // @lifetime: (&'a) -> &'a
+    SliceIter<Entry> iter() const { return entries_.iter(); }
+};
+
+template<typename K, typename V, typename Compare, typename Alloc, size_t B>
+struct Archiver<BTreeMap<K, V, Compare, Alloc, B>> {
+    typedef BTreeMap<K, V, Compare, Alloc, B> Map;
+    typedef ArchivedBTreeMap<K, V> Archived;
+    typedef typename Archived::Entry Entry;
+    struct Resolver {
+        size_t pos;
+        size_t index_pos;
+        size_t index_len;
+        size_t depth;
+    };
+
+    static Resolver serialize(const Map& map, ArchiveWriter& w) {
+        size_t n = map.len();
+        Vec<std::pair<const K*, const V*>> entries = Vec<std::pair<const K*, const V*>>::with_capacity(n);
+        for (std::pair<const K&, const V&> kv : map) {
+            entries.push(std::make_pair(&kv.first, &kv.second));
+        }
+        Vec<typename Archiver<K>::Resolver> keys = Vec<typename Archiver<K>::Resolver>::with_capacity(n);
+        Vec<typename Archiver<V>::Resolver> values = Vec<typename Archiver<V>::Resolver>::with_capacity(n);
+        for (size_t i = 0; i < n; i++) {
+            keys.push(Archiver<K>::serialize(*entries[i].first, w));
+            values.push(Archiver<V>::serialize(*entries[i].second, w));
+        }
+        Resolver r;
+        r.pos = w.reserve(n * sizeof(Entry), alignof(Entry));
+        for (size_t i = 0; i < n; i++) {
+            size_t at = r.pos + i * sizeof(Entry);
+            Archiver<K>::resolve(*entries[i].first, keys[i], at + offsetof(Entry, first), w);
+            Archiver<V>::resolve(*entries[i].second, values[i], at + offsetof(Entry, second), w);
+        }
+
+        // Separator keys, top level first
+        size_t lens[detail::ARCHIVE_BTREE_MAX_DEPTH];
+        r.depth = detail::archive_btree_levels(n, lens);
+        Vec<const K*> separators;
+        for (size_t k = r.depth; k > 0; k--) {
+            size_t stride = 1;
+            for (size_t j = 0; j < k; j++) stride *= detail::ARCHIVE_BTREE_FANOUT;
+            for (size_t i = 0; i < lens[k]; i++) separators.push(entries[i * stride].first);
+        }
+        r.index_len = separators.len();
+        r.index_pos = detail::archive_array<K>(separators.len(), [&](size_t i) -> const K& { return *separators[i]; }, w);
+        return r;
+    }
+
+    static void resolve(const Map& map, const Resolver& r, size_t at, ArchiveWriter& w) {
+        Archived a;
+        a.entries_.ptr_ = RelPtr<Entry>::between(at + offsetof(Archived, entries_), r.pos);
+        a.entries_.len_ = map.len();
+        a.index_.ptr_ = RelPtr<typename Archived::ArchivedKey>::between(at + offsetof(Archived, index_), r.index_pos);
+        a.index_.len_ = r.index_len;
+        a.depth_ = r.depth;
+        w.put(at, a);
+    }
+
+    static bool verify(const Archived& a, const ArchiveBounds& b) {
+        if (a.entries_.len_ > SIZE_MAX) return false;
+        size_t lens[detail::ARCHIVE_BTREE_MAX_DEPTH];
+        size_t depth = detail::archive_btree_levels(size_t(a.entries_.len_), lens);
+        size_t index_len = 0;
+        for (size_t k = 1; k <= depth; k++) index_len += lens[k];
+        return a.depth_ == depth && a.index_.len_ == index_len &&
+               detail::verify_array<K>(a.index_.as_ptr(), index_len, b) &&
+               detail::verify_array<std::pair<K, V>>(a.entries_.as_ptr(), size_t(a.entries_.len_), b);
+    }
+
+    // @lifetime: owned
+    static Map deserialize(const Archived& a) {
+        Vec<std::pair<K, V>> entries = Vec<std::pair<K, V>>::with_capacity(a.len());
+        for (const Entry& e : a.as_slice()) {
+            entries.push(std::pair<K, V>(Archiver<K>::deserialize(e.first), Archiver<V>::deserialize(e.second)));
+        }
+        return Map::from_sorted_iter(std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+    }
+};
+
+namespace archive {
+
+constexpr uint32_t FORMAT_VERSION = 2;
+constexpr uint32_t FLAG_BIG_ENDIAN = 1;
+
+// The first bytes of every archive
+struct Header {
+    char magic[8];   // "RUSTYAR"
+    uint32_t version;
+    uint32_t flags;
+    uint64_t root;   // Position of the root's archived form
+    uint64_t size;   // Total archive bytes
+};
+
+namespace detail {
+
+inline uint32_t native_flags() {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return FLAG_BIG_ENDIAN;
+#else
+    return 0;
+#endif
+}
+
+inline ArchiveError error(const char* message) {
+    ArchiveError err = {message};
+    return err;
+}
+
+} // namespace detail
+
+// Archive value into a new byte buffer
+template<typename T>
+// @lifetime: owned
+Vec<uint8_t> to_bytes(const T& value) {
+    ArchiveWriter w;
+    w.reserve(sizeof(Header), alignof(Header));
+    typename Archiver<T>::Resolver r = Archiver<T>::serialize(value, w);
+    size_t root = w.reserve(sizeof(Archived<T>), alignof(Archived<T>));
+    Archiver<T>::resolve(value, r, root, w);
+
+    Header header;
+    std::memcpy(header.magic, "RUSTYAR", 8);
+    header.version = FORMAT_VERSION;
+    header.flags = detail::native_flags();
+    header.root = root;
+    header.size = w.pos();
+    w.put(0, header);
+    return w.finish();
+}
+
+// The root of an archive, without checking anything: bytes must come
+// from to_bytes (or have passed access() before)
+template<typename T>
+// @lifetime: (&'a) -> &'a
+const Archived<T>& access_unchecked(const uint8_t* bytes) {
+    Header header;
+    std::memcpy(&header, bytes, sizeof(Header));
+    return *reinterpret_cast<const Archived<T>*>(bytes + header.root);
+}
+
+namespace detail {
+
+// The header and root checks: O(1), before anything the root points to
+template<typename T>
+Result<const Archived<T>*, ArchiveError> archive_root(Slice<uint8_t> bytes) {
+    typedef Result<const Archived<T>*, ArchiveError> R;
+    if (bytes.len() < sizeof(Header)) return R::Err(detail::error("archive too short"));
+    if (reinterpret_cast<uintptr_t>(bytes.as_ptr()) % 16 != 0) return R::Err(detail::error("archive misaligned"));
+    Header header;
+    std::memcpy(&header, bytes.as_ptr(), sizeof(Header));
+    if (std::memcmp(header.magic, "RUSTYAR", 8) != 0) return R::Err(detail::error("not an archive"));
+    if (header.version != FORMAT_VERSION) return R::Err(detail::error("unsupported archive version"));
+    if (header.flags != detail::native_flags()) return R::Err(detail::error("archive byte order differs"));
+    if (header.size > bytes.len()) return R::Err(detail::error("archive truncated"));
+
+    ArchiveBounds bounds = {bytes.as_ptr(), bytes.as_ptr() + size_t(header.size)};
+    if (header.root > header.size) return R::Err(detail::error("archive root out of bounds"));
+    const Archived<T>* root = reinterpret_cast<const Archived<T>*>(bytes.as_ptr() + size_t(header.root));
+    if (!bounds.contains(root, sizeof(Archived<T>), alignof(Archived<T>))) {
+        return R::Err(detail::error("archive root out of bounds"));
+    }
+    return R::Ok(root);
+}
+
+} // namespace detail
+
+// The root of an archive, after checking every offset, length and table
+// in it. bytes must be 16-byte aligned (as malloc and mmap memory is).
+template<typename T>
+// @lifetime: (&'a) -> &'a
+Result<const Archived<T>*, ArchiveError> access(Slice<uint8_t> bytes) {
+    typedef Result<const Archived<T>*, ArchiveError> R;
+    R root = detail::archive_root<T>(bytes);
+    if (root.is_err()) return root;
+    const Archived<T>* r = root.unwrap();
+    Header header;
+    std::memcpy(&header, bytes.as_ptr(), sizeof(Header));
+    ArchiveBounds bounds = {bytes.as_ptr(), bytes.as_ptr() + size_t(header.size)};
+    if (!Archiver<T>::verify(*r, bounds)) return R::Err(detail::error("archive is corrupt"));
+    return R::Ok(r);
+}
+
+// Rebuild an ordinary T from its archived form
+template<typename T>
+// @lifetime: owned
+T deserialize(const Archived<T>& archived) {
+    return Archiver<T>::deserialize(archived);
+}
+
+// access() then deserialize()
+template<typename T>
+// @lifetime: owned
+Result<T, ArchiveError> from_bytes(Slice<uint8_t> bytes) {
+    Result<const Archived<T>*, ArchiveError> root = access<T>(bytes);
+    if (root.is_err()) return Result<T, ArchiveError>::Err(root.unwrap_err());
+    return Result<T, ArchiveError>::Ok(Archiver<T>::deserialize(*root.unwrap()));
+}
+
+// Archive value into the file at path, replacing it atomically (see
+// write_file_atomic)
+template<typename T>
+Result<void, IoError> write_file(const char* path, const T& value) {
+    Vec<uint8_t> bytes = to_bytes(value);
+    return write_file_atomic(path, bytes.as_slice());
+}
+
+// An archive file mapped into memory, for lookups straight from the page
+// cache. Processes mapping the same file share one copy of it.
+//
+//   archive::write_file("routes.bin", routes);               // once, offline
+//   auto routes = archive::MappedArchive<HashMap<String, uint32_t>>::open_unchecked("routes.bin");
+//   uint32_t port = routes.unwrap()->get("api").unwrap();
+//
+// open() checks the whole archive as access() does, which reads every
+// page once. open_unchecked() only checks the header, the file size and
+// the root, so it is O(1) whatever the size; use it for files this
+// system wrote (a corrupt file can then crash the reader).
+template<typename T>
+class MappedArchive {
+private:
+    MappedFile file_;
+    const Archived<T>* root_;
+
+    MappedArchive(MappedFile file, const Archived<T>* root) : file_(std::move(file)), root_(root) {}
+
+    static Result<MappedArchive, ArchiveError> map(const char* path, bool check) {
+        Result<MappedFile, IoError> file = MappedFile::open(path);
+        if (file.is_err()) return Result<MappedArchive, ArchiveError>::Err(detail::error("cannot open archive file"));
+        return from_file(file.unwrap(), check);
+    }
+
+public:
+    MappedArchive(MappedArchive&& other) noexcept : file_(std::move(other.file_)), root_(other.root_) {
+        other.root_ = nullptr;
+    }
+
+    MappedArchive& operator=(MappedArchive&& other) noexcept {
+        file_ = std::move(other.file_);
+        root_ = other.root_;
+        other.root_ = nullptr;
+        return *this;
+    }
+
+    // @lifetime: owned
+    static Result<MappedArchive, ArchiveError> open(const char* path) { return map(path, true); }
+
+    // @lifetime: owned
+    static Result<MappedArchive, ArchiveError> open_unchecked(const char* path) { return map(path, false); }
+
+    // Take over a file mapped by the caller (which sees the IoError on
+    // failure to open)
+    // @lifetime: owned
+    static Result<MappedArchive, ArchiveError> from_file(MappedFile file, bool check) {
+        typedef Result<MappedArchive, ArchiveError> R;
+        if (check) file.advise(MappedFile::Advice::Sequential);
+        Result<const Archived<T>*, ArchiveError> root =
+            check ? access<T>(file.as_slice()) : detail::archive_root<T>(file.as_slice());
+        if (root.is_err()) return R::Err(root.unwrap_err());
+        file.advise(MappedFile::Advice::Random);  // Lookups jump around
+        return R::Ok(MappedArchive(std::move(file), root.unwrap()));
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const Archived<T>& get() const { return *root_; }
+    // @lifetime: (&'a) -> &'a
+    const Archived<T>& operator*() const { return *root_; }
+    // @lifetime: (&'a) -> &'a
+    const Archived<T>* operator->() const { return root_; }
+
+    // @lifetime: (&'a) -> &'a
+    const MappedFile& file() const { return file_; }
+};
+
+} // namespace archive
+
+} // namespace rusty
+
+#endif // RUSTY_ARCHIVE_HPP
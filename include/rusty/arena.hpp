@@ -0,0 +1,336 @@
+#ifndef RUSTY_ARENA_HPP
+#define RUSTY_ARENA_HPP
+
+#include <cassert>
+#include <cstddef>  // for size_t
+#include <cstdint>  // for uintptr_t
+#include <cstring>  // for memcpy
+#include <new>
+#include <utility>  // for std::move, std::forward
+#include "alloc.hpp"
+#include "relocate.hpp"
+
+// Arena - A bump allocator that frees everything at once
+// Equivalent to Rust's bumpalo::Bump
+//
+// Guarantees:
+// - O(1) allocation by bumping a pointer inside the current chunk
+// - No per-object frees: all memory is released when the Arena is dropped
+//   (or recycled by reset())
+// - Everything allocated from an Arena borrows it: references and ArenaBox
+//   handles carry the Arena's lifetime, so the checker rejects any that
+//   outlive it
+//
+// Values created with alloc() are never destroyed (like bumpalo); use
+// alloc_box() when T has a destructor that must run.
+
+// @safe
+namespace rusty {
+
+template<typename T>
+class ArenaBox;
+
+class Arena {
+private:
+    // Chunks form a singly linked list, newest first; data follows the header
+    struct Chunk {
+        Chunk* prev;
+        size_t size;  // Usable bytes after the header
+
+        char* data() { return reinterpret_cast<char*>(this + 1); }
+    };
+
+    Chunk* head_;
+    char* ptr_;            // Next free byte in head_
+    char* end_;            // End of head_
+    size_t next_chunk_size_;
+    size_t allocated_;     // Bytes handed out since creation or last reset
+
+    static char* align_up(char* p, size_t align) {
+        uintptr_t addr = reinterpret_cast<uintptr_t>(p);
+        return reinterpret_cast<char*>((addr + align - 1) & ~(uintptr_t(align) - 1));
+    }
+
+    // Start a new chunk big enough for size bytes at the given alignment
+    void add_chunk(size_t size, size_t align) {
+        size_t needed = size + align;
+        size_t chunk_size = next_chunk_size_;
+        while (chunk_size < needed) {
+            chunk_size *= 2;
+        }
+
+        Chunk* chunk = static_cast<Chunk*>(
+            alloc_or_throw(backing_, sizeof(Chunk) + chunk_size, alignof(Chunk)));
+        chunk->prev = head_;
+        chunk->size = chunk_size;
+
+        head_ = chunk;
+        ptr_ = chunk->data();
+        end_ = ptr_ + chunk_size;
+        next_chunk_size_ = chunk_size * 2;
+    }
+
+    void free_chunks(Chunk* chunk) {
+        while (chunk) {
+            Chunk* prev = chunk->prev;
+            backing_.deallocate(chunk, sizeof(Chunk) + chunk->size, alignof(Chunk));
+            chunk = prev;
+        }
+    }
+
+    Global backing_;
+
+public:
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 4096;
+
+    // Constructors
+    Arena() : Arena(DEFAULT_CHUNK_SIZE) {}
+
+    explicit Arena(size_t chunk_size)
+        : head_(nullptr), ptr_(nullptr), end_(nullptr),
+          next_chunk_size_(chunk_size > 0 ? chunk_size : size_t(DEFAULT_CHUNK_SIZE)),
+          allocated_(0) {}
+
+    // @lifetime: owned
+    static Arena new_() {
+        return Arena();
+    }
+
+    // Pre-allocate the first chunk
+    // @lifetime: owned
+    static Arena with_capacity(size_t bytes) {
+        Arena arena(bytes);
+        arena.add_chunk(bytes, 1);
+        return arena;
+    }
+
+    // No copy - an Arena owns its chunks
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Move - chunks stay where they are, so nothing allocated is invalidated
+    Arena(Arena&& other) noexcept
+        : head_(other.head_), ptr_(other.ptr_), end_(other.end_),
+          next_chunk_size_(other.next_chunk_size_), allocated_(other.allocated_) {
+        other.head_ = nullptr;
+        other.ptr_ = other.end_ = nullptr;
+        other.allocated_ = 0;
+    }
+
+    Arena& operator=(Arena&& other) noexcept {
+        if (this != &other) {
+            free_chunks(head_);
+            head_ = other.head_;
+            ptr_ = other.ptr_;
+            end_ = other.end_;
+            next_chunk_size_ = other.next_chunk_size_;
+            allocated_ = other.allocated_;
+
+            other.head_ = nullptr;
+            other.ptr_ = other.end_ = nullptr;
+            other.allocated_ = 0;
+        }
+        return *this;
+    }
+
+    // Destructor - drops every chunk at once
+    ~Arena() {
+        free_chunks(head_);
+    }
+
+    // Allocate uninitialized bytes (align must be a power of two)
+    // @unsafe
+    // @lifetime: (&'a) -> &'a
+    void* alloc_raw(size_t size, size_t align) {
+        assert(align > 0 && (align & (align - 1)) == 0);
+        char* p = ptr_ ? align_up(ptr_, align) : nullptr;
+        if (!p || p + size > end_) {
+            add_chunk(size, align);
+            p = align_up(ptr_, align);
+        }
+        ptr_ = p + size;
+        allocated_ += size;
+        return p;
+    }
+
+    // Try to grow the most recent allocation in place
+    // Returns false if ptr is not the last allocation or the chunk is full
+    bool grow_in_place(void* ptr, size_t old_size, size_t new_size) {
+        char* p = static_cast<char*>(ptr);
+        if (p + old_size != ptr_ || p + new_size > end_) {
+            return false;
+        }
+        ptr_ = p + new_size;
+        allocated_ += new_size - old_size;
+        return true;
+    }
+
+    // Construct a value in the arena. It is never destroyed.
+    template<typename T, typename... Args>
+    // @lifetime: (&'a) -> &'a mut
+    T& alloc(Args&&... args) {
+        void* mem = alloc_raw(sizeof(T), alignof(T));
+        return *new (mem) T(std::forward<Args>(args)...);
+    }
+
+    // Allocate an uninitialized array of n values
+    template<typename T>
+    // @unsafe
+    // @lifetime: (&'a) -> &'a
+    T* alloc_array(size_t n) {
+        return static_cast<T*>(alloc_raw(n * sizeof(T), alignof(T)));
+    }
+
+    // Construct a value in the arena owned by an ArenaBox, which runs the
+    // destructor when dropped (the memory itself stays in the arena)
+    template<typename T, typename... Args>
+    // @lifetime: (&'a) -> &'a
+    ArenaBox<T> alloc_box(Args&&... args);
+
+    // Recycle the arena: keep the largest chunk, free the rest.
+    // Invalidates everything allocated so far, so it needs exclusive access.
+    void reset() {
+        if (!head_) return;
+        free_chunks(head_->prev);
+        head_->prev = nullptr;
+        ptr_ = head_->data();
+        end_ = ptr_ + head_->size;
+        allocated_ = 0;
+    }
+
+    // Bytes handed out since creation or the last reset
+    size_t allocated_bytes() const { return allocated_; }
+
+    // Total bytes reserved in chunks
+    size_t chunk_capacity() const {
+        size_t total = 0;
+        for (Chunk* c = head_; c; c = c->prev) {
+            total += c->size;
+        }
+        return total;
+    }
+};
+
+// ArenaBox<T> - Owning handle to a value stored in an Arena
+// Equivalent to bumpalo::boxed::Box<'a, T>
+//
+// Same move-only semantics as Box<T>, but dropping it only runs T's
+// destructor; the memory is reclaimed with the Arena.
+template<typename T>
+class ArenaBox {
+private:
+    T* ptr;
+
+public:
+    ArenaBox() : ptr(nullptr) {}
+
+    // @unsafe
+    explicit ArenaBox(T* p) : ptr(p) {}
+
+    // No copy constructor - ArenaBox cannot be copied
+    ArenaBox(const ArenaBox&) = delete;
+    ArenaBox& operator=(const ArenaBox&) = delete;
+
+    // Move constructor - transfers ownership
+    ArenaBox(ArenaBox&& other) noexcept : ptr(other.ptr) {
+        other.ptr = nullptr;
+    }
+
+    // Move assignment - transfers ownership
+    ArenaBox& operator=(ArenaBox&& other) noexcept {
+        if (this != &other) {
+            if (ptr) ptr->~T();
+            ptr = other.ptr;
+            other.ptr = nullptr;
+        }
+        return *this;
+    }
+
+    // Destructor - drops the value, not the memory
+    ~ArenaBox() {
+        if (ptr) ptr->~T();
+    }
+
+    // Dereference - borrow the value
+    // @lifetime: (&'a) -> &'a
+    T& operator*() {
+        return *ptr;
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const T& operator*() const {
+        return *ptr;
+    }
+
+    // Arrow operator - access members
+    // @lifetime: (&'a) -> &'a
+    T* operator->() {
+        return ptr;
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const T* operator->() const {
+        return ptr;
+    }
+
+    // Check if box contains a value
+    bool is_valid() const {
+        return ptr != nullptr;
+    }
+
+    explicit operator bool() const {
+        return is_valid();
+    }
+
+    // Give up ownership without running the destructor (Rust: Box::leak)
+    // @lifetime: (&'a mut) -> &'a mut
+    T& leak() {
+        T* temp = ptr;
+        ptr = nullptr;
+        return *temp;
+    }
+};
+
+template<typename T, typename... Args>
+ArenaBox<T> Arena::alloc_box(Args&&... args) {
+    return ArenaBox<T>(&alloc<T>(std::forward<Args>(args)...));
+}
+
+template<typename T>
+struct is_trivially_relocatable<ArenaBox<T>> : std::true_type {};
+
+// ArenaAlloc - Allocator handle (see alloc.hpp) that places container
+// storage in an Arena. deallocate is a no-op; the Arena frees everything.
+// Containers using it must not outlive the Arena, and the Arena must not
+// be moved while handles point at it.
+struct ArenaAlloc {
+    Arena* arena;
+
+    ArenaAlloc() : arena(nullptr) {}
+    explicit ArenaAlloc(Arena& a) : arena(&a) {}
+
+    void* allocate(size_t size, size_t align) {
+        return arena->alloc_raw(size, align);
+    }
+
+    void deallocate(void*, size_t, size_t) {}
+
+    // Growing the most recent allocation (the common Vec/String case) is O(1)
+    void* reallocate(void* ptr, size_t old_size, size_t new_size, size_t align) {
+        if (ptr && arena->grow_in_place(ptr, old_size, new_size)) {
+            return ptr;
+        }
+        void* new_ptr = arena->alloc_raw(new_size, align);
+        if (ptr) {
+            std::memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+        }
+        return new_ptr;
+    }
+
+    bool operator==(const ArenaAlloc& other) const { return arena == other.arena; }
+    bool operator!=(const ArenaAlloc& other) const { return arena != other.arena; }
+};
+
+} // namespace rusty
+
+#endif // RUSTY_ARENA_HPP
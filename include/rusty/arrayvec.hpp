@@ -0,0 +1,491 @@
+#ifndef RUSTY_ARRAYVEC_HPP
+#define RUSTY_ARRAYVEC_HPP
+
+#include <cstddef>  // for size_t
+#include <initializer_list>
+#include <new>
+#include <stdexcept>
+#include <string>   // for std::char_traits
+#include <type_traits>
+#include <utility>  // for std::move
+#include "bounds.hpp"
+#include "marker.hpp"
+#include "niche.hpp"
+#include "result.hpp"
+#include "slice.hpp"
+#if __cplusplus >= 201703L
+#include "string.hpp"
+#endif
+
+// ArrayVec<T, N> / ArrayString<N> - Fixed-capacity Vec and String stored
+// inline, never on the heap (Rust: the arrayvec crate)
+//
+// Guarantees:
+// - No allocation ever: the N slots are part of the object
+// - Going past N is an error, never a reallocation: push and push_str
+//   throw std::length_error, try_push and try_push_str return
+//   Err(CapacityError) and leave the contents unchanged
+// - ArrayVec has Vec's ownership rules: move-only, explicit clone();
+//   ArrayString holds bytes only and copies like a value
+// - From C++20 on both are constexpr (ArrayVec for trivial element types),
+//   so tables and parsed configs can be built at compile time:
+//     constexpr auto primes = [] {
+//         rusty::ArrayVec<int, 8> v;
+//         for (int n = 2; !v.is_full(); n++) if (is_prime(n)) v.push(n);
+//         return v;
+//     }();
+// - ArrayString needs C++17 (it reads and writes str)
+
+// @safe
+namespace rusty {
+
+// The fixed capacity was exceeded
+struct CapacityError {
+    bool operator==(const CapacityError&) const { return true; }
+};
+
+namespace detail {
+
+// True while a constant expression is being evaluated (C++20 on)
+constexpr bool in_constant_evaluation() {
+#if __cplusplus >= 202002L
+    return std::is_constant_evaluated();
+#else
+    return false;
+#endif
+}
+
+// ArrayVec's slots. Trivial elements live in a plain array that C++20
+// constant expressions can write; it is only filled during constant
+// evaluation, which needs every byte of a constexpr object initialized.
+template<typename T, size_t N, bool Trivial = std::is_trivial<T>::value>
+struct ArrayVecSlots {
+    T items[N];
+
+    RUSTY_CONSTEXPR20 ArrayVecSlots() {
+        if (in_constant_evaluation()) {
+            for (size_t i = 0; i < N; i++) items[i] = T();
+        }
+    }
+
+    RUSTY_CONSTEXPR20 T* data() { return items; }
+    RUSTY_CONSTEXPR20 const T* data() const { return items; }
+
+    template<typename... Args>
+    RUSTY_CONSTEXPR20 void construct(size_t i, Args&&... args) {
+        items[i] = T(std::forward<Args>(args)...);
+    }
+
+    RUSTY_CONSTEXPR20 void destroy(size_t) {}
+};
+
+// Other elements: raw storage, constructed slot by slot
+template<typename T, size_t N>
+struct ArrayVecSlots<T, N, false> {
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type items[N];
+
+    T* data() { return reinterpret_cast<T*>(items); }
+    const T* data() const { return reinterpret_cast<const T*>(items); }
+
+    template<typename... Args>
+    void construct(size_t i, Args&&... args) {
+        new (&items[i]) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(size_t i) { data()[i].~T(); }
+};
+
+} // namespace detail
+
+template<typename T, size_t N>
+class ArrayVec {
+    static_assert(N > 0, "ArrayVec needs at least one slot");
+
+private:
+    detail::ArrayVecSlots<T, N> slots_;
+    size_t size_;
+
+    // Take other's elements; this must be empty
+    RUSTY_CONSTEXPR20 void take_from(ArrayVec& other) {
+        for (size_t i = 0; i < other.size_; ++i) {
+            slots_.construct(i, std::move(other.slots_.data()[i]));
+        }
+        size_ = other.size_;
+        other.clear();
+    }
+
+public:
+    static constexpr size_t CAPACITY = N;
+
+    RUSTY_CONSTEXPR20 ArrayVec() : size_(0) {}
+
+    // @lifetime: owned
+    static RUSTY_CONSTEXPR20 ArrayVec new_() {
+        return ArrayVec();
+    }
+
+    // Throws std::length_error when init has more than N elements
+    RUSTY_CONSTEXPR20 ArrayVec(std::initializer_list<T> init) : size_(0) {
+        extend_from_slice(init.begin(), init.size());
+    }
+
+    // No copy constructor - ArrayVec cannot be copied
+    ArrayVec(const ArrayVec&) = delete;
+    ArrayVec& operator=(const ArrayVec&) = delete;
+
+    // Move constructor: moves the elements, leaving other empty
+    RUSTY_CONSTEXPR20 ArrayVec(ArrayVec&& other) noexcept : size_(0) {
+        take_from(other);
+    }
+
+    RUSTY_CONSTEXPR20 ArrayVec& operator=(ArrayVec&& other) noexcept {
+        if (this != &other) {
+            clear();
+            take_from(other);
+        }
+        return *this;
+    }
+
+    RUSTY_CONSTEXPR20 ~ArrayVec() {
+        clear();
+    }
+
+    // Push element to the back; throws std::length_error when full
+    RUSTY_CONSTEXPR20 void push(T value) {
+        if (size_ == N) {
+            throw std::length_error("ArrayVec is full");
+        }
+        slots_.construct(size_, std::move(value));
+        ++size_;
+    }
+
+    RUSTY_CONSTEXPR20 Result<void, CapacityError> try_push(T value) {
+        if (size_ == N) {
+            return Result<void, CapacityError>::Err(CapacityError());
+        }
+        slots_.construct(size_, std::move(value));
+        ++size_;
+        return Result<void, CapacityError>::Ok();
+    }
+
+    // Pop element from the back
+    RUSTY_CONSTEXPR20 T pop() {
+        RUSTY_BOUNDS_CHECK(size_ > 0, "pop from empty ArrayVec");
+        --size_;
+        T result = std::move(slots_.data()[size_]);
+        slots_.destroy(size_);
+        return result;
+    }
+
+    // Copies of n elements at the back; throws std::length_error, adding
+    // nothing, when they do not fit
+    RUSTY_CONSTEXPR20 void extend_from_slice(const T* src, size_t n) {
+        if (n > N - size_) {
+            throw std::length_error("ArrayVec is full");
+        }
+        for (size_t i = 0; i < n; ++i) {
+            slots_.construct(size_, src[i]);
+            ++size_;
+        }
+    }
+
+    RUSTY_CONSTEXPR20 Result<void, CapacityError> try_extend_from_slice(const T* src, size_t n) {
+        if (n > N - size_) {
+            return Result<void, CapacityError>::Err(CapacityError());
+        }
+        extend_from_slice(src, n);
+        return Result<void, CapacityError>::Ok();
+    }
+
+    // Insert at index, shifting the tail right; throws when full
+    RUSTY_CONSTEXPR20 void insert(size_t index, T value) {
+        RUSTY_BOUNDS_CHECK(index <= size_, "ArrayVec insert index out of bounds");
+        if (size_ == N) {
+            throw std::length_error("ArrayVec is full");
+        }
+        T* data = slots_.data();
+        if (index == size_) {
+            slots_.construct(size_, std::move(value));
+        } else {
+            slots_.construct(size_, std::move(data[size_ - 1]));
+            for (size_t i = size_ - 1; i > index; --i) {
+                data[i] = std::move(data[i - 1]);
+            }
+            data[index] = std::move(value);
+        }
+        ++size_;
+    }
+
+    // Remove and return the element at index, shifting the tail left
+    // @lifetime: owned
+    RUSTY_CONSTEXPR20 T remove(size_t index) {
+        RUSTY_BOUNDS_CHECK(index < size_, "ArrayVec remove index out of bounds");
+        T* data = slots_.data();
+        T result = std::move(data[index]);
+        for (size_t i = index; i + 1 < size_; ++i) {
+            data[i] = std::move(data[i + 1]);
+        }
+        --size_;
+        slots_.destroy(size_);
+        return result;
+    }
+
+    // Remove the element at index, moving the last one into its place
+    // @lifetime: owned
+    RUSTY_CONSTEXPR20 T swap_remove(size_t index) {
+        RUSTY_BOUNDS_CHECK(index < size_, "ArrayVec swap_remove index out of bounds");
+        T* data = slots_.data();
+        T result = std::move(data[index]);
+        if (index + 1 != size_) {
+            data[index] = std::move(data[size_ - 1]);
+        }
+        --size_;
+        slots_.destroy(size_);
+        return result;
+    }
+
+    // Access element by index
+    // @lifetime: (&'a) -> &'a
+    RUSTY_CONSTEXPR20 T& operator[](size_t index) {
+        RUSTY_BOUNDS_CHECK(index < size_, "ArrayVec index out of bounds");
+        return slots_.data()[index];
+    }
+
+    // @lifetime: (&'a) -> &'a
+    RUSTY_CONSTEXPR20 const T& operator[](size_t index) const {
+        RUSTY_BOUNDS_CHECK(index < size_, "ArrayVec index out of bounds");
+        return slots_.data()[index];
+    }
+
+    // Access element by index without a bounds check, in any build
+    // @unsafe
+    // @lifetime: (&'a) -> &'a
+    RUSTY_CONSTEXPR20 const T& get_unchecked(size_t index) const { return slots_.data()[index]; }
+
+    // @unsafe
+    // @lifetime: (&'a mut) -> &'a mut
+    RUSTY_CONSTEXPR20 T& get_unchecked_mut(size_t index) { return slots_.data()[index]; }
+
+    // @lifetime: (&'a) -> &'a
+    RUSTY_CONSTEXPR20 T& front() {
+        RUSTY_BOUNDS_CHECK(size_ > 0, "front of empty ArrayVec");
+        return slots_.data()[0];
+    }
+
+    // @lifetime: (&'a) -> &'a
+    RUSTY_CONSTEXPR20 const T& front() const {
+        RUSTY_BOUNDS_CHECK(size_ > 0, "front of empty ArrayVec");
+        return slots_.data()[0];
+    }
+
+    // @lifetime: (&'a) -> &'a
+    RUSTY_CONSTEXPR20 T& back() {
+        RUSTY_BOUNDS_CHECK(size_ > 0, "back of empty ArrayVec");
+        return slots_.data()[size_ - 1];
+    }
+
+    // @lifetime: (&'a) -> &'a
+    RUSTY_CONSTEXPR20 const T& back() const {
+        RUSTY_BOUNDS_CHECK(size_ > 0, "back of empty ArrayVec");
+        return slots_.data()[size_ - 1];
+    }
+
+    RUSTY_CONSTEXPR20 size_t len() const { return size_; }
+    RUSTY_CONSTEXPR20 size_t size() const { return size_; }
+
+    RUSTY_CONSTEXPR20 bool is_empty() const { return size_ == 0; }
+    RUSTY_CONSTEXPR20 bool is_full() const { return size_ == N; }
+
+    static constexpr size_t capacity() { return N; }
+    RUSTY_CONSTEXPR20 size_t remaining_capacity() const { return N - size_; }
+
+    // Keep the first len elements
+    RUSTY_CONSTEXPR20 void truncate(size_t len) {
+        while (size_ > len) {
+            --size_;
+            slots_.destroy(size_);
+        }
+    }
+
+    RUSTY_CONSTEXPR20 void clear() {
+        truncate(0);
+    }
+
+    // Borrow the elements as a slice
+    // @lifetime: (&'a) -> &'a
+    Slice<T> as_slice() const { return Slice<T>(slots_.data(), size_); }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    SliceMut<T> as_mut_slice() { return SliceMut<T>(slots_.data(), size_); }
+
+    // Iterator support
+    // @lifetime: (&'a) -> &'a
+    RUSTY_CONSTEXPR20 T* begin() { return slots_.data(); }
+    RUSTY_CONSTEXPR20 const T* begin() const { return slots_.data(); }
+
+    // @lifetime: (&'a) -> &'a
+    RUSTY_CONSTEXPR20 T* end() { return slots_.data() + size_; }
+    RUSTY_CONSTEXPR20 const T* end() const { return slots_.data() + size_; }
+
+    // Clone the ArrayVec (explicit deep copy)
+    // @lifetime: owned
+    RUSTY_CONSTEXPR20 ArrayVec clone() const {
+        ArrayVec result;
+        result.extend_from_slice(slots_.data(), size_);  // Requires T to be copyable
+        return result;
+    }
+
+    RUSTY_CONSTEXPR20 bool operator==(const ArrayVec& other) const {
+        if (size_ != other.size_) return false;
+        for (size_t i = 0; i < size_; ++i) {
+            if (!(slots_.data()[i] == other.slots_.data()[i])) return false;
+        }
+        return true;
+    }
+
+    RUSTY_CONSTEXPR20 bool operator!=(const ArrayVec& other) const {
+        return !(*this == other);
+    }
+};
+
+template<typename T, size_t N>
+constexpr size_t ArrayVec<T, N>::CAPACITY;
+
+template<typename T, size_t N>
+struct is_send<ArrayVec<T, N>> : is_send<T> {};
+
+template<typename T, size_t N>
+struct is_sync<ArrayVec<T, N>> : is_sync<T> {};
+
+#if __cplusplus >= 201703L
+
+// ArrayString<N> - Up to N bytes of text inline, always NUL-terminated
+template<size_t N>
+class ArrayString {
+private:
+    char bytes_[N + 1];
+    size_t len_;
+
+public:
+    static constexpr size_t CAPACITY = N;
+
+    RUSTY_CONSTEXPR20 ArrayString() : len_(0) {
+        if (detail::in_constant_evaluation()) {
+            for (size_t i = 0; i <= N; i++) bytes_[i] = '\0';
+        }
+        bytes_[0] = '\0';
+    }
+
+    // @lifetime: owned
+    static RUSTY_CONSTEXPR20 ArrayString new_() {
+        return ArrayString();
+    }
+
+    // Err(CapacityError) when s is longer than N bytes
+    // @lifetime: owned
+    static RUSTY_CONSTEXPR20 Result<ArrayString, CapacityError> from(str s) {
+        ArrayString out;
+        if (out.try_push_str(s).is_err()) {
+            return Result<ArrayString, CapacityError>::Err(CapacityError());
+        }
+        return Result<ArrayString, CapacityError>::Ok(out);
+    }
+
+    // @lifetime: owned
+    RUSTY_CONSTEXPR20 ArrayString clone() const { return *this; }
+
+    RUSTY_CONSTEXPR20 size_t len() const { return len_; }
+    RUSTY_CONSTEXPR20 bool is_empty() const { return len_ == 0; }
+    RUSTY_CONSTEXPR20 bool is_full() const { return len_ == N; }
+
+    static constexpr size_t capacity() { return N; }
+    RUSTY_CONSTEXPR20 size_t remaining_capacity() const { return N - len_; }
+
+    // Append bytes; throws std::length_error, appending nothing, when they
+    // do not fit
+    RUSTY_CONSTEXPR20 void push_str(str s) {
+        if (s.len() > N - len_) {
+            throw std::length_error("ArrayString is full");
+        }
+        std::char_traits<char>::copy(bytes_ + len_, s.as_ptr(), s.len());
+        len_ += s.len();
+        bytes_[len_] = '\0';
+    }
+
+    RUSTY_CONSTEXPR20 Result<void, CapacityError> try_push_str(str s) {
+        if (s.len() > N - len_) {
+            return Result<void, CapacityError>::Err(CapacityError());
+        }
+        push_str(s);
+        return Result<void, CapacityError>::Ok();
+    }
+
+    RUSTY_CONSTEXPR20 void push(char ch) {
+        push_str(str(&ch, 1));
+    }
+
+    RUSTY_CONSTEXPR20 Result<void, CapacityError> try_push(char ch) {
+        return try_push_str(str(&ch, 1));
+    }
+
+    // Remove and return the last byte
+    RUSTY_CONSTEXPR20 char pop() {
+        RUSTY_BOUNDS_CHECK(len_ > 0, "pop from empty ArrayString");
+        char ch = bytes_[--len_];
+        bytes_[len_] = '\0';
+        return ch;
+    }
+
+    RUSTY_CONSTEXPR20 void truncate(size_t new_len) {
+        if (new_len < len_) {
+            len_ = new_len;
+            bytes_[len_] = '\0';
+        }
+    }
+
+    RUSTY_CONSTEXPR20 void clear() { truncate(0); }
+
+    // @lifetime: (&'a) -> &'a
+    constexpr str as_str() const { return str(bytes_, len_); }
+    // @lifetime: (&'a) -> &'a
+    constexpr operator str() const { return as_str(); }
+
+    // @lifetime: (&'a) -> &'a
+    constexpr const char* c_str() const { return bytes_; }
+
+    // @lifetime: (&'a) -> &'a
+    RUSTY_CONSTEXPR20 const char& operator[](size_t idx) const {
+        RUSTY_BOUNDS_CHECK(idx < len_, "index out of bounds");
+        return bytes_[idx];
+    }
+
+    // @lifetime: (&'a) -> &'a
+    constexpr const char* begin() const { return bytes_; }
+    // @lifetime: (&'a) -> &'a
+    constexpr const char* end() const { return bytes_ + len_; }
+
+    // @lifetime: owned
+    String to_string() const { return as_str().to_string(); }
+
+    constexpr bool operator==(str other) const { return as_str() == other; }
+    constexpr bool operator!=(str other) const { return !(as_str() == other); }
+
+    template<size_t M>
+    constexpr bool operator==(const ArrayString<M>& other) const {
+        return as_str() == other.as_str();
+    }
+
+    template<size_t M>
+    constexpr bool operator!=(const ArrayString<M>& other) const {
+        return !(*this == other);
+    }
+};
+
+template<size_t N>
+constexpr size_t ArrayString<N>::CAPACITY;
+
+#endif // __cplusplus >= 201703L
+
+} // namespace rusty
+
+#endif // RUSTY_ARRAYVEC_HPP
@@ -0,0 +1,537 @@
+#ifndef RUSTY_BINARYHEAP_HPP
+#define RUSTY_BINARYHEAP_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include "alloc.hpp"
+#include "fwd.hpp"
+#include "iter.hpp"
+#include "option.hpp"
+#include "slice.hpp"
+#include "vec.hpp"
+
+// BinaryHeap<T> - A priority queue in a Vec
+// Equivalent to Rust's BinaryHeap<T>
+//
+// Guarantees:
+// - pop/peek give the greatest element under Compare, so the default
+//   std::less<T> is a max-heap (as Rust and std::priority_queue);
+//   std::greater<T> makes a min-heap
+// - push and pop are O(log n); from_vec heapifies in O(n)
+// - Sifts move a hole instead of swapping, so each level costs one move
+//
+// D is the arity of the tree. The default binary layout is best for small
+// heaps; D = 4 halves the depth and keeps each node's children on one or
+// two cache lines, which usually wins once the heap outgrows L1.
+//
+// IndexedBinaryHeap<P> is the addressable variant for schedulers and
+// shortest-path searches: entries are keyed by a small integer id, so an
+// entry's priority can be looked up, changed (decrease_key) or removed in
+// O(log n) without searching the heap.
+
+// @safe
+namespace rusty {
+
+namespace detail {
+
+// Shared sift routines over a contiguous array. Move is called after every
+// element move with the element's new position, which lets the indexed
+// heap keep its id -> position table current.
+template<size_t D>
+struct HeapOps {
+    static_assert(D >= 2, "heap arity must be at least 2");
+
+    static size_t parent(size_t pos) { return (pos - 1) / D; }
+    static size_t first_child(size_t pos) { return D * pos + 1; }
+
+    // Index of the greatest of the children starting at child, below end
+    template<typename T, typename Less>
+    static size_t best_child(const T* data, size_t child, size_t end, Less& less) {
+        size_t last = end - child > D ? child + D : end;
+        size_t best = child;
+        for (size_t c = child + 1; c < last; c++) {
+            if (less(data[best], data[c])) best = c;
+        }
+        return best;
+    }
+
+    // Move data[pos] up while it is greater than its parent, stopping at
+    // start. Returns its final position.
+    template<typename T, typename Less, typename Moved>
+    static size_t sift_up(T* data, size_t start, size_t pos, Less& less, Moved& moved) {
+        T elem = std::move(data[pos]);
+        while (pos > start) {
+            size_t p = parent(pos);
+            if (!less(data[p], elem)) break;
+            data[pos] = std::move(data[p]);
+            moved(pos);
+            pos = p;
+        }
+        data[pos] = std::move(elem);
+        moved(pos);
+        return pos;
+    }
+
+    // Move data[pos] down while a child in [0, end) is greater than it
+    template<typename T, typename Less, typename Moved>
+    static void sift_down_range(T* data, size_t pos, size_t end, Less& less, Moved& moved) {
+        T elem = std::move(data[pos]);
+        size_t child = first_child(pos);
+        while (child < end) {
+            size_t best = best_child(data, child, end, less);
+            if (!less(elem, data[best])) break;
+            data[pos] = std::move(data[best]);
+            moved(pos);
+            pos = best;
+            child = first_child(pos);
+        }
+        data[pos] = std::move(elem);
+        moved(pos);
+    }
+
+    // Sift data[pos] all the way to a leaf, then back up. An element placed
+    // at the root by pop usually belongs near the bottom, so this saves the
+    // comparison against the element at every level (as Rust's
+    // sift_down_to_bottom does).
+    template<typename T, typename Less, typename Moved>
+    static void sift_down_to_bottom(T* data, size_t pos, size_t end, Less& less, Moved& moved) {
+        size_t start = pos;
+        T elem = std::move(data[pos]);
+        size_t child = first_child(pos);
+        while (child < end) {
+            size_t best = best_child(data, child, end, less);
+            data[pos] = std::move(data[best]);
+            moved(pos);
+            pos = best;
+            child = first_child(pos);
+        }
+        data[pos] = std::move(elem);
+        sift_up(data, start, pos, less, moved);
+    }
+
+    template<typename T, typename Less, typename Moved>
+    static void heapify(T* data, size_t len, Less& less, Moved& moved) {
+        if (len < 2) return;
+        size_t n = parent(len - 1) + 1;
+        while (n > 0) {
+            n--;
+            sift_down_range(data, n, len, less, moved);
+        }
+    }
+};
+
+struct HeapNoMoved {
+    void operator()(size_t) const {}
+};
+
+} // namespace detail
+
+template<typename T, typename Compare, size_t D, typename Alloc>
+class BinaryHeap {
+private:
+    typedef detail::HeapOps<D> Ops;
+
+    Vec<T, Alloc> data_;
+    Compare less_;
+
+    void rebuild() {
+        detail::HeapNoMoved none;
+        Ops::heapify(data_.as_mut_ptr(), data_.len(), less_, none);
+    }
+
+    void sift_up(size_t pos) {
+        detail::HeapNoMoved none;
+        Ops::sift_up(data_.as_mut_ptr(), 0, pos, less_, none);
+    }
+
+    void sift_down(size_t pos) {
+        detail::HeapNoMoved none;
+        Ops::sift_down_range(data_.as_mut_ptr(), pos, data_.len(), less_, none);
+    }
+
+    BinaryHeap(Vec<T, Alloc> data, Compare less)
+        : data_(std::move(data)), less_(std::move(less)) {
+        rebuild();
+    }
+
+public:
+    // Constructors
+    BinaryHeap() : data_(), less_() {}
+
+    explicit BinaryHeap(Compare less) : data_(), less_(std::move(less)) {}
+
+    BinaryHeap(std::initializer_list<T> items)
+        : data_(items), less_() {
+        rebuild();
+    }
+
+    // Factory methods
+    // @lifetime: owned
+    static BinaryHeap new_() { return BinaryHeap(); }
+
+    // @lifetime: owned
+    static BinaryHeap with_capacity(size_t cap) {
+        BinaryHeap heap;
+        heap.data_ = Vec<T, Alloc>::with_capacity(cap);
+        return heap;
+    }
+
+    // @lifetime: owned
+    static BinaryHeap with_capacity_in(size_t cap, const Alloc& alloc) {
+        BinaryHeap heap;
+        heap.data_ = Vec<T, Alloc>::with_capacity_in(cap, alloc);
+        return heap;
+    }
+
+    // @lifetime: owned
+    static Result<BinaryHeap, AllocError> try_with_capacity(size_t cap) {
+        Result<Vec<T, Alloc>, AllocError> data = Vec<T, Alloc>::try_with_capacity(cap);
+        if (data.is_err()) return Result<BinaryHeap, AllocError>::Err(data.unwrap_err());
+        BinaryHeap heap;
+        heap.data_ = data.unwrap();
+        return Result<BinaryHeap, AllocError>::Ok(std::move(heap));
+    }
+
+    // Heapify the elements of vec in place: O(n), no extra allocation
+    // @lifetime: owned
+    static BinaryHeap from_vec(Vec<T, Alloc> vec, Compare less = Compare()) {
+        return BinaryHeap(std::move(vec), std::move(less));
+    }
+
+    // Move-only, like Vec
+    BinaryHeap(const BinaryHeap&) = delete;
+    BinaryHeap& operator=(const BinaryHeap&) = delete;
+    BinaryHeap(BinaryHeap&&) = default;
+    BinaryHeap& operator=(BinaryHeap&&) = default;
+
+    size_t len() const { return data_.len(); }
+    bool is_empty() const { return data_.is_empty(); }
+    size_t capacity() const { return data_.capacity(); }
+
+    // Reserve room for at least len() + additional elements
+    void reserve(size_t additional) { data_.reserve(data_.len() + additional); }
+
+    // Greatest element, without removing it
+    // @lifetime: (&'a) -> &'a
+    Option<const T&> peek() const {
+        if (data_.is_empty()) return None;
+        return Option<const T&>(data_[0]);
+    }
+
+    void push(T value) {
+        data_.push(std::move(value));
+        sift_up(data_.len() - 1);
+    }
+
+    // @lifetime: owned
+    Result<void, AllocError> try_push(T value) {
+        Result<void, AllocError> pushed = data_.try_push(std::move(value));
+        if (pushed.is_ok()) sift_up(data_.len() - 1);
+        return pushed;
+    }
+
+    // Remove and return the greatest element
+    // @lifetime: owned
+    Option<T> pop() {
+        if (data_.is_empty()) return None;
+        T last = data_.pop();
+        if (data_.is_empty()) return Option<T>(std::move(last));
+        using std::swap;
+        swap(last, data_[0]);
+        detail::HeapNoMoved none;
+        Ops::sift_down_to_bottom(data_.as_mut_ptr(), 0, data_.len(), less_, none);
+        return Option<T>(std::move(last));
+    }
+
+    // push(value) followed by pop(), with at most one sift. Returns value
+    // itself when it is at least as great as every element.
+    // @lifetime: owned
+    T push_pop(T value) {
+        if (data_.is_empty() || !less_(value, data_[0])) return value;
+        using std::swap;
+        swap(value, data_[0]);
+        sift_down(0);
+        return value;
+    }
+
+    // pop() followed by push(value), with one sift. Returns None (and just
+    // pushes) when the heap was empty.
+    // @lifetime: owned
+    Option<T> replace(T value) {
+        if (data_.is_empty()) {
+            data_.push(std::move(value));
+            return None;
+        }
+        using std::swap;
+        swap(value, data_[0]);
+        sift_down(0);
+        return Option<T>(std::move(value));
+    }
+
+    // Move all elements of other into this heap, leaving other empty
+    void append(BinaryHeap& other) {
+        if (data_.len() < other.data_.len()) std::swap(data_, other.data_);
+        size_t added = other.data_.len();
+        if (added == 0) return;
+        // Rebuilding is O(len + added); pushing one by one is
+        // O(added * log len). Pick the cheaper (as Rust's append does).
+        size_t total = data_.len() + added;
+        size_t log2 = 0;
+        for (size_t n = data_.len(); n > 1; n >>= 1) log2++;
+        size_t start = data_.len();
+        data_.append(other.data_);
+        if (2 * total < added * log2) {
+            rebuild();
+        } else {
+            for (size_t i = start; i < total; i++) sift_up(i);
+        }
+    }
+
+    // Keep only the elements for which pred returns true
+    template<typename Pred>
+    void retain(Pred pred) {
+        size_t before = data_.len();
+        data_.retain(pred);
+        if (data_.len() != before) rebuild();
+    }
+
+    void clear() { data_.clear(); }
+
+    // Elements in heap order (not sorted)
+    // @lifetime: (&'a) -> &'a
+    Slice<T> as_slice() const { return data_.as_slice(); }
+
+    // @lifetime: (&'a) -> &'a
+    SliceIter<T> iter() const { return data_.iter(); }
+
+    const T* begin() const { return data_.begin(); }
+    const T* end() const { return data_.end(); }
+
+    // The underlying storage, in heap order
+    // @lifetime: owned
+    Vec<T, Alloc> into_vec() && { return std::move(data_); }
+
+    // The elements in ascending order under Compare, sorted in place by
+    // heapsort
+    // @lifetime: owned
+    Vec<T, Alloc> into_sorted_vec() && {
+        T* data = data_.as_mut_ptr();
+        detail::HeapNoMoved none;
+        using std::swap;
+        for (size_t end = data_.len(); end > 1;) {
+            end--;
+            swap(data[0], data[end]);
+            Ops::sift_down_range(data, 0, end, less_, none);
+        }
+        return std::move(data_);
+    }
+
+    // Consume the heap, yielding elements in heap order
+    // @lifetime: owned
+    VecIntoIter<T, Alloc> into_iter() && { return std::move(data_).into_iter(); }
+
+    // @lifetime: owned
+    BinaryHeap clone() const {
+        BinaryHeap heap(less_);
+        heap.data_ = data_.clone();
+        return heap;
+    }
+};
+
+template<typename T, typename Compare, size_t D, typename Alloc>
+struct is_trivially_relocatable<BinaryHeap<T, Compare, D, Alloc>>
+    : std::integral_constant<bool, is_trivially_relocatable<Alloc>::value &&
+                                   std::is_trivially_copyable<Compare>::value> {};
+
+template<typename T, typename Compare, size_t D, typename Alloc>
+struct is_send<BinaryHeap<T, Compare, D, Alloc>>
+    : detail::all_of<is_send<T>::value, is_send<Compare>::value, is_send<Alloc>::value> {};
+
+template<typename T, typename Compare, size_t D, typename Alloc>
+struct is_sync<BinaryHeap<T, Compare, D, Alloc>>
+    : detail::all_of<is_sync<T>::value, is_sync<Compare>::value, is_sync<Alloc>::value> {};
+
+// IndexedBinaryHeap<P> - A priority queue of ids with mutable priorities
+//
+// Ids are integers in [0, n); the id -> position table grows to the
+// largest id pushed, so ids should be dense (node numbers, timer slots).
+// Ordering follows BinaryHeap: the top is the greatest priority under
+// Compare, so shortest-path searches use std::greater<P> to pop the
+// smallest distance first.
+template<typename P, typename Compare, size_t D, typename Alloc>
+class IndexedBinaryHeap {
+private:
+    typedef detail::HeapOps<D> Ops;
+
+    static constexpr size_t NOT_PRESENT = SIZE_MAX;
+
+    struct Entry {
+        P priority;
+        size_t id;
+    };
+
+    struct EntryLess {
+        Compare less;
+        bool operator()(const Entry& a, const Entry& b) { return less(a.priority, b.priority); }
+    };
+
+    // Records an entry's new position after each move
+    struct Moved {
+        Entry* heap;
+        size_t* pos;
+        void operator()(size_t at) const { pos[heap[at].id] = at; }
+    };
+
+    Vec<Entry, Alloc> heap_;
+    Vec<size_t, Alloc> pos_;  // id -> heap position, or NOT_PRESENT
+    EntryLess less_;
+
+    Moved moved() { Moved m = { heap_.as_mut_ptr(), pos_.as_mut_ptr() }; return m; }
+
+    size_t sift_up(size_t at) {
+        Moved m = moved();
+        return Ops::sift_up(heap_.as_mut_ptr(), 0, at, less_, m);
+    }
+
+    void sift_down(size_t at) {
+        Moved m = moved();
+        Ops::sift_down_range(heap_.as_mut_ptr(), at, heap_.len(), less_, m);
+    }
+
+    // Restore heap order around an entry whose priority changed
+    void resift(size_t at) {
+        if (sift_up(at) == at) sift_down(at);
+    }
+
+    // Remove the entry at heap position at, returning its priority
+    P remove_at(size_t at) {
+        Entry last = heap_.pop();
+        pos_[last.id] = NOT_PRESENT;
+        if (at == heap_.len()) return std::move(last.priority);
+        using std::swap;
+        swap(last, heap_[at]);
+        pos_[heap_[at].id] = at;
+        pos_[last.id] = NOT_PRESENT;
+        resift(at);
+        return std::move(last.priority);
+    }
+
+public:
+    // Constructors
+    IndexedBinaryHeap() : heap_(), pos_(), less_() {}
+
+    explicit IndexedBinaryHeap(Compare less) : heap_(), pos_() { less_.less = std::move(less); }
+
+    // Factory methods
+    // @lifetime: owned
+    static IndexedBinaryHeap new_() { return IndexedBinaryHeap(); }
+
+    // Room for ids [0, ids) without reallocating
+    // @lifetime: owned
+    static IndexedBinaryHeap with_capacity(size_t ids) {
+        IndexedBinaryHeap heap;
+        heap.heap_ = Vec<Entry, Alloc>::with_capacity(ids);
+        heap.pos_ = Vec<size_t, Alloc>::with_capacity(ids);
+        heap.pos_.resize(ids, NOT_PRESENT);
+        return heap;
+    }
+
+    // Move-only, like Vec
+    IndexedBinaryHeap(const IndexedBinaryHeap&) = delete;
+    IndexedBinaryHeap& operator=(const IndexedBinaryHeap&) = delete;
+    IndexedBinaryHeap(IndexedBinaryHeap&&) = default;
+    IndexedBinaryHeap& operator=(IndexedBinaryHeap&&) = default;
+
+    size_t len() const { return heap_.len(); }
+    bool is_empty() const { return heap_.is_empty(); }
+
+    bool contains(size_t id) const {
+        return id < pos_.len() && pos_[id] != NOT_PRESENT;
+    }
+
+    // @lifetime: (&'a) -> &'a
+    Option<const P&> priority(size_t id) const {
+        if (!contains(id)) return None;
+        return Option<const P&>(heap_[pos_[id]].priority);
+    }
+
+    // Id with the greatest priority, without removing it
+    Option<size_t> peek() const {
+        if (heap_.is_empty()) return None;
+        return Option<size_t>(heap_[0].id);
+    }
+
+    // @lifetime: (&'a) -> &'a
+    Option<const P&> peek_priority() const {
+        if (heap_.is_empty()) return None;
+        return Option<const P&>(heap_[0].priority);
+    }
+
+    // Insert id with priority. If id is already queued its priority is
+    // replaced and the old one returned.
+    // @lifetime: owned
+    Option<P> push(size_t id, P priority) {
+        assert(id != NOT_PRESENT);
+        if (contains(id)) return Option<P>(change_key(id, std::move(priority)));
+        if (id >= pos_.len()) pos_.resize(id + 1, NOT_PRESENT);
+        Entry entry = { std::move(priority), id };
+        heap_.push(std::move(entry));
+        sift_up(heap_.len() - 1);
+        return None;
+    }
+
+    // Remove and return the id with the greatest priority
+    // @lifetime: owned
+    Option<std::pair<size_t, P>> pop() {
+        if (heap_.is_empty()) return None;
+        size_t id = heap_[0].id;
+        P priority = remove_at(0);
+        return Option<std::pair<size_t, P>>(std::make_pair(id, std::move(priority)));
+    }
+
+    // Move id toward the top: priority must not be less than the current
+    // one under Compare (with std::greater, not larger). Returns false and
+    // leaves the entry unchanged otherwise. id must be queued.
+    bool decrease_key(size_t id, P priority) {
+        assert(contains(id));
+        size_t at = pos_[id];
+        if (less_.less(priority, heap_[at].priority)) return false;
+        heap_[at].priority = std::move(priority);
+        sift_up(at);
+        return true;
+    }
+
+    // Set id's priority in either direction, returning the old one. id must
+    // be queued.
+    // @lifetime: owned
+    P change_key(size_t id, P priority) {
+        assert(contains(id));
+        size_t at = pos_[id];
+        using std::swap;
+        swap(priority, heap_[at].priority);
+        resift(at);
+        return priority;
+    }
+
+    // Remove id from the queue, returning its priority
+    // @lifetime: owned
+    Option<P> remove(size_t id) {
+        if (!contains(id)) return None;
+        return Option<P>(remove_at(pos_[id]));
+    }
+
+    void clear() {
+        for (size_t i = 0; i < heap_.len(); i++) pos_[heap_[i].id] = NOT_PRESENT;
+        heap_.clear();
+    }
+};
+
+template<typename P, typename Compare, size_t D, typename Alloc>
+constexpr size_t IndexedBinaryHeap<P, Compare, D, Alloc>::NOT_PRESENT;
+
+} // namespace rusty
+
+#endif // RUSTY_BINARYHEAP_HPP
@@ -0,0 +1,703 @@
+#ifndef RUSTY_BITVEC_HPP
+#define RUSTY_BITVEC_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include "alloc.hpp"
+#include "fwd.hpp"
+#include "iter.hpp"
+#include "option.hpp"
+#include "relocate.hpp"
+#include "slice.hpp"
+#include "vec.hpp"
+
+// BitVec / FixedBitSet - Dense bit arrays packed into 64-bit words
+// BitVec is a growable sequence of bools (like Rust's bitvec::BitVec);
+// FixedBitSet is a set of small integers on top of it (like the
+// fixedbitset crate). For dense id ranges a set costs one bit per
+// possible member, where HashSet<uint32_t> costs several bytes per
+// member plus control bytes and load-factor slack.
+//
+// Whole-set operations work a word at a time: and/or/xor/not are one
+// instruction per 64 members, count_ones is a popcount per word and
+// iter_ones() finds each member with a trailing-zero count.
+//
+// Bulk kernel backend, selected at compile time:
+// - AVX2: 256 bits per step, with a nibble-lookup popcount (whenever the
+//   target has AVX2)
+// - Scalar: one word per step with popcnt/tzcnt builtins (force with
+//   -DRUSTY_BITVEC_SCALAR)
+//
+// Invariant: the bits of the last word past len() are always zero, so
+// counts, comparisons and iteration never look at them.
+#if defined(RUSTY_BITVEC_SCALAR)
+#define RUSTY_BITS_SCALAR 1
+#elif defined(__AVX2__)
+#define RUSTY_BITS_AVX2 1
+#else
+#define RUSTY_BITS_SCALAR 1
+#endif
+
+#if defined(RUSTY_BITS_AVX2)
+#include <immintrin.h>
+#endif
+
+// @safe
+namespace rusty {
+
+namespace detail {
+
+constexpr size_t BITS_PER_WORD = 64;
+
+inline size_t bit_words(size_t bits) { return (bits + BITS_PER_WORD - 1) / BITS_PER_WORD; }
+
+inline size_t word_count_ones(uint64_t w) { return static_cast<size_t>(__builtin_popcountll(w)); }
+inline size_t word_trailing_zeros(uint64_t w) { return static_cast<size_t>(__builtin_ctzll(w)); }
+inline size_t word_leading_zeros(uint64_t w) { return static_cast<size_t>(__builtin_clzll(w)); }
+
+// Word-wise binary operations, applied as dst = Op(dst, src)
+struct BitAnd {
+    static uint64_t apply(uint64_t a, uint64_t b) { return a & b; }
+#if defined(RUSTY_BITS_AVX2)
+    static __m256i apply(__m256i a, __m256i b) { return _mm256_and_si256(a, b); }
+#endif
+};
+
+struct BitOr {
+    static uint64_t apply(uint64_t a, uint64_t b) { return a | b; }
+#if defined(RUSTY_BITS_AVX2)
+    static __m256i apply(__m256i a, __m256i b) { return _mm256_or_si256(a, b); }
+#endif
+};
+
+struct BitXor {
+    static uint64_t apply(uint64_t a, uint64_t b) { return a ^ b; }
+#if defined(RUSTY_BITS_AVX2)
+    static __m256i apply(__m256i a, __m256i b) { return _mm256_xor_si256(a, b); }
+#endif
+};
+
+// a & !b
+struct BitAndNot {
+    static uint64_t apply(uint64_t a, uint64_t b) { return a & ~b; }
+#if defined(RUSTY_BITS_AVX2)
+    static __m256i apply(__m256i a, __m256i b) { return _mm256_andnot_si256(b, a); }
+#endif
+};
+
+#if defined(RUSTY_BITS_AVX2)
+inline __m256i bits_load(const uint64_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+inline void bits_store(uint64_t* p, __m256i v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+}
+
+// Per-64-bit-lane popcounts of v (Mula's nibble lookup)
+inline __m256i bits_popcount_lanes(__m256i v) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0f);
+    __m256i lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low));
+    __m256i hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+    return _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256());
+}
+
+inline size_t bits_sum_lanes(__m256i acc) {
+    return static_cast<size_t>(_mm256_extract_epi64(acc, 0) + _mm256_extract_epi64(acc, 1) +
+                               _mm256_extract_epi64(acc, 2) + _mm256_extract_epi64(acc, 3));
+}
+#endif
+
+template<typename Op>
+inline void bits_apply(uint64_t* dst, const uint64_t* src, size_t n) {
+    size_t i = 0;
+#if defined(RUSTY_BITS_AVX2)
+    for (; i + 4 <= n; i += 4) {
+        bits_store(dst + i, Op::apply(bits_load(dst + i), bits_load(src + i)));
+    }
+#endif
+    for (; i < n; i++) {
+        dst[i] = Op::apply(dst[i], src[i]);
+    }
+}
+
+inline void bits_not(uint64_t* dst, size_t n) {
+    size_t i = 0;
+#if defined(RUSTY_BITS_AVX2)
+    const __m256i ones = _mm256_set1_epi64x(-1);
+    for (; i + 4 <= n; i += 4) {
+        bits_store(dst + i, _mm256_xor_si256(bits_load(dst + i), ones));
+    }
+#endif
+    for (; i < n; i++) {
+        dst[i] = ~dst[i];
+    }
+}
+
+inline size_t bits_count(const uint64_t* p, size_t n) {
+    size_t total = 0;
+    size_t i = 0;
+#if defined(RUSTY_BITS_AVX2)
+    __m256i acc = _mm256_setzero_si256();
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm256_add_epi64(acc, bits_popcount_lanes(bits_load(p + i)));
+    }
+    total = bits_sum_lanes(acc);
+#endif
+    for (; i < n; i++) {
+        total += word_count_ones(p[i]);
+    }
+    return total;
+}
+
+// Ones in Op(a, b), without materializing it
+template<typename Op>
+inline size_t bits_count_op(const uint64_t* a, const uint64_t* b, size_t n) {
+    size_t total = 0;
+    size_t i = 0;
+#if defined(RUSTY_BITS_AVX2)
+    __m256i acc = _mm256_setzero_si256();
+    for (; i + 4 <= n; i += 4) {
+        acc = _mm256_add_epi64(acc, bits_popcount_lanes(Op::apply(bits_load(a + i), bits_load(b + i))));
+    }
+    total = bits_sum_lanes(acc);
+#endif
+    for (; i < n; i++) {
+        total += word_count_ones(Op::apply(a[i], b[i]));
+    }
+    return total;
+}
+
+// Whether Op(a, b) has any one bit, stopping at the first
+template<typename Op>
+inline bool bits_any_op(const uint64_t* a, const uint64_t* b, size_t n) {
+    size_t i = 0;
+#if defined(RUSTY_BITS_AVX2)
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = Op::apply(bits_load(a + i), bits_load(b + i));
+        if (!_mm256_testz_si256(v, v)) return true;
+    }
+#endif
+    for (; i < n; i++) {
+        if (Op::apply(a[i], b[i]) != 0) return true;
+    }
+    return false;
+}
+
+inline bool bits_any(const uint64_t* p, size_t n) {
+    size_t i = 0;
+#if defined(RUSTY_BITS_AVX2)
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = bits_load(p + i);
+        if (!_mm256_testz_si256(v, v)) return true;
+    }
+#endif
+    for (; i < n; i++) {
+        if (p[i] != 0) return true;
+    }
+    return false;
+}
+
+} // namespace detail
+
+// Iterator over the indices of the one bits, ascending
+// Each step is a trailing-zero count and a clear-lowest-bit; zero words
+// are skipped a word at a time.
+class BitOnes : public Iterator<BitOnes, size_t> {
+private:
+    const uint64_t* words_;
+    size_t count_;      // Words in the array
+    size_t index_;      // Word that current_ came from
+    uint64_t current_;  // Bits of words_[index_] not yet visited
+
+public:
+    BitOnes(const uint64_t* words, size_t count)
+        : words_(words), count_(count), index_(0), current_(count > 0 ? words[0] : 0) {}
+
+    template<typename F>
+    bool next_with(F&& f) {
+        while (current_ == 0) {
+            if (++index_ >= count_) {
+                index_ = count_;
+                return false;
+            }
+            current_ = words_[index_];
+        }
+        size_t bit = index_ * detail::BITS_PER_WORD + detail::word_trailing_zeros(current_);
+        current_ &= current_ - 1;
+        f(bit);
+        return true;
+    }
+
+    size_t size_hint() const { return detail::word_count_ones(current_); }
+};
+
+template<typename Alloc>
+class BasicFixedBitSet;
+
+template<typename Alloc>
+class BasicBitVec {
+private:
+    Vec<uint64_t, Alloc> words_;  // Always bit_words(len_) long
+    size_t len_;
+
+    friend class BasicFixedBitSet<Alloc>;
+
+    static uint64_t mask(size_t index) { return uint64_t(1) << (index % detail::BITS_PER_WORD); }
+
+    // Mask of bits [from, BITS_PER_WORD) of a word
+    static uint64_t mask_from(size_t from) { return ~uint64_t(0) << from; }
+
+    void clear_tail() {
+        size_t used = len_ % detail::BITS_PER_WORD;
+        if (used != 0) {
+            words_[words_.len() - 1] &= ~mask_from(used);
+        }
+    }
+
+    explicit BasicBitVec(Vec<uint64_t, Alloc> words, size_t len) : words_(std::move(words)), len_(len) {}
+
+public:
+    // Constructors
+    BasicBitVec() : words_(), len_(0) {}
+
+    explicit BasicBitVec(const Alloc& alloc) : words_(Vec<uint64_t, Alloc>::new_in(alloc)), len_(0) {}
+
+    // @lifetime: owned
+    static BasicBitVec new_() { return BasicBitVec(); }
+
+    // @lifetime: owned
+    static BasicBitVec new_in(const Alloc& alloc) { return BasicBitVec(alloc); }
+
+    // Empty, with room for at least bits bits
+    // @lifetime: owned
+    static BasicBitVec with_capacity(size_t bits) {
+        return BasicBitVec(Vec<uint64_t, Alloc>::with_capacity(detail::bit_words(bits)), 0);
+    }
+
+    // @lifetime: owned
+    static BasicBitVec with_capacity_in(size_t bits, const Alloc& alloc) {
+        return BasicBitVec(Vec<uint64_t, Alloc>::with_capacity_in(detail::bit_words(bits), alloc), 0);
+    }
+
+    // len copies of bit
+    // @lifetime: owned
+    static BasicBitVec repeat(bool bit, size_t len) {
+        BasicBitVec out = with_capacity(len);
+        out.resize(len, bit);
+        return out;
+    }
+
+    BasicBitVec(BasicBitVec&& other) noexcept : words_(std::move(other.words_)), len_(other.len_) {
+        other.len_ = 0;
+    }
+
+    BasicBitVec& operator=(BasicBitVec&& other) noexcept {
+        if (this != &other) {
+            words_ = std::move(other.words_);
+            len_ = other.len_;
+            other.len_ = 0;
+        }
+        return *this;
+    }
+
+    BasicBitVec(const BasicBitVec&) = delete;
+    BasicBitVec& operator=(const BasicBitVec&) = delete;
+
+    size_t len() const { return len_; }
+    bool is_empty() const { return len_ == 0; }
+
+    // Bits that fit without reallocating
+    size_t capacity() const { return words_.capacity() * detail::BITS_PER_WORD; }
+
+    // Make room for at least bits bits in total
+    void reserve(size_t bits) { words_.reserve(detail::bit_words(bits)); }
+
+    // @lifetime: (&'a) -> &'a
+    const Alloc& allocator() const { return words_.allocator(); }
+
+    void push(bool bit) {
+        if (len_ % detail::BITS_PER_WORD == 0) words_.push(0);
+        if (bit) words_[len_ / detail::BITS_PER_WORD] |= mask(len_);
+        len_++;
+    }
+
+    // Remove and return the last bit
+    Option<bool> pop() {
+        if (len_ == 0) return None;
+        len_--;
+        uint64_t& word = words_[len_ / detail::BITS_PER_WORD];
+        bool bit = (word & mask(len_)) != 0;
+        word &= ~mask(len_);
+        if (len_ % detail::BITS_PER_WORD == 0) words_.pop();
+        return Option<bool>(bit);
+    }
+
+    // The bit at index, or None when out of range
+    Option<bool> get(size_t index) const {
+        if (index >= len_) return None;
+        return Option<bool>((*this)[index]);
+    }
+
+    bool operator[](size_t index) const {
+        assert(index < len_ && "BitVec index out of bounds");
+        return (words_[index / detail::BITS_PER_WORD] & mask(index)) != 0;
+    }
+
+    void set(size_t index, bool bit) {
+        assert(index < len_ && "BitVec index out of bounds");
+        uint64_t& word = words_[index / detail::BITS_PER_WORD];
+        if (bit) word |= mask(index);
+        else word &= ~mask(index);
+    }
+
+    // Set the bit at index, returning its previous value
+    bool replace(size_t index, bool bit) {
+        bool old = (*this)[index];
+        set(index, bit);
+        return old;
+    }
+
+    void toggle(size_t index) {
+        assert(index < len_ && "BitVec index out of bounds");
+        words_[index / detail::BITS_PER_WORD] ^= mask(index);
+    }
+
+    // Set bits [start, end) to bit, whole words at a time
+    void set_range(size_t start, size_t end, bool bit) {
+        assert(start <= end && end <= len_ && "BitVec range out of bounds");
+        if (start == end) return;
+        size_t first = start / detail::BITS_PER_WORD;
+        size_t last = (end - 1) / detail::BITS_PER_WORD;
+        uint64_t head = mask_from(start % detail::BITS_PER_WORD);
+        uint64_t tail = ~uint64_t(0) >> (detail::BITS_PER_WORD - 1 - (end - 1) % detail::BITS_PER_WORD);
+        uint64_t* w = words_.as_mut_ptr();
+        if (first == last) {
+            head &= tail;
+            if (bit) w[first] |= head;
+            else w[first] &= ~head;
+            return;
+        }
+        if (bit) w[first] |= head;
+        else w[first] &= ~head;
+        std::memset(w + first + 1, bit ? 0xff : 0, (last - first - 1) * sizeof(uint64_t));
+        if (bit) w[last] |= tail;
+        else w[last] &= ~tail;
+    }
+
+    // Set every bit to bit
+    void fill(bool bit) {
+        std::memset(words_.as_mut_ptr(), bit ? 0xff : 0, words_.len() * sizeof(uint64_t));
+        clear_tail();
+    }
+
+    // Grow with copies of bit, or shrink to len bits
+    void resize(size_t len, bool bit) {
+        if (len <= len_) {
+            truncate(len);
+            return;
+        }
+        size_t old = len_;
+        words_.resize(detail::bit_words(len), bit ? ~uint64_t(0) : 0);
+        len_ = len;
+        if (bit && old % detail::BITS_PER_WORD != 0) {
+            words_[old / detail::BITS_PER_WORD] |= mask_from(old % detail::BITS_PER_WORD);
+        }
+        clear_tail();
+    }
+
+    // Keep the first len bits
+    void truncate(size_t len) {
+        if (len >= len_) return;
+        len_ = len;
+        words_.truncate(detail::bit_words(len));
+        clear_tail();
+    }
+
+    void clear() {
+        words_.clear();
+        len_ = 0;
+    }
+
+    // Queries
+
+    size_t count_ones() const { return detail::bits_count(words_.as_ptr(), words_.len()); }
+    size_t count_zeros() const { return len_ - count_ones(); }
+
+    bool any() const { return detail::bits_any(words_.as_ptr(), words_.len()); }
+    bool none() const { return !any(); }
+    bool all() const { return count_ones() == len_; }
+
+    // Index of the lowest one bit
+    Option<size_t> first_one() const {
+        for (size_t i = 0; i < words_.len(); i++) {
+            if (words_[i] != 0) {
+                return Option<size_t>(i * detail::BITS_PER_WORD + detail::word_trailing_zeros(words_[i]));
+            }
+        }
+        return None;
+    }
+
+    // Index of the highest one bit
+    Option<size_t> last_one() const {
+        for (size_t i = words_.len(); i-- > 0;) {
+            if (words_[i] != 0) {
+                return Option<size_t>(i * detail::BITS_PER_WORD + detail::BITS_PER_WORD - 1 -
+                                      detail::word_leading_zeros(words_[i]));
+            }
+        }
+        return None;
+    }
+
+    // Indices of the one bits, ascending
+    // @lifetime: (&'a) -> &'a
+    BitOnes iter_ones() const { return BitOnes(words_.as_ptr(), words_.len()); }
+
+    // The packed words, bit i at (words[i / 64] >> (i % 64)) & 1
+    // @lifetime: (&'a) -> &'a
+    Slice<uint64_t> as_raw_slice() const { return words_.as_slice(); }
+
+    // Bulk operations, a word at a time. The length of *this never
+    // changes: bits past other's length count as zero.
+
+    BasicBitVec& operator&=(const BasicBitVec& other) {
+        size_t n = words_.len() < other.words_.len() ? words_.len() : other.words_.len();
+        detail::bits_apply<detail::BitAnd>(words_.as_mut_ptr(), other.words_.as_ptr(), n);
+        std::memset(words_.as_mut_ptr() + n, 0, (words_.len() - n) * sizeof(uint64_t));
+        return *this;
+    }
+
+    BasicBitVec& operator|=(const BasicBitVec& other) {
+        size_t n = words_.len() < other.words_.len() ? words_.len() : other.words_.len();
+        detail::bits_apply<detail::BitOr>(words_.as_mut_ptr(), other.words_.as_ptr(), n);
+        clear_tail();
+        return *this;
+    }
+
+    BasicBitVec& operator^=(const BasicBitVec& other) {
+        size_t n = words_.len() < other.words_.len() ? words_.len() : other.words_.len();
+        detail::bits_apply<detail::BitXor>(words_.as_mut_ptr(), other.words_.as_ptr(), n);
+        clear_tail();
+        return *this;
+    }
+
+    // Clear the bits that are set in other
+    BasicBitVec& operator-=(const BasicBitVec& other) {
+        size_t n = words_.len() < other.words_.len() ? words_.len() : other.words_.len();
+        detail::bits_apply<detail::BitAndNot>(words_.as_mut_ptr(), other.words_.as_ptr(), n);
+        return *this;
+    }
+
+    // Flip every bit in place
+    void negate() {
+        detail::bits_not(words_.as_mut_ptr(), words_.len());
+        clear_tail();
+    }
+
+    // @lifetime: owned
+    BasicBitVec operator&(const BasicBitVec& other) const {
+        BasicBitVec out = clone();
+        out &= other;
+        return out;
+    }
+
+    // @lifetime: owned
+    BasicBitVec operator|(const BasicBitVec& other) const {
+        BasicBitVec out = clone();
+        out |= other;
+        return out;
+    }
+
+    // @lifetime: owned
+    BasicBitVec operator^(const BasicBitVec& other) const {
+        BasicBitVec out = clone();
+        out ^= other;
+        return out;
+    }
+
+    // @lifetime: owned
+    BasicBitVec operator-(const BasicBitVec& other) const {
+        BasicBitVec out = clone();
+        out -= other;
+        return out;
+    }
+
+    // @lifetime: owned
+    BasicBitVec operator~() const {
+        BasicBitVec out = clone();
+        out.negate();
+        return out;
+    }
+
+    // @lifetime: owned
+    BasicBitVec clone() const { return BasicBitVec(words_.clone(), len_); }
+
+    bool operator==(const BasicBitVec& other) const {
+        return len_ == other.len_ && words_ == other.words_;
+    }
+
+    bool operator!=(const BasicBitVec& other) const { return !(*this == other); }
+};
+
+template<typename Alloc>
+struct is_trivially_relocatable<BasicBitVec<Alloc>> : is_trivially_relocatable<Alloc> {};
+
+typedef BasicBitVec<Global> BitVec;
+
+// FixedBitSet - A set of integers in [0, len()), one bit each
+// Equivalent to Rust's fixedbitset::FixedBitSet. The universe grows
+// only through grow() or a union with a larger set; insert() past the
+// end is a bug, while contains() past the end is simply false.
+template<typename Alloc>
+class BasicFixedBitSet {
+private:
+    BasicBitVec<Alloc> bits_;
+
+    explicit BasicFixedBitSet(BasicBitVec<Alloc> bits) : bits_(std::move(bits)) {}
+
+    size_t shared_words(const BasicFixedBitSet& other) const {
+        size_t a = bits_.words_.len();
+        size_t b = other.bits_.words_.len();
+        return a < b ? a : b;
+    }
+
+public:
+    BasicFixedBitSet() : bits_() {}
+
+    // @lifetime: owned
+    static BasicFixedBitSet new_() { return BasicFixedBitSet(); }
+
+    // Room for members [0, bits), all absent
+    // @lifetime: owned
+    static BasicFixedBitSet with_capacity(size_t bits) {
+        return BasicFixedBitSet(BasicBitVec<Alloc>::repeat(false, bits));
+    }
+
+    // @lifetime: owned
+    static BasicFixedBitSet with_capacity_in(size_t bits, const Alloc& alloc) {
+        BasicBitVec<Alloc> vec = BasicBitVec<Alloc>::with_capacity_in(bits, alloc);
+        vec.resize(bits, false);
+        return BasicFixedBitSet(std::move(vec));
+    }
+
+    BasicFixedBitSet(BasicFixedBitSet&&) = default;
+    BasicFixedBitSet& operator=(BasicFixedBitSet&&) = default;
+    BasicFixedBitSet(const BasicFixedBitSet&) = delete;
+    BasicFixedBitSet& operator=(const BasicFixedBitSet&) = delete;
+
+    // Size of the universe, not the number of members (see count_ones)
+    size_t len() const { return bits_.len(); }
+
+    // Extend the universe to [0, bits); never shrinks
+    void grow(size_t bits) {
+        if (bits > bits_.len()) bits_.resize(bits, false);
+    }
+
+    void insert(size_t value) {
+        assert(value < bits_.len() && "FixedBitSet insert out of range");
+        bits_.words_[value / detail::BITS_PER_WORD] |= uint64_t(1) << (value % detail::BITS_PER_WORD);
+    }
+
+    // Insert value, returning whether it was already present
+    bool put(size_t value) {
+        bool old = contains(value);
+        insert(value);
+        return old;
+    }
+
+    // Returns whether value was present
+    bool remove(size_t value) {
+        if (value >= bits_.len()) return false;
+        return bits_.replace(value, false);
+    }
+
+    bool contains(size_t value) const {
+        return value < bits_.len() && bits_[value];
+    }
+
+    void toggle(size_t value) { bits_.toggle(value); }
+    void set(size_t value, bool present) { bits_.set(value, present); }
+
+    // Insert every value in [start, end)
+    void insert_range(size_t start, size_t end) { bits_.set_range(start, end, true); }
+
+    // Remove every member, keeping the universe
+    void clear() { bits_.fill(false); }
+
+    // Number of members
+    size_t count_ones() const { return bits_.count_ones(); }
+    bool is_clear() const { return bits_.none(); }
+
+    Option<size_t> minimum() const { return bits_.first_one(); }
+    Option<size_t> maximum() const { return bits_.last_one(); }
+
+    // Members, ascending
+    // @lifetime: (&'a) -> &'a
+    BitOnes ones() const { return bits_.iter_ones(); }
+
+    // @lifetime: (&'a) -> &'a
+    const BasicBitVec<Alloc>& as_bitvec() const { return bits_; }
+
+    // In-place set operations. union and symmetric difference grow the
+    // universe to cover other's.
+
+    void union_with(const BasicFixedBitSet& other) {
+        grow(other.len());
+        bits_ |= other.bits_;
+    }
+
+    void intersect_with(const BasicFixedBitSet& other) { bits_ &= other.bits_; }
+
+    void difference_with(const BasicFixedBitSet& other) { bits_ -= other.bits_; }
+
+    void symmetric_difference_with(const BasicFixedBitSet& other) {
+        grow(other.len());
+        bits_ ^= other.bits_;
+    }
+
+    // Set queries, without building the result
+
+    size_t intersection_count(const BasicFixedBitSet& other) const {
+        return detail::bits_count_op<detail::BitAnd>(bits_.words_.as_ptr(), other.bits_.words_.as_ptr(),
+                                                     shared_words(other));
+    }
+
+    size_t union_count(const BasicFixedBitSet& other) const {
+        return count_ones() + other.count_ones() - intersection_count(other);
+    }
+
+    bool is_disjoint(const BasicFixedBitSet& other) const {
+        return !detail::bits_any_op<detail::BitAnd>(bits_.words_.as_ptr(), other.bits_.words_.as_ptr(),
+                                                    shared_words(other));
+    }
+
+    bool is_subset(const BasicFixedBitSet& other) const {
+        size_t n = shared_words(other);
+        const uint64_t* mine = bits_.words_.as_ptr();
+        if (detail::bits_any_op<detail::BitAndNot>(mine, other.bits_.words_.as_ptr(), n)) return false;
+        return !detail::bits_any(mine + n, bits_.words_.len() - n);
+    }
+
+    bool is_superset(const BasicFixedBitSet& other) const { return other.is_subset(*this); }
+
+    // @lifetime: owned
+    BasicFixedBitSet clone() const { return BasicFixedBitSet(bits_.clone()); }
+
+    // Same universe and same members
+    bool operator==(const BasicFixedBitSet& other) const { return bits_ == other.bits_; }
+    bool operator!=(const BasicFixedBitSet& other) const { return !(*this == other); }
+};
+
+template<typename Alloc>
+struct is_trivially_relocatable<BasicFixedBitSet<Alloc>> : is_trivially_relocatable<Alloc> {};
+
+typedef BasicFixedBitSet<Global> FixedBitSet;
+
+} // namespace rusty
+
+#endif // RUSTY_BITVEC_HPP
@@ -0,0 +1,57 @@
+#ifndef RUSTY_BOUNDS_HPP
+#define RUSTY_BOUNDS_HPP
+
+#include <stdexcept>
+
+// Bounds-check policy
+//
+// Index and range arguments to Vec, SmallVec, VecDeque, Slice, SliceMut,
+// String and str (operator[], front/back, pop, insert, remove, drain,
+// slice, ...) are checked when RUSTY_BOUNDS_CHECKS is 1 and not checked at
+// all when it is 0. Like assert, it defaults to 1 and to 0 under NDEBUG;
+// define it to 1 to keep the checks in a release build, or to 0 to drop
+// them from a debug one. A failed check throws std::out_of_range.
+//
+// get_unchecked(i) / get_unchecked_mut(i) never check. They are @unsafe:
+// the checker accepts them in @safe code where it can prove the index is in
+// range, which is inside
+//
+//   for (size_t i = ...; i < v.len(); ++i) { ... v.get_unchecked(i) ... }
+//
+// when the body neither writes i nor uses v except through read-only
+// methods (len, size, is_empty, get, get_unchecked, operator[]), and calls
+// nothing that can shrink a container. Anywhere else they need @unsafe.
+//
+// Every translation unit of a program must agree on RUSTY_BOUNDS_CHECKS.
+
+#if !defined(RUSTY_BOUNDS_CHECKS)
+#if defined(NDEBUG)
+#define RUSTY_BOUNDS_CHECKS 0
+#else
+#define RUSTY_BOUNDS_CHECKS 1
+#endif
+#endif
+
+// @safe
+namespace rusty {
+
+namespace detail {
+
+[[noreturn]] inline void bounds_fail(const char* what) {
+    throw std::out_of_range(what);
+}
+
+} // namespace detail
+
+constexpr bool BOUNDS_CHECKS = RUSTY_BOUNDS_CHECKS != 0;
+
+} // namespace rusty
+
+#if RUSTY_BOUNDS_CHECKS
+#define RUSTY_BOUNDS_CHECK(cond, what) \
+    ((cond) ? static_cast<void>(0) : ::rusty::detail::bounds_fail(what))
+#else
+#define RUSTY_BOUNDS_CHECK(cond, what) static_cast<void>(0)
+#endif
+
+#endif // RUSTY_BOUNDS_HPP
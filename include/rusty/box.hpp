@@ -2,6 +2,9 @@
 #define RUSTY_BOX_HPP
 
 #include <utility>  // for std::move, std::forward
+#include "alloc_observer.hpp"
+#include "niche.hpp"
+#include "relocate.hpp"
 
 // Box<T> - A smart pointer for heap-allocated values with single ownership
 // Equivalent to Rust's Box<T>
@@ -11,6 +14,9 @@
 // - Automatic deallocation when Box goes out of scope
 // - Move semantics only
 // - Null state after move
+//
+// A Box reports the pointer it holds to the allocation observer (see
+// alloc_observer.hpp) when it takes it and when it deletes or gives it up.
 
 // @safe
 namespace rusty {
@@ -20,12 +26,19 @@ class Box {
 private:
     T* ptr;
     
+    static void drop(T* p) {
+        detail::observe_dealloc(AllocKind::Box, p, sizeof(T));
+        delete p;
+    }
+    
 public:
     // Constructors
     Box() : ptr(nullptr) {}
     
     // @lifetime: owned
-    explicit Box(T* p) : ptr(p) {}
+    explicit Box(T* p) : ptr(p) {
+        detail::observe_alloc(AllocKind::Box, p, sizeof(T));
+    }
     
     // Rust-idiomatic factory method - Box::new()
     // @lifetime: owned
@@ -53,7 +66,7 @@ public:
     // @lifetime: owned
     Box& operator=(Box&& other) noexcept {
         if (this != &other) {
-            delete ptr;
+            drop(ptr);
             ptr = other.ptr;
             other.ptr = nullptr;
         }
@@ -62,7 +75,7 @@ public:
     
     // Destructor - automatic cleanup
     ~Box() {
-        delete ptr;
+        drop(ptr);
     }
     
     // Dereference - borrow the value
@@ -104,6 +117,7 @@ public:
     T* into_raw() {
         T* temp = ptr;
         ptr = nullptr;
+        detail::observe_dealloc(AllocKind::Box, temp, sizeof(T));
         return temp;
     }
     
@@ -121,11 +135,20 @@ public:
     
     // Reset with new value
     void reset(T* p = nullptr) {
-        delete ptr;
+        drop(ptr);
         ptr = p;
+        detail::observe_alloc(AllocKind::Box, p, sizeof(T));
     }
 };
 
+// Box only holds a pointer, so it can be relocated bitwise
+template<typename T>
+struct is_trivially_relocatable<Box<T>> : std::true_type {};
+
+// Empty handles are null, so Option stores None as a null pointer
+template<typename T>
+struct niche_traits<Box<T>> : null_pointer_niche {};
+
 // Rust-idiomatic factory function
 template<typename T, typename... Args>
 // @lifetime: owned
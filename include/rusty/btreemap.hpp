@@ -3,53 +3,292 @@
 
 #include <algorithm>
 #include <functional>
-#include <memory>
+#include <cstdint>
 #include <utility>
 #include <cassert>
 #include <cstring>
+#include <new>
+#include "alloc.hpp"
+#include "fwd.hpp"
 #include "option.hpp"
+#include "relocate.hpp"
+#include "stats.hpp"
+#include "traits.hpp"
 #include "vec.hpp"
 
 // Real B-Tree implementation following Rust's std::collections::BTreeMap
 // 
 // Key design decisions from Rust's implementation:
-// - B = 6: Each node has 5-11 keys (except root: 0-11 keys)
-// - Nodes are either internal (with children) or leaves (with values)
-// - Keys and edges are stored in arrays for cache locality
+// - Each node has B-1 to 2B-1 keys (except root: 0 to 2B-1 keys). B is a
+//   template parameter; by default it is picked so that a leaf fills
+//   BTREE_NODE_CACHE_LINES cache lines (never below Rust's B = 6)
+// - Nodes are either internal (with children) or leaves (with values),
+//   told apart by a tag rather than a vtable
+// - Keys and values live in uninitialized inline arrays, constructed only
+//   for occupied slots; edges are raw pointers owned by the parent
+// - Internal nodes hold copies of separator keys (made with clone() when
+//   K is not copyable); leaves are linked for in-order iteration
 // - Node splitting/merging maintains B-tree invariants
 // - In-place mutation when possible for performance
+// - Nodes come from the Alloc parameter (see alloc.hpp, default Global)
 
 // @safe
 namespace rusty {
 
-// B-tree constants matching Rust's implementation
+// B-tree constants matching Rust's implementation (the smallest B used)
 constexpr size_t BTREE_B = 6;                    // Branching factor
 constexpr size_t BTREE_MIN_LEN = BTREE_B - 1;   // 5: Minimum keys in non-root node
 constexpr size_t BTREE_MAX_LEN = 2 * BTREE_B - 1; // 11: Maximum keys in any node
 constexpr size_t BTREE_MAX_CHILDREN = 2 * BTREE_B; // 12: Maximum children
 
-template <typename K, typename V, typename Compare = std::less<K>>
-class BTreeMap {
+// Node size budget used to pick B when it is not given
+constexpr size_t BTREE_CACHE_LINE = 64;
+constexpr size_t BTREE_NODE_CACHE_LINES = 8;
+
+// Branching factor for which a leaf of K/V entries fits in CacheLines
+// cache lines, e.g. BTreeMap<K, V, Compare, Alloc, btree_b_for<K, V, 16>::value>
+template<typename K, typename V, size_t CacheLines = BTREE_NODE_CACHE_LINES>
+struct btree_b_for {
+    static constexpr size_t entries = CacheLines * BTREE_CACHE_LINE / (sizeof(K) + sizeof(V));
+    static constexpr size_t value = (entries + 1) / 2 < BTREE_B ? BTREE_B : (entries + 1) / 2;
+};
+
+namespace detail {
+
+// Keys that can be located with a branchless count over the whole node:
+// plain arithmetic keys ordered by std::less, looked up by the same type
+template<typename K, typename Compare, typename Q>
+struct btree_linear_search : std::integral_constant<bool,
+    std::is_arithmetic<K>::value && std::is_same<K, Q>::value &&
+    !std::is_same<K, bool>::value &&
+    (std::is_same<Compare, std::less<K>>::value ||
+     std::is_same<Compare, std::less<>>::value)> {};
+
+// Number of keys < key (lower bound) in a sorted run. The loop has no
+// data-dependent branch, so compilers turn it into vector compares.
+template<typename K, typename Q>
+size_t count_less(const K* keys, size_t len, const Q& key) {
+    size_t count = 0;
+    for (size_t i = 0; i < len; i++) {
+        count += static_cast<size_t>(keys[i] < key);
+    }
+    return count;
+}
+
+// Number of keys <= key (upper bound)
+template<typename K, typename Q>
+size_t count_not_greater(const K* keys, size_t len, const Q& key) {
+    size_t count = 0;
+    for (size_t i = 0; i < len; i++) {
+        count += static_cast<size_t>(!(key < keys[i]));
+    }
+    return count;
+}
+
+// Storage for up to N values of T that are constructed on demand
+// (Rust: [MaybeUninit<T>; N]). The owner tracks which slots are live.
+template<typename T, size_t N>
+struct UninitArray {
+    alignas(T) unsigned char bytes[N * sizeof(T)];
+
+    T* data() { return reinterpret_cast<T*>(bytes); }
+    const T* data() const { return reinterpret_cast<const T*>(bytes); }
+
+    T& operator[](size_t i) { return data()[i]; }
+    const T& operator[](size_t i) const { return data()[i]; }
+};
+
+} // namespace detail
+
+// Bound<T> - One end of a range (Rust: std::ops::Bound)
+// Borrows its value, so it is meant to be built in place as an argument:
+//   map.range(Included(10), Excluded(20))
+//   map.range(Unbounded, Included(key))
+struct Unbounded_t {};
+constexpr Unbounded_t Unbounded{};
+
+template<typename T>
+class Bound {
+public:
+    enum Kind { INCLUDED, EXCLUDED, UNBOUNDED };
+    
+private:
+    Kind kind_;
+    const T* value_;
+    
+    Bound(Kind kind, const T* value) : kind_(kind), value_(value) {}
+    
+public:
+    Bound(Unbounded_t) : kind_(UNBOUNDED), value_(nullptr) {}
+    
+    // @lifetime: (&'a) -> 'a
+    static Bound included(const T& value) { return Bound(INCLUDED, &value); }
+    
+    // @lifetime: (&'a) -> 'a
+    static Bound excluded(const T& value) { return Bound(EXCLUDED, &value); }
+    
+    Kind kind() const { return kind_; }
+    bool is_unbounded() const { return kind_ == UNBOUNDED; }
+    
+    // @lifetime: (&'a) -> &'a
+    const T& value() const { return *value_; }
+};
+
+template<typename T>
+// @lifetime: (&'a) -> 'a
+Bound<T> Included(const T& value) {
+    return Bound<T>::included(value);
+}
+
+template<typename T>
+// @lifetime: (&'a) -> 'a
+Bound<T> Excluded(const T& value) {
+    return Bound<T>::excluded(value);
+}
+
+// B = 0 picks btree_b_for<K, V>::value
+template <typename K, typename V, typename Compare, typename Alloc, size_t B>
+class BTreeMap : private detail::AllocHolder<Alloc> {
+public:
+    // Node geometry
+    static constexpr size_t BRANCHING = B != 0 ? B : btree_b_for<K, V>::value;
+    static constexpr size_t MIN_LEN = BRANCHING - 1;
+    static constexpr size_t MAX_LEN = 2 * BRANCHING - 1;
+    static constexpr size_t MAX_CHILDREN = 2 * BRANCHING;
+    
+    static_assert(BRANCHING >= 2, "B-tree branching factor must be at least 2");
+    static_assert(MAX_LEN <= 0xFFFF, "node length must fit in 16 bits");
+    
 private:
     // Forward declarations
     struct Node;
     struct InternalNode;
     struct LeafNode;
     
-    using NodePtr = std::unique_ptr<Node>;
     using KV = std::pair<K, V>;
     
-    // Base node structure
+    // Enables the heterogeneous lookup overloads for key-like types Q
+    template<typename Q>
+    using if_transparent = typename std::enable_if<
+        detail::is_transparent<Compare>::value && !std::is_same<Q, K>::value, int>::type;
+    
+    template<typename N>
+    static N* create_node(Alloc& alloc) {
+        void* mem = alloc_or_throw(alloc, sizeof(N), alignof(N));
+        detail::observe_alloc(AllocKind::BTreeMap, mem, sizeof(N));
+        return new (mem) N();
+    }
+    
+    // Free a node's memory; its keys, values and children must already
+    // be gone or owned elsewhere
+    static void deallocate_node(Alloc& alloc, Node* node) {
+        if (node->is_leaf) {
+            static_cast<LeafNode*>(node)->~LeafNode();
+            detail::observe_dealloc(AllocKind::BTreeMap, node, sizeof(LeafNode));
+            alloc.deallocate(node, sizeof(LeafNode), alignof(LeafNode));
+        } else {
+            static_cast<InternalNode*>(node)->~InternalNode();
+            detail::observe_dealloc(AllocKind::BTreeMap, node, sizeof(InternalNode));
+            alloc.deallocate(node, sizeof(InternalNode), alignof(InternalNode));
+        }
+    }
+    
+    // Drop a whole subtree
+    static void destroy_node(Alloc& alloc, Node* node) {
+        if (node->is_leaf) {
+            static_cast<LeafNode*>(node)->destroy_entries();
+        } else {
+            auto* internal = static_cast<InternalNode*>(node);
+            for (size_t i = 0; i <= internal->len; i++) {
+                destroy_node(alloc, internal->children[i]);
+            }
+            internal->destroy_keys();
+        }
+        deallocate_node(alloc, node);
+    }
+    
+    static constexpr bool trivially_copied() {
+        return std::is_trivially_copyable<K>::value && std::is_trivially_copyable<V>::value;
+    }
+    
+    // Copy a subtree node for node, keeping its shape. Leaves are linked
+    // after last_leaf in key order. On a throw nothing of the copy is left.
+    static Node* clone_node(Alloc& alloc, const Node* node, LeafNode*& last_leaf) {
+        if (node->is_leaf) {
+            const auto* src = static_cast<const LeafNode*>(node);
+            auto* leaf = create_node<LeafNode>(alloc);
+            if (trivially_copied()) {
+                std::memcpy(static_cast<void*>(leaf->keys.data()), src->keys.data(), src->len * sizeof(K));
+                std::memcpy(static_cast<void*>(leaf->values.data()), src->values.data(), src->len * sizeof(V));
+                leaf->len = src->len;
+            } else {
+                try {
+                    for (size_t i = 0; i < src->len; i++) {
+                        K key = detail::clone_value(src->keys[i]);
+                        new (leaf->values.data() + i) V(detail::clone_value(src->values[i]));
+                        new (leaf->keys.data() + i) K(std::move(key));
+                        leaf->len++;
+                    }
+                } catch (...) {
+                    destroy_node(alloc, leaf);
+                    throw;
+                }
+            }
+            leaf->prev = last_leaf;
+            if (last_leaf) last_leaf->next = leaf;
+            last_leaf = leaf;
+            return leaf;
+        }
+        
+        const auto* src = static_cast<const InternalNode*>(node);
+        auto* internal = create_node<InternalNode>(alloc);
+        bool has_children = false;
+        try {
+            internal->children[0] = clone_node(alloc, src->children[0], last_leaf);
+            has_children = true;
+            for (size_t i = 0; i < src->len; i++) {
+                K key = detail::clone_value(src->keys[i]);
+                Node* child = clone_node(alloc, src->children[i + 1], last_leaf);
+                new (internal->keys.data() + i) K(std::move(key));
+                internal->children[i + 1] = child;
+                internal->len++;
+            }
+        } catch (...) {
+            if (has_children) {
+                destroy_node(alloc, internal);
+            } else {
+                deallocate_node(alloc, internal);
+            }
+            throw;
+        }
+        return internal;
+    }
+    
+    // Node header shared by both node kinds. There is no vtable: is_leaf
+    // tags the node, and slots past len hold no objects, so K and V need
+    // not be default-constructible.
     struct Node {
-        K keys[BTREE_MAX_LEN];      // Keys array
-        size_t len;                  // Number of keys
+        uint16_t len;                // Number of keys
         bool is_leaf;                // Leaf or internal node
+        detail::UninitArray<K, MAX_LEN> keys;
+        
+        explicit Node(bool leaf) : len(0), is_leaf(leaf) {}
+        
+        // Position of the first key not less than key
+        template<typename Q>
+        size_t search_key(const Q& key, const Compare& comp) const {
+            return search_key(key, comp, detail::btree_linear_search<K, Compare, Q>());
+        }
         
-        Node(bool leaf) : len(0), is_leaf(leaf) {}
-        virtual ~Node() = default;
+        // Arithmetic keys: branchless count over the node
+        template<typename Q>
+        size_t search_key(const Q& key, const Compare&, std::true_type) const {
+            return detail::count_less(keys.data(), len, key);
+        }
         
         // Binary search for key position
-        size_t search_key(const K& key, const Compare& comp) const {
+        template<typename Q>
+        size_t search_key(const Q& key, const Compare& comp, std::false_type) const {
             size_t left = 0;
             size_t right = len;
             
@@ -65,78 +304,118 @@ private:
             return left;
         }
         
+        // Position of the first key greater than key, i.e. the edge whose
+        // subtree covers key
+        template<typename Q>
+        size_t search_edge(const Q& key, const Compare& comp) const {
+            return search_edge(key, comp, detail::btree_linear_search<K, Compare, Q>());
+        }
+        
+        template<typename Q>
+        size_t search_edge(const Q& key, const Compare&, std::true_type) const {
+            return detail::count_not_greater(keys.data(), len, key);
+        }
+        
+        template<typename Q>
+        size_t search_edge(const Q& key, const Compare& comp, std::false_type) const {
+            size_t left = 0;
+            size_t right = len;
+            
+            while (left < right) {
+                size_t mid = left + (right - left) / 2;
+                if (!comp(key, keys[mid])) {
+                    left = mid + 1;
+                } else {
+                    right = mid;
+                }
+            }
+            
+            return left;
+        }
+        
         // Check if key exists at position
-        bool key_at_pos_eq(size_t pos, const K& key, const Compare& comp) const {
+        template<typename Q>
+        bool key_at_pos_eq(size_t pos, const Q& key, const Compare& comp) const {
             return pos < len && !comp(keys[pos], key) && !comp(key, keys[pos]);
         }
         
-        bool is_full() const { return len >= BTREE_MAX_LEN; }
-        bool is_underfull() const { return len < BTREE_MIN_LEN; }
+        bool is_full() const { return len >= MAX_LEN; }
         
         // Insert key at position (assumes space available)
         void insert_key_at(size_t pos, K key) {
-            std::memmove(&keys[pos + 1], &keys[pos], (len - pos) * sizeof(K));
-            keys[pos] = std::move(key);
+            relocate_n(keys.data() + pos + 1, keys.data() + pos, len - pos);
+            new (keys.data() + pos) K(std::move(key));
             len++;
         }
         
         // Remove key at position
-        void remove_key_at(size_t pos) {
+        K take_key_at(size_t pos) {
+            K key(std::move(keys[pos]));
             keys[pos].~K();
-            std::memmove(&keys[pos], &keys[pos + 1], (len - pos - 1) * sizeof(K));
+            relocate_n(keys.data() + pos, keys.data() + pos + 1, len - pos - 1);
             len--;
+            return key;
+        }
+        
+        void destroy_keys() {
+            for (size_t i = 0; i < len; i++) {
+                keys[i].~K();
+            }
+            len = 0;
         }
     };
     
     // Leaf node - contains values
     struct LeafNode : Node {
-        V values[BTREE_MAX_LEN];     // Values array
+        detail::UninitArray<V, MAX_LEN> values;
         LeafNode* next;               // Next leaf for iteration
         LeafNode* prev;               // Previous leaf for iteration
         
         LeafNode() : Node(true), next(nullptr), prev(nullptr) {}
         
-        ~LeafNode() = default;
-        
         // Insert key-value at position
         void insert_at(size_t pos, K key, V value) {
-            // Shift values - can't use memmove for non-trivial types
-            for (size_t i = this->len; i > pos; i--) {
-                values[i] = std::move(values[i - 1]);
-            }
-            values[pos] = std::move(value);
-            
-            // Insert key
+            relocate_n(values.data() + pos + 1, values.data() + pos, this->len - pos);
+            new (values.data() + pos) V(std::move(value));
             this->insert_key_at(pos, std::move(key));
         }
         
         // Remove at position
-        V remove_at(size_t pos) {
-            V value = std::move(values[pos]);
-            // Shift values left - can't use memmove for non-trivial types
-            for (size_t i = pos; i < this->len - 1; i++) {
-                values[i] = std::move(values[i + 1]);
+        KV remove_at(size_t pos) {
+            V value(std::move(values[pos]));
+            values[pos].~V();
+            relocate_n(values.data() + pos, values.data() + pos + 1, this->len - pos - 1);
+            K key = this->take_key_at(pos);
+            return KV(std::move(key), std::move(value));
+        }
+        
+        // Move entries [from, len) to the end of dst
+        void move_entries_to(LeafNode* dst, size_t from) {
+            size_t count = this->len - from;
+            relocate_n(dst->keys.data() + dst->len, this->keys.data() + from, count);
+            relocate_n(dst->values.data() + dst->len, values.data() + from, count);
+            dst->len += count;
+            this->len = from;
+        }
+        
+        void destroy_entries() {
+            for (size_t i = 0; i < this->len; i++) {
+                values[i].~V();
             }
-            
-            this->remove_key_at(pos);
-            return value;
+            this->destroy_keys();
         }
         
         // Split leaf node (returns new right node and median key)
-        std::pair<LeafNode*, K> split() {
+        std::pair<LeafNode*, K> split(Alloc& alloc) {
             size_t mid = this->len / 2;
-            auto* right = new LeafNode();
+            auto* right = create_node<LeafNode>(alloc);
             
             // Move right half to new node (including the element at mid)
-            right->len = this->len - mid;
-            for (size_t i = 0; i < right->len; i++) {
-                right->keys[i] = std::move(this->keys[mid + i]);
-                right->values[i] = std::move(this->values[mid + i]);
-            }
+            move_entries_to(right, mid);
             
-            // The median key that goes up to parent is the first key of right node
-            K median = right->keys[0];
-            this->len = mid;
+            // The separator that goes up to the parent is a copy of the
+            // right node's first key
+            K median = detail::clone_value(right->keys[0]);
             
             // Update linked list pointers
             right->next = this->next;
@@ -146,102 +425,77 @@ private:
             }
             this->next = right;
             
-            return {right, median};
-        }
-        
-        // Merge with right sibling
-        void merge_with_right(LeafNode* right, const K& parent_key) {
-            // Copy all entries from right
-            for (size_t i = 0; i < right->len; i++) {
-                this->keys[this->len + i] = std::move(right->keys[i]);
-                this->values[this->len + i] = std::move(right->values[i]);
-            }
-            this->len += right->len;
-            
-            // Update linked list
-            this->next = right->next;
-            if (right->next) {
-                right->next->prev = this;
-            }
+            return {right, std::move(median)};
         }
     };
     
     // Internal node - contains child pointers
     struct InternalNode : Node {
-        NodePtr children[BTREE_MAX_CHILDREN];  // Child pointers
+        Node* children[MAX_CHILDREN];  // Owned; len + 1 are live
         
         InternalNode() : Node(false) {}
         
         // Insert key and right child at position
-        void insert_at(size_t pos, K key, NodePtr right_child) {
-            // Shift children - can't use memmove with unique_ptr
-            for (size_t i = this->len; i > pos; i--) {
-                children[i + 1] = std::move(children[i]);
-            }
-            children[pos + 1] = std::move(right_child);
-            
-            // Insert key
+        void insert_at(size_t pos, K key, Node* right_child) {
+            std::memmove(&children[pos + 2], &children[pos + 1],
+                         (this->len - pos) * sizeof(Node*));
+            children[pos + 1] = right_child;
             this->insert_key_at(pos, std::move(key));
         }
         
+        // Remove key at position and the child to its right
+        K remove_at(size_t pos) {
+            std::memmove(&children[pos + 1], &children[pos + 2],
+                         (this->len - pos - 1) * sizeof(Node*));
+            return this->take_key_at(pos);
+        }
+        
         // Split internal node
-        std::pair<InternalNode*, K> split() {
+        std::pair<InternalNode*, K> split(Alloc& alloc) {
             size_t mid = this->len / 2;
-            auto* right = new InternalNode();
+            auto* right = create_node<InternalNode>(alloc);
             
-            // Move right half keys to new node
+            // Move right half keys and children to new node
             right->len = this->len - mid - 1;
-            for (size_t i = 0; i < right->len; i++) {
-                right->keys[i] = std::move(this->keys[mid + 1 + i]);
-            }
-            
-            // Move right half children to new node
-            for (size_t i = 0; i <= right->len; i++) {
-                right->children[i] = std::move(this->children[mid + 1 + i]);
-            }
+            relocate_n(right->keys.data(), this->keys.data() + mid + 1, right->len);
+            std::memcpy(&right->children[0], &children[mid + 1],
+                        (right->len + 1) * sizeof(Node*));
             
-            K median = std::move(this->keys[mid]);
+            K median(std::move(this->keys[mid]));
+            this->keys[mid].~K();
             this->len = mid;
             
-            return {right, median};
+            return {right, std::move(median)};
         }
         
-        // Merge with right sibling
-        void merge_with_right(InternalNode* right, const K& parent_key) {
-            // Add parent key
-            this->keys[this->len] = parent_key;
+        // Merge with right sibling, pulling the parent key down between them
+        void merge_with_right(InternalNode* right, K parent_key) {
+            new (this->keys.data() + this->len) K(std::move(parent_key));
             this->len++;
             
-            // Copy keys from right
-            for (size_t i = 0; i < right->len; i++) {
-                this->keys[this->len + i] = std::move(right->keys[i]);
-            }
-            
-            // Copy children from right
-            for (size_t i = 0; i <= right->len; i++) {
-                this->children[this->len + i] = std::move(right->children[i]);
-            }
+            relocate_n(this->keys.data() + this->len, right->keys.data(), right->len);
+            std::memcpy(&children[this->len], &right->children[0],
+                        (right->len + 1) * sizeof(Node*));
             
             this->len += right->len;
+            right->len = 0;
         }
         
         // Borrow from left sibling
         void borrow_from_left(InternalNode* left, K& parent_key) {
             // Shift everything right
-            std::memmove(&this->keys[1], &this->keys[0], this->len * sizeof(K));
-            // Can't use memmove with unique_ptr
-            for (size_t i = this->len; i > 0; i--) {
-                this->children[i] = std::move(this->children[i - 1]);
-            }
+            relocate_n(this->keys.data() + 1, this->keys.data(), this->len);
+            std::memmove(&children[1], &children[0], (this->len + 1) * sizeof(Node*));
             
             // Move parent key down
-            this->keys[0] = std::move(parent_key);
+            new (this->keys.data()) K(std::move(parent_key));
             
             // Move last key from left up to parent
             parent_key = std::move(left->keys[left->len - 1]);
+            left->keys[left->len - 1].~K();
             
             // Move last child from left
-            this->children[0] = std::move(left->children[left->len]);
+            children[0] = left->children[left->len];
             
             this->len++;
             left->len--;
@@ -250,21 +504,19 @@ private:
         // Borrow from right sibling
         void borrow_from_right(InternalNode* right, K& parent_key) {
             // Move parent key down
-            this->keys[this->len] = std::move(parent_key);
+            new (this->keys.data() + this->len) K(std::move(parent_key));
+            
+            // Move first child from right
+            children[this->len + 1] = right->children[0];
             
             // Move first key from right up to parent
             parent_key = std::move(right->keys[0]);
-            
-            // Move first child from right
-            this->children[this->len + 1] = std::move(right->children[0]);
+            right->keys[0].~K();
             
             // Shift right node left
-            std::memmove(&right->keys[0], &right->keys[1], 
-                        (right->len - 1) * sizeof(K));
-            // Can't use memmove with unique_ptr
-            for (size_t i = 0; i < right->len; i++) {
-                right->children[i] = std::move(right->children[i + 1]);
-            }
+            relocate_n(right->keys.data(), right->keys.data() + 1, right->len - 1);
+            std::memmove(&right->children[0], &right->children[1],
+                         right->len * sizeof(Node*));
             
             this->len++;
             right->len--;
@@ -272,39 +524,83 @@ private:
     };
     
     // Member variables
-    NodePtr root_;
+    Node* root_;            // Owned; null only after a move
     size_t size_;
     Compare comp_;
     LeafNode* first_leaf_;  // For iteration
     LeafNode* last_leaf_;   // For reverse iteration
+    // append_max() leaves the nodes on the right border short until the
+    // next removal or split_off, which rebalance it first (settle_border)
+    bool border_short_;
+    
+    void init_root() {
+        auto* root = create_node<LeafNode>(this->alloc());
+        root_ = root;
+        first_leaf_ = last_leaf_ = root;
+    }
     
-    // Helper: Insert into non-full node
-    Option<V> insert_into_node(Node* node, K key, V value) {
+    void destroy_tree() {
+        if (root_) {
+            destroy_node(this->alloc(), root_);
+            root_ = nullptr;
+        }
+        first_leaf_ = last_leaf_ = nullptr;
+        size_ = 0;
+        border_short_ = false;
+    }
+    
+    // Restore MIN_LEN along the right border after append_max()
+    void settle_border() {
+        if (border_short_) {
+            fix_right_border();
+            border_short_ = false;
+        }
+    }
+    
+    static void count_nodes(const Node* node, size_t level, stats::BTreeStats& s) {
+        if (level > s.depth) s.depth = level;
         if (node->is_leaf) {
-            auto* leaf = static_cast<LeafNode*>(node);
-            size_t pos = node->search_key(key, comp_);
-            
-            if (node->key_at_pos_eq(pos, key, comp_)) {
-                // Key exists, update value
-                V old = std::move(leaf->values[pos]);
-                leaf->values[pos] = std::move(value);
-                return Some(std::move(old));
-            } else {
-                // Insert new entry
-                leaf->insert_at(pos, std::move(key), std::move(value));
-                size_++;
-                return None;
-            }
-        } else {
+            s.leaf_nodes++;
+            s.leaf_keys += node->len;
+            return;
+        }
+        s.internal_nodes++;
+        s.internal_keys += node->len;
+        const InternalNode* internal = static_cast<const InternalNode*>(node);
+        for (size_t i = 0; i <= node->len; i++) count_nodes(internal->children[i], level + 1, s);
+    }
+    
+    // Index of the child whose range contains key
+    template<typename Q>
+    size_t child_index(const InternalNode* node, const Q& key) const {
+        return node->search_edge(key, comp_);
+    }
+    
+    // insert(), also reporting the leaf and slot the entry ended up in
+    Option<V> insert_locating(K key, V value, std::pair<LeafNode*, size_t>& where) {
+        if (!root_) {
+            init_root();  // Reuse after a move
+        }
+        
+        if (root_->is_full()) {
+            // Split root
+            auto* new_root = create_node<InternalNode>(this->alloc());
+            new_root->children[0] = root_;
+            root_ = new_root;
+            split_child(new_root, 0);
+        }
+        
+        return insert_into_node(root_, std::move(key), std::move(value), where);
+    }
+    
+    // Helper: Insert into non-full node; where is set to the entry's place
+    Option<V> insert_into_node(Node* node, K key, V value, std::pair<LeafNode*, size_t>& where) {
+        while (!node->is_leaf) {
             auto* internal = static_cast<InternalNode*>(node);
             
-            // Find which child to recurse to
-            size_t child_idx = 0;
-            while (child_idx < internal->len && !comp_(key, internal->keys[child_idx])) {
-                child_idx++;
-            }
-            
-            Node* child = internal->children[child_idx].get();
+            // Find which child to descend to
+            size_t child_idx = child_index(internal, key);
+            Node* child = internal->children[child_idx];
             
             if (child->is_full()) {
                 // Split child first
@@ -314,126 +610,144 @@ private:
                 if (child_idx < internal->len && !comp_(key, internal->keys[child_idx])) {
                     child_idx++;
                 }
-                child = internal->children[child_idx].get();
+                child = internal->children[child_idx];
             }
             
-            return insert_into_node(child, std::move(key), std::move(value));
+            node = child;
+        }
+        
+        auto* leaf = static_cast<LeafNode*>(node);
+        size_t pos = node->search_key(key, comp_);
+        where = {leaf, pos};
+        
+        if (node->key_at_pos_eq(pos, key, comp_)) {
+            // Key exists, update value
+            V old = std::move(leaf->values[pos]);
+            leaf->values[pos] = std::move(value);
+            return Some(std::move(old));
         }
+        
+        // Insert new entry
+        leaf->insert_at(pos, std::move(key), std::move(value));
+        size_++;
+        return None;
     }
     
     // Split child node at position
     void split_child(InternalNode* parent, size_t child_idx) {
-        Node* child = parent->children[child_idx].get();
+        Node* child = parent->children[child_idx];
         
         if (child->is_leaf) {
             auto* leaf = static_cast<LeafNode*>(child);
-            auto [new_right, median] = leaf->split();
-            parent->insert_at(child_idx, std::move(median), 
-                            NodePtr(new_right));
+            auto [new_right, median] = leaf->split(this->alloc());
+            if (last_leaf_ == leaf) {
+                last_leaf_ = new_right;
+            }
+            parent->insert_at(child_idx, std::move(median), new_right);
         } else {
             auto* internal = static_cast<InternalNode*>(child);
-            auto [new_right, median] = internal->split();
-            parent->insert_at(child_idx, std::move(median), 
-                            NodePtr(new_right));
+            auto [new_right, median] = internal->split(this->alloc());
+            parent->insert_at(child_idx, std::move(median), new_right);
         }
     }
     
-    // Find node containing key
-    std::pair<Node*, size_t> find_node(const K& key) const {
-        Node* node = root_.get();
+    // Find node containing key (Q is K, or any type a transparent Compare accepts)
+    template<typename Q>
+    std::pair<LeafNode*, size_t> find_node(const Q& key) const {
+        Node* node = root_;
+        if (!node) {
+            return {nullptr, 0};
+        }
         
-        while (node) {
-            if (node->is_leaf) {
-                size_t pos = node->search_key(key, comp_);
-                if (node->key_at_pos_eq(pos, key, comp_)) {
-                    return {node, pos};
-                }
-                return {nullptr, 0};
-            }
-            
+        while (!node->is_leaf) {
             auto* internal = static_cast<InternalNode*>(node);
-            
-            // Find which child to descend to
-            size_t child_idx = 0;
-            while (child_idx < internal->len && !comp_(key, internal->keys[child_idx])) {
-                child_idx++;
-            }
-            node = internal->children[child_idx].get();
+            node = internal->children[child_index(internal, key)];
         }
         
+        size_t pos = node->search_key(key, comp_);
+        if (node->key_at_pos_eq(pos, key, comp_)) {
+            return {static_cast<LeafNode*>(node), pos};
+        }
         return {nullptr, 0};
     }
     
-    // Remove from node (complex - handles rebalancing)
-    Option<V> remove_from_node(Node* node, const K& key) {
-        if (node->is_leaf) {
-            auto* leaf = static_cast<LeafNode*>(node);
-            size_t pos = node->search_key(key, comp_);
-            
-            if (node->key_at_pos_eq(pos, key, comp_)) {
-                V value = leaf->remove_at(pos);
-                size_--;
-                return Some(std::move(value));
-            }
-            return None;
+    template<typename Q>
+    Option<V&> get_impl(const Q& key) {
+        auto [leaf, pos] = find_node(key);
+        if (leaf) {
+            return Option<V&>(leaf->values[pos]);
         }
-        
-        auto* internal = static_cast<InternalNode*>(node);
-        
-        // Find which child to recurse to
-        size_t child_idx = 0;
-        while (child_idx < internal->len && !comp_(key, internal->keys[child_idx])) {
-            child_idx++;
+        return None;
+    }
+    
+    template<typename Q>
+    Option<const V&> get_const_impl(const Q& key) const {
+        auto [leaf, pos] = find_node(key);
+        if (leaf) {
+            return Option<const V&>(leaf->values[pos]);
         }
-        
-        Node* child = internal->children[child_idx].get();
-        
-        // Ensure child has enough keys (unless it's the root)
-        if (child != root_.get() && child->is_underfull()) {
-            fix_underfull_child(internal, child_idx);
-            // After fix, recompute which child to use
-            child_idx = 0;
-            while (child_idx < internal->len && !comp_(key, internal->keys[child_idx])) {
-                child_idx++;
-            }
-            if (child_idx <= internal->len) {
-                child = internal->children[child_idx].get();
-            } else {
+        return None;
+    }
+    
+    template<typename Q>
+    Option<KV> remove_impl(const Q& key) {
+        return remove_where(
+            [&](const InternalNode* node) { return child_index(node, key); },
+            [&](const LeafNode* leaf) -> Option<size_t> {
+                size_t pos = leaf->search_key(key, comp_);
+                if (leaf->key_at_pos_eq(pos, key, comp_)) {
+                    return Some(pos);
+                }
                 return None;
-            }
-        }
-        
-        return remove_from_node(child, key);
+            });
     }
     
-    // Remove key from internal node
-    Option<V> remove_internal_key(InternalNode* node, size_t pos) {
-        // Replace with predecessor from left subtree
-        Node* left_child = node->children[pos].get();
+    // Remove one entry in a single top-down pass. child_of picks the edge
+    // to follow in each internal node and slot_of the entry in the leaf.
+    // Every node entered has more than the minimum number of keys (it is
+    // refilled from a sibling first), so the removal never needs to walk
+    // back up the tree.
+    template<typename ChildFn, typename SlotFn>
+    Option<KV> remove_where(ChildFn child_of, SlotFn slot_of) {
+        if (size_ == 0) return None;
+        settle_border();
         
-        if (left_child->is_leaf) {
-            auto* leaf = static_cast<LeafNode*>(left_child);
-            if (leaf->len > BTREE_MIN_LEN) {
-                // Take last element from left child
-                size_t last = leaf->len - 1;
-                node->keys[pos] = std::move(leaf->keys[last]);
-                V value = leaf->remove_at(last);
-                size_--;
-                return Some(std::move(value));
+        Node* node = root_;
+        while (!node->is_leaf) {
+            auto* internal = static_cast<InternalNode*>(node);
+            size_t child_idx = child_of(internal);
+            
+            if (internal->children[child_idx]->len <= MIN_LEN) {
+                fix_underfull_child(internal, child_idx);
+                child_idx = child_of(internal);
             }
+            node = internal->children[child_idx];
+        }
+        
+        Option<KV> result = None;
+        auto* leaf = static_cast<LeafNode*>(node);
+        auto pos = slot_of(leaf);
+        if (pos.is_some()) {
+            result = Option<KV>(leaf->remove_at(pos.unwrap()));
+            size_--;
         }
         
-        // Complex case - need to restructure
-        // For simplicity, convert to leaf operation
-        return remove_from_node(left_child, node->keys[pos]);
+        // Merges may have left the root with a single child
+        while (!root_->is_leaf && root_->len == 0) {
+            Node* old_root = root_;
+            root_ = static_cast<InternalNode*>(old_root)->children[0];
+            deallocate_node(this->alloc(), old_root);
+        }
+        
+        return result;
     }
     
     // Fix underfull child by borrowing or merging
     void fix_underfull_child(InternalNode* parent, size_t child_idx) {
         // Try to borrow from left sibling
         if (child_idx > 0) {
-            Node* left = parent->children[child_idx - 1].get();
-            if (left->len > BTREE_MIN_LEN) {
+            Node* left = parent->children[child_idx - 1];
+            if (left->len > MIN_LEN) {
                 borrow_from_left_sibling(parent, child_idx);
                 return;
             }
@@ -441,8 +755,8 @@ private:
         
         // Try to borrow from right sibling
         if (child_idx < parent->len) {
-            Node* right = parent->children[child_idx + 1].get();
-            if (right->len > BTREE_MIN_LEN) {
+            Node* right = parent->children[child_idx + 1];
+            if (right->len > MIN_LEN) {
                 borrow_from_right_sibling(parent, child_idx);
                 return;
             }
@@ -459,19 +773,18 @@ private:
     // Borrow from left sibling
     void borrow_from_left_sibling(InternalNode* parent, size_t child_idx) {
         if (parent->children[child_idx]->is_leaf) {
-            auto* child = static_cast<LeafNode*>(parent->children[child_idx].get());
-            auto* left = static_cast<LeafNode*>(parent->children[child_idx - 1].get());
+            auto* child = static_cast<LeafNode*>(parent->children[child_idx]);
+            auto* left = static_cast<LeafNode*>(parent->children[child_idx - 1]);
             
             // Move last element from left to beginning of child
-            child->insert_at(0, std::move(left->keys[left->len - 1]),
-                           std::move(left->values[left->len - 1]));
-            left->len--;
+            KV kv = left->remove_at(left->len - 1);
+            child->insert_at(0, std::move(kv.first), std::move(kv.second));
             
             // Update parent key
-            parent->keys[child_idx - 1] = child->keys[0];
+            parent->keys[child_idx - 1] = detail::clone_value(child->keys[0]);
         } else {
-            auto* child = static_cast<InternalNode*>(parent->children[child_idx].get());
-            auto* left = static_cast<InternalNode*>(parent->children[child_idx - 1].get());
+            auto* child = static_cast<InternalNode*>(parent->children[child_idx]);
+            auto* left = static_cast<InternalNode*>(parent->children[child_idx - 1]);
             child->borrow_from_left(left, parent->keys[child_idx - 1]);
         }
     }
@@ -479,141 +792,614 @@ private:
     // Borrow from right sibling
     void borrow_from_right_sibling(InternalNode* parent, size_t child_idx) {
         if (parent->children[child_idx]->is_leaf) {
-            auto* child = static_cast<LeafNode*>(parent->children[child_idx].get());
-            auto* right = static_cast<LeafNode*>(parent->children[child_idx + 1].get());
+            auto* child = static_cast<LeafNode*>(parent->children[child_idx]);
+            auto* right = static_cast<LeafNode*>(parent->children[child_idx + 1]);
             
             // Move first element from right to end of child
-            child->insert_at(child->len, std::move(right->keys[0]),
-                           std::move(right->values[0]));
-            right->remove_at(0);
+            KV kv = right->remove_at(0);
+            child->insert_at(child->len, std::move(kv.first), std::move(kv.second));
             
             // Update parent key
-            parent->keys[child_idx] = right->keys[0];
+            parent->keys[child_idx] = detail::clone_value(right->keys[0]);
         } else {
-            auto* child = static_cast<InternalNode*>(parent->children[child_idx].get());
-            auto* right = static_cast<InternalNode*>(parent->children[child_idx + 1].get());
+            auto* child = static_cast<InternalNode*>(parent->children[child_idx]);
+            auto* right = static_cast<InternalNode*>(parent->children[child_idx + 1]);
             child->borrow_from_right(right, parent->keys[child_idx]);
         }
     }
     
     // Merge child with right sibling
     void merge_with_right_sibling(InternalNode* parent, size_t child_idx) {
-        if (parent->children[child_idx]->is_leaf) {
-            auto* left = static_cast<LeafNode*>(parent->children[child_idx].get());
-            auto* right = static_cast<LeafNode*>(parent->children[child_idx + 1].get());
-            left->merge_with_right(right, parent->keys[child_idx]);
-        } else {
-            auto* left = static_cast<InternalNode*>(parent->children[child_idx].get());
-            auto* right = static_cast<InternalNode*>(parent->children[child_idx + 1].get());
-            left->merge_with_right(right, parent->keys[child_idx]);
-        }
+        Node* right_node = parent->children[child_idx + 1];
         
         // Remove key and right child from parent
-        parent->remove_key_at(child_idx);
-        // Shift children left - can't use memmove with unique_ptr
-        for (size_t i = child_idx + 1; i <= parent->len; i++) {
-            parent->children[i] = std::move(parent->children[i + 1]);
+        K parent_key = parent->remove_at(child_idx);
+        
+        if (right_node->is_leaf) {
+            auto* left = static_cast<LeafNode*>(parent->children[child_idx]);
+            auto* right = static_cast<LeafNode*>(right_node);
+            right->move_entries_to(left, 0);
+            
+            // Update linked list
+            left->next = right->next;
+            if (right->next) {
+                right->next->prev = left;
+            } else {
+                last_leaf_ = left;
+            }
+        } else {
+            auto* left = static_cast<InternalNode*>(parent->children[child_idx]);
+            auto* right = static_cast<InternalNode*>(right_node);
+            left->merge_with_right(right, std::move(parent_key));
         }
+        
+        deallocate_node(this->alloc(), right_node);
     }
     
-public:
-    // Constructors
-    BTreeMap() : size_(0), first_leaf_(nullptr), last_leaf_(nullptr) {
-        auto* root = new LeafNode();
-        root_ = NodePtr(root);
-        first_leaf_ = last_leaf_ = root;
+    // Whether two adjacent siblings fit in one node
+    static bool can_merge(const Node* left, const Node* right) {
+        return size_t(left->len) + right->len + (left->is_leaf ? 0 : 1) <= MAX_LEN;
     }
     
-    // @lifetime: owned
-    static BTreeMap new_() {
-        return BTreeMap();
+    // Move count entries from the end of children[i - 1] to the front of
+    // children[i], rotating through the separator for internal nodes
+    void steal_from_left(InternalNode* parent, size_t i, size_t count) {
+        if (parent->children[i]->is_leaf) {
+            auto* left = static_cast<LeafNode*>(parent->children[i - 1]);
+            auto* right = static_cast<LeafNode*>(parent->children[i]);
+            relocate_n(right->keys.data() + count, right->keys.data(), right->len);
+            relocate_n(right->values.data() + count, right->values.data(), right->len);
+            relocate_n(right->keys.data(), left->keys.data() + left->len - count, count);
+            relocate_n(right->values.data(), left->values.data() + left->len - count, count);
+            left->len -= count;
+            right->len += count;
+            parent->keys[i - 1] = detail::clone_value(right->keys[0]);
+        } else {
+            auto* left = static_cast<InternalNode*>(parent->children[i - 1]);
+            auto* right = static_cast<InternalNode*>(parent->children[i]);
+            relocate_n(right->keys.data() + count, right->keys.data(), right->len);
+            std::memmove(&right->children[count], &right->children[0],
+                         (right->len + 1) * sizeof(Node*));
+            
+            // The separator comes down behind the keys taken from left
+            new (right->keys.data() + count - 1) K(std::move(parent->keys[i - 1]));
+            relocate_n(right->keys.data(), left->keys.data() + left->len - count + 1, count - 1);
+            std::memcpy(&right->children[0], &left->children[left->len - count + 1],
+                        count * sizeof(Node*));
+            parent->keys[i - 1] = std::move(left->keys[left->len - count]);
+            left->keys[left->len - count].~K();
+            left->len -= count;
+            right->len += count;
+        }
     }
     
-    // Move constructor
-    BTreeMap(BTreeMap&& other) noexcept
-        : root_(std::move(other.root_)), size_(other.size_),
-          comp_(std::move(other.comp_)),
-          first_leaf_(other.first_leaf_), last_leaf_(other.last_leaf_) {
-        other.size_ = 0;
-        other.first_leaf_ = other.last_leaf_ = nullptr;
+    // Move count entries from the front of children[i + 1] to the end of
+    // children[i]
+    void steal_from_right(InternalNode* parent, size_t i, size_t count) {
+        if (parent->children[i]->is_leaf) {
+            auto* left = static_cast<LeafNode*>(parent->children[i]);
+            auto* right = static_cast<LeafNode*>(parent->children[i + 1]);
+            relocate_n(left->keys.data() + left->len, right->keys.data(), count);
+            relocate_n(left->values.data() + left->len, right->values.data(), count);
+            relocate_n(right->keys.data(), right->keys.data() + count, right->len - count);
+            relocate_n(right->values.data(), right->values.data() + count, right->len - count);
+            left->len += count;
+            right->len -= count;
+            parent->keys[i] = detail::clone_value(right->keys[0]);
+        } else {
+            auto* left = static_cast<InternalNode*>(parent->children[i]);
+            auto* right = static_cast<InternalNode*>(parent->children[i + 1]);
+            new (left->keys.data() + left->len) K(std::move(parent->keys[i]));
+            relocate_n(left->keys.data() + left->len + 1, right->keys.data(), count - 1);
+            std::memcpy(&left->children[left->len + 1], &right->children[0],
+                        count * sizeof(Node*));
+            parent->keys[i] = std::move(right->keys[count - 1]);
+            right->keys[count - 1].~K();
+            relocate_n(right->keys.data(), right->keys.data() + count, right->len - count);
+            std::memmove(&right->children[0], &right->children[count],
+                         (right->len - count + 1) * sizeof(Node*));
+            left->len += count;
+            right->len -= count;
+        }
     }
     
-    // Move assignment
-    BTreeMap& operator=(BTreeMap&& other) noexcept {
-        if (this != &other) {
-            root_ = std::move(other.root_);
-            size_ = other.size_;
-            comp_ = std::move(other.comp_);
-            first_leaf_ = other.first_leaf_;
-            last_leaf_ = other.last_leaf_;
-            
-            other.size_ = 0;
-            other.first_leaf_ = other.last_leaf_ = nullptr;
+    // Drop internal roots that are left with a single child
+    void fix_top() {
+        while (!root_->is_leaf && root_->len == 0) {
+            Node* old_root = root_;
+            root_ = static_cast<InternalNode*>(old_root)->children[0];
+            deallocate_node(this->alloc(), old_root);
         }
-        return *this;
     }
     
-    // Delete copy operations
-    BTreeMap(const BTreeMap&) = delete;
-    BTreeMap& operator=(const BTreeMap&) = delete;
-    
-    // Destructor
-    ~BTreeMap() = default;
-    
-    // Size
-    size_t len() const { return size_; }
-    bool is_empty() const { return size_ == 0; }
-    
-    // Insert
-    Option<V> insert(K key, V value) {
-        if (root_->is_full()) {
-            // Split root
-            auto* new_root = new InternalNode();
-            NodePtr old_root = std::move(root_);
-            
-            if (old_root->is_leaf) {
-                auto* leaf = static_cast<LeafNode*>(old_root.get());
-                auto [new_right, median] = leaf->split();
-                
-                new_root->keys[0] = std::move(median);
-                new_root->children[0] = std::move(old_root);
-                new_root->children[1] = NodePtr(new_right);
-                new_root->len = 1;
+    // After split_off the nodes along the cut may be short or even empty,
+    // while every other node still has at least MIN_LEN keys. Walk down
+    // the cut merging each border node into its inner sibling, or topping
+    // it up to MIN_LEN + 1 when both do not fit in one node, so a merge one
+    // level down still leaves it at MIN_LEN (Rust: fix_right_border).
+    void fix_right_border() {
+        fix_top();
+        Node* node = root_;
+        while (!node->is_leaf) {
+            auto* parent = static_cast<InternalNode*>(node);
+            size_t i = parent->len;
+            Node* child = parent->children[i];
+            if (can_merge(parent->children[i - 1], child)) {
+                merge_with_right_sibling(parent, i - 1);
+                node = parent->children[i - 1];
             } else {
-                auto* internal = static_cast<InternalNode*>(old_root.get());
-                auto [new_right, median] = internal->split();
-                
-                new_root->keys[0] = std::move(median);
-                new_root->children[0] = std::move(old_root);
-                new_root->children[1] = NodePtr(new_right);
-                new_root->len = 1;
+                if (child->len < MIN_LEN + 1) {
+                    steal_from_left(parent, i, MIN_LEN + 1 - child->len);
+                }
+                node = child;
+            }
+        }
+        fix_top();
+    }
+    
+    void fix_left_border() {
+        fix_top();
+        Node* node = root_;
+        while (!node->is_leaf) {
+            auto* parent = static_cast<InternalNode*>(node);
+            Node* child = parent->children[0];
+            if (can_merge(child, parent->children[1])) {
+                merge_with_right_sibling(parent, 0);
+            } else if (child->len < MIN_LEN + 1) {
+                steal_from_right(parent, 0, MIN_LEN + 1 - child->len);
+            }
+            node = parent->children[0];
+        }
+        fix_top();
+    }
+    
+    // Start a new last leaf holding just key, for append_max() when the
+    // last leaf is full. It is linked along the right spine, where each
+    // full node gets a new right sibling with a single edge in turn (and a
+    // full root a new root), so every full node stays full. The new nodes
+    // are short until settle_border().
+    void push_right_leaf(K key, V value) {
+        InternalNode* spine[64];
+        size_t height = 0;
+        for (Node* node = root_; !node->is_leaf; node = spine[height - 1]->children[node->len]) {
+            spine[height++] = static_cast<InternalNode*>(node);
+        }
+        size_t full = 0;
+        while (full < height && spine[height - 1 - full]->is_full()) {
+            full++;
+        }
+        bool new_root = full == height;
+        
+        // Allocate everything first, so a failure leaves the map unchanged
+        K separator = detail::clone_value(key);
+        Node* fresh[65];
+        size_t needed = full + (new_root ? 1 : 0);
+        size_t made = 0;
+        auto* leaf = create_node<LeafNode>(this->alloc());
+        try {
+            for (; made < needed; made++) {
+                fresh[made] = create_node<InternalNode>(this->alloc());
+            }
+        } catch (...) {
+            for (size_t i = 0; i < made; i++) {
+                deallocate_node(this->alloc(), fresh[i]);
+            }
+            deallocate_node(this->alloc(), leaf);
+            throw;
+        }
+        
+        leaf->insert_at(0, std::move(key), std::move(value));
+        leaf->prev = last_leaf_;
+        last_leaf_->next = leaf;
+        last_leaf_ = leaf;
+        
+        // The new subtree's smallest key is key at every level, so one
+        // separator serves wherever the subtree is finally attached
+        Node* child = leaf;
+        for (size_t i = 0; i < full; i++) {
+            auto* sibling = static_cast<InternalNode*>(fresh[i]);
+            sibling->children[0] = child;
+            child = sibling;
+        }
+        if (new_root) {
+            auto* root = static_cast<InternalNode*>(fresh[full]);
+            root->children[0] = root_;
+            root->insert_at(0, std::move(separator), child);
+            root_ = root;
+        } else {
+            InternalNode* parent = spine[height - 1 - full];
+            parent->insert_at(parent->len, std::move(separator), child);
+        }
+        size_++;
+        border_short_ = true;
+    }
+    
+    // Tag for building a map whose tree is filled in afterwards
+    struct NoRoot {};
+    
+    BTreeMap(NoRoot, const Alloc& alloc)
+        : detail::AllocHolder<Alloc>(alloc), root_(nullptr), size_(0),
+          first_leaf_(nullptr), last_leaf_(nullptr), border_short_(false) {}
+    
+    // Builds a tree bottom-up from entries pushed in increasing key order:
+    // leaves are filled completely, then each internal level is made by
+    // spreading the level below evenly over as few nodes as possible.
+    class BulkBuilder {
+    private:
+        BTreeMap* map_;
+        Vec<Node*> leaves_;
+        LeafNode* leaf_;
+        size_t count_;
+        
+    public:
+        explicit BulkBuilder(BTreeMap* map) : map_(map), leaf_(nullptr), count_(0) {}
+        
+        // @lifetime: (&'a) -> &'a
+        const K* last_key() const {
+            return leaf_ ? &leaf_->keys[leaf_->len - 1] : nullptr;
+        }
+        
+        void push(K key, V value) {
+            if (!leaf_ || leaf_->len == MAX_LEN) {
+                auto* leaf = create_node<LeafNode>(map_->alloc());
+                leaf->prev = leaf_;
+                if (leaf_) {
+                    leaf_->next = leaf;
+                }
+                leaf_ = leaf;
+                leaves_.push(leaf);
+            }
+            new (leaf_->keys.data() + leaf_->len) K(std::move(key));
+            new (leaf_->values.data() + leaf_->len) V(std::move(value));
+            leaf_->len++;
+            count_++;
+        }
+        
+        void replace_last_value(V value) {
+            leaf_->values[leaf_->len - 1] = std::move(value);
+        }
+        
+        // Hand the finished tree to the map, whose tree must be empty
+        void finish() {
+            if (leaves_.len() == 0) {
+                map_->init_root();
+                return;
+            }
+            
+            // Only the last leaf can be short; top it up from its neighbour
+            size_t leaf_count = leaves_.len();
+            if (leaf_count > 1 && leaf_->len < MIN_LEN) {
+                auto* prev = static_cast<LeafNode*>(leaves_[leaf_count - 2]);
+                size_t moved = (prev->len + leaf_->len) / 2 - leaf_->len;
+                relocate_n(leaf_->keys.data() + moved, leaf_->keys.data(), leaf_->len);
+                relocate_n(leaf_->values.data() + moved, leaf_->values.data(), leaf_->len);
+                relocate_n(leaf_->keys.data(), prev->keys.data() + prev->len - moved, moved);
+                relocate_n(leaf_->values.data(), prev->values.data() + prev->len - moved, moved);
+                prev->len -= moved;
+                leaf_->len += moved;
+            }
+            
+            // Smallest key below each node of the current level
+            Vec<Node*> level = std::move(leaves_);
+            Vec<const K*> mins = Vec<const K*>::with_capacity(level.len());
+            for (size_t i = 0; i < level.len(); i++) {
+                mins.push(&level[i]->keys[0]);
+            }
+            
+            while (level.len() > 1) {
+                size_t n = level.len();
+                size_t nodes = (n + MAX_CHILDREN - 1) / MAX_CHILDREN;
+                Vec<Node*> parents = Vec<Node*>::with_capacity(nodes);
+                Vec<const K*> parent_mins = Vec<const K*>::with_capacity(nodes);
+                
+                size_t next = 0;
+                for (size_t j = 0; j < nodes; j++) {
+                    size_t children = n / nodes + (j < n % nodes ? 1 : 0);
+                    auto* parent = create_node<InternalNode>(map_->alloc());
+                    parent->children[0] = level[next];
+                    for (size_t c = 1; c < children; c++) {
+                        new (parent->keys.data() + c - 1) K(detail::clone_value(*mins[next + c]));
+                        parent->children[c] = level[next + c];
+                    }
+                    parent->len = children - 1;
+                    parents.push(parent);
+                    parent_mins.push(mins[next]);
+                    next += children;
+                }
+                
+                level = std::move(parents);
+                mins = std::move(parent_mins);
             }
             
-            root_ = NodePtr(new_root);
+            map_->root_ = level[0];
+            map_->first_leaf_ = static_cast<LeafNode*>(leaves_at_front(level[0]));
+            map_->last_leaf_ = leaf_;
+            map_->size_ = count_;
         }
         
-        return insert_into_node(root_.get(), std::move(key), std::move(value));
+    private:
+        static Node* leaves_at_front(Node* node) {
+            while (!node->is_leaf) {
+                node = static_cast<InternalNode*>(node)->children[0];
+            }
+            return node;
+        }
+    };
+    
+    // Push one entry from a mostly sorted input: an equal key replaces the
+    // value just pushed (the last one wins), an out-of-order entry is set
+    // aside and inserted normally once the tree is built
+    void bulk_push(BulkBuilder& builder, Vec<KV>& stragglers, K key, V value) {
+        const K* last = builder.last_key();
+        if (!last || comp_(*last, key)) {
+            builder.push(std::move(key), std::move(value));
+        } else if (!comp_(key, *last)) {
+            builder.replace_last_value(std::move(value));
+        } else {
+            stragglers.push(KV(std::move(key), std::move(value)));
+        }
     }
     
-    // Get
-    // @lifetime: (&'a) -> &'a
-    Option<V*> get(const K& key) {
-        auto [node, pos] = find_node(key);
-        if (node && node->is_leaf) {
-            auto* leaf = static_cast<LeafNode*>(node);
-            return Some(&leaf->values[pos]);
+    // First entry inside the lower bound, or a null leaf
+    std::pair<LeafNode*, size_t> lower_position(const Bound<K>& bound) const {
+        if (size_ == 0) {
+            return {nullptr, 0};
+        }
+        if (bound.is_unbounded()) {
+            return {first_leaf_, 0};
+        }
+        
+        Node* node = root_;
+        while (!node->is_leaf) {
+            auto* internal = static_cast<InternalNode*>(node);
+            node = internal->children[child_index(internal, bound.value())];
+        }
+        
+        auto* leaf = static_cast<LeafNode*>(node);
+        size_t pos = bound.kind() == Bound<K>::INCLUDED
+            ? leaf->search_key(bound.value(), comp_)
+            : leaf->search_edge(bound.value(), comp_);
+        if (pos == leaf->len) {
+            return {leaf->next, 0};
+        }
+        return {leaf, pos};
+    }
+    
+    // Last entry inside the upper bound, or a null leaf
+    std::pair<LeafNode*, size_t> upper_position(const Bound<K>& bound) const {
+        if (size_ == 0) {
+            return {nullptr, 0};
+        }
+        if (bound.is_unbounded()) {
+            return {last_leaf_, size_t(last_leaf_->len - 1)};
+        }
+        
+        Node* node = root_;
+        while (!node->is_leaf) {
+            auto* internal = static_cast<InternalNode*>(node);
+            node = internal->children[child_index(internal, bound.value())];
+        }
+        
+        auto* leaf = static_cast<LeafNode*>(node);
+        size_t end = bound.kind() == Bound<K>::INCLUDED
+            ? leaf->search_edge(bound.value(), comp_)
+            : leaf->search_key(bound.value(), comp_);
+        if (end == 0) {
+            LeafNode* prev = leaf->prev;
+            return {prev, prev ? size_t(prev->len - 1) : 0};
+        }
+        return {leaf, end - 1};
+    }
+    
+public:
+    // Range<Mut> - Lazy, double-ended walk over the entries between two
+    // positions, following the leaf links. Nothing is copied; the range
+    // borrows the map and must not outlive it or see it modified.
+    template<bool Mut>
+    class RangeIter {
+    private:
+        friend class BTreeMap;
+        using Leaf = typename std::conditional<Mut, LeafNode, const LeafNode>::type;
+        using Value = typename std::conditional<Mut, V, const V>::type;
+        
+        // Both ends are inclusive; front_ is null once the range is used up
+        Leaf* front_;
+        size_t front_idx_;
+        Leaf* back_;
+        size_t back_idx_;
+        
+        RangeIter(Leaf* front, size_t front_idx, Leaf* back, size_t back_idx)
+            : front_(front), front_idx_(front_idx), back_(back), back_idx_(back_idx) {}
+        
+    public:
+        using Item = std::pair<const K*, Value*>;
+        
+        RangeIter() : front_(nullptr), front_idx_(0), back_(nullptr), back_idx_(0) {}
+        
+        bool is_empty() const { return front_ == nullptr; }
+        
+        // Take the next entry from the front
+        // @lifetime: (&'a mut) -> &'a
+        Option<Item> next() {
+            if (!front_) return None;
+            Item item(&front_->keys[front_idx_], &front_->values[front_idx_]);
+            if (front_ == back_ && front_idx_ == back_idx_) {
+                *this = RangeIter();
+            } else if (++front_idx_ == front_->len) {
+                front_ = front_->next;
+                front_idx_ = 0;
+            }
+            return Some(item);
+        }
+        
+        // Take the next entry from the back
+        // @lifetime: (&'a mut) -> &'a
+        Option<Item> next_back() {
+            if (!front_) return None;
+            Item item(&back_->keys[back_idx_], &back_->values[back_idx_]);
+            if (front_ == back_ && front_idx_ == back_idx_) {
+                *this = RangeIter();
+            } else if (back_idx_-- == 0) {
+                back_ = back_->prev;
+                back_idx_ = back_->len - 1;
+            }
+            return Some(item);
+        }
+        
+        // Range-for support over what is left of the range
+        class iterator {
+        private:
+            RangeIter range_;
+            
+        public:
+            explicit iterator(const RangeIter& range) : range_(range) {}
+            
+            std::pair<const K&, Value&> operator*() const {
+                return {range_.front_->keys[range_.front_idx_],
+                        range_.front_->values[range_.front_idx_]};
+            }
+            
+            iterator& operator++() {
+                range_.next();
+                return *this;
+            }
+            
+            bool operator!=(const iterator& other) const {
+                return range_.front_ != other.range_.front_ ||
+                       range_.front_idx_ != other.range_.front_idx_;
+            }
+            
+            bool operator==(const iterator& other) const {
+                return !(*this != other);
+            }
+        };
+        
+        // @lifetime: (&'a) -> &'a
+        iterator begin() const { return iterator(*this); }
+        
+        // @lifetime: (&'a) -> &'a
+        iterator end() const { return iterator(RangeIter()); }
+    };
+    
+    using Range = RangeIter<false>;
+    using RangeMut = RangeIter<true>;
+    
+    // Constructors
+    BTreeMap() : root_(nullptr), size_(0), first_leaf_(nullptr), last_leaf_(nullptr), border_short_(false) {
+        init_root();
+    }
+    
+    explicit BTreeMap(const Alloc& alloc)
+        : detail::AllocHolder<Alloc>(alloc), root_(nullptr), size_(0),
+          first_leaf_(nullptr), last_leaf_(nullptr), border_short_(false) {
+        init_root();
+    }
+    
+    // @lifetime: owned
+    static BTreeMap new_() {
+        return BTreeMap();
+    }
+    
+    // @lifetime: owned
+    static BTreeMap new_in(const Alloc& alloc) {
+        return BTreeMap(alloc);
+    }
+    
+    // Move constructor
+    BTreeMap(BTreeMap&& other) noexcept
+        : detail::AllocHolder<Alloc>(other.alloc()),
+          root_(other.root_), size_(other.size_),
+          comp_(std::move(other.comp_)),
+          first_leaf_(other.first_leaf_), last_leaf_(other.last_leaf_),
+          border_short_(other.border_short_) {
+        other.root_ = nullptr;
+        other.size_ = 0;
+        other.first_leaf_ = other.last_leaf_ = nullptr;
+        other.border_short_ = false;
+    }
+    
+    // Move assignment
+    BTreeMap& operator=(BTreeMap&& other) noexcept {
+        if (this != &other) {
+            destroy_tree();
+            this->alloc() = other.alloc();
+            root_ = other.root_;
+            size_ = other.size_;
+            comp_ = std::move(other.comp_);
+            first_leaf_ = other.first_leaf_;
+            last_leaf_ = other.last_leaf_;
+            border_short_ = other.border_short_;
+            
+            other.root_ = nullptr;
+            other.size_ = 0;
+            other.first_leaf_ = other.last_leaf_ = nullptr;
+            other.border_short_ = false;
+        }
+        return *this;
+    }
+    
+    // Delete copy operations
+    BTreeMap(const BTreeMap&) = delete;
+    BTreeMap& operator=(const BTreeMap&) = delete;
+    
+    // Destructor
+    ~BTreeMap() {
+        destroy_tree();
+    }
+    
+    // Size
+    size_t len() const { return size_; }
+    bool is_empty() const { return size_ == 0; }
+    
+    // Get the allocator
+    const Alloc& allocator() const { return this->alloc(); }
+    
+    // Depth and node fill, measured by walking the tree (see stats.hpp)
+    stats::BTreeStats stats() const {
+        stats::BTreeStats s = stats::BTreeStats();
+        s.len = size_;
+        s.node_capacity = MAX_LEN;
+        if (root_) count_nodes(root_, 1, s);
+        return s;
+    }
+    
+    // Insert
+    Option<V> insert(K key, V value) {
+        std::pair<LeafNode*, size_t> where;
+        return insert_locating(std::move(key), std::move(value), where);
+    }
+    
+    // Insert a key greater than every key in the map in O(1), without
+    // searching the tree: it goes at the end of the last leaf. A full last
+    // leaf is not split in the middle; a new leaf is started beside it, so
+    // keys appended in order fill every leaf completely. Any other key is
+    // passed on to insert().
+    Option<V> append_max(K key, V value) {
+        if (!root_) {
+            init_root();
+        }
+        LeafNode* leaf = last_leaf_;
+        if (size_ != 0 && !comp_(leaf->keys[leaf->len - 1], key)) {
+            return insert(std::move(key), std::move(value));
+        }
+        if (leaf->is_full()) {
+            push_right_leaf(std::move(key), std::move(value));
+        } else {
+            leaf->insert_at(leaf->len, std::move(key), std::move(value));
+            size_++;
         }
         return None;
     }
     
+    // Get
     // @lifetime: (&'a) -> &'a
-    Option<const V*> get(const K& key) const {
-        auto [node, pos] = find_node(key);
-        if (node && node->is_leaf) {
-            auto* leaf = static_cast<const LeafNode*>(node);
-            return Option<const V*>(Some(&leaf->values[pos]));
-        }
-        return Option<const V*>(None);
+    Option<V&> get(const K& key) {
+        return get_impl(key);
+    }
+    
+    // @lifetime: (&'a) -> &'a
+    Option<const V&> get(const K& key) const {
+        return get_const_impl(key);
     }
     
     // Contains
@@ -622,29 +1408,99 @@ public:
         return node != nullptr;
     }
     
-    // Remove - simplified version for now
+    // Remove and return the value, rebalancing underfull nodes by borrowing or merging
     // @lifetime: owned
     Option<V> remove(const K& key) {
-        if (size_ == 0) return None;
-        
-        // For now, just do simple leaf removal without rebalancing
+        return remove_impl(key).map([](KV kv) { return std::move(kv.second); });
+    }
+    
+    // Remove and return the stored key and value
+    // @lifetime: owned
+    Option<KV> remove_entry(const K& key) {
+        return remove_impl(key);
+    }
+    
+    // Heterogeneous lookup: with a transparent Compare (e.g. std::less<>
+    // or StringLess), keys can be looked up by any type it accepts, such
+    // as str or const char* for String keys, without building a temporary K
+    template<typename Q, if_transparent<Q> = 0>
+    // @lifetime: (&'a) -> &'a
+    Option<V&> get(const Q& key) {
+        return get_impl(key);
+    }
+    
+    template<typename Q, if_transparent<Q> = 0>
+    // @lifetime: (&'a) -> &'a
+    Option<const V&> get(const Q& key) const {
+        return get_const_impl(key);
+    }
+    
+    template<typename Q, if_transparent<Q> = 0>
+    // @lifetime: (&'a mut) -> &'a mut
+    Option<V&> get_mut(const Q& key) {
+        return get_impl(key);
+    }
+    
+    template<typename Q, if_transparent<Q> = 0>
+    bool contains_key(const Q& key) const {
         auto [node, pos] = find_node(key);
-        if (node && node->is_leaf) {
-            auto* leaf = static_cast<LeafNode*>(node);
-            V value = leaf->remove_at(pos);
-            size_--;
-            return Some(std::move(value));
-        }
-        
-        return None;
+        return node != nullptr;
+    }
+    
+    template<typename Q, if_transparent<Q> = 0>
+    // @lifetime: owned
+    Option<V> remove(const Q& key) {
+        return remove_impl(key).map([](KV kv) { return std::move(kv.second); });
+    }
+    
+    template<typename Q, if_transparent<Q> = 0>
+    // @lifetime: owned
+    Option<KV> remove_entry(const Q& key) {
+        return remove_impl(key);
     }
     
     // Clear
     void clear() {
-        auto* root = new LeafNode();
-        root_ = NodePtr(root);
-        first_leaf_ = last_leaf_ = root;
-        size_ = 0;
+        destroy_tree();
+        init_root();
+    }
+    
+    // Stored key and value for key
+    // @lifetime: (&'a) -> &'a
+    Option<std::pair<const K*, const V*>> get_key_value(const K& key) const {
+        auto [leaf, pos] = find_node(key);
+        if (!leaf) return None;
+        return Some(std::pair<const K*, const V*>(&leaf->keys[pos], &leaf->values[pos]));
+    }
+    
+    // Smallest and largest entries, read straight off the leaf links
+    // @lifetime: (&'a) -> &'a
+    Option<std::pair<const K*, const V*>> first_key_value() const {
+        if (size_ == 0) return None;
+        return Some(std::pair<const K*, const V*>(&first_leaf_->keys[0], &first_leaf_->values[0]));
+    }
+    
+    // @lifetime: (&'a) -> &'a
+    Option<std::pair<const K*, const V*>> last_key_value() const {
+        if (size_ == 0) return None;
+        size_t last = last_leaf_->len - 1;
+        return Some(std::pair<const K*, const V*>(&last_leaf_->keys[last], &last_leaf_->values[last]));
+    }
+    
+    // Remove the smallest entry
+    // @lifetime: owned
+    Option<KV> pop_first() {
+        return remove_where(
+            [](const InternalNode*) { return size_t(0); },
+            [](const LeafNode*) { return Some(size_t(0)); });
+    }
+    
+    // Remove the largest entry
+    // @lifetime: owned
+    Option<KV> pop_last() {
+        return remove_where(
+            [](const InternalNode* node) { return size_t(node->len); },
+            [](const LeafNode* leaf) { return Some(size_t(leaf->len - 1)); });
     }
     
     // Iterator support
@@ -737,34 +1593,457 @@ public:
         return const_iterator(nullptr, 0);
     }
     
+    // Bulk load from entries sorted by key, in O(n) with fully packed
+    // leaves. *first must convert to std::pair<K, V>; wrap the iterators in
+    // std::make_move_iterator to move entries out of a container. For
+    // equal keys the last entry wins. Unsorted input is still accepted,
+    // but the out-of-order entries cost a normal insert each.
+    template<typename It>
+    // @lifetime: owned
+    static BTreeMap from_sorted_iter(It first, It last, const Alloc& alloc = Alloc()) {
+        BTreeMap map(NoRoot(), alloc);
+        BulkBuilder builder(&map);
+        Vec<KV> stragglers;
+        for (; first != last; ++first) {
+            KV kv(*first);
+            map.bulk_push(builder, stragglers, std::move(kv.first), std::move(kv.second));
+        }
+        builder.finish();
+        for (size_t i = 0; i < stragglers.len(); i++) {
+            map.insert(std::move(stragglers[i].first), std::move(stragglers[i].second));
+        }
+        return map;
+    }
+    
+    // Move every entry of other into this map, leaving other empty. Both
+    // maps are merged in one pass and rebuilt bottom-up, O(len + other.len).
+    // For keys present in both, other's value wins.
+    void append(BTreeMap& other) {
+        if (this == &other || other.size_ == 0) return;
+        
+        BTreeMap merged(NoRoot(), this->alloc());
+        BulkBuilder builder(&merged);
+        LeafNode* a = size_ ? first_leaf_ : nullptr;
+        LeafNode* b = other.first_leaf_;
+        size_t ia = 0, ib = 0;
+        
+        auto take = [&builder](LeafNode*& leaf, size_t& idx) {
+            builder.push(std::move(leaf->keys[idx]), std::move(leaf->values[idx]));
+            if (++idx == leaf->len) {
+                leaf = leaf->next;
+                idx = 0;
+            }
+        };
+        auto skip = [](LeafNode*& leaf, size_t& idx) {
+            if (++idx == leaf->len) {
+                leaf = leaf->next;
+                idx = 0;
+            }
+        };
+        
+        while (a || b) {
+            if (!b || (a && comp_(a->keys[ia], b->keys[ib]))) {
+                take(a, ia);
+            } else if (a && !comp_(b->keys[ib], a->keys[ia])) {
+                skip(a, ia);
+                take(b, ib);
+            } else {
+                take(b, ib);
+            }
+        }
+        builder.finish();
+        
+        // Both old trees now hold only moved-from entries
+        other.destroy_tree();
+        other.init_root();
+        *this = std::move(merged);
+    }
+    
+    void append(BTreeMap&& other) {
+        append(other);
+    }
+    
+    // Same as append(other)
+    void extend(BTreeMap&& other) {
+        append(other);
+    }
+    
+    // Move the entries with keys >= key into a new map, keeping the
+    // smaller keys (Rust: BTreeMap::split_off). The tree is cut along the
+    // path to key and only the nodes on the cut are rebalanced, O(log n);
+    // the two lengths are then counted over the leaves of the smaller
+    // half, O(min(len, returned len) / B).
+    // @lifetime: owned
+    BTreeMap split_off(const K& key) {
+        settle_border();
+        BTreeMap right(NoRoot(), this->alloc());
+        if (size_ == 0 || comp_(last_leaf_->keys[last_leaf_->len - 1], key)) {
+            right.init_root();
+            return right;
+        }
+        if (!comp_(first_leaf_->keys[0], key)) {
+            right = std::move(*this);
+            init_root();
+            return right;
+        }
+        
+        // Allocate one node per level up front, so the cut cannot fail
+        // half way
+        size_t height = 0;
+        for (Node* node = root_; !node->is_leaf; node = static_cast<InternalNode*>(node)->children[0]) {
+            height++;
+        }
+        Node* fresh[64];
+        size_t made = 0;
+        try {
+            for (; made < height; made++) {
+                fresh[made] = create_node<InternalNode>(this->alloc());
+            }
+            fresh[height] = create_node<LeafNode>(this->alloc());
+        } catch (...) {
+            for (size_t i = 0; i < made; i++) {
+                deallocate_node(this->alloc(), fresh[i]);
+            }
+            throw;
+        }
+        
+        // Each level keeps the edges left of the one covering key and
+        // hands the rest to the new node; that edge itself is cut one
+        // level down
+        Node* node = root_;
+        Node** attach = &right.root_;
+        for (size_t level = 0; level < height; level++) {
+            auto* internal = static_cast<InternalNode*>(node);
+            auto* split = static_cast<InternalNode*>(fresh[level]);
+            size_t edge = child_index(internal, key);
+            split->len = internal->len - edge;
+            relocate_n(split->keys.data(), internal->keys.data() + edge, split->len);
+            std::memcpy(&split->children[1], &internal->children[edge + 1],
+                        split->len * sizeof(Node*));
+            internal->len = edge;
+            *attach = split;
+            attach = &split->children[0];
+            node = internal->children[edge];
+        }
+        
+        auto* leaf = static_cast<LeafNode*>(node);
+        auto* split = static_cast<LeafNode*>(fresh[height]);
+        leaf->move_entries_to(split, leaf->search_key(key, comp_));
+        *attach = split;
+        split->next = leaf->next;
+        if (leaf->next) {
+            leaf->next->prev = split;
+        }
+        leaf->next = nullptr;
+        right.first_leaf_ = split;
+        right.last_leaf_ = last_leaf_ == leaf ? split : last_leaf_;
+        last_leaf_ = leaf;
+        
+        fix_right_border();
+        right.fix_left_border();
+        
+        size_t left_len = 0, right_len = 0;
+        const LeafNode* a = first_leaf_;
+        const LeafNode* b = right.first_leaf_;
+        while (a && b) {
+            left_len += a->len;
+            right_len += b->len;
+            a = a->next;
+            b = b->next;
+        }
+        if (a) {
+            left_len = size_ - right_len;
+        } else {
+            right_len = size_ - left_len;
+        }
+        size_ = left_len;
+        right.size_ = right_len;
+        return right;
+    }
+    
+    // Keep only the entries for which pred(key, value) is true; the kept
+    // entries are moved into a tree rebuilt bottom-up, O(n). If pred
+    // throws, the entries not yet visited are lost but nothing leaks.
+    template<typename Pred>
+    void retain(Pred pred) {
+        if (size_ == 0) return;
+        
+        BTreeMap kept(NoRoot(), this->alloc());
+        BulkBuilder builder(&kept);
+        try {
+            for (LeafNode* leaf = first_leaf_; leaf; leaf = leaf->next) {
+                for (size_t i = 0; i < leaf->len; i++) {
+                    if (pred(static_cast<const K&>(leaf->keys[i]), leaf->values[i])) {
+                        builder.push(std::move(leaf->keys[i]), std::move(leaf->values[i]));
+                    }
+                }
+            }
+        } catch (...) {
+            builder.finish();
+            *this = std::move(kept);
+            throw;
+        }
+        builder.finish();
+        *this = std::move(kept);
+    }
+    
+    // Lazy iteration over the entries with keys between lo and hi
+    // (Rust: map.range((lo, hi))). Empty when lo lies after hi.
+    // @lifetime: (&'a) -> &'a
+    Range range(const Bound<K>& lo, const Bound<K>& hi) const {
+        return make_range<Range>(lo, hi);
+    }
+    
+    // @lifetime: (&'a mut) -> &'a mut
+    RangeMut range_mut(const Bound<K>& lo, const Bound<K>& hi) {
+        return make_range<RangeMut>(lo, hi);
+    }
+    
+    // Entries with lo <= key <= hi
+    // @lifetime: (&'a) -> &'a
+    Range range(const K& lo, const K& hi) const {
+        return range(Included(lo), Included(hi));
+    }
+    
+    // Double-ended iteration over the whole map
+    // @lifetime: (&'a) -> &'a
+    Range iter() const {
+        return range(Unbounded, Unbounded);
+    }
+    
+    // @lifetime: (&'a mut) -> &'a mut
+    RangeMut iter_mut() {
+        return range_mut(Unbounded, Unbounded);
+    }
+    
+    // CursorMut - A position between two entries (or at either end) from
+    // which the map can be walked and edited (Rust: btree_map::CursorMut).
+    // Edits made through the cursor keep it valid; any other change to the
+    // map invalidates it.
+    class CursorMut {
+    private:
+        friend class BTreeMap;
+        using Item = std::pair<const K*, V*>;
+        
+        // The gap before leaf_->keys[index_]; index_ == leaf_->len is the
+        // gap before the next leaf's first entry
+        BTreeMap* map_;
+        LeafNode* leaf_;
+        size_t index_;
+        
+        CursorMut(BTreeMap* map, LeafNode* leaf, size_t index)
+            : map_(map), leaf_(leaf), index_(index) {}
+        
+        static Option<Item> item(LeafNode* leaf, size_t index) {
+            return Some(Item(&leaf->keys[index], &leaf->values[index]));
+        }
+        
+        // Where the next entry is, or a null leaf at the end
+        std::pair<LeafNode*, size_t> next_slot() const {
+            if (index_ < leaf_->len) return {leaf_, index_};
+            return {leaf_->next, 0};
+        }
+        
+        std::pair<LeafNode*, size_t> prev_slot() const {
+            if (index_ > 0) return {leaf_, index_ - 1};
+            LeafNode* prev = leaf_->prev;
+            return {prev, prev ? size_t(prev->len - 1) : 0};
+        }
+        
+        void seek_after(std::pair<LeafNode*, size_t> slot) {
+            leaf_ = slot.first;
+            index_ = slot.second + 1;
+        }
+        
+        // Remove the entry at slot. A leaf that can spare it (or the root
+        // leaf) loses it in place; otherwise the removal goes through the
+        // tree, and the cursor finds its gap again by key afterwards.
+        Option<KV> remove_slot(std::pair<LeafNode*, size_t> slot) {
+            LeafNode* leaf = slot.first;
+            if (leaf->len > MIN_LEN || leaf == map_->root_) {
+                KV kv = leaf->remove_at(slot.second);
+                map_->size_--;
+                leaf_ = leaf;
+                index_ = slot.second;
+                return Some(std::move(kv));
+            }
+            K probe = detail::clone_value(leaf->keys[slot.second]);
+            Option<KV> kv = map_->remove_impl(probe);
+            auto next = map_->lower_position(Bound<K>::included(probe));
+            if (next.first) {
+                leaf_ = next.first;
+                index_ = next.second;
+            } else {
+                leaf_ = map_->last_leaf_;
+                index_ = leaf_->len;
+            }
+            return kv;
+        }
+        
+    public:
+        // The entry after the cursor, without moving
+        // @lifetime: (&'a) -> &'a
+        Option<Item> peek_next() const {
+            auto slot = next_slot();
+            if (!slot.first) return None;
+            return item(slot.first, slot.second);
+        }
+        
+        // @lifetime: (&'a) -> &'a
+        Option<Item> peek_prev() const {
+            auto slot = prev_slot();
+            if (!slot.first) return None;
+            return item(slot.first, slot.second);
+        }
+        
+        // Step over the next entry and return it
+        // @lifetime: (&'a) -> &'a
+        Option<Item> next() {
+            auto slot = next_slot();
+            if (!slot.first) return None;
+            seek_after(slot);
+            return item(slot.first, slot.second);
+        }
+        
+        // @lifetime: (&'a) -> &'a
+        Option<Item> prev() {
+            auto slot = prev_slot();
+            if (!slot.first) return None;
+            leaf_ = slot.first;
+            index_ = slot.second;
+            return item(slot.first, slot.second);
+        }
+        
+        // Insert key, expected to sort between the entries around the
+        // cursor, and leave the cursor after it. At the end of the map this
+        // is append_max(); inside a leaf with room the entry goes in place
+        // without searching the tree. A key equal to a neighbour replaces
+        // its value, and any other key is inserted normally, so a wrong
+        // hint only costs the search.
+        Option<V> insert_hint(K key, V value) {
+            const auto& comp = map_->comp_;
+            auto prev = prev_slot();
+            auto next = next_slot();
+            bool after_prev = !prev.first || comp(prev.first->keys[prev.second], key);
+            bool before_next = !next.first || comp(key, next.first->keys[next.second]);
+            
+            if (after_prev && before_next) {
+                if (!next.first) {
+                    Option<V> old = map_->append_max(std::move(key), std::move(value));
+                    leaf_ = map_->last_leaf_;
+                    index_ = leaf_->len;
+                    return old;
+                }
+                // Only a key between two keys of one leaf (or ahead of the
+                // first leaf) certainly belongs there; at a leaf's edge the
+                // parent's separator decides
+                bool inside = index_ < leaf_->len &&
+                              (index_ > 0 || leaf_ == map_->first_leaf_);
+                if (inside && !leaf_->is_full()) {
+                    leaf_->insert_at(index_, std::move(key), std::move(value));
+                    map_->size_++;
+                    index_++;
+                    return None;
+                }
+            } else if (!after_prev && !comp(key, prev.first->keys[prev.second])) {
+                V old = std::move(prev.first->values[prev.second]);
+                prev.first->values[prev.second] = std::move(value);
+                return Some(std::move(old));
+            } else if (!before_next && !comp(next.first->keys[next.second], key)) {
+                V old = std::move(next.first->values[next.second]);
+                next.first->values[next.second] = std::move(value);
+                seek_after(next);
+                return Some(std::move(old));
+            }
+            
+            std::pair<LeafNode*, size_t> where;
+            Option<V> old = map_->insert_locating(std::move(key), std::move(value), where);
+            seek_after(where);
+            return old;
+        }
+        
+        // Remove the entry after the cursor
+        // @lifetime: owned
+        Option<KV> remove_next() {
+            auto slot = next_slot();
+            if (!slot.first) return None;
+            return remove_slot(slot);
+        }
+        
+        // Remove the entry before the cursor
+        // @lifetime: owned
+        Option<KV> remove_prev() {
+            auto slot = prev_slot();
+            if (!slot.first) return None;
+            return remove_slot(slot);
+        }
+    };
+    
+    // Cursor at the gap before the first entry inside bound (Rust:
+    // lower_bound_mut). Unbounded puts it before the first entry.
+    // @lifetime: (&'a mut) -> &'a mut
+    CursorMut lower_bound_mut(const Bound<K>& bound) {
+        if (!root_) {
+            init_root();
+        }
+        auto pos = lower_position(bound);
+        if (!pos.first) {
+            return CursorMut(this, last_leaf_, last_leaf_->len);
+        }
+        return CursorMut(this, pos.first, pos.second);
+    }
+    
+    // Cursor at the gap after the last entry inside bound (Rust:
+    // upper_bound_mut). Unbounded puts it after the last entry.
+    // @lifetime: (&'a mut) -> &'a mut
+    CursorMut upper_bound_mut(const Bound<K>& bound) {
+        if (!root_) {
+            init_root();
+        }
+        auto pos = upper_position(bound);
+        if (!pos.first) {
+            return CursorMut(this, first_leaf_, 0);
+        }
+        return CursorMut(this, pos.first, pos.second + 1);
+    }
+    
     // Additional methods for compatibility
     
-    // Clone for explicit copying
+    // Clone for explicit copying. Copies the tree node for node, so the
+    // clone has the same shape and nothing is compared or rebalanced;
+    // leaves of trivially copyable entries are copied with memcpy
     // @lifetime: owned
     BTreeMap clone() const {
-        BTreeMap result;
-        for (const auto& [key, value] : *this) {
-            result.insert(key, value);
-        }
+        if (!root_) return BTreeMap(this->alloc());
+        BTreeMap result(NoRoot(), this->alloc());
+        result.comp_ = comp_;
+        LeafNode* last_leaf = nullptr;
+        result.root_ = clone_node(result.alloc(), root_, last_leaf);
+        result.size_ = size_;
+        result.border_short_ = border_short_;
+        result.last_leaf_ = last_leaf;
+        Node* first = result.root_;
+        while (!first->is_leaf) first = static_cast<InternalNode*>(first)->children[0];
+        result.first_leaf_ = static_cast<LeafNode*>(first);
         return result;
     }
     
-    // Collect all keys
+    // Collect all keys (use iter() or range() to walk them without copying)
     // @lifetime: owned
     Vec<K> keys() const {
         Vec<K> result = Vec<K>::with_capacity(size_);
         for (const auto& [key, _] : *this) {
-            result.push(key);
+            result.push(detail::clone_value(key));
         }
         return result;
     }
     
-    // Collect all values
+    // Collect all values (use iter() or range() to walk them without copying)
     // @lifetime: owned
     Vec<V> values() const {
         Vec<V> result = Vec<V>::with_capacity(size_);
         for (const auto& [_, value] : *this) {
-            result.push(value);
+            result.push(detail::clone_value(value));
         }
         return result;
     }
@@ -772,36 +2051,32 @@ public:
     // Get or insert with default
     // @lifetime: (&'a mut) -> &'a mut
     V& entry(const K& key) {
-        auto [node, pos] = find_node(key);
-        if (node && node->is_leaf) {
-            auto* leaf = static_cast<LeafNode*>(node);
+        auto [leaf, pos] = find_node(key);
+        if (leaf) {
             return leaf->values[pos];
         }
         // Insert and return reference
-        insert(key, V());
-        auto [new_node, new_pos] = find_node(key);
-        auto* leaf = static_cast<LeafNode*>(new_node);
-        return leaf->values[new_pos];
+        insert(detail::clone_value(key), V());
+        auto [new_leaf, new_pos] = find_node(key);
+        return new_leaf->values[new_pos];
     }
     
     // Get or insert with value
     // @lifetime: (&'a mut) -> &'a mut
     V& or_insert(const K& key, V default_value) {
-        auto [node, pos] = find_node(key);
-        if (node && node->is_leaf) {
-            auto* leaf = static_cast<LeafNode*>(node);
+        auto [leaf, pos] = find_node(key);
+        if (leaf) {
             return leaf->values[pos];
         }
         // Insert and return reference
-        insert(key, std::move(default_value));
-        auto [new_node, new_pos] = find_node(key);
-        auto* leaf = static_cast<LeafNode*>(new_node);
-        return leaf->values[new_pos];
+        insert(detail::clone_value(key), std::move(default_value));
+        auto [new_leaf, new_pos] = find_node(key);
+        return new_leaf->values[new_pos];
     }
     
     // Get mutable reference to value
     // @lifetime: (&'a mut) -> &'a mut
-    Option<V*> get_mut(const K& key) {
+    Option<V&> get_mut(const K& key) {
         return get(key); // Since get already returns mutable
     }
     
@@ -810,7 +2085,7 @@ public:
         if (size_ != other.size_) return false;
         for (const auto& [key, value] : *this) {
             auto other_val = other.get(key);
-            if (other_val.is_none() || *other_val.unwrap() != value) {
+            if (other_val.is_none() || other_val.unwrap() != value) {
                 return false;
             }
         }
@@ -820,8 +2095,28 @@ public:
     bool operator!=(const BTreeMap& other) const {
         return !(*this == other);
     }
+    
+private:
+    template<typename R>
+    R make_range(const Bound<K>& lo, const Bound<K>& hi) const {
+        auto front = lower_position(lo);
+        auto back = upper_position(hi);
+        if (!front.first || !back.first ||
+            comp_(back.first->keys[back.second], front.first->keys[front.second])) {
+            return R();
+        }
+        return R(front.first, front.second, back.first, back.second);
+    }
 };
 
+template<typename K, typename V, typename Compare, typename Alloc, size_t B>
+struct is_send<BTreeMap<K, V, Compare, Alloc, B>>
+    : detail::all_of<is_send<K>::value, is_send<V>::value, is_send<Compare>::value, is_send<Alloc>::value> {};
+
+template<typename K, typename V, typename Compare, typename Alloc, size_t B>
+struct is_sync<BTreeMap<K, V, Compare, Alloc, B>>
+    : detail::all_of<is_sync<K>::value, is_sync<V>::value, is_sync<Compare>::value, is_sync<Alloc>::value> {};
+
 // Factory function
 template<typename K, typename V>
 // @lifetime: owned
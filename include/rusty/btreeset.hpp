@@ -2,6 +2,7 @@
 #define RUSTY_BTREESET_HPP
 
 #include "btreemap.hpp"
+#include "fwd.hpp"
 #include "vec.hpp"
 #include <functional>
 
@@ -10,23 +11,61 @@ namespace rusty {
 
 // BTreeSet implemented as a thin wrapper around BTreeMap<T, ()>
 // Maintains elements in sorted order
-template <typename T, typename Compare = std::less<T>>
+// B = 0 picks the branching factor from the node size budget (see BTreeMap)
+template <typename T, typename Compare, typename Alloc, size_t B>
 class BTreeSet {
 private:
     struct Unit {  // Empty struct to represent Rust's unit type ()
         bool operator==(const Unit&) const { return true; }
+        bool operator!=(const Unit&) const { return false; }
     };
-    BTreeMap<T, Unit, Compare> map_;
+    using Map = BTreeMap<T, Unit, Compare, Alloc, B>;
+    Map map_;
+    
+    explicit BTreeSet(Map&& map) : map_(std::move(map)) {}
+    
+    // Size ratio above which walking the smaller set and looking each
+    // element up beats walking both (Rust uses the same tipping point)
+    static constexpr size_t LOOKUP_RATIO = 16;
+    
+    // Presents a sequence of elements as (element, Unit) entries
+    template<typename It>
+    struct UnitEntries {
+        It it;
+        
+        std::pair<T, Unit> operator*() { return std::pair<T, Unit>(T(*it), Unit{}); }
+        UnitEntries& operator++() { ++it; return *this; }
+        bool operator!=(const UnitEntries& other) const { return it != other.it; }
+    };
+    
+    // Enables the heterogeneous lookup overloads for key-like types Q
+    template<typename Q>
+    using if_transparent = typename std::enable_if<
+        detail::is_transparent<Compare>::value && !std::is_same<Q, T>::value, int>::type;
     
 public:
     // Constructors
     BTreeSet() = default;
     
+    explicit BTreeSet(const Alloc& alloc) : map_(alloc) {}
+    
     // @lifetime: owned
     static BTreeSet new_() {
         return BTreeSet();
     }
     
+    // @lifetime: owned
+    static BTreeSet new_in(const Alloc& alloc) {
+        return BTreeSet(alloc);
+    }
+    
+    // Bulk load from sorted elements in O(n) (see BTreeMap::from_sorted_iter)
+    template<typename It>
+    // @lifetime: owned
+    static BTreeSet from_sorted_iter(It first, It last, const Alloc& alloc = Alloc()) {
+        return BTreeSet(Map::from_sorted_iter(UnitEntries<It>{first}, UnitEntries<It>{last}, alloc));
+    }
+    
     // Move constructor
     BTreeSet(BTreeSet&& other) noexcept : map_(std::move(other.map_)) {}
     
@@ -45,15 +84,19 @@ public:
     // Clone for explicit copying
     // @lifetime: owned
     BTreeSet clone() const {
-        BTreeSet result;
-        result.map_ = map_.clone();
-        return result;
+        return BTreeSet(map_.clone());
     }
     
     // Size and capacity
     size_t len() const { return map_.len(); }
     bool is_empty() const { return map_.is_empty(); }
     
+    // The underlying map's stats (see stats.hpp)
+    stats::BTreeStats stats() const { return map_.stats(); }
+    
+    // Get the allocator
+    const Alloc& allocator() const { return map_.allocator(); }
+    
     // Clear all elements
     void clear() {
         map_.clear();
@@ -66,6 +109,12 @@ public:
         return !existed;  // Return true if newly inserted
     }
     
+    // Insert an element greater than every element in O(1), filling the
+    // nodes completely (see BTreeMap::append_max)
+    bool append_max(T value) {
+        return map_.append_max(std::move(value), Unit{}).is_none();
+    }
+    
     // Remove element
     bool remove(const T& value) {
         return map_.remove(value).is_some();
@@ -76,13 +125,23 @@ public:
         return map_.contains_key(value);
     }
     
-    // Get element (returns Option<const T*>)
+    // Heterogeneous lookup with a transparent Compare (see BTreeMap)
+    template<typename Q, if_transparent<Q> = 0>
+    bool contains(const Q& value) const {
+        return map_.contains_key(value);
+    }
+    
+    template<typename Q, if_transparent<Q> = 0>
+    bool remove(const Q& value) {
+        return map_.remove(value).is_some();
+    }
+    
+    // Stored element equal to value
     // @lifetime: (&'a) -> &'a
-    Option<const T*> get(const T& value) const {
-        for (const auto& [key, _] : map_) {
-            if (key == value) {
-                return Some(&key);
-            }
+    Option<const T&> get(const T& value) const {
+        auto kv = map_.get_key_value(value);
+        if (kv.is_some()) {
+            return Option<const T&>(*kv.unwrap().first);
         }
         return None;
     }
@@ -112,20 +171,20 @@ public:
     
     // Get first (minimum) element
     // @lifetime: (&'a) -> &'a
-    Option<const T*> first() const {
+    Option<const T&> first() const {
         auto first_kv = map_.first_key_value();
         if (first_kv.is_some()) {
-            return Some(first_kv.unwrap().first);
+            return Option<const T&>(*first_kv.unwrap().first);
         }
         return None;
     }
     
     // Get last (maximum) element
     // @lifetime: (&'a) -> &'a
-    Option<const T*> last() const {
+    Option<const T&> last() const {
         auto last_kv = map_.last_key_value();
         if (last_kv.is_some()) {
-            return Some(last_kv.unwrap().first);
+            return Option<const T&>(*last_kv.unwrap().first);
         }
         return None;
     }
@@ -152,99 +211,125 @@ public:
     
     // Range operations
     
-    // Get all elements in range [min, max]
-    // @lifetime: owned
-    Vec<T> range(const T& min, const T& max) const {
-        auto map_range = map_.range(min, max);
-        Vec<T> result = Vec<T>::with_capacity(map_range.len());
-        for (size_t i = 0; i < map_range.len(); i++) {
-            result.push(map_range[i].first);
+    // Range - Lazy, double-ended walk over the elements between two bounds
+    class Range {
+    private:
+        typename Map::Range inner_;
+        
+    public:
+        explicit Range(typename Map::Range inner) : inner_(inner) {}
+        
+        bool is_empty() const { return inner_.is_empty(); }
+        
+        // @lifetime: (&'a mut) -> &'a
+        Option<const T&> next() {
+            auto item = inner_.next();
+            if (item.is_some()) return Option<const T&>(*item.unwrap().first);
+            return None;
         }
-        return result;
+        
+        // @lifetime: (&'a mut) -> &'a
+        Option<const T&> next_back() {
+            auto item = inner_.next_back();
+            if (item.is_some()) return Option<const T&>(*item.unwrap().first);
+            return None;
+        }
+        
+        class iterator {
+        private:
+            typename Map::Range::iterator inner_;
+            
+        public:
+            explicit iterator(typename Map::Range::iterator it) : inner_(it) {}
+            
+            const T& operator*() const { return (*inner_).first; }
+            
+            iterator& operator++() {
+                ++inner_;
+                return *this;
+            }
+            
+            bool operator!=(const iterator& other) const { return inner_ != other.inner_; }
+            bool operator==(const iterator& other) const { return inner_ == other.inner_; }
+        };
+        
+        // @lifetime: (&'a) -> &'a
+        iterator begin() const { return iterator(inner_.begin()); }
+        
+        // @lifetime: (&'a) -> &'a
+        iterator end() const { return iterator(inner_.end()); }
+    };
+    
+    // Lazy iteration over the elements between lo and hi
+    // (Rust: set.range((lo, hi)))
+    // @lifetime: (&'a) -> &'a
+    Range range(const Bound<T>& lo, const Bound<T>& hi) const {
+        return Range(map_.range(lo, hi));
+    }
+    
+    // Elements in [min, max]
+    // @lifetime: (&'a) -> &'a
+    Range range(const T& min, const T& max) const {
+        return Range(map_.range(min, max));
+    }
+    
+    // Double-ended iteration in sorted order
+    // @lifetime: (&'a) -> &'a
+    Range iter() const {
+        return Range(map_.iter());
     }
     
-    // Split off everything after value (exclusive)
+    // Move the elements >= value into a new set, O(log n) (see
+    // BTreeMap::split_off)
     // @lifetime: owned
     BTreeSet split_off(const T& value) {
-        BTreeSet result;
+        BTreeSet result(allocator());
         result.map_ = map_.split_off(value);
         return result;
     }
     
-    // Append another set (all values in other must be > all values in self)
+    // Move all elements of other into this set in one O(n + m) merge,
+    // leaving other empty
+    void append(BTreeSet& other) {
+        map_.append(other.map_);
+    }
+    
     void append(BTreeSet&& other) {
-        map_.append(std::move(other.map_));
+        map_.append(other.map_);
     }
     
-    // Set operations
+    // Set operations: union_with, intersection, difference and
+    // symmetric_difference walk both sets in order and bulk-load the
+    // result (see from_sorted_iter), O(len + other.len) with fully packed
+    // nodes. The *_iter forms below are the same walks, done lazily.
     
     // Union: self ∪ other (all elements from both sets)
     // @lifetime: owned
     BTreeSet union_with(const BTreeSet& other) const {
-        BTreeSet result = this->clone();
-        for (const auto& [key, _] : other.map_) {
-            result.insert(key);
-        }
-        return result;
+        return collect_sorted(union_iter(other));
     }
     
     // Intersection: self ∩ other (elements in both sets)
     // @lifetime: owned
     BTreeSet intersection(const BTreeSet& other) const {
-        BTreeSet result;
-        // Iterate over smaller set for efficiency
-        const BTreeSet* smaller = this->len() <= other.len() ? this : &other;
-        const BTreeSet* larger = this->len() <= other.len() ? &other : this;
-        
-        for (const auto& [key, _] : smaller->map_) {
-            if (larger->contains(key)) {
-                result.insert(key);
-            }
-        }
-        return result;
+        return collect_sorted(intersection_iter(other));
     }
     
     // Difference: self - other (elements in self but not in other)
     // @lifetime: owned
     BTreeSet difference(const BTreeSet& other) const {
-        BTreeSet result;
-        for (const auto& [key, _] : map_) {
-            if (!other.contains(key)) {
-                result.insert(key);
-            }
-        }
-        return result;
+        return collect_sorted(difference_iter(other));
     }
     
     // Symmetric difference: self △ other (elements in either but not both)
     // @lifetime: owned
     BTreeSet symmetric_difference(const BTreeSet& other) const {
-        BTreeSet result;
-        for (const auto& [key, _] : map_) {
-            if (!other.contains(key)) {
-                result.insert(key);
-            }
-        }
-        for (const auto& [key, _] : other.map_) {
-            if (!this->contains(key)) {
-                result.insert(key);
-            }
-        }
-        return result;
+        return collect_sorted(symmetric_difference_iter(other));
     }
     
     // Check if disjoint (no common elements)
     bool is_disjoint(const BTreeSet& other) const {
-        // Check smaller set against larger
-        const BTreeSet* smaller = this->len() <= other.len() ? this : &other;
-        const BTreeSet* larger = this->len() <= other.len() ? &other : this;
-        
-        for (const auto& [key, _] : smaller->map_) {
-            if (larger->contains(key)) {
-                return false;
-            }
-        }
-        return true;
+        return intersection_iter(other).next().is_none();
     }
     
     // Check if subset
@@ -252,12 +337,7 @@ public:
         if (this->len() > other.len()) {
             return false;
         }
-        for (const auto& [key, _] : map_) {
-            if (!other.contains(key)) {
-                return false;
-            }
-        }
-        return true;
+        return difference_iter(other).next().is_none();
     }
     
     // Check if superset
@@ -267,7 +347,7 @@ public:
     
     // Extend from another set
     void extend(BTreeSet&& other) {
-        map_.extend(std::move(other.map_));
+        map_.append(other.map_);
     }
     
     // Retain only elements matching predicate
@@ -292,17 +372,17 @@ public:
     // Iterator support (iterate in sorted order)
     class iterator {
     private:
-        typename BTreeMap<T, Unit, Compare>::iterator inner_;
+        typename Map::iterator inner_;
         
     public:
-        iterator(typename BTreeMap<T, Unit, Compare>::iterator it) : inner_(it) {}
+        iterator(typename Map::iterator it) : inner_(it) {}
         
         const T& operator*() {
-            return inner_->first;
+            return (*inner_).first;
         }
         
         const T* operator->() {
-            return &(inner_->first);
+            return &(*inner_).first;
         }
         
         iterator& operator++() {
@@ -321,17 +401,17 @@ public:
     
     class const_iterator {
     private:
-        typename BTreeMap<T, Unit, Compare>::const_iterator inner_;
+        typename Map::const_iterator inner_;
         
     public:
-        const_iterator(typename BTreeMap<T, Unit, Compare>::const_iterator it) : inner_(it) {}
+        const_iterator(typename Map::const_iterator it) : inner_(it) {}
         
         const T& operator*() const {
-            return inner_->first;
+            return (*inner_).first;
         }
         
         const T* operator->() const {
-            return &(inner_->first);
+            return &(*inner_).first;
         }
         
         const_iterator& operator++() {
@@ -368,6 +448,92 @@ public:
         return const_iterator(map_.end());
     }
     
+    // SetOp<InSelf, InBoth, InOther> - Lazy set operation yielding, in
+    // sorted order, the elements found only in self, in both sets, or
+    // only in other, as selected. Both sets are walked in step, unless
+    // one side is much smaller and only elements of self can be yielded:
+    // then the smaller side is walked and each element looked up in the
+    // other (as Rust's Intersection and Difference do). Borrows both sets.
+    template<bool InSelf, bool InBoth, bool InOther>
+    class SetOp : public Iterator<SetOp<InSelf, InBoth, InOther>, const T&> {
+    private:
+        const_iterator a_;
+        const_iterator a_end_;
+        const_iterator b_;
+        const_iterator b_end_;
+        const BTreeSet* probe_;  // Look elements of a up here instead of merging
+        Compare comp_;
+        
+    public:
+        SetOp(const BTreeSet& a, const BTreeSet& b, const BTreeSet* probe)
+            : a_(a.begin()), a_end_(a.end()), b_(b.begin()), b_end_(b.end()), probe_(probe) {}
+        
+        template<typename G>
+        bool next_with(G&& g) {
+            if (probe_) {
+                while (a_ != a_end_) {
+                    const T& x = *a_;
+                    ++a_;
+                    if (probe_->contains(x) == InBoth) {
+                        g(x);
+                        return true;
+                    }
+                }
+                return false;
+            }
+            for (;;) {
+                bool has_a = a_ != a_end_;
+                bool has_b = b_ != b_end_;
+                if ((!has_a && !InOther) || (!has_b && !InSelf) || (!has_a && !has_b)) {
+                    return false;
+                }
+                if (!has_b || (has_a && comp_(*a_, *b_))) {
+                    const T& x = *a_;
+                    ++a_;
+                    if (InSelf) { g(x); return true; }
+                } else if (!has_a || comp_(*b_, *a_)) {
+                    const T& x = *b_;
+                    ++b_;
+                    if (InOther) { g(x); return true; }
+                } else {
+                    const T& x = *a_;
+                    ++a_;
+                    ++b_;
+                    if (InBoth) { g(x); return true; }
+                }
+            }
+        }
+    };
+    
+    typedef SetOp<true, true, true> Union;
+    typedef SetOp<false, true, false> Intersection;
+    typedef SetOp<true, false, false> Difference;
+    typedef SetOp<true, false, true> SymmetricDifference;
+    
+    // @lifetime: (&'a, &'a) -> &'a
+    Union union_iter(const BTreeSet& other) const {
+        return Union(*this, other, nullptr);
+    }
+    
+    // @lifetime: (&'a, &'a) -> &'a
+    Intersection intersection_iter(const BTreeSet& other) const {
+        if (other.len() / LOOKUP_RATIO > len()) return Intersection(*this, other, &other);
+        if (len() / LOOKUP_RATIO > other.len()) return Intersection(other, *this, this);
+        return Intersection(*this, other, nullptr);
+    }
+    
+    // @lifetime: (&'a, &'a) -> &'a
+    Difference difference_iter(const BTreeSet& other) const {
+        // A probe yields elements that are not in the other set
+        if (other.len() / LOOKUP_RATIO > len()) return Difference(*this, other, &other);
+        return Difference(*this, other, nullptr);
+    }
+    
+    // @lifetime: (&'a, &'a) -> &'a
+    SymmetricDifference symmetric_difference_iter(const BTreeSet& other) const {
+        return SymmetricDifference(*this, other, nullptr);
+    }
+    
     // Convert to Vec (in sorted order)
     // @lifetime: owned
     Vec<T> to_vec() const {
@@ -378,6 +544,16 @@ public:
         return result;
     }
     
+private:
+    // Bulk-load the elements of a sorted lazy set operation
+    template<typename Op>
+    // @lifetime: owned
+    BTreeSet collect_sorted(Op op) const {
+        typedef UnitEntries<detail::IterCursor<Op>> Entries;
+        return BTreeSet(Map::from_sorted_iter(Entries{op.begin()}, Entries{op.end()}, allocator()));
+    }
+    
+public:
     // Equality comparison
     bool operator==(const BTreeSet& other) const {
         return map_ == other.map_;
@@ -406,6 +582,14 @@ BTreeSet<T> btreeset_from_vec(Vec<T> vec) {
     return set;
 }
 
+template<typename T, typename Compare, typename Alloc, size_t B>
+struct is_send<BTreeSet<T, Compare, Alloc, B>>
+    : detail::all_of<is_send<T>::value, is_send<Compare>::value, is_send<Alloc>::value> {};
+
+template<typename T, typename Compare, typename Alloc, size_t B>
+struct is_sync<BTreeSet<T, Compare, Alloc, B>>
+    : detail::all_of<is_sync<T>::value, is_sync<Compare>::value, is_sync<Alloc>::value> {};
+
 // Note: For std::vector compatibility, include <vector> and use:
 // template<typename T>
 // BTreeSet<T> btreeset_from_std_vec(std::vector<T> vec) {
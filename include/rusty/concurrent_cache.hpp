@@ -0,0 +1,234 @@
+#ifndef RUSTY_CONCURRENT_CACHE_HPP
+#define RUSTY_CONCURRENT_CACHE_HPP
+
+#include <cstddef>
+#include <memory>   // for std::unique_ptr
+#include <thread>   // for std::thread::hardware_concurrency
+#include <utility>
+#include "lru.hpp"
+#include "sync.hpp"
+#include "traits.hpp"
+
+// ShardedCache<Cache> - A thread-safe bounded cache split into shards
+//
+// Each shard is an ordinary LruCache or ClockCache behind its own Mutex,
+// on its own cache line. Capacity is divided evenly, so eviction is per
+// shard: an entry is evicted when its shard is full, even if another
+// shard has room. Shards are capped so each holds at least
+// MIN_SHARD_CAPACITY entries, which keeps that skew small.
+//
+// As in ConcurrentHashMap, a key is hashed once: the bits just below the
+// top 7 pick the shard and the same hash goes to the shard's cache
+// through its *_with_hash functions.
+//
+// A cache hit updates recency, so every operation takes its shard's lock
+// exclusively; values are returned by copy (get_cloned) or handled inside
+// a closure (update). ClockCache shards hold the lock for less time on a
+// hit, since they set one bit instead of relinking the recency list.
+
+// @safe
+namespace rusty {
+
+template<typename Cache>
+class ShardedCache {
+public:
+    typedef typename Cache::key_type K;
+    typedef typename Cache::mapped_type V;
+
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    static constexpr size_t MAX_SHARDS = 1024;
+    static constexpr size_t MIN_SHARD_CAPACITY = 64;
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Shard {
+        Mutex<Cache> cache;
+    };
+
+    std::unique_ptr<Shard[]> shards_;
+    size_t shard_mask_;
+    unsigned shard_shift_;
+    size_t capacity_;
+    typename Cache::hasher hasher_;
+
+    static size_t round_shards(size_t n) {
+        if (n > MAX_SHARDS) n = MAX_SHARDS;
+        size_t shards = 1;
+        while (shards < n) {
+            shards <<= 1;
+        }
+        return shards;
+    }
+
+    Shard& shard_for(size_t hash) const {
+        return shards_[(hash >> shard_shift_) & shard_mask_];
+    }
+
+    void init(size_t capacity, size_t shard_count) {
+        size_t shards = round_shards(shard_count);
+        while (shards > 1 && capacity / shards < MIN_SHARD_CAPACITY) {
+            shards >>= 1;
+        }
+        shards_.reset(new Shard[shards]);
+        shard_mask_ = shards - 1;
+
+        unsigned bits = 0;
+        while ((size_t(1) << bits) < shards) {
+            bits++;
+        }
+        shard_shift_ = unsigned(sizeof(size_t) * 8) - 7 - bits;
+
+        size_t per_shard = (capacity + shards - 1) / shards;
+        capacity_ = per_shard * shards;
+        for (size_t i = 0; i < shards; i++) {
+            shards_[i].cache.get_mut() = Cache::new_(per_shard);
+        }
+    }
+
+public:
+    // Default shard count: 4 shards per hardware thread, like
+    // ConcurrentHashMap
+    static size_t default_shard_count() {
+        unsigned threads = std::thread::hardware_concurrency();
+        return round_shards(threads > 0 ? size_t(threads) * 4 : 16);
+    }
+
+    // Constructors
+    explicit ShardedCache(size_t capacity) {
+        init(capacity, default_shard_count());
+    }
+
+    ShardedCache(size_t capacity, size_t shard_count) {
+        init(capacity, shard_count);
+    }
+
+    // @lifetime: owned
+    static ShardedCache new_(size_t capacity) {
+        return ShardedCache(capacity);
+    }
+
+    // @lifetime: owned
+    static ShardedCache with_shards(size_t capacity, size_t shard_count) {
+        return ShardedCache(capacity, shard_count);
+    }
+
+    ShardedCache(ShardedCache&&) = default;
+    ShardedCache& operator=(ShardedCache&&) = default;
+    ShardedCache(const ShardedCache&) = delete;
+    ShardedCache& operator=(const ShardedCache&) = delete;
+
+    size_t shard_count() const { return shard_mask_ + 1; }
+
+    // Total capacity: the requested capacity rounded up to a multiple of
+    // the shard count
+    size_t cap() const { return capacity_; }
+
+    // Sum of the shard sizes, each read under its lock; only a snapshot
+    // while other threads are writing
+    size_t len() const {
+        size_t total = 0;
+        for (size_t i = 0; i <= shard_mask_; i++) {
+            total += shards_[i].cache.lock()->len();
+        }
+        return total;
+    }
+
+    bool is_empty() const { return len() == 0; }
+
+    // Copy of the value for key, marking it used
+    // @lifetime: owned
+    Option<V> get_cloned(const K& key) const {
+        size_t hash = hasher_(key);
+        MutexGuard<Cache> cache = shard_for(hash).cache.lock();
+        Option<V&> value = cache->get_with_hash(key, hash);
+        if (value.is_none()) return None;
+        return Option<V>(detail::clone_value<V>(value.unwrap()));
+    }
+
+    bool contains(const K& key) const {
+        size_t hash = hasher_(key);
+        return shard_for(hash).cache.lock()->contains(key);
+    }
+
+    // Run f(V&) on the value under the shard's lock, marking it used.
+    // Returns false if the key is absent.
+    template<typename F>
+    bool update(const K& key, F f) const {
+        size_t hash = hasher_(key);
+        MutexGuard<Cache> cache = shard_for(hash).cache.lock();
+        Option<V&> value = cache->get_with_hash(key, hash);
+        if (value.is_none()) return false;
+        f(value.unwrap());
+        return true;
+    }
+
+    // Insert or update, returning the previous value for key
+    // @lifetime: owned
+    Option<V> put(K key, V value) const {
+        size_t hash = hasher_(key);
+        return shard_for(hash).cache.lock()->put_with_hash(std::move(key), std::move(value), hash);
+    }
+
+    // Insert or update, returning the entry that left the shard
+    // @lifetime: owned
+    Option<std::pair<K, V>> push(K key, V value) const {
+        size_t hash = hasher_(key);
+        return shard_for(hash).cache.lock()->push_with_hash(std::move(key), std::move(value), hash);
+    }
+
+    // Copy of the value for key, inserting f() first if absent. f runs
+    // under the shard's lock, so concurrent misses on one key call it once.
+    template<typename F>
+    // @lifetime: owned
+    V get_or_insert_with(K key, F f) const {
+        size_t hash = hasher_(key);
+        MutexGuard<Cache> cache = shard_for(hash).cache.lock();
+        Option<V&> value = cache->get_with_hash(key, hash);
+        if (value.is_some()) return detail::clone_value<V>(value.unwrap());
+        V fresh = f();
+        V result = detail::clone_value<V>(fresh);
+        cache->put_with_hash(std::move(key), std::move(fresh), hash);
+        return result;
+    }
+
+    // @lifetime: owned
+    Option<V> remove(const K& key) const {
+        size_t hash = hasher_(key);
+        return shard_for(hash).cache.lock()->remove_with_hash(key, hash);
+    }
+
+    // Remove every entry, one shard at a time
+    void clear() const {
+        for (size_t i = 0; i <= shard_mask_; i++) {
+            shards_[i].cache.lock()->clear();
+        }
+    }
+
+    // Call f(key, value) for every entry, locking one shard at a time
+    template<typename F>
+    void for_each(F f) const {
+        for (size_t i = 0; i <= shard_mask_; i++) {
+            shards_[i].cache.lock()->for_each(f);
+        }
+    }
+};
+
+template<typename Cache>
+constexpr size_t ShardedCache<Cache>::CACHE_LINE_SIZE;
+
+template<typename Cache>
+constexpr size_t ShardedCache<Cache>::MAX_SHARDS;
+
+template<typename Cache>
+constexpr size_t ShardedCache<Cache>::MIN_SHARD_CAPACITY;
+
+template<typename K, typename V, typename Hash = FxHash<K>, typename KeyEqual = std::equal_to<K>,
+         typename Alloc = Global>
+using ConcurrentLruCache = ShardedCache<LruCache<K, V, Hash, KeyEqual, Alloc>>;
+
+template<typename K, typename V, typename Hash = FxHash<K>, typename KeyEqual = std::equal_to<K>,
+         typename Alloc = Global>
+using ConcurrentClockCache = ShardedCache<ClockCache<K, V, Hash, KeyEqual, Alloc>>;
+
+} // namespace rusty
+
+#endif // RUSTY_CONCURRENT_CACHE_HPP
@@ -0,0 +1,391 @@
+#ifndef RUSTY_CONCURRENT_HASHMAP_HPP
+#define RUSTY_CONCURRENT_HASHMAP_HPP
+
+#include <cstddef>
+#include <memory>        // for std::unique_ptr
+#include <mutex>         // for std::unique_lock
+#include <shared_mutex>  // for std::shared_mutex, std::shared_lock
+#include <thread>        // for std::thread::hardware_concurrency
+#include <type_traits>
+#include <utility>
+#include "fwd.hpp"
+#include "hashmap.hpp"
+
+// ConcurrentHashMap<K, V> - A thread-safe hash map split into shards
+// Equivalent to Rust's dashmap::DashMap
+//
+// The key space is split over a power-of-two number of shards. Each shard
+// is an ordinary SwissTable HashMap behind its own reader-writer lock and
+// sits on its own cache line, so threads touching different shards never
+// contend and lookups in the same shard only share a read lock.
+//
+// A key is hashed once: the bits just below the top 7 (which the table
+// uses for its control bytes) pick the shard, and the same hash is passed
+// to the shard's table through the *_with_hash functions.
+//
+// Access goes through guards: get() returns a ReadGuard holding the shard's
+// read lock, get_mut() a WriteGuard holding its write lock. A guard borrows
+// the map, and the shard stays locked until it is dropped, so calling back
+// into the same map while holding a guard may deadlock (as in DashMap).
+// Use the closure-based functions (update, get_cloned, for_each) to keep
+// the critical section short.
+
+// @safe
+namespace rusty {
+
+template<typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+class ConcurrentHashMap {
+public:
+    using Map = HashMap<K, V, Hash, KeyEqual, Alloc>;
+
+    static constexpr size_t CACHE_LINE_SIZE = 64;
+    static constexpr size_t MAX_SHARDS = 1024;
+
+private:
+    // Enables the heterogeneous lookup overloads for key-like types Q
+    template<typename Q>
+    using if_transparent = typename std::enable_if<
+        detail::is_transparent<Hash>::value && detail::is_transparent<KeyEqual>::value &&
+        !std::is_same<Q, K>::value, int>::type;
+
+    struct alignas(CACHE_LINE_SIZE) Shard {
+        mutable std::shared_mutex lock;
+        Map map;
+
+        Shard() = default;
+    };
+
+    std::unique_ptr<Shard[]> shards_;
+    size_t shard_mask_;
+    unsigned shard_shift_;
+    Hash hasher_;
+
+    static size_t round_shards(size_t n) {
+        if (n > MAX_SHARDS) n = MAX_SHARDS;
+        size_t shards = 1;
+        while (shards < n) {
+            shards <<= 1;
+        }
+        return shards;
+    }
+
+    template<typename Q>
+    size_t hash_of(const Q& key) const {
+        return hasher_(key);
+    }
+
+    Shard& shard_for(size_t hash) const {
+        return shards_[(hash >> shard_shift_) & shard_mask_];
+    }
+
+    void init(size_t shard_count, size_t capacity, const Alloc& alloc) {
+        size_t shards = round_shards(shard_count);
+        shards_.reset(new Shard[shards]);
+        shard_mask_ = shards - 1;
+
+        unsigned bits = 0;
+        while ((size_t(1) << bits) < shards) {
+            bits++;
+        }
+        shard_shift_ = unsigned(sizeof(size_t) * 8) - 7 - bits;
+
+        size_t per_shard = (capacity + shards - 1) / shards;
+        for (size_t i = 0; i < shards; i++) {
+            shards_[i].map = Map::with_capacity_in(per_shard, alloc);
+        }
+    }
+
+    template<typename Q>
+    Option<V> get_cloned_impl(const Q& key) const {
+        size_t hash = hash_of(key);
+        Shard& shard = shard_for(hash);
+        std::shared_lock<std::shared_mutex> lock(shard.lock);
+        auto value = shard.map.get_with_hash(key, hash);
+        if (value.is_none()) {
+            return None;
+        }
+        return Option<V>(V(value.unwrap()));
+    }
+
+    template<typename Q>
+    bool contains_key_impl(const Q& key) const {
+        size_t hash = hash_of(key);
+        Shard& shard = shard_for(hash);
+        std::shared_lock<std::shared_mutex> lock(shard.lock);
+        return shard.map.get_with_hash(key, hash).is_some();
+    }
+
+public:
+    // ReadGuard - Shared access to one value; holds its shard's read lock
+    class ReadGuard {
+    private:
+        std::shared_lock<std::shared_mutex> lock_;
+        const V* value_;
+
+    public:
+        ReadGuard(std::shared_lock<std::shared_mutex> lock, const V* value)
+            : lock_(std::move(lock)), value_(value) {}
+
+        ReadGuard(ReadGuard&&) = default;
+        ReadGuard& operator=(ReadGuard&&) = default;
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+        // @lifetime: (&'a) -> &'a
+        const V& operator*() const { return *value_; }
+
+        // @lifetime: (&'a) -> &'a
+        const V* operator->() const { return value_; }
+    };
+
+    // WriteGuard - Exclusive access to one value; holds its shard's write lock
+    class WriteGuard {
+    private:
+        std::unique_lock<std::shared_mutex> lock_;
+        V* value_;
+
+    public:
+        WriteGuard(std::unique_lock<std::shared_mutex> lock, V* value)
+            : lock_(std::move(lock)), value_(value) {}
+
+        WriteGuard(WriteGuard&&) = default;
+        WriteGuard& operator=(WriteGuard&&) = default;
+        WriteGuard(const WriteGuard&) = delete;
+        WriteGuard& operator=(const WriteGuard&) = delete;
+
+        // @lifetime: (&'a mut) -> &'a mut
+        V& operator*() { return *value_; }
+
+        // @lifetime: (&'a mut) -> &'a mut
+        V* operator->() { return value_; }
+
+        // @lifetime: (&'a) -> &'a
+        const V& operator*() const { return *value_; }
+
+        // @lifetime: (&'a) -> &'a
+        const V* operator->() const { return value_; }
+    };
+
+    // Default shard count: 4 shards per hardware thread, like DashMap
+    static size_t default_shard_count() {
+        unsigned threads = std::thread::hardware_concurrency();
+        return round_shards(threads > 0 ? size_t(threads) * 4 : 16);
+    }
+
+    // Constructors
+    ConcurrentHashMap() {
+        init(default_shard_count(), 0, Alloc());
+    }
+
+    explicit ConcurrentHashMap(size_t shard_count, size_t capacity = 0,
+                               const Alloc& alloc = Alloc()) {
+        init(shard_count, capacity, alloc);
+    }
+
+    // @lifetime: owned
+    static ConcurrentHashMap new_() {
+        return ConcurrentHashMap();
+    }
+
+    // Capacity is spread evenly over the shards
+    // @lifetime: owned
+    static ConcurrentHashMap with_capacity(size_t cap) {
+        return ConcurrentHashMap(default_shard_count(), cap);
+    }
+
+    // @lifetime: owned
+    static ConcurrentHashMap with_shards(size_t shard_count) {
+        return ConcurrentHashMap(shard_count);
+    }
+
+    // @lifetime: owned
+    static ConcurrentHashMap new_in(const Alloc& alloc) {
+        return ConcurrentHashMap(default_shard_count(), 0, alloc);
+    }
+
+    // Moving needs exclusive access, so no guards can be alive; the shards
+    // themselves stay where they are
+    ConcurrentHashMap(ConcurrentHashMap&&) = default;
+    ConcurrentHashMap& operator=(ConcurrentHashMap&&) = default;
+
+    ConcurrentHashMap(const ConcurrentHashMap&) = delete;
+    ConcurrentHashMap& operator=(const ConcurrentHashMap&) = delete;
+
+    size_t shard_count() const { return shard_mask_ + 1; }
+
+    // Number of entries. Shards are counted one at a time, so the result
+    // is only a snapshot while other threads are writing.
+    size_t len() const {
+        size_t total = 0;
+        for (size_t i = 0; i <= shard_mask_; i++) {
+            std::shared_lock<std::shared_mutex> lock(shards_[i].lock);
+            total += shards_[i].map.len();
+        }
+        return total;
+    }
+
+    bool is_empty() const { return len() == 0; }
+
+    // Insert or update, returning the previous value
+    Option<V> insert(K key, V value) {
+        size_t hash = hash_of(key);
+        Shard& shard = shard_for(hash);
+        std::unique_lock<std::shared_mutex> lock(shard.lock);
+        auto entry = shard.map.entry_with_hash(std::move(key), hash);
+        if (entry.is_occupied()) {
+            return Option<V>(entry.into_occupied().insert(std::move(value)));
+        }
+        entry.into_vacant().insert(std::move(value));
+        return None;
+    }
+
+    // Shared access to a value; the shard stays read-locked while the
+    // guard is alive
+    // @lifetime: (&'a) -> &'a
+    Option<ReadGuard> get(const K& key) const {
+        return get_impl(key);
+    }
+
+    template<typename Q, if_transparent<Q> = 0>
+    // @lifetime: (&'a) -> &'a
+    Option<ReadGuard> get(const Q& key) const {
+        return get_impl(key);
+    }
+
+    // Exclusive access to a value; the shard stays write-locked while the
+    // guard is alive
+    // @lifetime: (&'a) -> &'a mut
+    Option<WriteGuard> get_mut(const K& key) {
+        return get_mut_impl(key);
+    }
+
+    template<typename Q, if_transparent<Q> = 0>
+    // @lifetime: (&'a) -> &'a mut
+    Option<WriteGuard> get_mut(const Q& key) {
+        return get_mut_impl(key);
+    }
+
+    // Copy a value out without keeping the shard locked
+    // @lifetime: owned
+    Option<V> get_cloned(const K& key) const {
+        return get_cloned_impl(key);
+    }
+
+    template<typename Q, if_transparent<Q> = 0>
+    // @lifetime: owned
+    Option<V> get_cloned(const Q& key) const {
+        return get_cloned_impl(key);
+    }
+
+    bool contains_key(const K& key) const {
+        return contains_key_impl(key);
+    }
+
+    template<typename Q, if_transparent<Q> = 0>
+    bool contains_key(const Q& key) const {
+        return contains_key_impl(key);
+    }
+
+    // Remove a key, returning its value
+    Option<V> remove(const K& key) {
+        return remove_impl(key);
+    }
+
+    template<typename Q, if_transparent<Q> = 0>
+    Option<V> remove(const Q& key) {
+        return remove_impl(key);
+    }
+
+    // Run f(V&) on the value under the shard's write lock.
+    // Returns false if the key is absent.
+    template<typename F>
+    bool update(const K& key, F f) {
+        size_t hash = hash_of(key);
+        Shard& shard = shard_for(hash);
+        std::unique_lock<std::shared_mutex> lock(shard.lock);
+        auto value = shard.map.get_with_hash(key, hash);
+        if (value.is_none()) {
+            return false;
+        }
+        f(value.unwrap());
+        return true;
+    }
+
+    // Exclusive access to the value for key, inserting f() first if absent
+    // (Rust: dashmap.entry(key).or_insert_with(f))
+    template<typename F>
+    // @lifetime: (&'a) -> &'a mut
+    WriteGuard get_or_insert_with(K key, F f) {
+        size_t hash = hash_of(key);
+        Shard& shard = shard_for(hash);
+        std::unique_lock<std::shared_mutex> lock(shard.lock);
+        V& value = shard.map.entry_with_hash(std::move(key), hash).or_insert_with(f);
+        return WriteGuard(std::move(lock), &value);
+    }
+
+    // Remove every entry, one shard at a time
+    void clear() {
+        for (size_t i = 0; i <= shard_mask_; i++) {
+            std::unique_lock<std::shared_mutex> lock(shards_[i].lock);
+            shards_[i].map.clear();
+        }
+    }
+
+    // Keep only entries for which pred(key, value) is true
+    template<typename Pred>
+    void retain(Pred pred) {
+        for (size_t i = 0; i <= shard_mask_; i++) {
+            std::unique_lock<std::shared_mutex> lock(shards_[i].lock);
+            shards_[i].map.retain(pred);
+        }
+    }
+
+    // Call f(key, value) for every entry, read-locking one shard at a time
+    template<typename F>
+    void for_each(F f) const {
+        for (size_t i = 0; i <= shard_mask_; i++) {
+            std::shared_lock<std::shared_mutex> lock(shards_[i].lock);
+            for (auto kv : shards_[i].map) {
+                f(kv.first, kv.second);
+            }
+        }
+    }
+
+private:
+    template<typename Q>
+    Option<ReadGuard> get_impl(const Q& key) const {
+        size_t hash = hash_of(key);
+        Shard& shard = shard_for(hash);
+        std::shared_lock<std::shared_mutex> lock(shard.lock);
+        const Map& map = shard.map;
+        auto value = map.get_with_hash(key, hash);
+        if (value.is_none()) {
+            return None;
+        }
+        return Option<ReadGuard>(ReadGuard(std::move(lock), value.as_ptr()));
+    }
+
+    template<typename Q>
+    Option<WriteGuard> get_mut_impl(const Q& key) {
+        size_t hash = hash_of(key);
+        Shard& shard = shard_for(hash);
+        std::unique_lock<std::shared_mutex> lock(shard.lock);
+        auto value = shard.map.get_with_hash(key, hash);
+        if (value.is_none()) {
+            return None;
+        }
+        return Option<WriteGuard>(WriteGuard(std::move(lock), value.as_ptr()));
+    }
+
+    template<typename Q>
+    Option<V> remove_impl(const Q& key) {
+        size_t hash = hash_of(key);
+        Shard& shard = shard_for(hash);
+        std::unique_lock<std::shared_mutex> lock(shard.lock);
+        return shard.map.remove(key);
+    }
+};
+
+} // namespace rusty
+
+#endif // RUSTY_CONCURRENT_HASHMAP_HPP
@@ -0,0 +1,151 @@
+#ifndef RUSTY_COW_HPP
+#define RUSTY_COW_HPP
+
+#include <new>
+#include <type_traits>
+#include <utility>  // for std::move
+#include "fwd.hpp"
+
+// Cow<B, O> - Either a borrowed view B or an owned value O (Rust: Cow<'a, B>)
+//
+// For functions that usually hand their input back unchanged: they return
+// the view and allocate only when there is something to change, so callers
+// no longer pay for a defensive clone on the common path.
+//   rusty::Cow<rusty::str, rusty::String> name = s.to_lowercase();
+//   lookup(name.as_ref());            // no copy if s was already lowercase
+//
+// Guarantees:
+// - Borrowed(view) never allocates; as_ref() is a view in either state
+// - to_mut() copies a borrowed value into an owned one on first use only
+// - std::move(cow).into_owned() moves an owned value out without a copy,
+//   so `String r = s.replace(a, b);` still compiles and costs one copy at
+//   most
+// - Move-only, like the owned types; clone() keeps a borrowed Cow borrowed
+// - A borrowed Cow must not outlive what it borrows from
+// - The pair of types is tied by cow_traits<B, O>; specialize it when B
+//   cannot be built from an O or O from a B (str/String and Slice/Vec are
+//   provided with those types)
+
+// @safe
+namespace rusty {
+
+// How a Cow views its owned value and copies its borrowed one
+template<typename B, typename O>
+struct cow_traits {
+    // @lifetime: (&'a) -> &'a
+    static B borrow(const O& owned) { return B(owned); }
+
+    // @lifetime: owned
+    static O to_owned(const B& borrowed) { return O(borrowed); }
+};
+
+template<typename B, typename O>
+class Cow {
+private:
+    using Traits = cow_traits<B, O>;
+
+    union {
+        B borrowed_;
+        O owned_;
+    };
+    bool is_owned_;
+
+    struct BorrowTag {};
+    struct OwnTag {};
+
+    Cow(BorrowTag, const B& view) : is_owned_(false) { new (&borrowed_) B(view); }
+    Cow(OwnTag, O&& value) : is_owned_(true) { new (&owned_) O(std::move(value)); }
+
+    void destroy() {
+        if (is_owned_) {
+            owned_.~O();
+        } else {
+            borrowed_.~B();
+        }
+    }
+
+    void construct_from(Cow&& other) {
+        is_owned_ = other.is_owned_;
+        if (is_owned_) {
+            new (&owned_) O(std::move(other.owned_));
+        } else {
+            new (&borrowed_) B(other.borrowed_);
+        }
+    }
+
+public:
+    // Rust-style factories
+    // @lifetime: (&'a) -> &'a
+    static Cow Borrowed(B view) { return Cow(BorrowTag(), view); }
+
+    // @lifetime: owned
+    static Cow Owned(O value) { return Cow(OwnTag(), std::move(value)); }
+
+    Cow(Cow&& other) noexcept(std::is_nothrow_move_constructible<O>::value) {
+        construct_from(std::move(other));
+    }
+
+    Cow& operator=(Cow&& other) noexcept(std::is_nothrow_move_constructible<O>::value) {
+        if (this != &other) {
+            destroy();
+            construct_from(std::move(other));
+        }
+        return *this;
+    }
+
+    Cow(const Cow&) = delete;
+    Cow& operator=(const Cow&) = delete;
+
+    ~Cow() { destroy(); }
+
+    // Borrowed stays borrowed; an owned value is copied through its view
+    // @lifetime: owned
+    Cow clone() const {
+        if (is_owned_) return Owned(Traits::to_owned(Traits::borrow(owned_)));
+        return Borrowed(borrowed_);
+    }
+
+    bool is_borrowed() const { return !is_owned_; }
+    bool is_owned() const { return is_owned_; }
+
+    // The value as a view, whichever state holds it
+    // @lifetime: (&'a) -> &'a
+    B as_ref() const { return is_owned_ ? Traits::borrow(owned_) : borrowed_; }
+
+    // @lifetime: (&'a) -> &'a
+    operator B() const { return as_ref(); }
+
+    // The owned value, copied from the borrowed one the first time
+    // @lifetime: (&'a mut) -> &'a mut
+    O& to_mut() {
+        if (!is_owned_) {
+            O value = Traits::to_owned(borrowed_);
+            borrowed_.~B();
+            new (&owned_) O(std::move(value));
+            is_owned_ = true;
+        }
+        return owned_;
+    }
+
+    // Moves an owned value out; copies a borrowed one
+    // @lifetime: owned
+    O into_owned() && {
+        if (is_owned_) return std::move(owned_);
+        return Traits::to_owned(borrowed_);
+    }
+
+    // @lifetime: owned
+    operator O() && { return std::move(*this).into_owned(); }
+
+    // Compares the views, so a borrowed and an owned Cow can be equal
+    friend bool operator==(const Cow& a, const Cow& b) { return a.as_ref() == b.as_ref(); }
+    friend bool operator!=(const Cow& a, const Cow& b) { return !(a == b); }
+    friend bool operator==(const Cow& a, const B& b) { return a.as_ref() == b; }
+    friend bool operator!=(const Cow& a, const B& b) { return !(a == b); }
+    friend bool operator==(const B& a, const Cow& b) { return b == a; }
+    friend bool operator!=(const B& a, const Cow& b) { return !(b == a); }
+};
+
+} // namespace rusty
+
+#endif // RUSTY_COW_HPP
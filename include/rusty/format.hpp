@@ -0,0 +1,424 @@
+#ifndef RUSTY_FORMAT_HPP
+#define RUSTY_FORMAT_HPP
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "string.hpp"
+
+// rusty::format / rusty::write_fmt - Rust-style formatting into a String
+//
+//   rusty::String out = rusty::String::with_capacity(256);
+//   rusty::write_fmt(out, "id={} ratio={:.3} tag={:>8}\n", id, ratio, tag);
+//   auto s = rusty::format("{:08.2}|{:<6}|{:x}", 3.14159, "ab", 255);
+//
+// Placeholders follow Rust's grammar, restricted to positional arguments:
+//   {[:[[fill]align][0][width][.precision][type]]}
+// where align is one of < > ^, type is one of x X o b e, and {{ / }} are
+// literal braces. Numbers are rendered with std::to_chars into a stack
+// buffer and appended to the target, so formatting into a String with
+// enough capacity performs no allocation at all.
+//
+// Mistakes in the format string (a bad spec, too few or too many
+// arguments) throw std::invalid_argument, the counterpart of the compile
+// error Rust would report.
+//
+// Custom types opt in by specializing Display:
+//   template<> struct rusty::Display<Point> {
+//       static void fmt(const Point& p, rusty::Formatter& f) {
+//           f.write_fmt("({}, {})", p.x, p.y);
+//       }
+//   };
+
+// @safe
+namespace rusty {
+
+// Parsed contents of a {:...} placeholder
+struct FormatSpec {
+    char fill = ' ';
+    char align = 0;        // '<', '>', '^', or 0 for the type's default
+    bool zero_pad = false;
+    size_t width = 0;
+    int precision = -1;    // -1 when absent
+    char type = 0;         // 'x', 'X', 'o', 'b', 'e', or 0
+};
+
+class Formatter;
+
+// Formatting trait; specialize for user types
+template<typename T, typename Enable = void>
+struct Display;
+
+namespace detail {
+
+// Type-erased reference to one format argument
+struct FmtArg {
+    const void* value;
+    void (*fmt)(const void* value, Formatter& f);
+};
+
+inline void vwrite_fmt(Formatter& f, str fmt, const FmtArg* args, size_t count);
+
+template<typename T>
+void fmt_thunk(const void* value, Formatter& f);
+
+inline void fmt_cstr_thunk(const void* value, Formatter& f);
+
+template<typename T>
+FmtArg make_fmt_arg(const T& value) {
+    return FmtArg{&value, &fmt_thunk<T>};
+}
+
+// String literals and char buffers arrive as arrays; format their text
+template<size_t N>
+FmtArg make_fmt_arg(const char (&value)[N]) {
+    return FmtArg{value, &fmt_cstr_thunk};
+}
+
+} // namespace detail
+
+// Output sink handed to Display::fmt, carrying the current spec
+class Formatter {
+private:
+    void* out_;
+    void (*write_)(void* out, const char* bytes, size_t len);
+    FormatSpec spec_;
+
+    template<typename Alloc>
+    static void write_to_string(void* out, const char* bytes, size_t len) {
+        static_cast<BasicString<Alloc>*>(out)->push_str(str(bytes, len));
+    }
+
+    void write_fill(size_t count) {
+        char run[32];
+        std::memset(run, spec_.fill, sizeof(run));
+        while (count > 0) {
+            size_t n = count < sizeof(run) ? count : sizeof(run);
+            write_(out_, run, n);
+            count -= n;
+        }
+    }
+
+    friend void detail::vwrite_fmt(Formatter&, str, const detail::FmtArg*, size_t);
+
+public:
+    template<typename Alloc>
+    explicit Formatter(BasicString<Alloc>& out)
+        : out_(&out), write_(&write_to_string<Alloc>) {}
+
+    const FormatSpec& spec() const { return spec_; }
+
+    // Raw output, ignoring width and fill
+    void write_str(str s) { write_(out_, s.as_ptr(), s.len()); }
+    void write_char(char c) { write_(out_, &c, 1); }
+
+    // Output honouring the spec's width, fill and alignment
+    // Numeric bodies default to right alignment and support zero padding
+    // after the sign
+    void pad(str body, bool numeric = false) {
+        size_t len = body.len();
+        if (spec_.width <= len) {
+            write_str(body);
+            return;
+        }
+        size_t padding = spec_.width - len;
+
+        if (numeric && spec_.zero_pad) {
+            size_t sign = (len > 0 && (body[0] == '-' || body[0] == '+')) ? 1 : 0;
+            write_str(body.slice(0, sign));
+            char fill = spec_.fill;
+            spec_.fill = '0';
+            write_fill(padding);
+            spec_.fill = fill;
+            write_str(body.slice(sign, len));
+            return;
+        }
+
+        char align = spec_.align ? spec_.align : (numeric ? '>' : '<');
+        size_t before = align == '>' ? padding : (align == '^' ? padding / 2 : 0);
+        write_fill(before);
+        write_str(body);
+        write_fill(padding - before);
+    }
+
+    // Format nested arguments into the same output (Rust's write!(f, ...))
+    template<typename... Args>
+    void write_fmt(str fmt, const Args&... args) {
+        detail::FmtArg packed[sizeof...(Args) + 1] = {detail::make_fmt_arg(args)...};
+        Formatter nested(*this);
+        nested.spec_ = FormatSpec();
+        detail::vwrite_fmt(nested, fmt, packed, sizeof...(Args));
+    }
+};
+
+// Integers (bool and char are formatted as text below)
+template<typename T>
+struct Display<T, typename std::enable_if<std::is_integral<T>::value &&
+                                          !std::is_same<T, bool>::value &&
+                                          !std::is_same<T, char>::value>::type> {
+    static void fmt(T value, Formatter& f) {
+        int base = 10;
+        switch (f.spec().type) {
+            case 'x': case 'X': base = 16; break;
+            case 'o': base = 8; break;
+            case 'b': base = 2; break;
+            case 0: break;
+            default: throw std::invalid_argument("format: bad type for an integer");
+        }
+        char buf[sizeof(T) * 8 + 2];
+        char* end = std::to_chars(buf, buf + sizeof(buf), value, base).ptr;
+        if (f.spec().type == 'X') {
+            for (char* p = buf; p != end; ++p) {
+                if (*p >= 'a' && *p <= 'f') *p = static_cast<char>(*p - ('a' - 'A'));
+            }
+        }
+        f.pad(str(buf, end - buf), true);
+    }
+};
+
+// Floats: shortest round-trip digits by default, {:.N} fixed, {:e} scientific
+template<typename T>
+struct Display<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+    static void fmt(T value, Formatter& f) {
+        const FormatSpec& spec = f.spec();
+        std::chars_format style = std::chars_format::fixed;
+        if (spec.type == 'e') {
+            style = std::chars_format::scientific;
+        } else if (spec.type != 0) {
+            throw std::invalid_argument("format: bad type for a float");
+        }
+
+        char buf[128];
+        std::to_chars_result r = spec.precision < 0
+            ? std::to_chars(buf, buf + sizeof(buf), value, style)
+            : std::to_chars(buf, buf + sizeof(buf), value, style, spec.precision);
+        if (r.ec == std::errc()) {
+            f.pad(str(buf, r.ptr - buf), true);
+            return;
+        }
+
+        // Huge magnitudes in fixed notation: size a buffer for the worst case
+        size_t cap = std::numeric_limits<T>::max_exponent10 + std::numeric_limits<T>::max_digits10 +
+                     8 + static_cast<size_t>(spec.precision < 0 ? 0 : spec.precision);
+        std::unique_ptr<char[]> big(new char[cap]);
+        r = spec.precision < 0
+            ? std::to_chars(big.get(), big.get() + cap, value, style)
+            : std::to_chars(big.get(), big.get() + cap, value, style, spec.precision);
+        f.pad(str(big.get(), r.ptr - big.get()), true);
+    }
+};
+
+template<>
+struct Display<bool> {
+    static void fmt(bool value, Formatter& f) {
+        f.pad(value ? str("true", 4) : str("false", 5));
+    }
+};
+
+template<>
+struct Display<char> {
+    static void fmt(char value, Formatter& f) {
+        f.pad(str(&value, 1));
+    }
+};
+
+// Text; {:.N} keeps at most N bytes
+template<>
+struct Display<str> {
+    static void fmt(str value, Formatter& f) {
+        int precision = f.spec().precision;
+        if (precision >= 0 && static_cast<size_t>(precision) < value.len()) {
+            value = value.slice(0, precision);
+        }
+        f.pad(value);
+    }
+};
+
+template<typename Alloc>
+struct Display<BasicString<Alloc>> {
+    static void fmt(const BasicString<Alloc>& value, Formatter& f) {
+        Display<str>::fmt(value, f);
+    }
+};
+
+template<typename B, typename O>
+struct Display<Cow<B, O>> {
+    static void fmt(const Cow<B, O>& value, Formatter& f) {
+        Display<B>::fmt(value.as_ref(), f);
+    }
+};
+
+template<>
+struct Display<std::string_view> {
+    static void fmt(std::string_view value, Formatter& f) {
+        Display<str>::fmt(value, f);
+    }
+};
+
+template<>
+struct Display<std::string> {
+    static void fmt(const std::string& value, Formatter& f) {
+        Display<str>::fmt(str(value.data(), value.size()), f);
+    }
+};
+
+template<>
+struct Display<const char*> {
+    static void fmt(const char* value, Formatter& f) {
+        Display<str>::fmt(str(value), f);
+    }
+};
+
+template<>
+struct Display<char*> : Display<const char*> {};
+
+// Other pointers print their address in hex
+template<typename T>
+struct Display<T*> {
+    static void fmt(const T* value, Formatter& f) {
+        char buf[2 + sizeof(void*) * 2];
+        buf[0] = '0';
+        buf[1] = 'x';
+        char* end = std::to_chars(buf + 2, buf + sizeof(buf),
+                                  reinterpret_cast<uintptr_t>(value), 16).ptr;
+        f.pad(str(buf, end - buf));
+    }
+};
+
+namespace detail {
+
+template<typename T>
+void fmt_thunk(const void* value, Formatter& f) {
+    Display<T>::fmt(*static_cast<const T*>(value), f);
+}
+
+inline void fmt_cstr_thunk(const void* value, Formatter& f) {
+    Display<const char*>::fmt(static_cast<const char*>(value), f);
+}
+
+inline size_t parse_fmt_number(const char*& p, const char* end) {
+    size_t n = 0;
+    while (p != end && *p >= '0' && *p <= '9') {
+        n = n * 10 + static_cast<size_t>(*p - '0');
+        ++p;
+    }
+    return n;
+}
+
+// Parse the text between ':' and '}'
+inline FormatSpec parse_fmt_spec(const char* p, const char* end) {
+    FormatSpec spec;
+    auto is_align = [](char c) { return c == '<' || c == '>' || c == '^'; };
+    if (end - p >= 2 && is_align(p[1])) {
+        spec.fill = p[0];
+        spec.align = p[1];
+        p += 2;
+    } else if (p != end && is_align(*p)) {
+        spec.align = *p++;
+    }
+    if (p != end && *p == '0') {
+        spec.zero_pad = true;
+        ++p;
+    }
+    spec.width = parse_fmt_number(p, end);
+    if (p != end && *p == '.') {
+        ++p;
+        if (p == end || *p < '0' || *p > '9') {
+            throw std::invalid_argument("format: missing precision");
+        }
+        spec.precision = static_cast<int>(parse_fmt_number(p, end));
+    }
+    if (p != end) {
+        char t = *p++;
+        if (t != 'x' && t != 'X' && t != 'o' && t != 'b' && t != 'e') {
+            throw std::invalid_argument("format: unknown format spec");
+        }
+        spec.type = t;
+    }
+    if (p != end) {
+        throw std::invalid_argument("format: unknown format spec");
+    }
+    return spec;
+}
+
+inline void vwrite_fmt(Formatter& f, str fmt, const FmtArg* args, size_t count) {
+    const char* p = fmt.as_ptr();
+    const char* end = p + fmt.len();
+    size_t next = 0;
+
+    while (p != end) {
+        // Copy the literal run up to the next brace
+        const char* brace = p;
+        while (brace != end && *brace != '{' && *brace != '}') ++brace;
+        if (brace != p) f.write_str(str(p, brace - p));
+        if (brace == end) break;
+
+        if (brace + 1 != end && brace[1] == *brace) {
+            f.write_char(*brace);
+            p = brace + 2;
+            continue;
+        }
+        if (*brace == '}') {
+            throw std::invalid_argument("format: unmatched '}'");
+        }
+
+        const char* close = brace + 1;
+        while (close != end && *close != '}') ++close;
+        if (close == end) {
+            throw std::invalid_argument("format: unterminated '{'");
+        }
+
+        const char* inner = brace + 1;
+        if (inner != close && *inner != ':') {
+            throw std::invalid_argument("format: only positional {} placeholders are supported");
+        }
+        f.spec_ = inner == close ? FormatSpec() : parse_fmt_spec(inner + 1, close);
+        if (next == count) {
+            throw std::invalid_argument("format: too few arguments");
+        }
+        args[next].fmt(args[next].value, f);
+        next++;
+        p = close + 1;
+    }
+
+    if (next != count) {
+        throw std::invalid_argument("format: too many arguments");
+    }
+}
+
+} // namespace detail
+
+// Append formatted text to out, using its spare capacity first
+template<typename Alloc, typename... Args>
+void write_fmt(BasicString<Alloc>& out, str fmt, const Args&... args) {
+    detail::FmtArg packed[sizeof...(Args) + 1] = {detail::make_fmt_arg(args)...};
+    Formatter f(out);
+    detail::vwrite_fmt(f, fmt, packed, sizeof...(Args));
+}
+
+// Format into a new String
+// @lifetime: owned
+template<typename... Args>
+String format(str fmt, const Args&... args) {
+    String out;
+    write_fmt(out, fmt, args...);
+    return out;
+}
+
+// Format a single value with the default spec
+// @lifetime: owned
+template<typename T>
+String to_string(const T& value) {
+    return format("{}", value);
+}
+
+} // namespace rusty
+
+#endif // RUSTY_FORMAT_HPP
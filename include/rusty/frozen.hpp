@@ -0,0 +1,579 @@
+#ifndef RUSTY_FROZEN_HPP
+#define RUSTY_FROZEN_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <utility>
+#include "alloc.hpp"
+#include "bitvec.hpp"
+#include "fwd.hpp"
+#include "hash.hpp"
+#include "option.hpp"
+#include "slice.hpp"
+#include "traits.hpp"
+#include "vec.hpp"
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+// FrozenMap<K, V> - A read-only map over a minimal perfect hash
+// Modeled on PTHash (Pibiri and Trani), like Rust's phf crate
+//
+//   Vec<std::pair<String, uint32_t>> routes = load_routes();
+//   FrozenMap<String, uint32_t> table = FrozenMap<String, uint32_t>::from_vec(std::move(routes));
+//   uint32_t port = table.get(String::from("api")).unwrap();
+//
+// The keys are fixed when the map is built; values stay mutable. Each
+// key's hash picks one of n/4 buckets, and each bucket stores a 16-bit
+// pilot chosen at build time so that its keys land on free slots. A
+// lookup is therefore one hash, one pilot load and one entry compare:
+// no probing, no control bytes and no empty slots. The entries are one
+// dense array of n pairs, so the map costs n * sizeof(pair<K, V>) plus
+// about 0.6 bytes per key.
+//
+// The slot table is 1.5% larger than n, which keeps the search for the
+// last buckets' pilots short; the few keys that land past n are sent to
+// the free slots below n through a small remap array (PTHash's minimal
+// mapping). Building is expected O(n). Duplicate keys keep the last value.
+//
+// Lookups with a key that is not in the map cost the same and return
+// None. The layout depends on Hash, so use one that is stable across the
+// program (FxHash is); HashDoS does not apply to a keyset fixed in
+// advance.
+//
+// StaticFrozenMap<K, V, N> (C++14) is the same scheme built by a constexpr
+// function, for tables fixed at compile time:
+//
+//   constexpr auto COLORS = rusty::make_static_frozen_map<std::string_view, int>(
+//       {{"red", 0xf00}, {"green", 0x0f0}, {"blue", 0x00f}});
+//   static_assert(COLORS.get_or("green", 0) == 0x0f0, "");
+
+// @safe
+namespace rusty {
+
+namespace detail {
+
+// Average keys per bucket
+constexpr size_t FROZEN_BUCKET_KEYS = 4;
+
+// Pilots tried for one bucket before starting over with a new seed
+constexpr uint32_t FROZEN_MAX_PILOT = 0xffff;
+
+constexpr uint64_t frozen_xorshift(uint64_t x, unsigned shift) { return x ^ (x >> shift); }
+
+// MurmurHash3's finalizer
+constexpr uint64_t frozen_mix(uint64_t x) {
+    return frozen_xorshift(
+        frozen_xorshift(frozen_xorshift(x, 33) * 0xff51afd7ed558ccdULL, 33) * 0xc4ceb9fe1a85ec53ULL, 33);
+}
+
+// Map a uniform 64-bit value onto [0, n) without a division
+constexpr size_t frozen_reduce(uint64_t h, size_t n) {
+#if defined(__SIZEOF_INT128__)
+    return static_cast<size_t>((static_cast<__uint128_t>(h) * n) >> 64);
+#else
+    return static_cast<size_t>(h % n);
+#endif
+}
+
+// Multiply into 128 bits and fold the halves (see hash.hpp)
+constexpr uint64_t frozen_fold(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    return static_cast<uint64_t>(static_cast<__uint128_t>(a) * b) ^
+           static_cast<uint64_t>((static_cast<__uint128_t>(a) * b) >> 64);
+#else
+    return frozen_mix(a * b);
+#endif
+}
+
+// seed_hash is frozen_mix(seed), kept by the map
+constexpr uint64_t frozen_key_hash(uint64_t hash, uint64_t seed_hash) {
+    return frozen_fold(hash ^ seed_hash, 0x9e3779b97f4a7c15ULL);
+}
+
+// The bucket takes the top bits of the key hash; the slot rehashes all
+// of them with the pilot
+constexpr size_t frozen_slot(uint64_t key_hash, uint32_t pilot, size_t slots) {
+    return frozen_reduce(frozen_fold(key_hash ^ (pilot * 0xbf58476d1ce4e5b9ULL), 0x94d049bb133111ebULL), slots);
+}
+
+// Slots for n keys: 1.5% spare
+constexpr size_t frozen_slots(size_t n) { return n + n / 64 + (n ? 1 : 0); }
+
+constexpr size_t frozen_buckets(size_t n) { return n / FROZEN_BUCKET_KEYS + 1; }
+
+} // namespace detail
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+class FrozenMap {
+public:
+    typedef std::pair<K, V> Entry;
+
+private:
+    template<typename Q>
+    using if_transparent = typename std::enable_if<
+        detail::is_transparent<Hash>::value && detail::is_transparent<KeyEqual>::value &&
+        !std::is_same<Q, K>::value, int>::type;
+
+    Vec<Entry, Alloc> entries_;    // In slot order
+    Vec<uint16_t, Alloc> pilots_;  // One per bucket
+    Vec<size_t, Alloc> remap_;     // Slots n.. -> free slots below n
+    uint64_t seed_hash_;
+    size_t buckets_;
+    size_t slots_;
+
+    explicit FrozenMap(Vec<Entry, Alloc> entries)
+        : entries_(std::move(entries)),
+          pilots_(Vec<uint16_t, Alloc>::new_in(entries_.allocator())),
+          remap_(Vec<size_t, Alloc>::new_in(entries_.allocator())),
+          seed_hash_(0), buckets_(0), slots_(0) {}
+
+    template<typename Q>
+    size_t find_index(const Q& key) const {
+        size_t n = entries_.len();
+        if (n == 0) return SIZE_MAX;
+        uint64_t h = detail::frozen_key_hash(Hash()(key), seed_hash_);
+        size_t slot = detail::frozen_slot(h, pilots_[detail::frozen_reduce(h, buckets_)], slots_);
+        if (slot >= n) slot = remap_[slot - n];
+        return KeyEqual()(entries_[slot].first, key) ? slot : SIZE_MAX;
+    }
+
+    // Bucket the keys with counting sort: bucket b's keys are
+    // order[start[b]..start[b + 1])
+    static void bucket_keys(const Vec<uint64_t>& hashes, size_t buckets, Vec<size_t>& start, Vec<size_t>& order) {
+        start.clear();
+        start.resize(buckets + 1, 0);
+        for (size_t i = 0; i < hashes.len(); i++) start[detail::frozen_reduce(hashes[i], buckets) + 1]++;
+        for (size_t b = 0; b < buckets; b++) start[b + 1] += start[b];
+        Vec<size_t> fill = start.clone();
+        order.clear();
+        order.resize(hashes.len(), 0);
+        for (size_t i = 0; i < hashes.len(); i++) order[fill[detail::frozen_reduce(hashes[i], buckets)]++] = i;
+    }
+
+    enum class Placement { Done, Reseed, Dedup };
+
+    // Choose pilots for seed_hash. Reseed when some bucket has no free
+    // pilot or two keys share a full hash; Dedup when some of those keys
+    // are equal (equal keys hash alike, so they share a bucket), after
+    // marking all but the last of each in dropped.
+    Placement place(uint64_t seed_hash, Vec<size_t>& slot_of, BitVec& dropped) {
+        size_t n = entries_.len();
+        Vec<uint64_t> hashes = Vec<uint64_t>::with_capacity(n);
+        for (size_t i = 0; i < n; i++) hashes.push(detail::frozen_key_hash(Hash()(entries_[i].first), seed_hash));
+        Vec<size_t> start, order;
+        bucket_keys(hashes, buckets_, start, order);
+        Vec<uint64_t> sorted = Vec<uint64_t>::with_capacity(n);  // Each bucket's hashes together
+        for (size_t x = 0; x < n; x++) sorted.push(hashes[order[x]]);
+
+        // Largest buckets first, while most slots are free
+        size_t largest = 0;
+        for (size_t b = 0; b < buckets_; b++) {
+            size_t size = start[b + 1] - start[b];
+            if (size > largest) largest = size;
+        }
+        Vec<size_t> by_size_start;
+        by_size_start.resize(largest + 2, 0);
+        for (size_t b = 0; b < buckets_; b++) by_size_start[largest - (start[b + 1] - start[b]) + 1]++;
+        for (size_t s = 0; s <= largest; s++) by_size_start[s + 1] += by_size_start[s];
+        Vec<size_t> by_size;
+        by_size.resize(buckets_, 0);
+        for (size_t b = 0; b < buckets_; b++) by_size[by_size_start[largest - (start[b + 1] - start[b])]++] = b;
+
+        bool duplicates = false;
+        for (size_t b = 0; b < buckets_; b++) {
+            for (size_t x = start[b]; x < start[b + 1]; x++) {
+                for (size_t y = x + 1; y < start[b + 1]; y++) {
+                    if (sorted[x] != sorted[y]) continue;
+                    // order[x] < order[y]: counting sort is stable
+                    if (!KeyEqual()(entries_[order[x]].first, entries_[order[y]].first)) return Placement::Reseed;
+                    dropped.set(order[x], true);
+                    duplicates = true;
+                }
+            }
+        }
+        if (duplicates) return Placement::Dedup;
+
+        FixedBitSet taken = FixedBitSet::with_capacity(slots_);
+        Vec<size_t> tried;
+        for (size_t k = 0; k < buckets_; k++) {
+            size_t b = by_size[k];
+            size_t first = start[b], last = start[b + 1];
+            if (first == last) break;  // Only empty buckets remain
+            uint32_t pilot = 0;
+            for (;; pilot++) {
+                if (pilot > detail::FROZEN_MAX_PILOT) return Placement::Reseed;
+                tried.clear();
+                bool fits = true;
+                for (size_t x = first; x < last && fits; x++) {
+                    size_t slot = detail::frozen_slot(sorted[x], pilot, slots_);
+                    fits = !taken.contains(slot);
+                    for (size_t t = 0; t < tried.len() && fits; t++) fits = tried[t] != slot;
+                    tried.push(slot);
+                }
+                if (fits) break;
+            }
+            pilots_[b] = static_cast<uint16_t>(pilot);
+            for (size_t x = first; x < last; x++) {
+                taken.insert(tried[x - first]);
+                slot_of[order[x]] = tried[x - first];
+            }
+        }
+
+        // Send the keys past n to the holes below it
+        remap_.clear();
+        remap_.resize(slots_ - n, 0);
+        size_t hole = 0;
+        for (size_t slot = n; slot < slots_; slot++) {
+            if (!taken.contains(slot)) continue;
+            while (taken.contains(hole)) hole++;
+            remap_[slot - n] = hole++;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (slot_of[i] >= n) slot_of[i] = remap_[slot_of[i] - n];
+        }
+        return Placement::Done;
+    }
+
+    void resize_table() {
+        size_t n = entries_.len();
+        buckets_ = detail::frozen_buckets(n);
+        slots_ = detail::frozen_slots(n);
+        pilots_.clear();
+        pilots_.resize(buckets_, 0);
+    }
+
+public:
+    FrozenMap() : FrozenMap(Vec<Entry, Alloc>()) {}
+
+    // @lifetime: owned
+    static FrozenMap new_() { return FrozenMap(); }
+
+    // Build from entries; for equal keys the last one wins
+    // @lifetime: owned
+    static FrozenMap from_vec(Vec<Entry, Alloc> entries) {
+        FrozenMap map(std::move(entries));
+        if (map.entries_.is_empty()) return map;
+        map.resize_table();
+
+        Vec<size_t> slot_of;
+        slot_of.resize(map.entries_.len(), 0);
+        BitVec dropped = BitVec::repeat(false, map.entries_.len());
+        uint64_t seed = 0;
+        for (;;) {
+            Placement placement = map.place(detail::frozen_mix(seed), slot_of, dropped);
+            if (placement == Placement::Done) break;
+            if (placement == Placement::Reseed) {
+                seed++;
+                assert(seed < 1000 && "FrozenMap: keys do not hash apart (is Hash deterministic?)");
+                continue;
+            }
+            size_t kept_len = dropped.count_zeros();
+            Vec<Entry, Alloc> kept = Vec<Entry, Alloc>::with_capacity_in(kept_len, map.entries_.allocator());
+            for (size_t i = 0; i < map.entries_.len(); i++) {
+                if (!dropped[i]) kept.push(std::move(map.entries_[i]));
+            }
+            map.entries_ = std::move(kept);
+            map.resize_table();
+            slot_of.truncate(kept_len);
+            dropped = BitVec::repeat(false, kept_len);
+        }
+        map.seed_hash_ = detail::frozen_mix(seed);
+        size_t n = map.entries_.len();
+
+        // Move each entry to its slot
+        Vec<size_t> key_at;
+        key_at.resize(n, 0);
+        for (size_t i = 0; i < n; i++) key_at[slot_of[i]] = i;
+        Vec<Entry, Alloc> placed = Vec<Entry, Alloc>::with_capacity_in(n, map.entries_.allocator());
+        for (size_t slot = 0; slot < n; slot++) placed.push(std::move(map.entries_[key_at[slot]]));
+        map.entries_ = std::move(placed);
+        return map;
+    }
+
+    // @lifetime: owned
+    FrozenMap clone() const {
+        Vec<Entry, Alloc> entries = Vec<Entry, Alloc>::with_capacity_in(entries_.len(), entries_.allocator());
+        for (size_t i = 0; i < entries_.len(); i++) {
+            entries.push(Entry(detail::clone_value(entries_[i].first), detail::clone_value(entries_[i].second)));
+        }
+        FrozenMap copy(std::move(entries));
+        copy.pilots_ = pilots_.clone();
+        copy.remap_ = remap_.clone();
+        copy.seed_hash_ = seed_hash_;
+        copy.buckets_ = buckets_;
+        copy.slots_ = slots_;
+        return copy;
+    }
+
+    size_t len() const { return entries_.len(); }
+    bool is_empty() const { return entries_.is_empty(); }
+
+    // @lifetime: (&'a) -> &'a
+    Option<const V&> get(const K& key) const {
+        size_t i = find_index(key);
+        if (i == SIZE_MAX) return None;
+        return Option<const V&>(entries_[i].second);
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    Option<V&> get_mut(const K& key) {
+        size_t i = find_index(key);
+        if (i == SIZE_MAX) return None;
+        return Option<V&>(entries_[i].second);
+    }
+
+    bool contains_key(const K& key) const { return find_index(key) != SIZE_MAX; }
+
+    // The key's position in [0, len()): a minimal perfect hash, usable
+    // to index side arrays
+    Option<size_t> get_index_of(const K& key) const {
+        size_t i = find_index(key);
+        if (i == SIZE_MAX) return None;
+        return Option<size_t>(i);
+    }
+
+    // @lifetime: (&'a) -> &'a
+    Option<std::pair<const K*, const V*>> get_key_value(const K& key) const {
+        size_t i = find_index(key);
+        if (i == SIZE_MAX) return None;
+        return Option<std::pair<const K*, const V*>>(std::make_pair(&entries_[i].first, &entries_[i].second));
+    }
+
+    // Heterogeneous lookup (see HashMap)
+    template<typename Q, if_transparent<Q> = 0>
+    // @lifetime: (&'a) -> &'a
+    Option<const V&> get(const Q& key) const {
+        size_t i = find_index(key);
+        if (i == SIZE_MAX) return None;
+        return Option<const V&>(entries_[i].second);
+    }
+
+    template<typename Q, if_transparent<Q> = 0>
+    // @lifetime: (&'a mut) -> &'a mut
+    Option<V&> get_mut(const Q& key) {
+        size_t i = find_index(key);
+        if (i == SIZE_MAX) return None;
+        return Option<V&>(entries_[i].second);
+    }
+
+    template<typename Q, if_transparent<Q> = 0>
+    bool contains_key(const Q& key) const { return find_index(key) != SIZE_MAX; }
+
+    template<typename Q, if_transparent<Q> = 0>
+    Option<size_t> get_index_of(const Q& key) const {
+        size_t i = find_index(key);
+        if (i == SIZE_MAX) return None;
+        return Option<size_t>(i);
+    }
+
+    // @lifetime: (&'a) -> &'a
+    Option<std::pair<const K*, const V*>> get_index(size_t index) const {
+        if (index >= entries_.len()) return None;
+        return Option<std::pair<const K*, const V*>>(
+            std::make_pair(&entries_[index].first, &entries_[index].second));
+    }
+
+    // The entries in slot order (deterministic for a given keyset)
+    // @lifetime: (&'a) -> &'a
+    Slice<Entry> as_slice() const { return entries_.as_slice(); }
+
+    // @lifetime: (&'a) -> &'a
+    SliceIter<Entry> iter() const { return entries_.iter(); }
+
+    // @lifetime: (&'a) -> &'a
+    const Entry* begin() const { return entries_.as_ptr(); }
+    // @lifetime: (&'a) -> &'a
+    const Entry* end() const { return entries_.as_ptr() + entries_.len(); }
+
+    // Take the entries back out, in slot order
+    // @lifetime: owned
+    Vec<Entry, Alloc> into_entries() && { return std::move(entries_); }
+
+    bool operator==(const FrozenMap& other) const {
+        if (len() != other.len()) return false;
+        for (const Entry& e : entries_) {
+            Option<const V&> v = other.get(e.first);
+            if (v.is_none() || !(v.unwrap() == e.second)) return false;
+        }
+        return true;
+    }
+
+    bool operator!=(const FrozenMap& other) const { return !(*this == other); }
+};
+
+#if __cpp_constexpr >= 201304L
+
+// Hashes usable in constant expressions, for StaticFrozenMap
+template<typename T>
+struct ConstHash<T, typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type> {
+    constexpr uint64_t operator()(T value) const { return detail::frozen_mix(static_cast<uint64_t>(value)); }
+};
+
+#if __cplusplus >= 201703L
+// FNV-1a: a byte at a time, so it runs at compile time
+template<>
+struct ConstHash<std::string_view> {
+    constexpr uint64_t operator()(std::string_view s) const {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (char c : s) h = (h ^ static_cast<uint8_t>(c)) * 0x100000001b3ULL;
+        return h;
+    }
+};
+#endif
+
+namespace detail {
+
+// Not constexpr: reaching it while building a constexpr table is a
+// compile error that names the problem
+inline void static_frozen_map_duplicate_key() {
+    assert(false && "StaticFrozenMap: duplicate key");
+    std::abort();
+}
+
+inline void static_frozen_map_no_pilot() {
+    assert(false && "StaticFrozenMap: no seed separates these keys");
+    std::abort();
+}
+
+} // namespace detail
+
+// A FrozenMap with N entries fixed at compile time. The slot table has
+// exactly N slots (no remap array) and buckets hold two keys on average,
+// which keeps the constexpr pilot search short. K and V must be literal
+// types that are default constructible; keys compare with ==.
+template<typename K, typename V, size_t N, typename Hash>
+class StaticFrozenMap {
+private:
+    static_assert(N > 0, "StaticFrozenMap needs at least one entry");
+    static constexpr size_t BUCKETS = N / 2 + 1;
+
+    K keys_[N];
+    V values_[N];
+    uint16_t pilots_[BUCKETS];
+    uint64_t seed_hash_;
+
+    constexpr size_t find_index(const K& key) const {
+        uint64_t h = detail::frozen_key_hash(Hash()(key), seed_hash_);
+        size_t slot = detail::frozen_slot(h, pilots_[detail::frozen_reduce(h, BUCKETS)], N);
+        return keys_[slot] == key ? slot : SIZE_MAX;
+    }
+
+    // Pilots for seed_hash, and slot_of[i] for each entry; false to retry
+    constexpr bool place(const std::pair<K, V>* entries, uint64_t seed_hash, size_t* slot_of) {
+        uint64_t hashes[N] = {};
+        size_t start[BUCKETS + 1] = {};
+        for (size_t i = 0; i < N; i++) {
+            hashes[i] = detail::frozen_key_hash(Hash()(entries[i].first), seed_hash);
+            start[detail::frozen_reduce(hashes[i], BUCKETS) + 1]++;
+        }
+        size_t largest = 0;
+        for (size_t b = 0; b < BUCKETS; b++) {
+            if (start[b + 1] > largest) largest = start[b + 1];
+            start[b + 1] += start[b];
+        }
+        size_t order[N] = {};
+        size_t fill[BUCKETS] = {};
+        for (size_t i = 0; i < N; i++) {
+            size_t b = detail::frozen_reduce(hashes[i], BUCKETS);
+            order[start[b] + fill[b]++] = i;
+        }
+
+        bool taken[N] = {};
+        size_t tried[N] = {};
+        for (size_t size = largest; size > 0; size--) {
+            for (size_t b = 0; b < BUCKETS; b++) {
+                size_t first = start[b], last = start[b + 1];
+                if (last - first != size) continue;
+                // Equal keys share a bucket and a hash
+                for (size_t x = first; x < last; x++) {
+                    for (size_t y = x + 1; y < last; y++) {
+                        if (hashes[order[x]] != hashes[order[y]]) continue;
+                        if (entries[order[x]].first == entries[order[y]].first) {
+                            detail::static_frozen_map_duplicate_key();
+                        }
+                        return false;
+                    }
+                }
+                uint32_t pilot = 0;
+                for (;; pilot++) {
+                    if (pilot > detail::FROZEN_MAX_PILOT) return false;
+                    bool fits = true;
+                    for (size_t x = first; x < last && fits; x++) {
+                        tried[x - first] = detail::frozen_slot(hashes[order[x]], pilot, N);
+                        fits = !taken[tried[x - first]];
+                        for (size_t y = first; y < x && fits; y++) fits = tried[y - first] != tried[x - first];
+                    }
+                    if (fits) break;
+                }
+                pilots_[b] = static_cast<uint16_t>(pilot);
+                for (size_t x = first; x < last; x++) {
+                    slot_of[order[x]] = tried[x - first];
+                    taken[tried[x - first]] = true;
+                }
+            }
+        }
+        return true;
+    }
+
+public:
+    constexpr explicit StaticFrozenMap(const std::pair<K, V> (&entries)[N])
+        : keys_(), values_(), pilots_(), seed_hash_(detail::frozen_mix(0)) {
+        size_t slot_of[N] = {};
+        uint64_t seed = 0;
+        while (!place(entries, seed_hash_, slot_of)) {
+            for (size_t b = 0; b < BUCKETS; b++) pilots_[b] = 0;
+            if (++seed == 64) detail::static_frozen_map_no_pilot();
+            seed_hash_ = detail::frozen_mix(seed);
+        }
+        for (size_t i = 0; i < N; i++) {
+            keys_[slot_of[i]] = entries[i].first;
+            values_[slot_of[i]] = entries[i].second;
+        }
+    }
+
+    constexpr size_t len() const { return N; }
+
+    constexpr bool contains_key(const K& key) const { return find_index(key) != SIZE_MAX; }
+
+    // The value for key, or fallback
+    constexpr V get_or(const K& key, V fallback) const {
+        size_t i = find_index(key);
+        return i == SIZE_MAX ? fallback : values_[i];
+    }
+
+    // @lifetime: (&'a) -> &'a
+    Option<const V&> get(const K& key) const {
+        size_t i = find_index(key);
+        if (i == SIZE_MAX) return None;
+        return Option<const V&>(values_[i]);
+    }
+
+    // The key's position in [0, N), or N if absent
+    constexpr size_t index_of(const K& key) const {
+        size_t i = find_index(key);
+        return i == SIZE_MAX ? N : i;
+    }
+
+    // Slot order
+    // @lifetime: (&'a) -> &'a
+    constexpr const K& key_at(size_t index) const { return keys_[index]; }
+    // @lifetime: (&'a) -> &'a
+    constexpr const V& value_at(size_t index) const { return values_[index]; }
+};
+
+// Build a StaticFrozenMap; N is deduced from the braced list
+template<typename K, typename V, size_t N>
+constexpr StaticFrozenMap<K, V, N> make_static_frozen_map(const std::pair<K, V> (&entries)[N]) {
+    return StaticFrozenMap<K, V, N>(entries);
+}
+
+#endif // __cpp_constexpr >= 201304L
+
+} // namespace rusty
+
+#endif // RUSTY_FROZEN_HPP
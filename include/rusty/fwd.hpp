@@ -0,0 +1,120 @@
+#ifndef RUSTY_FWD_HPP
+#define RUSTY_FWD_HPP
+
+#include <cstddef>     // for size_t
+#include <functional>  // for std::less, std::equal_to (default comparators)
+
+// fwd.hpp - Declarations of the rusty types without their definitions
+//
+// A header that only names rusty types - parameters and return types of
+// declared functions, pointer or reference members, friends - can include
+// fwd.hpp instead of the containers themselves, so every TU that includes
+// it skips parsing their bodies:
+//   #include "rusty/fwd.hpp"
+//   void load_routes(rusty::HashMap<rusty::String, int>& out);
+//
+// Default template arguments are given here and only here; every header
+// defining one of these types includes fwd.hpp and omits them.
+
+// @safe
+namespace rusty {
+
+// Parameters of the defaults below
+struct Global;
+template<typename T> struct FxHash;
+struct SeparateSlots;
+struct RcNodes;
+struct ArcNodes;
+template<typename T, typename Enable = void> struct ConstHash;
+
+// Owning and shared pointers
+template<typename T> class Box;
+template<typename T> class Rc;
+template<typename T> class Weak;
+template<typename T, size_t Align = 0> class Arc;
+template<typename T, size_t Align = 0> class ArcWeak;
+template<typename T, size_t Align = 0> class ArcSwap;
+template<typename T> class Pool;
+template<typename T> class PoolBox;
+template<typename T> class BoxSlice;
+template<typename T> class RcSlice;
+template<typename T> class ArcSlice;
+class ArcStr;
+
+// Locks
+template<typename T> class Mutex;
+template<typename T> class RwLock;
+
+// Values and views
+template<typename T> class Option;
+template<typename T, typename E> class Result;
+template<typename T> class Slice;
+template<typename T> class SliceMut;
+template<typename B, typename O> class Cow;
+class str;
+template<typename Alloc = Global> class BasicString;
+using String = BasicString<>;
+template<size_t N> class ArrayString;
+class Rope;
+
+// Sequences
+template<typename T, typename Alloc = Global> class Vec;
+template<typename T, size_t N, typename Alloc = Global> class SmallVec;
+template<typename T, size_t N> class ArrayVec;
+template<typename... Ts> class SoaVec;
+template<typename T, typename Alloc = Global> class VecDeque;
+template<typename T, typename Compare = std::less<T>, size_t D = 2, typename Alloc = Global>
+class BinaryHeap;
+template<typename P, typename Compare = std::less<P>, size_t D = 2, typename Alloc = Global>
+class IndexedBinaryHeap;
+template<typename Alloc = Global> class BasicBitVec;
+template<typename Alloc = Global> class BasicFixedBitSet;
+typedef BasicBitVec<Global> BitVec;
+typedef BasicFixedBitSet<Global> FixedBitSet;
+
+// Maps and sets
+template<typename K, typename V, typename Hash = FxHash<K>, typename KeyEqual = std::equal_to<K>,
+         typename Alloc = Global, typename Layout = SeparateSlots>
+class HashMap;
+template<typename T, typename Hash = FxHash<T>, typename KeyEqual = std::equal_to<T>,
+         typename Alloc = Global>
+class HashSet;
+template<typename K, typename V, size_t N, typename Hash = FxHash<K>,
+         typename KeyEqual = std::equal_to<K>, typename Alloc = Global>
+class SmallMap;
+template<typename K, typename V, typename Hash = FxHash<K>, typename KeyEqual = std::equal_to<K>,
+         typename Alloc = Global>
+class IndexMap;
+template<typename K, typename V, typename Compare = std::less<K>, typename Alloc = Global,
+         size_t B = 0>
+class BTreeMap;
+template<typename T, typename Compare = std::less<T>, typename Alloc = Global, size_t B = 0>
+class BTreeSet;
+template<typename K, typename V, typename Hash = FxHash<K>, typename KeyEqual = std::equal_to<K>,
+         typename Alloc = Global>
+class FrozenMap;
+template<typename K, typename V, size_t N, typename Hash = ConstHash<K>>
+class StaticFrozenMap;
+template<typename K, typename V, typename Hash = FxHash<K>, typename KeyEqual = std::equal_to<K>,
+         typename Share = RcNodes>
+class PersistentMap;
+template<typename T, typename Share = RcNodes> class PersistentVec;
+template<typename K, typename V, typename Hash = FxHash<K>, typename KeyEqual = std::equal_to<K>,
+         typename Alloc = Global>
+class ConcurrentHashMap;
+template<typename K, typename V, typename Hash = FxHash<K>, typename KeyEqual = std::equal_to<K>,
+         typename Alloc = Global>
+class LruCache;
+template<typename K, typename V, typename Hash = FxHash<K>, typename KeyEqual = std::equal_to<K>,
+         typename Alloc = Global>
+class ClockCache;
+
+// Arenas and interning
+class Arena;
+template<typename T, typename Alloc = Global> class Slab;
+class Symbol;
+class Interner;
+
+} // namespace rusty
+
+#endif // RUSTY_FWD_HPP
@@ -0,0 +1,139 @@
+#ifndef RUSTY_HASH_HPP
+#define RUSTY_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+// FxHash<T> - Fast non-cryptographic hasher, the default for HashMap/HashSet
+// Similar to rustc's FxHasher, with a folded-multiply finalizer (as in
+// wyhash/foldhash) so that every output bit depends on every input bit.
+//
+// HashMap uses the low bits of a hash to pick a bucket and the top 7 bits
+// as the H2 tag, so identity hashes such as std::hash<int> on libstdc++
+// make every small integer key collide on its tag. FxHash<T>:
+// - mixes integers, enums and pointers with one 128-bit multiply
+// - hashes byte strings 16 bytes at a time (see hash_bytes)
+// - falls back to finalizing std::hash<T> for any other type
+//
+// Not resistant to HashDoS; do not use it for keys an attacker chooses.
+
+// @safe
+namespace rusty {
+namespace detail {
+
+constexpr uint64_t HASH_SEED0 = 0x243f6a8885a308d3ULL;  // Digits of pi
+constexpr uint64_t HASH_SEED1 = 0x13198a2e03707344ULL;
+constexpr uint64_t HASH_SEED2 = 0xa4093822299f31d0ULL;
+
+// Multiply into 128 bits and fold the halves together
+inline uint64_t folded_multiply(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = static_cast<__uint128_t>(a) * b;
+    return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+#else
+    // Portable 64x64 -> 128 multiply
+    uint64_t a_lo = a & 0xffffffff, a_hi = a >> 32;
+    uint64_t b_lo = b & 0xffffffff, b_hi = b >> 32;
+    uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo;
+    uint64_t lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+    uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+    uint64_t upper = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+    uint64_t lower = (cross << 32) | (lo_lo & 0xffffffff);
+    return lower ^ upper;
+#endif
+}
+
+inline uint64_t read_u64(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t read_u32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+} // namespace detail
+
+// Hash a single 64-bit word
+inline size_t hash_u64(uint64_t x) {
+    return static_cast<size_t>(
+        detail::folded_multiply(x ^ detail::HASH_SEED0, detail::HASH_SEED1));
+}
+
+// Hash a byte string
+inline size_t hash_bytes(const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint64_t seed = detail::HASH_SEED0 ^ len;
+    uint64_t a, b;
+
+    if (len <= 16) {
+        if (len >= 8) {
+            a = detail::read_u64(p);
+            b = detail::read_u64(p + len - 8);
+        } else if (len >= 4) {
+            a = detail::read_u32(p);
+            b = detail::read_u32(p + len - 4);
+        } else if (len > 0) {
+            a = (uint64_t(p[0]) << 16) | (uint64_t(p[len / 2]) << 8) | p[len - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        // Fold 16-byte chunks into the seed; the last 16 bytes (possibly
+        // overlapping the previous chunk) are mixed below
+        while (len > 16) {
+            seed = detail::folded_multiply(detail::read_u64(p) ^ detail::HASH_SEED1,
+                                           detail::read_u64(p + 8) ^ seed);
+            p += 16;
+            len -= 16;
+        }
+        a = detail::read_u64(p + len - 16);
+        b = detail::read_u64(p + len - 8);
+    }
+
+    return static_cast<size_t>(detail::folded_multiply(
+        a ^ detail::HASH_SEED1, b ^ detail::folded_multiply(seed, detail::HASH_SEED2)));
+}
+
+namespace detail {
+
+// Integers, enums and pointers are mixed directly
+template<typename T>
+size_t fx_hash(const T& value, std::true_type) {
+    return hash_u64(static_cast<uint64_t>(value));
+}
+
+template<typename T>
+size_t fx_hash(T* const& value, std::true_type) {
+    return hash_u64(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+}
+
+// Everything else: finalize std::hash<T>
+template<typename T>
+size_t fx_hash(const T& value, std::false_type) {
+    return hash_u64(static_cast<uint64_t>(std::hash<T>()(value)));
+}
+
+template<typename T>
+struct is_fx_word : std::integral_constant<bool,
+    std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value> {};
+
+} // namespace detail
+
+template<typename T>
+struct FxHash {
+    size_t operator()(const T& value) const noexcept {
+        return detail::fx_hash(value, detail::is_fx_word<T>());
+    }
+};
+
+} // namespace rusty
+
+#endif // RUSTY_HASH_HPP
@@ -6,8 +6,15 @@
 #include <cstring>
 #include <utility>
 #include <functional>
-#include <immintrin.h>  // For SSE2/AVX2 intrinsics
+#include <type_traits>
+#include "alloc.hpp"
+#include "fwd.hpp"
+#include "hash.hpp"
+#include "iter.hpp"
 #include "option.hpp"
+#include "result.hpp"
+#include "stats.hpp"
+#include "traits.hpp"
 #include "vec.hpp"
 
 // Swiss Table HashMap - High-performance hash table based on Google's SwissTable/Abseil
@@ -19,6 +26,37 @@
 // - Quadratic probing for better cache locality
 // - Robin Hood hashing for reduced probe distances
 // - Load factor of 7/8 for better memory efficiency
+// - One allocation per table: control bytes and slots share a block
+// - FxHash<K> by default (see hash.hpp), which mixes well into the H2 bits
+// - Pluggable allocator (see alloc.hpp) for arenas and per-NUMA pools
+
+// Group backend, selected at compile time:
+// - AVX2: 32 control bytes per group (opt in with -DRUSTY_HASHMAP_AVX2 on AVX2 targets)
+// - SSE2: 16 control bytes per group (default on x86-64)
+// - NEON: 8 control bytes per group (default on little-endian ARM)
+// - SWAR: 8 control bytes in a uint64_t (portable fallback, force with
+//   -DRUSTY_HASHMAP_SWAR)
+#if defined(RUSTY_HASHMAP_SWAR)
+#define RUSTY_GROUP_SWAR 1
+#elif defined(RUSTY_HASHMAP_AVX2) && defined(__AVX2__)
+#define RUSTY_GROUP_AVX2 1
+#elif defined(__SSE2__)
+#define RUSTY_GROUP_SSE2 1
+#elif defined(__ARM_NEON) && defined(__ARM_ARCH_ISA_A64) && \
+      defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define RUSTY_GROUP_NEON 1
+#else
+#define RUSTY_GROUP_SWAR 1
+#endif
+
+// Only the AVX2 path needs <immintrin.h>; <emmintrin.h> is a tenth of its size
+#if defined(RUSTY_GROUP_AVX2)
+#include <immintrin.h>
+#elif defined(RUSTY_GROUP_SSE2)
+#include <emmintrin.h>
+#elif defined(RUSTY_GROUP_NEON)
+#include <arm_neon.h>
+#endif
 
 // @safe
 namespace rusty {
@@ -40,60 +78,145 @@ inline bool is_full(uint8_t ctrl) {
     return ctrl < DELETED;
 }
 
-// Group size for SIMD operations (16 bytes for SSE2)
+#if defined(RUSTY_GROUP_AVX2)
+constexpr size_t GROUP_SIZE = 32;
+#elif defined(RUSTY_GROUP_SSE2)
 constexpr size_t GROUP_SIZE = 16;
+#else
+constexpr size_t GROUP_SIZE = 8;
+#endif
+
+#if defined(RUSTY_GROUP_AVX2) || defined(RUSTY_GROUP_SSE2)
+// One bit per control byte (movemask)
+using GroupWord = uint32_t;
+constexpr size_t BITMASK_STRIDE = 1;
+#else
+// The high bit of each byte (0x80 per matching byte)
+using GroupWord = uint64_t;
+constexpr size_t BITMASK_STRIDE = 8;
+#endif
+
+inline size_t bit_trailing_zeros(uint32_t x) { return __builtin_ctz(x); }
+inline size_t bit_trailing_zeros(uint64_t x) { return __builtin_ctzll(x); }
+inline size_t bit_leading_zeros(uint32_t x) { return __builtin_clz(x); }
+inline size_t bit_leading_zeros(uint64_t x) { return __builtin_clzll(x); }
+
+// Set of slot offsets within a group, lowest first
+struct BitMask {
+    GroupWord bits;
+    
+    bool any() const { return bits != 0; }
+    explicit operator bool() const { return any(); }
+    
+    // Offset of the first set slot (must be any())
+    size_t lowest() const { return bit_trailing_zeros(bits) / BITMASK_STRIDE; }
+    
+    void clear_lowest() { bits &= bits - 1; }
+    
+    // Number of unset slots before the first set one (GROUP_SIZE if none)
+    size_t trailing_zeros() const {
+        return bits ? lowest() : GROUP_SIZE;
+    }
+    
+    // Number of unset slots after the last set one (GROUP_SIZE if none)
+    size_t leading_zeros() const {
+        if (!bits) return GROUP_SIZE;
+        size_t unused = sizeof(GroupWord) * 8 - GROUP_SIZE * BITMASK_STRIDE;
+        return (bit_leading_zeros(bits) - unused) / BITMASK_STRIDE;
+    }
+};
+
+#if defined(RUSTY_GROUP_SWAR)
+// Byte-wise helpers for the SWAR backend
+constexpr uint64_t SWAR_LSB = 0x0101010101010101ULL;
+constexpr uint64_t SWAR_MSB = 0x8080808080808080ULL;
+#endif
 
 // Portable SIMD group operations
 struct Group {
-    uint8_t bytes[GROUP_SIZE];
+#if defined(RUSTY_GROUP_AVX2)
+    __m256i vec;
+#elif defined(RUSTY_GROUP_SSE2)
+    __m128i vec;
+#elif defined(RUSTY_GROUP_NEON)
+    uint8x8_t vec;
+#else
+    uint64_t word;
+#endif
     
-    // Load group from control bytes
+    // Load group from control bytes (unaligned)
     static Group load(const uint8_t* ctrl) {
         Group g;
-        std::memcpy(g.bytes, ctrl, GROUP_SIZE);
+#if defined(RUSTY_GROUP_AVX2)
+        g.vec = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ctrl));
+#elif defined(RUSTY_GROUP_SSE2)
+        g.vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+#elif defined(RUSTY_GROUP_NEON)
+        g.vec = vld1_u8(ctrl);
+#else
+        std::memcpy(&g.word, ctrl, sizeof(g.word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        // Keep byte 0 in the low bits so lowest() is the first slot
+        g.word = __builtin_bswap64(g.word);
+#endif
+#endif
         return g;
     }
     
-    // Match bytes equal to value (returns bitmask)
-    uint32_t match_byte(uint8_t value) const {
-        uint32_t mask = 0;
-        
-#ifdef __SSE2__
-        // SSE2 accelerated version
-        __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
-        __m128i match = _mm_set1_epi8(value);
-        __m128i cmp = _mm_cmpeq_epi8(group, match);
-        mask = _mm_movemask_epi8(cmp);
+    // Match bytes equal to value
+    // SWAR may report a false positive right after a true match, which is
+    // harmless because every candidate's key is compared anyway.
+    BitMask match_byte(uint8_t value) const {
+#if defined(RUSTY_GROUP_AVX2)
+        __m256i cmp = _mm256_cmpeq_epi8(vec, _mm256_set1_epi8(static_cast<char>(value)));
+        return BitMask{static_cast<uint32_t>(_mm256_movemask_epi8(cmp))};
+#elif defined(RUSTY_GROUP_SSE2)
+        __m128i cmp = _mm_cmpeq_epi8(vec, _mm_set1_epi8(static_cast<char>(value)));
+        return BitMask{static_cast<uint32_t>(_mm_movemask_epi8(cmp))};
+#elif defined(RUSTY_GROUP_NEON)
+        uint8x8_t cmp = vceq_u8(vec, vdup_n_u8(value));
+        return BitMask{vget_lane_u64(vreinterpret_u64_u8(cmp), 0) & 0x8080808080808080ULL};
 #else
-        // Portable fallback
-        for (size_t i = 0; i < GROUP_SIZE; i++) {
-            if (bytes[i] == value) {
-                mask |= (1u << i);
-            }
-        }
+        uint64_t x = word ^ (SWAR_LSB * value);
+        return BitMask{(x - SWAR_LSB) & ~x & SWAR_MSB};
 #endif
-        return mask;
     }
     
-    // Match empty slots (EMPTY or DELETED)
-    uint32_t match_empty_or_deleted() const {
-        uint32_t mask = 0;
-        
-#ifdef __SSE2__
-        // SSE2 version: check if high bit is set
-        __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
-        __m128i high_bit = _mm_set1_epi8(0x80);
-        __m128i cmp = _mm_and_si128(group, high_bit);
-        mask = _mm_movemask_epi8(cmp);
+    // Match EMPTY slots only (exact on every backend)
+    BitMask match_empty() const {
+#if defined(RUSTY_GROUP_SWAR)
+        // EMPTY is the only control byte with both of the top two bits set
+        return BitMask{word & (word << 1) & SWAR_MSB};
 #else
-        // Portable fallback
-        for (size_t i = 0; i < GROUP_SIZE; i++) {
-            if (is_empty_or_deleted(bytes[i])) {
-                mask |= (1u << i);
-            }
-        }
+        return match_byte(EMPTY);
+#endif
+    }
+    
+    // Match empty slots (EMPTY or DELETED): the high bit is set
+    BitMask match_empty_or_deleted() const {
+#if defined(RUSTY_GROUP_AVX2)
+        return BitMask{static_cast<uint32_t>(_mm256_movemask_epi8(vec))};
+#elif defined(RUSTY_GROUP_SSE2)
+        return BitMask{static_cast<uint32_t>(_mm_movemask_epi8(vec))};
+#elif defined(RUSTY_GROUP_NEON)
+        uint8x8_t high = vcltz_s8(vreinterpret_s8_u8(vec));
+        return BitMask{vget_lane_u64(vreinterpret_u64_u8(high), 0) & 0x8080808080808080ULL};
+#else
+        return BitMask{word & SWAR_MSB};
+#endif
+    }
+    
+    // Match full slots: the high bit is clear
+    BitMask match_full() const {
+#if defined(RUSTY_GROUP_AVX2)
+        return BitMask{~match_empty_or_deleted().bits};
+#elif defined(RUSTY_GROUP_SSE2)
+        return BitMask{~match_empty_or_deleted().bits & 0xFFFFu};
+#elif defined(RUSTY_GROUP_NEON)
+        return BitMask{~match_empty_or_deleted().bits & 0x8080808080808080ULL};
+#else
+        return BitMask{~word & SWAR_MSB};
 #endif
-        return mask;
     }
 };
 
@@ -108,9 +231,27 @@ inline uint8_t h2_hash(size_t hash) {
     return (hash >> 57) & 0x7F;
 }
 
-// Next power of 2 that is >= n and >= 16
+// Smallest table; never less than one group so the mirrored control
+// bytes after the table cover a full group load
+constexpr size_t MIN_BUCKETS = GROUP_SIZE > 16 ? GROUP_SIZE : 16;
+
+// The control bytes of every map without a table: one group of EMPTY, so
+// lookups miss on the first load and the first insert finds no growth
+// left and allocates. Shared and never written.
+inline uint8_t* empty_ctrl_group() {
+    static_assert(GROUP_SIZE <= 32, "empty group covers one group load");
+    alignas(32) static const uint8_t group[32] = {
+        EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY,
+        EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY,
+        EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY,
+        EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY, EMPTY,
+    };
+    return const_cast<uint8_t*>(group);
+}
+
+// Next power of 2 that is >= n and >= MIN_BUCKETS
 inline size_t capacity_to_buckets(size_t n) {
-    if (n < 16) return 16;
+    if (n < MIN_BUCKETS) return MIN_BUCKETS;
     
     // Round up to next power of 2
     n--;
@@ -125,6 +266,16 @@ inline size_t capacity_to_buckets(size_t n) {
     return n;
 }
 
+// Elements a table with the given number of buckets holds at 7/8 load
+inline size_t buckets_to_growth(size_t buckets) {
+    return buckets - buckets / 8;
+}
+
+// Smallest table that holds items elements
+inline size_t items_to_buckets(size_t items) {
+    return capacity_to_buckets((items * 8 + 6) / 7);
+}
+
 // ProbeSeq generates probe indices using quadratic probing
 struct ProbeSeq {
     size_t mask;
@@ -141,68 +292,164 @@ struct ProbeSeq {
     }
 };
 
-template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
-class HashMap {
+// Slot layouts for HashMap's Layout parameter
+//
+// SeparateSlots keeps keys and values in two arrays, so probing only
+// touches keys. InterleavedSlots stores each key next to its value, so a
+// hit reads both from the same cache line; prefer it for small values that
+// are read on every lookup.
+struct SeparateSlots {};
+struct InterleavedSlots {};
+
+namespace detail {
+
+inline size_t align_to(size_t n, size_t align) {
+    return (n + align - 1) & ~(align - 1);
+}
+
+template<typename K, typename V, typename Layout>
+struct SlotLayout;
+
+// [K; buckets] [V; buckets]
+template<typename K, typename V>
+struct SlotLayout<K, V, SeparateSlots> {
+    static size_t align() { return alignof(K) > alignof(V) ? alignof(K) : alignof(V); }
+    
+    static size_t values_offset(size_t buckets) {
+        return align_to(buckets * sizeof(K), alignof(V));
+    }
+    
+    static size_t size(size_t buckets) {
+        return values_offset(buckets) + buckets * sizeof(V);
+    }
+    
+    static K* key(uint8_t* slots, size_t, size_t index) {
+        return reinterpret_cast<K*>(slots) + index;
+    }
+    
+    static V* value(uint8_t* slots, size_t buckets, size_t index) {
+        return reinterpret_cast<V*>(slots + values_offset(buckets)) + index;
+    }
+};
+
+// [(K, V); buckets]
+template<typename K, typename V>
+struct SlotLayout<K, V, InterleavedSlots> {
+    static size_t align() { return alignof(K) > alignof(V) ? alignof(K) : alignof(V); }
+    
+    static size_t value_offset() { return align_to(sizeof(K), alignof(V)); }
+    
+    static size_t stride() { return align_to(value_offset() + sizeof(V), align()); }
+    
+    static size_t size(size_t buckets) { return buckets * stride(); }
+    
+    static K* key(uint8_t* slots, size_t, size_t index) {
+        return reinterpret_cast<K*>(slots + index * stride());
+    }
+    
+    static V* value(uint8_t* slots, size_t, size_t index) {
+        return reinterpret_cast<V*>(slots + index * stride() + value_offset());
+    }
+};
+
+} // namespace detail
+
+template <typename K, typename V, typename Hash, typename KeyEqual, typename Alloc, typename Layout>
+class HashMap : private detail::AllocHolder<Alloc> {
 private:
-    // Bucket structure
-    struct Bucket {
-        // We use separate arrays for better cache locality
-        // Instead of array of structs, we have struct of arrays
-    };
+    using Slots = detail::SlotLayout<K, V, Layout>;
+    
+    // Enables the heterogeneous lookup overloads for key-like types Q
+    template<typename Q>
+    using if_transparent = typename std::enable_if<
+        detail::is_transparent<Hash>::value && detail::is_transparent<KeyEqual>::value &&
+        !std::is_same<Q, K>::value, int>::type;
     
+    // The table is one allocation: control bytes, then the slots. A map
+    // without one points at empty_ctrl_group() with a single bucket and
+    // no growth left, so new and moved-from maps allocate nothing.
     uint8_t* ctrl_;          // Control bytes (metadata)
-    K* keys_;                // Keys array
-    V* values_;              // Values array
+    uint8_t* slots_;         // Key/value storage, arranged by Layout
     size_t bucket_mask_;     // Capacity - 1 (for fast modulo)
     size_t size_;            // Number of elements
     size_t growth_left_;     // Number of elements we can add before resize
     Hash hasher_;
     KeyEqual key_eq_;
+#if defined(RUSTY_STATS)
+    stats::HashMapCounters counters_;
+#endif
     
     // Find the insert position for a key
+    // If the key is absent, index is the first EMPTY or DELETED slot on its
+    // probe sequence, so tombstones get reused
     struct FindResult {
         size_t index;
         bool found;
     };
     
-    FindResult find_insert_slot(const K& key) const {
-        size_t hash = hasher_(key);
+    FindResult find_insert_slot(const K& key, size_t hash) const {
         uint8_t h2 = h2_hash(hash);
         ProbeSeq seq(hash, bucket_mask_);
+        size_t insert_slot = static_cast<size_t>(-1);
         
         while (true) {
             Group g = Group::load(&ctrl_[seq.offset()]);
             
             // Check for matching H2 in this group
-            uint32_t matches = g.match_byte(h2);
+            BitMask matches = g.match_byte(h2);
             while (matches) {
-                size_t bit = __builtin_ctz(matches);  // Count trailing zeros
+                size_t bit = matches.lowest();
                 size_t index = (seq.offset() + bit) & bucket_mask_;
                 
-                if (key_eq_(keys_[index], key)) {
+                if (key_eq_(key_at(index), key)) {
                     return {index, true};
                 }
                 
-                matches &= matches - 1;  // Clear lowest bit
+                matches.clear_lowest();
             }
             
-            // Check for empty slot in this group
-            uint32_t empties = g.match_byte(EMPTY);
-            if (empties) {
-                size_t bit = __builtin_ctz(empties);
-                size_t index = (seq.offset() + bit) & bucket_mask_;
-                return {index, false};
+            // Remember the first free slot, but keep probing for the key
+            if (insert_slot == static_cast<size_t>(-1)) {
+                BitMask free = g.match_empty_or_deleted();
+                if (free) {
+                    insert_slot = (seq.offset() + free.lowest()) & bucket_mask_;
+                }
+            }
+            
+            // An EMPTY slot ends the probe sequence
+            if (g.match_empty()) {
+                return {insert_slot, false};
             }
             
             seq.next();
         }
     }
     
-    // Find existing key
-    size_t find_key(const K& key) const {
+    // First EMPTY or DELETED slot on the probe sequence for hash
+    size_t find_free_slot(size_t hash) const {
+        ProbeSeq seq(hash, bucket_mask_);
+        
+        while (true) {
+            BitMask free = Group::load(&ctrl_[seq.offset()]).match_empty_or_deleted();
+            if (free) {
+                return (seq.offset() + free.lowest()) & bucket_mask_;
+            }
+            seq.next();
+        }
+    }
+    
+    // Find existing key (Q is K, or any type a transparent Hash/KeyEqual accept)
+    template<typename Q>
+    size_t find_key(const Q& key) const {
+        if (size_ == 0) return static_cast<size_t>(-1);
+        return find_key_hashed(key, hasher_(key));
+    }
+    
+    // Find existing key whose hash is already known
+    template<typename Q>
+    size_t find_key_hashed(const Q& key, size_t hash) const {
         if (size_ == 0) return static_cast<size_t>(-1);
         
-        size_t hash = hasher_(key);
         uint8_t h2 = h2_hash(hash);
         ProbeSeq seq(hash, bucket_mask_);
         
@@ -210,20 +457,20 @@ private:
             Group g = Group::load(&ctrl_[seq.offset()]);
             
             // Check for matching H2
-            uint32_t matches = g.match_byte(h2);
+            BitMask matches = g.match_byte(h2);
             while (matches) {
-                size_t bit = __builtin_ctz(matches);
+                size_t bit = matches.lowest();
                 size_t index = (seq.offset() + bit) & bucket_mask_;
                 
-                if (key_eq_(keys_[index], key)) {
+                if (key_eq_(key_at(index), key)) {
                     return index;
                 }
                 
-                matches &= matches - 1;
+                matches.clear_lowest();
             }
             
             // If we see any empty (not deleted), key doesn't exist
-            if (g.match_byte(EMPTY)) {
+            if (g.match_empty()) {
                 return static_cast<size_t>(-1);
             }
             
@@ -231,118 +478,351 @@ private:
         }
     }
     
-    // Allocate storage for given capacity
+    // Lookup results for a slot index from find_key (-1 gives None)
+    Option<V&> value_ref(size_t index) {
+        if (index != static_cast<size_t>(-1)) {
+            return Option<V&>(value_at(index));
+        }
+        return None;
+    }
+    
+    Option<const V&> const_value_ref(size_t index) const {
+        if (index != static_cast<size_t>(-1)) {
+            return Option<const V&>(value_at(index));
+        }
+        return None;
+    }
+    
+    Option<std::pair<const K*, const V*>> key_value_ptr(size_t index) const {
+        if (index != static_cast<size_t>(-1)) {
+            return Option<std::pair<const K*, const V*>>(
+                Some(std::make_pair(const_cast<const K*>(&key_at(index)),
+                                    const_cast<const V*>(&value_at(index))))
+            );
+        }
+        return Option<std::pair<const K*, const V*>>(None);
+    }
+    
+    Option<V> take_value(size_t index) {
+        if (index != static_cast<size_t>(-1)) {
+            V value = std::move(value_at(index));
+            erase_slot(index);
+            return Some(std::move(value));
+        }
+        return None;
+    }
+    
+    Option<std::pair<K, V>> take_entry(size_t index) {
+        if (index != static_cast<size_t>(-1)) {
+            K k = std::move(key_at(index));
+            V v = std::move(value_at(index));
+            erase_slot(index);
+            return Some(std::make_pair(std::move(k), std::move(v)));
+        }
+        return None;
+    }
+    
+    // Slot accessors
+    K& key_at(size_t index) const {
+        return *Slots::key(slots_, bucket_mask_ + 1, index);
+    }
+    
+    V& value_at(size_t index) const {
+        return *Slots::value(slots_, bucket_mask_ + 1, index);
+    }
+    
+    // The slots start after the control bytes (plus GROUP_SIZE sentinel bytes)
+    static size_t slots_offset(size_t buckets) {
+        return detail::align_to(buckets + GROUP_SIZE, Slots::align());
+    }
+    
+    static size_t storage_size(size_t buckets) {
+        return slots_offset(buckets) + Slots::size(buckets);
+    }
+    
+    // Buckets for a table that takes capacity inserts before growing
+    static size_t buckets_for(size_t capacity) {
+        return capacity > SIZE_MAX / 8 ? SIZE_MAX : items_to_buckets(capacity);
+    }
+    
+    // Allocate storage for at least the given number of buckets
     void allocate(size_t capacity) {
+        if (try_allocate(capacity).is_err()) throw std::bad_alloc();
+    }
+    
+    // As allocate, but reports failure; nothing changes on Err
+    Result<void, AllocError> try_allocate(size_t capacity) {
+        // Keeps the bucket rounding and storage_size() from overflowing
+        const size_t max_capacity = (SIZE_MAX >> 4) / (sizeof(K) + sizeof(V) + 1);
+        if (capacity > max_capacity) {
+            return Result<void, AllocError>::Err(AllocError::capacity_overflow());
+        }
         size_t buckets = capacity_to_buckets(capacity);
-        bucket_mask_ = buckets - 1;
+        size_t bytes = storage_size(buckets);
+        void* storage = this->alloc().allocate(bytes, Slots::align());
+        if (!storage) {
+            AllocError err = {bytes, Slots::align()};
+            return Result<void, AllocError>::Err(err);
+        }
+        detail::observe_alloc(AllocKind::HashMap, storage, bytes);
         
-        // Allocate control bytes with extra GROUP_SIZE for sentinel
-        ctrl_ = static_cast<uint8_t*>(::operator new(buckets + GROUP_SIZE));
+        bucket_mask_ = buckets - 1;
+        ctrl_ = static_cast<uint8_t*>(storage);
+        slots_ = ctrl_ + slots_offset(buckets);
         std::memset(ctrl_, EMPTY, buckets + GROUP_SIZE);
         
-        // Allocate keys and values
-        keys_ = static_cast<K*>(::operator new(buckets * sizeof(K)));
-        values_ = static_cast<V*>(::operator new(buckets * sizeof(V)));
-        
-        // Set growth_left to 7/8 of capacity
-        growth_left_ = buckets - buckets / 8;
+        growth_left_ = buckets_to_growth(buckets);
+        return Result<void, AllocError>::Ok();
+    }
+    
+    // Free a table with the given number of buckets
+    void free_storage(uint8_t* ctrl, size_t buckets) {
+        detail::observe_dealloc(AllocKind::HashMap, ctrl, storage_size(buckets));
+        this->alloc().deallocate(ctrl, storage_size(buckets), Slots::align());
+    }
+    
+    // Call f(index) for each full slot in [start, end), one group of
+    // control bytes per step. f may erase the slot it is given.
+    template<typename F>
+    static void for_each_full(const uint8_t* ctrl, size_t start, size_t end, F f) {
+        for (size_t base = start; base < end; base += GROUP_SIZE) {
+            BitMask full = Group::load(&ctrl[base]).match_full();
+            while (full) {
+                size_t index = base + full.lowest();
+                full.clear_lowest();
+                if (index >= end) break;
+                f(index);
+            }
+        }
+    }
+    
+    static constexpr bool trivially_dropped() {
+        return std::is_trivially_destructible<K>::value &&
+               std::is_trivially_destructible<V>::value;
+    }
+    
+    // Run the destructors of the live elements (the control bytes are kept)
+    void destroy_elements() {
+        if (trivially_dropped() || size_ == 0) return;
+        for_each_full(ctrl_, 0, bucket_mask_ + 1, [this](size_t i) {
+            key_at(i).~K();
+            value_at(i).~V();
+        });
+    }
+    
+    bool has_table() const { return ctrl_ != empty_ctrl_group(); }
+    
+    // Point at the shared empty group, forgetting any table
+    void reset_to_empty() {
+        ctrl_ = empty_ctrl_group();
+        slots_ = nullptr;
+        bucket_mask_ = 0;
+        size_ = 0;
+        growth_left_ = 0;
     }
     
     // Deallocate all storage
     void deallocate() {
-        if (ctrl_) {
-            // Destroy live elements
+        if (has_table()) {
             size_t capacity = bucket_mask_ + 1;
-            for (size_t i = 0; i < capacity; i++) {
-                if (is_full(ctrl_[i])) {
-                    keys_[i].~K();
-                    values_[i].~V();
-                }
-            }
-            
-            ::operator delete(ctrl_);
-            ::operator delete(keys_);
-            ::operator delete(values_);
-            
-            ctrl_ = nullptr;
-            keys_ = nullptr;
-            values_ = nullptr;
+            destroy_elements();
+            free_storage(ctrl_, capacity);
+            reset_to_empty();
+        }
+    }
+    
+    // Set a control byte, mirroring the first group after the table so
+    // group loads near the end wrap around
+    void set_ctrl(size_t index, uint8_t ctrl) {
+        ctrl_[index] = ctrl;
+        if (index < GROUP_SIZE) {
+            ctrl_[index + bucket_mask_ + 1] = ctrl;
+        }
+    }
+    
+    // Take the slot found by find_insert_slot for a new element. Grows or
+    // rehashes first when that would use up the last EMPTY slot.
+    // Returns the slot to construct the key and value in.
+    size_t claim_slot(size_t hash, size_t index) {
+        if (growth_left_ == 0 && ctrl_[index] == EMPTY) {
+            reserve_rehash(1);
+            index = find_free_slot(hash);
         }
+        
+        // Reusing a tombstone does not consume growth
+        growth_left_ -= ctrl_[index] == EMPTY;
+        set_ctrl(index, h2_hash(hash));
+        size_++;
+        return index;
     }
     
-    // Resize the table
-    void resize() {
+    // Destroy the element in a full slot
+    // The slot becomes EMPTY (giving back growth) unless some probe
+    // sequence may have passed over it while the group was full, in which
+    // case it must stay a DELETED tombstone.
+    void erase_slot(size_t index) {
+        key_at(index).~K();
+        value_at(index).~V();
+        
+        size_t index_before = (index - GROUP_SIZE) & bucket_mask_;
+        BitMask empty_before = Group::load(&ctrl_[index_before]).match_empty();
+        BitMask empty_after = Group::load(&ctrl_[index]).match_empty();
+        
+        if (empty_before.leading_zeros() + empty_after.trailing_zeros() >= GROUP_SIZE) {
+            set_ctrl(index, DELETED);
+        } else {
+            set_ctrl(index, EMPTY);
+            growth_left_++;
+        }
+        size_--;
+    }
+    
+    // Make room for additional more elements: rehash in place when
+    // tombstones take up most of the table, otherwise grow
+    void reserve_rehash(size_t additional) {
+        if (try_reserve_rehash(additional).is_err()) throw std::bad_alloc();
+    }
+    
+    Result<void, AllocError> try_reserve_rehash(size_t additional) {
+        if (additional > SIZE_MAX / 8 - size_) {
+            return Result<void, AllocError>::Err(AllocError::capacity_overflow());
+        }
+        size_t new_items = size_ + additional;
+        size_t full_capacity = buckets_to_growth(bucket_mask_ + 1);
+        
+        if (new_items <= full_capacity / 2) {
+            rehash_in_place();
+#if defined(RUSTY_STATS)
+            counters_.record_rehash_in_place();
+#endif
+            return Result<void, AllocError>::Ok();
+        }
+        return try_resize(
+            items_to_buckets(new_items > full_capacity + 1 ? new_items : full_capacity + 1));
+    }
+    
+    // Move every element into a new table with the given number of buckets
+    void resize(size_t new_buckets) {
+        if (try_resize(new_buckets).is_err()) throw std::bad_alloc();
+    }
+    
+    // As resize, but reports failure; the map is unchanged on Err
+    Result<void, AllocError> try_resize(size_t new_buckets) {
         size_t old_capacity = bucket_mask_ + 1;
         uint8_t* old_ctrl = ctrl_;
-        K* old_keys = keys_;
-        V* old_values = values_;
+        uint8_t* old_slots = slots_;
         
-        // Allocate new larger table
-        size_t new_capacity = old_capacity * 2;
-        allocate(new_capacity);
+        Result<void, AllocError> allocated = try_allocate(new_buckets);
+        if (allocated.is_err()) return allocated;
         size_ = 0;
         
         // Rehash all elements
-        for (size_t i = 0; i < old_capacity; i++) {
-            if (is_full(old_ctrl[i])) {
-                insert_unique_unchecked(
-                    std::move(old_keys[i]),
-                    std::move(old_values[i])
-                );
-                old_keys[i].~K();
-                old_values[i].~V();
-            }
-        }
+        for_each_full(old_ctrl, 0, old_capacity, [&](size_t i) {
+            K* key = Slots::key(old_slots, old_capacity, i);
+            V* value = Slots::value(old_slots, old_capacity, i);
+            insert_unique_unchecked(std::move(*key), std::move(*value));
+            key->~K();
+            value->~V();
+        });
         
         // Free old storage
-        ::operator delete(old_ctrl);
-        ::operator delete(old_keys);
-        ::operator delete(old_values);
+        if (old_ctrl != empty_ctrl_group()) free_storage(old_ctrl, old_capacity);
+#if defined(RUSTY_STATS)
+        counters_.record_resize();
+#endif
+        return Result<void, AllocError>::Ok();
     }
     
-    // Insert without checking for duplicates (for resize)
-    void insert_unique_unchecked(K key, V value) {
-        size_t hash = hasher_(key);
-        uint8_t h2 = h2_hash(hash);
-        ProbeSeq seq(hash, bucket_mask_);
+    // Drop all tombstones without reallocating (hashbrown's rehash_in_place)
+    //
+    // Every full slot is first marked DELETED ("needs rehash") and every
+    // tombstone EMPTY. Each marked element then moves to the first free slot
+    // on its probe sequence, swapping with another marked element if needed.
+    void rehash_in_place() {
+        size_t buckets = bucket_mask_ + 1;
+        for (size_t i = 0; i < buckets; i++) {
+            ctrl_[i] = is_full(ctrl_[i]) ? DELETED : EMPTY;
+        }
+        std::memcpy(&ctrl_[buckets], ctrl_, GROUP_SIZE);
         
-        while (true) {
-            Group g = Group::load(&ctrl_[seq.offset()]);
-            uint32_t empties = g.match_empty_or_deleted();
+        for (size_t i = 0; i < buckets; i++) {
+            if (ctrl_[i] != DELETED) continue;
             
-            if (empties) {
-                size_t bit = __builtin_ctz(empties);
-                size_t index = (seq.offset() + bit) & bucket_mask_;
+            while (true) {
+                size_t hash = hasher_(key_at(i));
+                size_t new_index = find_free_slot(hash);
+                
+                // Already in the first group it would be probed in
+                size_t probe_start = h1_hash(hash) & bucket_mask_;
+                if (((i - probe_start) & bucket_mask_) / GROUP_SIZE ==
+                    ((new_index - probe_start) & bucket_mask_) / GROUP_SIZE) {
+                    set_ctrl(i, h2_hash(hash));
+                    break;
+                }
                 
-                ctrl_[index] = h2;
-                new (&keys_[index]) K(std::move(key));
-                new (&values_[index]) V(std::move(value));
-                size_++;
-                growth_left_--;
+                uint8_t prev_ctrl = ctrl_[new_index];
+                set_ctrl(new_index, h2_hash(hash));
                 
-                // Mirror the control byte for wraparound
-                if (index < GROUP_SIZE) {
-                    ctrl_[index + bucket_mask_ + 1] = h2;
+                if (prev_ctrl == EMPTY) {
+                    new (&key_at(new_index)) K(std::move(key_at(i)));
+                    new (&value_at(new_index)) V(std::move(value_at(i)));
+                    key_at(i).~K();
+                    value_at(i).~V();
+                    set_ctrl(i, EMPTY);
+                    break;
                 }
                 
-                return;
+                // The target still holds an element to rehash: swap and
+                // continue with that element
+                std::swap(key_at(i), key_at(new_index));
+                std::swap(value_at(i), value_at(new_index));
             }
-            
-            seq.next();
         }
+        
+        growth_left_ = buckets_to_growth(buckets) - size_;
     }
     
+    // Insert without checking for duplicates (for resize)
+    void insert_unique_unchecked(K key, V value) {
+        size_t hash = hasher_(key);
+        size_t index = find_free_slot(hash);
+        
+        set_ctrl(index, h2_hash(hash));
+        new (&key_at(index)) K(std::move(key));
+        new (&value_at(index)) V(std::move(value));
+        size_++;
+        growth_left_--;
+    }
+    
+    // A map with no table yet, for the fallible factories
+    struct NoTable {};
+    
+    explicit HashMap(NoTable)
+        : ctrl_(empty_ctrl_group()), slots_(nullptr), bucket_mask_(0), size_(0), growth_left_(0) {}
+    
+    // No table yet, with other's allocator, hasher and key equality
+    HashMap(NoTable, const HashMap& other)
+        : detail::AllocHolder<Alloc>(other.alloc()),
+          ctrl_(empty_ctrl_group()), slots_(nullptr), bucket_mask_(0), size_(0), growth_left_(0),
+          hasher_(other.hasher_), key_eq_(other.key_eq_) {}
+    
 public:
-    // Constructors
-    HashMap() : ctrl_(nullptr), keys_(nullptr), values_(nullptr),
-                     bucket_mask_(0), size_(0), growth_left_(0) {
-        allocate(16);  // Start with minimum size
+    // Constructors; nothing is allocated until the first insert (or for a
+    // capacity of 0)
+    HashMap() : HashMap(NoTable()) {}
+    
+    explicit HashMap(size_t capacity) : HashMap(NoTable()) {
+        if (capacity) allocate(buckets_for(capacity));
     }
     
-    explicit HashMap(size_t capacity) 
-        : ctrl_(nullptr), keys_(nullptr), values_(nullptr),
-          bucket_mask_(0), size_(0), growth_left_(0) {
-        allocate(capacity);
+    // Constructors taking an allocator
+    explicit HashMap(const Alloc& alloc)
+        : detail::AllocHolder<Alloc>(alloc),
+          ctrl_(empty_ctrl_group()), slots_(nullptr),
+          bucket_mask_(0), size_(0), growth_left_(0) {}
+    
+    HashMap(size_t capacity, const Alloc& alloc) : HashMap(alloc) {
+        if (capacity) allocate(buckets_for(capacity));
     }
     
     // @lifetime: owned
@@ -355,19 +835,41 @@ public:
         return HashMap(cap);
     }
     
+    // @lifetime: owned
+    static HashMap new_in(const Alloc& alloc) {
+        return HashMap(alloc);
+    }
+    
+    // @lifetime: owned
+    static HashMap with_capacity_in(size_t cap, const Alloc& alloc) {
+        return HashMap(cap, alloc);
+    }
+    
+    // HashMap::try_with_capacity(): Err instead of throwing std::bad_alloc
+    // @lifetime: owned
+    static Result<HashMap, AllocError> try_with_capacity(size_t cap) {
+        HashMap map{NoTable()};
+        if (cap == 0) return Result<HashMap, AllocError>::Ok(std::move(map));
+        Result<void, AllocError> allocated = map.try_allocate(buckets_for(cap));
+        if (allocated.is_err()) {
+            return Result<HashMap, AllocError>::Err(allocated.unwrap_err());
+        }
+        return Result<HashMap, AllocError>::Ok(std::move(map));
+    }
+    
     // Move constructor
     HashMap(HashMap&& other) noexcept
-        : ctrl_(other.ctrl_), keys_(other.keys_), values_(other.values_),
+        : detail::AllocHolder<Alloc>(std::move(other.alloc())),
+          ctrl_(other.ctrl_), slots_(other.slots_),
           bucket_mask_(other.bucket_mask_), size_(other.size_),
           growth_left_(other.growth_left_),
           hasher_(std::move(other.hasher_)),
-          key_eq_(std::move(other.key_eq_)) {
-        other.ctrl_ = nullptr;
-        other.keys_ = nullptr;
-        other.values_ = nullptr;
-        other.size_ = 0;
-        other.bucket_mask_ = 0;
-        other.growth_left_ = 0;
+          key_eq_(std::move(other.key_eq_))
+#if defined(RUSTY_STATS)
+          , counters_(other.counters_)
+#endif
+    {
+        other.reset_to_empty();
     }
     
     // Move assignment
@@ -375,21 +877,20 @@ public:
         if (this != &other) {
             deallocate();
             
+            // The allocator moves with its storage
+            this->alloc() = std::move(other.alloc());
             ctrl_ = other.ctrl_;
-            keys_ = other.keys_;
-            values_ = other.values_;
+            slots_ = other.slots_;
             bucket_mask_ = other.bucket_mask_;
             size_ = other.size_;
             growth_left_ = other.growth_left_;
             hasher_ = std::move(other.hasher_);
             key_eq_ = std::move(other.key_eq_);
+#if defined(RUSTY_STATS)
+            counters_ = other.counters_;
+#endif
             
-            other.ctrl_ = nullptr;
-            other.keys_ = nullptr;
-            other.values_ = nullptr;
-            other.size_ = 0;
-            other.bucket_mask_ = 0;
-            other.growth_left_ = 0;
+            other.reset_to_empty();
         }
         return *this;
     }
@@ -406,104 +907,233 @@ public:
     // Size and capacity
     size_t len() const { return size_; }
     bool is_empty() const { return size_ == 0; }
-    size_t capacity() const { return bucket_mask_ + 1; }
+    size_t capacity() const { return has_table() ? bucket_mask_ + 1 : 0; }
+    
+    // Get the allocator
+    const Alloc& allocator() const { return this->alloc(); }
+    
+    // Probe lengths, tombstones and load, measured by walking the table
+    // (see stats.hpp); resizes and rehashes_in_place need RUSTY_STATS
+    stats::HashMapStats stats() const {
+        stats::HashMapStats s = stats::HashMapStats();
+        s.len = size_;
+#if defined(RUSTY_STATS)
+        s.resizes = counters_.resizes;
+        s.rehashes_in_place = counters_.rehashes_in_place;
+#endif
+        if (!has_table()) return s;
+        size_t buckets = bucket_mask_ + 1;
+        s.buckets = buckets;
+        s.growth_left = growth_left_;
+        
+        for (size_t i = 0; i < buckets; i++) {
+            s.tombstones += ctrl_[i] == DELETED;
+        }
+        
+        // A key is found in the first group of its probe sequence that
+        // covers its slot
+        for_each_full(ctrl_, 0, buckets, [&](size_t i) {
+            ProbeSeq seq(hasher_(key_at(i)), bucket_mask_);
+            size_t groups = 1;
+            while (((i - seq.offset()) & bucket_mask_) >= GROUP_SIZE) {
+                seq.next();
+                groups++;
+            }
+            s.hit_probes.record(groups);
+        });
+        
+        // A miss stops at the first group with an EMPTY byte; sample one
+        // start per group
+        for (size_t start = 0; start < buckets; start += GROUP_SIZE) {
+            ProbeSeq seq(0, bucket_mask_);
+            seq.pos = start;
+            size_t groups = 1;
+            while (!Group::load(&ctrl_[seq.offset()]).match_empty() && groups <= buckets) {
+                seq.next();
+                groups++;
+            }
+            s.miss_probes.record(groups);
+        }
+        return s;
+    }
     
     // Clear all elements
     void clear() {
+        if (!has_table()) return;
         size_t capacity = bucket_mask_ + 1;
-        for (size_t i = 0; i < capacity; i++) {
-            if (is_full(ctrl_[i])) {
-                keys_[i].~K();
-                values_[i].~V();
-                ctrl_[i] = EMPTY;
-            }
-        }
+        destroy_elements();
         
-        // Reset sentinel bytes
-        std::memset(&ctrl_[capacity], EMPTY, GROUP_SIZE);
+        // Reset the control bytes, sentinel bytes included
+        std::memset(ctrl_, EMPTY, capacity + GROUP_SIZE);
         
         size_ = 0;
-        growth_left_ = capacity - capacity / 8;
+        growth_left_ = buckets_to_growth(capacity);
+    }
+    
+    // Reserve room for at least additional more elements
+    void reserve(size_t additional) {
+        if (additional > growth_left_) {
+            reserve_rehash(additional);
+        }
+    }
+    
+    // Reserve, reporting failure instead of throwing; the map is
+    // unchanged on Err
+    Result<void, AllocError> try_reserve(size_t additional) {
+        if (additional <= growth_left_) return Result<void, AllocError>::Ok();
+        return try_reserve_rehash(additional);
+    }
+    
+    // Shrink the table as much as possible while keeping all elements
+    void shrink_to_fit() {
+        shrink_to(0);
+    }
+    
+    // Shrink the table to hold at least max(len(), min_capacity) elements
+    // Also drops tombstones when the table is rebuilt, and frees the table
+    // of an empty map shrunk to 0
+    void shrink_to(size_t min_capacity) {
+        if (size_ == 0 && min_capacity == 0) {
+            deallocate();
+            return;
+        }
+        size_t target = items_to_buckets(size_ > min_capacity ? size_ : min_capacity);
+        if (target < bucket_mask_ + 1) {
+            resize(target);
+        }
     }
     
     // Insert or update
     void insert(K key, V value) {
-        if (growth_left_ == 0) {
-            resize();
-        }
+        size_t hash = hasher_(key);
+        insert_with_hash(std::move(key), std::move(value), hash);
+    }
+    
+    // Insert or update, reporting allocation failure instead of throwing.
+    // On Err the map is unchanged and key and value are dropped.
+    Result<void, AllocError> try_insert(K key, V value) {
+        size_t hash = hasher_(key);
+        auto result = find_insert_slot(key, hash);
         
-        auto result = find_insert_slot(key);
+        if (result.found) {
+            value_at(result.index) = std::move(value);
+            return Result<void, AllocError>::Ok();
+        }
+        if (growth_left_ == 0 && ctrl_[result.index] == EMPTY) {
+            Result<void, AllocError> grown = try_reserve_rehash(1);
+            if (grown.is_err()) return grown;
+            result.index = find_free_slot(hash);
+        }
+        size_t index = claim_slot(hash, result.index);
+        new (&key_at(index)) K(std::move(key));
+        new (&value_at(index)) V(std::move(value));
+        return Result<void, AllocError>::Ok();
+    }
+    
+    // Precomputed hashes
+    // hash_key() hashes a key once so it can be reused for lookups in
+    // several maps with the same hasher. Passing any other hash to the
+    // *_with_hash functions is a logic error: the key will not be found.
+    size_t hash_key(const K& key) const {
+        return hasher_(key);
+    }
+    
+    template<typename Q, if_transparent<Q> = 0>
+    size_t hash_key(const Q& key) const {
+        return hasher_(key);
+    }
+    
+    // @lifetime: (&'a) -> &'a
+    Option<V&> get_with_hash(const K& key, size_t hash) {
+        return value_ref(find_key_hashed(key, hash));
+    }
+    
+    // @lifetime: (&'a) -> &'a
+    Option<const V&> get_with_hash(const K& key, size_t hash) const {
+        return const_value_ref(find_key_hashed(key, hash));
+    }
+    
+    template<typename Q, if_transparent<Q> = 0>
+    // @lifetime: (&'a) -> &'a
+    Option<V&> get_with_hash(const Q& key, size_t hash) {
+        return value_ref(find_key_hashed(key, hash));
+    }
+    
+    template<typename Q, if_transparent<Q> = 0>
+    // @lifetime: (&'a) -> &'a
+    Option<const V&> get_with_hash(const Q& key, size_t hash) const {
+        return const_value_ref(find_key_hashed(key, hash));
+    }
+    
+    // Insert or update with a hash from hash_key()
+    void insert_with_hash(K key, V value, size_t hash) {
+        auto result = find_insert_slot(key, hash);
         
         if (result.found) {
             // Update existing value
-            values_[result.index] = std::move(value);
+            value_at(result.index) = std::move(value);
         } else {
             // Insert new entry
-            size_t hash = hasher_(key);
-            uint8_t h2 = h2_hash(hash);
-            
-            ctrl_[result.index] = h2;
-            new (&keys_[result.index]) K(std::move(key));
-            new (&values_[result.index]) V(std::move(value));
+            size_t index = claim_slot(hash, result.index);
+            new (&key_at(index)) K(std::move(key));
+            new (&value_at(index)) V(std::move(value));
+        }
+    }
+    
+    // Batched lookup: out[i] = get(keys[i]) for i < count
+    // Hashes a block of keys and prefetches their first control group and
+    // slot before probing any of them, so cache misses on large tables
+    // overlap instead of being paid one after another.
+    template<typename Q>
+    // @lifetime: (&'a) -> &'a
+    void get_many(const Q* keys, size_t count, Option<const V&>* out) const {
+        static_assert(std::is_same<Q, K>::value ||
+                      (detail::is_transparent<Hash>::value && detail::is_transparent<KeyEqual>::value),
+                      "get_many needs K keys or a transparent Hash and KeyEqual");
+        const size_t BATCH = 16;
+        size_t hashes[BATCH];
+        
+        for (size_t start = 0; start < count; start += BATCH) {
+            size_t n = count - start < BATCH ? count - start : BATCH;
             
-            // Mirror control byte for wraparound
-            if (result.index < GROUP_SIZE) {
-                ctrl_[result.index + bucket_mask_ + 1] = h2;
+            if (size_ != 0) {
+                for (size_t i = 0; i < n; i++) {
+                    hashes[i] = hasher_(keys[start + i]);
+                    size_t pos = h1_hash(hashes[i]) & bucket_mask_;
+                    __builtin_prefetch(&ctrl_[pos]);
+                    __builtin_prefetch(&key_at(pos));
+                }
             }
             
-            size_++;
-            growth_left_--;
+            for (size_t i = 0; i < n; i++) {
+                size_t index = size_ != 0 ? find_key_hashed(keys[start + i], hashes[i])
+                                          : static_cast<size_t>(-1);
+                out[start + i] = const_value_ref(index);
+            }
         }
     }
     
     // Get value by key
     // @lifetime: (&'a) -> &'a
-    Option<V*> get(const K& key) {
-        size_t index = find_key(key);
-        if (index != static_cast<size_t>(-1)) {
-            return Some(&values_[index]);
-        }
-        return None;
+    Option<V&> get(const K& key) {
+        return value_ref(find_key(key));
     }
     
     // @lifetime: (&'a) -> &'a
-    Option<const V*> get(const K& key) const {
-        size_t index = find_key(key);
-        if (index != static_cast<size_t>(-1)) {
-            return Option<const V*>(Some(const_cast<const V*>(&values_[index])));
-        }
-        return Option<const V*>(None);
+    Option<const V&> get(const K& key) const {
+        return const_value_ref(find_key(key));
     }
     
     // Get mutable reference
     // @lifetime: (&'a mut) -> &'a mut
-    Option<V*> get_mut(const K& key) {
-        size_t index = find_key(key);
-        if (index != static_cast<size_t>(-1)) {
-            return Some(&values_[index]);
-        }
-        return None;
+    Option<V&> get_mut(const K& key) {
+        return value_ref(find_key(key));
     }
     
     // Remove by key
     // @lifetime: owned
     Option<V> remove(const K& key) {
-        size_t index = find_key(key);
-        if (index != static_cast<size_t>(-1)) {
-            V value = std::move(values_[index]);
-            keys_[index].~K();
-            values_[index].~V();
-            ctrl_[index] = DELETED;
-            
-            // Mirror control byte for wraparound
-            if (index < GROUP_SIZE) {
-                ctrl_[index + bucket_mask_ + 1] = DELETED;
-            }
-            
-            size_--;
-            return Some(std::move(value));
-        }
-        return None;
+        return take_value(find_key(key));
     }
     
     // Check if key exists
@@ -511,137 +1141,289 @@ public:
         return find_key(key) != static_cast<size_t>(-1);
     }
     
-    // Entry API for get-or-insert
+    // Heterogeneous lookup: when Hash and KeyEqual are both transparent
+    // (e.g. StringHash/StringEq), keys can be looked up by any type they
+    // accept, such as str or const char* for String keys, without building
+    // a temporary K. Q must hash and compare the same as the equal K.
+    template<typename Q, if_transparent<Q> = 0>
+    // @lifetime: (&'a) -> &'a
+    Option<V&> get(const Q& key) {
+        return value_ref(find_key(key));
+    }
+    
+    template<typename Q, if_transparent<Q> = 0>
+    // @lifetime: (&'a) -> &'a
+    Option<const V&> get(const Q& key) const {
+        return const_value_ref(find_key(key));
+    }
+    
+    template<typename Q, if_transparent<Q> = 0>
     // @lifetime: (&'a mut) -> &'a mut
-    V& entry(K key) {
-        if (growth_left_ == 0) {
-            resize();
+    Option<V&> get_mut(const Q& key) {
+        return value_ref(find_key(key));
+    }
+    
+    template<typename Q, if_transparent<Q> = 0>
+    // @lifetime: owned
+    Option<V> remove(const Q& key) {
+        return take_value(find_key(key));
+    }
+    
+    template<typename Q, if_transparent<Q> = 0>
+    bool contains_key(const Q& key) const {
+        return find_key(key) != static_cast<size_t>(-1);
+    }
+    
+    template<typename Q, if_transparent<Q> = 0>
+    // @lifetime: (&'a) -> &'a
+    Option<std::pair<const K*, const V*>> get_key_value(const Q& key) const {
+        return key_value_ptr(find_key(key));
+    }
+    
+    template<typename Q, if_transparent<Q> = 0>
+    // @lifetime: owned
+    Option<std::pair<K, V>> remove_entry(const Q& key) {
+        return take_entry(find_key(key));
+    }
+    
+    // Entry API (Rust's HashMap::entry)
+    // The key is hashed and probed once; the handles below then read,
+    // update or insert without searching again:
+    //   *counts.entry(word).or_insert(0) += 1;   // Rust
+    //   counts.entry(word).or_insert(0) += 1;    // here
+    //   cache.entry(id).or_insert_with([&] { return load(id); });
+    //   map.entry(k).and_modify([](V& v) { v.bump(); }).or_default();
+    // A handle borrows the map mutably, so use it before touching the map again.
+    
+    // A slot holding the key
+    class OccupiedEntry {
+    private:
+        HashMap* map_;
+        size_t index_;
+        
+    public:
+        OccupiedEntry(HashMap* map, size_t index) : map_(map), index_(index) {}
+        
+        // @lifetime: (&'a) -> &'a
+        const K& key() const { return map_->key_at(index_); }
+        
+        // @lifetime: (&'a) -> &'a
+        V& get() { return map_->value_at(index_); }
+        
+        // @lifetime: (&'a mut) -> &'a mut
+        V& into_mut() { return map_->value_at(index_); }
+        
+        // Replace the value, returning the old one
+        // @lifetime: owned
+        V insert(V value) {
+            V old = std::move(map_->value_at(index_));
+            map_->value_at(index_) = std::move(value);
+            return old;
         }
         
-        auto result = find_insert_slot(key);
+        // @lifetime: owned
+        V remove() {
+            return map_->take_value(index_).unwrap();
+        }
         
-        if (!result.found) {
-            size_t hash = hasher_(key);
-            uint8_t h2 = h2_hash(hash);
-            
-            ctrl_[result.index] = h2;
-            new (&keys_[result.index]) K(std::move(key));
-            new (&values_[result.index]) V();
-            
-            if (result.index < GROUP_SIZE) {
-                ctrl_[result.index + bucket_mask_ + 1] = h2;
-            }
-            
-            size_++;
-            growth_left_--;
+        // @lifetime: owned
+        std::pair<K, V> remove_entry() {
+            return map_->take_entry(index_).unwrap();
         }
+    };
+    
+    // A free slot for the key, found while probing
+    class VacantEntry {
+    private:
+        HashMap* map_;
+        K key_;
+        size_t hash_;
+        size_t index_;
         
-        return values_[result.index];
-    }
+    public:
+        VacantEntry(HashMap* map, K key, size_t hash, size_t index)
+            : map_(map), key_(std::move(key)), hash_(hash), index_(index) {}
+        
+        // @lifetime: (&'a) -> &'a
+        const K& key() const { return key_; }
+        
+        // Give the key back without inserting
+        // @lifetime: owned
+        K into_key() { return std::move(key_); }
+        
+        // Insert the value; may grow the map, but never probes for the key again
+        // @lifetime: (&'a mut) -> &'a mut
+        V& insert(V value) {
+            size_t index = map_->claim_slot(hash_, index_);
+            new (&map_->key_at(index)) K(std::move(key_));
+            new (&map_->value_at(index)) V(std::move(value));
+            return map_->value_at(index);
+        }
+    };
     
-    // Get or insert with value
-    // @lifetime: (&'a mut) -> &'a mut
-    V& or_insert(K key, V default_value) {
-        if (growth_left_ == 0) {
-            resize();
+    // Either kind of entry
+    class Entry {
+    private:
+        HashMap* map_;
+        size_t hash_;
+        size_t index_;
+        bool occupied_;
+        // The caller's key, inserted if vacant. A plain K, not Option<K>:
+        // an empty Box, Arc or Rc key would read as None through the niche.
+        K key_;
+        
+    public:
+        Entry(HashMap* map, size_t hash, size_t index, bool occupied, K key)
+            : map_(map), hash_(hash), index_(index), occupied_(occupied),
+              key_(std::move(key)) {}
+        
+        bool is_occupied() const { return occupied_; }
+        bool is_vacant() const { return !occupied_; }
+        
+        // @lifetime: (&'a) -> &'a
+        const K& key() const {
+            return is_occupied() ? map_->key_at(index_) : key_;
         }
         
-        auto result = find_insert_slot(key);
+        // Switch to the specific handle (panics on the wrong kind)
+        OccupiedEntry into_occupied() {
+            if (!is_occupied()) {
+                throw std::runtime_error("Entry is vacant");
+            }
+            return OccupiedEntry(map_, index_);
+        }
         
-        if (!result.found) {
-            size_t hash = hasher_(key);
-            uint8_t h2 = h2_hash(hash);
-            
-            ctrl_[result.index] = h2;
-            new (&keys_[result.index]) K(std::move(key));
-            new (&values_[result.index]) V(std::move(default_value));
-            
-            if (result.index < GROUP_SIZE) {
-                ctrl_[result.index + bucket_mask_ + 1] = h2;
+        VacantEntry into_vacant() {
+            if (is_occupied()) {
+                throw std::runtime_error("Entry is occupied");
             }
-            
-            size_++;
-            growth_left_--;
+            return VacantEntry(map_, std::move(key_), hash_, index_);
         }
         
-        return values_[result.index];
+        // The value, inserting default_value if vacant
+        // @lifetime: (&'a mut) -> &'a mut
+        V& or_insert(V default_value) {
+            if (is_occupied()) {
+                return map_->value_at(index_);
+            }
+            return into_vacant().insert(std::move(default_value));
+        }
+        
+        // The value, inserting f() if vacant (f is only called when needed)
+        template<typename F>
+        // @lifetime: (&'a mut) -> &'a mut
+        V& or_insert_with(F f) {
+            if (is_occupied()) {
+                return map_->value_at(index_);
+            }
+            return into_vacant().insert(f());
+        }
+        
+        // Same, but f receives the key
+        template<typename F>
+        // @lifetime: (&'a mut) -> &'a mut
+        V& or_insert_with_key(F f) {
+            if (is_occupied()) {
+                return map_->value_at(index_);
+            }
+            V value = f(key_);
+            return into_vacant().insert(std::move(value));
+        }
+        
+        // @lifetime: (&'a mut) -> &'a mut
+        V& or_default() {
+            if (is_occupied()) {
+                return map_->value_at(index_);
+            }
+            return into_vacant().insert(V());
+        }
+        
+        // Run f on the value if occupied; chains into or_insert and friends
+        template<typename F>
+        Entry and_modify(F f) {
+            if (is_occupied()) {
+                f(map_->value_at(index_));
+            }
+            return std::move(*this);
+        }
+    };
+    
+    // @lifetime: (&'a mut) -> &'a mut
+    Entry entry(K key) {
+        size_t hash = hasher_(key);
+        return entry_with_hash(std::move(key), hash);
+    }
+    
+    // Entry for a key whose hash came from hash_key()
+    // @lifetime: (&'a mut) -> &'a mut
+    Entry entry_with_hash(K key, size_t hash) {
+        auto result = find_insert_slot(key, hash);
+        return Entry(this, hash, result.index, result.found, std::move(key));
+    }
+    
+    // Get or insert with value
+    // @lifetime: (&'a mut) -> &'a mut
+    V& or_insert(K key, V default_value) {
+        return entry(std::move(key)).or_insert(std::move(default_value));
     }
     
     // Get key-value pair
     // @lifetime: (&'a) -> &'a
     Option<std::pair<const K*, const V*>> get_key_value(const K& key) const {
-        size_t index = find_key(key);
-        if (index != static_cast<size_t>(-1)) {
-            return Option<std::pair<const K*, const V*>>(
-                Some(std::make_pair(&keys_[index], &values_[index]))
-            );
-        }
-        return Option<std::pair<const K*, const V*>>(None);
+        return key_value_ptr(find_key(key));
     }
     
     // Remove entry and return both key and value
     // @lifetime: owned
     Option<std::pair<K, V>> remove_entry(const K& key) {
-        size_t index = find_key(key);
-        if (index != static_cast<size_t>(-1)) {
-            K k = std::move(keys_[index]);
-            V v = std::move(values_[index]);
-            keys_[index].~K();
-            values_[index].~V();
-            ctrl_[index] = DELETED;
-            
-            if (index < GROUP_SIZE) {
-                ctrl_[index + bucket_mask_ + 1] = DELETED;
-            }
-            
-            size_--;
-            return Some(std::make_pair(std::move(k), std::move(v)));
-        }
-        return None;
+        return take_entry(find_key(key));
     }
     
     // Extend from another map
     void extend(HashMap&& other) {
-        size_t cap = other.bucket_mask_ + 1;
-        for (size_t i = 0; i < cap; i++) {
-            if (is_full(other.ctrl_[i])) {
-                insert(std::move(other.keys_[i]), std::move(other.values_[i]));
-            }
-        }
+        for_each_full(other.ctrl_, 0, other.bucket_mask_ + 1, [&](size_t i) {
+            insert(std::move(other.key_at(i)), std::move(other.value_at(i)));
+        });
         other.clear();
     }
     
     // Retain only entries matching predicate
     template<typename Pred>
     void retain(Pred pred) {
-        size_t cap = bucket_mask_ + 1;
-        for (size_t i = 0; i < cap; i++) {
-            if (is_full(ctrl_[i]) && !pred(keys_[i], values_[i])) {
-                keys_[i].~K();
-                values_[i].~V();
-                ctrl_[i] = DELETED;
-                
-                if (i < GROUP_SIZE) {
-                    ctrl_[i + bucket_mask_ + 1] = DELETED;
-                }
-                
-                size_--;
+        for_each_full(ctrl_, 0, bucket_mask_ + 1, [&](size_t i) {
+            if (!pred(key_at(i), value_at(i))) {
+                erase_slot(i);
             }
-        }
+        });
     }
     
-    // Clone for explicit copying
+    // Clone for explicit copying. The clone gets a table of the same size
+    // with every element in the same slot, so nothing is rehashed: control
+    // bytes are copied as they are, and the slots with memcpy when K and V
+    // are trivially copyable
     // @lifetime: owned
     HashMap clone() const {
-        HashMap result(capacity());
+        HashMap result(NoTable(), *this);
+        if (!has_table()) return result;
+        size_t buckets = bucket_mask_ + 1;
+        result.allocate(buckets);
         
-        size_t cap = bucket_mask_ + 1;
-        for (size_t i = 0; i < cap; i++) {
-            if (is_full(ctrl_[i])) {
-                result.insert(keys_[i], values_[i]);
-            }
+        if (std::is_trivially_copyable<K>::value && std::is_trivially_copyable<V>::value) {
+            std::memcpy(static_cast<void*>(result.slots_), slots_, Slots::size(buckets));
+        } else {
+            // Marked full only once constructed, so a throwing copy leaves
+            // result destructible
+            for_each_full(ctrl_, 0, buckets, [&](size_t i) {
+                K key(detail::clone_value(key_at(i)));
+                new (&result.value_at(i)) V(detail::clone_value(value_at(i)));
+                new (&result.key_at(i)) K(std::move(key));
+                result.set_ctrl(i, ctrl_[i]);
+                result.size_++;
+            });
         }
-        
+        std::memcpy(result.ctrl_, ctrl_, buckets + GROUP_SIZE);
+        result.size_ = size_;
+        result.growth_left_ = growth_left_;
         return result;
     }
     
@@ -651,11 +1433,20 @@ public:
         HashMap* map_;
         size_t index_;
         
+        // Skip to the next full slot a group at a time; the bytes past
+        // the table mirror its start, so a match there means the end
         void advance_to_next_full() {
             size_t capacity = map_->bucket_mask_ + 1;
-            while (index_ < capacity && !is_full(map_->ctrl_[index_])) {
-                index_++;
+            while (index_ < capacity) {
+                BitMask full = Group::load(&map_->ctrl_[index_]).match_full();
+                if (full) {
+                    index_ += full.lowest();
+                    if (index_ > capacity) index_ = capacity;
+                    return;
+                }
+                index_ += GROUP_SIZE;
             }
+            index_ = capacity;
         }
         
     public:
@@ -664,11 +1455,11 @@ public:
         }
         
         std::pair<K&, V&> operator*() {
-            return {map_->keys_[index_], map_->values_[index_]};
+            return {map_->key_at(index_), map_->value_at(index_)};
         }
         
         std::pair<K*, V*> operator->() {
-            return {&map_->keys_[index_], &map_->values_[index_]};
+            return {&map_->key_at(index_), &map_->value_at(index_)};
         }
         
         iterator& operator++() {
@@ -691,11 +1482,20 @@ public:
         const HashMap* map_;
         size_t index_;
         
+        // Skip to the next full slot a group at a time; the bytes past
+        // the table mirror its start, so a match there means the end
         void advance_to_next_full() {
             size_t capacity = map_->bucket_mask_ + 1;
-            while (index_ < capacity && !is_full(map_->ctrl_[index_])) {
-                index_++;
+            while (index_ < capacity) {
+                BitMask full = Group::load(&map_->ctrl_[index_]).match_full();
+                if (full) {
+                    index_ += full.lowest();
+                    if (index_ > capacity) index_ = capacity;
+                    return;
+                }
+                index_ += GROUP_SIZE;
             }
+            index_ = capacity;
         }
         
     public:
@@ -704,11 +1504,11 @@ public:
         }
         
         std::pair<const K&, const V&> operator*() const {
-            return {map_->keys_[index_], map_->values_[index_]};
+            return {map_->key_at(index_), map_->value_at(index_)};
         }
         
         std::pair<const K*, const V*> operator->() const {
-            return {&map_->keys_[index_], &map_->values_[index_]};
+            return {&map_->key_at(index_), &map_->value_at(index_)};
         }
         
         const_iterator& operator++() {
@@ -746,51 +1546,126 @@ public:
         return const_iterator(this, bucket_mask_ + 1);
     }
     
-    // Collect all keys
-    // @lifetime: owned
-    Vec<K> keys() const {
-        Vec<K> result = Vec<K>::with_capacity(size_);
-        size_t capacity = bucket_mask_ + 1;
+    // Lazy iterators over the entries, in bucket order
+    // (rusty::Iterator: map, filter, collect, ...)
+private:
+    struct EntryAt {
+        typedef std::pair<const K&, const V&> type;
+        static type get(const HashMap& m, size_t i) { return type(m.key_at(i), m.value_at(i)); }
+    };
+    struct EntryMutAt {
+        typedef std::pair<const K&, V&> type;
+        static type get(const HashMap& m, size_t i) { return type(m.key_at(i), m.value_at(i)); }
+    };
+    struct KeyAt {
+        typedef const K& type;
+        static type get(const HashMap& m, size_t i) { return m.key_at(i); }
+    };
+    struct ValueAt {
+        typedef const V& type;
+        static type get(const HashMap& m, size_t i) { return m.value_at(i); }
+    };
+    struct ValueMutAt {
+        typedef V& type;
+        static type get(const HashMap& m, size_t i) { return m.value_at(i); }
+    };
+    
+public:
+    template<typename At>
+    class SlotIter : public Iterator<SlotIter<At>, typename At::type> {
+    private:
+        const HashMap* map_;
+        size_t base_;       // First slot of the current group
+        BitMask full_;      // Full slots of the current group not yet visited
+        size_t remaining_;  // Stop at the last entry instead of the table end
+        
+    public:
+        explicit SlotIter(const HashMap* map)
+            : map_(map), base_(0), full_(BitMask{0}), remaining_(map->size_) {
+            if (remaining_) full_ = Group::load(map_->ctrl_).match_full();
+        }
         
-        for (size_t i = 0; i < capacity; i++) {
-            if (is_full(ctrl_[i])) {
-                result.push(keys_[i]);
+        template<typename F>
+        bool next_with(F&& f) {
+            if (remaining_ == 0) return false;
+            while (!full_) {
+                base_ += GROUP_SIZE;
+                full_ = Group::load(&map_->ctrl_[base_]).match_full();
             }
+            size_t index = base_ + full_.lowest();
+            full_.clear_lowest();
+            remaining_--;
+            f(At::get(*map_, index));
+            return true;
         }
         
-        return result;
+        size_t len() const { return remaining_; }
+        size_t size_hint() const { return remaining_; }
+    };
+    
+    typedef SlotIter<EntryAt> Iter;
+    typedef SlotIter<EntryMutAt> IterMut;
+    typedef SlotIter<KeyAt> Keys;
+    typedef SlotIter<ValueAt> Values;
+    typedef SlotIter<ValueMutAt> ValuesMut;
+    
+    // Items are std::pair<const K&, const V&>
+    // @lifetime: (&'a) -> &'a
+    Iter iter() const { return Iter(this); }
+    
+    // Items are std::pair<const K&, V&>
+    // @lifetime: (&'a mut) -> &'a mut
+    IterMut iter_mut() { return IterMut(this); }
+    
+    // Unlike keys() and values(), these borrow instead of copying into a Vec
+    // @lifetime: (&'a) -> &'a
+    Keys keys_iter() const { return Keys(this); }
+    
+    // @lifetime: (&'a) -> &'a
+    Values values_iter() const { return Values(this); }
+    
+    // @lifetime: (&'a mut) -> &'a mut
+    ValuesMut values_iter_mut() { return ValuesMut(this); }
+    
+    // Visit the entries stored in buckets [start, end) in bucket order, as
+    // f(key, value). Disjoint bucket ranges may be visited from different
+    // threads at once (see par_iter.hpp); end is at most capacity().
+    template<typename F>
+    // @lifetime: (&'a) -> &'a
+    void for_each_in_buckets(size_t start, size_t end, F f) const {
+        for_each_full(ctrl_, start, end, [&](size_t i) {
+            f(static_cast<const K&>(key_at(i)), static_cast<const V&>(value_at(i)));
+        });
+    }
+    
+    template<typename F>
+    // @lifetime: (&'a mut) -> &'a mut
+    void for_each_in_buckets_mut(size_t start, size_t end, F f) {
+        for_each_full(ctrl_, start, end, [&](size_t i) {
+            f(static_cast<const K&>(key_at(i)), value_at(i));
+        });
+    }
+    
+    // Collect all keys
+    // @lifetime: owned
+    Vec<K> keys() const {
+        return keys_iter().collect();
     }
     
     // Collect all values
     // @lifetime: owned
     Vec<V> values() const {
-        Vec<V> result = Vec<V>::with_capacity(size_);
-        size_t capacity = bucket_mask_ + 1;
-        
-        for (size_t i = 0; i < capacity; i++) {
-            if (is_full(ctrl_[i])) {
-                result.push(values_[i]);
-            }
-        }
-        
-        return result;
+        return values_iter().collect();
     }
     
     // Equality comparison
     bool operator==(const HashMap& other) const {
         if (size_ != other.size_) return false;
         
-        size_t capacity = bucket_mask_ + 1;
-        for (size_t i = 0; i < capacity; i++) {
-            if (is_full(ctrl_[i])) {
-                auto other_val = other.get(keys_[i]);
-                if (!other_val.is_some() || *other_val.unwrap() != values_[i]) {
-                    return false;
-                }
-            }
-        }
-        
-        return true;
+        return iter().all([&other](std::pair<const K&, const V&> kv) {
+            auto other_val = other.get(kv.first);
+            return other_val.is_some() && other_val.unwrap() == kv.second;
+        });
     }
     
     bool operator!=(const HashMap& other) const {
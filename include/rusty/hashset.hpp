@@ -1,6 +1,7 @@
 #ifndef RUSTY_HASHSET_HPP
 #define RUSTY_HASHSET_HPP
 
+#include "fwd.hpp"
 #include "hashmap.hpp"
 #include "vec.hpp"
 #include <functional>
@@ -10,19 +11,40 @@ namespace rusty {
 
 // HashSet implemented as a thin wrapper around HashMap<T, ()>
 // Uses unit type () as value, represented here as an empty struct
-template <typename T, typename Hash = std::hash<T>>
+template <typename T, typename Hash, typename KeyEqual, typename Alloc>
 class HashSet {
 private:
     struct Unit {  // Empty struct to represent Rust's unit type ()
         bool operator==(const Unit&) const { return true; }
         bool operator!=(const Unit&) const { return false; }
     };
-    HashMap<T, Unit, Hash> map_;
+    using Map = HashMap<T, Unit, Hash, KeyEqual, Alloc>;
+    Map map_;
+    
+    explicit HashSet(Map&& map) : map_(std::move(map)) {}
+    
+    // out ∪= (from - other), reusing each hash for the insert
+    static void append_difference(const HashSet& from, const HashSet& other, HashSet& out) {
+        for (const T& key : from) {
+            size_t hash = from.map_.hash_key(key);
+            if (other.map_.get_with_hash(key, hash).is_none()) {
+                out.map_.insert_with_hash(key, Unit{}, hash);
+            }
+        }
+    }
+    
+    // Enables the heterogeneous lookup overloads for key-like types Q
+    template<typename Q>
+    using if_transparent = typename std::enable_if<
+        detail::is_transparent<Hash>::value && detail::is_transparent<KeyEqual>::value &&
+        !std::is_same<Q, T>::value, int>::type;
     
 public:
     // Constructors
     HashSet() = default;
     
+    explicit HashSet(const Alloc& alloc) : map_(alloc) {}
+    
     // @lifetime: owned
     static HashSet new_() {
         return HashSet();
@@ -30,9 +52,26 @@ public:
     
     // @lifetime: owned
     static HashSet with_capacity(size_t cap) {
-        HashSet set;
-        set.map_ = HashMap<T, Unit, Hash>::with_capacity(cap);
-        return set;
+        return HashSet(Map::with_capacity(cap));
+    }
+    
+    // @lifetime: owned
+    static HashSet new_in(const Alloc& alloc) {
+        return HashSet(alloc);
+    }
+    
+    // @lifetime: owned
+    static HashSet with_capacity_in(size_t cap, const Alloc& alloc) {
+        return HashSet(Map::with_capacity_in(cap, alloc));
+    }
+    
+    // @lifetime: owned
+    static Result<HashSet, AllocError> try_with_capacity(size_t cap) {
+        Result<Map, AllocError> map = Map::try_with_capacity(cap);
+        if (map.is_err()) {
+            return Result<HashSet, AllocError>::Err(map.unwrap_err());
+        }
+        return Result<HashSet, AllocError>::Ok(HashSet(map.unwrap()));
     }
     
     // Move constructor
@@ -53,9 +92,7 @@ public:
     // Clone for explicit copying
     // @lifetime: owned
     HashSet clone() const {
-        HashSet result;
-        result.map_ = map_.clone();
-        return result;
+        return HashSet(map_.clone());
     }
     
     // Size and capacity
@@ -63,16 +100,50 @@ public:
     size_t capacity() const { return map_.capacity(); }
     bool is_empty() const { return map_.is_empty(); }
     
+    // The underlying map's stats (see stats.hpp)
+    stats::HashMapStats stats() const { return map_.stats(); }
+    
+    // Get the allocator
+    const Alloc& allocator() const { return map_.allocator(); }
+    
     // Clear all elements
     void clear() {
         map_.clear();
     }
     
-    // Insert element
+    // Insert element, probing once; returns true if newly inserted
     bool insert(T value) {
+        auto entry = map_.entry(std::move(value));
+        if (entry.is_occupied()) {
+            return false;
+        }
+        entry.into_vacant().insert(Unit{});
+        return true;
+    }
+    
+    // Insert, reporting allocation failure instead of throwing
+    // Ok(true) if newly inserted; the set is unchanged on Err
+    Result<bool, AllocError> try_insert(T value) {
         bool existed = map_.contains_key(value);
-        map_.insert(std::move(value), Unit{});
-        return !existed;  // Return true if newly inserted
+        Result<void, AllocError> inserted = map_.try_insert(std::move(value), Unit{});
+        if (inserted.is_err()) {
+            return Result<bool, AllocError>::Err(inserted.unwrap_err());
+        }
+        return Result<bool, AllocError>::Ok(!existed);
+    }
+    
+    // Reserve room for at least additional more elements
+    void reserve(size_t additional) {
+        map_.reserve(additional);
+    }
+    
+    Result<void, AllocError> try_reserve(size_t additional) {
+        return map_.try_reserve(additional);
+    }
+    
+    // Shrink the table as much as possible
+    void shrink_to_fit() {
+        map_.shrink_to_fit();
     }
     
     // Remove element
@@ -85,26 +156,43 @@ public:
         return map_.contains_key(value);
     }
     
-    // Get element (returns Option<const T*>)
+    // Stored element equal to value
     // @lifetime: (&'a) -> &'a
-    Option<const T*> get(const T& value) const {
-        for (const auto& [key, _] : map_) {
-            if (key == value) {
-                return Option<const T*>(Some(&key));
-            }
+    Option<const T&> get(const T& value) const {
+        auto entry = map_.get_key_value(value);
+        if (entry.is_some()) {
+            return Option<const T&>(*entry.unwrap().first);
         }
-        return Option<const T*>(None);
+        return None;
     }
     
     // Take element (remove and return)
     // @lifetime: owned
     Option<T> take(const T& value) {
-        // Since we can't directly extract the key from HashMap,
-        // we need to check if it exists first
-        if (map_.contains_key(value)) {
-            map_.remove(value);
-            // Create a copy of the value to return
-            return Some(value);
+        auto entry = map_.remove_entry(value);
+        if (entry.is_some()) {
+            return Some(std::move(entry.unwrap().first));
+        }
+        return None;
+    }
+    
+    // Heterogeneous lookup with transparent Hash and KeyEqual (see HashMap)
+    template<typename Q, if_transparent<Q> = 0>
+    bool contains(const Q& value) const {
+        return map_.contains_key(value);
+    }
+    
+    template<typename Q, if_transparent<Q> = 0>
+    bool remove(const Q& value) {
+        return map_.remove(value).is_some();
+    }
+    
+    template<typename Q, if_transparent<Q> = 0>
+    // @lifetime: (&'a) -> &'a
+    Option<const T&> get(const Q& value) const {
+        auto entry = map_.get_key_value(value);
+        if (entry.is_some()) {
+            return Option<const T&>(*entry.unwrap().first);
         }
         return None;
     }
@@ -123,28 +211,35 @@ public:
     }
     
     // Set operations
+    // intersection, difference and symmetric_difference size their result
+    // for the largest possible outcome up front, so building it never
+    // rehashes (shrink_to_fit() trims a small result). Each element is
+    // hashed once: both sets share the hasher type, so the hash found for
+    // the lookup is reused for the insert.
     
     // Union: self ∪ other (all elements from both sets)
+    // Clones the larger set (and its allocator), then adds the smaller one
     // @lifetime: owned
     HashSet union_with(const HashSet& other) const {
-        HashSet result = this->clone();
-        for (auto [key, _] : other.map_) {
-            result.insert(key);
-        }
+        const HashSet* smaller = this->len() <= other.len() ? this : &other;
+        const HashSet* larger = this->len() <= other.len() ? &other : this;
+        HashSet result = larger->clone();
+        result |= *smaller;
         return result;
     }
     
     // Intersection: self ∩ other (elements in both sets)
     // @lifetime: owned
     HashSet intersection(const HashSet& other) const {
-        HashSet result;
         // Iterate over smaller set for efficiency
         const HashSet* smaller = this->len() <= other.len() ? this : &other;
         const HashSet* larger = this->len() <= other.len() ? &other : this;
+        HashSet result = with_capacity_in(smaller->len(), allocator());
         
-        for (auto [key, _] : smaller->map_) {
-            if (larger->contains(key)) {
-                result.insert(key);
+        for (const T& key : *smaller) {
+            size_t hash = map_.hash_key(key);
+            if (larger->map_.get_with_hash(key, hash).is_some()) {
+                result.map_.insert_with_hash(key, Unit{}, hash);
             }
         }
         return result;
@@ -153,32 +248,80 @@ public:
     // Difference: self - other (elements in self but not in other)
     // @lifetime: owned
     HashSet difference(const HashSet& other) const {
-        HashSet result;
-        for (auto [key, _] : map_) {
-            if (!other.contains(key)) {
-                result.insert(key);
-            }
-        }
+        HashSet result = with_capacity_in(len(), allocator());
+        append_difference(*this, other, result);
         return result;
     }
     
     // Symmetric difference: self △ other (elements in either but not both)
     // @lifetime: owned
     HashSet symmetric_difference(const HashSet& other) const {
-        HashSet result;
-        for (auto [key, _] : map_) {
-            if (!other.contains(key)) {
-                result.insert(key);
+        HashSet result = with_capacity_in(len() + other.len(), allocator());
+        append_difference(*this, other, result);
+        append_difference(other, *this, result);
+        return result;
+    }
+    
+    // In-place set operations; these only allocate for |=
+    
+    // self = self ∪ other
+    HashSet& operator|=(const HashSet& other) {
+        // Reserve as HashMap::extend does in hashbrown: all of other into an
+        // empty set, half of it otherwise, since overlap is common
+        map_.reserve(is_empty() ? other.len() : (other.len() + 1) / 2);
+        for (const T& key : other) {
+            map_.entry(key).or_insert(Unit{});
+        }
+        return *this;
+    }
+    
+    // self = self ∩ other
+    HashSet& operator&=(const HashSet& other) {
+        map_.retain([&other](const T& key, const Unit&) {
+            return other.contains(key);
+        });
+        return *this;
+    }
+    
+    // self = self - other
+    HashSet& operator-=(const HashSet& other) {
+        // Walk whichever side is smaller
+        if (other.len() < len()) {
+            for (const T& key : other) {
+                map_.remove(key);
             }
+        } else {
+            map_.retain([&other](const T& key, const Unit&) {
+                return !other.contains(key);
+            });
         }
-        for (auto [key, _] : other.map_) {
-            if (!this->contains(key)) {
-                result.insert(key);
+        return *this;
+    }
+    
+    // self = self △ other
+    HashSet& operator^=(const HashSet& other) {
+        map_.reserve(other.len());
+        for (const T& key : other) {
+            auto entry = map_.entry(key);
+            if (entry.is_occupied()) {
+                entry.into_occupied().remove();
+            } else {
+                entry.into_vacant().insert(Unit{});
             }
         }
-        return result;
+        return *this;
     }
     
+    // Operator forms of the set operations (as on &HashSet in Rust)
+    // @lifetime: owned
+    HashSet operator|(const HashSet& other) const { return union_with(other); }
+    // @lifetime: owned
+    HashSet operator&(const HashSet& other) const { return intersection(other); }
+    // @lifetime: owned
+    HashSet operator-(const HashSet& other) const { return difference(other); }
+    // @lifetime: owned
+    HashSet operator^(const HashSet& other) const { return symmetric_difference(other); }
+    
     // Check if disjoint (no common elements)
     bool is_disjoint(const HashSet& other) const {
         // Check smaller set against larger
@@ -238,10 +381,10 @@ public:
     // Iterator support (iterate over keys only)
     class iterator {
     private:
-        typename HashMap<T, Unit, Hash>::iterator inner_;
+        typename Map::iterator inner_;
         
     public:
-        iterator(typename HashMap<T, Unit, Hash>::iterator it) : inner_(it) {}
+        iterator(typename Map::iterator it) : inner_(it) {}
         
         const T& operator*() {
             return (*inner_).first;
@@ -267,10 +410,10 @@ public:
     
     class const_iterator {
     private:
-        typename HashMap<T, Unit, Hash>::const_iterator inner_;
+        typename Map::const_iterator inner_;
         
     public:
-        const_iterator(typename HashMap<T, Unit, Hash>::const_iterator it) : inner_(it) {}
+        const_iterator(typename Map::const_iterator it) : inner_(it) {}
         
         const T& operator*() const {
             return (*inner_).first;
@@ -314,14 +457,77 @@ public:
         return const_iterator(map_.end());
     }
     
+    // Lazy iterator over the elements (yields const T&)
+    typedef typename Map::Keys Iter;
+    
+    // @lifetime: (&'a) -> &'a
+    Iter iter() const {
+        return map_.keys_iter();
+    }
+    
+    // Elements of one set kept or dropped by membership in another
+    template<bool Keep>
+    class Filtered : public Iterator<Filtered<Keep>, const T&> {
+    private:
+        Iter inner_;
+        const HashSet* other_;
+        
+    public:
+        Filtered(Iter inner, const HashSet* other) : inner_(std::move(inner)), other_(other) {}
+        
+        template<typename G>
+        bool next_with(G&& g) {
+            const HashSet* other = other_;
+            for (;;) {
+                bool matched = false;
+                bool got = inner_.next_with([other, &g, &matched](const T& key) {
+                    if (other->contains(key) == Keep) {
+                        matched = true;
+                        g(key);
+                    }
+                });
+                if (!got) return false;
+                if (matched) return true;
+            }
+        }
+    };
+    
+    // Lazy set operations: nothing is allocated or copied, the items borrow
+    // both sets. Use these to count, test or fold over a set operation, or
+    // collect<Vec<T>>() it, without building a HashSet first.
+    typedef Filtered<true> Intersection;
+    typedef Filtered<false> Difference;
+    typedef Chain<Iter, Difference> Union;
+    typedef Chain<Difference, Difference> SymmetricDifference;
+    
+    // Walks the smaller set
+    // @lifetime: (&'a, &'a) -> &'a
+    Intersection intersection_iter(const HashSet& other) const {
+        const HashSet* smaller = this->len() <= other.len() ? this : &other;
+        const HashSet* larger = this->len() <= other.len() ? &other : this;
+        return Intersection(smaller->iter(), larger);
+    }
+    
+    // @lifetime: (&'a, &'a) -> &'a
+    Difference difference_iter(const HashSet& other) const {
+        return Difference(iter(), &other);
+    }
+    
+    // Every element of self, then those of other not in self
+    // @lifetime: (&'a, &'a) -> &'a
+    Union union_iter(const HashSet& other) const {
+        return Union(iter(), other.difference_iter(*this));
+    }
+    
+    // @lifetime: (&'a, &'a) -> &'a
+    SymmetricDifference symmetric_difference_iter(const HashSet& other) const {
+        return SymmetricDifference(difference_iter(other), other.difference_iter(*this));
+    }
+    
     // Convert to Vec
     // @lifetime: owned
     Vec<T> to_vec() const {
-        Vec<T> result = Vec<T>::with_capacity(map_.len());
-        for (auto [key, _] : map_) {
-            result.push(key);
-        }
-        return result;
+        return map_.keys_iter().collect();
     }
     
     // Equality comparison
@@ -359,7 +565,7 @@ HashSet<T> hashset_with_capacity(size_t cap) {
 template<typename T>
 // @lifetime: owned
 HashSet<T> hashset_from_vec(Vec<T> vec) {
-    HashSet<T> set;
+    HashSet<T> set = HashSet<T>::with_capacity(vec.len());
     for (size_t i = 0; i < vec.len(); i++) {
         set.insert(std::move(vec[i]));
     }
@@ -0,0 +1,605 @@
+#ifndef RUSTY_INDEXMAP_HPP
+#define RUSTY_INDEXMAP_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <new>
+#include <utility>
+#include "alloc.hpp"
+#include "fwd.hpp"
+#include "hash.hpp"
+#include "hashmap.hpp"
+#include "iter.hpp"
+#include "option.hpp"
+#include "slice.hpp"
+#include "vec.hpp"
+
+// IndexMap<K, V> - A hash map that remembers insertion order
+// Equivalent to Rust's indexmap::IndexMap
+//
+// Entries are stored densely in a Vec<pair<K, V>>, in insertion order, and
+// a SwissTable of uint32_t positions into that Vec finds them by key. So:
+// - Iteration walks contiguous memory in a deterministic order
+// - Entries can be addressed by position (get_index, swap_remove_index)
+// - swap_remove is O(1) but moves the last entry into the hole;
+//   shift_remove keeps the order and is O(n)
+//
+// Each entry's hash is kept in a parallel Vec, so growing the index never
+// rehashes a key. The index table shares Group, ProbeSeq and the control
+// byte scheme with HashMap (see hashmap.hpp).
+
+// @safe
+namespace rusty {
+
+namespace detail {
+
+// A SwissTable of entry positions. The keys live elsewhere, so lookups
+// take the hash and a predicate on a position, and growth takes the
+// entries' hashes. No allocation until the first insert.
+template<typename Alloc>
+class IndexTable : private AllocHolder<Alloc> {
+private:
+    uint8_t* ctrl_;
+    uint32_t* slots_;
+    size_t bucket_mask_;
+    size_t items_;
+    size_t growth_left_;
+
+    static size_t slots_offset(size_t buckets) {
+        return align_to(buckets + GROUP_SIZE, alignof(uint32_t));
+    }
+
+    static size_t storage_size(size_t buckets) {
+        return slots_offset(buckets) + buckets * sizeof(uint32_t);
+    }
+
+    size_t buckets() const { return ctrl_ ? bucket_mask_ + 1 : 0; }
+
+    void set_ctrl(size_t slot, uint8_t ctrl) {
+        ctrl_[slot] = ctrl;
+        if (slot < GROUP_SIZE) {
+            ctrl_[slot + bucket_mask_ + 1] = ctrl;
+        }
+    }
+
+    size_t find_free_slot(size_t hash) const {
+        ProbeSeq seq(hash, bucket_mask_);
+        while (true) {
+            BitMask free = Group::load(&ctrl_[seq.offset()]).match_empty_or_deleted();
+            if (free) {
+                return (seq.offset() + free.lowest()) & bucket_mask_;
+            }
+            seq.next();
+        }
+    }
+
+    void free_storage() {
+        if (ctrl_) {
+            this->alloc().deallocate(ctrl_, storage_size(bucket_mask_ + 1), alignof(uint32_t));
+            ctrl_ = nullptr;
+            slots_ = nullptr;
+        }
+    }
+
+    // Move every position into a table of new_buckets, dropping tombstones
+    void resize(size_t new_buckets, const size_t* hashes) {
+        uint8_t* old_ctrl = ctrl_;
+        uint32_t* old_slots = slots_;
+        size_t old_buckets = buckets();
+
+        void* storage = alloc_or_throw(this->alloc(), storage_size(new_buckets), alignof(uint32_t));
+        ctrl_ = static_cast<uint8_t*>(storage);
+        slots_ = reinterpret_cast<uint32_t*>(ctrl_ + slots_offset(new_buckets));
+        bucket_mask_ = new_buckets - 1;
+        std::memset(ctrl_, EMPTY, new_buckets + GROUP_SIZE);
+        growth_left_ = buckets_to_growth(new_buckets) - items_;
+
+        for (size_t i = 0; i < old_buckets; i++) {
+            if (!is_full(old_ctrl[i])) continue;
+            uint32_t index = old_slots[i];
+            size_t slot = find_free_slot(hashes[index]);
+            set_ctrl(slot, h2_hash(hashes[index]));
+            slots_[slot] = index;
+        }
+        if (old_ctrl) {
+            this->alloc().deallocate(old_ctrl, storage_size(old_buckets), alignof(uint32_t));
+        }
+    }
+
+public:
+    static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+    IndexTable() : ctrl_(nullptr), slots_(nullptr), bucket_mask_(0), items_(0), growth_left_(0) {}
+
+    explicit IndexTable(const Alloc& alloc)
+        : AllocHolder<Alloc>(alloc),
+          ctrl_(nullptr), slots_(nullptr), bucket_mask_(0), items_(0), growth_left_(0) {}
+
+    IndexTable(IndexTable&& other) noexcept
+        : AllocHolder<Alloc>(std::move(other.alloc())),
+          ctrl_(other.ctrl_), slots_(other.slots_), bucket_mask_(other.bucket_mask_),
+          items_(other.items_), growth_left_(other.growth_left_) {
+        other.ctrl_ = nullptr;
+        other.slots_ = nullptr;
+        other.bucket_mask_ = 0;
+        other.items_ = 0;
+        other.growth_left_ = 0;
+    }
+
+    IndexTable& operator=(IndexTable&& other) noexcept {
+        if (this != &other) {
+            free_storage();
+            this->alloc() = std::move(other.alloc());
+            ctrl_ = other.ctrl_;
+            slots_ = other.slots_;
+            bucket_mask_ = other.bucket_mask_;
+            items_ = other.items_;
+            growth_left_ = other.growth_left_;
+            other.ctrl_ = nullptr;
+            other.slots_ = nullptr;
+            other.bucket_mask_ = 0;
+            other.items_ = 0;
+            other.growth_left_ = 0;
+        }
+        return *this;
+    }
+
+    IndexTable(const IndexTable&) = delete;
+    IndexTable& operator=(const IndexTable&) = delete;
+
+    ~IndexTable() { free_storage(); }
+
+    const Alloc& allocator() const { return this->alloc(); }
+
+    size_t len() const { return items_; }
+    size_t capacity() const { return items_ + growth_left_; }
+
+    // Slot holding a position for which eq(position) is true
+    template<typename Eq>
+    size_t find(size_t hash, Eq eq) const {
+        if (items_ == 0) return NOT_FOUND;
+        uint8_t h2 = h2_hash(hash);
+        ProbeSeq seq(hash, bucket_mask_);
+        while (true) {
+            Group g = Group::load(&ctrl_[seq.offset()]);
+            BitMask matches = g.match_byte(h2);
+            while (matches) {
+                size_t slot = (seq.offset() + matches.lowest()) & bucket_mask_;
+                if (eq(slots_[slot])) return slot;
+                matches.clear_lowest();
+            }
+            if (g.match_empty()) return NOT_FOUND;
+            seq.next();
+        }
+    }
+
+    // Slot holding exactly position index
+    size_t find_position(size_t hash, uint32_t index) const {
+        return find(hash, [index](uint32_t i) { return i == index; });
+    }
+
+    uint32_t position(size_t slot) const { return slots_[slot]; }
+    void set_position(size_t slot, uint32_t index) { slots_[slot] = index; }
+
+    // Make room for additional more positions
+    void reserve(size_t additional, const size_t* hashes) {
+        if (additional <= growth_left_) return;
+        size_t new_items = items_ + additional;
+        size_t full_capacity = buckets() ? buckets_to_growth(buckets()) : 0;
+        if (new_items <= full_capacity / 2) {
+            resize(buckets(), hashes);  // mostly tombstones: same size
+        } else {
+            resize(items_to_buckets(new_items > full_capacity + 1 ? new_items : full_capacity + 1),
+                   hashes);
+        }
+    }
+
+    // Add a position known to be absent. hashes covers the positions
+    // already in the table, in case it has to grow.
+    void insert(size_t hash, uint32_t index, const size_t* hashes) {
+        size_t slot = ctrl_ ? find_free_slot(hash) : 0;
+        if (!ctrl_ || (growth_left_ == 0 && ctrl_[slot] == EMPTY)) {
+            reserve(1, hashes);
+            slot = find_free_slot(hash);
+        }
+        growth_left_ -= ctrl_[slot] == EMPTY;
+        set_ctrl(slot, h2_hash(hash));
+        slots_[slot] = index;
+        items_++;
+    }
+
+    // Free a slot: EMPTY unless a probe may have passed over it while its
+    // group was full, as in HashMap::erase_slot
+    void erase(size_t slot) {
+        size_t slot_before = (slot - GROUP_SIZE) & bucket_mask_;
+        BitMask empty_before = Group::load(&ctrl_[slot_before]).match_empty();
+        BitMask empty_after = Group::load(&ctrl_[slot]).match_empty();
+        if (empty_before.leading_zeros() + empty_after.trailing_zeros() >= GROUP_SIZE) {
+            set_ctrl(slot, DELETED);
+        } else {
+            set_ctrl(slot, EMPTY);
+            growth_left_++;
+        }
+        items_--;
+    }
+
+    // Subtract one from every position above removed (for shift_remove)
+    void shift_down_above(uint32_t removed) {
+        for (size_t base = 0; base < buckets(); base += GROUP_SIZE) {
+            BitMask full = Group::load(&ctrl_[base]).match_full();
+            while (full) {
+                size_t slot = base + full.lowest();
+                full.clear_lowest();
+                if (slot > bucket_mask_) break;
+                if (slots_[slot] > removed) slots_[slot]--;
+            }
+        }
+    }
+
+    // Forget every position, keeping the allocation
+    void clear() {
+        if (!ctrl_) return;
+        std::memset(ctrl_, EMPTY, buckets() + GROUP_SIZE);
+        items_ = 0;
+        growth_left_ = buckets_to_growth(buckets());
+    }
+
+    // Index positions [0, len) from scratch
+    void rebuild(const size_t* hashes, size_t len) {
+        clear();
+        reserve(len, hashes);
+        for (size_t i = 0; i < len; i++) {
+            size_t slot = find_free_slot(hashes[i]);
+            set_ctrl(slot, h2_hash(hashes[i]));
+            slots_[slot] = uint32_t(i);
+        }
+        items_ = len;
+        growth_left_ -= len;
+    }
+};
+
+template<typename Alloc>
+constexpr size_t IndexTable<Alloc>::NOT_FOUND;
+
+} // namespace detail
+
+template<typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+class IndexMap {
+public:
+    typedef std::pair<K, V> value_type;
+
+private:
+    typedef detail::IndexTable<Alloc> Table;
+
+    static constexpr size_t NOT_FOUND = Table::NOT_FOUND;
+
+    Vec<value_type, Alloc> entries_;
+    Vec<size_t, Alloc> hashes_;  // hashes_[i] is the hash of entries_[i].first
+    Table table_;
+    Hash hasher_;
+    KeyEqual key_eq_;
+
+    // Table slot for key, or NOT_FOUND
+    size_t find_slot(const K& key, size_t hash) const {
+        return table_.find(hash, [&](uint32_t i) { return key_eq_(entries_[i].first, key); });
+    }
+
+    size_t find_index(const K& key) const {
+        if (entries_.is_empty()) return NOT_FOUND;
+        size_t slot = find_slot(key, hasher_(key));
+        return slot == NOT_FOUND ? NOT_FOUND : table_.position(slot);
+    }
+
+    uint32_t push_entry(K key, V value, size_t hash) {
+        assert(entries_.len() < UINT32_MAX);
+        uint32_t index = uint32_t(entries_.len());
+        entries_.push(value_type(std::move(key), std::move(value)));
+        hashes_.push(hash);
+        table_.insert(hash, index, hashes_.as_ptr());
+        return index;
+    }
+
+    // Remove entry index, whose table slot is slot, moving the last entry
+    // into its place
+    value_type swap_remove_at(size_t slot, size_t index) {
+        table_.erase(slot);
+        size_t last = entries_.len() - 1;
+        if (index != last) {
+            size_t last_slot = table_.find_position(hashes_[last], uint32_t(last));
+            table_.set_position(last_slot, uint32_t(index));
+            using std::swap;
+            swap(entries_[index], entries_[last]);
+            hashes_[index] = hashes_[last];
+        }
+        hashes_.pop();
+        return entries_.pop();
+    }
+
+    // Remove entry index, whose table slot is slot, shifting the later
+    // entries down one place
+    value_type shift_remove_at(size_t slot, size_t index) {
+        table_.erase(slot);
+        table_.shift_down_above(uint32_t(index));
+        hashes_.remove(index);
+        return entries_.remove(index);
+    }
+
+    void rehash_all() {
+        for (size_t i = 0; i < entries_.len(); i++) hashes_[i] = hasher_(entries_[i].first);
+        table_.rebuild(hashes_.as_ptr(), entries_.len());
+    }
+
+public:
+    // Constructors (no allocation until the first insert)
+    IndexMap() : entries_(), hashes_(), table_() {}
+
+    explicit IndexMap(const Alloc& alloc)
+        : entries_(Vec<value_type, Alloc>::new_in(alloc)),
+          hashes_(Vec<size_t, Alloc>::new_in(alloc)),
+          table_(alloc) {}
+
+    IndexMap(std::initializer_list<value_type> items) : IndexMap() {
+        reserve(items.size());
+        for (const value_type& kv : items) insert(kv.first, kv.second);
+    }
+
+    // Factory methods
+    // @lifetime: owned
+    static IndexMap new_() { return IndexMap(); }
+
+    // @lifetime: owned
+    static IndexMap new_in(const Alloc& alloc) { return IndexMap(alloc); }
+
+    // @lifetime: owned
+    static IndexMap with_capacity(size_t cap) {
+        IndexMap map;
+        map.reserve(cap);
+        return map;
+    }
+
+    // @lifetime: owned
+    static IndexMap with_capacity_in(size_t cap, const Alloc& alloc) {
+        IndexMap map(alloc);
+        map.reserve(cap);
+        return map;
+    }
+
+    // Move-only, like HashMap
+    IndexMap(const IndexMap&) = delete;
+    IndexMap& operator=(const IndexMap&) = delete;
+    IndexMap(IndexMap&&) = default;
+    IndexMap& operator=(IndexMap&&) = default;
+
+    size_t len() const { return entries_.len(); }
+    bool is_empty() const { return entries_.is_empty(); }
+    size_t capacity() const {
+        size_t table = table_.capacity();
+        return table < entries_.capacity() ? table : entries_.capacity();
+    }
+
+    // Make room for additional more entries
+    void reserve(size_t additional) {
+        entries_.reserve(entries_.len() + additional);
+        hashes_.reserve(hashes_.len() + additional);
+        table_.reserve(additional, hashes_.as_ptr());
+    }
+
+    // Insert or update. An existing key keeps its position; the previous
+    // value is returned.
+    // @lifetime: owned
+    Option<V> insert(K key, V value) {
+        return insert_full(std::move(key), std::move(value)).second;
+    }
+
+    // As insert, also giving the entry's position
+    // @lifetime: owned
+    std::pair<size_t, Option<V>> insert_full(K key, V value) {
+        size_t hash = hasher_(key);
+        size_t slot = find_slot(key, hash);
+        if (slot != NOT_FOUND) {
+            size_t index = table_.position(slot);
+            using std::swap;
+            swap(entries_[index].second, value);
+            return std::make_pair(index, Option<V>(std::move(value)));
+        }
+        size_t index = push_entry(std::move(key), std::move(value), hash);
+        return std::make_pair(index, Option<V>(None));
+    }
+
+    // The value for key, appending f() first if absent (f is only called
+    // when needed)
+    template<typename F>
+    // @lifetime: (&'a mut) -> &'a mut
+    V& get_or_insert_with(K key, F f) {
+        size_t hash = hasher_(key);
+        size_t slot = find_slot(key, hash);
+        if (slot != NOT_FOUND) return entries_[table_.position(slot)].second;
+        return entries_[push_entry(std::move(key), f(), hash)].second;
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    V& or_insert(K key, V default_value) {
+        size_t hash = hasher_(key);
+        size_t slot = find_slot(key, hash);
+        if (slot != NOT_FOUND) return entries_[table_.position(slot)].second;
+        return entries_[push_entry(std::move(key), std::move(default_value), hash)].second;
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    Option<V&> get(const K& key) {
+        size_t index = find_index(key);
+        if (index == NOT_FOUND) return None;
+        return Option<V&>(entries_[index].second);
+    }
+
+    // @lifetime: (&'a) -> &'a
+    Option<const V&> get(const K& key) const {
+        size_t index = find_index(key);
+        if (index == NOT_FOUND) return None;
+        return Option<const V&>(entries_[index].second);
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    Option<V&> get_mut(const K& key) { return get(key); }
+
+    bool contains_key(const K& key) const { return find_index(key) != NOT_FOUND; }
+
+    // Position of key in iteration order
+    Option<size_t> get_index_of(const K& key) const {
+        size_t index = find_index(key);
+        if (index == NOT_FOUND) return None;
+        return Option<size_t>(index);
+    }
+
+    // Entry at a position
+    // @lifetime: (&'a) -> &'a
+    Option<std::pair<const K*, const V*>> get_index(size_t index) const {
+        if (index >= entries_.len()) return None;
+        return Option<std::pair<const K*, const V*>>(
+            std::make_pair(&entries_[index].first, &entries_[index].second));
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    Option<std::pair<const K*, V*>> get_index_mut(size_t index) {
+        if (index >= entries_.len()) return None;
+        return Option<std::pair<const K*, V*>>(
+            std::make_pair(&entries_[index].first, &entries_[index].second));
+    }
+
+    // @lifetime: (&'a) -> &'a
+    Option<std::pair<const K*, const V*>> first() const { return get_index(0); }
+
+    // @lifetime: (&'a) -> &'a
+    Option<std::pair<const K*, const V*>> last() const {
+        return entries_.is_empty() ? Option<std::pair<const K*, const V*>>(None)
+                                   : get_index(entries_.len() - 1);
+    }
+
+    // Remove key in O(1); the last entry takes its position
+    // @lifetime: owned
+    Option<V> swap_remove(const K& key) {
+        if (entries_.is_empty()) return None;
+        size_t slot = find_slot(key, hasher_(key));
+        if (slot == NOT_FOUND) return None;
+        return Option<V>(swap_remove_at(slot, table_.position(slot)).second);
+    }
+
+    // @lifetime: owned
+    Option<value_type> swap_remove_index(size_t index) {
+        if (index >= entries_.len()) return None;
+        size_t slot = table_.find_position(hashes_[index], uint32_t(index));
+        return Option<value_type>(swap_remove_at(slot, index));
+    }
+
+    // Remove key in O(n), keeping the order of the other entries
+    // @lifetime: owned
+    Option<V> shift_remove(const K& key) {
+        if (entries_.is_empty()) return None;
+        size_t slot = find_slot(key, hasher_(key));
+        if (slot == NOT_FOUND) return None;
+        return Option<V>(shift_remove_at(slot, table_.position(slot)).second);
+    }
+
+    // @lifetime: owned
+    Option<value_type> shift_remove_index(size_t index) {
+        if (index >= entries_.len()) return None;
+        size_t slot = table_.find_position(hashes_[index], uint32_t(index));
+        return Option<value_type>(shift_remove_at(slot, index));
+    }
+
+    // Remove the last entry
+    // @lifetime: owned
+    Option<value_type> pop() {
+        if (entries_.is_empty()) return None;
+        return swap_remove_index(entries_.len() - 1);
+    }
+
+    // Keep only the entries for which pred(key, value) is true, in order
+    template<typename Pred>
+    void retain(Pred pred) {
+        size_t kept = 0;
+        for (size_t i = 0; i < entries_.len(); i++) {
+            if (!pred(static_cast<const K&>(entries_[i].first), entries_[i].second)) continue;
+            if (kept != i) {
+                entries_[kept] = std::move(entries_[i]);
+                hashes_[kept] = hashes_[i];
+            }
+            kept++;
+        }
+        if (kept == entries_.len()) return;
+        entries_.truncate(kept);
+        hashes_.truncate(kept);
+        table_.rebuild(hashes_.as_ptr(), kept);
+    }
+
+    // Reorder the entries by key (stable)
+    void sort_keys() {
+        entries_.sort_by([](const value_type& a, const value_type& b) { return a.first < b.first; });
+        rehash_all();
+    }
+
+    // Reorder the entries with less(a, b) on (key, value) pairs (stable)
+    template<typename Less>
+    void sort_by(Less less) {
+        entries_.sort_by(less);
+        rehash_all();
+    }
+
+    void clear() {
+        entries_.clear();
+        hashes_.clear();
+        table_.clear();
+    }
+
+    // Entries in order, as one contiguous slice
+    // @lifetime: (&'a) -> &'a
+    Slice<value_type> as_slice() const { return entries_.as_slice(); }
+
+    // @lifetime: (&'a) -> &'a
+    SliceIter<value_type> iter() const { return entries_.iter(); }
+
+    const value_type* begin() const { return entries_.begin(); }
+    const value_type* end() const { return entries_.end(); }
+
+    // Consume the map, yielding entries in order
+    // @lifetime: owned
+    VecIntoIter<value_type, Alloc> into_iter() && { return std::move(entries_).into_iter(); }
+
+    // The entries in order
+    // @lifetime: owned
+    Vec<value_type, Alloc> into_entries() && { return std::move(entries_); }
+
+    // @lifetime: owned
+    IndexMap clone() const {
+        IndexMap map(table_.allocator());
+        map.reserve(entries_.len());
+        for (size_t i = 0; i < entries_.len(); i++) {
+            map.push_entry(detail::clone_value(entries_[i].first),
+                           detail::clone_value(entries_[i].second), hashes_[i]);
+        }
+        return map;
+    }
+
+    // Same entries, in any order (as Rust's IndexMap)
+    bool operator==(const IndexMap& other) const {
+        if (entries_.len() != other.entries_.len()) return false;
+        for (size_t i = 0; i < entries_.len(); i++) {
+            Option<const V&> value = other.get(entries_[i].first);
+            if (value.is_none() || !(value.unwrap() == entries_[i].second)) return false;
+        }
+        return true;
+    }
+
+    bool operator!=(const IndexMap& other) const { return !(*this == other); }
+};
+
+template<typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+constexpr size_t IndexMap<K, V, Hash, KeyEqual, Alloc>::NOT_FOUND;
+
+} // namespace rusty
+
+#endif // RUSTY_INDEXMAP_HPP
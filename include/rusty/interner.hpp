@@ -0,0 +1,325 @@
+#ifndef RUSTY_INTERNER_HPP
+#define RUSTY_INTERNER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>    // for std::hash
+#include <mutex>         // for std::unique_lock
+#include <shared_mutex>  // for std::shared_mutex, std::shared_lock
+#include <stdexcept>
+#include "arena.hpp"
+#include "hashmap.hpp"
+#include "string.hpp"
+
+// Interner - deduplicating string pool handing out 4-byte Symbols
+// Equivalent to Rust's string-interner / lasso::Rodeo
+//
+// Each distinct string is copied once into an Arena (null-terminated) and
+// indexed by a SwissTable HashMap<str, Symbol>. A Symbol is the string's
+// insertion index, so comparing or hashing Symbols is an integer operation
+// and maps keyed by Symbol hold 4-byte keys instead of Strings.
+//
+// Symbols are only meaningful to the interner that created them; resolving
+// one from another interner returns unrelated text (or throws when its
+// index is out of range).
+//
+// SyncInterner is the thread-safe variant: lookups share a read lock, new
+// strings take the write lock, and resolve() takes no lock at all because
+// interned text is never moved or freed while the interner lives.
+
+// @safe
+namespace rusty {
+
+// Handle to an interned string
+class Symbol {
+private:
+    uint32_t id_;
+
+public:
+    explicit Symbol(uint32_t id) : id_(id) {}
+
+    // Dense index, usable to key side tables
+    uint32_t as_u32() const { return id_; }
+
+    bool operator==(Symbol other) const { return id_ == other.id_; }
+    bool operator!=(Symbol other) const { return id_ != other.id_; }
+    bool operator<(Symbol other) const { return id_ < other.id_; }
+};
+
+template<>
+struct FxHash<Symbol> {
+    size_t operator()(Symbol sym) const noexcept {
+        return hash_u64(sym.as_u32());
+    }
+};
+
+namespace detail {
+
+// Append-only table of interned strings, indexed by Symbol
+// Slots live in segments of doubling size that are never moved, so readers
+// can resolve without locking while a writer appends
+class SymbolTable {
+private:
+    static constexpr unsigned FIRST_BITS = 8;                  // 256 slots first
+    static constexpr unsigned SEGMENTS = 32 - FIRST_BITS + 1;  // covers every uint32_t
+
+    std::atomic<str*> segments_[SEGMENTS];
+
+    static void locate(uint32_t index, unsigned& segment, size_t& offset) {
+        uint64_t biased = static_cast<uint64_t>(index) + (uint64_t(1) << FIRST_BITS);
+        unsigned top = 63 - static_cast<unsigned>(__builtin_clzll(biased));
+        segment = top - FIRST_BITS;
+        offset = static_cast<size_t>(biased - (uint64_t(1) << top));
+    }
+
+public:
+    SymbolTable() {
+        for (auto& s : segments_) s.store(nullptr, std::memory_order_relaxed);
+    }
+
+    SymbolTable(SymbolTable&& other) noexcept {
+        for (unsigned i = 0; i < SEGMENTS; i++) {
+            segments_[i].store(other.segments_[i].load(std::memory_order_relaxed),
+                               std::memory_order_relaxed);
+            other.segments_[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    SymbolTable& operator=(SymbolTable&& other) noexcept {
+        if (this != &other) {
+            for (unsigned i = 0; i < SEGMENTS; i++) {
+                delete[] segments_[i].load(std::memory_order_relaxed);
+                segments_[i].store(other.segments_[i].load(std::memory_order_relaxed),
+                                   std::memory_order_relaxed);
+                other.segments_[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+        return *this;
+    }
+
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    ~SymbolTable() {
+        for (auto& s : segments_) delete[] s.load(std::memory_order_relaxed);
+    }
+
+    // Writer side: store the string for a fresh index (one writer at a time)
+    void set(uint32_t index, str text) {
+        unsigned segment;
+        size_t offset;
+        locate(index, segment, offset);
+        str* slots = segments_[segment].load(std::memory_order_relaxed);
+        if (!slots) {
+            slots = new str[size_t(1) << (segment + FIRST_BITS)];
+            segments_[segment].store(slots, std::memory_order_release);
+        }
+        slots[offset] = text;
+    }
+
+    // Reader side: index must have been published to this thread
+    str get(uint32_t index) const {
+        unsigned segment;
+        size_t offset;
+        locate(index, segment, offset);
+        return segments_[segment].load(std::memory_order_acquire)[offset];
+    }
+};
+
+// State shared by Interner and SyncInterner; callers provide the locking
+class InternerCore {
+private:
+    Arena arena_;
+    HashMap<str, Symbol, StringHash, StringEq> map_;
+    SymbolTable table_;
+    std::atomic<uint32_t> len_;
+
+public:
+    InternerCore() : len_(0) {}
+
+    explicit InternerCore(size_t capacity)
+        : map_(HashMap<str, Symbol, StringHash, StringEq>::with_capacity(capacity)), len_(0) {}
+
+    InternerCore(InternerCore&& other) noexcept
+        : arena_(std::move(other.arena_)),
+          map_(std::move(other.map_)),
+          table_(std::move(other.table_)),
+          len_(other.len_.exchange(0, std::memory_order_relaxed)) {}
+
+    InternerCore& operator=(InternerCore&& other) noexcept {
+        if (this != &other) {
+            arena_ = std::move(other.arena_);
+            map_ = std::move(other.map_);
+            table_ = std::move(other.table_);
+            len_.store(other.len_.exchange(0, std::memory_order_relaxed),
+                       std::memory_order_relaxed);
+        }
+        return *this;
+    }
+
+    size_t hash(str text) const { return map_.hash_key(text); }
+
+    Option<Symbol> find(str text, size_t hash) const {
+        auto found = map_.get_with_hash(text, hash);
+        if (found.is_none()) return None;
+        return found.cloned();
+    }
+
+    // Copy text into the arena and assign the next Symbol (text is absent)
+    Symbol insert(str text, size_t hash) {
+        uint32_t id = len_.load(std::memory_order_relaxed);
+        if (id == UINT32_MAX) {
+            throw std::length_error("Interner: too many symbols");
+        }
+        char* bytes = arena_.alloc_array<char>(text.len() + 1);
+        if (text.len() > 0) std::memcpy(bytes, text.as_ptr(), text.len());
+        bytes[text.len()] = '\0';
+
+        str stored(bytes, text.len());
+        Symbol sym(id);
+        map_.insert_with_hash(stored, sym, hash);
+        table_.set(id, stored);
+        len_.store(id + 1, std::memory_order_release);
+        return sym;
+    }
+
+    str resolve(Symbol sym) const {
+        if (sym.as_u32() >= len_.load(std::memory_order_acquire)) {
+            throw std::out_of_range("Interner: symbol out of range");
+        }
+        return table_.get(sym.as_u32());
+    }
+
+    size_t len() const { return len_.load(std::memory_order_acquire); }
+
+    // Bytes of interned text, terminators included
+    size_t bytes_used() const { return arena_.allocated_bytes(); }
+};
+
+} // namespace detail
+
+// Single-threaded interner
+class Interner {
+private:
+    detail::InternerCore core_;
+
+    explicit Interner(size_t capacity) : core_(capacity) {}
+
+public:
+    Interner() = default;
+
+    // @lifetime: owned
+    static Interner new_() {
+        return Interner();
+    }
+
+    // Room for capacity strings before the index rehashes
+    // @lifetime: owned
+    static Interner with_capacity(size_t capacity) {
+        return Interner(capacity);
+    }
+
+    Interner(Interner&&) = default;
+    Interner& operator=(Interner&&) = default;
+    Interner(const Interner&) = delete;
+    Interner& operator=(const Interner&) = delete;
+
+    // Symbol for text, interning a copy the first time it is seen
+    Symbol intern(str text) {
+        size_t hash = core_.hash(text);
+        Option<Symbol> existing = core_.find(text, hash);
+        if (existing.is_some()) return existing.unwrap();
+        return core_.insert(text, hash);
+    }
+
+    // Symbol for text if it was interned already
+    Option<Symbol> get(str text) const {
+        return core_.find(text, core_.hash(text));
+    }
+
+    // Interned text (null-terminated); borrows the interner
+    // @lifetime: (&'a) -> &'a
+    str resolve(Symbol sym) const {
+        return core_.resolve(sym);
+    }
+
+    size_t len() const { return core_.len(); }
+    bool is_empty() const { return len() == 0; }
+    size_t bytes_used() const { return core_.bytes_used(); }
+};
+
+// Thread-safe interner
+// Not movable: share it by reference or through Arc
+class SyncInterner {
+private:
+    mutable std::shared_mutex lock_;
+    detail::InternerCore core_;
+
+    explicit SyncInterner(size_t capacity) : core_(capacity) {}
+
+public:
+    SyncInterner() = default;
+
+    // @lifetime: owned
+    static SyncInterner new_() {
+        return SyncInterner();
+    }
+
+    // @lifetime: owned
+    static SyncInterner with_capacity(size_t capacity) {
+        return SyncInterner(capacity);
+    }
+
+    SyncInterner(const SyncInterner&) = delete;
+    SyncInterner& operator=(const SyncInterner&) = delete;
+
+    // Known strings only take the read lock; the first sighting rechecks
+    // under the write lock, since another thread may have won the race
+    Symbol intern(str text) {
+        size_t hash = core_.hash(text);
+        {
+            std::shared_lock<std::shared_mutex> read(lock_);
+            Option<Symbol> existing = core_.find(text, hash);
+            if (existing.is_some()) return existing.unwrap();
+        }
+        std::unique_lock<std::shared_mutex> write(lock_);
+        Option<Symbol> existing = core_.find(text, hash);
+        if (existing.is_some()) return existing.unwrap();
+        return core_.insert(text, hash);
+    }
+
+    Option<Symbol> get(str text) const {
+        size_t hash = core_.hash(text);
+        std::shared_lock<std::shared_mutex> read(lock_);
+        return core_.find(text, hash);
+    }
+
+    // Lock-free; sym must come from this interner
+    // @lifetime: (&'a) -> &'a
+    str resolve(Symbol sym) const {
+        return core_.resolve(sym);
+    }
+
+    size_t len() const { return core_.len(); }
+    bool is_empty() const { return len() == 0; }
+
+    size_t bytes_used() const {
+        std::shared_lock<std::shared_mutex> read(lock_);
+        return core_.bytes_used();
+    }
+};
+
+} // namespace rusty
+
+namespace std {
+    template<>
+    struct hash<rusty::Symbol> {
+        size_t operator()(rusty::Symbol sym) const noexcept {
+            return rusty::FxHash<rusty::Symbol>()(sym);
+        }
+    };
+}
+
+#endif // RUSTY_INTERNER_HPP
@@ -0,0 +1,677 @@
+#ifndef RUSTY_IO_HPP
+#define RUSTY_IO_HPP
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include "memchr.hpp"
+#include "mmap.hpp"
+#include "result.hpp"
+#include "slice.hpp"
+#include "string.hpp"
+#include "traits.hpp"
+#include "vec.hpp"
+
+#ifdef RUSTY_POSIX
+#include <sys/uio.h>
+#endif
+
+// io - Buffered, copy-light file and socket I/O
+// Modeled on Rust's std::io
+//
+//   auto file = rusty::io::File::open("access.log");
+//   rusty::io::BufReader<rusty::io::File> reader(file.unwrap());
+//   rusty::String line;
+//   while (reader.read_line(line).unwrap() != 0) {   // the String is reused
+//       ... line.as_str() ...
+//       line.clear();
+//   }
+//
+// Readers and writers are plain types with these members, which the
+// generic code below (BufReader, BufWriter, read_to_end, write_all) uses:
+//   Result<size_t, Error> read(SliceMut<uint8_t> buf);  // 0 at end of input
+//   Result<size_t, Error> write(Slice<uint8_t> buf);    // may be partial
+//   Result<void, Error> flush();
+// plus, optionally, read_vectored/write_vectored, which map to readv and
+// writev and are used when present.
+//
+// File owns a descriptor (a file, pipe or socket) and has no buffer of
+// its own; each call is one system call, retried on EINTR. BufReader
+// reads in large blocks and hands out views of its buffer (fill_buf,
+// consume), so lines are found with memchr without copying first.
+// BufWriter collects small writes and sends full buffers, or large
+// writes directly, with one call each. No iostreams or locale formatting
+// is involved anywhere.
+
+// @safe
+namespace rusty {
+namespace io {
+
+typedef IoError Error;
+
+// The mapped view of a whole file (see mmap.hpp)
+typedef rusty::MappedFile MappedFile;
+
+constexpr size_t DEFAULT_BUF_SIZE = 64 * 1024;
+
+namespace detail {
+
+inline Error error(int code) {
+    Error err = {code};
+    return err;
+}
+
+} // namespace detail
+
+// One buffer of a vectored write; the same layout as struct iovec
+class IoSlice {
+private:
+#ifdef RUSTY_POSIX
+    struct iovec raw_;
+#else
+    struct {
+        void* iov_base;
+        size_t iov_len;
+    } raw_;
+#endif
+
+public:
+    IoSlice() { raw_.iov_base = nullptr; raw_.iov_len = 0; }
+
+    // @lifetime: (&'a) -> 'a
+    explicit IoSlice(Slice<uint8_t> bytes) {
+        raw_.iov_base = const_cast<uint8_t*>(bytes.as_ptr());
+        raw_.iov_len = bytes.len();
+    }
+
+    size_t len() const { return raw_.iov_len; }
+
+    // @lifetime: (&'a) -> &'a
+    Slice<uint8_t> as_slice() const { return Slice<uint8_t>(static_cast<const uint8_t*>(raw_.iov_base), raw_.iov_len); }
+
+    // Skip n bytes, after a partial write
+    void advance(size_t n) {
+        raw_.iov_base = static_cast<uint8_t*>(raw_.iov_base) + n;
+        raw_.iov_len -= n;
+    }
+};
+
+// One buffer of a vectored read
+class IoSliceMut {
+private:
+#ifdef RUSTY_POSIX
+    struct iovec raw_;
+#else
+    struct {
+        void* iov_base;
+        size_t iov_len;
+    } raw_;
+#endif
+
+public:
+    IoSliceMut() { raw_.iov_base = nullptr; raw_.iov_len = 0; }
+
+    // @lifetime: (&'a mut) -> 'a
+    explicit IoSliceMut(SliceMut<uint8_t> bytes) {
+        raw_.iov_base = bytes.as_mut_ptr();
+        raw_.iov_len = bytes.len();
+    }
+
+    size_t len() const { return raw_.iov_len; }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    SliceMut<uint8_t> as_mut_slice() { return SliceMut<uint8_t>(static_cast<uint8_t*>(raw_.iov_base), raw_.iov_len); }
+};
+
+namespace detail {
+
+// Detect an optional write_vectored member
+template<typename T, typename = void>
+struct has_write_vectored : std::false_type {};
+
+template<typename T>
+struct has_write_vectored<T, typename rusty::detail::make_void<decltype(
+    std::declval<T&>().write_vectored(std::declval<Slice<IoSlice>>()))>::type> : std::true_type {};
+
+} // namespace detail
+
+#ifdef RUSTY_POSIX
+static_assert(sizeof(IoSlice) == sizeof(struct iovec), "IoSlice must match iovec");
+static_assert(sizeof(IoSliceMut) == sizeof(struct iovec), "IoSliceMut must match iovec");
+
+namespace detail {
+
+// IOV_MAX is at least 16 everywhere; Linux allows 1024
+inline int iov_count(size_t n) {
+    const size_t limit = 1024;
+    return static_cast<int>(n < limit ? n : limit);
+}
+
+inline Result<size_t, Error> fd_read(int fd, void* buf, size_t len) {
+    while (true) {
+        ssize_t n = ::read(fd, buf, len);
+        if (n >= 0) return Result<size_t, Error>::Ok(static_cast<size_t>(n));
+        if (errno != EINTR) return Result<size_t, Error>::Err(error(errno));
+    }
+}
+
+inline Result<size_t, Error> fd_write(int fd, const void* buf, size_t len) {
+    while (true) {
+        ssize_t n = ::write(fd, buf, len);
+        if (n >= 0) return Result<size_t, Error>::Ok(static_cast<size_t>(n));
+        if (errno != EINTR) return Result<size_t, Error>::Err(error(errno));
+    }
+}
+
+inline Result<size_t, Error> fd_readv(int fd, IoSliceMut* bufs, size_t count) {
+    while (true) {
+        ssize_t n = ::readv(fd, reinterpret_cast<const struct iovec*>(bufs), iov_count(count));
+        if (n >= 0) return Result<size_t, Error>::Ok(static_cast<size_t>(n));
+        if (errno != EINTR) return Result<size_t, Error>::Err(error(errno));
+    }
+}
+
+inline Result<size_t, Error> fd_writev(int fd, const IoSlice* bufs, size_t count) {
+    while (true) {
+        ssize_t n = ::writev(fd, reinterpret_cast<const struct iovec*>(bufs), iov_count(count));
+        if (n >= 0) return Result<size_t, Error>::Ok(static_cast<size_t>(n));
+        if (errno != EINTR) return Result<size_t, Error>::Err(error(errno));
+    }
+}
+
+} // namespace detail
+
+// An owned file descriptor: a file, or any pipe or socket adopted with
+// from_raw_fd. Closed on destruction.
+class File {
+private:
+    int fd_;
+
+    static Result<File, Error> open_with(const char* path, int flags) {
+        int fd;
+        do {
+            fd = ::open(path, flags | O_CLOEXEC, 0666);
+        } while (fd < 0 && errno == EINTR);
+        if (fd < 0) return Result<File, Error>::Err(detail::error(errno));
+        return Result<File, Error>::Ok(File(fd));
+    }
+
+    explicit File(int fd) : fd_(fd) {}
+
+public:
+    File(File&& other) noexcept : fd_(other.fd_) { other.fd_ = -1; }
+
+    File& operator=(File&& other) noexcept {
+        if (this != &other) {
+            if (fd_ >= 0) ::close(fd_);
+            fd_ = other.fd_;
+            other.fd_ = -1;
+        }
+        return *this;
+    }
+
+    File(const File&) = delete;
+    File& operator=(const File&) = delete;
+
+    ~File() {
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    // Read only
+    // @lifetime: owned
+    static Result<File, Error> open(const char* path) { return open_with(path, O_RDONLY); }
+
+    // Write only, created or truncated
+    // @lifetime: owned
+    static Result<File, Error> create(const char* path) { return open_with(path, O_WRONLY | O_CREAT | O_TRUNC); }
+
+    // Write only, created if missing, every write at the end
+    // @lifetime: owned
+    static Result<File, Error> append(const char* path) { return open_with(path, O_WRONLY | O_CREAT | O_APPEND); }
+
+    // Take ownership of fd
+    // @lifetime: owned
+    static File from_raw_fd(int fd) { return File(fd); }
+
+    int as_raw_fd() const { return fd_; }
+
+    // Give up ownership without closing
+    int into_raw_fd() && {
+        int fd = fd_;
+        fd_ = -1;
+        return fd;
+    }
+
+    Result<size_t, Error> read(SliceMut<uint8_t> buf) { return detail::fd_read(fd_, buf.as_mut_ptr(), buf.len()); }
+
+    // One readv call filling bufs in order
+    Result<size_t, Error> read_vectored(SliceMut<IoSliceMut> bufs) {
+        return detail::fd_readv(fd_, bufs.as_mut_ptr(), bufs.len());
+    }
+
+    Result<size_t, Error> write(Slice<uint8_t> buf) { return detail::fd_write(fd_, buf.as_ptr(), buf.len()); }
+
+    // One writev call sending bufs in order
+    Result<size_t, Error> write_vectored(Slice<IoSlice> bufs) {
+        return detail::fd_writev(fd_, bufs.as_ptr(), bufs.len());
+    }
+
+    // Nothing is buffered here
+    Result<void, Error> flush() { return Result<void, Error>::Ok(); }
+
+    // fsync: data and metadata reach the disk
+    Result<void, Error> sync_all() {
+        if (::fsync(fd_) != 0) return Result<void, Error>::Err(detail::error(errno));
+        return Result<void, Error>::Ok();
+    }
+
+    Result<uint64_t, Error> size() const {
+        struct stat st;
+        if (::fstat(fd_, &st) != 0) return Result<uint64_t, Error>::Err(detail::error(errno));
+        return Result<uint64_t, Error>::Ok(static_cast<uint64_t>(st.st_size));
+    }
+};
+
+// Standard input, output or error; borrowed, never closed
+class Stdio {
+private:
+    int fd_;
+
+public:
+    explicit Stdio(int fd) : fd_(fd) {}
+
+    int as_raw_fd() const { return fd_; }
+
+    Result<size_t, Error> read(SliceMut<uint8_t> buf) { return detail::fd_read(fd_, buf.as_mut_ptr(), buf.len()); }
+    Result<size_t, Error> write(Slice<uint8_t> buf) { return detail::fd_write(fd_, buf.as_ptr(), buf.len()); }
+    Result<size_t, Error> write_vectored(Slice<IoSlice> bufs) {
+        return detail::fd_writev(fd_, bufs.as_ptr(), bufs.len());
+    }
+    Result<void, Error> flush() { return Result<void, Error>::Ok(); }
+};
+
+// Trailing underscores: stdin and friends may be macros
+inline Stdio stdin_() { return Stdio(0); }
+inline Stdio stdout_() { return Stdio(1); }
+inline Stdio stderr_() { return Stdio(2); }
+
+#endif // RUSTY_POSIX
+
+// Reads from borrowed bytes, e.g. a MappedFile
+class SliceReader {
+private:
+    Slice<uint8_t> rest_;
+
+public:
+    // @lifetime: (&'a) -> 'a
+    explicit SliceReader(Slice<uint8_t> bytes) : rest_(bytes) {}
+
+    // @lifetime: (&'a) -> &'a
+    Slice<uint8_t> remaining() const { return rest_; }
+
+    Result<size_t, Error> read(SliceMut<uint8_t> buf) {
+        size_t n = buf.len() < rest_.len() ? buf.len() : rest_.len();
+        if (n) std::memcpy(buf.as_mut_ptr(), rest_.as_ptr(), n);
+        rest_ = rest_.slice(n, rest_.len());
+        return Result<size_t, Error>::Ok(n);
+    }
+};
+
+// Appends everything written to a Vec
+class VecWriter {
+private:
+    Vec<uint8_t> bytes_;
+
+public:
+    VecWriter() : bytes_() {}
+    explicit VecWriter(Vec<uint8_t> bytes) : bytes_(std::move(bytes)) {}
+
+    // @lifetime: (&'a) -> &'a
+    const Vec<uint8_t>& get_ref() const { return bytes_; }
+
+    // @lifetime: owned
+    Vec<uint8_t> into_inner() && { return std::move(bytes_); }
+
+    Result<size_t, Error> write(Slice<uint8_t> buf) {
+        bytes_.extend_from_slice(buf);
+        return Result<size_t, Error>::Ok(buf.len());
+    }
+
+    Result<size_t, Error> write_vectored(Slice<IoSlice> bufs) {
+        size_t total = 0;
+        for (size_t i = 0; i < bufs.len(); i++) {
+            bytes_.extend_from_slice(bufs[i].as_slice());
+            total += bufs[i].len();
+        }
+        return Result<size_t, Error>::Ok(total);
+    }
+
+    Result<void, Error> flush() { return Result<void, Error>::Ok(); }
+};
+
+// Write all of buf, looping over partial writes
+template<typename W>
+Result<void, Error> write_all(W& writer, Slice<uint8_t> buf) {
+    while (!buf.is_empty()) {
+        Result<size_t, Error> n = writer.write(buf);
+        if (n.is_err()) return Result<void, Error>::Err(n.unwrap_err());
+        size_t written = n.unwrap();
+        if (written == 0) return Result<void, Error>::Err(detail::error(EIO));
+        buf = buf.slice(written, buf.len());
+    }
+    return Result<void, Error>::Ok();
+}
+
+namespace detail {
+
+template<typename W>
+Result<size_t, Error> write_vectored(W& writer, IoSlice* bufs, size_t count, std::true_type) {
+    return writer.write_vectored(Slice<IoSlice>(bufs, count));
+}
+
+// Without write_vectored, the first nonempty buffer
+template<typename W>
+Result<size_t, Error> write_vectored(W& writer, IoSlice* bufs, size_t count, std::false_type) {
+    for (size_t i = 0; i < count; i++) {
+        if (bufs[i].len()) return writer.write(bufs[i].as_slice());
+    }
+    return Result<size_t, Error>::Ok(0);
+}
+
+} // namespace detail
+
+// Write all of bufs, with as few vectored writes as the writer allows.
+// bufs is advanced past what was written.
+template<typename W>
+Result<void, Error> write_all_vectored(W& writer, SliceMut<IoSlice> bufs) {
+    IoSlice* p = bufs.as_mut_ptr();
+    size_t count = bufs.len();
+    while (count && p->len() == 0) { p++; count--; }
+    while (count) {
+        Result<size_t, Error> n = detail::write_vectored(writer, p, count, detail::has_write_vectored<W>());
+        if (n.is_err()) return Result<void, Error>::Err(n.unwrap_err());
+        size_t written = n.unwrap();
+        if (written == 0) return Result<void, Error>::Err(detail::error(EIO));
+        while (count && written >= p->len()) {
+            written -= p->len();
+            p++;
+            count--;
+        }
+        if (count) p->advance(written);
+        while (count && p->len() == 0) { p++; count--; }
+    }
+    return Result<void, Error>::Ok();
+}
+
+// Append everything left in reader to buf; returns the bytes appended
+template<typename R>
+Result<size_t, Error> read_to_end(R& reader, Vec<uint8_t>& buf) {
+    size_t start = buf.len();
+    size_t chunk = 8 * 1024;
+    while (true) {
+        if (buf.capacity() - buf.len() < chunk) buf.reserve(buf.len() + chunk);
+        size_t len = buf.len();
+        size_t spare = buf.capacity() - len;
+        buf.resize(buf.capacity(), 0);
+        Result<size_t, Error> n = reader.read(SliceMut<uint8_t>(buf.as_mut_ptr() + len, spare));
+        if (n.is_err()) {
+            buf.truncate(len);
+            return Result<size_t, Error>::Err(n.unwrap_err());
+        }
+        buf.truncate(len + n.unwrap());
+        if (n.unwrap() == 0) return Result<size_t, Error>::Ok(buf.len() - start);
+        if (chunk < DEFAULT_BUF_SIZE * 4) chunk *= 2;
+    }
+}
+
+// Adds a block buffer to any reader
+template<typename R>
+class BufReader {
+private:
+    R inner_;
+    Vec<uint8_t> buf_;  // len() is the capacity; [pos_, filled_) is unread
+    size_t pos_;
+    size_t filled_;
+
+public:
+    explicit BufReader(R inner) : BufReader(DEFAULT_BUF_SIZE, std::move(inner)) {}
+
+    BufReader(size_t capacity, R inner) : inner_(std::move(inner)), buf_(), pos_(0), filled_(0) {
+        buf_.resize(capacity ? capacity : 1, 0);
+    }
+
+    // @lifetime: owned
+    static BufReader with_capacity(size_t capacity, R inner) { return BufReader(capacity, std::move(inner)); }
+
+    size_t capacity() const { return buf_.len(); }
+
+    // The buffered, unread bytes
+    // @lifetime: (&'a) -> &'a
+    Slice<uint8_t> buffer() const { return Slice<uint8_t>(buf_.as_ptr() + pos_, filled_ - pos_); }
+
+    // The buffered bytes, reading more first if there are none; empty at
+    // the end of input
+    // @lifetime: (&'a mut) -> &'a
+    Result<Slice<uint8_t>, Error> fill_buf() {
+        if (pos_ == filled_) {
+            Result<size_t, Error> n = inner_.read(buf_.as_mut_slice());
+            if (n.is_err()) return Result<Slice<uint8_t>, Error>::Err(n.unwrap_err());
+            pos_ = 0;
+            filled_ = n.unwrap();
+        }
+        return Result<Slice<uint8_t>, Error>::Ok(buffer());
+    }
+
+    // Mark n buffered bytes as read
+    void consume(size_t n) {
+        assert(n <= filled_ - pos_ && "BufReader::consume past the buffer");
+        pos_ += n;
+    }
+
+    // Reads at least as large as the buffer skip it
+    Result<size_t, Error> read(SliceMut<uint8_t> out) {
+        if (pos_ == filled_ && out.len() >= buf_.len()) return inner_.read(std::move(out));
+        Result<Slice<uint8_t>, Error> avail = fill_buf();
+        if (avail.is_err()) return Result<size_t, Error>::Err(avail.unwrap_err());
+        Slice<uint8_t> bytes = avail.unwrap();
+        size_t n = bytes.len() < out.len() ? bytes.len() : out.len();
+        if (n) std::memcpy(out.as_mut_ptr(), bytes.as_ptr(), n);
+        consume(n);
+        return Result<size_t, Error>::Ok(n);
+    }
+
+    // Append bytes up to and including delim (or the end of input) to
+    // out; returns the bytes appended, 0 at the end of input
+    Result<size_t, Error> read_until(uint8_t delim, Vec<uint8_t>& out) {
+        size_t total = 0;
+        while (true) {
+            Result<Slice<uint8_t>, Error> avail = fill_buf();
+            if (avail.is_err()) return Result<size_t, Error>::Err(avail.unwrap_err());
+            Slice<uint8_t> bytes = avail.unwrap();
+            if (bytes.is_empty()) return Result<size_t, Error>::Ok(total);
+            size_t at = find_byte(reinterpret_cast<const char*>(bytes.as_ptr()), bytes.len(), char(delim));
+            size_t take = at == BYTES_NPOS ? bytes.len() : at + 1;
+            out.extend_from_slice(bytes.as_ptr(), take);
+            consume(take);
+            total += take;
+            if (at != BYTES_NPOS) return Result<size_t, Error>::Ok(total);
+        }
+    }
+
+    // Append the next line, '\n' included, to line; returns the bytes
+    // appended, 0 at the end of input. Invalid UTF-8 is an EILSEQ error
+    // and leaves line as it was (the bytes are still consumed).
+    Result<size_t, Error> read_line(String& line) {
+        size_t start = line.len();
+        size_t total = 0;
+        while (true) {
+            Result<Slice<uint8_t>, Error> avail = fill_buf();
+            if (avail.is_err()) {
+                line.truncate(start);
+                return Result<size_t, Error>::Err(avail.unwrap_err());
+            }
+            Slice<uint8_t> bytes = avail.unwrap();
+            if (bytes.is_empty()) break;
+            const char* chars = reinterpret_cast<const char*>(bytes.as_ptr());
+            size_t at = find_byte(chars, bytes.len(), '\n');
+            size_t take = at == BYTES_NPOS ? bytes.len() : at + 1;
+            line.push_str(str(chars, take));
+            consume(take);
+            total += take;
+            if (at != BYTES_NPOS) break;
+        }
+        if (total && str::from_utf8(line.as_ptr() + start, total).is_err()) {
+            line.truncate(start);
+            return Result<size_t, Error>::Err(detail::error(EILSEQ));
+        }
+        return Result<size_t, Error>::Ok(total);
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const R& get_ref() const { return inner_; }
+    // @lifetime: (&'a mut) -> &'a mut
+    R& get_mut() { return inner_; }
+
+    // Any buffered bytes are lost
+    // @lifetime: owned
+    R into_inner() && { return std::move(inner_); }
+};
+
+// Collects writes into a block buffer. Destruction flushes and ignores
+// errors; call flush() to see them.
+template<typename W>
+class BufWriter {
+private:
+    W inner_;
+    Vec<uint8_t> buf_;
+    size_t capacity_;
+
+    // Write out the buffer; on error, keep what was not written
+    Result<void, Error> flush_buf() {
+        size_t written = 0;
+        Result<void, Error> result = Result<void, Error>::Ok();
+        while (written < buf_.len()) {
+            Result<size_t, Error> n = inner_.write(buf_.as_slice().slice(written, buf_.len()));
+            if (n.is_err()) {
+                result = Result<void, Error>::Err(n.unwrap_err());
+                break;
+            }
+            if (n.unwrap() == 0) {
+                result = Result<void, Error>::Err(detail::error(EIO));
+                break;
+            }
+            written += n.unwrap();
+        }
+        if (written == buf_.len()) {
+            buf_.clear();
+        } else if (written) {
+            std::memmove(buf_.as_mut_ptr(), buf_.as_ptr() + written, buf_.len() - written);
+            buf_.truncate(buf_.len() - written);
+        }
+        return result;
+    }
+
+public:
+    explicit BufWriter(W inner) : BufWriter(DEFAULT_BUF_SIZE, std::move(inner)) {}
+
+    BufWriter(size_t capacity, W inner) : inner_(std::move(inner)), buf_(Vec<uint8_t>::with_capacity(capacity)), capacity_(capacity) {}
+
+    BufWriter(BufWriter&& other) noexcept
+        : inner_(std::move(other.inner_)), buf_(std::move(other.buf_)), capacity_(other.capacity_) {}
+
+    BufWriter& operator=(BufWriter&&) = delete;
+    BufWriter(const BufWriter&) = delete;
+    BufWriter& operator=(const BufWriter&) = delete;
+
+    ~BufWriter() {
+        if (!buf_.is_empty()) flush_buf();
+    }
+
+    // @lifetime: owned
+    static BufWriter with_capacity(size_t capacity, W inner) { return BufWriter(capacity, std::move(inner)); }
+
+    size_t capacity() const { return capacity_; }
+
+    // The bytes not yet written to the inner writer
+    // @lifetime: (&'a) -> &'a
+    Slice<uint8_t> buffer() const { return buf_.as_slice(); }
+
+    // Buffers all of buf; one that does not fit goes straight through
+    Result<size_t, Error> write(Slice<uint8_t> buf) {
+        if (buf_.len() + buf.len() > capacity_) {
+            Result<void, Error> flushed = flush_buf();
+            if (flushed.is_err()) return Result<size_t, Error>::Err(flushed.unwrap_err());
+        }
+        if (buf.len() >= capacity_) return inner_.write(buf);
+        buf_.extend_from_slice(buf);
+        return Result<size_t, Error>::Ok(buf.len());
+    }
+
+    Result<void, Error> write_all(Slice<uint8_t> buf) {
+        if (buf_.len() + buf.len() <= capacity_) {
+            buf_.extend_from_slice(buf);
+            return Result<void, Error>::Ok();
+        }
+        return io::write_all(*this, buf);
+    }
+
+    Result<void, Error> write_str(str s) {
+        return write_all(Slice<uint8_t>(reinterpret_cast<const uint8_t*>(s.as_ptr()), s.len()));
+    }
+
+    // Small pieces are copied together; when they do not fit, the buffer
+    // and the pieces go out in one vectored write
+    Result<size_t, Error> write_vectored(Slice<IoSlice> bufs) {
+        size_t total = 0;
+        for (size_t i = 0; i < bufs.len(); i++) total += bufs[i].len();
+        if (buf_.len() + total <= capacity_) {
+            for (size_t i = 0; i < bufs.len(); i++) buf_.extend_from_slice(bufs[i].as_slice());
+            return Result<size_t, Error>::Ok(total);
+        }
+        if (!detail::has_write_vectored<W>::value) {
+            Result<void, Error> flushed = flush_buf();
+            if (flushed.is_err()) return Result<size_t, Error>::Err(flushed.unwrap_err());
+            for (size_t i = 0; i < bufs.len(); i++) {
+                Result<void, Error> r = io::write_all(inner_, bufs[i].as_slice());
+                if (r.is_err()) return Result<size_t, Error>::Err(r.unwrap_err());
+            }
+            return Result<size_t, Error>::Ok(total);
+        }
+        Vec<IoSlice> all = Vec<IoSlice>::with_capacity(bufs.len() + 1);
+        if (!buf_.is_empty()) all.push(IoSlice(buf_.as_slice()));
+        for (size_t i = 0; i < bufs.len(); i++) all.push(bufs[i]);
+        Result<void, Error> r = write_all_vectored(inner_, all.as_mut_slice());
+        // After an error it is unknown how much of the buffer went out,
+        // so it is dropped either way
+        buf_.clear();
+        if (r.is_err()) return Result<size_t, Error>::Err(r.unwrap_err());
+        return Result<size_t, Error>::Ok(total);
+    }
+
+    Result<void, Error> flush() {
+        Result<void, Error> flushed = flush_buf();
+        if (flushed.is_err()) return flushed;
+        return inner_.flush();
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const W& get_ref() const { return inner_; }
+    // @lifetime: (&'a mut) -> &'a mut
+    W& get_mut() { return inner_; }
+
+    // Flush, then hand back the writer
+    // @lifetime: owned
+    Result<W, Error> into_inner() && {
+        Result<void, Error> flushed = flush_buf();
+        if (flushed.is_err()) return Result<W, Error>::Err(flushed.unwrap_err());
+        return Result<W, Error>::Ok(std::move(inner_));
+    }
+};
+
+} // namespace io
+} // namespace rusty
+
+#endif // RUSTY_IO_HPP
@@ -0,0 +1,485 @@
+#ifndef RUSTY_ITER_HPP
+#define RUSTY_ITER_HPP
+
+#include <cstddef>  // for size_t
+#include <new>
+#include <type_traits>
+#include <utility>  // for std::forward, std::move, std::pair
+#include "alloc.hpp"
+#include "option.hpp"
+
+// Iterator<Self, Item> - Lazy, composable iterator adaptors
+// Equivalent to Rust's Iterator trait
+//
+//   Vec<int> squares = v.iter()
+//                          .filter([](const int& x) { return x % 2 == 0; })
+//                          .map([](const int& x) { return x * x; })
+//                          .collect();
+//
+// An iterator is a class deriving from Iterator<Self, Item> that defines
+//
+//   template<typename F> bool next_with(F&& f);
+//
+// which passes the next item to f and returns true, or returns false when
+// the iterator is exhausted, and optionally `size_t size_hint() const`, a
+// lower bound on the items left. Adaptors (map, filter, zip, ...) wrap
+// their source by value and forward next_with through plain lambdas, so a
+// chain compiles down to the loop you would have written by hand: no
+// items are buffered, and nothing is allocated until collect().
+//
+// Adaptors consume the iterator they are called on, as in Rust: the
+// source is moved into the adaptor and must not be used afterwards.
+//
+// Item may be a reference (Vec::iter() yields const T&); the element it
+// refers to is borrowed from the container, which must outlive the
+// iterator and must not be modified while it is in use.
+
+// @safe
+namespace rusty {
+
+template<typename T, typename Alloc>
+class Vec;
+
+template<typename Self, typename ItemT>
+class Iterator;
+
+template<typename I, typename F>
+class Map;
+template<typename I, typename F>
+class Filter;
+template<typename I>
+class Enumerate;
+template<typename A, typename B>
+class Zip;
+template<typename I>
+class Take;
+template<typename I>
+class Skip;
+template<typename A, typename B>
+class Chain;
+
+namespace detail {
+
+// Holds the current item of a range-for loop over an iterator
+template<typename T>
+class IterSlot {
+private:
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage_;
+    bool full_;
+
+public:
+    IterSlot() : full_(false) {}
+    IterSlot(IterSlot&& other) : full_(false) {
+        if (other.full_) set(std::move(other.get()));
+    }
+    IterSlot& operator=(const IterSlot&) = delete;
+    ~IterSlot() { reset(); }
+
+    void reset() {
+        if (full_) get().~T();
+        full_ = false;
+    }
+    void set(T&& value) {
+        reset();
+        new (&storage_) T(std::move(value));
+        full_ = true;
+    }
+    T& get() { return *reinterpret_cast<T*>(&storage_); }
+};
+
+template<typename T>
+class IterSlot<T&> {
+private:
+    T* ptr_;
+
+public:
+    IterSlot() : ptr_(nullptr) {}
+    void reset() { ptr_ = nullptr; }
+    void set(T& value) { ptr_ = &value; }
+    T& get() { return *ptr_; }
+};
+
+template<typename Self>
+class IterCursor {
+private:
+    typedef typename Self::Item Item;
+    Self* iter_;
+    IterSlot<Item> current_;
+
+    void pull() {
+        IterSlot<Item>& slot = current_;
+        if (!iter_->next_with([&slot](Item x) { slot.set(std::forward<Item>(x)); })) {
+            iter_ = nullptr;
+        }
+    }
+
+public:
+    explicit IterCursor(Self* iter) : iter_(iter) {
+        if (iter_) pull();
+    }
+
+    typename std::remove_reference<Item>::type& operator*() { return current_.get(); }
+
+    IterCursor& operator++() {
+        current_.reset();
+        pull();
+        return *this;
+    }
+
+    bool operator!=(const IterCursor& other) const { return iter_ != other.iter_; }
+    bool operator==(const IterCursor& other) const { return iter_ == other.iter_; }
+};
+
+// Overloads picked by rank: the highest applicable one wins
+struct rank0 {};
+struct rank1 : rank0 {};
+struct rank2 : rank1 {};
+
+template<typename C, typename T>
+auto collect_push(C& c, T&& x, rank2) -> decltype(c.push(std::forward<T>(x)), void()) {
+    c.push(std::forward<T>(x));
+}
+
+template<typename C, typename T>
+auto collect_push(C& c, T&& x, rank1) -> decltype(c.insert(std::forward<T>(x)), void()) {
+    c.insert(std::forward<T>(x));
+}
+
+// Maps collect (key, value) pairs
+template<typename C, typename T>
+auto collect_push(C& c, T&& x, rank0)
+    -> decltype(c.insert(std::forward<T>(x).first, std::forward<T>(x).second), void()) {
+    c.insert(std::forward<T>(x).first, std::forward<T>(x).second);
+}
+
+template<typename C>
+auto collect_reserve(C& c, size_t n, rank1) -> decltype(c.reserve(n), void()) {
+    if (n > 0) c.reserve(n);
+}
+
+template<typename C>
+void collect_reserve(C&, size_t, rank0) {}
+
+} // namespace detail
+
+template<typename Self, typename ItemT>
+class Iterator {
+private:
+    Self& self() { return static_cast<Self&>(*this); }
+    const Self& self() const { return static_cast<const Self&>(*this); }
+
+public:
+    typedef ItemT Item;
+
+    // Lower bound on the number of items left
+    size_t size_hint() const { return 0; }
+
+    // The next item, or None once exhausted
+    // @lifetime: (&'a mut) -> &'a
+    Option<Item> next() {
+        Option<Item> out = None;
+        self().next_with([&out](Item x) { out = Option<Item>(std::forward<Item>(x)); });
+        return out;
+    }
+
+    // Adaptors
+
+    // @lifetime: owned
+    template<typename F>
+    rusty::Map<Self, F> map(F f) {
+        return rusty::Map<Self, F>(std::move(self()), std::move(f));
+    }
+
+    // Keep items for which pred(item) is true
+    // @lifetime: owned
+    template<typename F>
+    Filter<Self, F> filter(F pred) {
+        return Filter<Self, F>(std::move(self()), std::move(pred));
+    }
+
+    // Pair each item with its index: std::pair<size_t, Item>
+    // @lifetime: owned
+    Enumerate<Self> enumerate() {
+        return Enumerate<Self>(std::move(self()));
+    }
+
+    // Items of both, as std::pair<Item, Other::Item>, until either ends
+    // @lifetime: owned
+    template<typename Other>
+    Zip<Self, Other> zip(Other other) {
+        return Zip<Self, Other>(std::move(self()), std::move(other));
+    }
+
+    // @lifetime: owned
+    Take<Self> take(size_t n) {
+        return Take<Self>(std::move(self()), n);
+    }
+
+    // @lifetime: owned
+    Skip<Self> skip(size_t n) {
+        return Skip<Self>(std::move(self()), n);
+    }
+
+    // This iterator's items, then other's
+    // @lifetime: owned
+    template<typename Other>
+    Chain<Self, Other> chain(Other other) {
+        return Chain<Self, Other>(std::move(self()), std::move(other));
+    }
+
+    // Consumers
+
+    template<typename B, typename F>
+    B fold(B init, F f) {
+        while (self().next_with([&init, &f](Item x) {
+            init = f(std::move(init), std::forward<Item>(x));
+        })) {}
+        return init;
+    }
+
+    template<typename F>
+    void for_each(F f) {
+        while (self().next_with([&f](Item x) { f(std::forward<Item>(x)); })) {}
+    }
+
+    size_t count() {
+        size_t n = 0;
+        while (self().next_with([&n](Item) { n++; })) {}
+        return n;
+    }
+
+    typename std::decay<Item>::type sum() {
+        typedef typename std::decay<Item>::type S;
+        S total = S();
+        while (self().next_with([&total](Item x) { total = total + x; })) {}
+        return total;
+    }
+
+    // Stops at the first item for which pred is true
+    template<typename F>
+    bool any(F pred) {
+        bool found = false;
+        while (!found && self().next_with([&found, &pred](Item x) { found = pred(x); })) {}
+        return found;
+    }
+
+    // Stops at the first item for which pred is false
+    template<typename F>
+    bool all(F pred) {
+        bool ok = true;
+        while (ok && self().next_with([&ok, &pred](Item x) { ok = pred(x); })) {}
+        return ok;
+    }
+
+    // The first item for which pred is true
+    // @lifetime: (&'a mut) -> &'a
+    template<typename F>
+    Option<Item> find(F pred) {
+        Option<Item> out = None;
+        bool found = false;
+        while (!found && self().next_with([&](Item x) {
+            if (pred(x)) {
+                found = true;
+                out = Option<Item>(std::forward<Item>(x));
+            }
+        })) {}
+        return out;
+    }
+
+    // Build a container from the items, reserving size_hint() up front.
+    // C defaults to Vec; anything with push(item), insert(item) or (for
+    // pairs) insert(key, value) works.
+    // @lifetime: owned
+    template<typename C = Vec<typename std::decay<Item>::type, Global>>
+    C collect() {
+        C out;
+        detail::collect_reserve(out, self().size_hint(), detail::rank1());
+        while (self().next_with([&out](Item x) {
+            detail::collect_push(out, std::forward<Item>(x), detail::rank2());
+        })) {}
+        return out;
+    }
+
+    // Range-for support; the loop consumes the iterator
+    // @lifetime: (&'a mut) -> &'a
+    detail::IterCursor<Self> begin() { return detail::IterCursor<Self>(&self()); }
+    // @lifetime: (&'a mut) -> &'a
+    detail::IterCursor<Self> end() { return detail::IterCursor<Self>(nullptr); }
+};
+
+template<typename I, typename F>
+class Map : public Iterator<Map<I, F>,
+                            decltype(std::declval<F&>()(std::declval<typename I::Item>()))> {
+private:
+    typedef typename I::Item In;
+    I inner_;
+    F f_;
+
+public:
+    Map(I inner, F f) : inner_(std::move(inner)), f_(std::move(f)) {}
+
+    template<typename G>
+    bool next_with(G&& g) {
+        F& f = f_;
+        return inner_.next_with([&f, &g](In x) { g(f(std::forward<In>(x))); });
+    }
+
+    size_t size_hint() const { return inner_.size_hint(); }
+};
+
+template<typename I, typename F>
+class Filter : public Iterator<Filter<I, F>, typename I::Item> {
+private:
+    typedef typename I::Item In;
+    I inner_;
+    F pred_;
+
+public:
+    Filter(I inner, F pred) : inner_(std::move(inner)), pred_(std::move(pred)) {}
+
+    template<typename G>
+    bool next_with(G&& g) {
+        F& pred = pred_;
+        for (;;) {
+            bool matched = false;
+            bool got = inner_.next_with([&pred, &g, &matched](In x) {
+                if (pred(static_cast<const typename std::remove_reference<In>::type&>(x))) {
+                    matched = true;
+                    g(std::forward<In>(x));
+                }
+            });
+            if (!got) return false;
+            if (matched) return true;
+        }
+    }
+};
+
+template<typename I>
+class Enumerate : public Iterator<Enumerate<I>, std::pair<size_t, typename I::Item>> {
+private:
+    typedef typename I::Item In;
+    typedef std::pair<size_t, In> Out;
+    I inner_;
+    size_t index_;
+
+public:
+    explicit Enumerate(I inner) : inner_(std::move(inner)), index_(0) {}
+
+    template<typename G>
+    bool next_with(G&& g) {
+        size_t& index = index_;
+        return inner_.next_with([&index, &g](In x) { g(Out(index++, std::forward<In>(x))); });
+    }
+
+    size_t size_hint() const { return inner_.size_hint(); }
+};
+
+template<typename A, typename B>
+class Zip : public Iterator<Zip<A, B>, std::pair<typename A::Item, typename B::Item>> {
+private:
+    typedef typename A::Item InA;
+    typedef typename B::Item InB;
+    typedef std::pair<InA, InB> Out;
+    A a_;
+    B b_;
+
+public:
+    Zip(A a, B b) : a_(std::move(a)), b_(std::move(b)) {}
+
+    template<typename G>
+    bool next_with(G&& g) {
+        B& b = b_;
+        bool got = false;
+        a_.next_with([&b, &g, &got](InA x) {
+            got = b.next_with([&x, &g](InB y) {
+                g(Out(std::forward<InA>(x), std::forward<InB>(y)));
+            });
+        });
+        return got;
+    }
+
+    size_t size_hint() const {
+        size_t a = a_.size_hint();
+        size_t b = b_.size_hint();
+        return a < b ? a : b;
+    }
+};
+
+template<typename I>
+class Take : public Iterator<Take<I>, typename I::Item> {
+private:
+    I inner_;
+    size_t left_;
+
+public:
+    Take(I inner, size_t n) : inner_(std::move(inner)), left_(n) {}
+
+    template<typename G>
+    bool next_with(G&& g) {
+        if (left_ == 0) return false;
+        left_--;
+        return inner_.next_with(g);
+    }
+
+    size_t size_hint() const {
+        size_t n = inner_.size_hint();
+        return n < left_ ? n : left_;
+    }
+};
+
+template<typename I>
+class Skip : public Iterator<Skip<I>, typename I::Item> {
+private:
+    typedef typename I::Item In;
+    I inner_;
+    size_t skip_;
+
+public:
+    Skip(I inner, size_t n) : inner_(std::move(inner)), skip_(n) {}
+
+    template<typename G>
+    bool next_with(G&& g) {
+        while (skip_ > 0) {
+            skip_--;
+            if (!inner_.next_with([](In) {})) {
+                skip_ = 0;
+                return false;
+            }
+        }
+        return inner_.next_with(g);
+    }
+
+    size_t size_hint() const {
+        size_t n = inner_.size_hint();
+        return n > skip_ ? n - skip_ : 0;
+    }
+};
+
+template<typename A, typename B>
+class Chain : public Iterator<Chain<A, B>, typename A::Item> {
+    static_assert(std::is_same<typename A::Item, typename B::Item>::value,
+                  "chain() needs iterators with the same Item type");
+
+private:
+    A a_;
+    B b_;
+    bool a_done_;
+
+public:
+    Chain(A a, B b) : a_(std::move(a)), b_(std::move(b)), a_done_(false) {}
+
+    template<typename G>
+    bool next_with(G&& g) {
+        if (!a_done_) {
+            if (a_.next_with(g)) return true;
+            a_done_ = true;
+        }
+        return b_.next_with(g);
+    }
+
+    size_t size_hint() const { return (a_done_ ? 0 : a_.size_hint()) + b_.size_hint(); }
+};
+
+} // namespace rusty
+
+#endif // RUSTY_ITER_HPP
@@ -0,0 +1,626 @@
+#ifndef RUSTY_LRU_HPP
+#define RUSTY_LRU_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include "alloc.hpp"
+#include "fwd.hpp"
+#include "hash.hpp"
+#include "hashmap.hpp"
+#include "option.hpp"
+#include "vec.hpp"
+
+// LruCache<K, V> - A bounded map that evicts the least recently used entry
+// Equivalent to Rust's lru::LruCache
+//
+// ClockCache<K, V> - The same interface with CLOCK (second chance)
+// eviction: a hit only sets a bit instead of relinking a list node, so hits
+// are cheaper and touch no other entry, at the cost of a coarser
+// approximation of recency.
+//
+// Both caches keep their entries in one Vec of nodes, allocated at full
+// capacity up front and never reallocated, plus a SwissTable HashMap from
+// key to node index. The map stores a pointer to the key inside its node
+// rather than a second copy, so K needs no copy constructor and each
+// entry costs one node plus one 12-16 byte slot. LruCache threads its
+// recency list through the nodes as 32-bit indices; there is no
+// allocation per entry.
+//
+// get() counts as a use and may reorder entries; peek() and contains()
+// do not. A capacity of zero stores nothing: every push hands its entry
+// straight back.
+//
+// The *_with_hash functions take a hash from hash_key(), for callers that
+// already hashed the key (ShardedCache in concurrent_cache.hpp).
+
+// @safe
+namespace rusty {
+
+namespace detail {
+
+// Map key pointing at the key stored in a cache node
+template<typename K>
+struct CacheKeyRef {
+    const K* key;
+};
+
+template<typename K, typename Hash>
+struct CacheKeyHash {
+    typedef void is_transparent;
+
+    Hash hash;
+
+    size_t operator()(const CacheKeyRef<K>& ref) const { return hash(*ref.key); }
+
+    template<typename Q>
+    size_t operator()(const Q& key) const { return hash(key); }
+};
+
+template<typename K, typename KeyEqual>
+struct CacheKeyEq {
+    typedef void is_transparent;
+
+    KeyEqual eq;
+
+    // Each node's key is in the map at most once, so two refs name the
+    // same key exactly when they point at the same node
+    bool operator()(const CacheKeyRef<K>& a, const CacheKeyRef<K>& b) const {
+        return a.key == b.key;
+    }
+
+    template<typename Q>
+    bool operator()(const CacheKeyRef<K>& stored, const Q& key) const {
+        return eq(*stored.key, key);
+    }
+};
+
+// Node storage and key index shared by the cache policies. Meta is the
+// per-node policy state (list links, reference bit).
+template<typename K, typename V, typename Meta, typename Hash, typename KeyEqual, typename Alloc>
+struct CacheSlots {
+    struct Node {
+        K key;
+        V value;
+        Meta meta;
+    };
+
+    typedef CacheKeyRef<K> Ref;
+    typedef HashMap<Ref, uint32_t, CacheKeyHash<K, Hash>, CacheKeyEq<K, KeyEqual>, Alloc> Index;
+
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    Vec<Node, Alloc> nodes;  // Never reallocated: the index points into it
+    Index index;
+    size_t capacity;
+
+    CacheSlots(size_t cap, const Alloc& alloc)
+        : nodes(Vec<Node, Alloc>::with_capacity_in(cap, alloc)),
+          index(Index::with_capacity_in(cap, alloc)),
+          capacity(cap) {
+        assert(cap < NIL);
+    }
+
+    size_t len() const { return nodes.len(); }
+    bool full() const { return nodes.len() == capacity; }
+
+    template<typename Q>
+    size_t hash_key(const Q& key) const { return index.hash_key(key); }
+
+    template<typename Q>
+    uint32_t find(const Q& key, size_t hash) const {
+        Option<const uint32_t&> found = index.get_with_hash(key, hash);
+        return found.is_some() ? found.unwrap() : NIL;
+    }
+
+    // Append a node; the caller checks !full()
+    uint32_t push_node(K key, V value, Meta meta, size_t hash) {
+        assert(!full());
+        uint32_t i = uint32_t(nodes.len());
+        Node node = { std::move(key), std::move(value), meta };
+        nodes.push(std::move(node));
+        index.insert_with_hash(Ref{&nodes[i].key}, i, hash);
+        return i;
+    }
+
+    // Reuse node i for key/value, which come back holding the old entry
+    void replace_node(uint32_t i, K& key, V& value, size_t hash) {
+        Node& node = nodes[i];
+        index.remove(Ref{&node.key});
+        using std::swap;
+        swap(node.key, key);
+        swap(node.value, value);
+        index.insert_with_hash(Ref{&node.key}, i, hash);
+    }
+
+    // Remove node i and fill the hole with the last node. moved is set to
+    // the last node's old index (i itself when node i was last).
+    std::pair<K, V> remove_node(uint32_t i, uint32_t& moved) {
+        index.remove(Ref{&nodes[i].key});
+        moved = uint32_t(nodes.len() - 1);
+        if (moved != i) {
+            Ref last = {&nodes[moved].key};
+            size_t hash = index.hash_key(last);
+            index.entry_with_hash(last, hash).into_occupied().remove();
+            using std::swap;
+            swap(nodes[i], nodes[moved]);
+            index.insert_with_hash(Ref{&nodes[i].key}, i, hash);
+        }
+        Node node = nodes.pop();
+        return std::make_pair(std::move(node.key), std::move(node.value));
+    }
+
+    void clear() {
+        index.clear();
+        nodes.clear();
+    }
+};
+
+} // namespace detail
+
+template<typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+class LruCache {
+private:
+    struct Links {
+        uint32_t prev;  // Toward the most recently used end
+        uint32_t next;  // Toward the least recently used end
+    };
+
+    typedef detail::CacheSlots<K, V, Links, Hash, KeyEqual, Alloc> Slots;
+
+    static constexpr uint32_t NIL = Slots::NIL;
+
+    Slots slots_;
+    uint32_t head_;  // Most recently used
+    uint32_t tail_;  // Least recently used
+
+    Links& links(uint32_t i) { return slots_.nodes[i].meta; }
+
+    void unlink(uint32_t i) {
+        Links l = links(i);
+        if (l.prev != NIL) links(l.prev).next = l.next;
+        else head_ = l.next;
+        if (l.next != NIL) links(l.next).prev = l.prev;
+        else tail_ = l.prev;
+    }
+
+    void link_front(uint32_t i) {
+        links(i).prev = NIL;
+        links(i).next = head_;
+        if (head_ != NIL) links(head_).prev = i;
+        else tail_ = i;
+        head_ = i;
+    }
+
+    void touch(uint32_t i) {
+        if (i == head_) return;
+        unlink(i);
+        link_front(i);
+    }
+
+    std::pair<K, V> remove_at(uint32_t i) {
+        unlink(i);
+        uint32_t moved;
+        std::pair<K, V> entry = slots_.remove_node(i, moved);
+        if (moved != i) {
+            // The node that was last now lives at i; repoint its neighbours
+            Links l = links(i);
+            if (l.prev != NIL) links(l.prev).next = i;
+            else head_ = i;
+            if (l.next != NIL) links(l.next).prev = i;
+            else tail_ = i;
+        }
+        return entry;
+    }
+
+    // Insert a key known to be absent, evicting the LRU entry if full
+    Option<std::pair<K, V>> insert_new(K key, V value, size_t hash) {
+        if (!slots_.full()) {
+            Links none = { NIL, NIL };
+            link_front(slots_.push_node(std::move(key), std::move(value), none, hash));
+            return None;
+        }
+        if (tail_ == NIL) {
+            return Option<std::pair<K, V>>(std::make_pair(std::move(key), std::move(value)));
+        }
+        uint32_t victim = tail_;
+        slots_.replace_node(victim, key, value, hash);
+        touch(victim);
+        return Option<std::pair<K, V>>(std::make_pair(std::move(key), std::move(value)));
+    }
+
+public:
+    typedef K key_type;
+    typedef V mapped_type;
+    typedef Hash hasher;
+
+    // A zero-capacity cache
+    LruCache() : slots_(0, Alloc()), head_(NIL), tail_(NIL) {}
+
+    explicit LruCache(size_t capacity, const Alloc& alloc = Alloc())
+        : slots_(capacity, alloc), head_(NIL), tail_(NIL) {}
+
+    // Factory methods
+    // @lifetime: owned
+    static LruCache new_(size_t capacity) { return LruCache(capacity); }
+
+    // @lifetime: owned
+    static LruCache new_in(size_t capacity, const Alloc& alloc) { return LruCache(capacity, alloc); }
+
+    // Move-only
+    LruCache(const LruCache&) = delete;
+    LruCache& operator=(const LruCache&) = delete;
+    LruCache(LruCache&&) = default;
+    LruCache& operator=(LruCache&&) = default;
+
+    size_t len() const { return slots_.len(); }
+    bool is_empty() const { return slots_.len() == 0; }
+    size_t cap() const { return slots_.capacity; }
+
+    size_t hash_key(const K& key) const { return slots_.hash_key(key); }
+
+    // The value for key, marking it most recently used
+    // @lifetime: (&'a mut) -> &'a mut
+    Option<V&> get(const K& key) { return get_with_hash(key, hash_key(key)); }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    Option<V&> get_with_hash(const K& key, size_t hash) {
+        uint32_t i = slots_.find(key, hash);
+        if (i == NIL) return None;
+        touch(i);
+        return Option<V&>(slots_.nodes[i].value);
+    }
+
+    // The value for key, leaving the order alone
+    // @lifetime: (&'a) -> &'a
+    Option<const V&> peek(const K& key) const {
+        uint32_t i = slots_.find(key, hash_key(key));
+        if (i == NIL) return None;
+        return Option<const V&>(slots_.nodes[i].value);
+    }
+
+    bool contains(const K& key) const {
+        return slots_.find(key, hash_key(key)) != NIL;
+    }
+
+    // Mark key most recently used; false if absent
+    bool promote(const K& key) {
+        uint32_t i = slots_.find(key, hash_key(key));
+        if (i == NIL) return false;
+        touch(i);
+        return true;
+    }
+
+    // Insert or update, returning the previous value for key. A full
+    // cache drops its least recently used entry to make room.
+    // @lifetime: owned
+    Option<V> put(K key, V value) {
+        size_t hash = hash_key(key);
+        return put_with_hash(std::move(key), std::move(value), hash);
+    }
+
+    // @lifetime: owned
+    Option<V> put_with_hash(K key, V value, size_t hash) {
+        uint32_t i = slots_.find(key, hash);
+        if (i != NIL) {
+            using std::swap;
+            swap(slots_.nodes[i].value, value);
+            touch(i);
+            return Option<V>(std::move(value));
+        }
+        insert_new(std::move(key), std::move(value), hash);
+        return None;
+    }
+
+    // Insert or update, returning the entry that left the cache: key with
+    // its old value on update, or the evicted entry
+    // @lifetime: owned
+    Option<std::pair<K, V>> push(K key, V value) {
+        size_t hash = hash_key(key);
+        return push_with_hash(std::move(key), std::move(value), hash);
+    }
+
+    // @lifetime: owned
+    Option<std::pair<K, V>> push_with_hash(K key, V value, size_t hash) {
+        uint32_t i = slots_.find(key, hash);
+        if (i != NIL) {
+            using std::swap;
+            swap(slots_.nodes[i].value, value);
+            touch(i);
+            return Option<std::pair<K, V>>(std::make_pair(std::move(key), std::move(value)));
+        }
+        return insert_new(std::move(key), std::move(value), hash);
+    }
+
+    // The value for key, inserting f() first if absent (f is only called
+    // when needed). Must not be called on a zero-capacity cache.
+    template<typename F>
+    // @lifetime: (&'a mut) -> &'a mut
+    V& get_or_insert_with(K key, F f) {
+        assert(cap() > 0);
+        size_t hash = hash_key(key);
+        uint32_t i = slots_.find(key, hash);
+        if (i == NIL) {
+            insert_new(std::move(key), f(), hash);
+            i = head_;
+        } else {
+            touch(i);
+        }
+        return slots_.nodes[i].value;
+    }
+
+    // @lifetime: owned
+    Option<V> remove(const K& key) { return remove_with_hash(key, hash_key(key)); }
+
+    // @lifetime: owned
+    Option<V> remove_with_hash(const K& key, size_t hash) {
+        uint32_t i = slots_.find(key, hash);
+        if (i == NIL) return None;
+        return Option<V>(remove_at(i).second);
+    }
+
+    // Remove and return the least recently used entry
+    // @lifetime: owned
+    Option<std::pair<K, V>> pop_lru() {
+        if (tail_ == NIL) return None;
+        return Option<std::pair<K, V>>(remove_at(tail_));
+    }
+
+    // The entry pop_lru() would remove
+    // @lifetime: (&'a) -> &'a
+    Option<std::pair<const K*, const V*>> peek_lru() const {
+        if (tail_ == NIL) return None;
+        const typename Slots::Node& node = slots_.nodes[tail_];
+        return Option<std::pair<const K*, const V*>>(std::make_pair(&node.key, &node.value));
+    }
+
+    void clear() {
+        slots_.clear();
+        head_ = NIL;
+        tail_ = NIL;
+    }
+
+    // Change the capacity, dropping least recently used entries that no
+    // longer fit. Reallocates the node storage.
+    void resize(size_t capacity) {
+        while (len() > capacity) pop_lru();
+        LruCache resized(capacity, slots_.nodes.allocator());
+        for (uint32_t i = tail_; i != NIL; i = links(i).prev) {
+            typename Slots::Node& node = slots_.nodes[i];
+            size_t hash = hash_key(node.key);
+            resized.insert_new(std::move(node.key), std::move(node.value), hash);
+        }
+        *this = std::move(resized);
+    }
+
+    // Call f(key, value) from most to least recently used
+    template<typename F>
+    void for_each(F f) const {
+        for (uint32_t i = head_; i != NIL; i = slots_.nodes[i].meta.next) {
+            f(slots_.nodes[i].key, slots_.nodes[i].value);
+        }
+    }
+};
+
+template<typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+constexpr uint32_t LruCache<K, V, Hash, KeyEqual, Alloc>::NIL;
+
+template<typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+class ClockCache {
+private:
+    struct Bit {
+        bool referenced;  // Used since the hand last passed
+    };
+
+    typedef detail::CacheSlots<K, V, Bit, Hash, KeyEqual, Alloc> Slots;
+
+    static constexpr uint32_t NIL = Slots::NIL;
+
+    Slots slots_;
+    uint32_t hand_;  // Next node the clock looks at
+
+    // Sweep the hand, clearing reference bits, until it reaches a node
+    // that has not been used since the last sweep
+    uint32_t pick_victim() {
+        while (true) {
+            uint32_t i = hand_;
+            hand_ = i + 1 == slots_.len() ? 0 : i + 1;
+            Bit& bit = slots_.nodes[i].meta;
+            if (!bit.referenced) return i;
+            bit.referenced = false;
+        }
+    }
+
+    std::pair<K, V> remove_at(uint32_t i) {
+        uint32_t moved;
+        std::pair<K, V> entry = slots_.remove_node(i, moved);
+        if (hand_ == moved) hand_ = i;
+        if (hand_ >= slots_.len()) hand_ = 0;
+        return entry;
+    }
+
+    // Insert a key known to be absent, evicting a victim if full. at is
+    // set to the new entry's node.
+    Option<std::pair<K, V>> insert_new(K key, V value, size_t hash, bool referenced, uint32_t& at) {
+        Bit bit = { referenced };
+        if (!slots_.full()) {
+            at = slots_.push_node(std::move(key), std::move(value), bit, hash);
+            return None;
+        }
+        at = NIL;
+        if (slots_.len() == 0) {
+            return Option<std::pair<K, V>>(std::make_pair(std::move(key), std::move(value)));
+        }
+        at = pick_victim();
+        slots_.replace_node(at, key, value, hash);
+        slots_.nodes[at].meta = bit;
+        return Option<std::pair<K, V>>(std::make_pair(std::move(key), std::move(value)));
+    }
+
+public:
+    typedef K key_type;
+    typedef V mapped_type;
+    typedef Hash hasher;
+
+    // A zero-capacity cache
+    ClockCache() : slots_(0, Alloc()), hand_(0) {}
+
+    explicit ClockCache(size_t capacity, const Alloc& alloc = Alloc())
+        : slots_(capacity, alloc), hand_(0) {}
+
+    // Factory methods
+    // @lifetime: owned
+    static ClockCache new_(size_t capacity) { return ClockCache(capacity); }
+
+    // @lifetime: owned
+    static ClockCache new_in(size_t capacity, const Alloc& alloc) { return ClockCache(capacity, alloc); }
+
+    // Move-only
+    ClockCache(const ClockCache&) = delete;
+    ClockCache& operator=(const ClockCache&) = delete;
+    ClockCache(ClockCache&&) = default;
+    ClockCache& operator=(ClockCache&&) = default;
+
+    size_t len() const { return slots_.len(); }
+    bool is_empty() const { return slots_.len() == 0; }
+    size_t cap() const { return slots_.capacity; }
+
+    size_t hash_key(const K& key) const { return slots_.hash_key(key); }
+
+    // The value for key, setting its reference bit
+    // @lifetime: (&'a mut) -> &'a mut
+    Option<V&> get(const K& key) { return get_with_hash(key, hash_key(key)); }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    Option<V&> get_with_hash(const K& key, size_t hash) {
+        uint32_t i = slots_.find(key, hash);
+        if (i == NIL) return None;
+        slots_.nodes[i].meta.referenced = true;
+        return Option<V&>(slots_.nodes[i].value);
+    }
+
+    // The value for key, leaving its reference bit alone
+    // @lifetime: (&'a) -> &'a
+    Option<const V&> peek(const K& key) const {
+        uint32_t i = slots_.find(key, hash_key(key));
+        if (i == NIL) return None;
+        return Option<const V&>(slots_.nodes[i].value);
+    }
+
+    bool contains(const K& key) const {
+        return slots_.find(key, hash_key(key)) != NIL;
+    }
+
+    // Insert or update, returning the previous value for key. A full
+    // cache evicts the first entry the clock hand finds unreferenced.
+    // @lifetime: owned
+    Option<V> put(K key, V value) {
+        size_t hash = hash_key(key);
+        return put_with_hash(std::move(key), std::move(value), hash);
+    }
+
+    // @lifetime: owned
+    Option<V> put_with_hash(K key, V value, size_t hash) {
+        uint32_t i = slots_.find(key, hash);
+        if (i != NIL) {
+            using std::swap;
+            swap(slots_.nodes[i].value, value);
+            slots_.nodes[i].meta.referenced = true;
+            return Option<V>(std::move(value));
+        }
+        uint32_t at;
+        insert_new(std::move(key), std::move(value), hash, false, at);
+        return None;
+    }
+
+    // Insert or update, returning the entry that left the cache: key with
+    // its old value on update, or the evicted entry
+    // @lifetime: owned
+    Option<std::pair<K, V>> push(K key, V value) {
+        size_t hash = hash_key(key);
+        return push_with_hash(std::move(key), std::move(value), hash);
+    }
+
+    // @lifetime: owned
+    Option<std::pair<K, V>> push_with_hash(K key, V value, size_t hash) {
+        uint32_t i = slots_.find(key, hash);
+        if (i != NIL) {
+            using std::swap;
+            swap(slots_.nodes[i].value, value);
+            slots_.nodes[i].meta.referenced = true;
+            return Option<std::pair<K, V>>(std::make_pair(std::move(key), std::move(value)));
+        }
+        uint32_t at;
+        return insert_new(std::move(key), std::move(value), hash, false, at);
+    }
+
+    // The value for key, inserting f() first if absent (f is only called
+    // when needed). Must not be called on a zero-capacity cache.
+    template<typename F>
+    // @lifetime: (&'a mut) -> &'a mut
+    V& get_or_insert_with(K key, F f) {
+        assert(cap() > 0);
+        size_t hash = hash_key(key);
+        uint32_t i = slots_.find(key, hash);
+        if (i == NIL) {
+            insert_new(std::move(key), f(), hash, false, i);
+        } else {
+            slots_.nodes[i].meta.referenced = true;
+        }
+        return slots_.nodes[i].value;
+    }
+
+    // @lifetime: owned
+    Option<V> remove(const K& key) { return remove_with_hash(key, hash_key(key)); }
+
+    // @lifetime: owned
+    Option<V> remove_with_hash(const K& key, size_t hash) {
+        uint32_t i = slots_.find(key, hash);
+        if (i == NIL) return None;
+        return Option<V>(remove_at(i).second);
+    }
+
+    // Run the clock and remove the entry it picks
+    // @lifetime: owned
+    Option<std::pair<K, V>> evict() {
+        if (slots_.len() == 0) return None;
+        return Option<std::pair<K, V>>(remove_at(pick_victim()));
+    }
+
+    void clear() {
+        slots_.clear();
+        hand_ = 0;
+    }
+
+    // Change the capacity, evicting entries that no longer fit.
+    // Reallocates the node storage.
+    void resize(size_t capacity) {
+        while (len() > capacity) evict();
+        ClockCache resized(capacity, slots_.nodes.allocator());
+        for (size_t i = 0; i < slots_.len(); i++) {
+            typename Slots::Node& node = slots_.nodes[i];
+            size_t hash = hash_key(node.key);
+            uint32_t at;
+            resized.insert_new(std::move(node.key), std::move(node.value), hash, node.meta.referenced, at);
+        }
+        resized.hand_ = hand_ < resized.len() ? hand_ : 0;
+        *this = std::move(resized);
+    }
+
+    // Call f(key, value) for every entry, in storage order
+    template<typename F>
+    void for_each(F f) const {
+        for (size_t i = 0; i < slots_.len(); i++) {
+            f(slots_.nodes[i].key, slots_.nodes[i].value);
+        }
+    }
+};
+
+template<typename K, typename V, typename Hash, typename KeyEqual, typename Alloc>
+constexpr uint32_t ClockCache<K, V, Hash, KeyEqual, Alloc>::NIL;
+
+} // namespace rusty
+
+#endif // RUSTY_LRU_HPP
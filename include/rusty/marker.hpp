@@ -0,0 +1,73 @@
+#ifndef RUSTY_MARKER_HPP
+#define RUSTY_MARKER_HPP
+
+#include <functional>  // for std::reference_wrapper
+#include <type_traits>
+
+// is_send<T> / is_sync<T> - Rust's Send and Sync marker traits
+//
+// Send: a value of the type may be moved to another thread and dropped
+// there. Sync: several threads may use a shared reference to one value at
+// the same time; T is Sync exactly when const T& is Send.
+//
+// Like Rust's auto traits, both hold unless something inside the type says
+// otherwise. An instance of a class template is Send (Sync) when all of its
+// type arguments are, so Vec<Rc<int>>, Option<Rc<int>> and Box<Rc<int>> are
+// neither. Types that are not thread-safe opt out by specializing (Rc,
+// Weak, RefCell); types whose guarantees differ from their contents' say so
+// explicitly (Arc, Mutex, Slice):
+//   template<typename T> struct is_send<MyHandle<T>> : std::false_type {};
+//
+// Scalars, raw pointers and lambdas are assumed to be both. The compiler
+// cannot see what a lambda captures, so rusty::thread checks the values
+// passed to spawn() here and rusty-cpp-checker checks lambda captures at
+// spawn sites.
+
+// @safe
+namespace rusty {
+
+namespace detail {
+
+template<bool...>
+struct bool_pack;
+
+template<bool... Bs>
+struct all_of : std::is_same<bool_pack<true, Bs...>, bool_pack<Bs..., true>> {};
+
+} // namespace detail
+
+template<typename T>
+struct is_send : std::true_type {};
+
+template<typename T>
+struct is_sync : std::true_type {};
+
+// Containers and wrappers inherit from their type arguments
+template<template<typename...> class C, typename... Ts>
+struct is_send<C<Ts...>> : detail::all_of<is_send<Ts>::value...> {};
+
+template<template<typename...> class C, typename... Ts>
+struct is_sync<C<Ts...>> : detail::all_of<is_sync<Ts>::value...> {};
+
+template<typename T>
+struct is_send<const T> : is_send<T> {};
+
+template<typename T>
+struct is_sync<const T> : is_sync<T> {};
+
+// Sending a reference shares the referent
+template<typename T>
+struct is_send<T&> : is_sync<T> {};
+
+template<typename T>
+struct is_sync<T&> : is_sync<T> {};
+
+template<typename T>
+struct is_send<std::reference_wrapper<T>> : is_sync<T> {};
+
+template<typename T>
+struct is_sync<std::reference_wrapper<T>> : is_sync<T> {};
+
+} // namespace rusty
+
+#endif // RUSTY_MARKER_HPP
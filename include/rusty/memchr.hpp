@@ -0,0 +1,232 @@
+#ifndef RUSTY_MEMCHR_HPP
+#define RUSTY_MEMCHR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Byte-span search kernels used by String and str
+// Unlike strchr/strstr they take explicit lengths, so embedded NULs are
+// ordinary bytes and haystacks need no terminator.
+//
+// Backend, selected at compile time:
+// - AVX2: 32 bytes per step (whenever the target has AVX2)
+// - SSE2: 16 bytes per step (default on x86-64)
+// - NEON: 16 bytes per step (little-endian AArch64)
+// - SWAR: 8 bytes in a uint64_t (portable fallback, force with
+//   -DRUSTY_MEMCHR_SWAR)
+//
+// Substring search compares the needle's first and last bytes at every
+// position of a chunk at once and only verifies the surviving candidates,
+// which keeps the common no-match case at two compares per chunk.
+#if defined(RUSTY_MEMCHR_SWAR)
+#define RUSTY_BYTES_SWAR 1
+#elif defined(__AVX2__)
+#define RUSTY_BYTES_AVX2 1
+#elif defined(__SSE2__)
+#define RUSTY_BYTES_SSE2 1
+#elif defined(__ARM_NEON) && defined(__ARM_ARCH_ISA_A64) && \
+      defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define RUSTY_BYTES_NEON 1
+#else
+#define RUSTY_BYTES_SWAR 1
+#endif
+
+// Only the AVX2 path needs <immintrin.h>; <emmintrin.h> is a tenth of its size
+#if defined(RUSTY_BYTES_AVX2)
+#include <immintrin.h>
+#elif defined(RUSTY_BYTES_SSE2)
+#include <emmintrin.h>
+#elif defined(RUSTY_BYTES_NEON)
+#include <arm_neon.h>
+#endif
+
+// @safe
+namespace rusty {
+
+// Returned by the search functions when nothing matches
+constexpr size_t BYTES_NPOS = static_cast<size_t>(-1);
+
+namespace detail {
+
+#if !defined(RUSTY_BYTES_SWAR)
+// A chunk of haystack bytes compared lane-wise
+// Masks carry STRIDE bits per byte, lowest address first
+struct ByteChunk {
+#if defined(RUSTY_BYTES_AVX2)
+    static constexpr size_t WIDTH = 32;
+    static constexpr unsigned STRIDE = 1;
+    using Mask = uint32_t;
+    __m256i vec;
+
+    static ByteChunk load(const char* p) {
+        return {_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))};
+    }
+    static ByteChunk splat(char c) { return {_mm256_set1_epi8(c)}; }
+
+    Mask eq(ByteChunk other) const {
+        return static_cast<Mask>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(vec, other.vec)));
+    }
+
+    // Bytes with the high bit set (non-ASCII)
+    Mask high_bits() const { return static_cast<Mask>(_mm256_movemask_epi8(vec)); }
+#elif defined(RUSTY_BYTES_SSE2)
+    static constexpr size_t WIDTH = 16;
+    static constexpr unsigned STRIDE = 1;
+    using Mask = uint32_t;
+    __m128i vec;
+
+    static ByteChunk load(const char* p) {
+        return {_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))};
+    }
+    static ByteChunk splat(char c) { return {_mm_set1_epi8(c)}; }
+
+    Mask eq(ByteChunk other) const {
+        return static_cast<Mask>(_mm_movemask_epi8(_mm_cmpeq_epi8(vec, other.vec)));
+    }
+
+    Mask high_bits() const { return static_cast<Mask>(_mm_movemask_epi8(vec)); }
+#else
+    static constexpr size_t WIDTH = 16;
+    static constexpr unsigned STRIDE = 4;
+    using Mask = uint64_t;
+    uint8x16_t vec;
+
+    static ByteChunk load(const char* p) {
+        return {vld1q_u8(reinterpret_cast<const uint8_t*>(p))};
+    }
+    static ByteChunk splat(char c) { return {vdupq_n_u8(static_cast<uint8_t>(c))}; }
+
+    // Narrow each 0x00/0xFF byte lane to a nibble
+    static Mask to_mask(uint8x16_t lanes) {
+        uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(lanes), 4);
+        return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+    }
+
+    Mask eq(ByteChunk other) const { return to_mask(vceqq_u8(vec, other.vec)); }
+
+    Mask high_bits() const {
+        return to_mask(vcltq_s8(vreinterpretq_s8_u8(vec), vdupq_n_s8(0)));
+    }
+#endif
+
+    static size_t first(Mask m) { return static_cast<size_t>(__builtin_ctzll(m)) / STRIDE; }
+
+    static Mask clear(Mask m, size_t offset) {
+        return m & ~(static_cast<Mask>((1u << STRIDE) - 1) << (offset * STRIDE));
+    }
+};
+#else
+constexpr uint64_t BYTES_LSB = 0x0101010101010101ULL;
+constexpr uint64_t BYTES_MSB = 0x8080808080808080ULL;
+
+inline uint64_t load_word(const char* p) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+// Nonzero when some byte of word is zero (may flag bytes above a true zero)
+inline uint64_t word_has_zero(uint64_t word) {
+    return (word - BYTES_LSB) & ~word & BYTES_MSB;
+}
+#endif
+
+} // namespace detail
+
+// Offset of the first byte equal to c, or BYTES_NPOS
+inline size_t find_byte(const char* hay, size_t len, char c) {
+    size_t i = 0;
+#if !defined(RUSTY_BYTES_SWAR)
+    using Chunk = detail::ByteChunk;
+    if (len >= Chunk::WIDTH) {
+        Chunk needle = Chunk::splat(c);
+        for (; i + Chunk::WIDTH <= len; i += Chunk::WIDTH) {
+            Chunk::Mask m = Chunk::load(hay + i).eq(needle);
+            if (m) return i + Chunk::first(m);
+        }
+        // Overlapping last chunk; its already-scanned prefix cannot match
+        if (i < len) {
+            size_t tail = len - Chunk::WIDTH;
+            Chunk::Mask m = Chunk::load(hay + tail).eq(needle);
+            return m ? tail + Chunk::first(m) : BYTES_NPOS;
+        }
+        return BYTES_NPOS;
+    }
+#else
+    uint64_t pattern = detail::BYTES_LSB * static_cast<unsigned char>(c);
+    for (; i + 8 <= len; i += 8) {
+        if (detail::word_has_zero(detail::load_word(hay + i) ^ pattern)) break;
+    }
+#endif
+    for (; i < len; i++) {
+        if (hay[i] == c) return i;
+    }
+    return BYTES_NPOS;
+}
+
+// Offset of the first occurrence of needle in hay, or BYTES_NPOS
+// An empty needle matches at offset 0
+inline size_t find_bytes(const char* hay, size_t len, const char* needle, size_t needle_len) {
+    if (needle_len == 0) return 0;
+    if (needle_len > len) return BYTES_NPOS;
+    if (needle_len == 1) return find_byte(hay, len, needle[0]);
+
+    const char first = needle[0];
+    const char last = needle[needle_len - 1];
+    const size_t starts = len - needle_len + 1;
+    size_t i = 0;
+#if !defined(RUSTY_BYTES_SWAR)
+    using Chunk = detail::ByteChunk;
+    if (starts >= Chunk::WIDTH) {
+        Chunk first_v = Chunk::splat(first);
+        Chunk last_v = Chunk::splat(last);
+        for (; i + Chunk::WIDTH <= starts; i += Chunk::WIDTH) {
+            Chunk::Mask candidates = Chunk::load(hay + i).eq(first_v) &
+                                     Chunk::load(hay + i + needle_len - 1).eq(last_v);
+            while (candidates) {
+                size_t offset = Chunk::first(candidates);
+                if (std::memcmp(hay + i + offset + 1, needle + 1, needle_len - 2) == 0) {
+                    return i + offset;
+                }
+                candidates = Chunk::clear(candidates, offset);
+            }
+        }
+    }
+#endif
+    while (i < starts) {
+        size_t at = find_byte(hay + i, starts - i, first);
+        if (at == BYTES_NPOS) return BYTES_NPOS;
+        i += at;
+        if (hay[i + needle_len - 1] == last &&
+            std::memcmp(hay + i + 1, needle + 1, needle_len - 2) == 0) {
+            return i;
+        }
+        i++;
+    }
+    return BYTES_NPOS;
+}
+
+// Length of the leading run of ASCII bytes (all of len when none is >= 0x80)
+inline size_t ascii_prefix_len(const char* bytes, size_t len) {
+    size_t i = 0;
+#if !defined(RUSTY_BYTES_SWAR)
+    using Chunk = detail::ByteChunk;
+    for (; i + Chunk::WIDTH <= len; i += Chunk::WIDTH) {
+        Chunk::Mask m = Chunk::load(bytes + i).high_bits();
+        if (m) return i + Chunk::first(m);
+    }
+#else
+    for (; i + 8 <= len; i += 8) {
+        if (detail::load_word(bytes + i) & detail::BYTES_MSB) break;
+    }
+#endif
+    while (i < len && static_cast<unsigned char>(bytes[i]) < 0x80) {
+        i++;
+    }
+    return i;
+}
+
+} // namespace rusty
+
+#endif // RUSTY_MEMCHR_HPP
@@ -0,0 +1,222 @@
+#ifndef RUSTY_MMAP_HPP
+#define RUSTY_MMAP_HPP
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include "alloc.hpp"
+#include "result.hpp"
+#include "slice.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define RUSTY_POSIX 1
+#endif
+
+// MappedFile - A whole file mapped read-only into memory
+// Modeled on Rust's memmap2::Mmap
+//
+//   auto file = rusty::MappedFile::open("routes.bin");
+//   if (file.is_err()) { ... file.unwrap_err().message() ... }
+//   Slice<uint8_t> bytes = file.unwrap().as_slice();
+//
+// Opening is O(1): pages are read from the page cache on first touch, and
+// processes mapping the same file share those pages. The mapping is
+// private and read-only; the file should not be truncated while mapped.
+// Mappings are page aligned, so they satisfy any alignment a file format
+// needs. Where mmap is unavailable the file is read into an aligned heap
+// buffer instead.
+
+// @safe
+namespace rusty {
+
+// An operating system error, as an errno value
+struct IoError {
+    int code;
+
+    // @lifetime: static
+    const char* message() const { return std::strerror(code); }
+
+    bool operator==(const IoError& other) const { return code == other.code; }
+    bool operator!=(const IoError& other) const { return code != other.code; }
+};
+
+class MappedFile {
+private:
+    const uint8_t* data_;
+    size_t len_;
+
+    MappedFile(const uint8_t* data, size_t len) : data_(data), len_(len) {}
+
+    static Result<MappedFile, IoError> fail(int code) {
+        IoError err = {code};
+        return Result<MappedFile, IoError>::Err(err);
+    }
+
+    void release() {
+        if (!data_) return;
+#ifdef RUSTY_POSIX
+        munmap(const_cast<uint8_t*>(data_), len_);
+#else
+        Global().deallocate(const_cast<uint8_t*>(data_), len_, 16);
+#endif
+        data_ = nullptr;
+        len_ = 0;
+    }
+
+public:
+    // How pages will be read, for the kernel's read-ahead
+    enum class Advice { Normal, Sequential, Random, WillNeed };
+
+    MappedFile() : data_(nullptr), len_(0) {}
+
+    MappedFile(MappedFile&& other) noexcept : data_(other.data_), len_(other.len_) {
+        other.data_ = nullptr;
+        other.len_ = 0;
+    }
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            release();
+            data_ = other.data_;
+            len_ = other.len_;
+            other.data_ = nullptr;
+            other.len_ = 0;
+        }
+        return *this;
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() { release(); }
+
+    // Map the whole file at path. An empty file maps to an empty slice.
+    // @lifetime: owned
+    static Result<MappedFile, IoError> open(const char* path) {
+#ifdef RUSTY_POSIX
+        int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return fail(errno);
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            int code = errno;
+            ::close(fd);
+            return fail(code);
+        }
+        if (uint64_t(st.st_size) > SIZE_MAX) {
+            ::close(fd);
+            return fail(EFBIG);
+        }
+        size_t len = static_cast<size_t>(st.st_size);
+        if (len == 0) {
+            ::close(fd);
+            return Result<MappedFile, IoError>::Ok(MappedFile());
+        }
+        void* p = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        int code = errno;
+        ::close(fd);  // The mapping keeps the file alive
+        if (p == MAP_FAILED) return fail(code);
+        return Result<MappedFile, IoError>::Ok(MappedFile(static_cast<const uint8_t*>(p), len));
+#else
+        std::FILE* f = std::fopen(path, "rb");
+        if (!f) return fail(errno);
+        if (std::fseek(f, 0, SEEK_END) != 0) {
+            std::fclose(f);
+            return fail(EIO);
+        }
+        long end = std::ftell(f);
+        std::rewind(f);
+        if (end <= 0) {
+            std::fclose(f);
+            if (end < 0) return fail(EIO);
+            return Result<MappedFile, IoError>::Ok(MappedFile());
+        }
+        size_t len = static_cast<size_t>(end);
+        uint8_t* buf = static_cast<uint8_t*>(Global().allocate(len, 16));
+        if (!buf) {
+            std::fclose(f);
+            return fail(ENOMEM);
+        }
+        size_t got = std::fread(buf, 1, len, f);
+        std::fclose(f);
+        if (got != len) {
+            Global().deallocate(buf, len, 16);
+            return fail(EIO);
+        }
+        return Result<MappedFile, IoError>::Ok(MappedFile(buf, len));
+#endif
+    }
+
+    size_t len() const { return len_; }
+    bool is_empty() const { return len_ == 0; }
+
+    // @lifetime: (&'a) -> &'a
+    const uint8_t* as_ptr() const { return data_; }
+
+    // @lifetime: (&'a) -> &'a
+    Slice<uint8_t> as_slice() const { return Slice<uint8_t>(data_, len_); }
+
+    // A hint only; errors are ignored
+    void advise(Advice advice) const {
+#if defined(RUSTY_POSIX) && defined(POSIX_MADV_NORMAL)
+        if (!data_) return;
+        int flag = POSIX_MADV_NORMAL;
+        switch (advice) {
+        case Advice::Normal: flag = POSIX_MADV_NORMAL; break;
+        case Advice::Sequential: flag = POSIX_MADV_SEQUENTIAL; break;
+        case Advice::Random: flag = POSIX_MADV_RANDOM; break;
+        case Advice::WillNeed: flag = POSIX_MADV_WILLNEED; break;
+        }
+        posix_madvise(const_cast<uint8_t*>(data_), len_, flag);
+#else
+        (void)advice;
+#endif
+    }
+};
+
+// Write bytes to path, replacing the file. The data goes to a temporary
+// file beside it that is renamed over path, so readers that already
+// mapped the old file keep seeing it intact.
+inline Result<void, IoError> write_file_atomic(const char* path, Slice<uint8_t> bytes) {
+    typedef Result<void, IoError> R;
+    size_t path_len = std::strlen(path);
+    const char suffix[] = ".tmp";
+    char* tmp = static_cast<char*>(Global().allocate(path_len + sizeof(suffix), 1));
+    if (!tmp) {
+        IoError err = {ENOMEM};
+        return R::Err(err);
+    }
+    std::memcpy(tmp, path, path_len);
+    std::memcpy(tmp + path_len, suffix, sizeof(suffix));
+
+    int code = 0;
+    std::FILE* f = std::fopen(tmp, "wb");
+    if (!f) {
+        code = errno;
+    } else {
+        if (bytes.len() && std::fwrite(bytes.as_ptr(), 1, bytes.len(), f) != bytes.len()) code = errno ? errno : EIO;
+        if (std::fflush(f) != 0 && !code) code = errno ? errno : EIO;
+#ifdef RUSTY_POSIX
+        if (!code && fsync(fileno(f)) != 0) code = errno;
+#endif
+        if (std::fclose(f) != 0 && !code) code = errno ? errno : EIO;
+        if (!code && std::rename(tmp, path) != 0) code = errno;
+        if (code) std::remove(tmp);
+    }
+    Global().deallocate(tmp, path_len + sizeof(suffix), 1);
+    if (code) {
+        IoError err = {code};
+        return R::Err(err);
+    }
+    return R::Ok();
+}
+
+} // namespace rusty
+
+#endif // RUSTY_MMAP_HPP
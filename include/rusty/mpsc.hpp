@@ -0,0 +1,624 @@
+#ifndef RUSTY_MPSC_HPP
+#define RUSTY_MPSC_HPP
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>  // for size_t
+#include <cstdint>
+#include <new>
+#include <type_traits>  // for std::aligned_storage
+#include <utility>  // for std::move, std::pair
+#include "alloc.hpp"
+#include "niche.hpp"
+#include "result.hpp"
+#include "sync.hpp"
+#include "vec.hpp"
+
+// mpsc - Multi-producer, single-consumer channels
+// Equivalent to Rust's std::sync::mpsc
+//
+//   auto ch = rusty::mpsc::channel<Box<Message>>();        // unbounded
+//   auto ch = rusty::mpsc::sync_channel<Box<Message>>(1024); // bounded
+//   ch.first.send(std::move(msg));
+//   auto next = ch.second.recv();
+//
+// Guarantees:
+// - Sender and Receiver are move-only handles; Sender::clone() adds a
+//   producer, and the channel is freed when the last handle drops
+// - send/recv never take a lock: the bounded channel is a ring of
+//   sequence-numbered slots with head and tail on separate cache lines,
+//   the unbounded one a linked list of fixed-size blocks of slots
+// - recv() on an empty channel, and send() on a full bounded one, spin
+//   briefly and then park; a waiting side is only woken if it is parked
+// - send_many/recv_many move a batch with a single wake-up
+// - Dropping every Sender disconnects the channel: recv() drains what is
+//   left and then returns Err. Dropping the Receiver makes send() fail
+//   and hand the value back in SendError
+//
+// The bounded capacity is rounded up to a power of two; unlike Rust, a
+// capacity of zero is treated as one rather than as a rendezvous channel.
+
+// @safe
+namespace rusty {
+namespace mpsc {
+
+// The value that could not be sent because the Receiver is gone
+template<typename T>
+struct SendError {
+    T value;
+};
+
+// recv() on an empty channel with no Senders left
+struct RecvError {};
+
+enum class TryRecvError {
+    Empty,
+    Disconnected,
+};
+
+namespace detail {
+
+using rusty::detail::cpu_relax;
+using rusty::detail::park;
+using rusty::detail::unpark_all;
+using rusty::detail::SPIN_LIMIT;
+
+// The queues and the channel are cache-line aligned, which plain new
+// only honours from C++17
+template<typename U, typename... Args>
+U* new_aligned(Args&&... args) {
+    Global alloc;
+    void* p = alloc_or_throw(alloc, sizeof(U), alignof(U));
+    try {
+        return new (p) U(std::forward<Args>(args)...);
+    } catch (...) {
+        alloc.deallocate(p, sizeof(U), alignof(U));
+        throw;
+    }
+}
+
+template<typename U>
+void delete_aligned(U* p) {
+    if (!p) return;
+    p->~U();
+    Global alloc;
+    alloc.deallocate(p, sizeof(U), alignof(U));
+}
+
+// Bounded ring (Vyukov): slot i is free for enqueue position p when its
+// sequence is p, and holds the value for dequeue position p when it is p + 1
+template<typename T>
+class Ring {
+private:
+    struct Slot {
+        std::atomic<size_t> seq;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+        T* value() { return reinterpret_cast<T*>(&storage); }
+    };
+
+    alignas(64) std::atomic<size_t> tail_;  // next enqueue position
+    alignas(64) size_t head_;               // next dequeue position (receiver only)
+    Slot* slots_;
+    size_t mask_;
+
+    static size_t round_up(size_t n) {
+        size_t cap = 1;
+        while (cap < n) cap <<= 1;
+        return cap;
+    }
+
+public:
+    explicit Ring(size_t capacity) : tail_(0), head_(0), slots_(nullptr), mask_(0) {
+        size_t cap = round_up(capacity);
+        slots_ = new Slot[cap];
+        mask_ = cap - 1;
+        for (size_t i = 0; i < cap; i++) {
+            slots_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    Ring(const Ring&) = delete;
+    Ring& operator=(const Ring&) = delete;
+
+    ~Ring() {
+        while (pop([](T&&) {})) {}
+        delete[] slots_;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+    // Moves from value only on success; false when full
+    bool push(T& value) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[pos & mask_];
+            size_t seq = slot.seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    new (&slot.storage) T(std::move(value));
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool full() const {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        return slots_[pos & mask_].seq.load(std::memory_order_acquire) != pos;
+    }
+
+    bool can_pop() const {
+        return slots_[head_ & mask_].seq.load(std::memory_order_acquire) == head_ + 1;
+    }
+
+    // Hand the oldest value to sink; false when empty
+    template<typename Sink>
+    bool pop(Sink&& sink) {
+        Slot& slot = slots_[head_ & mask_];
+        if (slot.seq.load(std::memory_order_acquire) != head_ + 1) return false;
+        T* value = slot.value();
+        sink(std::move(*value));
+        value->~T();
+        slot.seq.store(head_ + mask_ + 1, std::memory_order_release);
+        head_++;
+        return true;
+    }
+};
+
+// Unbounded list of blocks. Producers claim a position by CAS on the tail
+// index; the producer taking a block's last slot links the next block and
+// bumps the index past the unused offset BLOCK_CAP. The single consumer
+// frees each block once it has read every slot in it, so no producer can
+// still be using it.
+template<typename T>
+class List {
+private:
+    static constexpr size_t LAP = 32;
+    static constexpr size_t BLOCK_CAP = LAP - 1;
+
+    struct Slot {
+        std::atomic<bool> ready;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+        T* value() { return reinterpret_cast<T*>(&storage); }
+    };
+
+    struct Block {
+        std::atomic<Block*> next;
+        Slot slots[BLOCK_CAP];
+
+        Block() : next(nullptr) {
+            for (size_t i = 0; i < BLOCK_CAP; i++) {
+                slots[i].ready.store(false, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    alignas(64) std::atomic<size_t> tail_index_;
+    std::atomic<Block*> tail_block_;
+    alignas(64) size_t head_index_;  // receiver only
+    Block* head_block_;
+
+public:
+    List() : tail_index_(0), tail_block_(nullptr), head_index_(0), head_block_(new Block()) {
+        tail_block_.store(head_block_, std::memory_order_relaxed);
+    }
+
+    List(const List&) = delete;
+    List& operator=(const List&) = delete;
+
+    ~List() {
+        while (pop([](T&&) {})) {}
+        while (head_block_) {
+            Block* next = head_block_->next.load(std::memory_order_relaxed);
+            delete head_block_;
+            head_block_ = next;
+        }
+    }
+
+    void push(T& value) {
+        Block* next_block = nullptr;
+        size_t tail = tail_index_.load(std::memory_order_acquire);
+        Block* block = tail_block_.load(std::memory_order_acquire);
+        for (;;) {
+            size_t offset = tail % LAP;
+            if (offset == BLOCK_CAP) {
+                // Another producer is linking the next block
+                cpu_relax();
+                tail = tail_index_.load(std::memory_order_acquire);
+                block = tail_block_.load(std::memory_order_acquire);
+                continue;
+            }
+            // Allocate before claiming the last slot, to keep the wait short
+            if (offset + 1 == BLOCK_CAP && !next_block) next_block = new Block();
+
+            if (tail_index_.compare_exchange_weak(tail, tail + 1, std::memory_order_seq_cst,
+                                                  std::memory_order_acquire)) {
+                if (offset + 1 == BLOCK_CAP) {
+                    tail_block_.store(next_block, std::memory_order_release);
+                    tail_index_.fetch_add(1, std::memory_order_release);
+                    block->next.store(next_block, std::memory_order_release);
+                    next_block = nullptr;
+                }
+                Slot& slot = block->slots[offset];
+                new (&slot.storage) T(std::move(value));
+                slot.ready.store(true, std::memory_order_release);
+                break;
+            }
+            block = tail_block_.load(std::memory_order_acquire);
+        }
+        delete next_block;
+    }
+
+    bool can_pop() const {
+        return head_block_->slots[head_index_ % LAP].ready.load(std::memory_order_acquire);
+    }
+
+    template<typename Sink>
+    bool pop(Sink&& sink) {
+        size_t offset = head_index_ % LAP;
+        Slot& slot = head_block_->slots[offset];
+        if (!slot.ready.load(std::memory_order_acquire)) return false;
+        T* value = slot.value();
+        sink(std::move(*value));
+        value->~T();
+        if (offset + 1 == BLOCK_CAP) {
+            // The last slot is written after the next block is linked
+            Block* next = head_block_->next.load(std::memory_order_acquire);
+            delete head_block_;
+            head_block_ = next;
+            head_index_ += 2;
+        } else {
+            head_index_++;
+        }
+        return true;
+    }
+};
+
+// Park until ready() holds. A notifier changes the condition, then calls
+// notify(); the waiting count keeps notify() free when nobody is parked.
+struct WaitQueue {
+    std::atomic<uint32_t> epoch;
+    std::atomic<uint32_t> waiting;
+
+    WaitQueue() : epoch(0), waiting(0) {}
+
+    template<typename Ready>
+    void wait_until(Ready ready) {
+        for (int spin = 0; spin < SPIN_LIMIT; spin++) {
+            if (ready()) return;
+            cpu_relax();
+        }
+        waiting.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (;;) {
+            uint32_t seen = epoch.load(std::memory_order_seq_cst);
+            if (ready()) break;
+            park(epoch, seen);
+        }
+        waiting.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load(std::memory_order_relaxed) != 0) {
+            notify_always();
+        }
+    }
+
+    void notify_always() {
+        epoch.fetch_add(1, std::memory_order_seq_cst);
+        unpark_all(&epoch);
+    }
+};
+
+template<typename T>
+class Channel {
+private:
+    std::atomic<size_t> handles_;  // Senders + Receiver, for freeing
+    std::atomic<size_t> senders_;
+    std::atomic<bool> disconnected_;     // no Senders left
+    std::atomic<bool> receiver_alive_;
+    alignas(64) WaitQueue recv_wait_;
+    alignas(64) WaitQueue send_wait_;
+    Ring<T>* ring_;  // bounded flavor
+    List<T>* list_;  // unbounded flavor
+
+    bool can_pop() const {
+        return ring_ ? ring_->can_pop() : list_->can_pop();
+    }
+
+    template<typename Sink>
+    bool pop(Sink&& sink) {
+        if (ring_) {
+            return ring_->pop(sink);
+        }
+        return list_->pop(sink);
+    }
+
+    bool try_push(T& value) {
+        if (ring_) return ring_->push(value);
+        list_->push(value);
+        return true;
+    }
+
+public:
+    // capacity 0 selects the unbounded flavor
+    explicit Channel(size_t capacity)
+        : handles_(2), senders_(1), disconnected_(false), receiver_alive_(true),
+          ring_(capacity ? new_aligned<Ring<T>>(capacity) : nullptr),
+          list_(capacity ? nullptr : new_aligned<List<T>>()) {}
+
+    Channel(const Channel&) = delete;
+    Channel& operator=(const Channel&) = delete;
+
+    ~Channel() {
+        delete_aligned(ring_);
+        delete_aligned(list_);
+    }
+
+    void release_handle() {
+        if (handles_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete_aligned(this);
+        }
+    }
+
+    void add_sender() {
+        handles_.fetch_add(1, std::memory_order_relaxed);
+        senders_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void drop_sender() {
+        if (senders_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            disconnected_.store(true, std::memory_order_seq_cst);
+            recv_wait_.notify_always();
+        }
+        release_handle();
+    }
+
+    void drop_receiver() {
+        receiver_alive_.store(false, std::memory_order_seq_cst);
+        send_wait_.notify_always();
+        release_handle();
+    }
+
+    // Move items[0..count) in order; fewer are sent only if the Receiver is
+    // gone. Blocks while a bounded channel is full.
+    size_t send_batch(T* items, size_t count) {
+        size_t sent = 0;
+        while (sent < count) {
+            if (!receiver_alive_.load(std::memory_order_acquire)) break;
+            if (try_push(items[sent])) {
+                sent++;
+                continue;
+            }
+            // Full: let the receiver see what we have sent so far
+            recv_wait_.notify();
+            send_wait_.wait_until([this]() {
+                return !ring_->full() || !receiver_alive_.load(std::memory_order_acquire);
+            });
+        }
+        if (sent > 0) recv_wait_.notify();
+        return sent;
+    }
+
+    // Hand up to max values to sink, waiting for the first unless !block.
+    // Returns the number handed over; 0 means empty (and, when blocking,
+    // disconnected).
+    template<typename Sink>
+    size_t recv_batch(Sink&& sink, size_t max, bool block) {
+        size_t received = 0;
+        for (;;) {
+            while (received < max && pop(sink)) received++;
+            if (received > 0 || !block) break;
+            if (disconnected_.load(std::memory_order_acquire)) {
+                // Values sent before the last Sender dropped are still ours
+                while (received < max && pop(sink)) received++;
+                break;
+            }
+            recv_wait_.wait_until([this]() {
+                return can_pop() || disconnected_.load(std::memory_order_acquire);
+            });
+        }
+        if (received > 0 && ring_) send_wait_.notify();
+        return received;
+    }
+
+    bool is_disconnected() const {
+        return disconnected_.load(std::memory_order_acquire);
+    }
+
+    bool receiver_alive() const {
+        return receiver_alive_.load(std::memory_order_acquire);
+    }
+};
+
+} // namespace detail
+
+template<typename T>
+class Receiver;
+
+template<typename T>
+class Sender;
+
+template<typename T>
+std::pair<Sender<T>, Receiver<T>> channel();
+
+template<typename T>
+std::pair<Sender<T>, Receiver<T>> sync_channel(size_t capacity);
+
+template<typename T>
+class Sender {
+private:
+    friend std::pair<Sender<T>, Receiver<T>> channel<T>();
+    friend std::pair<Sender<T>, Receiver<T>> sync_channel<T>(size_t);
+
+    detail::Channel<T>* chan_;
+
+    explicit Sender(detail::Channel<T>* chan) : chan_(chan) {}
+
+public:
+    // No copy constructor - use clone() to add a producer
+    Sender(const Sender&) = delete;
+    Sender& operator=(const Sender&) = delete;
+
+    // @lifetime: owned
+    Sender(Sender&& other) noexcept : chan_(other.chan_) {
+        other.chan_ = nullptr;
+    }
+
+    // @lifetime: owned
+    Sender& operator=(Sender&& other) noexcept {
+        if (this != &other) {
+            if (chan_) chan_->drop_sender();
+            chan_ = other.chan_;
+            other.chan_ = nullptr;
+        }
+        return *this;
+    }
+
+    ~Sender() {
+        if (chan_) chan_->drop_sender();
+    }
+
+    // Another handle to the same channel
+    // @lifetime: owned
+    Sender clone() const {
+        assert(chan_ != nullptr);
+        chan_->add_sender();
+        return Sender(chan_);
+    }
+
+    // Blocks while a bounded channel is full
+    Result<void, SendError<T>> send(T value) {
+        assert(chan_ != nullptr);
+        if (chan_->send_batch(&value, 1) == 1) {
+            return Result<void, SendError<T>>::Ok();
+        }
+        return Result<void, SendError<T>>::Err(SendError<T>{std::move(value)});
+    }
+
+    // Move count values out of items, in order, with one wake-up; sent
+    // items are left moved-from. Returns how many were sent: all of them
+    // unless the Receiver is gone.
+    size_t send_many(T* items, size_t count) {
+        assert(chan_ != nullptr);
+        return chan_->send_batch(items, count);
+    }
+
+    // True once the Receiver has been dropped
+    bool is_closed() const {
+        return chan_ == nullptr || !chan_->receiver_alive();
+    }
+};
+
+template<typename T>
+class Receiver {
+private:
+    friend std::pair<Sender<T>, Receiver<T>> channel<T>();
+    friend std::pair<Sender<T>, Receiver<T>> sync_channel<T>(size_t);
+
+    detail::Channel<T>* chan_;
+
+    explicit Receiver(detail::Channel<T>* chan) : chan_(chan) {}
+
+public:
+    // No copy constructor - a channel has exactly one consumer
+    Receiver(const Receiver&) = delete;
+    Receiver& operator=(const Receiver&) = delete;
+
+    // @lifetime: owned
+    Receiver(Receiver&& other) noexcept : chan_(other.chan_) {
+        other.chan_ = nullptr;
+    }
+
+    // @lifetime: owned
+    Receiver& operator=(Receiver&& other) noexcept {
+        if (this != &other) {
+            if (chan_) chan_->drop_receiver();
+            chan_ = other.chan_;
+            other.chan_ = nullptr;
+        }
+        return *this;
+    }
+
+    ~Receiver() {
+        if (chan_) chan_->drop_receiver();
+    }
+
+    // Block until a value arrives; Err once empty with no Senders left
+    // @lifetime: owned
+    Result<T, RecvError> recv() {
+        assert(chan_ != nullptr);
+        Result<T, RecvError> result;
+        chan_->recv_batch([&result](T&& value) {
+            result = Result<T, RecvError>::Ok(std::move(value));
+        }, 1, true);
+        return result;
+    }
+
+    // @lifetime: owned
+    Result<T, TryRecvError> try_recv() {
+        assert(chan_ != nullptr);
+        Result<T, TryRecvError> result = Result<T, TryRecvError>::Err(TryRecvError::Empty);
+        bool disconnected = chan_->is_disconnected();
+        size_t got = chan_->recv_batch([&result](T&& value) {
+            result = Result<T, TryRecvError>::Ok(std::move(value));
+        }, 1, false);
+        // Checked before popping, so nothing sent earlier can be missed
+        if (got == 0 && disconnected) {
+            result = Result<T, TryRecvError>::Err(TryRecvError::Disconnected);
+        }
+        return result;
+    }
+
+    // Block until at least one value arrives, then append up to max
+    // values to out. Returns the number appended; 0 means disconnected.
+    size_t recv_many(Vec<T>& out, size_t max) {
+        assert(chan_ != nullptr);
+        return chan_->recv_batch([&out](T&& value) { out.push(std::move(value)); }, max, true);
+    }
+};
+
+// Unbounded channel: send() never blocks
+// @lifetime: owned
+template<typename T>
+std::pair<Sender<T>, Receiver<T>> channel() {
+    detail::Channel<T>* chan = detail::new_aligned<detail::Channel<T>>(0);
+    return std::pair<Sender<T>, Receiver<T>>(Sender<T>(chan), Receiver<T>(chan));
+}
+
+// Bounded channel: send() blocks while capacity values are queued
+// @lifetime: owned
+template<typename T>
+std::pair<Sender<T>, Receiver<T>> sync_channel(size_t capacity) {
+    detail::Channel<T>* chan = detail::new_aligned<detail::Channel<T>>(capacity ? capacity : 1);
+    return std::pair<Sender<T>, Receiver<T>>(Sender<T>(chan), Receiver<T>(chan));
+}
+
+} // namespace mpsc
+
+// Handles hold one pointer, null only when moved from
+template<typename T>
+struct niche_traits<mpsc::Sender<T>> : null_pointer_niche {};
+
+template<typename T>
+struct niche_traits<mpsc::Receiver<T>> : null_pointer_niche {};
+
+// Senders share the channel; there is only ever one receiving thread
+template<typename T>
+struct is_sync<mpsc::Sender<T>> : is_send<T> {};
+
+template<typename T>
+struct is_sync<mpsc::Receiver<T>> : std::false_type {};
+
+} // namespace rusty
+
+#endif // RUSTY_MPSC_HPP
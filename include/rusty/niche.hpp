@@ -0,0 +1,80 @@
+#ifndef RUSTY_NICHE_HPP
+#define RUSTY_NICHE_HPP
+
+#include <cstring>  // for memcpy
+#include <new>
+#include <type_traits>
+#include <utility>
+#if __cplusplus >= 202002L
+#include <memory>   // for construct_at
+#endif
+
+// niche_traits<T> - Describes a bit pattern that no live T ever holds,
+// so Option<T> can store None in it instead of in a separate flag.
+//
+// Rust does this for references, Box, Arc, Rc and NonNull: Option of any
+// of them is one pointer wide. Here a type opts in by specializing
+// niche_traits with two static functions working on raw storage:
+//   static void set_none(void* storage);        // write the niche pattern
+//   static bool is_none(const void* storage);   // does storage hold it?
+// plus `static constexpr bool available = true`.
+//
+// For handles that hold a single pointer and are empty when it is null,
+// derive from null_pointer_niche:
+//   template<typename T> struct niche_traits<Box<T>> : null_pointer_niche {};
+//
+// Consequence: for such types, an empty handle is the None pattern, so
+// Some(Box<T>()) is None, as in Rust where these types are never null.
+// Raw pointers have no niche: null is a valid value, so Some(nullptr)
+// must stay Some (Rust's Option<*const T> is not niche-optimized either).
+
+// RUSTY_CONSTEXPR20 - constexpr from C++20 on, where constant expressions
+// may construct and destroy union members: Option, Result and ArrayVec of
+// literal types can then be built and used at compile time
+#if __cplusplus >= 202002L
+#define RUSTY_CONSTEXPR20 constexpr
+#else
+#define RUSTY_CONSTEXPR20
+#endif
+
+// @safe
+namespace rusty {
+
+namespace detail {
+
+// Placement new, in the form constant expressions accept from C++20 on
+template<typename T, typename... Args>
+RUSTY_CONSTEXPR20 void construct_in_place(T* p, Args&&... args) {
+#if __cplusplus >= 202002L
+    std::construct_at(p, std::forward<Args>(args)...);
+#else
+    new (static_cast<void*>(p)) T(std::forward<Args>(args)...);
+#endif
+}
+
+} // namespace detail
+
+template<typename T>
+struct niche_traits {
+    static constexpr bool available = false;
+};
+
+// The None pattern is a null pointer in the first pointer-sized bytes
+struct null_pointer_niche {
+    static constexpr bool available = true;
+
+    static void set_none(void* storage) {
+        void* null = nullptr;
+        std::memcpy(storage, &null, sizeof(null));
+    }
+
+    static bool is_none(const void* storage) {
+        void* ptr;
+        std::memcpy(&ptr, storage, sizeof(ptr));
+        return ptr == nullptr;
+    }
+};
+
+} // namespace rusty
+
+#endif // RUSTY_NICHE_HPP
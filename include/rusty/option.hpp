@@ -1,8 +1,11 @@
 #ifndef RUSTY_OPTION_HPP
 #define RUSTY_OPTION_HPP
 
+#include <new>
 #include <utility>
 #include <stdexcept>
+#include <type_traits>
+#include "niche.hpp"
 
 // Option<T> - Represents an optional value
 // Equivalent to Rust's Option<T>
@@ -11,6 +14,12 @@
 // - Type-safe null handling
 // - No null pointer dereferencing
 // - Explicit handling of absence
+// - Types with a niche (see niche.hpp) store None in it, so Option of a
+//   Box, Arc or Rc is no bigger than the pointer itself; Option of a raw
+//   pointer keeps a flag, since Some(nullptr) is a value
+// - Option<T&> is a nullable borrow, one pointer wide
+// - From C++20 on, Option of a literal type works in constant expressions
+//   (Option of a niche type does not)
 
 // @safe
 namespace rusty {
@@ -23,97 +32,142 @@ inline constexpr None_t None{};
 static const None_t None{};
 #endif
 
-template<typename T>
-class Option {
-private:
+namespace detail {
+
+// Default layout: a flag beside the value
+template<typename T, bool Niche = niche_traits<T>::available>
+struct OptionStorage {
     bool has_value;
     union {
         T value;
         char dummy;  // For when there's no value
     };
-    
+
+    RUSTY_CONSTEXPR20 OptionStorage() : has_value(false), dummy(0) {}
+    RUSTY_CONSTEXPR20 ~OptionStorage() {}  // Option destroys the value
+
+    RUSTY_CONSTEXPR20 bool is_some() const { return has_value; }
+    RUSTY_CONSTEXPR20 void set_none() { has_value = false; }
+
+    template<typename... Args>
+    RUSTY_CONSTEXPR20 void construct(Args&&... args) {
+        construct_in_place(&value, std::forward<Args>(args)...);
+        has_value = true;
+    }
+};
+
+// Niche layout: None is a bit pattern of T itself, no flag needed
+template<typename T>
+struct OptionStorage<T, true> {
+    union {
+        T value;
+        unsigned char raw[sizeof(T)];
+    };
+
+    OptionStorage() { niche_traits<T>::set_none(raw); }
+    ~OptionStorage() {}
+
+    bool is_some() const { return !niche_traits<T>::is_none(raw); }
+    void set_none() { niche_traits<T>::set_none(raw); }
+
+    template<typename... Args>
+    void construct(Args&&... args) {
+        new (&value) T(std::forward<Args>(args)...);
+    }
+};
+
+} // namespace detail
+
+template<typename T>
+class Option {
+private:
+    detail::OptionStorage<T> storage_;
+
+    // Drop the value, if any, leaving None
+    RUSTY_CONSTEXPR20 void reset() {
+        if (storage_.is_some()) {
+            storage_.value.~T();
+            storage_.set_none();
+        }
+    }
+
+    // Move other's value (if any) into this empty Option, leaving other None
+    RUSTY_CONSTEXPR20 void take_from(Option& other) {
+        if (other.storage_.is_some()) {
+            storage_.construct(std::move(other.storage_.value));
+            other.reset();
+        }
+    }
+
 public:
     // Constructors
-    Option() : has_value(false), dummy(0) {}
+    RUSTY_CONSTEXPR20 Option() {}
     
-    Option(None_t) : has_value(false), dummy(0) {}
+    RUSTY_CONSTEXPR20 Option(None_t) {}
     
-    Option(T val) : has_value(true), value(std::move(val)) {}
+    RUSTY_CONSTEXPR20 Option(T val) {
+        storage_.construct(std::move(val));
+    }
     
     // Copy constructor
-    Option(const Option& other) : has_value(other.has_value) {
-        if (has_value) {
-            new (&value) T(other.value);
+    RUSTY_CONSTEXPR20 Option(const Option& other) {
+        if (other.is_some()) {
+            storage_.construct(other.storage_.value);
         }
     }
     
     // Move constructor
-    Option(Option&& other) noexcept : has_value(other.has_value) {
-        if (has_value) {
-            new (&value) T(std::move(other.value));
-            other.has_value = false;
-        }
+    RUSTY_CONSTEXPR20 Option(Option&& other) noexcept {
+        take_from(other);
     }
     
     // Copy assignment
-    Option& operator=(const Option& other) {
+    RUSTY_CONSTEXPR20 Option& operator=(const Option& other) {
         if (this != &other) {
-            if (has_value) {
-                value.~T();
-            }
-            has_value = other.has_value;
-            if (has_value) {
-                new (&value) T(other.value);
+            reset();
+            if (other.is_some()) {
+                storage_.construct(other.storage_.value);
             }
         }
         return *this;
     }
     
     // Move assignment
-    Option& operator=(Option&& other) noexcept {
+    RUSTY_CONSTEXPR20 Option& operator=(Option&& other) noexcept {
         if (this != &other) {
-            if (has_value) {
-                value.~T();
-            }
-            has_value = other.has_value;
-            if (has_value) {
-                new (&value) T(std::move(other.value));
-                other.has_value = false;
-            }
+            reset();
+            take_from(other);
         }
         return *this;
     }
     
     // Destructor
-    ~Option() {
-        if (has_value) {
-            value.~T();
-        }
+    RUSTY_CONSTEXPR20 ~Option() {
+        reset();
     }
     
     // Check if Option contains a value
-    bool is_some() const { return has_value; }
-    bool is_none() const { return !has_value; }
+    RUSTY_CONSTEXPR20 bool is_some() const { return storage_.is_some(); }
+    RUSTY_CONSTEXPR20 bool is_none() const { return !storage_.is_some(); }
     
     // Explicit bool conversion
-    explicit operator bool() const { return has_value; }
+    RUSTY_CONSTEXPR20 explicit operator bool() const { return is_some(); }
     
     // Unwrap the value (panics if None) - Rust style
     // @lifetime: owned
-    T unwrap() {
-        if (!has_value) {
+    RUSTY_CONSTEXPR20 T unwrap() {
+        if (is_none()) {
             throw std::runtime_error("Called unwrap on None");
         }
-        T result = std::move(value);
-        value.~T();
-        has_value = false;
+        T result = std::move(storage_.value);
+        reset();
         return result;
     }
     
     // Expect with custom message - Rust style
     // @lifetime: owned
-    T expect(const char* msg) {
-        if (!has_value) {
+    RUSTY_CONSTEXPR20 T expect(const char* msg) {
+        if (is_none()) {
             throw std::runtime_error(msg);
         }
         return unwrap();
@@ -121,8 +175,8 @@ public:
     
     // Unwrap with default value
     // @lifetime: owned
-    T unwrap_or(T default_value) {
-        if (has_value) {
+    RUSTY_CONSTEXPR20 T unwrap_or(T default_value) {
+        if (is_some()) {
             return unwrap();
         }
         return default_value;
@@ -130,28 +184,28 @@ public:
     
     // Get reference to value (panics if None)
     // @lifetime: (&'a) -> &'a
-    T& unwrap_ref() {
-        if (!has_value) {
+    RUSTY_CONSTEXPR20 T& unwrap_ref() {
+        if (is_none()) {
             throw std::runtime_error("Called unwrap_ref on None");
         }
-        return value;
+        return storage_.value;
     }
     
     // @lifetime: (&'a) -> &'a
-    const T& unwrap_ref() const {
-        if (!has_value) {
+    RUSTY_CONSTEXPR20 const T& unwrap_ref() const {
+        if (is_none()) {
             throw std::runtime_error("Called unwrap_ref on None");
         }
-        return value;
+        return storage_.value;
     }
     
     // Map function over the value
     template<typename F>
     // @lifetime: owned
-    auto map(F&& f) -> Option<decltype(f(std::declval<T>()))> {
+    RUSTY_CONSTEXPR20 auto map(F&& f) -> Option<decltype(f(std::declval<T>()))> {
         using U = decltype(f(std::declval<T>()));
-        if (has_value) {
-            return Option<U>(f(std::move(value)));
+        if (is_some()) {
+            return Option<U>(f(std::move(storage_.value)));
         }
         return Option<U>(None);
     }
@@ -159,50 +213,142 @@ public:
     // Map function over reference
     template<typename F>
     // @lifetime: (&'a) -> owned
-    auto map_ref(F&& f) const -> Option<decltype(f(std::declval<const T&>()))> {
+    RUSTY_CONSTEXPR20 auto map_ref(F&& f) const -> Option<decltype(f(std::declval<const T&>()))> {
         using U = decltype(f(std::declval<const T&>()));
-        if (has_value) {
-            return Option<U>(f(value));
+        if (is_some()) {
+            return Option<U>(f(storage_.value));
         }
         return Option<U>(None);
     }
     
     // Take the value out, leaving None
     // @lifetime: owned
-    Option<T> take() {
+    RUSTY_CONSTEXPR20 Option<T> take() {
         Option<T> result = std::move(*this);
         *this = Option<T>(None);
         return result;
     }
     
     // Replace the value
-    void replace(T new_value) {
-        if (has_value) {
-            value = std::move(new_value);
-        } else {
-            new (&value) T(std::move(new_value));
-            has_value = true;
+    RUSTY_CONSTEXPR20 void replace(T new_value) {
+        reset();
+        storage_.construct(std::move(new_value));
+    }
+};
+
+// Option<T&> - an optional borrow, equivalent to Rust's Option<&T>
+// Exactly one pointer wide (None is null) and trivially copyable; what map
+// and set lookups return. unwrap() hands back the reference itself.
+template<typename T>
+class Option<T&> {
+private:
+    T* ptr_;
+
+public:
+    RUSTY_CONSTEXPR20 Option() : ptr_(nullptr) {}
+
+    RUSTY_CONSTEXPR20 Option(None_t) : ptr_(nullptr) {}
+
+    // @lifetime: (&'a) -> &'a
+    RUSTY_CONSTEXPR20 Option(T& ref) : ptr_(&ref) {}
+
+    // Option<V&> converts to Option<const V&>
+    template<typename U, typename = typename std::enable_if<
+                             std::is_convertible<U*, T*>::value>::type>
+    RUSTY_CONSTEXPR20 Option(const Option<U&>& other) : ptr_(other.as_ptr()) {}
+
+    // Never borrow a temporary
+    Option(typename std::remove_reference<T>::type&&) = delete;
+
+    RUSTY_CONSTEXPR20 bool is_some() const { return ptr_ != nullptr; }
+    RUSTY_CONSTEXPR20 bool is_none() const { return ptr_ == nullptr; }
+
+    RUSTY_CONSTEXPR20 explicit operator bool() const { return is_some(); }
+
+    // @lifetime: (&'a) -> &'a
+    RUSTY_CONSTEXPR20 T& unwrap() const {
+        if (!ptr_) {
+            throw std::runtime_error("Called unwrap on None");
+        }
+        return *ptr_;
+    }
+
+    // @lifetime: (&'a) -> &'a
+    RUSTY_CONSTEXPR20 T& expect(const char* msg) const {
+        if (!ptr_) {
+            throw std::runtime_error(msg);
+        }
+        return *ptr_;
+    }
+
+    // @lifetime: (&'a, &'a) -> &'a
+    RUSTY_CONSTEXPR20 T& unwrap_or(T& default_value) const {
+        return ptr_ ? *ptr_ : default_value;
+    }
+
+    // @lifetime: (&'a) -> &'a
+    RUSTY_CONSTEXPR20 T& unwrap_ref() const {
+        return unwrap();
+    }
+
+    // The borrowed address, or nullptr for None
+    // @lifetime: (&'a) -> &'a
+    RUSTY_CONSTEXPR20 T* as_ptr() const { return ptr_; }
+
+    template<typename F>
+    // @lifetime: (&'a) -> owned
+    RUSTY_CONSTEXPR20 auto map(F&& f) const -> Option<decltype(f(std::declval<T&>()))> {
+        using U = decltype(f(std::declval<T&>()));
+        if (ptr_) {
+            return Option<U>(f(*ptr_));
+        }
+        return Option<U>(None);
+    }
+
+    template<typename F>
+    // @lifetime: (&'a) -> owned
+    RUSTY_CONSTEXPR20 auto map_ref(F&& f) const -> Option<decltype(f(std::declval<T&>()))> {
+        return map(std::forward<F>(f));
+    }
+
+    // Copy the referenced value out (Rust: Option::cloned)
+    // @lifetime: owned
+    RUSTY_CONSTEXPR20 Option<typename std::remove_const<T>::type> cloned() const {
+        using U = typename std::remove_const<T>::type;
+        if (ptr_) {
+            return Option<U>(U(*ptr_));
         }
+        return Option<U>(None);
     }
+
+    // @lifetime: (&'a) -> &'a
+    RUSTY_CONSTEXPR20 Option take() {
+        Option result = *this;
+        ptr_ = nullptr;
+        return result;
+    }
+
+    // Rebind to another referent
+    RUSTY_CONSTEXPR20 void replace(T& ref) { ptr_ = &ref; }
 };
 
 // Helper function to create Some variant
 template<typename T>
 // @lifetime: owned
-Option<T> Some(T value) {
+RUSTY_CONSTEXPR20 Option<T> Some(T value) {
     return Option<T>(std::move(value));
 }
 
 // Equality operators
 template<typename T>
-bool operator==(const Option<T>& lhs, const Option<T>& rhs) {
+RUSTY_CONSTEXPR20 bool operator==(const Option<T>& lhs, const Option<T>& rhs) {
     if (lhs.is_none() && rhs.is_none()) return true;
     if (lhs.is_some() && rhs.is_some()) return lhs.unwrap_ref() == rhs.unwrap_ref();
     return false;
 }
 
 template<typename T>
-bool operator!=(const Option<T>& lhs, const Option<T>& rhs) {
+RUSTY_CONSTEXPR20 bool operator!=(const Option<T>& lhs, const Option<T>& rhs) {
     return !(lhs == rhs);
 }
 
@@ -0,0 +1,445 @@
+#ifndef RUSTY_PAR_ITER_HPP
+#define RUSTY_PAR_ITER_HPP
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include "hashmap.hpp"
+#include "slice.hpp"
+#include "thread_pool.hpp"
+#include "vec.hpp"
+
+// Parallel iterators - data parallelism over Vec, Slice and HashMap
+// Equivalent to Rust's rayon::prelude (par_iter, par_chunks, ...)
+//
+//   rusty::Vec<int> v = ...;
+//   long total = rusty::par_iter(v)
+//                    .filter([](const int& x) { return x % 2 == 0; })
+//                    .map([](const int& x) { return long(x) * x; })
+//                    .sum();
+//   rusty::par_iter_mut(v).for_each([](int& x) { x += 1; });
+//
+// A parallel iterator splits its source into contiguous index ranges
+// (buckets, for a HashMap: a control-byte group at a time) and runs them
+// on the current ThreadPool (see thread_pool.hpp): the pool whose worker
+// makes the call, otherwise the global one. The ranges are halved with
+// join, so a worker that finishes early steals the largest piece left
+// instead of idling. The call returns once every range is done; the first
+// exception thrown by a closure is rethrown there, and ranges not yet
+// started are skipped.
+//
+// Closures are called through a const reference from several threads at
+// once, so they must not mutate their captures (a `mutable` lambda does
+// not compile) - the equivalent of Rust's Fn + Sync bound. Mutable access
+// goes only through par_iter_mut / par_chunks_mut, which hand each element
+// to exactly one thread.
+//
+// collect() keeps the source order; reduce(), sum() and count() combine
+// range results in order as well, so an associative operation gives the
+// same answer as the sequential loop.
+//
+// The global pool has RUSTY_NUM_THREADS workers (default: hardware
+// concurrency); ThreadPool::install runs a call on another pool. A
+// parallel call made from inside another one splits its work onto the
+// same workers.
+
+// @safe
+namespace rusty {
+namespace detail {
+
+// Run task(lo) .. task(hi - 1), halving the range with join so idle
+// workers steal the larger halves
+template<typename Task>
+void par_tasks(ThreadPool& pool, size_t lo, size_t hi, Task& task) {
+    if (hi - lo == 1) {
+        task(lo);
+        return;
+    }
+    size_t mid = lo + (hi - lo) / 2;
+    pool.join([&] { par_tasks(pool, lo, mid, task); }, [&] { par_tasks(pool, mid, hi, task); });
+}
+
+// How a source of n indices is cut into tasks
+struct ParSplit {
+    size_t tasks;
+    size_t grain;
+};
+
+inline ParSplit par_split(size_t n, size_t min_len) {
+    size_t pieces = ThreadPool::current().num_threads() * 4;
+    size_t grain = (n + pieces - 1) / pieces;
+    if (grain < min_len) grain = min_len;
+    if (grain == 0) grain = 1;
+    return ParSplit{(n + grain - 1) / grain, grain};
+}
+
+// Run body(task, lo, hi) over the split of [0, n); rethrows the first error
+template<typename Body>
+void par_run(size_t n, ParSplit split, Body& body) {
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    std::atomic<bool> failed(false);
+    auto task = [&](size_t t) {
+        if (failed.load(std::memory_order_relaxed)) return;
+        size_t lo = t * split.grain;
+        size_t hi = n - lo < split.grain ? n : lo + split.grain;
+        try {
+            body(t, lo, hi);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error) error = std::current_exception();
+            failed.store(true, std::memory_order_relaxed);
+        }
+    };
+    ThreadPool& pool = ThreadPool::current();
+    if (split.tasks <= 1 || pool.num_threads() == 1) {
+        // Nothing to run in parallel: skip the hand-off to a worker
+        for (size_t t = 0; t < split.tasks; t++) task(t);
+    } else {
+        auto all = [&] { par_tasks(pool, 0, split.tasks, task); };
+        pool.install(all);
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+// Producers: a source of len() indices whose range [lo, hi) is turned into
+// items by feed(lo, hi, sink). EXACT means one item per index.
+
+template<typename T>
+struct SliceProducer {
+    using Item = const T&;
+    static constexpr bool EXACT = true;
+    const T* data;
+    size_t n;
+
+    size_t len() const { return n; }
+
+    template<typename Sink>
+    void feed(size_t lo, size_t hi, Sink& sink) const {
+        for (size_t i = lo; i < hi; i++) sink(data[i]);
+    }
+};
+
+template<typename T>
+struct SliceMutProducer {
+    using Item = T&;
+    static constexpr bool EXACT = true;
+    T* data;
+    size_t n;
+
+    size_t len() const { return n; }
+
+    template<typename Sink>
+    void feed(size_t lo, size_t hi, Sink& sink) const {
+        for (size_t i = lo; i < hi; i++) sink(data[i]);
+    }
+};
+
+template<typename T>
+struct ChunksProducer {
+    using Item = Slice<T>;
+    static constexpr bool EXACT = true;
+    const T* data;
+    size_t n;
+    size_t size;
+
+    size_t len() const { return (n + size - 1) / size; }
+
+    template<typename Sink>
+    void feed(size_t lo, size_t hi, Sink& sink) const {
+        for (size_t i = lo; i < hi; i++) {
+            size_t start = i * size;
+            sink(Slice<T>(data + start, n - start < size ? n - start : size));
+        }
+    }
+};
+
+template<typename T>
+struct ChunksMutProducer {
+    using Item = SliceMut<T>;
+    static constexpr bool EXACT = true;
+    T* data;
+    size_t n;
+    size_t size;
+
+    size_t len() const { return (n + size - 1) / size; }
+
+    template<typename Sink>
+    void feed(size_t lo, size_t hi, Sink& sink) const {
+        for (size_t i = lo; i < hi; i++) {
+            size_t start = i * size;
+            sink(SliceMut<T>(data + start, n - start < size ? n - start : size));
+        }
+    }
+};
+
+struct RangeProducer {
+    using Item = size_t;
+    static constexpr bool EXACT = true;
+    size_t start;
+    size_t n;
+
+    size_t len() const { return n; }
+
+    template<typename Sink>
+    void feed(size_t lo, size_t hi, Sink& sink) const {
+        for (size_t i = lo; i < hi; i++) sink(start + i);
+    }
+};
+
+// One index per control-byte group of the table
+template<typename Map, typename K, typename V>
+struct HashMapProducer {
+    using Item = std::pair<const K&, const V&>;
+    static constexpr bool EXACT = false;
+    const Map* map;
+
+    size_t len() const { return map->is_empty() ? 0 : map->capacity() / GROUP_SIZE; }
+
+    template<typename Sink>
+    void feed(size_t lo, size_t hi, Sink& sink) const {
+        map->for_each_in_buckets(lo * GROUP_SIZE, hi * GROUP_SIZE,
+                                 [&sink](const K& k, const V& v) { sink(Item(k, v)); });
+    }
+};
+
+template<typename Map, typename K, typename V>
+struct HashMapMutProducer {
+    using Item = std::pair<const K&, V&>;
+    static constexpr bool EXACT = false;
+    Map* map;
+
+    size_t len() const { return map->is_empty() ? 0 : map->capacity() / GROUP_SIZE; }
+
+    template<typename Sink>
+    void feed(size_t lo, size_t hi, Sink& sink) const {
+        map->for_each_in_buckets_mut(lo * GROUP_SIZE, hi * GROUP_SIZE,
+                                     [&sink](const K& k, V& v) { sink(Item(k, v)); });
+    }
+};
+
+template<typename P, typename F>
+struct MapProducer {
+    using Item = decltype(std::declval<const F&>()(std::declval<typename P::Item>()));
+    static constexpr bool EXACT = P::EXACT;
+    P inner;
+    F f;
+
+    size_t len() const { return inner.len(); }
+
+    template<typename Sink>
+    void feed(size_t lo, size_t hi, Sink& sink) const {
+        auto mapped = [this, &sink](auto&& x) { sink(f(std::forward<decltype(x)>(x))); };
+        inner.feed(lo, hi, mapped);
+    }
+};
+
+template<typename P, typename F>
+struct FilterProducer {
+    using Item = typename P::Item;
+    static constexpr bool EXACT = false;
+    P inner;
+    F pred;
+
+    size_t len() const { return inner.len(); }
+
+    template<typename Sink>
+    void feed(size_t lo, size_t hi, Sink& sink) const {
+        auto filtered = [this, &sink](auto&& x) {
+            if (pred(x)) sink(std::forward<decltype(x)>(x));
+        };
+        inner.feed(lo, hi, filtered);
+    }
+};
+
+} // namespace detail
+
+template<typename P>
+class ParIter {
+private:
+    P producer_;
+    size_t min_len_;
+
+    template<typename T, typename Fold, typename Combine>
+    T fold_combine(T identity, const Fold& fold, const Combine& combine) const {
+        size_t n = producer_.len();
+        detail::ParSplit split = detail::par_split(n, min_len_);
+        Vec<T> partial = Vec<T>::with_capacity(split.tasks);
+        for (size_t t = 0; t < split.tasks; t++) partial.push(identity);
+        auto body = [&](size_t t, size_t lo, size_t hi) {
+            T acc = std::move(partial[t]);
+            auto sink = [&](auto&& x) { acc = fold(std::move(acc), std::forward<decltype(x)>(x)); };
+            producer_.feed(lo, hi, sink);
+            partial[t] = std::move(acc);
+        };
+        detail::par_run(n, split, body);
+        T result = std::move(identity);
+        for (T& part : partial) result = combine(std::move(result), std::move(part));
+        return result;
+    }
+
+public:
+    using Item = typename P::Item;
+
+    explicit ParIter(P producer, size_t min_len = 1) : producer_(std::move(producer)), min_len_(min_len) {}
+
+    // Do not split below n indices per task (for cheap per-item work)
+    ParIter with_min_len(size_t n) const { return ParIter(producer_, n); }
+
+    template<typename F>
+    ParIter<detail::MapProducer<P, F>> map(F f) const {
+        return ParIter<detail::MapProducer<P, F>>(
+            detail::MapProducer<P, F>{producer_, std::move(f)}, min_len_);
+    }
+
+    template<typename F>
+    ParIter<detail::FilterProducer<P, F>> filter(F pred) const {
+        return ParIter<detail::FilterProducer<P, F>>(
+            detail::FilterProducer<P, F>{producer_, std::move(pred)}, min_len_);
+    }
+
+    template<typename F>
+    void for_each(F f) const {
+        const F& fn = f;
+        size_t n = producer_.len();
+        auto body = [&](size_t, size_t lo, size_t hi) {
+            auto sink = [&fn](auto&& x) { fn(std::forward<decltype(x)>(x)); };
+            producer_.feed(lo, hi, sink);
+        };
+        detail::par_run(n, detail::par_split(n, min_len_), body);
+    }
+
+    // Fold each task's items into a copy of identity with op, then combine
+    // the task results with op; op must be associative
+    template<typename T, typename Op>
+    T reduce(T identity, Op op) const {
+        return fold_combine(std::move(identity), op, op);
+    }
+
+    size_t count() const {
+        return fold_combine(size_t(0), [](size_t c, auto&&) { return c + 1; },
+                            [](size_t a, size_t b) { return a + b; });
+    }
+
+    typename std::decay<Item>::type sum() const {
+        using S = typename std::decay<Item>::type;
+        return fold_combine(S(), [](S acc, auto&& x) { return acc + x; },
+                            [](S a, S b) { return a + b; });
+    }
+
+    // Collect the items in source order
+    // @lifetime: owned
+    Vec<typename std::decay<Item>::type> collect() const {
+        using S = typename std::decay<Item>::type;
+        size_t n = producer_.len();
+        detail::ParSplit split = detail::par_split(n, min_len_);
+        Vec<Vec<S>> parts = Vec<Vec<S>>::with_capacity(split.tasks);
+        for (size_t t = 0; t < split.tasks; t++) parts.push(Vec<S>());
+        auto body = [&](size_t t, size_t lo, size_t hi) {
+            Vec<S>& out = parts[t];
+            if (P::EXACT) out.reserve(hi - lo);
+            auto sink = [&out](auto&& x) { out.push(S(std::forward<decltype(x)>(x))); };
+            producer_.feed(lo, hi, sink);
+        };
+        detail::par_run(n, split, body);
+
+        size_t total = 0;
+        for (const Vec<S>& part : parts) total += part.len();
+        Vec<S> result = Vec<S>::with_capacity(total);
+        for (Vec<S>& part : parts) result.append(part);
+        return result;
+    }
+};
+
+// Number of threads parallel iterators run on
+inline size_t current_num_threads() {
+    return ThreadPool::current().num_threads();
+}
+
+// @lifetime: (&'a) -> &'a
+template<typename T>
+ParIter<detail::SliceProducer<T>> par_iter(Slice<T> s) {
+    return ParIter<detail::SliceProducer<T>>(detail::SliceProducer<T>{s.as_ptr(), s.len()});
+}
+
+// @lifetime: (&'a) -> &'a
+template<typename T, typename A>
+ParIter<detail::SliceProducer<T>> par_iter(const Vec<T, A>& v) {
+    return par_iter(v.as_slice());
+}
+
+// @lifetime: (&'a mut) -> &'a mut
+template<typename T>
+ParIter<detail::SliceMutProducer<T>> par_iter_mut(SliceMut<T> s) {
+    return ParIter<detail::SliceMutProducer<T>>(
+        detail::SliceMutProducer<T>{s.as_mut_ptr(), s.len()});
+}
+
+// @lifetime: (&'a mut) -> &'a mut
+template<typename T, typename A>
+ParIter<detail::SliceMutProducer<T>> par_iter_mut(Vec<T, A>& v) {
+    return par_iter_mut(v.as_mut_slice());
+}
+
+// Items are Slice<T> pieces of `size` elements (the last may be shorter)
+// @lifetime: (&'a) -> &'a
+template<typename T>
+ParIter<detail::ChunksProducer<T>> par_chunks(Slice<T> s, size_t size) {
+    assert(size > 0);
+    return ParIter<detail::ChunksProducer<T>>(
+        detail::ChunksProducer<T>{s.as_ptr(), s.len(), size});
+}
+
+// @lifetime: (&'a) -> &'a
+template<typename T, typename A>
+ParIter<detail::ChunksProducer<T>> par_chunks(const Vec<T, A>& v, size_t size) {
+    return par_chunks(v.as_slice(), size);
+}
+
+// Items are disjoint SliceMut<T> pieces of `size` elements
+// @lifetime: (&'a mut) -> &'a mut
+template<typename T>
+ParIter<detail::ChunksMutProducer<T>> par_chunks_mut(SliceMut<T> s, size_t size) {
+    assert(size > 0);
+    return ParIter<detail::ChunksMutProducer<T>>(
+        detail::ChunksMutProducer<T>{s.as_mut_ptr(), s.len(), size});
+}
+
+// @lifetime: (&'a mut) -> &'a mut
+template<typename T, typename A>
+ParIter<detail::ChunksMutProducer<T>> par_chunks_mut(Vec<T, A>& v, size_t size) {
+    return par_chunks_mut(v.as_mut_slice(), size);
+}
+
+// The indices start .. end - 1
+inline ParIter<detail::RangeProducer> par_range(size_t start, size_t end) {
+    return ParIter<detail::RangeProducer>(
+        detail::RangeProducer{start, end > start ? end - start : 0});
+}
+
+// Items are std::pair<const K&, const V&>, in no particular order
+// @lifetime: (&'a) -> &'a
+template<typename K, typename V, typename H, typename E, typename A, typename L>
+ParIter<detail::HashMapProducer<HashMap<K, V, H, E, A, L>, K, V>>
+par_iter(const HashMap<K, V, H, E, A, L>& map) {
+    using P = detail::HashMapProducer<HashMap<K, V, H, E, A, L>, K, V>;
+    return ParIter<P>(P{&map});
+}
+
+// Items are std::pair<const K&, V&>
+// @lifetime: (&'a mut) -> &'a mut
+template<typename K, typename V, typename H, typename E, typename A, typename L>
+ParIter<detail::HashMapMutProducer<HashMap<K, V, H, E, A, L>, K, V>>
+par_iter_mut(HashMap<K, V, H, E, A, L>& map) {
+    using P = detail::HashMapMutProducer<HashMap<K, V, H, E, A, L>, K, V>;
+    return ParIter<P>(P{&map});
+}
+
+} // namespace rusty
+
+#endif // RUSTY_PAR_ITER_HPP
@@ -0,0 +1,640 @@
+#ifndef RUSTY_PERSISTENT_HPP
+#define RUSTY_PERSISTENT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include "arc.hpp"
+#include "bounds.hpp"
+#include "fwd.hpp"
+#include "hash.hpp"
+#include "marker.hpp"
+#include "option.hpp"
+#include "rc.hpp"
+#include "traits.hpp"
+#include "vec.hpp"
+
+// PersistentMap<K, V> / PersistentVec<T> - Immutable collections with
+// structural sharing (Rust: the im / rpds crates)
+//
+// Guarantees:
+// - Every update (insert, remove, push_back, set, ...) is const: it returns
+//   a new version and leaves the old one valid and unchanged
+// - A new version copies only the nodes on the path to the change, O(log n)
+//   nodes of at most 32 slots, and shares every other node with the old one
+// - Copying a collection copies one node pointer, so snapshots are O(1)
+// - Nodes are never written once shared, which is the immutable-access
+//   model of Rc and Arc: with the default RcNodes they are counted like Rc
+//   and must stay on one thread; with ArcNodes any version may be read from
+//   other threads, like an Arc<const T>
+//
+// PersistentMap is a hash array mapped trie (HAMT, in CHAMP's layout): five
+// bits of the hash choose one of 32 slots per level, a bitmap says which
+// slots hold an entry and which a child node, and entries and children are
+// stored densely. Keys whose 60 used hash bits collide share a node that is
+// searched linearly.
+//
+// PersistentVec is a radix-balanced trie of 32-element leaves with a
+// separate tail leaf, so push_back and pop_back usually copy only the tail.
+
+// @safe
+namespace rusty {
+
+// How the nodes of a persistent collection are shared between versions
+struct RcNodes {
+    template<typename T> using ptr = Rc<T>;
+};
+
+struct ArcNodes {
+    template<typename T> using ptr = Arc<T>;
+};
+
+namespace detail {
+
+constexpr unsigned PERSISTENT_BITS = 5;
+constexpr size_t PERSISTENT_WIDTH = size_t(1) << PERSISTENT_BITS;
+constexpr size_t PERSISTENT_MASK = PERSISTENT_WIDTH - 1;
+
+inline size_t popcount32(uint32_t x) { return static_cast<size_t>(__builtin_popcount(x)); }
+
+} // namespace detail
+
+template<typename K, typename V, typename Hash, typename KeyEqual, typename Share>
+class PersistentMap {
+private:
+    struct Entry {
+        size_t hash;
+        K key;
+        V value;
+
+        Entry(size_t h, K k, V v) : hash(h), key(std::move(k)), value(std::move(v)) {}
+
+        Entry clone() const {
+            return Entry(hash, detail::clone_value(key), detail::clone_value(value));
+        }
+    };
+
+    struct Node;
+    using NodePtr = typename Share::template ptr<Node>;
+
+    // Below this depth the hash has no bits left: a collision node
+    static constexpr unsigned MAX_DEPTH = 64 / detail::PERSISTENT_BITS;
+
+    struct Node {
+        uint32_t datamap;     // Slots holding an entry
+        uint32_t nodemap;     // Slots holding a child
+        Vec<Entry> entries;   // In slot order; every entry of a collision node
+        Vec<NodePtr> children;
+
+        Node() : datamap(0), nodemap(0) {}
+
+        // A copy with room for one more entry and child
+        Node copy() const {
+            Node n;
+            n.datamap = datamap;
+            n.nodemap = nodemap;
+            n.entries = Vec<Entry>::with_capacity(entries.len() + 1);
+            for (size_t i = 0; i < entries.len(); i++) n.entries.push(entries[i].clone());
+            n.children = Vec<NodePtr>::with_capacity(children.len() + 1);
+            for (size_t i = 0; i < children.len(); i++) n.children.push(children[i].clone());
+            return n;
+        }
+
+        size_t entry_index(uint32_t bit) const { return detail::popcount32(datamap & (bit - 1)); }
+        size_t child_index(uint32_t bit) const { return detail::popcount32(nodemap & (bit - 1)); }
+
+        // One entry and no children: a child like this is inlined into its
+        // parent, keeping the trie canonical
+        bool is_single_entry() const { return children.is_empty() && entries.len() == 1; }
+    };
+
+    NodePtr root_;  // Empty when the map is
+    size_t size_;
+    Hash hasher_;
+    KeyEqual key_eq_;
+
+    static uint32_t slot_bit(size_t hash, unsigned depth) {
+        // The top bits first: FxHash mixes best there
+        unsigned shift = 64 - detail::PERSISTENT_BITS * (depth + 1);
+        return uint32_t(1) << ((hash >> shift) & detail::PERSISTENT_MASK);
+    }
+
+    static NodePtr share(Node node) { return NodePtr::new_(std::move(node)); }
+
+    // A node holding two entries whose hashes agree above depth
+    static Node merge(Entry a, Entry b, unsigned depth) {
+        Node node;
+        if (depth >= MAX_DEPTH) {
+            node.entries.push(std::move(a));
+            node.entries.push(std::move(b));
+            return node;
+        }
+        uint32_t bit_a = slot_bit(a.hash, depth);
+        uint32_t bit_b = slot_bit(b.hash, depth);
+        if (bit_a == bit_b) {
+            node.nodemap = bit_a;
+            node.children.push(share(merge(std::move(a), std::move(b), depth + 1)));
+        } else {
+            node.datamap = bit_a | bit_b;
+            if (bit_a > bit_b) std::swap(a, b);
+            node.entries.push(std::move(a));
+            node.entries.push(std::move(b));
+        }
+        return node;
+    }
+
+    // node with entry inserted or its value replaced; added tells which
+    Node insert_into(const Node& node, Entry entry, unsigned depth, bool& added) const {
+        Node n = node.copy();
+        if (depth >= MAX_DEPTH) {
+            for (size_t i = 0; i < n.entries.len(); i++) {
+                if (key_eq_(n.entries[i].key, entry.key)) {
+                    n.entries[i].value = std::move(entry.value);
+                    return n;
+                }
+            }
+            n.entries.push(std::move(entry));
+            added = true;
+            return n;
+        }
+
+        uint32_t bit = slot_bit(entry.hash, depth);
+        if (node.datamap & bit) {
+            size_t i = node.entry_index(bit);
+            const Entry& existing = node.entries[i];
+            if (existing.hash == entry.hash && key_eq_(existing.key, entry.key)) {
+                n.entries[i].value = std::move(entry.value);
+                return n;
+            }
+            // Two keys for one slot: both move down into a new child
+            Entry moved = n.entries.remove(i);
+            n.datamap &= ~bit;
+            n.nodemap |= bit;
+            n.children.insert(n.child_index(bit), share(merge(std::move(moved), std::move(entry), depth + 1)));
+            added = true;
+        } else if (node.nodemap & bit) {
+            size_t i = node.child_index(bit);
+            n.children[i] = share(insert_into(*node.children[i], std::move(entry), depth + 1, added));
+        } else {
+            n.entries.insert(node.entry_index(bit), std::move(entry));
+            n.datamap |= bit;
+            added = true;
+        }
+        return n;
+    }
+
+    // node without key, or None when it does not hold key
+    Option<Node> remove_from(const Node& node, const K& key, size_t hash, unsigned depth) const {
+        if (depth >= MAX_DEPTH) {
+            for (size_t i = 0; i < node.entries.len(); i++) {
+                if (key_eq_(node.entries[i].key, key)) {
+                    Node n = node.copy();
+                    n.entries.remove(i);
+                    return Some(std::move(n));
+                }
+            }
+            return None;
+        }
+
+        uint32_t bit = slot_bit(hash, depth);
+        if (node.datamap & bit) {
+            size_t i = node.entry_index(bit);
+            if (node.entries[i].hash != hash || !key_eq_(node.entries[i].key, key)) return None;
+            Node n = node.copy();
+            n.entries.remove(i);
+            n.datamap &= ~bit;
+            return Some(std::move(n));
+        }
+        if (!(node.nodemap & bit)) return None;
+
+        size_t i = node.child_index(bit);
+        Option<Node> child = remove_from(*node.children[i], key, hash, depth + 1);
+        if (child.is_none()) return None;
+        Node smaller = child.unwrap();
+        Node n = node.copy();
+        if (smaller.is_single_entry()) {
+            // Pull the last entry of the child up into this node
+            n.children.remove(i);
+            n.nodemap &= ~bit;
+            n.entries.insert(n.entry_index(bit), smaller.entries.remove(0));
+            n.datamap |= bit;
+        } else {
+            n.children[i] = share(std::move(smaller));
+        }
+        return Some(std::move(n));
+    }
+
+    const Entry* find(const K& key) const {
+        if (!root_) return nullptr;
+        size_t hash = hasher_(key);
+        const Node* node = root_.get();
+        for (unsigned depth = 0;; depth++) {
+            if (depth >= MAX_DEPTH) {
+                for (size_t i = 0; i < node->entries.len(); i++) {
+                    if (key_eq_(node->entries[i].key, key)) return &node->entries[i];
+                }
+                return nullptr;
+            }
+            uint32_t bit = slot_bit(hash, depth);
+            if (node->datamap & bit) {
+                const Entry& e = node->entries[node->entry_index(bit)];
+                return e.hash == hash && key_eq_(e.key, key) ? &e : nullptr;
+            }
+            if (!(node->nodemap & bit)) return nullptr;
+            node = node->children[node->child_index(bit)].get();
+        }
+    }
+
+    template<typename F>
+    static void for_each_in(const Node& node, F& f) {
+        for (size_t i = 0; i < node.entries.len(); i++) {
+            f(node.entries[i].key, node.entries[i].value);
+        }
+        for (size_t i = 0; i < node.children.len(); i++) {
+            for_each_in(*node.children[i], f);
+        }
+    }
+
+    PersistentMap(NodePtr root, size_t size, const Hash& hasher, const KeyEqual& key_eq)
+        : root_(std::move(root)), size_(size), hasher_(hasher), key_eq_(key_eq) {}
+
+public:
+    // Empty; allocates nothing
+    PersistentMap() : size_(0) {}
+
+    // @lifetime: owned
+    static PersistentMap new_() {
+        return PersistentMap();
+    }
+
+    // Copies share every node
+    PersistentMap(const PersistentMap&) = default;
+    PersistentMap& operator=(const PersistentMap&) = default;
+    PersistentMap(PersistentMap&&) = default;
+    PersistentMap& operator=(PersistentMap&&) = default;
+
+    // Another handle to this version, O(1)
+    // @lifetime: owned
+    PersistentMap clone() const {
+        return *this;
+    }
+
+    size_t len() const { return size_; }
+    bool is_empty() const { return size_ == 0; }
+
+    // @lifetime: (&'a) -> &'a
+    Option<const V&> get(const K& key) const {
+        const Entry* e = find(key);
+        if (e) return Option<const V&>(e->value);
+        return None;
+    }
+
+    bool contains_key(const K& key) const {
+        return find(key) != nullptr;
+    }
+
+    // A version with key mapped to value
+    // @lifetime: owned
+    PersistentMap insert(K key, V value) const {
+        size_t hash = hasher_(key);
+        Entry entry(hash, std::move(key), std::move(value));
+        if (!root_) {
+            Node node;
+            node.datamap = slot_bit(hash, 0);
+            node.entries.push(std::move(entry));
+            return PersistentMap(share(std::move(node)), 1, hasher_, key_eq_);
+        }
+        bool added = false;
+        Node root = insert_into(*root_, std::move(entry), 0, added);
+        return PersistentMap(share(std::move(root)), size_ + added, hasher_, key_eq_);
+    }
+
+    // A version without key; shares this version's root if key is absent
+    // @lifetime: owned
+    PersistentMap remove(const K& key) const {
+        if (!root_) return *this;
+        Option<Node> root = remove_from(*root_, key, hasher_(key), 0);
+        if (root.is_none()) return *this;
+        if (size_ == 1) return PersistentMap(NodePtr(), 0, hasher_, key_eq_);
+        return PersistentMap(share(root.unwrap()), size_ - 1, hasher_, key_eq_);
+    }
+
+    // Call f(key, value) for each entry, in hash order
+    template<typename F>
+    void for_each(F f) const {
+        if (root_) for_each_in(*root_, f);
+    }
+
+    // True when both are the same version, or one was copied from the other
+    bool ptr_eq(const PersistentMap& other) const {
+        return root_.get() == other.root_.get();
+    }
+
+    bool operator==(const PersistentMap& other) const {
+        if (size_ != other.size_) return false;
+        if (ptr_eq(other)) return true;
+        bool equal = true;
+        for_each([&](const K& key, const V& value) {
+            if (!equal) return;
+            const Entry* e = other.find(key);
+            equal = e && e->value == value;
+        });
+        return equal;
+    }
+
+    bool operator!=(const PersistentMap& other) const {
+        return !(*this == other);
+    }
+};
+
+template<typename K, typename V, typename Hash, typename KeyEqual, typename Share>
+constexpr unsigned PersistentMap<K, V, Hash, KeyEqual, Share>::MAX_DEPTH;
+
+template<typename T, typename Share>
+class PersistentVec {
+private:
+    // A leaf holds values, an inner node children
+    struct Node;
+    using NodePtr = typename Share::template ptr<Node>;
+
+    struct Node {
+        Vec<NodePtr> children;
+        Vec<T> values;
+
+        // A copy with room for one more slot
+        Node copy() const {
+            Node n;
+            n.children = Vec<NodePtr>::with_capacity(children.is_empty() ? 0 : children.len() + 1);
+            for (size_t i = 0; i < children.len(); i++) n.children.push(children[i].clone());
+            n.values = Vec<T>::with_capacity(values.is_empty() ? 0 : values.len() + 1);
+            for (size_t i = 0; i < values.len(); i++) n.values.push(detail::clone_value(values[i]));
+            return n;
+        }
+    };
+
+    static constexpr unsigned BITS = detail::PERSISTENT_BITS;
+    static constexpr size_t WIDTH = detail::PERSISTENT_WIDTH;
+    static constexpr size_t MASK = detail::PERSISTENT_MASK;
+
+    NodePtr root_;   // The full leaves; empty until there are more than WIDTH values
+    NodePtr tail_;   // The last 1 to WIDTH values; empty when the Vec is
+    unsigned shift_; // Index bits below the root's level
+    size_t size_;
+
+    static NodePtr share(Node node) { return NodePtr::new_(std::move(node)); }
+
+    // Index of the first value in the tail
+    size_t tail_offset() const {
+        return size_ <= WIDTH ? 0 : ((size_ - 1) >> BITS) << BITS;
+    }
+
+    // The leaf holding index, which must be in the tree rather than the tail
+    const Node* leaf_for(size_t index) const {
+        if (index >= tail_offset()) return tail_.get();
+        const Node* node = root_.get();
+        for (unsigned level = shift_; level > 0; level -= BITS) {
+            node = node->children[(index >> level) & MASK].get();
+        }
+        return node;
+    }
+
+    // A path of single-child nodes from level down to leaf
+    static NodePtr new_path(unsigned level, NodePtr leaf) {
+        if (level == 0) return leaf;
+        Node node;
+        node.children.push(new_path(level - BITS, std::move(leaf)));
+        return share(std::move(node));
+    }
+
+    // parent at level with the full tail appended as its last leaf; size_
+    // counts the tail
+    NodePtr push_tail(unsigned level, const Node& parent, NodePtr tail) const {
+        Node n = parent.copy();
+        size_t sub = ((size_ - 1) >> level) & MASK;
+        NodePtr child;
+        if (level == BITS) {
+            child = std::move(tail);
+        } else if (sub < parent.children.len()) {
+            child = push_tail(level - BITS, *parent.children[sub], std::move(tail));
+        } else {
+            child = new_path(level - BITS, std::move(tail));
+        }
+        if (sub < n.children.len()) {
+            n.children[sub] = std::move(child);
+        } else {
+            n.children.push(std::move(child));
+        }
+        return share(std::move(n));
+    }
+
+    // node at level without its last leaf; empty if that was its only one
+    NodePtr pop_tail(unsigned level, const Node& node) const {
+        size_t sub = ((size_ - 2) >> level) & MASK;
+        if (level > BITS) {
+            NodePtr child = pop_tail(level - BITS, *node.children[sub]);
+            if (!child && sub == 0) return NodePtr();
+            Node n = node.copy();
+            if (child) {
+                n.children[sub] = std::move(child);
+            } else {
+                n.children.pop();
+            }
+            return share(std::move(n));
+        }
+        if (sub == 0) return NodePtr();
+        Node n = node.copy();
+        n.children.pop();
+        return share(std::move(n));
+    }
+
+    // node at level with index set to value
+    static NodePtr assoc(unsigned level, const Node& node, size_t index, T value) {
+        Node n = node.copy();
+        if (level == 0) {
+            n.values[index & MASK] = std::move(value);
+        } else {
+            size_t sub = (index >> level) & MASK;
+            n.children[sub] = assoc(level - BITS, *node.children[sub], index, std::move(value));
+        }
+        return share(std::move(n));
+    }
+
+    PersistentVec(NodePtr root, NodePtr tail, unsigned shift, size_t size)
+        : root_(std::move(root)), tail_(std::move(tail)), shift_(shift), size_(size) {}
+
+public:
+    // Empty; allocates nothing
+    PersistentVec() : shift_(BITS), size_(0) {}
+
+    // @lifetime: owned
+    static PersistentVec new_() {
+        return PersistentVec();
+    }
+
+    // Copies share every node
+    PersistentVec(const PersistentVec&) = default;
+    PersistentVec& operator=(const PersistentVec&) = default;
+    PersistentVec(PersistentVec&&) = default;
+    PersistentVec& operator=(PersistentVec&&) = default;
+
+    // Another handle to this version, O(1)
+    // @lifetime: owned
+    PersistentVec clone() const {
+        return *this;
+    }
+
+    size_t len() const { return size_; }
+    bool is_empty() const { return size_ == 0; }
+
+    // @lifetime: (&'a) -> &'a
+    Option<const T&> get(size_t index) const {
+        if (index >= size_) return None;
+        return Option<const T&>(leaf_for(index)->values[index & MASK]);
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const T& operator[](size_t index) const {
+        RUSTY_BOUNDS_CHECK(index < size_, "PersistentVec index out of bounds");
+        return leaf_for(index)->values[index & MASK];
+    }
+
+    // A version with value appended
+    // @lifetime: owned
+    PersistentVec push_back(T value) const {
+        // Room in the tail: only the tail is copied
+        if (size_ - tail_offset() < WIDTH) {
+            Node tail = tail_ ? tail_->copy() : Node();
+            tail.values.push(std::move(value));
+            return PersistentVec(root_, share(std::move(tail)), shift_, size_ + 1);
+        }
+
+        // The full tail becomes the tree's last leaf
+        NodePtr root;
+        unsigned shift = shift_;
+        if (!root_) {
+            root = new_path(shift_, tail_);
+        } else if ((size_ >> BITS) > (size_t(1) << shift_)) {
+            Node grown;
+            grown.children.push(root_);
+            grown.children.push(new_path(shift_, tail_));
+            root = share(std::move(grown));
+            shift += BITS;
+        } else {
+            root = push_tail(shift_, *root_, tail_);
+        }
+        Node tail;
+        tail.values.push(std::move(value));
+        return PersistentVec(std::move(root), share(std::move(tail)), shift, size_ + 1);
+    }
+
+    // A version without the last value (empty for an empty Vec)
+    // @lifetime: owned
+    PersistentVec pop_back() const {
+        if (size_ <= 1) return PersistentVec();
+        if (size_ - tail_offset() > 1) {
+            Node tail = tail_->copy();
+            tail.values.pop();
+            return PersistentVec(root_, share(std::move(tail)), shift_, size_ - 1);
+        }
+
+        // The tail empties: the tree's last leaf becomes the tail
+        NodePtr tail;
+        const Node* node = root_.get();
+        for (unsigned level = shift_;; level -= BITS) {
+            const NodePtr& child = node->children[((size_ - 2) >> level) & MASK];
+            if (level == BITS) {
+                tail = child;
+                break;
+            }
+            node = child.get();
+        }
+        NodePtr root = pop_tail(shift_, *root_);
+        unsigned shift = shift_;
+        if (root && shift > BITS && root->children.len() == 1) {
+            NodePtr only = root->children[0];
+            root = std::move(only);
+            shift -= BITS;
+        }
+        return PersistentVec(std::move(root), std::move(tail), shift, size_ - 1);
+    }
+
+    // A version with index set to value
+    // @lifetime: owned
+    PersistentVec set(size_t index, T value) const {
+        RUSTY_BOUNDS_CHECK(index < size_, "PersistentVec index out of bounds");
+        if (index >= tail_offset()) {
+            Node tail = tail_->copy();
+            tail.values[index & MASK] = std::move(value);
+            return PersistentVec(root_, share(std::move(tail)), shift_, size_);
+        }
+        return PersistentVec(assoc(shift_, *root_, index, std::move(value)), tail_, shift_, size_);
+    }
+
+    // Call f(value) for each value in order, one leaf at a time
+    template<typename F>
+    void for_each(F f) const {
+        for (size_t base = 0; base < size_; base += WIDTH) {
+            const Node* leaf = leaf_for(base);
+            for (size_t i = 0; i < leaf->values.len(); i++) f(leaf->values[i]);
+        }
+    }
+
+    // True when both are the same version, or one was copied from the other
+    bool ptr_eq(const PersistentVec& other) const {
+        return size_ == other.size_ && root_.get() == other.root_.get() &&
+               tail_.get() == other.tail_.get();
+    }
+
+    bool operator==(const PersistentVec& other) const {
+        if (size_ != other.size_) return false;
+        if (ptr_eq(other)) return true;
+        for (size_t i = 0; i < size_; i++) {
+            if (!((*this)[i] == other[i])) return false;
+        }
+        return true;
+    }
+
+    bool operator!=(const PersistentVec& other) const {
+        return !(*this == other);
+    }
+};
+
+template<typename T, typename Share>
+constexpr unsigned PersistentVec<T, Share>::BITS;
+template<typename T, typename Share>
+constexpr size_t PersistentVec<T, Share>::WIDTH;
+template<typename T, typename Share>
+constexpr size_t PersistentVec<T, Share>::MASK;
+
+// Rc-shared nodes confine every version to its thread; Arc-shared ones
+// may be read anywhere, so the entries must be Send and Sync
+template<typename K, typename V, typename Hash, typename KeyEqual>
+struct is_send<PersistentMap<K, V, Hash, KeyEqual, RcNodes>> : std::false_type {};
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+struct is_sync<PersistentMap<K, V, Hash, KeyEqual, RcNodes>> : std::false_type {};
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+struct is_send<PersistentMap<K, V, Hash, KeyEqual, ArcNodes>>
+    : detail::all_of<is_send<K>::value, is_sync<K>::value, is_send<V>::value, is_sync<V>::value> {};
+
+template<typename K, typename V, typename Hash, typename KeyEqual>
+struct is_sync<PersistentMap<K, V, Hash, KeyEqual, ArcNodes>>
+    : detail::all_of<is_send<K>::value, is_sync<K>::value, is_send<V>::value, is_sync<V>::value> {};
+
+template<typename T>
+struct is_send<PersistentVec<T, RcNodes>> : std::false_type {};
+
+template<typename T>
+struct is_sync<PersistentVec<T, RcNodes>> : std::false_type {};
+
+template<typename T>
+struct is_send<PersistentVec<T, ArcNodes>> : detail::all_of<is_send<T>::value, is_sync<T>::value> {};
+
+template<typename T>
+struct is_sync<PersistentVec<T, ArcNodes>> : detail::all_of<is_send<T>::value, is_sync<T>::value> {};
+
+} // namespace rusty
+
+#endif // RUSTY_PERSISTENT_HPP
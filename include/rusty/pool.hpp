@@ -0,0 +1,330 @@
+#ifndef RUSTY_POOL_HPP
+#define RUSTY_POOL_HPP
+
+#include <cassert>
+#include <cstddef>  // for size_t
+#include <mutex>
+#include <new>
+#include <type_traits>  // for std::aligned_storage
+#include <utility>  // for std::move, std::forward
+#include "alloc.hpp"
+#include "niche.hpp"
+#include "relocate.hpp"
+
+// Pool<T> - Free-list allocator for fixed-size objects
+// PoolBox<T> - Box<T> whose memory comes from, and returns to, Pool<T>
+//
+// Guarantees:
+// - Allocation and free are a pointer pop/push on a thread-local free list
+//   in the common case: no locks, no atomics, no malloc
+// - Slots are carved from chunks of CHUNK_SLOTS; a thread whose list runs
+//   dry takes a batch from a shared list (under a mutex) before allocating
+//   a new chunk, and a thread holding too many free slots hands a batch back
+// - A PoolBox may be dropped on any thread; its slot joins that thread's list
+//
+// There is one pool per type, shared by the whole process. Chunks are
+// kept for reuse and never returned to the system.
+
+// @safe
+namespace rusty {
+
+template<typename T>
+class PoolBox;
+
+template<typename T>
+class Pool {
+private:
+    friend class PoolBox<T>;
+
+    static constexpr size_t CHUNK_SLOTS = 64;
+    static constexpr size_t BATCH = 64;          // slots moved per exchange
+    static constexpr size_t LOCAL_MAX = 2 * BATCH;
+
+    union Slot {
+        Slot* next;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    // Free slots that no thread holds
+    struct Shared {
+        std::mutex lock;
+        Slot* head;
+        size_t len;
+
+        Shared() : head(nullptr), len(0) {}
+    };
+
+    // Intentionally never destroyed: PoolBoxes in static objects may be
+    // dropped after every destructor of this header has run
+    static Shared& shared() {
+        static Shared* state = new Shared();
+        return *state;
+    }
+
+    struct Local {
+        Slot* head;
+        size_t len;
+
+        Local() : head(nullptr), len(0) {}
+
+        // A finishing thread gives all its slots back
+        ~Local() {
+            if (len > 0) give_back(len);
+            local_destroyed() = true;
+        }
+
+        void push(Slot* slot) {
+            slot->next = head;
+            head = slot;
+            len++;
+        }
+
+        Slot* pop() {
+            Slot* slot = head;
+            head = slot->next;
+            len--;
+            return slot;
+        }
+
+        // Move count slots to the shared list
+        void give_back(size_t count) {
+            Slot* first = head;
+            Slot* last = head;
+            for (size_t i = 1; i < count; i++) last = last->next;
+            head = last->next;
+            len -= count;
+
+            Shared& s = shared();
+            std::lock_guard<std::mutex> guard(s.lock);
+            last->next = s.head;
+            s.head = first;
+            s.len += count;
+        }
+
+        // Take a batch from the shared list, or carve a new chunk
+        void refill() {
+            {
+                Shared& s = shared();
+                std::lock_guard<std::mutex> guard(s.lock);
+                while (s.head && len < BATCH) {
+                    Slot* slot = s.head;
+                    s.head = slot->next;
+                    s.len--;
+                    push(slot);
+                }
+            }
+            if (len == 0) carve();
+        }
+
+        // Push a freshly allocated chunk of slots
+        void carve() {
+            Global alloc;
+            Slot* chunk = static_cast<Slot*>(
+                alloc_or_throw(alloc, sizeof(Slot) * CHUNK_SLOTS, alignof(Slot)));
+            for (size_t i = CHUNK_SLOTS; i > 0; i--) {
+                push(&chunk[i - 1]);
+            }
+        }
+    };
+
+    // Set once the calling thread's Local is gone (thread or program exit)
+    static bool& local_destroyed() {
+        static thread_local bool destroyed = false;
+        return destroyed;
+    }
+
+    static Local& local() {
+        static thread_local Local cache;
+        return cache;
+    }
+
+    static void* allocate() {
+        Local& cache = local();
+        if (!cache.head) cache.refill();
+        return &cache.pop()->storage;
+    }
+
+    static void deallocate(void* p) {
+        Slot* slot = static_cast<Slot*>(p);
+        if (local_destroyed()) {
+            // Late drop, e.g. from a static destructor: bypass the cache
+            Shared& s = shared();
+            std::lock_guard<std::mutex> guard(s.lock);
+            slot->next = s.head;
+            s.head = slot;
+            s.len++;
+            return;
+        }
+        Local& cache = local();
+        cache.push(slot);
+        if (cache.len > LOCAL_MAX) cache.give_back(BATCH);
+    }
+
+public:
+    // Construct a T in a pooled slot
+    // @lifetime: owned
+    static PoolBox<T> new_(T value) {
+        return make(std::move(value));
+    }
+
+    // Construct the value in place from constructor arguments
+    // @lifetime: owned
+    template<typename... Args>
+    static PoolBox<T> make(Args&&... args) {
+        void* p = allocate();
+        try {
+            return PoolBox<T>(new (p) T(std::forward<Args>(args)...));
+        } catch (...) {
+            deallocate(p);
+            throw;
+        }
+    }
+
+    // An uninitialised slot of sizeof(T) bytes, for allocators built on
+    // the pool (coroutine frames); free it with deallocate_raw on any thread
+    static void* allocate_raw() { return allocate(); }
+    static void deallocate_raw(void* p) { deallocate(p); }
+
+    // Make at least n slots available to the calling thread
+    static void reserve(size_t n) {
+        Local& cache = local();
+        while (cache.len < n) cache.carve();
+    }
+
+    // Free slots on the calling thread's list
+    static size_t local_free() {
+        return local().len;
+    }
+
+    // Free slots on the shared list
+    static size_t shared_free() {
+        Shared& s = shared();
+        std::lock_guard<std::mutex> guard(s.lock);
+        return s.len;
+    }
+};
+
+template<typename T>
+constexpr size_t Pool<T>::CHUNK_SLOTS;
+template<typename T>
+constexpr size_t Pool<T>::BATCH;
+template<typename T>
+constexpr size_t Pool<T>::LOCAL_MAX;
+
+template<typename T>
+class PoolBox {
+private:
+    friend class Pool<T>;
+
+    T* ptr;
+
+    // @lifetime: owned
+    explicit PoolBox(T* p) : ptr(p) {}
+
+    void drop() {
+        if (ptr) {
+            ptr->~T();
+            Pool<T>::deallocate(ptr);
+        }
+    }
+
+public:
+    PoolBox() : ptr(nullptr) {}
+
+    // @lifetime: owned
+    static PoolBox<T> new_(T value) {
+        return Pool<T>::new_(std::move(value));
+    }
+
+    // @lifetime: owned
+    template<typename... Args>
+    static PoolBox<T> make(Args&&... args) {
+        return Pool<T>::make(std::forward<Args>(args)...);
+    }
+
+    // No copy constructor - PoolBox cannot be copied
+    PoolBox(const PoolBox&) = delete;
+    PoolBox& operator=(const PoolBox&) = delete;
+
+    // Move constructor - transfers ownership
+    // @lifetime: owned
+    PoolBox(PoolBox&& other) noexcept : ptr(other.ptr) {
+        other.ptr = nullptr;
+    }
+
+    // Move assignment - transfers ownership
+    // @lifetime: owned
+    PoolBox& operator=(PoolBox&& other) noexcept {
+        if (this != &other) {
+            drop();
+            ptr = other.ptr;
+            other.ptr = nullptr;
+        }
+        return *this;
+    }
+
+    // Destructor - drops the value and returns the slot to the pool
+    ~PoolBox() {
+        drop();
+    }
+
+    // @lifetime: (&'a) -> &'a
+    T& operator*() {
+        assert(ptr != nullptr);
+        return *ptr;
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const T& operator*() const {
+        assert(ptr != nullptr);
+        return *ptr;
+    }
+
+    // @lifetime: (&'a) -> &'a
+    T* operator->() {
+        return ptr;
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const T* operator->() const {
+        return ptr;
+    }
+
+    // @lifetime: (&'a) -> &'a
+    T* get() const {
+        return ptr;
+    }
+
+    bool is_valid() const {
+        return ptr != nullptr;
+    }
+
+    explicit operator bool() const {
+        return is_valid();
+    }
+
+    // Drop the value now, leaving the PoolBox empty
+    void reset() {
+        drop();
+        ptr = nullptr;
+    }
+};
+
+// PoolBox only holds a pointer, so it can be relocated bitwise
+template<typename T>
+struct is_trivially_relocatable<PoolBox<T>> : std::true_type {};
+
+// Empty handles are null, so Option stores None as a null pointer
+template<typename T>
+struct niche_traits<PoolBox<T>> : null_pointer_niche {};
+
+// Rust-idiomatic factory function
+template<typename T, typename... Args>
+// @lifetime: owned
+PoolBox<T> pool_box(Args&&... args) {
+    return Pool<T>::make(std::forward<Args>(args)...);
+}
+
+} // namespace rusty
+
+#endif // RUSTY_POOL_HPP
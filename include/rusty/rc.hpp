@@ -4,6 +4,10 @@
 #include <cassert>
 #include <utility>  // for std::move, std::forward
 #include <cstddef>  // for size_t
+#include "alloc_observer.hpp"
+#include "marker.hpp"
+#include "niche.hpp"
+#include "relocate.hpp"
 
 // Rc<T> - Reference Counted pointer (non-atomic)
 // Equivalent to Rust's Rc<T>
@@ -39,6 +43,13 @@ private:
     
     ControlBlock* ptr;
     
+    template<typename... Args>
+    static ControlBlock* create(Args&&... args) {
+        ControlBlock* block = new ControlBlock(std::forward<Args>(args)...);
+        detail::observe_alloc(AllocKind::Rc, block, sizeof(ControlBlock));
+        return block;
+    }
+    
     void increment() {
         if (ptr) {
             ++ptr->ref_count;
@@ -48,6 +59,7 @@ private:
     void decrement() {
         if (ptr) {
             if (--ptr->ref_count == 0) {
+                detail::observe_dealloc(AllocKind::Rc, ptr, sizeof(ControlBlock));
                 delete ptr;
             }
         }
@@ -60,13 +72,13 @@ public:
     // Rust-idiomatic factory method - Rc::new()
     // @lifetime: owned
     static Rc<T> new_(T value) {
-        return Rc<T>(new ControlBlock(std::move(value)));
+        return Rc<T>(create(std::move(value)));
     }
     
     // C++-friendly factory method (kept for compatibility)
     // @lifetime: owned
     static Rc<T> make(T value) {
-        return Rc<T>(new ControlBlock(std::move(value)));
+        return Rc<T>(create(std::move(value)));
     }
     
     // Private constructor from control block
@@ -167,6 +179,22 @@ public:
     }
 };
 
+// Rc only holds a pointer to its control block, so it can be relocated bitwise
+template<typename T>
+struct is_trivially_relocatable<Rc<T>> : std::true_type {};
+
+// Empty handles are null, so Option stores None as a null pointer
+template<typename T>
+struct niche_traits<Rc<T>> : null_pointer_niche {};
+
+// The count is not atomic: an Rc may not leave its thread, and sharing one
+// by reference would let two threads clone it at once
+template<typename T>
+struct is_send<Rc<T>> : std::false_type {};
+
+template<typename T>
+struct is_sync<Rc<T>> : std::false_type {};
+
 // Rust-idiomatic factory function
 template<typename T, typename... Args>
 // @lifetime: owned
@@ -212,6 +240,12 @@ public:
     }
 };
 
+template<typename T>
+struct is_send<Weak<T>> : std::false_type {};
+
+template<typename T>
+struct is_sync<Weak<T>> : std::false_type {};
+
 } // namespace rusty
 
 #endif // RUSTY_RC_HPP
\ No newline at end of file
@@ -0,0 +1,72 @@
+#ifndef RUSTY_RELOCATE_HPP
+#define RUSTY_RELOCATE_HPP
+
+#include <cstddef>  // for size_t
+#include <cstring>  // for memmove
+#include <new>
+#include <type_traits>
+#include <utility>  // for std::move
+
+// is_trivially_relocatable<T> - Marks types whose objects can be moved to a
+// new address by copying their bytes, without running the move constructor
+// on the destination or the destructor on the source.
+//
+// This is what Rust assumes for every type: a move is a memcpy. In C++ it
+// holds for all trivially copyable types and for most owning handles
+// (Box, Arc, Rc, String, Vec), since they only hold pointers to storage
+// that does not point back at the handle itself.
+//
+// Containers use it to relocate their storage in one memcpy/realloc
+// instead of moving and destroying each element.
+//
+// Opt a type in by specializing:
+//   template<> struct is_trivially_relocatable<MyType> : std::true_type {};
+//
+// Do NOT opt in types that store pointers into themselves
+// (e.g. small-buffer types whose data pointer aims at an inline buffer).
+
+// @safe
+namespace rusty {
+
+template<typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+namespace detail {
+
+template<typename T>
+void relocate_n(T* dst, T* src, size_t n, std::true_type) {
+    if (n > 0) {
+        std::memmove(static_cast<void*>(dst), static_cast<const void*>(src), n * sizeof(T));
+    }
+}
+
+// Move-construct then destroy one element at a time, walking in the
+// direction that never overwrites an element before it has been moved
+template<typename T>
+void relocate_n(T* dst, T* src, size_t n, std::false_type) {
+    if (dst < src) {
+        for (size_t i = 0; i < n; i++) {
+            new (dst + i) T(std::move(src[i]));
+            src[i].~T();
+        }
+    } else if (dst > src) {
+        for (size_t i = n; i > 0; i--) {
+            new (dst + i - 1) T(std::move(src[i - 1]));
+            src[i - 1].~T();
+        }
+    }
+}
+
+} // namespace detail
+
+// Relocate n live objects from src to uninitialized (or already relocated)
+// storage at dst; the ranges may overlap. Afterwards src holds no objects.
+// @unsafe
+template<typename T>
+void relocate_n(T* dst, T* src, size_t n) {
+    detail::relocate_n(dst, src, n, is_trivially_relocatable<T>());
+}
+
+} // namespace rusty
+
+#endif // RUSTY_RELOCATE_HPP
@@ -5,6 +5,7 @@
 #include <stdexcept>
 #include <new>
 #include <type_traits>
+#include "niche.hpp"
 
 // Result<T, E> - Represents either success (Ok) or failure (Err)
 // Equivalent to Rust's Result<T, E>
@@ -13,135 +14,263 @@
 // - Explicit error handling
 // - No hidden exceptions
 // - Composable error propagation
+// - Trivially copyable when T and E are, so small Results such as
+//   Result<uint32_t, ErrorCode> are returned in registers
+// - From C++20 on, Result of literal types works in constant expressions
+//   (Result<void, E> with a niche E does not)
 
 // @safe
 namespace rusty {
 
+namespace detail {
+
+// Both alternatives trivially copyable: so is the Result, which lets it be
+// returned in registers and skip the destructor call
 template<typename T, typename E>
-class Result {
-private:
-    // Use aligned storage for union-like behavior (C++11 compatible)
-    union Storage {
-        typename std::aligned_storage<sizeof(T), alignof(T)>::type ok_storage;
-        typename std::aligned_storage<sizeof(E), alignof(E)>::type err_storage;
-        
-        Storage() {}
-        ~Storage() {}
-    } storage;
-    
+struct result_is_trivial
+    : std::integral_constant<bool, std::is_trivially_copyable<T>::value &&
+                                   std::is_trivially_copyable<E>::value> {};
+
+template<typename E>
+struct result_is_trivial<void, E> : std::is_trivially_copyable<E> {};
+
+// Ok and Err share a union. It starts out holding neither; with trivial
+// payloads its copy and destruction are trivial too, otherwise
+// ResultStorage below supplies them
+template<typename T, typename E, bool Trivial = result_is_trivial<T, E>::value>
+union ResultUnion {
+    char none;
+    T ok;
+    E err;
+
+    RUSTY_CONSTEXPR20 ResultUnion() : none(0) {}
+};
+
+template<typename T, typename E>
+union ResultUnion<T, E, false> {
+    char none;
+    T ok;
+    E err;
+
+    RUSTY_CONSTEXPR20 ResultUnion() : none(0) {}
+    RUSTY_CONSTEXPR20 ~ResultUnion() {}
+};
+
+// Layouts hold the storage and the discriminant; they have no special
+// members of their own so that trivial payloads keep them trivial
+// The union is tagged by a flag after it
+template<typename T, typename E>
+struct ResultLayout {
+    ResultUnion<T, E> storage;
     bool is_ok_value;
-    
-    T& ok_ref() { return *reinterpret_cast<T*>(&storage.ok_storage); }
-    const T& ok_ref() const { return *reinterpret_cast<const T*>(&storage.ok_storage); }
-    E& err_ref() { return *reinterpret_cast<E*>(&storage.err_storage); }
-    const E& err_ref() const { return *reinterpret_cast<const E*>(&storage.err_storage); }
-    
-    void destroy() {
+
+    RUSTY_CONSTEXPR20 bool is_ok() const { return is_ok_value; }
+
+    RUSTY_CONSTEXPR20 T& ok() { return storage.ok; }
+    RUSTY_CONSTEXPR20 const T& ok() const { return storage.ok; }
+    RUSTY_CONSTEXPR20 E& err() { return storage.err; }
+    RUSTY_CONSTEXPR20 const E& err() const { return storage.err; }
+
+    template<typename... Args>
+    RUSTY_CONSTEXPR20 void emplace_ok(Args&&... args) {
+        construct_in_place(&storage.ok, std::forward<Args>(args)...);
+        is_ok_value = true;
+    }
+
+    template<typename... Args>
+    RUSTY_CONSTEXPR20 void emplace_err(Args&&... args) {
+        construct_in_place(&storage.err, std::forward<Args>(args)...);
+        is_ok_value = false;
+    }
+
+    RUSTY_CONSTEXPR20 void destroy() {
         if (is_ok_value) {
-            ok_ref().~T();
+            storage.ok.~T();
         } else {
-            err_ref().~E();
+            storage.err.~E();
         }
     }
-    
-public:
-    // Constructors for Ok variant
-    static Result Ok(T value) {
-        Result r;
-        new (&r.storage.ok_storage) T(std::move(value));
-        r.is_ok_value = true;
-        return r;
+
+    RUSTY_CONSTEXPR20 void copy_from(const ResultLayout& other) {
+        if (other.is_ok()) {
+            emplace_ok(other.ok());
+        } else {
+            emplace_err(other.err());
+        }
     }
-    
-    // Constructors for Err variant
-    static Result Err(E error) {
-        Result r;
-        new (&r.storage.err_storage) E(std::move(error));
-        r.is_ok_value = false;
-        return r;
+
+    RUSTY_CONSTEXPR20 void move_from(ResultLayout& other) {
+        if (other.is_ok()) {
+            emplace_ok(std::move(other.ok()));
+        } else {
+            emplace_err(std::move(other.err()));
+        }
     }
-    
-    // Default constructor (creates Err with default E)
-    Result() : is_ok_value(false) {
-        new (&storage.err_storage) E();
+};
+
+// Result<void, E>: only E needs storage. When E has a niche (see
+// niche.hpp) Ok is that bit pattern and the flag disappears, so e.g.
+// Result<void, Box<Error>> is one pointer wide.
+template<typename E, bool Niche = niche_traits<E>::available>
+struct VoidResultLayout {
+    ResultUnion<char, E> storage;  // Ok holds nothing: the union stays on none
+    bool is_ok_value;
+
+    RUSTY_CONSTEXPR20 bool is_ok() const { return is_ok_value; }
+    RUSTY_CONSTEXPR20 void emplace_ok() { is_ok_value = true; }
+
+    template<typename... Args>
+    RUSTY_CONSTEXPR20 void emplace_err(Args&&... args) {
+        construct_in_place(&storage.err, std::forward<Args>(args)...);
+        is_ok_value = false;
     }
-    
-    // Copy constructor
-    Result(const Result& other) : is_ok_value(other.is_ok_value) {
-        if (is_ok_value) {
-            new (&storage.ok_storage) T(other.ok_ref());
+
+    RUSTY_CONSTEXPR20 E& err() { return storage.err; }
+    RUSTY_CONSTEXPR20 const E& err() const { return storage.err; }
+};
+
+template<typename E>
+struct VoidResultLayout<E, true> {
+    typename std::aligned_storage<sizeof(E), alignof(E)>::type err_storage;
+
+    bool is_ok() const { return niche_traits<E>::is_none(&err_storage); }
+    void emplace_ok() { niche_traits<E>::set_none(&err_storage); }
+
+    template<typename... Args>
+    void emplace_err(Args&&... args) {
+        new (&err_storage) E(std::forward<Args>(args)...);
+    }
+
+    E& err() { return *reinterpret_cast<E*>(&err_storage); }
+    const E& err() const { return *reinterpret_cast<const E*>(&err_storage); }
+};
+
+template<typename E, bool Niche>
+struct VoidResultOps : VoidResultLayout<E, Niche> {
+    RUSTY_CONSTEXPR20 void destroy() {
+        if (!this->is_ok()) this->err().~E();
+    }
+
+    RUSTY_CONSTEXPR20 void copy_from(const VoidResultOps& other) {
+        if (other.is_ok()) {
+            this->emplace_ok();
         } else {
-            new (&storage.err_storage) E(other.err_ref());
+            this->emplace_err(other.err());
         }
     }
-    
-    // Move constructor
-    Result(Result&& other) noexcept : is_ok_value(other.is_ok_value) {
-        if (is_ok_value) {
-            new (&storage.ok_storage) T(std::move(other.ok_ref()));
+
+    RUSTY_CONSTEXPR20 void move_from(VoidResultOps& other) {
+        if (other.is_ok()) {
+            this->emplace_ok();
         } else {
-            new (&storage.err_storage) E(std::move(other.err_ref()));
+            this->emplace_err(std::move(other.err()));
         }
     }
-    
-    // Copy assignment
-    Result& operator=(const Result& other) {
+};
+
+// Adds the copy/move/destroy members a non-trivial payload needs
+template<typename Layout, bool Trivial>
+struct ResultStorage : Layout {
+    RUSTY_CONSTEXPR20 ResultStorage() {}
+
+    RUSTY_CONSTEXPR20 ResultStorage(const ResultStorage& other) : Layout() {
+        this->copy_from(other);
+    }
+
+    RUSTY_CONSTEXPR20 ResultStorage(ResultStorage&& other) noexcept : Layout() {
+        this->move_from(other);
+    }
+
+    RUSTY_CONSTEXPR20 ResultStorage& operator=(const ResultStorage& other) {
         if (this != &other) {
-            destroy();
-            is_ok_value = other.is_ok_value;
-            if (is_ok_value) {
-                new (&storage.ok_storage) T(other.ok_ref());
-            } else {
-                new (&storage.err_storage) E(other.err_ref());
-            }
+            this->destroy();
+            this->copy_from(other);
         }
         return *this;
     }
-    
-    // Move assignment
-    Result& operator=(Result&& other) noexcept {
+
+    RUSTY_CONSTEXPR20 ResultStorage& operator=(ResultStorage&& other) noexcept {
         if (this != &other) {
-            destroy();
-            is_ok_value = other.is_ok_value;
-            if (is_ok_value) {
-                new (&storage.ok_storage) T(std::move(other.ok_ref()));
-            } else {
-                new (&storage.err_storage) E(std::move(other.err_ref()));
-            }
+            this->destroy();
+            this->move_from(other);
         }
         return *this;
     }
+
+    RUSTY_CONSTEXPR20 ~ResultStorage() {
+        this->destroy();
+    }
+};
+
+template<typename Layout>
+struct ResultStorage<Layout, true> : Layout {};
+
+// Selects Result's constructor that leaves the storage empty
+struct ResultUninit {};
+
+} // namespace detail
+
+template<typename T, typename E>
+class Result {
+private:
+    detail::ResultStorage<detail::ResultLayout<T, E>,
+                          detail::result_is_trivial<T, E>::value> storage;
+
+    RUSTY_CONSTEXPR20 explicit Result(detail::ResultUninit) {}
+
+    RUSTY_CONSTEXPR20 T& ok_ref() { return storage.ok(); }
+    RUSTY_CONSTEXPR20 const T& ok_ref() const { return storage.ok(); }
+    RUSTY_CONSTEXPR20 E& err_ref() { return storage.err(); }
+    RUSTY_CONSTEXPR20 const E& err_ref() const { return storage.err(); }
+
+public:
+    // Constructors for Ok variant
+    static RUSTY_CONSTEXPR20 Result Ok(T value) {
+        Result r{detail::ResultUninit()};
+        r.storage.emplace_ok(std::move(value));
+        return r;
+    }
     
-    // Destructor
-    ~Result() {
-        destroy();
+    // Constructors for Err variant
+    static RUSTY_CONSTEXPR20 Result Err(E error) {
+        Result r{detail::ResultUninit()};
+        r.storage.emplace_err(std::move(error));
+        return r;
     }
     
+    // Default constructor (creates Err with default E)
+    RUSTY_CONSTEXPR20 Result() {
+        storage.emplace_err();
+    }
+    
+    // Copy, move and destruction follow T and E: trivial when both are
+    // trivially copyable
+    
     // Check if Result is Ok
-    bool is_ok() const { return is_ok_value; }
+    RUSTY_CONSTEXPR20 bool is_ok() const { return storage.is_ok(); }
     
     // Check if Result is Err
-    bool is_err() const { return !is_ok_value; }
+    RUSTY_CONSTEXPR20 bool is_err() const { return !storage.is_ok(); }
     
     // Unwrap Ok value (panics if Err)
-    T unwrap() {
-        if (!is_ok_value) {
+    RUSTY_CONSTEXPR20 T unwrap() {
+        if (!is_ok()) {
             throw std::runtime_error("Called unwrap on an Err value");
         }
         return std::move(ok_ref());
     }
     
     // Unwrap Err value (panics if Ok)
-    E unwrap_err() {
-        if (is_ok_value) {
+    RUSTY_CONSTEXPR20 E unwrap_err() {
+        if (is_ok()) {
             throw std::runtime_error("Called unwrap_err on an Ok value");
         }
         return std::move(err_ref());
     }
     
     // Unwrap Ok value or return default
-    T unwrap_or(T default_value) {
-        if (is_ok_value) {
+    RUSTY_CONSTEXPR20 T unwrap_or(T default_value) {
+        if (is_ok()) {
             return std::move(ok_ref());
         }
         return std::move(default_value);
@@ -149,9 +278,9 @@ public:
     
     // Map over Ok value
     template<typename F>
-    auto map(F f) -> Result<decltype(f(std::declval<T>())), E> {
+    RUSTY_CONSTEXPR20 auto map(F f) -> Result<decltype(f(std::declval<T>())), E> {
         using NewT = decltype(f(std::declval<T>()));
-        if (is_ok_value) {
+        if (is_ok()) {
             return Result<NewT, E>::Ok(f(ok_ref()));
         } else {
             return Result<NewT, E>::Err(err_ref());
@@ -160,9 +289,9 @@ public:
     
     // Map over Err value
     template<typename F>
-    auto map_err(F f) -> Result<T, decltype(f(std::declval<E>()))> {
+    RUSTY_CONSTEXPR20 auto map_err(F f) -> Result<T, decltype(f(std::declval<E>()))> {
         using NewE = decltype(f(std::declval<E>()));
-        if (is_ok_value) {
+        if (is_ok()) {
             return Result<T, NewE>::Ok(ok_ref());
         } else {
             return Result<T, NewE>::Err(f(err_ref()));
@@ -171,9 +300,9 @@ public:
     
     // Chain operations that return Result
     template<typename F>
-    auto and_then(F f) -> decltype(f(std::declval<T>())) {
+    RUSTY_CONSTEXPR20 auto and_then(F f) -> decltype(f(std::declval<T>())) {
         using ReturnType = decltype(f(std::declval<T>()));
-        if (is_ok_value) {
+        if (is_ok()) {
             return f(ok_ref());
         } else {
             return ReturnType::Err(err_ref());
@@ -182,8 +311,8 @@ public:
     
     // Provide alternative Result if this is Err
     template<typename F>
-    Result or_else(F f) {
-        if (is_ok_value) {
+    RUSTY_CONSTEXPR20 Result or_else(F f) {
+        if (is_ok()) {
             return *this;
         } else {
             return f(err_ref());
@@ -191,8 +320,8 @@ public:
     }
     
     // Explicit bool conversion - true if Ok
-    explicit operator bool() const {
-        return is_ok_value;
+    RUSTY_CONSTEXPR20 explicit operator bool() const {
+        return is_ok();
     }
 };
 
@@ -200,91 +329,61 @@ public:
 template<typename E>
 class Result<void, E> {
 private:
-    union Storage {
-        typename std::aligned_storage<sizeof(E), alignof(E)>::type err_storage;
-        
-        Storage() {}
-        ~Storage() {}
-    } storage;
-    
-    bool is_ok_value;
-    
-    E& err_ref() { return *reinterpret_cast<E*>(&storage.err_storage); }
-    const E& err_ref() const { return *reinterpret_cast<const E*>(&storage.err_storage); }
-    
-    void destroy() {
-        if (!is_ok_value) {
-            err_ref().~E();
-        }
-    }
-    
+    detail::ResultStorage<detail::VoidResultOps<E, niche_traits<E>::available>,
+                          detail::result_is_trivial<void, E>::value> storage;
+
+    RUSTY_CONSTEXPR20 explicit Result(detail::ResultUninit) {}
+
+    RUSTY_CONSTEXPR20 E& err_ref() { return storage.err(); }
+    RUSTY_CONSTEXPR20 const E& err_ref() const { return storage.err(); }
+
 public:
     // Constructor for Ok variant
-    static Result Ok() {
-        Result r;
-        r.is_ok_value = true;
-        return r;
+    static RUSTY_CONSTEXPR20 Result Ok() {
+        return Result();
     }
     
     // Constructor for Err variant
-    static Result Err(E error) {
-        Result r;
-        new (&r.storage.err_storage) E(std::move(error));
-        r.is_ok_value = false;
+    static RUSTY_CONSTEXPR20 Result Err(E error) {
+        Result r{detail::ResultUninit()};
+        r.storage.emplace_err(std::move(error));
         return r;
     }
     
     // Default constructor (creates Ok)
-    Result() : is_ok_value(true) {}
-    
-    // Copy constructor
-    Result(const Result& other) : is_ok_value(other.is_ok_value) {
-        if (!is_ok_value) {
-            new (&storage.err_storage) E(other.err_ref());
-        }
-    }
-    
-    // Move constructor
-    Result(Result&& other) noexcept : is_ok_value(other.is_ok_value) {
-        if (!is_ok_value) {
-            new (&storage.err_storage) E(std::move(other.err_ref()));
-        }
-    }
-    
-    // Destructor
-    ~Result() {
-        destroy();
+    RUSTY_CONSTEXPR20 Result() {
+        storage.emplace_ok();
     }
     
     // Check if Result is Ok
-    bool is_ok() const { return is_ok_value; }
+    RUSTY_CONSTEXPR20 bool is_ok() const { return storage.is_ok(); }
     
     // Check if Result is Err
-    bool is_err() const { return !is_ok_value; }
+    RUSTY_CONSTEXPR20 bool is_err() const { return !storage.is_ok(); }
     
     // Unwrap Err value (panics if Ok)
-    E unwrap_err() {
-        if (is_ok_value) {
+    RUSTY_CONSTEXPR20 E unwrap_err() {
+        if (is_ok()) {
             throw std::runtime_error("Called unwrap_err on an Ok value");
         }
         return std::move(err_ref());
     }
     
     // Explicit bool conversion - true if Ok
-    explicit operator bool() const {
-        return is_ok_value;
+    RUSTY_CONSTEXPR20 explicit operator bool() const {
+        return is_ok();
     }
 };
 
 // Helper function to create Ok Result
 template<typename T, typename E>
-Result<T, E> Ok(T value) {
+RUSTY_CONSTEXPR20 Result<T, E> Ok(T value) {
     return Result<T, E>::Ok(std::move(value));
 }
 
 // Helper function to create Err Result
 template<typename T, typename E>
-Result<T, E> Err(E error) {
+RUSTY_CONSTEXPR20 Result<T, E> Err(E error) {
     return Result<T, E>::Err(std::move(error));
 }
 
@@ -0,0 +1,578 @@
+#ifndef RUSTY_ROPE_HPP
+#define RUSTY_ROPE_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include "arc.hpp"
+#include "bounds.hpp"
+#include "memchr.hpp"
+#include "option.hpp"
+#include "string.hpp"
+#include "vec.hpp"
+
+// Rope - A string kept as a B-tree of chunks, for editing large text
+// (Rust: the ropey / crop crates)
+//
+// Guarantees:
+// - insert, remove and slice are O(log n): an edit rewrites the chunks at
+//   its ends and the nodes on their paths, never the rest of the text
+//   (String::insert and drain move the whole tail)
+// - Leaves hold chunks of up to 1024 bytes (a few more when a multi-byte
+//   char straddles a split), internal nodes up to 16 children; all leaves
+//   are at the same depth
+// - Nodes are shared through Arc: clone() is O(1), and an edit copies only
+//   the nodes on its path that another clone still holds (copy-on-write),
+//   so clones may be kept as snapshots or read from other threads
+// - Every node caches its length and newline count, so converting between
+//   byte offsets and line numbers is O(log n) as well
+// - Offsets are in bytes and, as for String, must fall on UTF-8 char
+//   boundaries. Chunks are only split on char boundaries, so each chunk of
+//   valid UTF-8 text is itself valid UTF-8.
+
+// @safe
+namespace rusty {
+
+namespace detail {
+
+constexpr size_t ROPE_CHUNK_MAX = 1024;
+constexpr size_t ROPE_CHUNK_MIN = ROPE_CHUNK_MAX / 4;
+constexpr size_t ROPE_MAX_CHILDREN = 16;
+constexpr size_t ROPE_MIN_CHILDREN = ROPE_MAX_CHILDREN / 4;
+constexpr size_t ROPE_MAX_HEIGHT = 64;
+
+// The loop has no data-dependent branch, so compilers vectorize it
+inline size_t count_newlines(const char* bytes, size_t len) {
+    size_t count = 0;
+    for (size_t i = 0; i < len; i++) {
+        count += static_cast<size_t>(bytes[i] == '\n');
+    }
+    return count;
+}
+
+// The char boundary at or just before pos; a UTF-8 sequence has at most
+// three continuation bytes, so invalid input cannot walk further back
+inline size_t floor_char_boundary(const char* bytes, size_t len, size_t pos) {
+    for (int step = 0; step < 3 && pos > 0 && pos < len; step++) {
+        if (!utf8_is_cont(static_cast<unsigned char>(bytes[pos]))) break;
+        pos--;
+    }
+    return pos;
+}
+
+// How many of remaining items go in the next group when cutting a run into
+// groups of at most max, so that the last group is not left below min
+inline size_t rope_group(size_t remaining, size_t max, size_t min) {
+    if (remaining <= max) return remaining;
+    if (remaining < max + min) return remaining / 2;
+    return max;
+}
+
+} // namespace detail
+
+class Rope {
+private:
+    struct Node;
+    using NodePtr = Arc<Node>;
+
+    static constexpr size_t CHUNK_MAX = detail::ROPE_CHUNK_MAX;
+    static constexpr size_t CHUNK_MIN = detail::ROPE_CHUNK_MIN;
+    static constexpr size_t MAX_CHILDREN = detail::ROPE_MAX_CHILDREN;
+    static constexpr size_t MIN_CHILDREN = detail::ROPE_MIN_CHILDREN;
+
+    struct Node {
+        size_t len;              // Bytes in the subtree
+        size_t lines;            // '\n' bytes in the subtree
+        size_t height;           // 0 for a leaf
+        Vec<char> text;          // A leaf's chunk
+        Vec<NodePtr> children;   // An internal node's subtrees
+
+        explicit Node(size_t h) : len(0), lines(0), height(h) {}
+
+        // For Arc::make_mut on a node another rope still holds
+        Node clone() const {
+            Node node(height);
+            node.len = len;
+            node.lines = lines;
+            if (is_leaf()) {
+                node.text = Vec<char>::with_capacity(CHUNK_MAX);
+                node.text.extend_from_slice(text.as_ptr(), text.len());
+            } else {
+                node.children = children.clone();
+            }
+            return node;
+        }
+
+        bool is_leaf() const { return height == 0; }
+
+        bool is_underfull() const {
+            return is_leaf() ? len < CHUNK_MIN : children.len() < MIN_CHILDREN;
+        }
+
+        void set_text(const char* bytes, size_t n) {
+            text.clear();
+            text.extend_from_slice(bytes, n);
+            len = n;
+            lines = detail::count_newlines(bytes, n);
+        }
+
+        void recount() {
+            len = 0;
+            lines = 0;
+            for (size_t i = 0; i < children.len(); i++) {
+                len += children[i]->len;
+                lines += children[i]->lines;
+            }
+        }
+    };
+
+    NodePtr root_;  // Empty when the rope is
+
+    static NodePtr leaf(const char* bytes, size_t n) {
+        Node node(0);
+        node.text = Vec<char>::with_capacity(CHUNK_MAX);
+        node.set_text(bytes, n);
+        return NodePtr::new_(std::move(node));
+    }
+
+    static NodePtr internal(Vec<NodePtr> children) {
+        Node node(children[0]->height + 1);
+        node.children = std::move(children);
+        node.recount();
+        return NodePtr::new_(std::move(node));
+    }
+
+    // Where to cut total bytes into two chunks: the char boundary nearest
+    // the middle
+    static size_t split_point(const char* bytes, size_t total) {
+        return detail::floor_char_boundary(bytes, total, total / 2);
+    }
+
+    // Bytes of text from pos that go into the next chunk
+    static size_t piece_len(str text, size_t pos) {
+        size_t n = detail::rope_group(text.len() - pos, CHUNK_MAX, CHUNK_MIN);
+        return pos + n == text.len() ? n
+                                     : detail::floor_char_boundary(text.as_ptr() + pos, text.len() - pos, n);
+    }
+
+    // Insert n <= CHUNK_MAX bytes at offset at of node. Returns the new
+    // right sibling when node had to split, or an empty pointer.
+    static NodePtr insert_into(Node& node, size_t at, const char* bytes, size_t n) {
+        node.len += n;
+        node.lines += detail::count_newlines(bytes, n);
+        if (node.is_leaf()) {
+            size_t old_len = node.text.len();
+            if (old_len + n <= CHUNK_MAX) {
+                node.text.insert_from_slice(at, bytes, n);
+                return NodePtr();
+            }
+            // Too long for one chunk: join and cut in two near the middle
+            char joined[2 * CHUNK_MAX + 8];
+            size_t total = old_len + n;
+            std::memcpy(joined, node.text.as_ptr(), at);
+            std::memcpy(joined + at, bytes, n);
+            std::memcpy(joined + at + n, node.text.as_ptr() + at, old_len - at);
+            size_t mid = split_point(joined, total);
+            node.set_text(joined, mid);
+            return leaf(joined + mid, total - mid);
+        }
+
+        // The first child that at falls in or at the end of
+        size_t i = 0;
+        while (i + 1 < node.children.len() && at > node.children[i]->len) {
+            at -= node.children[i]->len;
+            i++;
+        }
+        NodePtr split = insert_into(node.children[i].make_mut(), at, bytes, n);
+        if (!split) return NodePtr();
+        node.children.insert(i + 1, std::move(split));
+        if (node.children.len() <= MAX_CHILDREN) return NodePtr();
+
+        // Move the upper half to a new sibling
+        size_t half = node.children.len() / 2;
+        Vec<NodePtr> upper = Vec<NodePtr>::with_capacity(MAX_CHILDREN + 1);
+        for (size_t k = half; k < node.children.len(); k++) {
+            upper.push(std::move(node.children[k]));
+        }
+        node.children.truncate(half);
+        node.recount();
+        return internal(std::move(upper));
+    }
+
+    // Remove bytes [start, end) of node, which keeps some of its bytes.
+    // Children left underfull are merged with a neighbour; node itself
+    // may be left underfull, for its parent to fix.
+    static void remove_from(Node& node, size_t start, size_t end) {
+        if (node.is_leaf()) {
+            char* bytes = node.text.as_mut_ptr();
+            node.lines -= detail::count_newlines(bytes + start, end - start);
+            std::memmove(bytes + start, bytes + end, node.text.len() - end);
+            node.text.truncate(node.text.len() - (end - start));
+            node.len = node.text.len();
+            return;
+        }
+
+        // Children wholly inside the range are dropped, the (at most two)
+        // that straddle an end are trimmed, and end up side by side
+        size_t offset = 0;
+        size_t first_trimmed = SIZE_MAX;
+        size_t trimmed = 0;
+        size_t i = 0;
+        while (i < node.children.len() && offset < end) {
+            size_t child_len = node.children[i]->len;
+            size_t lo = std::max(start, offset);
+            size_t hi = std::min(end, offset + child_len);
+            if (lo < hi) {
+                if (lo == offset && hi == offset + child_len) {
+                    node.children.remove(i);
+                    offset += child_len;
+                    continue;
+                }
+                remove_from(node.children[i].make_mut(), lo - offset, hi - offset);
+                if (trimmed++ == 0) first_trimmed = i;
+            }
+            offset += child_len;
+            i++;
+        }
+        for (size_t k = first_trimmed + trimmed; trimmed > 0 && k-- > first_trimmed;) {
+            fix_child(node, k);
+        }
+        node.recount();
+    }
+
+    // Merge child i with a neighbour if it is underfull
+    static void fix_child(Node& node, size_t i) {
+        if (node.children.len() < 2 || i >= node.children.len() ||
+            !node.children[i]->is_underfull()) {
+            return;
+        }
+        merge_children(node, i + 1 < node.children.len() ? i : i - 1);
+    }
+
+    // Merge children i and i + 1 into one node, or share their contents
+    // evenly between them when that does not fit
+    static void merge_children(Node& parent, size_t i) {
+        Node& left = parent.children[i].make_mut();
+        const Node& right = *parent.children[i + 1];
+
+        if (left.is_leaf()) {
+            size_t total = left.len + right.len;
+            if (total <= CHUNK_MAX) {
+                left.text.extend_from_slice(right.text.as_ptr(), right.len);
+                left.len = total;
+                left.lines += right.lines;
+                parent.children.remove(i + 1);
+                return;
+            }
+            char joined[2 * CHUNK_MAX + 8];
+            std::memcpy(joined, left.text.as_ptr(), left.len);
+            std::memcpy(joined + left.len, right.text.as_ptr(), right.len);
+            size_t mid = split_point(joined, total);
+            left.set_text(joined, mid);
+            parent.children[i + 1] = leaf(joined + mid, total - mid);
+            return;
+        }
+
+        size_t total = left.children.len() + right.children.len();
+        if (total <= MAX_CHILDREN) {
+            size_t seam = left.children.len();
+            for (size_t k = 0; k < right.children.len(); k++) {
+                left.children.push(right.children[k].clone());
+            }
+            parent.children.remove(i + 1);
+            // The subtrees now meeting at the seam may be underfull too
+            if (left.children[seam - 1]->is_underfull() || left.children[seam]->is_underfull()) {
+                merge_children(left, seam - 1);
+            }
+            left.recount();
+            return;
+        }
+        Vec<NodePtr> all = Vec<NodePtr>::with_capacity(total);
+        for (size_t k = 0; k < left.children.len(); k++) all.push(std::move(left.children[k]));
+        for (size_t k = 0; k < right.children.len(); k++) all.push(right.children[k].clone());
+        Node& other = parent.children[i + 1].make_mut();
+        left.children.clear();
+        other.children.clear();
+        size_t half = total / 2;
+        for (size_t k = 0; k < total; k++) {
+            (k < half ? left : other).children.push(std::move(all[k]));
+        }
+        left.recount();
+        other.recount();
+    }
+
+    void insert_piece(size_t at, const char* bytes, size_t n) {
+        if (!root_) {
+            root_ = leaf(bytes, n);
+            return;
+        }
+        NodePtr split = insert_into(root_.make_mut(), at, bytes, n);
+        if (split) {
+            Vec<NodePtr> children = Vec<NodePtr>::with_capacity(MAX_CHILDREN + 1);
+            children.push(std::move(root_));
+            children.push(std::move(split));
+            root_ = internal(std::move(children));
+        }
+    }
+
+public:
+    // Chunks - The rope's text in order, one chunk at a time. Borrows the
+    // rope, which must not be modified until the walk is done.
+    class Chunks {
+    private:
+        friend class Rope;
+
+        // Path from the root to the next chunk, with the next child to
+        // visit in each internal node
+        const Node* nodes_[detail::ROPE_MAX_HEIGHT];
+        size_t next_[detail::ROPE_MAX_HEIGHT];
+        size_t depth_;
+
+        explicit Chunks(const Node* root) : depth_(0) {
+            if (root) {
+                nodes_[0] = root;
+                next_[0] = 0;
+                depth_ = 1;
+            }
+        }
+
+    public:
+        Chunks() : depth_(0) {}
+
+        // @lifetime: (&'a mut) -> &'a
+        Option<str> next() {
+            while (depth_ > 0) {
+                const Node* node = nodes_[depth_ - 1];
+                if (node->is_leaf()) {
+                    depth_--;
+                    return Some(str(node->text.as_ptr(), node->text.len()));
+                }
+                size_t& next = next_[depth_ - 1];
+                if (next == node->children.len()) {
+                    depth_--;
+                    continue;
+                }
+                assert(depth_ < detail::ROPE_MAX_HEIGHT);
+                nodes_[depth_] = &*node->children[next++];
+                next_[depth_] = 0;
+                depth_++;
+            }
+            return None;
+        }
+
+        using iterator = detail::StrPieces<Chunks>;
+        // @lifetime: (&'a) -> &'a
+        iterator begin() const { return iterator(*this); }
+        // @lifetime: (&'a) -> &'a
+        iterator end() const { return iterator(); }
+    };
+
+    Rope() {}
+
+    // @lifetime: owned
+    static Rope new_() { return Rope(); }
+
+    // Build a rope from text in O(n), with full chunks and nodes
+    // @lifetime: owned
+    static Rope from(str text) {
+        Rope rope;
+        if (text.is_empty()) return rope;
+        Vec<NodePtr> level;
+        for (size_t pos = 0; pos < text.len();) {
+            size_t n = piece_len(text, pos);
+            level.push(leaf(text.as_ptr() + pos, n));
+            pos += n;
+        }
+        while (level.len() > 1) {
+            Vec<NodePtr> parents;
+            for (size_t pos = 0; pos < level.len();) {
+                size_t n = detail::rope_group(level.len() - pos, MAX_CHILDREN, MIN_CHILDREN);
+                Vec<NodePtr> children = Vec<NodePtr>::with_capacity(MAX_CHILDREN + 1);
+                for (size_t k = 0; k < n; k++) children.push(std::move(level[pos + k]));
+                parents.push(internal(std::move(children)));
+                pos += n;
+            }
+            level = std::move(parents);
+        }
+        rope.root_ = std::move(level[0]);
+        return rope;
+    }
+
+    // O(1): the clone shares every node until one of the two is edited
+    // @lifetime: owned
+    Rope clone() const { return *this; }
+
+    // Length in bytes
+    size_t len() const { return root_ ? root_->len : 0; }
+    bool is_empty() const { return !root_; }
+
+    // Number of lines: one more than the number of '\n' bytes, so a
+    // trailing newline is followed by an empty last line
+    size_t len_lines() const { return (root_ ? root_->lines : 0) + 1; }
+
+    // Byte at offset idx, found in O(log n)
+    char byte(size_t idx) const {
+        RUSTY_BOUNDS_CHECK(idx < len(), "rope index out of bounds");
+        const Node* node = &*root_;
+        while (!node->is_leaf()) {
+            size_t i = 0;
+            while (idx >= node->children[i]->len) {
+                idx -= node->children[i]->len;
+                i++;
+            }
+            node = &*node->children[i];
+        }
+        return node->text[idx];
+    }
+
+    // Insert text at byte offset at. Text longer than a chunk goes in one
+    // chunk at a time.
+    void insert(size_t at, str text) {
+        RUSTY_BOUNDS_CHECK(at <= len(), "rope insert index out of bounds");
+        for (size_t pos = 0; pos < text.len();) {
+            size_t n = piece_len(text, pos);
+            insert_piece(at + pos, text.as_ptr() + pos, n);
+            pos += n;
+        }
+    }
+
+    void push_str(str text) { insert(len(), text); }
+
+    // Remove bytes [start, end)
+    void remove(size_t start, size_t end) {
+        RUSTY_BOUNDS_CHECK(start <= end && end <= len(), "rope range out of bounds");
+        if (start == end) return;
+        if (end - start == len()) {
+            root_ = NodePtr();
+            return;
+        }
+        remove_from(root_.make_mut(), start, end);
+        // Drop roots left with a single child
+        while (!root_->is_leaf() && root_->children.len() == 1) {
+            NodePtr child = root_->children[0].clone();
+            root_ = std::move(child);
+        }
+    }
+
+    // Bytes [start, end) as a new rope, sharing all but O(log n) nodes
+    // @lifetime: owned
+    Rope slice(size_t start, size_t end) const {
+        RUSTY_BOUNDS_CHECK(start <= end && end <= len(), "rope range out of bounds");
+        Rope part = clone();
+        part.remove(end, len());
+        part.remove(0, start);
+        return part;
+    }
+
+    // Byte offset where line starts (line <= number of '\n' bytes)
+    size_t line_to_byte(size_t line) const {
+        RUSTY_BOUNDS_CHECK(line < len_lines(), "rope line out of bounds");
+        if (line == 0) return 0;
+        const Node* node = &*root_;
+        size_t offset = 0;
+        while (!node->is_leaf()) {
+            size_t i = 0;
+            while (node->children[i]->lines < line) {
+                line -= node->children[i]->lines;
+                offset += node->children[i]->len;
+                i++;
+            }
+            node = &*node->children[i];
+        }
+        const char* bytes = node->text.as_ptr();
+        size_t pos = 0;
+        while (true) {
+            pos += find_byte(bytes + pos, node->text.len() - pos, '\n') + 1;
+            if (--line == 0) return offset + pos;
+        }
+    }
+
+    // Line that byte offset idx is on (idx <= len())
+    size_t byte_to_line(size_t idx) const {
+        RUSTY_BOUNDS_CHECK(idx <= len(), "rope index out of bounds");
+        if (!root_) return 0;
+        const Node* node = &*root_;
+        size_t line = 0;
+        while (!node->is_leaf()) {
+            const Node* next = nullptr;
+            for (size_t i = 0; i < node->children.len(); i++) {
+                const Node* child = &*node->children[i];
+                if (idx < child->len) {
+                    next = child;
+                    break;
+                }
+                idx -= child->len;
+                line += child->lines;
+            }
+            if (!next) return line;
+            node = next;
+        }
+        return line + detail::count_newlines(node->text.as_ptr(), idx);
+    }
+
+    // Line number line, with its '\n' if it has one
+    // @lifetime: owned
+    Rope line(size_t line) const {
+        size_t start = line_to_byte(line);
+        size_t end = line + 1 < len_lines() ? line_to_byte(line + 1) : len();
+        return slice(start, end);
+    }
+
+    // @lifetime: (&'a) -> &'a
+    Chunks chunks() const { return Chunks(root_ ? &*root_ : nullptr); }
+
+    // @lifetime: owned
+    String to_string() const {
+        String out = String::with_capacity(len());
+        Chunks walk = chunks();
+        for (Option<str> chunk = walk.next(); chunk.is_some(); chunk = walk.next()) {
+            out.push_str(chunk.unwrap());
+        }
+        return out;
+    }
+
+    bool operator==(const Rope& other) const {
+        if (len() != other.len()) return false;
+        Chunks a = chunks();
+        Chunks b = other.chunks();
+        str x, y;
+        while (true) {
+            if (x.is_empty()) {
+                Option<str> chunk = a.next();
+                if (chunk.is_none()) return true;
+                x = chunk.unwrap();
+            }
+            if (y.is_empty()) y = b.next().unwrap();
+            size_t n = std::min(x.len(), y.len());
+            if (std::memcmp(x.as_ptr(), y.as_ptr(), n) != 0) return false;
+            x = x.slice(n, x.len());
+            y = y.slice(n, y.len());
+        }
+    }
+
+    bool operator==(str text) const {
+        if (len() != text.len()) return false;
+        size_t pos = 0;
+        Chunks walk = chunks();
+        for (Option<str> chunk = walk.next(); chunk.is_some(); chunk = walk.next()) {
+            str c = chunk.unwrap();
+            if (std::memcmp(c.as_ptr(), text.as_ptr() + pos, c.len()) != 0) return false;
+            pos += c.len();
+        }
+        return true;
+    }
+
+    bool operator!=(const Rope& other) const { return !(*this == other); }
+    bool operator!=(str text) const { return !(*this == text); }
+};
+
+constexpr size_t Rope::CHUNK_MAX;
+constexpr size_t Rope::CHUNK_MIN;
+constexpr size_t Rope::MAX_CHILDREN;
+constexpr size_t Rope::MIN_CHILDREN;
+
+} // namespace rusty
+
+#endif // RUSTY_ROPE_HPP
@@ -0,0 +1,306 @@
+// rusty.cppm - The rusty library as a C++20 named module
+//
+//   import rusty;
+//   rusty::Vec<int> v = rusty::vec_of({1, 2, 3});
+//
+// The headers are parsed once, when this interface unit is built; every
+// importing TU then reads the compiled module instead of ~95k lines of
+// headers. Build it with add_rusty_module() from the cmake helpers: it
+// needs CMake 3.28 or later and a compiler that can re-export declarations
+// from the global module fragment (Clang 16 or later; GCC 12 cannot).
+//
+// Configuration macros (RUSTY_BOUNDS_CHECKS, RUSTY_STATS, RUSTY_HASHMAP_SWAR,
+// ...) must be defined when the module is built; they do not cross an
+// import. Macros such as RUSTY_BOUNDS_CHECK are not exported either, so
+// code that uses them keeps including the headers.
+module;
+
+#include "rusty.hpp"
+
+export module rusty;
+
+export namespace rusty {
+
+// Allocation
+using rusty::Global;
+using rusty::AllocError;
+using rusty::AllocKind;
+using rusty::ALLOC_KINDS;
+using rusty::alloc_kind_name;
+using rusty::AllocEvent;
+using rusty::AllocObserver;
+using rusty::set_alloc_observer;
+using rusty::alloc_observer;
+using rusty::AllocSite;
+using rusty::AllocTally;
+using rusty::Arena;
+using rusty::ArenaBox;
+using rusty::ArenaAlloc;
+
+// Owning and shared pointers
+using rusty::Box;
+using rusty::box;
+using rusty::make_box;
+using rusty::Rc;
+using rusty::Weak;
+using rusty::rc;
+using rusty::make_rc;
+using rusty::Arc;
+using rusty::ArcWeak;
+using rusty::CacheAlignedArc;
+using rusty::arc;
+using rusty::make_arc;
+using rusty::ArcSwap;
+using rusty::Pool;
+using rusty::PoolBox;
+using rusty::pool_box;
+using rusty::BoxSlice;
+using rusty::RcSlice;
+using rusty::ArcSlice;
+using rusty::ArcStr;
+using rusty::from_raw;
+using rusty::box_from_raw;
+using rusty::arc_from_box;
+using rusty::rc_from_box;
+using rusty::Boxed;
+using rusty::Shared;
+using rusty::RefCounted;
+
+// Locks
+using rusty::Mutex;
+using rusty::MutexGuard;
+using rusty::RwLock;
+using rusty::RwLockReadGuard;
+using rusty::RwLockWriteGuard;
+
+// Option and Result
+using rusty::None_t;
+using rusty::None;
+using rusty::Option;
+using rusty::Some;
+using rusty::Result;
+using rusty::Ok;
+using rusty::Err;
+using rusty::ResultVoid;
+using rusty::ResultString;
+using rusty::ResultInt;
+using rusty::Cow;
+using rusty::operator==;
+using rusty::operator!=;
+
+// Traits users specialize
+using rusty::niche_traits;
+using rusty::cow_traits;
+using rusty::null_pointer_niche;
+using rusty::is_send;
+using rusty::is_sync;
+using rusty::is_trivially_relocatable;
+using rusty::relocate_n;
+using rusty::Display;
+using rusty::FxHash;
+using rusty::ConstHash;
+using rusty::Archiver;
+
+// Sequences
+using rusty::Vec;
+using rusty::VecIntoIter;
+using rusty::vec_of;
+using rusty::SmallVec;
+using rusty::CapacityError;
+using rusty::ArrayVec;
+using rusty::ArrayString;
+using rusty::SoaVec;
+using rusty::VecDeque;
+using rusty::VecDequeIntoIter;
+using rusty::BinaryHeap;
+using rusty::IndexedBinaryHeap;
+using rusty::BasicBitVec;
+using rusty::BasicFixedBitSet;
+using rusty::BitVec;
+using rusty::FixedBitSet;
+using rusty::BitOnes;
+using rusty::Slice;
+using rusty::SliceMut;
+using rusty::SliceIter;
+using rusty::SliceIterMut;
+using rusty::Chunks;
+using rusty::ChunksMut;
+using rusty::Windows;
+using rusty::BOUNDS_CHECKS;
+
+// Iterator adaptors
+using rusty::Iterator;
+using rusty::Map;
+using rusty::Filter;
+using rusty::Enumerate;
+using rusty::Zip;
+using rusty::Take;
+using rusty::Skip;
+using rusty::Chain;
+
+// Text
+using rusty::str;
+using rusty::BasicString;
+using rusty::String;
+using rusty::string;
+using rusty::Split;
+using rusty::SplitWhitespace;
+using rusty::Lines;
+using rusty::Utf8Error;
+using rusty::StringHash;
+using rusty::StringEq;
+using rusty::StringLess;
+using rusty::Rope;
+using rusty::BYTES_NPOS;
+using rusty::find_byte;
+using rusty::find_bytes;
+using rusty::FormatSpec;
+using rusty::Formatter;
+using rusty::write_fmt;
+using rusty::format;
+using rusty::to_string;
+using rusty::Symbol;
+using rusty::Interner;
+using rusty::SyncInterner;
+
+// Maps and sets
+using rusty::hash_u64;
+using rusty::hash_bytes;
+using rusty::HashMap;
+using rusty::hashmap;
+using rusty::SeparateSlots;
+using rusty::InterleavedSlots;
+using rusty::HashSet;
+using rusty::hashset;
+using rusty::hashset_with_capacity;
+using rusty::hashset_from_vec;
+using rusty::SmallMap;
+using rusty::IndexMap;
+using rusty::BTreeMap;
+using rusty::btreemap;
+using rusty::BTreeSet;
+using rusty::btreeset;
+using rusty::btreeset_from_vec;
+using rusty::Bound;
+using rusty::Included;
+using rusty::Excluded;
+using rusty::Unbounded_t;
+using rusty::Unbounded;
+using rusty::FrozenMap;
+using rusty::StaticFrozenMap;
+using rusty::make_static_frozen_map;
+using rusty::PersistentMap;
+using rusty::PersistentVec;
+using rusty::RcNodes;
+using rusty::ArcNodes;
+using rusty::ConcurrentHashMap;
+using rusty::LruCache;
+using rusty::ClockCache;
+using rusty::ShardedCache;
+using rusty::ConcurrentLruCache;
+using rusty::ConcurrentClockCache;
+using rusty::Slab;
+using rusty::SlabKey;
+
+// Threads and tasks
+using rusty::ThreadPool;
+using rusty::Scope;
+using rusty::join;
+using rusty::scope;
+using rusty::spawn;
+using rusty::ParIter;
+using rusty::current_num_threads;
+using rusty::par_iter;
+using rusty::par_iter_mut;
+using rusty::par_chunks;
+using rusty::par_chunks_mut;
+using rusty::par_range;
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+using rusty::Task;
+using rusty::Runtime;
+#endif
+
+// Files and archives
+using rusty::IoError;
+using rusty::MappedFile;
+using rusty::write_file_atomic;
+using rusty::ArchiveError;
+using rusty::Archived;
+using rusty::is_archive_pod;
+using rusty::RelPtr;
+using rusty::ArchiveWriter;
+using rusty::ArchiveBounds;
+using rusty::ArchivedString;
+using rusty::ArchivedVec;
+using rusty::ArchivedPair;
+using rusty::ArchivedOption;
+using rusty::ArchivedHashMap;
+using rusty::ArchivedBTreeMap;
+
+} // namespace rusty
+
+export namespace rusty::thread {
+using rusty::thread::Scope;
+using rusty::thread::ScopedJoinHandle;
+using rusty::thread::scope;
+} // namespace rusty::thread
+
+export namespace rusty::mpsc {
+using rusty::mpsc::SendError;
+using rusty::mpsc::RecvError;
+using rusty::mpsc::TryRecvError;
+using rusty::mpsc::Receiver;
+using rusty::mpsc::Sender;
+using rusty::mpsc::channel;
+using rusty::mpsc::sync_channel;
+} // namespace rusty::mpsc
+
+export namespace rusty::io {
+using rusty::io::Error;
+using rusty::io::MappedFile;
+using rusty::io::DEFAULT_BUF_SIZE;
+using rusty::io::IoSlice;
+using rusty::io::IoSliceMut;
+using rusty::io::File;
+using rusty::io::Stdio;
+using rusty::io::stdin_;
+using rusty::io::stdout_;
+using rusty::io::stderr_;
+using rusty::io::SliceReader;
+using rusty::io::VecWriter;
+using rusty::io::write_all;
+using rusty::io::write_all_vectored;
+using rusty::io::read_to_end;
+using rusty::io::BufReader;
+using rusty::io::BufWriter;
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && defined(__linux__)
+using rusty::io::AsyncFd;
+#endif
+} // namespace rusty::io
+
+export namespace rusty::archive {
+using rusty::archive::FORMAT_VERSION;
+using rusty::archive::FLAG_BIG_ENDIAN;
+using rusty::archive::Header;
+using rusty::archive::to_bytes;
+using rusty::archive::access_unchecked;
+using rusty::archive::access;
+using rusty::archive::deserialize;
+using rusty::archive::from_bytes;
+using rusty::archive::write_file;
+using rusty::archive::MappedArchive;
+} // namespace rusty::archive
+
+export namespace rusty::stats {
+using rusty::stats::ENABLED;
+using rusty::stats::ProbeHistogram;
+using rusty::stats::HashMapStats;
+using rusty::stats::GrowthStats;
+using rusty::stats::BTreeStats;
+using rusty::stats::GrowthTotals;
+using rusty::stats::Totals;
+using rusty::stats::totals;
+using rusty::stats::print;
+using rusty::stats::Tracked;
+using rusty::stats::dump;
+} // namespace rusty::stats
@@ -14,16 +14,53 @@
 
 // #include "rusty/std_minimal.hpp"  // Not needed with standard library
 #include "rusty/box.hpp"
+#include "rusty/pool.hpp"
 #include "rusty/arc.hpp"
+#include "rusty/arc_swap.hpp"
+#include "rusty/sync.hpp"
+#include "rusty/mpsc.hpp"
 #include "rusty/rc.hpp"
+#include "rusty/slice_ptr.hpp"
 #include "rusty/vec.hpp"
+#include "rusty/smallvec.hpp"
+#include "rusty/arrayvec.hpp"
+#include "rusty/soavec.hpp"
+#include "rusty/vecdeque.hpp"
+#include "rusty/binaryheap.hpp"
+#include "rusty/bitvec.hpp"
+#include "rusty/slice.hpp"
+#include "rusty/iter.hpp"
 #include "rusty/option.hpp"
 #include "rusty/result.hpp"
+#include "rusty/cow.hpp"
 #include "rusty/string.hpp"
+#include "rusty/rope.hpp"
+#include "rusty/format.hpp"
 #include "rusty/hashmap.hpp"
+#include "rusty/smallmap.hpp"
 #include "rusty/hashset.hpp"
+#include "rusty/indexmap.hpp"
+#include "rusty/frozen.hpp"
+#include "rusty/persistent.hpp"
 #include "rusty/btreemap.hpp"
 #include "rusty/btreeset.hpp"
+#include "rusty/arena.hpp"
+#include "rusty/slab.hpp"
+#include "rusty/concurrent_hashmap.hpp"
+#include "rusty/lru.hpp"
+#include "rusty/concurrent_cache.hpp"
+#include "rusty/marker.hpp"
+#include "rusty/thread.hpp"
+#include "rusty/thread_pool.hpp"
+#include "rusty/par_iter.hpp"
+#include "rusty/task.hpp"  // empty before C++20
+#include "rusty/interner.hpp"
+#include "rusty/mmap.hpp"
+#include "rusty/io.hpp"
+#include "rusty/archive.hpp"
+#include "rusty/stats.hpp"
+#include "rusty/alloc_observer.hpp"
+#include "rusty/bounds.hpp"
 
 // Convenience aliases in rusty namespace
 // @safe
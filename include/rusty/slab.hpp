@@ -0,0 +1,388 @@
+#ifndef RUSTY_SLAB_HPP
+#define RUSTY_SLAB_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>  // for std::hash
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include "alloc.hpp"
+#include "fwd.hpp"
+#include "hash.hpp"
+#include "iter.hpp"
+#include "option.hpp"
+#include "relocate.hpp"
+#include "traits.hpp"
+#include "vec.hpp"
+
+// Slab<T> - Values in one contiguous Vec, addressed by generational keys
+// Equivalent to Rust's slotmap::SlotMap (or a generational arena)
+//
+// Guarantees:
+// - insert, remove and lookup are O(1); a removed slot goes on a free
+//   list and is reused by the next insert, with no per-value allocation
+// - A SlabKey is two integers: the slot index and the slot's generation.
+//   Removing a value bumps its slot's generation, so keys to it stop
+//   matching; a stale key finds nothing instead of a newer value
+// - Keys are plain values: graphs and cyclic structures hold keys to
+//   each other instead of Rc webs or raw pointers, and every access goes
+//   through the slab, so the borrow rules stay those of the slab itself
+//
+// A slot's generation is odd while it holds a value and even while it is
+// free. It is 32 bits and wraps, so a key could only match again after
+// 2^31 removals from one slot.
+
+// @safe
+namespace rusty {
+
+// Handle to a value in a Slab
+class SlabKey {
+private:
+    uint32_t index_;
+    uint32_t generation_;
+
+public:
+    // The null key, which no slab contains
+    SlabKey() : index_(UINT32_MAX), generation_(0) {}
+    SlabKey(uint32_t index, uint32_t generation) : index_(index), generation_(generation) {}
+
+    uint32_t index() const { return index_; }
+    uint32_t generation() const { return generation_; }
+    bool is_null() const { return generation_ == 0; }
+
+    // Both halves in one integer, to store keys in other containers or
+    // on disk; from_bits(k.to_bits()) == k
+    uint64_t to_bits() const { return (uint64_t(generation_) << 32) | index_; }
+    static SlabKey from_bits(uint64_t bits) {
+        return SlabKey(static_cast<uint32_t>(bits), static_cast<uint32_t>(bits >> 32));
+    }
+
+    bool operator==(SlabKey other) const {
+        return index_ == other.index_ && generation_ == other.generation_;
+    }
+    bool operator!=(SlabKey other) const { return !(*this == other); }
+    bool operator<(SlabKey other) const { return to_bits() < other.to_bits(); }
+};
+
+template<>
+struct FxHash<SlabKey> {
+    size_t operator()(SlabKey key) const noexcept {
+        return hash_u64(key.to_bits());
+    }
+};
+
+namespace detail {
+
+// One slot of a Slab: a generation and either a value or a free-list link
+template<typename T>
+struct SlabSlot {
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    uint32_t generation;  // Odd while occupied
+    uint32_t next_free;   // Next free slot while vacant
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    SlabSlot() : generation(0), next_free(NIL) {}
+
+    SlabSlot(SlabSlot&& other) : generation(other.generation), next_free(other.next_free) {
+        if (occupied()) new (storage) T(std::move(*other.value()));
+    }
+
+    SlabSlot(const SlabSlot&) = delete;
+    SlabSlot& operator=(const SlabSlot&) = delete;
+    SlabSlot& operator=(SlabSlot&&) = delete;
+
+    ~SlabSlot() {
+        if (occupied()) value()->~T();
+    }
+
+    bool occupied() const { return (generation & 1) != 0; }
+
+    T* value() { return reinterpret_cast<T*>(storage); }
+    const T* value() const { return reinterpret_cast<const T*>(storage); }
+};
+
+template<typename T>
+constexpr uint32_t SlabSlot<T>::NIL;
+
+} // namespace detail
+
+template<typename T>
+struct is_trivially_relocatable<detail::SlabSlot<T>> : is_trivially_relocatable<T> {};
+
+template<typename T, typename Alloc>
+class Slab {
+private:
+    typedef detail::SlabSlot<T> Slot;
+    static constexpr uint32_t NIL = Slot::NIL;
+
+    Vec<Slot, Alloc> slots_;
+    uint32_t free_head_;  // Most recently freed slot, reused first
+    size_t len_;
+
+    explicit Slab(Vec<Slot, Alloc> slots) : slots_(std::move(slots)), free_head_(NIL), len_(0) {}
+
+    const Slot* find(SlabKey key) const {
+        if (key.index() >= slots_.len()) return nullptr;
+        const Slot& slot = slots_[key.index()];
+        return slot.generation == key.generation() ? &slot : nullptr;
+    }
+
+    Slot* find(SlabKey key) {
+        return const_cast<Slot*>(static_cast<const Slab*>(this)->find(key));
+    }
+
+    // Make sure the free list is non-empty; returns its head
+    uint32_t free_slot() {
+        if (free_head_ == NIL) {
+            if (slots_.len() >= NIL) throw std::length_error("Slab is full");
+            slots_.push(Slot());
+            free_head_ = static_cast<uint32_t>(slots_.len() - 1);
+        }
+        return free_head_;
+    }
+
+    // Fill the free slot at index; the value is built first so a throwing
+    // constructor leaves it free
+    template<typename... Args>
+    SlabKey occupy(uint32_t index, Args&&... args) {
+        Slot& slot = slots_[index];
+        new (slot.storage) T(std::forward<Args>(args)...);
+        free_head_ = slot.next_free;
+        slot.generation++;
+        len_++;
+        return SlabKey(index, slot.generation);
+    }
+
+    void vacate(uint32_t index) {
+        Slot& slot = slots_[index];
+        slot.value()->~T();
+        slot.generation++;
+        slot.next_free = free_head_;
+        free_head_ = index;
+        len_--;
+    }
+
+    template<typename Item, typename SlotPtr>
+    struct EntryAt {
+        static Item get(SlotPtr slot, uint32_t index) {
+            return Item(SlabKey(index, slot->generation), *slot->value());
+        }
+    };
+
+public:
+    // Iterator over the occupied slots in index order
+    template<typename Item, typename SlotPtr>
+    class SlotIter : public Iterator<SlotIter<Item, SlotPtr>, Item> {
+    private:
+        SlotPtr base_;
+        uint32_t index_;
+        size_t remaining_;  // Stop at the last value instead of the last slot
+
+    public:
+        SlotIter(SlotPtr base, size_t len) : base_(base), index_(0), remaining_(len) {}
+
+        template<typename F>
+        bool next_with(F&& f) {
+            if (remaining_ == 0) return false;
+            while (!base_[index_].occupied()) {
+                index_++;
+            }
+            remaining_--;
+            uint32_t at = index_++;
+            f(EntryAt<Item, SlotPtr>::get(base_ + at, at));
+            return true;
+        }
+
+        size_t len() const { return remaining_; }
+        size_t size_hint() const { return remaining_; }
+    };
+
+    typedef SlotIter<std::pair<SlabKey, const T&>, const Slot*> Iter;
+    typedef SlotIter<std::pair<SlabKey, T&>, Slot*> IterMut;
+
+    // Constructors
+    Slab() : slots_(), free_head_(NIL), len_(0) {}
+
+    explicit Slab(const Alloc& alloc) : slots_(Vec<Slot, Alloc>::new_in(alloc)), free_head_(NIL), len_(0) {}
+
+    // @lifetime: owned
+    static Slab new_() { return Slab(); }
+
+    // @lifetime: owned
+    static Slab new_in(const Alloc& alloc) { return Slab(alloc); }
+
+    // @lifetime: owned
+    static Slab with_capacity(size_t cap) { return Slab(Vec<Slot, Alloc>::with_capacity(cap)); }
+
+    // @lifetime: owned
+    static Slab with_capacity_in(size_t cap, const Alloc& alloc) {
+        return Slab(Vec<Slot, Alloc>::with_capacity_in(cap, alloc));
+    }
+
+    Slab(Slab&& other) noexcept
+        : slots_(std::move(other.slots_)), free_head_(other.free_head_), len_(other.len_) {
+        other.free_head_ = NIL;
+        other.len_ = 0;
+    }
+
+    Slab& operator=(Slab&& other) noexcept {
+        if (this != &other) {
+            slots_ = std::move(other.slots_);
+            free_head_ = other.free_head_;
+            len_ = other.len_;
+            other.free_head_ = NIL;
+            other.len_ = 0;
+        }
+        return *this;
+    }
+
+    Slab(const Slab&) = delete;
+    Slab& operator=(const Slab&) = delete;
+
+    size_t len() const { return len_; }
+    bool is_empty() const { return len_ == 0; }
+
+    // Values that fit without reallocating
+    size_t capacity() const { return slots_.capacity(); }
+
+    // Make room for additional more values, counting free slots
+    void reserve(size_t additional) {
+        size_t needed = len_ + additional;
+        if (needed > slots_.len()) slots_.reserve(needed);
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const Alloc& allocator() const { return slots_.allocator(); }
+
+    // Store value, returning its key
+    SlabKey insert(T value) {
+        return occupy(free_slot(), std::move(value));
+    }
+
+    template<typename... Args>
+    SlabKey emplace(Args&&... args) {
+        return occupy(free_slot(), std::forward<Args>(args)...);
+    }
+
+    // Store f(key), for values that refer to themselves. f must not
+    // modify the slab.
+    template<typename F>
+    SlabKey insert_with_key(F f) {
+        uint32_t index = free_slot();
+        SlabKey key(index, slots_[index].generation + 1);
+        return occupy(index, f(key));
+    }
+
+    // Remove and return the value for key; None if key is stale
+    // @lifetime: owned
+    Option<T> remove(SlabKey key) {
+        Slot* slot = find(key);
+        if (!slot) return None;
+        Option<T> out(std::move(*slot->value()));
+        vacate(key.index());
+        return out;
+    }
+
+    bool contains(SlabKey key) const { return find(key) != nullptr; }
+
+    // @lifetime: (&'a) -> &'a
+    Option<const T&> get(SlabKey key) const {
+        const Slot* slot = find(key);
+        if (!slot) return None;
+        return Option<const T&>(*slot->value());
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    Option<T&> get_mut(SlabKey key) {
+        Slot* slot = find(key);
+        if (!slot) return None;
+        return Option<T&>(*slot->value());
+    }
+
+    // Both values at once, for linking two nodes; None if either key is
+    // stale or both name the same value
+    // @lifetime: (&'a mut) -> &'a mut
+    Option<std::pair<T*, T*>> get_disjoint_mut(SlabKey a, SlabKey b) {
+        Slot* first = find(a);
+        Slot* second = find(b);
+        if (!first || !second || first == second) return None;
+        return Option<std::pair<T*, T*>>(std::make_pair(first->value(), second->value()));
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const T& operator[](SlabKey key) const {
+        const Slot* slot = find(key);
+        assert(slot && "Slab key is stale");
+        return *slot->value();
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    T& operator[](SlabKey key) {
+        Slot* slot = find(key);
+        assert(slot && "Slab key is stale");
+        return *slot->value();
+    }
+
+    // Keep the values for which pred(key, value) is true
+    template<typename Pred>
+    void retain(Pred pred) {
+        for (size_t i = 0; i < slots_.len(); i++) {
+            Slot& slot = slots_[i];
+            if (slot.occupied() && !pred(SlabKey(uint32_t(i), slot.generation), *slot.value())) {
+                vacate(uint32_t(i));
+            }
+        }
+    }
+
+    // Remove every value; keys from before stay stale as slots are reused
+    void clear() {
+        retain([](SlabKey, T&) { return false; });
+    }
+
+    // Items are std::pair<SlabKey, const T&>, in slot order
+    // @lifetime: (&'a) -> &'a
+    Iter iter() const { return Iter(slots_.as_ptr(), len_); }
+
+    // Items are std::pair<SlabKey, T&>
+    // @lifetime: (&'a mut) -> &'a mut
+    IterMut iter_mut() { return IterMut(slots_.as_mut_ptr(), len_); }
+
+    // Same keys for the same values; free slots keep their generations
+    // @lifetime: owned
+    Slab clone() const {
+        Slab out(Vec<Slot, Alloc>::with_capacity_in(slots_.len(), slots_.allocator()));
+        for (size_t i = 0; i < slots_.len(); i++) {
+            out.slots_.push(Slot());
+            Slot& slot = out.slots_[i];
+            const Slot& from = slots_[i];
+            if (from.occupied()) new (slot.storage) T(detail::clone_value<T>(*from.value()));
+            slot.generation = from.generation;
+            slot.next_free = from.next_free;
+        }
+        out.free_head_ = free_head_;
+        out.len_ = len_;
+        return out;
+    }
+};
+
+template<typename T, typename Alloc>
+constexpr uint32_t Slab<T, Alloc>::NIL;
+
+template<typename T, typename Alloc>
+struct is_trivially_relocatable<Slab<T, Alloc>> : is_trivially_relocatable<Alloc> {};
+
+} // namespace rusty
+
+namespace std {
+    template<>
+    struct hash<rusty::SlabKey> {
+        size_t operator()(rusty::SlabKey key) const noexcept {
+            return rusty::FxHash<rusty::SlabKey>()(key);
+        }
+    };
+}
+
+#endif // RUSTY_SLAB_HPP
@@ -0,0 +1,568 @@
+#ifndef RUSTY_SLICE_HPP
+#define RUSTY_SLICE_HPP
+
+#include <algorithm>  // for std::copy, std::reverse
+#include <cassert>
+#include <cstddef>  // for size_t
+#include <type_traits>
+#include <utility>  // for std::move, std::pair, std::swap
+#include "bounds.hpp"
+#include "iter.hpp"
+#include "marker.hpp"
+#include "option.hpp"
+#include "result.hpp"
+#include "sort.hpp"
+
+// Slice<T> / SliceMut<T> - Borrowed views of contiguous elements
+// Equivalent to Rust's &[T] and &mut [T]
+//
+// Guarantees:
+// - A slice never owns its elements; it borrows them from a Vec, an array
+//   or another slice, and every sub-slice borrows from the same source
+// - Slice<T> is a shared borrow: copyable, read-only
+// - SliceMut<T> is an exclusive borrow: move-only, so two live SliceMuts
+//   never alias; split_at_mut() and chunks_mut() hand out disjoint pieces
+//   that can go to different threads
+// - Indexing follows the bounds-check policy in bounds.hpp; get() returns
+//   None instead
+//
+// As with Rust references, the source must outlive the slice and must not
+// be resized while a slice of it is alive; the @lifetime annotations let
+// the checker enforce this.
+
+// @safe
+namespace rusty {
+
+template<typename T>
+class Slice;
+
+template<typename T>
+class SliceMut;
+
+namespace detail {
+
+// Range-for adaptor over a lazy slice iterator exposing next()
+template<typename Iter, typename Item>
+class SlicePieces {
+private:
+    Iter iter_;
+    Item current_;
+    bool done_;
+
+public:
+    SlicePieces() : done_(true) {}
+    explicit SlicePieces(const Iter& iter) : iter_(iter), done_(false) {
+        ++*this;
+    }
+
+    Item& operator*() { return current_; }
+
+    SlicePieces& operator++() {
+        Option<Item> piece = iter_.next();
+        done_ = piece.is_none();
+        if (!done_) current_ = piece.unwrap();
+        return *this;
+    }
+
+    bool operator!=(const SlicePieces& other) const { return done_ != other.done_; }
+    bool operator==(const SlicePieces& other) const { return done_ == other.done_; }
+};
+
+} // namespace detail
+
+// Element-by-element iterator (Rust's slice::Iter)
+template<typename T>
+class SliceIter : public Iterator<SliceIter<T>, const T&> {
+private:
+    const T* pos_;
+    const T* end_;
+
+public:
+    SliceIter(const T* begin, const T* end) : pos_(begin), end_(end) {}
+
+    template<typename F>
+    bool next_with(F&& f) {
+        if (pos_ == end_) return false;
+        f(*pos_++);
+        return true;
+    }
+
+    // @lifetime: (&'a mut) -> &'a
+    Option<const T&> next_back() {
+        if (pos_ == end_) return None;
+        return Option<const T&>(*--end_);
+    }
+
+    size_t len() const { return static_cast<size_t>(end_ - pos_); }
+    size_t size_hint() const { return len(); }
+
+    // @lifetime: (&'a) -> &'a
+    const T* begin() const { return pos_; }
+    // @lifetime: (&'a) -> &'a
+    const T* end() const { return end_; }
+};
+
+// Mutable element-by-element iterator (Rust's slice::IterMut)
+template<typename T>
+class SliceIterMut : public Iterator<SliceIterMut<T>, T&> {
+private:
+    T* pos_;
+    T* end_;
+
+public:
+    SliceIterMut(T* begin, T* end) : pos_(begin), end_(end) {}
+
+    template<typename F>
+    bool next_with(F&& f) {
+        if (pos_ == end_) return false;
+        f(*pos_++);
+        return true;
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    Option<T&> next_back() {
+        if (pos_ == end_) return None;
+        return Option<T&>(*--end_);
+    }
+
+    size_t len() const { return static_cast<size_t>(end_ - pos_); }
+    size_t size_hint() const { return len(); }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    T* begin() const { return pos_; }
+    // @lifetime: (&'a mut) -> &'a mut
+    T* end() const { return end_; }
+};
+
+// Non-overlapping pieces of size n; the last may be shorter
+template<typename T>
+class Chunks {
+private:
+    const T* pos_;
+    const T* end_;
+    size_t size_;
+
+public:
+    Chunks() : pos_(nullptr), end_(nullptr), size_(1) {}
+    Chunks(const T* begin, const T* end, size_t size) : pos_(begin), end_(end), size_(size) {}
+
+    // @lifetime: (&'a mut) -> &'a
+    Option<Slice<T>> next() {
+        if (pos_ == end_) return None;
+        size_t remaining = static_cast<size_t>(end_ - pos_);
+        size_t n = remaining < size_ ? remaining : size_;
+        Slice<T> piece(pos_, n);
+        pos_ += n;
+        return Option<Slice<T>>(piece);
+    }
+
+    using iterator = detail::SlicePieces<Chunks, Slice<T>>;
+    // @lifetime: (&'a) -> &'a
+    iterator begin() const { return iterator(*this); }
+    // @lifetime: (&'a) -> &'a
+    iterator end() const { return iterator(); }
+};
+
+// Overlapping pieces of size n, advancing one element at a time
+template<typename T>
+class Windows {
+private:
+    const T* pos_;
+    const T* end_;
+    size_t size_;
+
+public:
+    Windows() : pos_(nullptr), end_(nullptr), size_(1) {}
+    Windows(const T* begin, const T* end, size_t size) : pos_(begin), end_(end), size_(size) {}
+
+    // @lifetime: (&'a mut) -> &'a
+    Option<Slice<T>> next() {
+        if (static_cast<size_t>(end_ - pos_) < size_) return None;
+        return Option<Slice<T>>(Slice<T>(pos_++, size_));
+    }
+
+    using iterator = detail::SlicePieces<Windows, Slice<T>>;
+    // @lifetime: (&'a) -> &'a
+    iterator begin() const { return iterator(*this); }
+    // @lifetime: (&'a) -> &'a
+    iterator end() const { return iterator(); }
+};
+
+// Disjoint mutable pieces of size n; the last may be shorter
+template<typename T>
+class ChunksMut {
+private:
+    T* pos_;
+    T* end_;
+    size_t size_;
+
+public:
+    ChunksMut() : pos_(nullptr), end_(nullptr), size_(1) {}
+    ChunksMut(T* begin, T* end, size_t size) : pos_(begin), end_(end), size_(size) {}
+
+    // @lifetime: (&'a mut) -> &'a mut
+    Option<SliceMut<T>> next() {
+        if (pos_ == end_) return None;
+        size_t remaining = static_cast<size_t>(end_ - pos_);
+        size_t n = remaining < size_ ? remaining : size_;
+        SliceMut<T> piece(pos_, n);
+        pos_ += n;
+        return Option<SliceMut<T>>(std::move(piece));
+    }
+
+    using iterator = detail::SlicePieces<ChunksMut, SliceMut<T>>;
+    // @lifetime: (&'a) -> &'a mut
+    iterator begin() const { return iterator(*this); }
+    // @lifetime: (&'a) -> &'a mut
+    iterator end() const { return iterator(); }
+};
+
+template<typename T>
+class Slice {
+private:
+    const T* data_;
+    size_t len_;
+
+public:
+    Slice() : data_(nullptr), len_(0) {}
+
+    // @lifetime: (&'a) -> &'a
+    Slice(const T* data, size_t len) : data_(data), len_(len) {}
+
+    // @lifetime: (&'a) -> &'a
+    template<size_t N>
+    Slice(const T (&array)[N]) : data_(array), len_(N) {}
+
+    size_t len() const { return len_; }
+    bool is_empty() const { return len_ == 0; }
+
+    // @lifetime: (&'a) -> &'a
+    const T* as_ptr() const { return data_; }
+
+    // @lifetime: (&'a) -> &'a
+    const T& operator[](size_t index) const {
+        RUSTY_BOUNDS_CHECK(index < len_, "Slice index out of bounds");
+        return data_[index];
+    }
+
+    // Access element by index without a bounds check, in any build
+    // @unsafe
+    // @lifetime: (&'a) -> &'a
+    const T& get_unchecked(size_t index) const { return data_[index]; }
+
+    // @lifetime: (&'a) -> &'a
+    Option<const T&> get(size_t index) const {
+        if (index >= len_) return None;
+        return Option<const T&>(data_[index]);
+    }
+
+    // @lifetime: (&'a) -> &'a
+    Option<const T&> first() const { return get(0); }
+
+    // @lifetime: (&'a) -> &'a
+    Option<const T&> last() const {
+        if (len_ == 0) return None;
+        return Option<const T&>(data_[len_ - 1]);
+    }
+
+    // Elements [start, end), as in Rust's &s[start..end]
+    // @lifetime: (&'a) -> &'a
+    Slice slice(size_t start, size_t end) const {
+        RUSTY_BOUNDS_CHECK(start <= end && end <= len_, "Slice range out of bounds");
+        return Slice(data_ + start, end - start);
+    }
+
+    // [0, mid) and [mid, len)
+    // @lifetime: (&'a) -> &'a
+    std::pair<Slice, Slice> split_at(size_t mid) const {
+        RUSTY_BOUNDS_CHECK(mid <= len_, "Slice split point out of bounds");
+        return std::pair<Slice, Slice>(Slice(data_, mid), Slice(data_ + mid, len_ - mid));
+    }
+
+    // @lifetime: (&'a) -> &'a
+    Chunks<T> chunks(size_t size) const {
+        assert(size > 0);
+        return Chunks<T>(data_, data_ + len_, size);
+    }
+
+    // @lifetime: (&'a) -> &'a
+    Windows<T> windows(size_t size) const {
+        assert(size > 0);
+        return Windows<T>(data_, data_ + len_, size);
+    }
+
+    // @lifetime: (&'a) -> &'a
+    SliceIter<T> iter() const { return SliceIter<T>(data_, data_ + len_); }
+
+    // @lifetime: (&'a) -> &'a
+    const T* begin() const { return data_; }
+    // @lifetime: (&'a) -> &'a
+    const T* end() const { return data_ + len_; }
+
+    bool contains(const T& value) const {
+        for (size_t i = 0; i < len_; i++) {
+            if (data_[i] == value) return true;
+        }
+        return false;
+    }
+
+    bool starts_with(Slice prefix) const {
+        return prefix.len_ <= len_ && Slice(data_, prefix.len_) == prefix;
+    }
+
+    bool ends_with(Slice suffix) const {
+        return suffix.len_ <= len_ && Slice(data_ + len_ - suffix.len_, suffix.len_) == suffix;
+    }
+
+    // Index of the first element for which pred is false, assuming the
+    // slice is partitioned (all true elements first)
+    template<typename Pred>
+    size_t partition_point(Pred pred) const {
+        size_t lo = 0;
+        size_t hi = len_;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (pred(data_[mid])) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    // Search a slice sorted by cmp, where cmp(element) is negative,
+    // zero or positive as element is less than, equal to or greater than
+    // the target. Ok(index) of a match, or Err(index) to insert at.
+    template<typename Cmp>
+    Result<size_t, size_t> binary_search_by(Cmp cmp) const {
+        size_t lo = 0;
+        size_t hi = len_;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            int order = cmp(data_[mid]);
+            if (order == 0) return Result<size_t, size_t>::Ok(mid);
+            if (order < 0) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return Result<size_t, size_t>::Err(lo);
+    }
+
+    Result<size_t, size_t> binary_search(const T& value) const {
+        return binary_search_by([&value](const T& element) {
+            return element < value ? -1 : (value < element ? 1 : 0);
+        });
+    }
+
+    template<typename Key, typename F>
+    Result<size_t, size_t> binary_search_by_key(const Key& key, F f) const {
+        return binary_search_by([&key, &f](const T& element) {
+            const Key& k = f(element);
+            return k < key ? -1 : (key < k ? 1 : 0);
+        });
+    }
+
+    bool operator==(Slice other) const {
+        if (len_ != other.len_) return false;
+        for (size_t i = 0; i < len_; i++) {
+            if (!(data_[i] == other.data_[i])) return false;
+        }
+        return true;
+    }
+
+    bool operator!=(Slice other) const { return !(*this == other); }
+};
+
+template<typename T>
+class SliceMut {
+private:
+    T* data_;
+    size_t len_;
+
+public:
+    SliceMut() : data_(nullptr), len_(0) {}
+
+    // @lifetime: (&'a mut) -> &'a mut
+    SliceMut(T* data, size_t len) : data_(data), len_(len) {}
+
+    // @lifetime: (&'a mut) -> &'a mut
+    template<size_t N>
+    SliceMut(T (&array)[N]) : data_(array), len_(N) {}
+
+    // No copy constructor - only one SliceMut may borrow an element
+    SliceMut(const SliceMut&) = delete;
+    SliceMut& operator=(const SliceMut&) = delete;
+
+    SliceMut(SliceMut&& other) noexcept : data_(other.data_), len_(other.len_) {
+        other.data_ = nullptr;
+        other.len_ = 0;
+    }
+
+    SliceMut& operator=(SliceMut&& other) noexcept {
+        data_ = other.data_;
+        len_ = other.len_;
+        other.data_ = nullptr;
+        other.len_ = 0;
+        return *this;
+    }
+
+    // A shorter-lived SliceMut over the same elements; this one must not
+    // be used until the reborrow is dropped
+    // @lifetime: (&'a mut) -> &'a mut
+    SliceMut reborrow() { return SliceMut(data_, len_); }
+
+    // Shared view of the same elements
+    // @lifetime: (&'a) -> &'a
+    Slice<T> as_slice() const { return Slice<T>(data_, len_); }
+
+    // @lifetime: (&'a) -> &'a
+    operator Slice<T>() const { return as_slice(); }
+
+    size_t len() const { return len_; }
+    bool is_empty() const { return len_ == 0; }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    T* as_mut_ptr() { return data_; }
+
+    // @lifetime: (&'a) -> &'a
+    const T* as_ptr() const { return data_; }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    T& operator[](size_t index) {
+        RUSTY_BOUNDS_CHECK(index < len_, "SliceMut index out of bounds");
+        return data_[index];
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const T& operator[](size_t index) const {
+        RUSTY_BOUNDS_CHECK(index < len_, "SliceMut index out of bounds");
+        return data_[index];
+    }
+
+    // Access element by index without a bounds check, in any build
+    // @unsafe
+    // @lifetime: (&'a) -> &'a
+    const T& get_unchecked(size_t index) const { return data_[index]; }
+
+    // @unsafe
+    // @lifetime: (&'a mut) -> &'a mut
+    T& get_unchecked_mut(size_t index) { return data_[index]; }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    Option<T&> get_mut(size_t index) {
+        if (index >= len_) return None;
+        return Option<T&>(data_[index]);
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    SliceMut slice_mut(size_t start, size_t end) {
+        RUSTY_BOUNDS_CHECK(start <= end && end <= len_, "SliceMut range out of bounds");
+        return SliceMut(data_ + start, end - start);
+    }
+
+    // Two disjoint mutable halves: [0, mid) and [mid, len)
+    // @lifetime: (&'a mut) -> &'a mut
+    std::pair<SliceMut, SliceMut> split_at_mut(size_t mid) {
+        RUSTY_BOUNDS_CHECK(mid <= len_, "SliceMut split point out of bounds");
+        return std::pair<SliceMut, SliceMut>(SliceMut(data_, mid),
+                                             SliceMut(data_ + mid, len_ - mid));
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    ChunksMut<T> chunks_mut(size_t size) {
+        assert(size > 0);
+        return ChunksMut<T>(data_, data_ + len_, size);
+    }
+
+    // @lifetime: (&'a) -> &'a
+    SliceIter<T> iter() const { return SliceIter<T>(data_, data_ + len_); }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    SliceIterMut<T> iter_mut() { return SliceIterMut<T>(data_, data_ + len_); }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    T* begin() { return data_; }
+    // @lifetime: (&'a mut) -> &'a mut
+    T* end() { return data_ + len_; }
+    // @lifetime: (&'a) -> &'a
+    const T* begin() const { return data_; }
+    // @lifetime: (&'a) -> &'a
+    const T* end() const { return data_ + len_; }
+
+    void swap(size_t a, size_t b) {
+        RUSTY_BOUNDS_CHECK(a < len_ && b < len_, "SliceMut swap index out of bounds");
+        std::swap(data_[a], data_[b]);
+    }
+
+    void reverse() { std::reverse(data_, data_ + len_); }
+
+    void fill(const T& value) {
+        for (size_t i = 0; i < len_; i++) data_[i] = value;
+    }
+
+    // Copy src over these elements; the lengths must match
+    void copy_from_slice(Slice<T> src) {
+        assert(src.len() == len_);
+        std::copy(src.begin(), src.end(), data_);
+    }
+
+    // Sort without preserving the order of equal elements (pdqsort, in place)
+    void sort_unstable() {
+        detail::pdqsort(data_, data_ + len_, [](const T& a, const T& b) { return a < b; });
+    }
+
+    template<typename Less>
+    void sort_unstable_by(Less less) { detail::pdqsort(data_, data_ + len_, less); }
+
+    template<typename F>
+    void sort_unstable_by_key(F key) {
+        detail::pdqsort(data_, data_ + len_,
+                        [&key](const T& a, const T& b) { return key(a) < key(b); });
+    }
+
+    // Stable sort (merge sort, allocates len/2 elements of scratch)
+    void sort() {
+        detail::merge_sort(data_, len_, [](const T& a, const T& b) { return a < b; });
+    }
+
+    template<typename Less>
+    void sort_by(Less less) { detail::merge_sort(data_, len_, less); }
+
+    // key is called O(n log n) times; use sort_by_cached_key when it is costly
+    template<typename F>
+    void sort_by_key(F key) {
+        detail::merge_sort(data_, len_,
+                           [&key](const T& a, const T& b) { return key(a) < key(b); });
+    }
+
+    // Stable; calls key once per element and keeps the keys in a scratch buffer
+    template<typename F>
+    void sort_by_cached_key(F key) { detail::sort_by_cached_key(data_, len_, key); }
+
+    // Stable LSD radix sort on an integer key (allocates len elements of scratch)
+    template<typename F>
+    void radix_sort_by_key(F key) { detail::radix_sort_by_key(data_, len_, key); }
+
+    void radix_sort() {
+        static_assert(std::is_integral<T>::value, "radix_sort needs integer elements");
+        detail::radix_sort_by_key(data_, len_, [](const T& x) { return x; });
+    }
+
+    // Read-only operations of Slice
+    bool contains(const T& value) const { return as_slice().contains(value); }
+
+    Result<size_t, size_t> binary_search(const T& value) const {
+        return as_slice().binary_search(value);
+    }
+};
+
+// A Slice borrows its elements shared, like &[T]
+template<typename T>
+struct is_send<Slice<T>> : is_sync<T> {};
+
+} // namespace rusty
+
+#endif // RUSTY_SLICE_HPP
@@ -0,0 +1,505 @@
+#ifndef RUSTY_SLICE_PTR_HPP
+#define RUSTY_SLICE_PTR_HPP
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <utility>
+#include "alloc.hpp"
+#include "bounds.hpp"
+#include "marker.hpp"
+#include "relocate.hpp"
+#include "slice.hpp"
+#include "vec.hpp"
+
+#if __cplusplus >= 201703L
+#include "string.hpp"
+#endif
+
+// BoxSlice<T>, RcSlice<T>, ArcSlice<T>, ArcStr - Owning pointers to slices
+// Equivalent to Rust's Box<[T]>, Rc<[T]>, Arc<[T]> and Arc<str>
+//
+// Guarantees:
+// - BoxSlice owns a fixed-length buffer: a Vec without spare capacity.
+//   from_vec() keeps the Vec's buffer (shrinking it first if needed) and
+//   into_vec() hands it back, so neither copies an element
+// - RcSlice / ArcSlice are one pointer to a single allocation holding the
+//   count, the length and the elements; a clone shares the elements
+//   without the second allocation and indirection of Arc<Vec<T>>
+// - from_vec() relocates the elements out of the Vec into that block, so
+//   nothing is copied or dropped; copy_from_slice() copies
+// - Shared elements are read-only, and the last handle drops them
+// - ArcStr is an ArcSlice of UTF-8 bytes with a trailing NUL (C++17)
+//
+// Empty slices are null handles and never allocate.
+
+// @safe
+namespace rusty {
+
+namespace detail {
+
+// Header of a shared slice; the elements follow it in the same block
+template<typename T, typename Count>
+struct SliceBlock {
+    Count count;
+    size_t len;
+
+    explicit SliceBlock(size_t n) : count(1), len(n) {}
+
+    static constexpr size_t ALIGN = alignof(T) > alignof(Count) ? alignof(T) : alignof(Count);
+
+    static size_t data_offset() {
+        return (sizeof(SliceBlock) + alignof(T) - 1) / alignof(T) * alignof(T);
+    }
+
+    static size_t bytes(size_t len) {
+        return data_offset() + len * sizeof(T);
+    }
+
+    T* data() {
+        return reinterpret_cast<T*>(reinterpret_cast<char*>(this) + data_offset());
+    }
+
+    // A block for len elements, none of them constructed yet
+    static SliceBlock* allocate(size_t len, AllocKind kind) {
+        if (len > (SIZE_MAX - data_offset()) / sizeof(T)) throw std::bad_alloc();
+        Global alloc;
+        void* raw = alloc_or_throw(alloc, bytes(len), ALIGN);
+        detail::observe_alloc(kind, raw, bytes(len));
+        return new (raw) SliceBlock(len);
+    }
+
+    void deallocate(AllocKind kind) {
+        size_t size = bytes(len);
+        this->~SliceBlock();
+        detail::observe_dealloc(kind, this, size);
+        Global().deallocate(this, size, ALIGN);
+    }
+
+    // Take over the elements of v, leaving it empty
+    template<typename Alloc>
+    static SliceBlock* from_vec(Vec<T, Alloc>& v, AllocKind kind) {
+        SliceBlock* block = allocate(v.len(), kind);
+        rusty::relocate_n(block->data(), v.as_mut_ptr(), v.len());
+        v.set_len(0);
+        return block;
+    }
+
+    static SliceBlock* copy_of(const T* src, size_t n, AllocKind kind) {
+        SliceBlock* block = allocate(n, kind);
+        if (std::is_trivially_copyable<T>::value) {
+            if (n > 0) std::memcpy(static_cast<void*>(block->data()), static_cast<const void*>(src), n * sizeof(T));
+            return block;
+        }
+        size_t built = 0;
+        try {
+            for (; built < n; built++) new (block->data() + built) T(src[built]);
+        } catch (...) {
+            while (built > 0) block->data()[--built].~T();
+            block->deallocate(kind);
+            throw;
+        }
+        return block;
+    }
+
+    // Drop the elements and free the block
+    void destroy(AllocKind kind) {
+        T* elements = data();
+        for (size_t i = 0; i < len; i++) elements[i].~T();
+        deallocate(kind);
+    }
+};
+
+} // namespace detail
+
+// A fixed-length owned slice, Rust's Box<[T]>
+template<typename T>
+class BoxSlice {
+private:
+    T* ptr_;
+    size_t len_;
+
+    void drop() {
+        // Rebuild the Vec the buffer came from and let it free everything
+        Vec<T>::from_raw_parts(ptr_, len_, len_);
+    }
+
+public:
+    BoxSlice() : ptr_(nullptr), len_(0) {}
+
+    // Take v's buffer; spare capacity is given back first
+    // @lifetime: owned
+    static BoxSlice from_vec(Vec<T> v) {
+        v.shrink_to_fit();
+        BoxSlice b;
+        size_t cap = 0;
+        b.ptr_ = v.into_raw_parts(b.len_, cap);
+        return b;
+    }
+
+    // @lifetime: owned
+    static BoxSlice copy_from_slice(Slice<T> s) {
+        Vec<T> v = Vec<T>::with_capacity(s.len());
+        v.extend_from_slice(s);
+        return from_vec(std::move(v));
+    }
+
+    BoxSlice(const BoxSlice&) = delete;
+    BoxSlice& operator=(const BoxSlice&) = delete;
+
+    BoxSlice(BoxSlice&& other) noexcept : ptr_(other.ptr_), len_(other.len_) {
+        other.ptr_ = nullptr;
+        other.len_ = 0;
+    }
+
+    BoxSlice& operator=(BoxSlice&& other) noexcept {
+        if (this != &other) {
+            drop();
+            ptr_ = other.ptr_;
+            len_ = other.len_;
+            other.ptr_ = nullptr;
+            other.len_ = 0;
+        }
+        return *this;
+    }
+
+    ~BoxSlice() {
+        drop();
+    }
+
+    // Hand the buffer back as a Vec with no spare capacity
+    // @lifetime: owned
+    Vec<T> into_vec() {
+        Vec<T> v = Vec<T>::from_raw_parts(ptr_, len_, len_);
+        ptr_ = nullptr;
+        len_ = 0;
+        return v;
+    }
+
+    size_t len() const { return len_; }
+    bool is_empty() const { return len_ == 0; }
+
+    // @lifetime: (&'a) -> &'a
+    const T& operator[](size_t index) const {
+        RUSTY_BOUNDS_CHECK(index < len_, "BoxSlice index out of bounds");
+        return ptr_[index];
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    T& operator[](size_t index) {
+        RUSTY_BOUNDS_CHECK(index < len_, "BoxSlice index out of bounds");
+        return ptr_[index];
+    }
+
+    // @lifetime: (&'a) -> &'a
+    Slice<T> as_slice() const { return Slice<T>(ptr_, len_); }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    SliceMut<T> as_mut_slice() { return SliceMut<T>(ptr_, len_); }
+
+    // @lifetime: (&'a) -> &'a
+    const T* begin() const { return ptr_; }
+    const T* end() const { return ptr_ + len_; }
+
+    // @lifetime: owned
+    BoxSlice clone() const {
+        return copy_from_slice(as_slice());
+    }
+};
+
+// A shared slice with a plain counter, Rust's Rc<[T]>
+//
+// WARNING: Not thread-safe! Use ArcSlice to share across threads
+template<typename T>
+class RcSlice {
+private:
+    using Block = detail::SliceBlock<T, size_t>;
+
+    Block* ptr_;
+
+    explicit RcSlice(Block* block) : ptr_(block) {}
+
+    void increment() {
+        if (ptr_) ++ptr_->count;
+    }
+
+    void decrement() {
+        if (ptr_ && --ptr_->count == 0) ptr_->destroy(AllocKind::Rc);
+    }
+
+public:
+    RcSlice() : ptr_(nullptr) {}
+
+    // Move the elements of v into one shared block
+    // @lifetime: owned
+    static RcSlice from_vec(Vec<T> v) {
+        return v.is_empty() ? RcSlice() : RcSlice(Block::from_vec(v, AllocKind::Rc));
+    }
+
+    // @lifetime: owned
+    static RcSlice copy_from_slice(Slice<T> s) {
+        return s.is_empty() ? RcSlice() : RcSlice(Block::copy_of(s.as_ptr(), s.len(), AllocKind::Rc));
+    }
+
+    RcSlice(const RcSlice& other) : ptr_(other.ptr_) {
+        increment();
+    }
+
+    RcSlice(RcSlice&& other) noexcept : ptr_(other.ptr_) {
+        other.ptr_ = nullptr;
+    }
+
+    RcSlice& operator=(const RcSlice& other) {
+        if (this != &other) {
+            decrement();
+            ptr_ = other.ptr_;
+            increment();
+        }
+        return *this;
+    }
+
+    RcSlice& operator=(RcSlice&& other) noexcept {
+        if (this != &other) {
+            decrement();
+            ptr_ = other.ptr_;
+            other.ptr_ = nullptr;
+        }
+        return *this;
+    }
+
+    ~RcSlice() {
+        decrement();
+    }
+
+    size_t len() const { return ptr_ ? ptr_->len : 0; }
+    bool is_empty() const { return len() == 0; }
+
+    // @lifetime: (&'a) -> &'a
+    const T* as_ptr() const { return ptr_ ? ptr_->data() : nullptr; }
+
+    // @lifetime: (&'a) -> &'a
+    Slice<T> as_slice() const { return Slice<T>(as_ptr(), len()); }
+
+    // @lifetime: (&'a) -> &'a
+    const T& operator[](size_t index) const {
+        RUSTY_BOUNDS_CHECK(index < len(), "RcSlice index out of bounds");
+        return ptr_->data()[index];
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const T* begin() const { return as_ptr(); }
+    const T* end() const { return as_ptr() + len(); }
+
+    // Handles sharing this block (0 for the empty slice)
+    size_t strong_count() const { return ptr_ ? ptr_->count : 0; }
+
+    // True when both share one block (or are both empty)
+    static bool ptr_eq(const RcSlice& a, const RcSlice& b) { return a.ptr_ == b.ptr_; }
+
+    RcSlice clone() const { return RcSlice(*this); }
+
+    bool operator==(const RcSlice& other) const { return as_slice() == other.as_slice(); }
+    bool operator!=(const RcSlice& other) const { return !(*this == other); }
+};
+
+// A shared slice with an atomic counter, Rust's Arc<[T]>
+template<typename T>
+class ArcSlice {
+private:
+    using Block = detail::SliceBlock<T, std::atomic<size_t>>;
+
+    Block* ptr_;
+
+    explicit ArcSlice(Block* block) : ptr_(block) {}
+
+    void increment() {
+        if (ptr_) ptr_->count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void decrement() {
+        if (ptr_ && ptr_->count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            ptr_->destroy(AllocKind::Arc);
+        }
+    }
+
+public:
+    ArcSlice() : ptr_(nullptr) {}
+
+    // Move the elements of v into one shared block
+    // @lifetime: owned
+    static ArcSlice from_vec(Vec<T> v) {
+        return v.is_empty() ? ArcSlice() : ArcSlice(Block::from_vec(v, AllocKind::Arc));
+    }
+
+    // @lifetime: owned
+    static ArcSlice copy_from_slice(Slice<T> s) {
+        return s.is_empty() ? ArcSlice() : ArcSlice(Block::copy_of(s.as_ptr(), s.len(), AllocKind::Arc));
+    }
+
+    ArcSlice(const ArcSlice& other) : ptr_(other.ptr_) {
+        increment();
+    }
+
+    ArcSlice(ArcSlice&& other) noexcept : ptr_(other.ptr_) {
+        other.ptr_ = nullptr;
+    }
+
+    ArcSlice& operator=(const ArcSlice& other) {
+        if (this != &other) {
+            decrement();
+            ptr_ = other.ptr_;
+            increment();
+        }
+        return *this;
+    }
+
+    ArcSlice& operator=(ArcSlice&& other) noexcept {
+        if (this != &other) {
+            decrement();
+            ptr_ = other.ptr_;
+            other.ptr_ = nullptr;
+        }
+        return *this;
+    }
+
+    ~ArcSlice() {
+        decrement();
+    }
+
+    size_t len() const { return ptr_ ? ptr_->len : 0; }
+    bool is_empty() const { return len() == 0; }
+
+    // @lifetime: (&'a) -> &'a
+    const T* as_ptr() const { return ptr_ ? ptr_->data() : nullptr; }
+
+    // @lifetime: (&'a) -> &'a
+    Slice<T> as_slice() const { return Slice<T>(as_ptr(), len()); }
+
+    // @lifetime: (&'a) -> &'a
+    const T& operator[](size_t index) const {
+        RUSTY_BOUNDS_CHECK(index < len(), "ArcSlice index out of bounds");
+        return ptr_->data()[index];
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const T* begin() const { return as_ptr(); }
+    const T* end() const { return as_ptr() + len(); }
+
+    // Handles sharing this block (0 for the empty slice)
+    size_t strong_count() const {
+        return ptr_ ? ptr_->count.load(std::memory_order_relaxed) : 0;
+    }
+
+    // True when both share one block (or are both empty)
+    static bool ptr_eq(const ArcSlice& a, const ArcSlice& b) { return a.ptr_ == b.ptr_; }
+
+    ArcSlice clone() const { return ArcSlice(*this); }
+
+    bool operator==(const ArcSlice& other) const { return as_slice() == other.as_slice(); }
+    bool operator!=(const ArcSlice& other) const { return !(*this == other); }
+};
+
+#if __cplusplus >= 201703L
+// A shared immutable string, Rust's Arc<str>: one block with the count,
+// the length and the bytes, NUL-terminated for C APIs
+class ArcStr {
+private:
+    // The bytes and their NUL; empty for the empty string
+    ArcSlice<char> bytes_;
+
+    explicit ArcStr(ArcSlice<char> bytes) : bytes_(std::move(bytes)) {}
+
+public:
+    ArcStr() {}
+
+    // @lifetime: owned
+    static ArcStr from(str s) {
+        if (s.is_empty()) return ArcStr();
+        Vec<char> bytes = Vec<char>::with_capacity(s.len() + 1);
+        bytes.extend_from_slice(s.as_ptr(), s.len());
+        bytes.push('\0');
+        return ArcStr(ArcSlice<char>::from_vec(std::move(bytes)));
+    }
+
+    // Consume s; its bytes are copied next to the count, since a String's
+    // buffer has no room for one
+    // @lifetime: owned
+    static ArcStr from(String s) {
+        return from(str(s));
+    }
+
+    ArcStr(const ArcStr& other) = default;
+    ArcStr(ArcStr&& other) noexcept = default;
+    ArcStr& operator=(const ArcStr& other) = default;
+    ArcStr& operator=(ArcStr&& other) noexcept = default;
+
+    size_t len() const { return bytes_.is_empty() ? 0 : bytes_.len() - 1; }
+    bool is_empty() const { return bytes_.is_empty(); }
+
+    // @lifetime: (&'a) -> &'a
+    const char* as_ptr() const { return bytes_.is_empty() ? "" : bytes_.as_ptr(); }
+
+    // @lifetime: (&'a) -> &'a
+    const char* c_str() const { return as_ptr(); }
+
+    // @lifetime: (&'a) -> &'a
+    std::string_view as_str() const { return std::string_view(as_ptr(), len()); }
+
+    // @lifetime: (&'a) -> &'a
+    operator str() const { return str(as_ptr(), len()); }
+
+    size_t strong_count() const { return bytes_.strong_count(); }
+
+    static bool ptr_eq(const ArcStr& a, const ArcStr& b) { return ArcSlice<char>::ptr_eq(a.bytes_, b.bytes_); }
+
+    ArcStr clone() const { return *this; }
+
+    // @lifetime: owned
+    String to_string() const { return String::from(as_str()); }
+
+    bool operator==(const ArcStr& other) const { return as_str() == other.as_str(); }
+    bool operator!=(const ArcStr& other) const { return !(*this == other); }
+    bool operator==(str other) const { return as_str() == other.as_str(); }
+    bool operator!=(str other) const { return !(*this == other); }
+};
+
+// Hashes like String and str, so StringHash/StringEq maps take ArcStr keys
+template<>
+struct FxHash<ArcStr> : StringHash {};
+
+template<>
+struct is_trivially_relocatable<ArcStr> : std::true_type {};
+#endif
+
+// Each handle is one or two words that never point at themselves
+template<typename T>
+struct is_trivially_relocatable<BoxSlice<T>> : std::true_type {};
+
+template<typename T>
+struct is_trivially_relocatable<RcSlice<T>> : std::true_type {};
+
+template<typename T>
+struct is_trivially_relocatable<ArcSlice<T>> : std::true_type {};
+
+// RcSlice's count is not atomic: it stays on one thread
+template<typename T>
+struct is_send<RcSlice<T>> : std::false_type {};
+
+template<typename T>
+struct is_sync<RcSlice<T>> : std::false_type {};
+
+// As with Arc, the last handle drops the elements on whichever thread it
+// is on: T must be both Send and Sync
+template<typename T>
+struct is_send<ArcSlice<T>> : detail::all_of<is_send<T>::value, is_sync<T>::value> {};
+
+template<typename T>
+struct is_sync<ArcSlice<T>> : detail::all_of<is_send<T>::value, is_sync<T>::value> {};
+
+} // namespace rusty
+
+#endif // RUSTY_SLICE_PTR_HPP
@@ -0,0 +1,286 @@
+#ifndef RUSTY_SMALLMAP_HPP
+#define RUSTY_SMALLMAP_HPP
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "alloc.hpp"
+#include "fwd.hpp"
+#include "hash.hpp"
+#include "hashmap.hpp"
+#include "option.hpp"
+#include "traits.hpp"
+
+// SmallMap<K, V, N> - A map that keeps up to N entries inline
+//
+// Guarantees:
+// - Move-only with explicit clone(), like HashMap
+// - No allocation while it holds at most N entries: keys are found by a
+//   linear scan of an inline key array, with no hashing
+// - The (N+1)th key moves every entry ("spills") into a HashMap, which
+//   holds them from then on; spilled maps never move back inline
+// - Iteration order is unspecified; remove() moves the last inline entry
+//   into the freed place
+//
+// Meant for the many small maps (attributes, per-object properties) that
+// hold a handful of entries, where hashing and a table cost more than
+// comparing a few keys. Keep N small: every lookup compares up to N keys.
+
+// @safe
+namespace rusty {
+
+template<typename K, typename V, size_t N, typename Hash, typename KeyEqual, typename Alloc>
+class SmallMap {
+    static_assert(N > 0, "SmallMap needs at least one inline entry; use HashMap otherwise");
+
+public:
+    using Map = HashMap<K, V, Hash, KeyEqual, Alloc>;
+
+private:
+    typename std::aligned_storage<sizeof(K), alignof(K)>::type keys_[N];
+    typename std::aligned_storage<sizeof(V), alignof(V)>::type values_[N];
+    size_t inline_len_;
+    // Empty, and without a table, until the map spills
+    Map map_;
+    KeyEqual key_eq_;
+
+    K& key_at(size_t i) { return *reinterpret_cast<K*>(&keys_[i]); }
+    const K& key_at(size_t i) const { return *reinterpret_cast<const K*>(&keys_[i]); }
+    V& value_at(size_t i) { return *reinterpret_cast<V*>(&values_[i]); }
+    const V& value_at(size_t i) const { return *reinterpret_cast<const V*>(&values_[i]); }
+
+    // Inline index of key, or N if absent
+    size_t find_inline(const K& key) const {
+        for (size_t i = 0; i < inline_len_; i++) {
+            if (key_eq_(key_at(i), key)) return i;
+        }
+        return N;
+    }
+
+    void destroy_inline(size_t i) {
+        key_at(i).~K();
+        value_at(i).~V();
+    }
+
+    // Destroy inline entry i, moving the last entry into its place
+    void erase_inline(size_t i) {
+        size_t last = inline_len_ - 1;
+        if (i != last) {
+            key_at(i) = std::move(key_at(last));
+            value_at(i) = std::move(value_at(last));
+        }
+        destroy_inline(last);
+        inline_len_ = last;
+    }
+
+    void clear_inline() {
+        for (size_t i = 0; i < inline_len_; i++) {
+            destroy_inline(i);
+        }
+        inline_len_ = 0;
+    }
+
+    // Append a key known to be absent; there must be room inline
+    size_t push_inline(K key, V value) {
+        new (&keys_[inline_len_]) K(std::move(key));
+        new (&values_[inline_len_]) V(std::move(value));
+        return inline_len_++;
+    }
+
+    // Move the inline entries into map_, with room for one more
+    void spill() {
+        map_.reserve(N + 1);
+        for (size_t i = 0; i < inline_len_; i++) {
+            map_.insert(std::move(key_at(i)), std::move(value_at(i)));
+        }
+        clear_inline();
+    }
+
+    // Take other's inline entries; this must hold none
+    void take_inline(SmallMap& other) {
+        for (size_t i = 0; i < other.inline_len_; i++) {
+            push_inline(std::move(other.key_at(i)), std::move(other.value_at(i)));
+        }
+        other.clear_inline();
+    }
+
+public:
+    SmallMap() : inline_len_(0) {}
+
+    // Empty, using the given allocator once spilled
+    explicit SmallMap(const Alloc& alloc) : inline_len_(0), map_(alloc) {}
+
+    // @lifetime: owned
+    static SmallMap new_() {
+        return SmallMap();
+    }
+
+    // @lifetime: owned
+    static SmallMap new_in(const Alloc& alloc) {
+        return SmallMap(alloc);
+    }
+
+    SmallMap(const SmallMap&) = delete;
+    SmallMap& operator=(const SmallMap&) = delete;
+
+    SmallMap(SmallMap&& other) noexcept
+        : inline_len_(0), map_(std::move(other.map_)), key_eq_(std::move(other.key_eq_)) {
+        take_inline(other);
+    }
+
+    SmallMap& operator=(SmallMap&& other) noexcept {
+        if (this != &other) {
+            clear_inline();
+            map_ = std::move(other.map_);
+            key_eq_ = std::move(other.key_eq_);
+            take_inline(other);
+        }
+        return *this;
+    }
+
+    ~SmallMap() {
+        clear_inline();
+    }
+
+    size_t len() const { return spilled() ? map_.len() : inline_len_; }
+    bool is_empty() const { return len() == 0; }
+
+    static constexpr size_t inline_size() { return N; }
+
+    // True once the entries live in the HashMap
+    bool spilled() const { return map_.capacity() != 0; }
+
+    // Insert or update
+    void insert(K key, V value) {
+        if (spilled()) {
+            map_.insert(std::move(key), std::move(value));
+            return;
+        }
+        size_t i = find_inline(key);
+        if (i != N) {
+            value_at(i) = std::move(value);
+        } else if (inline_len_ < N) {
+            push_inline(std::move(key), std::move(value));
+        } else {
+            spill();
+            map_.insert(std::move(key), std::move(value));
+        }
+    }
+
+    // Get the value for key, inserting default_value first if absent
+    // @lifetime: (&'a mut) -> &'a mut
+    V& or_insert(K key, V default_value) {
+        if (!spilled()) {
+            size_t i = find_inline(key);
+            if (i != N) return value_at(i);
+            if (inline_len_ < N) {
+                return value_at(push_inline(std::move(key), std::move(default_value)));
+            }
+            spill();
+        }
+        return map_.or_insert(std::move(key), std::move(default_value));
+    }
+
+    // @lifetime: (&'a) -> &'a
+    Option<V&> get(const K& key) {
+        if (spilled()) return map_.get(key);
+        size_t i = find_inline(key);
+        if (i != N) return Option<V&>(value_at(i));
+        return None;
+    }
+
+    // @lifetime: (&'a) -> &'a
+    Option<const V&> get(const K& key) const {
+        if (spilled()) return map_.get(key);
+        size_t i = find_inline(key);
+        if (i != N) return Option<const V&>(value_at(i));
+        return None;
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    Option<V&> get_mut(const K& key) {
+        return get(key);
+    }
+
+    bool contains_key(const K& key) const {
+        return spilled() ? map_.contains_key(key) : find_inline(key) != N;
+    }
+
+    // Remove key, returning its value
+    // @lifetime: owned
+    Option<V> remove(const K& key) {
+        if (spilled()) return map_.remove(key);
+        size_t i = find_inline(key);
+        if (i == N) return None;
+        V value = std::move(value_at(i));
+        erase_inline(i);
+        return Some(std::move(value));
+    }
+
+    // Remove all entries (a spilled map keeps its table)
+    void clear() {
+        clear_inline();
+        map_.clear();
+    }
+
+    // Retain only entries for which pred(key, value) is true
+    template<typename Pred>
+    void retain(Pred pred) {
+        if (spilled()) {
+            map_.retain(pred);
+            return;
+        }
+        size_t i = 0;
+        while (i < inline_len_) {
+            if (pred(static_cast<const K&>(key_at(i)), value_at(i))) {
+                i++;
+            } else {
+                erase_inline(i);
+            }
+        }
+    }
+
+    // Call f(key, value) for each entry
+    template<typename F>
+    void for_each(F f) const {
+        if (spilled()) {
+            map_.for_each_in_buckets(0, map_.capacity(), f);
+            return;
+        }
+        for (size_t i = 0; i < inline_len_; i++) {
+            f(key_at(i), value_at(i));
+        }
+    }
+
+    // Call f(key, value) for each entry, with the value mutable
+    template<typename F>
+    void for_each_mut(F f) {
+        if (spilled()) {
+            map_.for_each_in_buckets_mut(0, map_.capacity(), f);
+            return;
+        }
+        for (size_t i = 0; i < inline_len_; i++) {
+            f(static_cast<const K&>(key_at(i)), value_at(i));
+        }
+    }
+
+    // Clone for explicit copying; a clone of a spilled map is spilled
+    // @lifetime: owned
+    SmallMap clone() const {
+        SmallMap result(map_.allocator());
+        if (spilled()) {
+            result.map_ = map_.clone();
+        } else {
+            for (size_t i = 0; i < inline_len_; i++) {
+                result.push_inline(detail::clone_value(key_at(i)), detail::clone_value(value_at(i)));
+            }
+        }
+        return result;
+    }
+};
+
+} // namespace rusty
+
+#endif // RUSTY_SMALLMAP_HPP
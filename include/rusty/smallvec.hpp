@@ -0,0 +1,306 @@
+#ifndef RUSTY_SMALLVEC_HPP
+#define RUSTY_SMALLVEC_HPP
+
+#include <cstddef>  // for size_t
+#include <initializer_list>
+#include <new>
+#include <type_traits>  // for std::aligned_storage
+#include <utility>  // for std::move
+#include "alloc.hpp"
+#include "bounds.hpp"
+#include "fwd.hpp"
+#include "relocate.hpp"
+#include "slice.hpp"
+#include "traits.hpp"
+
+// SmallVec<T, N> - A growable array that stores up to N elements inline
+// Equivalent to Rust's smallvec::SmallVec<[T; N]>
+//
+// Guarantees:
+// - Same ownership rules and API as Vec<T>: move-only, explicit clone()
+// - No allocation until the (N+1)th element; after that the elements move
+//   ("spill") to a heap buffer that grows by doubling, and never move back
+// - Element access is a plain pointer dereference whether spilled or not
+//
+// data_ points either at the inline buffer or at the heap, so moving a
+// SmallVec that has not spilled moves its elements one by one; SmallVec
+// is therefore not trivially relocatable.
+
+// @safe
+namespace rusty {
+
+template<typename T, size_t N, typename Alloc>
+class SmallVec : private detail::AllocHolder<Alloc> {
+    static_assert(N > 0, "SmallVec needs at least one inline slot; use Vec<T> otherwise");
+
+private:
+    T* data_;
+    size_t size_;
+    size_t capacity_;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type inline_[N];
+
+    T* inline_data() { return reinterpret_cast<T*>(inline_); }
+
+    // Take other's elements; this must hold no elements and no heap buffer
+    void take_from(SmallVec& other) {
+        if (other.spilled()) {
+            data_ = other.data_;
+            capacity_ = other.capacity_;
+        } else {
+            relocate_n(inline_data(), other.data_, other.size_);
+        }
+        size_ = other.size_;
+        other.data_ = other.inline_data();
+        other.size_ = 0;
+        other.capacity_ = N;
+    }
+
+    void deallocate() {
+        if (spilled()) {
+            this->alloc().deallocate(data_, capacity_ * sizeof(T), alignof(T));
+        }
+    }
+
+    void grow() {
+        relocate_to(capacity_ * 2);
+    }
+
+    // Move storage to a heap buffer of new_capacity elements
+    void relocate_to(size_t new_capacity) {
+        if (spilled()) {
+            relocate_to(new_capacity, is_trivially_relocatable<T>());
+            return;
+        }
+        T* heap = static_cast<T*>(
+            alloc_or_throw(this->alloc(), new_capacity * sizeof(T), alignof(T)));
+        relocate_n(heap, data_, size_);
+        data_ = heap;
+        capacity_ = new_capacity;
+    }
+
+    // Heap to heap, bits can be copied: let the allocator extend in place
+    void relocate_to(size_t new_capacity, std::true_type) {
+        data_ = static_cast<T*>(realloc_or_throw(this->alloc(), static_cast<void*>(data_),
+                                                 capacity_ * sizeof(T),
+                                                 new_capacity * sizeof(T), alignof(T)));
+        capacity_ = new_capacity;
+    }
+
+    void relocate_to(size_t new_capacity, std::false_type) {
+        T* heap = static_cast<T*>(
+            alloc_or_throw(this->alloc(), new_capacity * sizeof(T), alignof(T)));
+        relocate_n(heap, data_, size_);
+        deallocate();
+        data_ = heap;
+        capacity_ = new_capacity;
+    }
+
+public:
+    // Default constructor - empty, inline
+    SmallVec() : data_(inline_data()), size_(0), capacity_(N) {}
+
+    // Empty, using the given allocator once spilled
+    explicit SmallVec(const Alloc& alloc)
+        : detail::AllocHolder<Alloc>(alloc), data_(inline_data()), size_(0), capacity_(N) {}
+
+    // @lifetime: owned
+    static SmallVec new_() {
+        return SmallVec();
+    }
+
+    // @lifetime: owned
+    static SmallVec new_in(const Alloc& alloc) {
+        return SmallVec(alloc);
+    }
+
+    // Allocates only if cap exceeds the inline capacity
+    // @lifetime: owned
+    static SmallVec with_capacity(size_t cap) {
+        SmallVec v;
+        v.reserve(cap);
+        return v;
+    }
+
+    // Initializer list constructor
+    SmallVec(std::initializer_list<T> init) : data_(inline_data()), size_(0), capacity_(N) {
+        reserve(init.size());
+        for (const T& item : init) {
+            push(item);
+        }
+    }
+
+    // No copy constructor - SmallVec cannot be copied
+    SmallVec(const SmallVec&) = delete;
+    SmallVec& operator=(const SmallVec&) = delete;
+
+    // Move constructor
+    SmallVec(SmallVec&& other) noexcept
+        : detail::AllocHolder<Alloc>(std::move(other.alloc())),
+          data_(inline_data()), size_(0), capacity_(N) {
+        take_from(other);
+    }
+
+    // Move assignment
+    SmallVec& operator=(SmallVec&& other) noexcept {
+        if (this != &other) {
+            clear();
+            deallocate();
+            data_ = inline_data();
+            capacity_ = N;
+            this->alloc() = std::move(other.alloc());
+            take_from(other);
+        }
+        return *this;
+    }
+
+    // Destructor
+    ~SmallVec() {
+        clear();
+        deallocate();
+    }
+
+    // Push element to the back
+    void push(T value) {
+        if (size_ >= capacity_) {
+            grow();
+        }
+        new (&data_[size_]) T(std::move(value));
+        ++size_;
+    }
+
+    // Pop element from the back
+    T pop() {
+        RUSTY_BOUNDS_CHECK(size_ > 0, "pop from empty SmallVec");
+        --size_;
+        T result = std::move(data_[size_]);
+        data_[size_].~T();
+        return result;
+    }
+
+    // Access element by index
+    // @lifetime: (&'a) -> &'a
+    T& operator[](size_t index) {
+        RUSTY_BOUNDS_CHECK(index < size_, "SmallVec index out of bounds");
+        return data_[index];
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const T& operator[](size_t index) const {
+        RUSTY_BOUNDS_CHECK(index < size_, "SmallVec index out of bounds");
+        return data_[index];
+    }
+
+    // Access element by index without a bounds check, in any build
+    // @unsafe
+    // @lifetime: (&'a) -> &'a
+    const T& get_unchecked(size_t index) const { return data_[index]; }
+
+    // @unsafe
+    // @lifetime: (&'a mut) -> &'a mut
+    T& get_unchecked_mut(size_t index) { return data_[index]; }
+
+    // @lifetime: (&'a) -> &'a
+    T& front() {
+        RUSTY_BOUNDS_CHECK(size_ > 0, "front of empty SmallVec");
+        return data_[0];
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const T& front() const {
+        RUSTY_BOUNDS_CHECK(size_ > 0, "front of empty SmallVec");
+        return data_[0];
+    }
+
+    // @lifetime: (&'a) -> &'a
+    T& back() {
+        RUSTY_BOUNDS_CHECK(size_ > 0, "back of empty SmallVec");
+        return data_[size_ - 1];
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const T& back() const {
+        RUSTY_BOUNDS_CHECK(size_ > 0, "back of empty SmallVec");
+        return data_[size_ - 1];
+    }
+
+    size_t len() const { return size_; }
+    size_t size() const { return size_; }
+
+    bool is_empty() const { return size_ == 0; }
+
+    const Alloc& allocator() const { return this->alloc(); }
+
+    size_t capacity() const { return capacity_; }
+    size_t cap() const { return capacity_; }
+
+    static constexpr size_t inline_size() { return N; }
+
+    // True once the elements live on the heap
+    bool spilled() const {
+        return data_ != reinterpret_cast<const T*>(inline_);
+    }
+
+    // Reserve capacity
+    void reserve(size_t new_capacity) {
+        if (new_capacity > capacity_) {
+            relocate_to(new_capacity);
+        }
+    }
+
+    // Clear all elements (a heap buffer is kept)
+    void clear() {
+        for (size_t i = 0; i < size_; ++i) {
+            data_[i].~T();
+        }
+        size_ = 0;
+    }
+
+    // Borrow the elements as a slice
+    // @lifetime: (&'a) -> &'a
+    Slice<T> as_slice() const { return Slice<T>(data_, size_); }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    SliceMut<T> as_mut_slice() { return SliceMut<T>(data_, size_); }
+
+    // Iterator support
+    // @lifetime: (&'a) -> &'a
+    T* begin() { return data_; }
+    const T* begin() const { return data_; }
+
+    // @lifetime: (&'a) -> &'a
+    T* end() { return data_ + size_; }
+    const T* end() const { return data_ + size_; }
+
+    // Clone the SmallVec (explicit deep copy)
+    // @lifetime: owned
+    SmallVec clone() const {
+        SmallVec result(this->alloc());
+        result.reserve(size_);
+        for (size_t i = 0; i < size_; ++i) {
+            result.push(detail::clone_value(data_[i]));
+        }
+        return result;
+    }
+
+    bool operator==(const SmallVec& other) const {
+        if (size_ != other.size_) return false;
+        for (size_t i = 0; i < size_; ++i) {
+            if (!(data_[i] == other.data_[i])) return false;
+        }
+        return true;
+    }
+
+    bool operator!=(const SmallVec& other) const {
+        return !(*this == other);
+    }
+};
+
+template<typename T, size_t N, typename Alloc>
+struct is_send<SmallVec<T, N, Alloc>> : detail::all_of<is_send<T>::value, is_send<Alloc>::value> {};
+
+template<typename T, size_t N, typename Alloc>
+struct is_sync<SmallVec<T, N, Alloc>> : detail::all_of<is_sync<T>::value, is_sync<Alloc>::value> {};
+
+} // namespace rusty
+
+#endif // RUSTY_SMALLVEC_HPP
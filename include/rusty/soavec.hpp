@@ -0,0 +1,471 @@
+#ifndef RUSTY_SOAVEC_HPP
+#define RUSTY_SOAVEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "alloc.hpp"
+#include "bounds.hpp"
+#include "marker.hpp"
+#include "relocate.hpp"
+#include "result.hpp"
+#include "slice.hpp"
+
+// SoaVec<Ts...> - A growable array stored as one column per field
+// (Rust: the soa_derive crate's generated Vec)
+//
+//   SoaVec<uint64_t, double, uint32_t> trades;  // id, price, venue
+//   trades.push(1, 101.5, 7);
+//   double total = 0;
+//   for (double p : trades.column<1>()) total += p;  // touches prices only
+//
+// Guarantees:
+// - Move-only with explicit clone(), like Vec
+// - Field I of every row lives in one contiguous column, each starting on
+//   its own 64-byte line, so a scan of one field reads only that field and
+//   the compiler can vectorize it
+// - All columns share one allocation and grow with Vec's amortized
+//   doubling; trivially relocatable fields move with memcpy
+// - column<I>() / column_mut<I>() borrow a column as a Slice / SliceMut;
+//   they are invalidated by anything that grows the SoaVec
+// - row(i) (and operator[]) is a proxy for the i-th element of every
+//   column, for code that wants whole records
+//
+// Use it for wide records where hot loops read a few fields; when most
+// loops read every field, Vec<Record> keeps each record on fewer lines.
+
+// @safe
+namespace rusty {
+
+namespace detail {
+
+template<size_t... Is>
+struct SoaIndices {};
+
+template<size_t N, size_t... Is>
+struct MakeSoaIndices : MakeSoaIndices<N - 1, N - 1, Is...> {};
+
+template<size_t... Is>
+struct MakeSoaIndices<0, Is...> {
+    using type = SoaIndices<Is...>;
+};
+
+// Every column starts on a cache line of its own
+constexpr size_t SOA_COLUMN_ALIGN = 64;
+
+} // namespace detail
+
+template<typename... Ts>
+class SoaVec {
+    static_assert(sizeof...(Ts) > 0, "SoaVec needs at least one field");
+
+public:
+    static constexpr size_t FIELDS = sizeof...(Ts);
+
+    template<size_t I>
+    using Field = typename std::tuple_element<I, std::tuple<Ts...>>::type;
+
+    template<bool Const>
+    class RowRef;
+
+    using Row = RowRef<false>;
+    using ConstRow = RowRef<true>;
+
+private:
+    using Indices = typename detail::MakeSoaIndices<sizeof...(Ts)>::type;
+
+    // Column i starts at columns_[i]; columns_[0] is the block itself
+    void* columns_[sizeof...(Ts)];
+    size_t size_;
+    size_t capacity_;
+    size_t bytes_;
+
+    // Columns pad to a cache line anyway, so a smaller first block is
+    // mostly padding
+    static constexpr size_t MIN_NON_ZERO_CAP = 8;
+
+    static size_t field_size(size_t i) {
+        static const size_t sizes[] = {sizeof(Ts)...};
+        return sizes[i];
+    }
+
+    static size_t column_align(size_t i) {
+        static const size_t aligns[] = {alignof(Ts)...};
+        return aligns[i] > detail::SOA_COLUMN_ALIGN ? aligns[i] : detail::SOA_COLUMN_ALIGN;
+    }
+
+    static size_t block_align() {
+        size_t align = detail::SOA_COLUMN_ALIGN;
+        for (size_t i = 0; i < FIELDS; i++) {
+            if (column_align(i) > align) align = column_align(i);
+        }
+        return align;
+    }
+
+    // Offsets of each column in a block of cap rows, and the block's size;
+    // false if it does not fit in size_t
+    static bool layout(size_t cap, size_t* offsets, size_t& total) {
+        size_t offset = 0;
+        for (size_t i = 0; i < FIELDS; i++) {
+            size_t align = column_align(i);
+            if (offset > SIZE_MAX - (align - 1)) return false;
+            offset = (offset + align - 1) & ~(align - 1);
+            offsets[i] = offset;
+            if (cap > (SIZE_MAX - offset) / field_size(i)) return false;
+            offset += cap * field_size(i);
+        }
+        total = offset;
+        return true;
+    }
+
+    template<size_t I>
+    Field<I>* col() const {
+        return static_cast<Field<I>*>(columns_[I]);
+    }
+
+    void reset() {
+        for (size_t i = 0; i < FIELDS; i++) columns_[i] = nullptr;
+        size_ = 0;
+        capacity_ = 0;
+        bytes_ = 0;
+    }
+
+    void take(SoaVec& other) {
+        for (size_t i = 0; i < FIELDS; i++) columns_[i] = other.columns_[i];
+        size_ = other.size_;
+        capacity_ = other.capacity_;
+        bytes_ = other.bytes_;
+        other.reset();
+    }
+
+    void deallocate() {
+        if (columns_[0]) {
+            detail::observe_dealloc(AllocKind::Vec, columns_[0], bytes_);
+            Global().deallocate(columns_[0], bytes_, block_align());
+        }
+    }
+
+    // Destroy the first `fields` fields of row i
+    template<size_t... Is>
+    void destroy_row(size_t i, size_t fields, detail::SoaIndices<Is...>) {
+        int expand[] = {0, (Is < fields ? (col<Is>()[i].~Ts(), 0) : 0)...};
+        (void)expand;
+    }
+
+    // Construct row size_ from values; a throwing move leaves no fields
+    // of it behind
+    template<size_t... Is>
+    void construct_back(detail::SoaIndices<Is...>, Ts&&... values) {
+        size_t built = 0;
+        try {
+            int expand[] = {0, (new (col<Is>() + size_) Ts(std::move(values)), built++, 0)...};
+            (void)expand;
+        } catch (...) {
+            destroy_row(size_, built, Indices());
+            throw;
+        }
+        ++size_;
+    }
+
+    template<size_t... Is>
+    void relocate_columns(void* const* to, size_t from_row, size_t to_row, size_t n,
+                          detail::SoaIndices<Is...>) {
+        int expand[] = {0, (relocate_n(static_cast<Ts*>(to[Is]) + to_row, col<Is>() + from_row, n), 0)...};
+        (void)expand;
+    }
+
+    template<size_t... Is>
+    std::tuple<Ts...> take_row(size_t i, detail::SoaIndices<Is...>) {
+        std::tuple<Ts...> row(std::move(col<Is>()[i])...);
+        destroy_row(i, FIELDS, Indices());
+        return row;
+    }
+
+    template<size_t... Is>
+    void assign_row(size_t i, detail::SoaIndices<Is...>, Ts&&... values) {
+        int expand[] = {0, (col<Is>()[i] = std::move(values), 0)...};
+        (void)expand;
+    }
+
+    template<typename F, size_t... Is>
+    void call_row(F& f, size_t i, detail::SoaIndices<Is...>) const {
+        f(static_cast<const Ts&>(col<Is>()[i])...);
+    }
+
+    template<typename F, size_t... Is>
+    void call_row_mut(F& f, size_t i, detail::SoaIndices<Is...>) {
+        f(col<Is>()[i]...);
+    }
+
+    template<size_t... Is>
+    void copy_columns(SoaVec& to, detail::SoaIndices<Is...>) const {
+        int expand[] = {0, (size_ > 0 ? (std::memcpy(static_cast<void*>(to.col<Is>()),
+                                                     static_cast<const void*>(col<Is>()),
+                                                     size_ * sizeof(Ts)), 0) : 0)...};
+        (void)expand;
+    }
+
+    template<size_t... Is>
+    void push_copy_of(const SoaVec& from, size_t i, detail::SoaIndices<Is...>) {
+        push(from.col<Is>()[i]...);
+    }
+
+    Result<void, AllocError> try_grow_for(size_t additional) {
+        if (additional > SIZE_MAX - size_) {
+            return Result<void, AllocError>::Err(AllocError::capacity_overflow());
+        }
+        size_t needed = size_ + additional;
+        if (needed <= capacity_) return Result<void, AllocError>::Ok();
+        size_t doubled = capacity_ == 0 ? MIN_NON_ZERO_CAP : capacity_ * 2;
+        return try_relocate_to(needed > doubled ? needed : doubled);
+    }
+
+    // Move every column into a new block of new_capacity rows; the SoaVec
+    // is unchanged on Err
+    Result<void, AllocError> try_relocate_to(size_t new_capacity) {
+        size_t offsets[sizeof...(Ts)];
+        size_t total = 0;
+        if (!layout(new_capacity, offsets, total)) {
+            return Result<void, AllocError>::Err(AllocError::capacity_overflow());
+        }
+        void* block = Global().allocate(total, block_align());
+        if (!block) {
+            AllocError err = {total, block_align()};
+            return Result<void, AllocError>::Err(err);
+        }
+        detail::observe_alloc(AllocKind::Vec, block, total);
+        void* next[sizeof...(Ts)];
+        for (size_t i = 0; i < FIELDS; i++) next[i] = static_cast<char*>(block) + offsets[i];
+        relocate_columns(next, 0, 0, size_, Indices());
+        deallocate();
+        for (size_t i = 0; i < FIELDS; i++) columns_[i] = next[i];
+        capacity_ = new_capacity;
+        bytes_ = total;
+        return Result<void, AllocError>::Ok();
+    }
+
+public:
+    // A proxy for row i: field I of it is get<I>()
+    template<bool Const>
+    class RowRef {
+        using Owner = typename std::conditional<Const, const SoaVec, SoaVec>::type;
+
+        Owner* owner_;
+        size_t index_;
+
+        friend class SoaVec;
+
+        RowRef(Owner* owner, size_t index) : owner_(owner), index_(index) {}
+
+    public:
+        template<size_t I>
+        using Ref = typename std::conditional<Const, const Field<I>&, Field<I>&>::type;
+
+        size_t index() const { return index_; }
+
+        // @lifetime: (&'a) -> &'a
+        template<size_t I>
+        Ref<I> get() const {
+            return owner_->template col<I>()[index_];
+        }
+
+        // Overwrite every field of the row
+        void set(Ts... values) const {
+            static_assert(!Const, "set() needs a mutable row");
+            owner_->assign_row(index_, Indices(), std::move(values)...);
+        }
+
+        // The row's fields, copied
+        // @lifetime: owned
+        std::tuple<Ts...> to_tuple() const {
+            return owner_->row_tuple(index_, Indices());
+        }
+    };
+
+    SoaVec() { reset(); }
+
+    // @lifetime: owned
+    static SoaVec new_() {
+        return SoaVec();
+    }
+
+    // @lifetime: owned
+    static SoaVec with_capacity(size_t cap) {
+        SoaVec v;
+        v.reserve(cap);
+        return v;
+    }
+
+    // As with_capacity, but Err instead of throwing std::bad_alloc
+    // @lifetime: owned
+    static Result<SoaVec, AllocError> try_with_capacity(size_t cap) {
+        SoaVec v;
+        Result<void, AllocError> reserved = v.try_reserve(cap);
+        if (reserved.is_err()) {
+            return Result<SoaVec, AllocError>::Err(reserved.unwrap_err());
+        }
+        return Result<SoaVec, AllocError>::Ok(std::move(v));
+    }
+
+    SoaVec(const SoaVec&) = delete;
+    SoaVec& operator=(const SoaVec&) = delete;
+
+    SoaVec(SoaVec&& other) noexcept {
+        take(other);
+    }
+
+    SoaVec& operator=(SoaVec&& other) noexcept {
+        if (this != &other) {
+            clear();
+            deallocate();
+            take(other);
+        }
+        return *this;
+    }
+
+    ~SoaVec() {
+        clear();
+        deallocate();
+    }
+
+    size_t len() const { return size_; }
+    bool is_empty() const { return size_ == 0; }
+    size_t capacity() const { return capacity_; }
+
+    // Append a row
+    void push(Ts... values) {
+        if (size_ >= capacity_ && try_grow_for(1).is_err()) throw std::bad_alloc();
+        construct_back(Indices(), std::move(values)...);
+    }
+
+    // Push, or report allocation failure instead of throwing; the SoaVec
+    // is unchanged (and the values dropped) on Err
+    Result<void, AllocError> try_push(Ts... values) {
+        if (size_ >= capacity_) {
+            Result<void, AllocError> grown = try_grow_for(1);
+            if (grown.is_err()) return grown;
+        }
+        construct_back(Indices(), std::move(values)...);
+        return Result<void, AllocError>::Ok();
+    }
+
+    // Remove the last row and return its fields
+    // @lifetime: owned
+    std::tuple<Ts...> pop() {
+        RUSTY_BOUNDS_CHECK(size_ > 0, "pop from empty SoaVec");
+        --size_;
+        return take_row(size_, Indices());
+    }
+
+    // Remove row index, filling the gap with the last row: O(1), does not
+    // preserve order
+    // @lifetime: owned
+    std::tuple<Ts...> swap_remove(size_t index) {
+        RUSTY_BOUNDS_CHECK(index < size_, "SoaVec swap_remove index out of bounds");
+        std::tuple<Ts...> row = take_row(index, Indices());
+        --size_;
+        if (index != size_) {
+            relocate_columns(columns_, size_, index, 1, Indices());
+        }
+        return row;
+    }
+
+    // Reserve room for new_capacity rows in total
+    void reserve(size_t new_capacity) {
+        if (try_reserve(new_capacity).is_err()) throw std::bad_alloc();
+    }
+
+    Result<void, AllocError> try_reserve(size_t new_capacity) {
+        if (new_capacity <= capacity_) return Result<void, AllocError>::Ok();
+        return try_relocate_to(new_capacity);
+    }
+
+    // Drop the rows past len, keeping the capacity
+    void truncate(size_t len) {
+        while (size_ > len) {
+            --size_;
+            destroy_row(size_, FIELDS, Indices());
+        }
+    }
+
+    void clear() {
+        truncate(0);
+    }
+
+    // Borrow field I of every row; the SoaVec must not grow while it lives
+    // @lifetime: (&'a) -> &'a
+    template<size_t I>
+    Slice<Field<I>> column() const {
+        return Slice<Field<I>>(col<I>(), size_);
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    template<size_t I>
+    SliceMut<Field<I>> column_mut() {
+        return SliceMut<Field<I>>(col<I>(), size_);
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    Row row(size_t index) {
+        RUSTY_BOUNDS_CHECK(index < size_, "SoaVec index out of bounds");
+        return Row(this, index);
+    }
+
+    // @lifetime: (&'a) -> &'a
+    ConstRow row(size_t index) const {
+        RUSTY_BOUNDS_CHECK(index < size_, "SoaVec index out of bounds");
+        return ConstRow(this, index);
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    Row operator[](size_t index) { return row(index); }
+
+    // @lifetime: (&'a) -> &'a
+    ConstRow operator[](size_t index) const { return row(index); }
+
+    // Call f(fields...) for each row, in order
+    template<typename F>
+    void for_each(F f) const {
+        for (size_t i = 0; i < size_; i++) call_row(f, i, Indices());
+    }
+
+    // Call f(fields...) for each row, with the fields mutable
+    template<typename F>
+    void for_each_mut(F f) {
+        for (size_t i = 0; i < size_; i++) call_row_mut(f, i, Indices());
+    }
+
+    // Clone for explicit copying: one memcpy per column when every field
+    // is trivially copyable
+    // @lifetime: owned
+    SoaVec clone() const {
+        SoaVec result = with_capacity(size_);
+        if (detail::all_of<std::is_trivially_copyable<Ts>::value...>::value) {
+            copy_columns(result, Indices());
+            result.size_ = size_;
+        } else {
+            for (size_t i = 0; i < size_; i++) result.push_copy_of(*this, i, Indices());
+        }
+        return result;
+    }
+
+private:
+    template<size_t... Is>
+    std::tuple<Ts...> row_tuple(size_t i, detail::SoaIndices<Is...>) const {
+        return std::tuple<Ts...>(col<Is>()[i]...);
+    }
+};
+
+template<typename... Ts>
+constexpr size_t SoaVec<Ts...>::FIELDS;
+
+template<typename... Ts>
+constexpr size_t SoaVec<Ts...>::MIN_NON_ZERO_CAP;
+
+} // namespace rusty
+
+#endif // RUSTY_SOAVEC_HPP
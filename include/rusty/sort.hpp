@@ -0,0 +1,459 @@
+#ifndef RUSTY_SORT_HPP
+#define RUSTY_SORT_HPP
+
+#include <algorithm>  // for std::make_heap, std::sort_heap, std::iter_swap
+#include <cstddef>  // for size_t
+#include <cstring>  // for memset
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>  // for std::move, std::pair
+#include "alloc.hpp"
+
+// Sorting algorithms behind the sort* methods of SliceMut<T> and Vec<T>
+//
+// - pdqsort: unstable, in place, O(n log n) worst case. Quicksort with a
+//   median-of-3 (ninther above 128 elements) pivot, insertion sort for
+//   short ranges, a fast path for already partitioned input and a heapsort
+//   fallback after too many unbalanced partitions.
+// - merge_sort: stable. Top-down merge sort over a scratch buffer of n/2
+//   elements, insertion sort below 20 elements, and merges skipped when
+//   the halves are already in order. Fully sorted or strictly descending
+//   input is detected up front and finishes in O(n).
+// - sort_by_cached_key: computes each key once, sorts (key, index) pairs
+//   and applies the permutation in place.
+// - radix_sort_by_key: stable LSD radix sort on integer keys, one byte per
+//   pass over an n-element scratch buffer; passes where every key shares
+//   the same byte are skipped.
+//
+// `less(a, b)` is a strict weak ordering, as for std::sort. As with
+// std::sort, if it throws the range is left valid but unspecified (some
+// elements may be moved-from); scratch buffers never leak elements.
+
+// @safe
+namespace rusty {
+namespace detail {
+
+// Uninitialized scratch space for n elements, freed on scope exit
+template<typename T>
+class SortBuffer {
+private:
+    Global global_;
+    T* data_;
+    size_t capacity_;
+
+public:
+    explicit SortBuffer(size_t n)
+        : data_(n ? static_cast<T*>(alloc_or_throw(global_, n * sizeof(T), alignof(T)))
+                  : nullptr),
+          capacity_(n) {}
+
+    SortBuffer(const SortBuffer&) = delete;
+    SortBuffer& operator=(const SortBuffer&) = delete;
+
+    ~SortBuffer() {
+        if (data_) global_.deallocate(data_, capacity_ * sizeof(T), alignof(T));
+    }
+
+    T* data() { return data_; }
+};
+
+const size_t SORT_INSERTION_THRESHOLD = 24;
+const size_t SORT_NINTHER_THRESHOLD = 128;
+const size_t SORT_PARTIAL_INSERTION_LIMIT = 8;
+const size_t MERGE_SORT_RUN = 20;
+
+template<typename T, typename Less>
+void insertion_sort(T* begin, T* end, Less& less) {
+    if (begin == end) return;
+    for (T* cur = begin + 1; cur != end; ++cur) {
+        T* sift = cur;
+        T* sift_1 = cur - 1;
+        if (less(*sift, *sift_1)) {
+            T tmp(std::move(*sift));
+            do {
+                *sift-- = std::move(*sift_1);
+            } while (sift != begin && less(tmp, *--sift_1));
+            *sift = std::move(tmp);
+        }
+    }
+}
+
+// Insertion sort that relies on *(begin - 1) being <= every element
+template<typename T, typename Less>
+void unguarded_insertion_sort(T* begin, T* end, Less& less) {
+    if (begin == end) return;
+    for (T* cur = begin + 1; cur != end; ++cur) {
+        T* sift = cur;
+        T* sift_1 = cur - 1;
+        if (less(*sift, *sift_1)) {
+            T tmp(std::move(*sift));
+            do {
+                *sift-- = std::move(*sift_1);
+            } while (less(tmp, *--sift_1));
+            *sift = std::move(tmp);
+        }
+    }
+}
+
+// Insertion sort that gives up after moving SORT_PARTIAL_INSERTION_LIMIT
+// elements; returns whether the range ended up sorted
+template<typename T, typename Less>
+bool partial_insertion_sort(T* begin, T* end, Less& less) {
+    if (begin == end) return true;
+    size_t limit = 0;
+    for (T* cur = begin + 1; cur != end; ++cur) {
+        T* sift = cur;
+        T* sift_1 = cur - 1;
+        if (less(*sift, *sift_1)) {
+            T tmp(std::move(*sift));
+            do {
+                *sift-- = std::move(*sift_1);
+            } while (sift != begin && less(tmp, *--sift_1));
+            *sift = std::move(tmp);
+            limit += static_cast<size_t>(cur - sift);
+        }
+        if (limit > SORT_PARTIAL_INSERTION_LIMIT) return false;
+    }
+    return true;
+}
+
+template<typename T, typename Less>
+void sort2(T* a, T* b, Less& less) {
+    if (less(*b, *a)) std::iter_swap(a, b);
+}
+
+template<typename T, typename Less>
+void sort3(T* a, T* b, T* c, Less& less) {
+    sort2(a, b, less);
+    sort2(b, c, less);
+    sort2(a, b, less);
+}
+
+// Partition [begin, end) around the pivot *begin: elements < pivot to the
+// left, >= pivot to the right. Returns the pivot's final position and
+// whether no element had to move.
+template<typename T, typename Less>
+std::pair<T*, bool> partition_right(T* begin, T* end, Less& less) {
+    T pivot(std::move(*begin));
+    T* first = begin;
+    T* last = end;
+
+    // The median-of-3 guarantees an element >= pivot exists
+    while (less(*++first, pivot)) {}
+    if (first - 1 == begin) {
+        while (first < last && !less(*--last, pivot)) {}
+    } else {
+        while (!less(*--last, pivot)) {}
+    }
+
+    bool already_partitioned = first >= last;
+    while (first < last) {
+        std::iter_swap(first, last);
+        while (less(*++first, pivot)) {}
+        while (!less(*--last, pivot)) {}
+    }
+
+    T* pivot_pos = first - 1;
+    *begin = std::move(*pivot_pos);
+    *pivot_pos = std::move(pivot);
+    return std::pair<T*, bool>(pivot_pos, already_partitioned);
+}
+
+// Partition with elements == pivot going left; used when the pivot equals
+// the element just before the range, so the left side needs no sorting
+template<typename T, typename Less>
+T* partition_left(T* begin, T* end, Less& less) {
+    T pivot(std::move(*begin));
+    T* first = begin;
+    T* last = end;
+
+    while (less(pivot, *--last)) {}
+    if (last + 1 == end) {
+        while (first < last && !less(pivot, *++first)) {}
+    } else {
+        while (!less(pivot, *++first)) {}
+    }
+
+    while (first < last) {
+        std::iter_swap(first, last);
+        while (less(pivot, *--last)) {}
+        while (!less(pivot, *++first)) {}
+    }
+
+    T* pivot_pos = last;
+    *begin = std::move(*pivot_pos);
+    *pivot_pos = std::move(pivot);
+    return pivot_pos;
+}
+
+template<typename T, typename Less>
+void pdqsort_loop(T* begin, T* end, Less& less, int bad_allowed, bool leftmost) {
+    for (;;) {
+        size_t size = static_cast<size_t>(end - begin);
+        if (size < SORT_INSERTION_THRESHOLD) {
+            if (leftmost) {
+                insertion_sort(begin, end, less);
+            } else {
+                unguarded_insertion_sort(begin, end, less);
+            }
+            return;
+        }
+
+        size_t s2 = size / 2;
+        if (size > SORT_NINTHER_THRESHOLD) {
+            sort3(begin, begin + s2, end - 1, less);
+            sort3(begin + 1, begin + (s2 - 1), end - 2, less);
+            sort3(begin + 2, begin + (s2 + 1), end - 3, less);
+            sort3(begin + (s2 - 1), begin + s2, begin + (s2 + 1), less);
+            std::iter_swap(begin, begin + s2);
+        } else {
+            sort3(begin + s2, begin, end - 1, less);
+        }
+
+        // Nothing in the range is smaller than *(begin - 1); if the pivot
+        // equals it, split off the run of equal elements and continue
+        if (!leftmost && !less(*(begin - 1), *begin)) {
+            begin = partition_left(begin, end, less) + 1;
+            continue;
+        }
+
+        std::pair<T*, bool> part = partition_right(begin, end, less);
+        T* pivot_pos = part.first;
+        size_t l_size = static_cast<size_t>(pivot_pos - begin);
+        size_t r_size = static_cast<size_t>(end - (pivot_pos + 1));
+
+        if (l_size < size / 8 || r_size < size / 8) {
+            if (--bad_allowed == 0) {
+                std::make_heap(begin, end, less);
+                std::sort_heap(begin, end, less);
+                return;
+            }
+            // Break up patterns that defeat the pivot choice
+            if (l_size >= SORT_INSERTION_THRESHOLD) {
+                std::iter_swap(begin, begin + l_size / 4);
+                std::iter_swap(pivot_pos - 1, pivot_pos - l_size / 4);
+                if (l_size > SORT_NINTHER_THRESHOLD) {
+                    std::iter_swap(begin + 1, begin + (l_size / 4 + 1));
+                    std::iter_swap(begin + 2, begin + (l_size / 4 + 2));
+                    std::iter_swap(pivot_pos - 2, pivot_pos - (l_size / 4 + 1));
+                    std::iter_swap(pivot_pos - 3, pivot_pos - (l_size / 4 + 2));
+                }
+            }
+            if (r_size >= SORT_INSERTION_THRESHOLD) {
+                std::iter_swap(pivot_pos + 1, pivot_pos + (1 + r_size / 4));
+                std::iter_swap(end - 1, end - r_size / 4);
+                if (r_size > SORT_NINTHER_THRESHOLD) {
+                    std::iter_swap(pivot_pos + 2, pivot_pos + (2 + r_size / 4));
+                    std::iter_swap(pivot_pos + 3, pivot_pos + (3 + r_size / 4));
+                    std::iter_swap(end - 2, end - (1 + r_size / 4));
+                    std::iter_swap(end - 3, end - (2 + r_size / 4));
+                }
+            }
+        } else if (part.second &&
+                   partial_insertion_sort(begin, pivot_pos, less) &&
+                   partial_insertion_sort(pivot_pos + 1, end, less)) {
+            return;
+        }
+
+        // Recurse into the left side, loop on the right
+        pdqsort_loop(begin, pivot_pos, less, bad_allowed, leftmost);
+        begin = pivot_pos + 1;
+        leftmost = false;
+    }
+}
+
+template<typename T, typename Less>
+void pdqsort(T* begin, T* end, Less less) {
+    size_t size = static_cast<size_t>(end - begin);
+    if (size < 2) return;
+    int log2 = 0;
+    while (size >>= 1) log2++;
+    pdqsort_loop(begin, end, less, log2, true);
+}
+
+// Merges the sorted buf[0, n) (moved out of the left run) with the right
+// run [src, src_end) into dest. On scope exit, including when less throws,
+// whatever is left in buf is moved back into the hole at dest.
+template<typename T>
+struct MergeHole {
+    T* buf;
+    T* buf_end;
+    T* dest;
+
+    ~MergeHole() {
+        for (T* p = buf; p != buf_end; ++p, ++dest) {
+            *dest = std::move(*p);
+        }
+        for (T* p = buf; p != buf_end; ++p) p->~T();
+    }
+};
+
+template<typename T, typename Less>
+void merge_lo(T* v, size_t mid, size_t n, T* buf, Less& less) {
+    T* buf_end = buf;
+    for (size_t i = 0; i < mid; i++, buf_end++) {
+        new (buf_end) T(std::move(v[i]));
+    }
+    MergeHole<T> hole = {buf, buf_end, v};
+    T* right = v + mid;
+    T* right_end = v + n;
+    // The hole is always strictly before right, so nothing is overwritten
+    while (hole.buf != buf_end && right != right_end) {
+        if (less(*right, *hole.buf)) {
+            *hole.dest++ = std::move(*right++);
+        } else {
+            *hole.dest++ = std::move(*hole.buf);
+            hole.buf->~T();
+            hole.buf++;
+        }
+    }
+}
+
+template<typename T, typename Less>
+void merge_sort_rec(T* v, size_t n, T* buf, Less& less) {
+    if (n <= MERGE_SORT_RUN) {
+        insertion_sort(v, v + n, less);
+        return;
+    }
+    size_t mid = n / 2;
+    merge_sort_rec(v, mid, buf, less);
+    merge_sort_rec(v + mid, n - mid, buf, less);
+    if (!less(v[mid], v[mid - 1])) return;
+    merge_lo(v, mid, n, buf, less);
+}
+
+template<typename T, typename Less>
+void merge_sort(T* v, size_t n, Less less) {
+    if (n < 2) return;
+
+    // Already sorted, or strictly descending (reversing keeps it stable)
+    size_t run = 1;
+    if (less(v[1], v[0])) {
+        while (run < n && less(v[run], v[run - 1])) run++;
+        if (run == n) {
+            std::reverse(v, v + n);
+            return;
+        }
+    } else {
+        while (run < n && !less(v[run], v[run - 1])) run++;
+        if (run == n) return;
+    }
+
+    if (n <= MERGE_SORT_RUN) {
+        insertion_sort(v, v + n, less);
+        return;
+    }
+    SortBuffer<T> buf(n / 2);
+    merge_sort_rec(v, n, buf.data(), less);
+}
+
+template<typename T, typename F>
+void sort_by_cached_key(T* v, size_t n, F key) {
+    typedef typename std::decay<decltype(key(*v))>::type K;
+    typedef std::pair<K, size_t> Entry;
+    if (n < 2) return;
+
+    SortBuffer<Entry> keys(n);
+    Entry* entries = keys.data();
+    size_t built = 0;
+    struct Destroy {
+        Entry* entries;
+        size_t& built;
+        ~Destroy() {
+            for (size_t i = 0; i < built; i++) entries[i].~Entry();
+        }
+    } destroy = {entries, built};
+    for (; built < n; built++) {
+        new (&entries[built]) Entry(key(v[built]), built);
+    }
+
+    // The index breaks ties, so the unstable sort gives a stable order
+    pdqsort(entries, entries + n, [](const Entry& a, const Entry& b) {
+        return a.first < b.first || (!(b.first < a.first) && a.second < b.second);
+    });
+
+    // entries[i].second is where position i's element comes from; sources
+    // already swapped forward are followed to their current position
+    for (size_t i = 0; i < n; i++) {
+        size_t index = entries[i].second;
+        while (index < i) index = entries[index].second;
+        entries[i].second = index;
+        if (index != i) std::iter_swap(v + i, v + index);
+    }
+}
+
+// Order-preserving map of an integer key to an unsigned one
+template<typename K>
+typename std::make_unsigned<K>::type radix_key(K key, std::true_type /*is_signed*/) {
+    typedef typename std::make_unsigned<K>::type U;
+    return static_cast<U>(key) ^ (static_cast<U>(1) << (std::numeric_limits<U>::digits - 1));
+}
+
+template<typename K>
+typename std::make_unsigned<K>::type radix_key(K key, std::false_type /*is_signed*/) {
+    return static_cast<typename std::make_unsigned<K>::type>(key);
+}
+
+template<typename T, typename F>
+void radix_sort_by_key(T* v, size_t n, F key) {
+    typedef typename std::decay<decltype(key(*v))>::type K;
+    static_assert(std::is_integral<K>::value && !std::is_same<K, bool>::value,
+                  "radix_sort_by_key needs an integer key");
+    static_assert(std::is_nothrow_move_constructible<T>::value,
+                  "radix_sort_by_key moves elements between buffers and cannot recover "
+                  "from a throwing move");
+    typedef std::integral_constant<bool, std::is_signed<K>::value> is_signed;
+    const size_t DIGITS = sizeof(K);
+
+    if (n < 2) return;
+    if (n < 64) {
+        merge_sort(v, n, [&key](const T& a, const T& b) { return key(a) < key(b); });
+        return;
+    }
+
+    // Histograms for every byte in a single pass
+    size_t counts[sizeof(K)][256];
+    std::memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < n; i++) {
+        auto u = radix_key(key(v[i]), is_signed());
+        for (size_t d = 0; d < DIGITS; d++) {
+            counts[d][(u >> (d * 8)) & 0xff]++;
+        }
+    }
+
+    SortBuffer<T> buf(n);
+    T* src = v;
+    T* dst = buf.data();
+    for (size_t d = 0; d < DIGITS; d++) {
+        size_t* count = counts[d];
+        auto first = radix_key(key(src[0]), is_signed());
+        if (count[(first >> (d * 8)) & 0xff] == n) continue;
+
+        size_t offset = 0;
+        for (size_t b = 0; b < 256; b++) {
+            size_t c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+        // Moves every element, so dst ends up fully constructed and src raw
+        for (size_t i = 0; i < n; i++) {
+            auto u = radix_key(key(src[i]), is_signed());
+            new (&dst[count[(u >> (d * 8)) & 0xff]++]) T(std::move(src[i]));
+            src[i].~T();
+        }
+        std::swap(src, dst);
+    }
+
+    if (src != v) {
+        for (size_t i = 0; i < n; i++) {
+            new (&v[i]) T(std::move(src[i]));
+            src[i].~T();
+        }
+    }
+}
+
+} // namespace detail
+} // namespace rusty
+
+#endif // RUSTY_SORT_HPP
@@ -0,0 +1,290 @@
+#ifndef RUSTY_STATS_HPP
+#define RUSTY_STATS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+
+// Container statistics
+//
+// HashMap, Vec, String and BTreeMap have a stats() method. The shape of
+// the structure (HashMap probe lengths, tombstones and load, Vec and String
+// capacity, BTreeMap depth and node fill) is measured on demand by walking
+// the container, O(n), in every build.
+//
+// Event counters (HashMap resizes and in-place rehashes, Vec and String
+// reallocations and bytes copied) cost a field per container and an add on
+// each growth, so they are only kept when compiled with -DRUSTY_STATS and
+// read as zero otherwise. The same events are summed process-wide in
+// stats::totals().
+//
+// stats::Tracked registers a container under a name for stats::dump():
+//
+//   rusty::HashMap<uint64_t, Session> sessions;
+//   rusty::stats::Tracked<decltype(sessions)> watch("sessions", sessions);
+//   ...
+//   rusty::stats::dump(stderr);
+
+// @safe
+namespace rusty {
+namespace stats {
+
+#if defined(RUSTY_STATS)
+constexpr bool ENABLED = true;
+#else
+constexpr bool ENABLED = false;
+#endif
+
+// Probe lengths in groups: counts[i] is the number of probes that looked
+// at i + 1 groups, the last bucket also takes everything longer
+struct ProbeHistogram {
+    static constexpr size_t BUCKETS = 8;
+    uint64_t counts[BUCKETS];
+
+    ProbeHistogram() : counts() {}
+
+    void record(size_t groups) {
+        counts[(groups < BUCKETS ? groups : BUCKETS) - 1]++;
+    }
+
+    uint64_t total() const {
+        uint64_t n = 0;
+        for (size_t i = 0; i < BUCKETS; i++) n += counts[i];
+        return n;
+    }
+
+    double mean() const {
+        uint64_t n = 0, groups = 0;
+        for (size_t i = 0; i < BUCKETS; i++) {
+            n += counts[i];
+            groups += counts[i] * (i + 1);
+        }
+        return n == 0 ? 0.0 : double(groups) / double(n);
+    }
+
+    // Longest probe seen, in groups (BUCKETS means BUCKETS or more)
+    size_t max() const {
+        for (size_t i = BUCKETS; i > 0; i--) {
+            if (counts[i - 1] != 0) return i;
+        }
+        return 0;
+    }
+};
+
+struct HashMapStats {
+    size_t len;
+    size_t buckets;
+    size_t growth_left;          // Inserts left before the next resize
+    size_t tombstones;           // DELETED control bytes
+    ProbeHistogram hit_probes;   // Groups probed to find each resident key
+    ProbeHistogram miss_probes;  // Groups probed by a miss, per starting group
+    uint64_t resizes;            // RUSTY_STATS only
+    uint64_t rehashes_in_place;  // RUSTY_STATS only
+
+    double load_factor() const { return buckets == 0 ? 0.0 : double(len) / double(buckets); }
+
+    double tombstone_ratio() const {
+        return buckets == 0 ? 0.0 : double(tombstones) / double(buckets);
+    }
+};
+
+// Vec and String
+struct GrowthStats {
+    size_t len;
+    size_t capacity;
+    uint64_t reallocations;  // RUSTY_STATS only: buffer replaced or extended
+    uint64_t bytes_copied;   // RUSTY_STATS only: bytes moved to a new address
+};
+
+struct BTreeStats {
+    size_t len;
+    size_t depth;            // Levels, 1 for a lone leaf
+    size_t leaf_nodes;
+    size_t internal_nodes;
+    size_t leaf_keys;        // Keys held in leaves (each entry once)
+    size_t internal_keys;    // Separator keys in internal nodes
+    size_t node_capacity;    // Keys a node can hold
+
+    double leaf_fill() const {
+        return leaf_nodes == 0 ? 0.0 : double(leaf_keys) / double(leaf_nodes * node_capacity);
+    }
+
+    double internal_fill() const {
+        return internal_nodes == 0 ? 0.0
+                                   : double(internal_keys) / double(internal_nodes * node_capacity);
+    }
+};
+
+// Process-wide event sums, kept with RUSTY_STATS
+struct GrowthTotals {
+    std::atomic<uint64_t> reallocations;
+    std::atomic<uint64_t> bytes_copied;
+};
+
+struct Totals {
+    std::atomic<uint64_t> hashmap_resizes;
+    std::atomic<uint64_t> hashmap_rehashes_in_place;
+    GrowthTotals vec;
+    GrowthTotals string;
+};
+
+inline Totals& totals() {
+    static Totals t;  // Zero-initialized static storage
+    return t;
+}
+
+// Per-container event counters (members only under RUSTY_STATS)
+struct GrowthCounters {
+    uint64_t reallocations;
+    uint64_t bytes_copied;
+
+    GrowthCounters() : reallocations(0), bytes_copied(0) {}
+
+    void record(size_t bytes, GrowthTotals& total) {
+        reallocations++;
+        bytes_copied += bytes;
+        total.reallocations.fetch_add(1, std::memory_order_relaxed);
+        total.bytes_copied.fetch_add(bytes, std::memory_order_relaxed);
+    }
+};
+
+struct HashMapCounters {
+    uint64_t resizes;
+    uint64_t rehashes_in_place;
+
+    HashMapCounters() : resizes(0), rehashes_in_place(0) {}
+
+    void record_resize() {
+        resizes++;
+        totals().hashmap_resizes.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void record_rehash_in_place() {
+        rehashes_in_place++;
+        totals().hashmap_rehashes_in_place.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+inline void print(std::FILE* out, const HashMapStats& s) {
+    std::fprintf(out, "len=%zu buckets=%zu load=%.3f growth_left=%zu tombstones=%zu (%.3f)",
+                 s.len, s.buckets, s.load_factor(), s.growth_left, s.tombstones,
+                 s.tombstone_ratio());
+    std::fprintf(out, " hit_probe_mean=%.2f hit_probe_max=%zu miss_probe_mean=%.2f miss_probe_max=%zu",
+                 s.hit_probes.mean(), s.hit_probes.max(), s.miss_probes.mean(),
+                 s.miss_probes.max());
+    if (ENABLED) {
+        std::fprintf(out, " resizes=%llu rehashes_in_place=%llu",
+                     static_cast<unsigned long long>(s.resizes),
+                     static_cast<unsigned long long>(s.rehashes_in_place));
+    }
+}
+
+inline void print(std::FILE* out, const GrowthStats& s) {
+    std::fprintf(out, "len=%zu capacity=%zu", s.len, s.capacity);
+    if (ENABLED) {
+        std::fprintf(out, " reallocations=%llu bytes_copied=%llu",
+                     static_cast<unsigned long long>(s.reallocations),
+                     static_cast<unsigned long long>(s.bytes_copied));
+    }
+}
+
+inline void print(std::FILE* out, const BTreeStats& s) {
+    std::fprintf(out, "len=%zu depth=%zu leaves=%zu (fill %.3f) internal=%zu (fill %.3f)",
+                 s.len, s.depth, s.leaf_nodes, s.leaf_fill(), s.internal_nodes,
+                 s.internal_fill());
+}
+
+class TrackedBase;
+
+namespace detail {
+
+struct Registry {
+    std::mutex lock;
+    TrackedBase* head = nullptr;
+};
+
+inline Registry& registry() {
+    static Registry r;
+    return r;
+}
+
+} // namespace detail
+
+// A registry entry, linked into the list while it lives. It must not
+// outlive its container and cannot be copied or moved.
+class TrackedBase {
+    friend void dump(std::FILE* out);
+
+    const char* name_;
+    TrackedBase* prev_;
+    TrackedBase* next_;
+
+    virtual void print_stats(std::FILE* out) const = 0;
+
+protected:
+    explicit TrackedBase(const char* name) : name_(name), prev_(nullptr) {
+        detail::Registry& r = detail::registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+        next_ = r.head;
+        if (next_) next_->prev_ = this;
+        r.head = this;
+    }
+
+    ~TrackedBase() {
+        detail::Registry& r = detail::registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+        if (prev_) prev_->next_ = next_; else r.head = next_;
+        if (next_) next_->prev_ = prev_;
+    }
+
+public:
+    TrackedBase(const TrackedBase&) = delete;
+    TrackedBase& operator=(const TrackedBase&) = delete;
+
+    const char* name() const { return name_; }
+};
+
+// Registers container under name until destroyed; name is not copied
+// @lifetime: (&'a, &'a) -> 'a
+template<typename C>
+class Tracked : public TrackedBase {
+    const C& container_;
+
+    void print_stats(std::FILE* out) const override { print(out, container_.stats()); }
+
+public:
+    Tracked(const char* name, const C& container) : TrackedBase(name), container_(container) {}
+};
+
+// Print every tracked container, then the process-wide totals. The
+// tracked containers must not be modified concurrently.
+inline void dump(std::FILE* out) {
+    detail::Registry& r = detail::registry();
+    {
+        std::lock_guard<std::mutex> guard(r.lock);
+        for (TrackedBase* t = r.head; t; t = t->next_) {
+            std::fprintf(out, "%s: ", t->name_);
+            t->print_stats(out);
+            std::fputc('\n', out);
+        }
+    }
+    if (ENABLED) {
+        Totals& t = totals();
+        std::fprintf(out, "totals: hashmap_resizes=%llu hashmap_rehashes_in_place=%llu"
+                     " vec_reallocations=%llu vec_bytes_copied=%llu"
+                     " string_reallocations=%llu string_bytes_copied=%llu\n",
+                     static_cast<unsigned long long>(t.hashmap_resizes.load()),
+                     static_cast<unsigned long long>(t.hashmap_rehashes_in_place.load()),
+                     static_cast<unsigned long long>(t.vec.reallocations.load()),
+                     static_cast<unsigned long long>(t.vec.bytes_copied.load()),
+                     static_cast<unsigned long long>(t.string.reallocations.load()),
+                     static_cast<unsigned long long>(t.string.bytes_copied.load()));
+    }
+}
+
+} // namespace stats
+} // namespace rusty
+
+#endif // RUSTY_STATS_HPP
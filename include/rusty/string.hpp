@@ -2,266 +2,864 @@
 #define RUSTY_STRING_HPP
 
 #include <cstring>
+#include <cstdint>
 #include <cstdlib>
 #include <algorithm>
 #include <iterator>
-#include <ostream>
+#include <iosfwd>   // operator<< is a template, so callers bring <ostream>
+#include <string>
 #include <string_view>
 #include <vector>
 #include <cctype>
+#include "alloc.hpp"
+#include "bounds.hpp"
+#include "cow.hpp"
+#include "fwd.hpp"
+#include "hash.hpp"
+#include "memchr.hpp"
+#include "option.hpp"
+#include "result.hpp"
+#include "relocate.hpp"
+#include "stats.hpp"
 
 // @safe
 namespace rusty {
 
-// Forward declaration for str type (borrowed string slice)
-class str;
+template<typename Pattern> class Split;
+class SplitWhitespace;
+class Lines;
 
-// @safe
-// Rust-like owned String type
-// Manages a heap-allocated, growable UTF-8 string
-class String {
+// Why a byte sequence is not UTF-8 (mirrors Rust's std::str::Utf8Error)
+class Utf8Error {
+private:
+    size_t valid_up_to_;
+    uint8_t error_len_;   // 0 when the input ended mid-sequence
+    
+public:
+    Utf8Error() : valid_up_to_(0), error_len_(0) {}
+    Utf8Error(size_t valid_up_to, uint8_t error_len)
+        : valid_up_to_(valid_up_to), error_len_(error_len) {}
+    
+    // Length of the longest valid prefix
+    size_t valid_up_to() const { return valid_up_to_; }
+    
+    // Length of the invalid sequence at valid_up_to(), or None when the
+    // input ends in a truncated (possibly valid) sequence
+    Option<size_t> error_len() const {
+        if (error_len_ == 0) return None;
+        return Some(static_cast<size_t>(error_len_));
+    }
+    
+    bool operator==(const Utf8Error& other) const {
+        return valid_up_to_ == other.valid_up_to_ && error_len_ == other.error_len_;
+    }
+};
+
+namespace detail {
+
+inline bool utf8_is_cont(unsigned char b) { return (b & 0xC0) == 0x80; }
+
+// Validate bytes as UTF-8, reporting the first error through err
+// ASCII runs are skipped in SIMD chunks; multi-byte sequences follow the
+// Unicode table of well-formed sequences (no overlongs, no surrogates,
+// nothing past U+10FFFF)
+inline bool validate_utf8(const char* bytes, size_t len, Utf8Error& err) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(bytes);
+    size_t i = 0;
+    while (i < len) {
+        unsigned char b = p[i];
+        if (b < 0x80) {
+            i += ascii_prefix_len(bytes + i, len - i);
+            continue;
+        }
+        
+        size_t width;
+        unsigned char lo = 0x80, hi = 0xBF;   // bounds for the second byte
+        if (b >= 0xC2 && b <= 0xDF) {
+            width = 2;
+        } else if (b >= 0xE0 && b <= 0xEF) {
+            width = 3;
+            if (b == 0xE0) lo = 0xA0;
+            if (b == 0xED) hi = 0x9F;
+        } else if (b >= 0xF0 && b <= 0xF4) {
+            width = 4;
+            if (b == 0xF0) lo = 0x90;
+            if (b == 0xF4) hi = 0x8F;
+        } else {
+            err = Utf8Error(i, 1);
+            return false;
+        }
+        
+        for (size_t k = 1; k < width; k++) {
+            if (i + k >= len) {
+                err = Utf8Error(i, 0);
+                return false;
+            }
+            unsigned char c = p[i + k];
+            bool ok = k == 1 ? (c >= lo && c <= hi) : utf8_is_cont(c);
+            if (!ok) {
+                err = Utf8Error(i, static_cast<uint8_t>(k));
+                return false;
+            }
+        }
+        i += width;
+    }
+    return true;
+}
+
+} // namespace detail
+
+// str - borrowed string slice (similar to Rust's &str)
+// This is a non-owning view into a string. Construction, indexing, slicing
+// and comparison are constexpr, so string literals can be used as str in
+// constant expressions.
+class str {
+private:
+    const char* data_;
+    size_t len_;
+    
+public:
+    // Constructors
+    constexpr str() : data_(nullptr), len_(0) {}
+    constexpr str(const char* s) : data_(s), len_(s ? std::char_traits<char>::length(s) : 0) {}
+    constexpr str(const char* s, size_t len) : data_(s), len_(len) {}
+    template<typename Alloc>
+    str(const BasicString<Alloc>& s) : data_(s.as_ptr()), len_(s.len()) {}
+    constexpr str(std::string_view sv) : data_(sv.data()), len_(sv.length()) {}
+    str(const std::string& s) : data_(s.data()), len_(s.length()) {}
+    
+    // Length and emptiness
+    constexpr size_t len() const { return len_; }
+    constexpr bool is_empty() const { return len_ == 0; }
+    
+    // Get as C string (may not be null-terminated!)
+    // @lifetime: (&'a) -> &'a
+    constexpr const char* as_ptr() const { return data_; }
+    
+    // Get as string_view
+    // @lifetime: (&'a) -> &'a
+    constexpr std::string_view as_str() const {
+        return data_ ? std::string_view(data_, len_) : std::string_view();
+    }
+    
+    // Convert to owned String
+    // @lifetime: owned
+    String to_string() const;
+    
+    // Character access
+    // @lifetime: (&'a) -> &'a
+    constexpr const char& operator[](size_t idx) const {
+        RUSTY_BOUNDS_CHECK(idx < len_, "index out of bounds");
+        return data_[idx];
+    }
+    
+    // Byte access without a bounds check, in any build
+    // @unsafe
+    // @lifetime: (&'a) -> &'a
+    constexpr const char& get_unchecked(size_t idx) const { return data_[idx]; }
+    
+    // Get slice of the view
+    // @lifetime: (&'a) -> &'a
+    constexpr str slice(size_t start, size_t end) const {
+        RUSTY_BOUNDS_CHECK(start <= end && end <= len_, "slice range out of bounds");
+        return str(data_ + start, end - start);
+    }
+    
+    // Iterators
+    // @lifetime: (&'a) -> &'a
+    constexpr const char* begin() const { return data_; }
+    // @lifetime: (&'a) -> &'a
+    constexpr const char* end() const { return data_ ? data_ + len_ : nullptr; }
+    
+    // Whitespace trimming, returning a narrower view of the same bytes
+    // @lifetime: (&'a) -> &'a
+    str trim() const { return trim_start().trim_end(); }
+    
+    // @lifetime: (&'a) -> &'a
+    str trim_start() const {
+        size_t start = 0;
+        while (start < len_ && std::isspace(static_cast<unsigned char>(data_[start]))) {
+            start++;
+        }
+        return str(data_ + start, len_ - start);
+    }
+    
+    // @lifetime: (&'a) -> &'a
+    str trim_end() const {
+        size_t end = len_;
+        while (end > 0 && std::isspace(static_cast<unsigned char>(data_[end - 1]))) {
+            end--;
+        }
+        return str(data_, end);
+    }
+    
+    // Byte search (embedded NULs are ordinary bytes)
+    // Offsets are npos (size_t(-1)) when nothing matches
+    size_t find(char ch) const { return find_byte(data_, len_, ch); }
+    size_t find(str needle) const {
+        return find_bytes(data_, len_, needle.data_, needle.len_);
+    }
+    
+    bool contains(char ch) const { return find(ch) != BYTES_NPOS; }
+    bool contains(str needle) const { return find(needle) != BYTES_NPOS; }
+    
+    constexpr bool starts_with(str prefix) const {
+        return prefix.len_ == 0 ||
+               (prefix.len_ <= len_ &&
+                std::char_traits<char>::compare(data_, prefix.data_, prefix.len_) == 0);
+    }
+    
+    constexpr bool ends_with(str suffix) const {
+        return suffix.len_ == 0 ||
+               (suffix.len_ <= len_ &&
+                std::char_traits<char>::compare(data_ + len_ - suffix.len_, suffix.data_,
+                                                suffix.len_) == 0);
+    }
+    
+    bool is_ascii() const { return ascii_prefix_len(data_, len_) == len_; }
+    
+    // Borrow bytes as str after checking they are UTF-8
+    // @lifetime: (&'a) -> &'a
+    static Result<str, Utf8Error> from_utf8(const char* bytes, size_t len) {
+        Utf8Error err;
+        if (!detail::validate_utf8(bytes, len, err)) {
+            return Result<str, Utf8Error>::Err(err);
+        }
+        return Result<str, Utf8Error>::Ok(str(bytes, len));
+    }
+    
+    // Lazy splitting; the pieces borrow from this view's bytes
+    // @lifetime: (&'a) -> &'a
+    Split<char> split(char delim) const;
+    
+    // An empty pattern never matches, so it yields the whole view
+    // @lifetime: (&'a) -> &'a
+    Split<str> split(str pattern) const;
+    
+    // @lifetime: (&'a) -> &'a
+    SplitWhitespace split_whitespace() const;
+    
+    // @lifetime: (&'a) -> &'a
+    Lines lines() const;
+    
+    // Comparison
+    constexpr bool operator==(const str& other) const {
+        if (len_ != other.len_) return false;
+        if (!data_ || !other.data_) return !data_ && !other.data_;
+        return std::char_traits<char>::compare(data_, other.data_, len_) == 0;
+    }
+    
+    constexpr bool operator!=(const str& other) const { return !(*this == other); }
+};
+
+namespace detail {
+
+// Range-for adaptor over a lazy str iterator exposing next()
+template<typename Iter>
+class StrPieces {
 private:
-    char* data_;
-    size_t len_;      // Current length (excluding null terminator)
-    size_t capacity_; // Allocated capacity (including space for null terminator)
+    Iter iter_;
+    str current_;
+    bool done_;
+    
+public:
+    StrPieces() : done_(true) {}
+    explicit StrPieces(const Iter& iter) : iter_(iter), done_(false) {
+        ++*this;
+    }
+    
+    str operator*() const { return current_; }
+    
+    StrPieces& operator++() {
+        Option<str> piece = iter_.next();
+        done_ = piece.is_none();
+        if (!done_) current_ = piece.unwrap();
+        return *this;
+    }
+    
+    bool operator!=(const StrPieces& other) const { return done_ != other.done_; }
+    bool operator==(const StrPieces& other) const { return done_ == other.done_; }
+};
+
+template<typename Iter>
+std::vector<str> collect_pieces(Iter iter) {
+    std::vector<str> pieces;
+    for (Option<str> piece = iter.next(); piece.is_some(); piece = iter.next()) {
+        pieces.push_back(piece.unwrap());
+    }
+    return pieces;
+}
 
-    // Private helper to ensure null termination
-    void ensure_null_terminated() {
-        if (data_ && len_ < capacity_) {
-            data_[len_] = '\0';
+// Pattern matching for Split: offset of the first match, or BYTES_NPOS
+inline size_t find_pattern(const char* hay, size_t len, char delim, size_t& match_len) {
+    match_len = 1;
+    return find_byte(hay, len, delim);
+}
+
+inline size_t find_pattern(const char* hay, size_t len, str pattern, size_t& match_len) {
+    match_len = pattern.len();
+    if (pattern.is_empty()) return BYTES_NPOS;
+    return find_bytes(hay, len, pattern.as_ptr(), pattern.len());
+}
+
+} // namespace detail
+
+// Lazy iterator over the pieces of a str between matches of a pattern
+// Mirrors Rust: "a,b,".split(',') yields "a", "b", ""
+template<typename Pattern>
+class Split {
+private:
+    const char* pos_;
+    const char* end_;
+    Pattern pattern_;
+    bool finished_;
+    
+public:
+    Split() : pos_(nullptr), end_(nullptr), pattern_(), finished_(true) {}
+    Split(str s, Pattern pattern)
+        : pos_(s.as_ptr()), end_(s.as_ptr() + s.len()), pattern_(pattern), finished_(false) {}
+    
+    // @lifetime: (&'a mut) -> &'a
+    Option<str> next() {
+        if (finished_) return None;
+        size_t match_len = 0;
+        size_t remaining = static_cast<size_t>(end_ - pos_);
+        size_t at = detail::find_pattern(pos_, remaining, pattern_, match_len);
+        if (at == BYTES_NPOS) {
+            finished_ = true;
+            return Some(str(pos_, remaining));
         }
+        str piece(pos_, at);
+        pos_ += at + match_len;
+        return Some(piece);
     }
+    
+    using iterator = detail::StrPieces<Split>;
+    // @lifetime: (&'a) -> &'a
+    iterator begin() const { return iterator(*this); }
+    // @lifetime: (&'a) -> &'a
+    iterator end() const { return iterator(); }
+    
+    // Collect the remaining pieces (the views still borrow the source)
+    // @lifetime: (&'a) -> &'a
+    std::vector<str> collect() const { return detail::collect_pieces(*this); }
+};
 
-    // Grow capacity to at least new_cap
+// Lazy iterator over the non-empty runs of non-whitespace bytes
+class SplitWhitespace {
+private:
+    const char* pos_;
+    const char* end_;
+    
+public:
+    SplitWhitespace() : pos_(nullptr), end_(nullptr) {}
+    explicit SplitWhitespace(str s) : pos_(s.as_ptr()), end_(s.as_ptr() + s.len()) {}
+    
+    // @lifetime: (&'a mut) -> &'a
+    Option<str> next() {
+        while (pos_ != end_ && std::isspace(static_cast<unsigned char>(*pos_))) {
+            pos_++;
+        }
+        if (pos_ == end_) return None;
+        const char* start = pos_;
+        while (pos_ != end_ && !std::isspace(static_cast<unsigned char>(*pos_))) {
+            pos_++;
+        }
+        return Some(str(start, pos_ - start));
+    }
+    
+    using iterator = detail::StrPieces<SplitWhitespace>;
+    // @lifetime: (&'a) -> &'a
+    iterator begin() const { return iterator(*this); }
+    // @lifetime: (&'a) -> &'a
+    iterator end() const { return iterator(); }
+    
+    // @lifetime: (&'a) -> &'a
+    std::vector<str> collect() const { return detail::collect_pieces(*this); }
+};
+
+// Lazy iterator over lines ending in "\n" or "\r\n"
+// A final line terminator does not start an extra empty line
+class Lines {
+private:
+    const char* pos_;
+    const char* end_;
+    
+public:
+    Lines() : pos_(nullptr), end_(nullptr) {}
+    explicit Lines(str s) : pos_(s.as_ptr()), end_(s.as_ptr() + s.len()) {}
+    
+    // @lifetime: (&'a mut) -> &'a
+    Option<str> next() {
+        if (pos_ == end_) return None;
+        const char* start = pos_;
+        size_t at = find_byte(pos_, end_ - pos_, '\n');
+        const char* nl = at == BYTES_NPOS ? nullptr : pos_ + at;
+        const char* line_end = nl ? nl : end_;
+        pos_ = nl ? line_end + 1 : end_;
+        if (nl && line_end != start && line_end[-1] == '\r') {
+            line_end--;
+        }
+        return Some(str(start, line_end - start));
+    }
+    
+    using iterator = detail::StrPieces<Lines>;
+    // @lifetime: (&'a) -> &'a
+    iterator begin() const { return iterator(*this); }
+    // @lifetime: (&'a) -> &'a
+    iterator end() const { return iterator(); }
+    
+    // @lifetime: (&'a) -> &'a
+    std::vector<str> collect() const { return detail::collect_pieces(*this); }
+};
+
+inline Split<char> str::split(char delim) const {
+    return Split<char>(*this, delim);
+}
+
+inline Split<str> str::split(str pattern) const {
+    return Split<str>(*this, pattern);
+}
+
+inline SplitWhitespace str::split_whitespace() const {
+    return SplitWhitespace(*this);
+}
+
+inline Lines str::lines() const {
+    return Lines(*this);
+}
+
+// @safe
+// Rust-like owned String type
+// Manages a growable UTF-8 string
+// Storage comes from the Alloc parameter (see alloc.hpp); rusty::String is
+// BasicString<Global>
+//
+// Small-string optimization: strings of up to INLINE_CAPACITY bytes (23 on
+// 64-bit targets) live inside the object, so the common short string costs
+// no allocation while String stays three words. The last byte of the
+// object is the tag: for inline strings it holds INLINE_CAPACITY - len,
+// which is 0 and doubles as the null terminator when the buffer is full;
+// for heap strings its high bit is set (it is the top byte of the encoded
+// capacity). No pointer ever aims at the inline buffer, so a String stays
+// trivially relocatable. RUSTY_STATS builds add two counters after the
+// three words.
+template<typename Alloc>
+class BasicString : private detail::AllocHolder<Alloc> {
+private:
+    using String = BasicString;
+    
+    struct Heap {
+        char* ptr;
+        size_t len;       // Current length (excluding null terminator)
+        size_t cap;       // Encoded allocated capacity (including null terminator)
+    };
+    
+    static constexpr size_t REP_SIZE = sizeof(Heap);
+    static constexpr unsigned char HEAP_TAG = 0x80;
+    
+    union {
+        Heap heap_;
+        char inline_[REP_SIZE];
+    };
+#if defined(RUSTY_STATS)
+    stats::GrowthCounters growth_stats_;
+#endif
+    
+public:
+    static constexpr size_t INLINE_CAPACITY = REP_SIZE - 1;
+    
+private:
+    // The heap capacity is stored so that the byte overlapping the tag has
+    // HEAP_TAG set, whatever the byte order
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    static size_t encode_cap(size_t cap) { return (cap << 8) | HEAP_TAG; }
+    static size_t decode_cap(size_t field) { return field >> 8; }
+#else
+    static constexpr size_t CAP_FLAG = size_t(HEAP_TAG) << (8 * (sizeof(size_t) - 1));
+    static size_t encode_cap(size_t cap) { return cap | CAP_FLAG; }
+    static size_t decode_cap(size_t field) { return field & ~CAP_FLAG; }
+#endif
+    
+    unsigned char tag() const {
+        return static_cast<unsigned char>(inline_[INLINE_CAPACITY]);
+    }
+    
+    bool on_heap() const { return (tag() & HEAP_TAG) != 0; }
+    
+    void set_empty_inline() {
+        inline_[0] = '\0';
+        inline_[INLINE_CAPACITY] = static_cast<char>(INLINE_CAPACITY);
+    }
+    
+    char* ptr() { return on_heap() ? heap_.ptr : inline_; }
+    const char* ptr() const { return on_heap() ? heap_.ptr : inline_; }
+    
+    // Bytes available including the null terminator
+    size_t cap_bytes() const {
+        return on_heap() ? decode_cap(heap_.cap) : INLINE_CAPACITY + 1;
+    }
+    
+    // Set the length and write the null terminator
+    void set_len(size_t len) {
+        if (on_heap()) {
+            heap_.len = len;
+            heap_.ptr[len] = '\0';
+        } else {
+            inline_[len] = '\0';
+            inline_[INLINE_CAPACITY] = static_cast<char>(INLINE_CAPACITY - len);
+        }
+    }
+    
+    // Return the buffer to the allocator
+    void release() {
+        if (on_heap()) {
+            detail::observe_dealloc(AllocKind::String, heap_.ptr, decode_cap(heap_.cap));
+            this->alloc().deallocate(heap_.ptr, decode_cap(heap_.cap), 1);
+        }
+    }
+    
+    // Grow capacity to at least new_cap bytes (including the terminator)
     void grow(size_t new_cap) {
-        if (new_cap <= capacity_) return;
+        if (try_grow(new_cap).is_err()) throw std::bad_alloc();
+    }
+    
+    // As grow, but reports failure; the string is unchanged on Err
+    Result<void, AllocError> try_grow(size_t new_cap) {
+        size_t old_cap = cap_bytes();
+        if (new_cap <= old_cap) return Result<void, AllocError>::Ok();
+        if (new_cap > SIZE_MAX / 4) {
+            return Result<void, AllocError>::Err(AllocError::capacity_overflow());
+        }
         
         // Round up to next power of 2 for better performance
-        size_t actual_cap = 16;
+        size_t actual_cap = 2 * (INLINE_CAPACITY + 1);
         while (actual_cap < new_cap) {
             actual_cap *= 2;
         }
         
-        char* new_data = static_cast<char*>(std::malloc(actual_cap));
-        if (!new_data) {
-            throw std::bad_alloc();
+        size_t length = len();
+        char* data;
+        if (on_heap()) {
+            data = static_cast<char*>(detail::alloc_reallocate(this->alloc(), heap_.ptr, old_cap,
+                                                               actual_cap, 1,
+                                                               alloc_has_reallocate<Alloc>()));
+        } else {
+            data = static_cast<char*>(this->alloc().allocate(actual_cap, 1));
+            if (data) std::memcpy(data, inline_, length + 1);
         }
-        
-        if (data_) {
-            std::memcpy(new_data, data_, len_);
-            std::free(data_);
+        if (!data) {
+            AllocError err = {actual_cap, 1};
+            return Result<void, AllocError>::Err(err);
         }
-        
-        data_ = new_data;
-        capacity_ = actual_cap;
-        ensure_null_terminated();
+        detail::observe_realloc(AllocKind::String, on_heap() ? heap_.ptr : nullptr, old_cap,
+                                data, actual_cap);
+#if defined(RUSTY_STATS)
+        // Leaving the inline buffer counts once it held something
+        if (on_heap() || length != 0) {
+            bool moved = !on_heap() || data != heap_.ptr;
+            growth_stats_.record(moved ? length + 1 : 0, stats::totals().string);
+        }
+#endif
+        heap_.ptr = data;
+        heap_.len = length;
+        heap_.cap = encode_cap(actual_cap);
+        return Result<void, AllocError>::Ok();
     }
-
+    
+    // Append raw bytes
+    void push_bytes(const char* bytes, size_t count) {
+        size_t length = len();
+        if (length + count >= cap_bytes()) {
+            grow(length + count + 1);
+        }
+        std::memcpy(ptr() + length, bytes, count);
+        set_len(length + count);
+    }
+    
+    // @lifetime: owned
+    String from_bytes(const char* bytes, size_t count) const {
+        String s(this->alloc());
+        s.push_bytes(bytes, count);
+        return s;
+    }
+    
 public:
     // Constructors
-    String() : data_(nullptr), len_(0), capacity_(0) {}
+    BasicString() {
+        set_empty_inline();
+    }
+    
+    explicit BasicString(const Alloc& alloc) : detail::AllocHolder<Alloc>(alloc) {
+        set_empty_inline();
+    }
     
     // @lifetime: owned
     static String new_() {
         return String();
     }
     
+    // @lifetime: owned
+    static String new_in(const Alloc& alloc) {
+        return String(alloc);
+    }
+    
     // @lifetime: owned
     static String with_capacity(size_t cap) {
-        String s;
+        return with_capacity_in(cap, Alloc());
+    }
+    
+    // @lifetime: owned
+    static String with_capacity_in(size_t cap, const Alloc& alloc) {
+        String s(alloc);
         s.grow(cap + 1); // +1 for null terminator
         return s;
     }
     
+    // String::try_with_capacity(): Err instead of throwing std::bad_alloc
+    // @lifetime: owned
+    static Result<String, AllocError> try_with_capacity(size_t cap) {
+        String s;
+        Result<void, AllocError> grown = s.try_reserve(cap);
+        if (grown.is_err()) {
+            return Result<String, AllocError>::Err(grown.unwrap_err());
+        }
+        return Result<String, AllocError>::Ok(std::move(s));
+    }
+    
     // @lifetime: owned
     static String from(const char* cstr) {
-        if (!cstr) return String();
-        
-        size_t len = std::strlen(cstr);
         String s;
-        s.grow(len + 1);
-        std::memcpy(s.data_, cstr, len);
-        s.len_ = len;
-        s.ensure_null_terminated();
+        if (cstr) {
+            s.push_bytes(cstr, std::strlen(cstr));
+        }
         return s;
     }
     
     // @lifetime: owned
     static String from(const std::string& str) {
-        return String::from(str.c_str());
+        String s;
+        s.push_bytes(str.data(), str.length());
+        return s;
     }
     
     // @lifetime: owned
     static String from(std::string_view sv) {
         String s;
-        s.grow(sv.length() + 1);
-        std::memcpy(s.data_, sv.data(), sv.length());
-        s.len_ = sv.length();
-        s.ensure_null_terminated();
+        s.push_bytes(sv.data(), sv.length());
         return s;
     }
     
+    // Copy bytes into a String after checking they are UTF-8
+    // @lifetime: owned
+    static Result<String, Utf8Error> from_utf8(str bytes) {
+        Utf8Error err;
+        if (!detail::validate_utf8(bytes.as_ptr(), bytes.len(), err)) {
+            return Result<String, Utf8Error>::Err(err);
+        }
+        String s;
+        s.push_bytes(bytes.as_ptr(), bytes.len());
+        return Result<String, Utf8Error>::Ok(std::move(s));
+    }
+    
+    // Bytes as text, each invalid sequence replaced by U+FFFD; valid input
+    // is borrowed, so only malformed bytes cost an allocation
+    // @lifetime: (&'a) -> &'a
+    static Cow<str, String> from_utf8_lossy(str bytes) {
+        Utf8Error err;
+        const char* data = bytes.as_ptr();
+        size_t length = bytes.len();
+        if (detail::validate_utf8(data, length, err)) return Cow<str, String>::Borrowed(bytes);
+        
+        String s;
+        s.reserve(length + 2);
+        for (;;) {
+            s.push_bytes(data, err.valid_up_to());
+            s.push_bytes("\xEF\xBF\xBD", 3);
+            Option<size_t> bad = err.error_len();
+            if (bad.is_none()) break;  // truncated sequence at the end
+            size_t skip = err.valid_up_to() + bad.unwrap();
+            data += skip;
+            length -= skip;
+            if (detail::validate_utf8(data, length, err)) {
+                s.push_bytes(data, length);
+                break;
+            }
+        }
+        return Cow<str, String>::Owned(std::move(s));
+    }
+    
     // Move constructor (String is move-only)
-    String(String&& other) noexcept 
-        : data_(other.data_), len_(other.len_), capacity_(other.capacity_) {
-        other.data_ = nullptr;
-        other.len_ = 0;
-        other.capacity_ = 0;
+    BasicString(BasicString&& other) noexcept 
+        : detail::AllocHolder<Alloc>(std::move(other.alloc()))
+#if defined(RUSTY_STATS)
+          , growth_stats_(other.growth_stats_)
+#endif
+    {
+        std::memcpy(static_cast<void*>(&heap_), &other.heap_, REP_SIZE);
+        other.set_empty_inline();
     }
     
     // Move assignment
-    String& operator=(String&& other) noexcept {
+    BasicString& operator=(BasicString&& other) noexcept {
         if (this != &other) {
-            if (data_) {
-                std::free(data_);
-            }
-            data_ = other.data_;
-            len_ = other.len_;
-            capacity_ = other.capacity_;
-            
-            other.data_ = nullptr;
-            other.len_ = 0;
-            other.capacity_ = 0;
+            release();
+            // The allocator moves with its storage
+            this->alloc() = std::move(other.alloc());
+            std::memcpy(static_cast<void*>(&heap_), &other.heap_, REP_SIZE);
+#if defined(RUSTY_STATS)
+            growth_stats_ = other.growth_stats_;
+#endif
+            other.set_empty_inline();
         }
         return *this;
     }
     
     // Delete copy constructor and copy assignment
-    String(const String&) = delete;
-    String& operator=(const String&) = delete;
+    BasicString(const BasicString&) = delete;
+    BasicString& operator=(const BasicString&) = delete;
     
     // Destructor
-    ~String() {
-        if (data_) {
-            std::free(data_);
-        }
+    ~BasicString() {
+        release();
     }
     
     // Clone method for explicit copying
     // @lifetime: owned
     String clone() const {
-        if (!data_) return String();
-        
-        String s;
-        s.grow(capacity_);
-        std::memcpy(s.data_, data_, len_);
-        s.len_ = len_;
-        s.ensure_null_terminated();
-        return s;
+        return from_bytes(ptr(), len());
     }
     
     // Capacity and length
-    size_t len() const { return len_; }
-    size_t capacity() const { return capacity_ > 0 ? capacity_ - 1 : 0; } // Exclude null terminator
-    bool is_empty() const { return len_ == 0; }
+    size_t len() const {
+        return on_heap() ? heap_.len : INLINE_CAPACITY - tag();
+    }
+    size_t capacity() const { return cap_bytes() - 1; } // Exclude null terminator
+    
+    // Length and capacity; reallocations and bytes_copied need RUSTY_STATS
+    stats::GrowthStats stats() const {
+        stats::GrowthStats s = stats::GrowthStats();
+        s.len = len();
+        s.capacity = capacity();
+#if defined(RUSTY_STATS)
+        s.reallocations = growth_stats_.reallocations;
+        s.bytes_copied = growth_stats_.bytes_copied;
+#endif
+        return s;
+    }
+    bool is_empty() const { return len() == 0; }
+    
+    // True while the contents fit in the object itself
+    bool is_inline() const { return !on_heap(); }
     
     // Reserve capacity
     void reserve(size_t additional) {
-        grow(len_ + additional + 1);
+        grow(len() + additional + 1);
+    }
+    
+    // Reserve, reporting failure instead of throwing
+    Result<void, AllocError> try_reserve(size_t additional) {
+        if (additional > SIZE_MAX / 4) {
+            return Result<void, AllocError>::Err(AllocError::capacity_overflow());
+        }
+        return try_grow(len() + additional + 1);
+    }
+    
+    // Append s, or report allocation failure and leave the string unchanged
+    Result<void, AllocError> try_push_str(str s) {
+        Result<void, AllocError> grown = try_reserve(s.len());
+        if (grown.is_ok()) push_bytes(s.as_ptr(), s.len());
+        return grown;
     }
     
     // Clear the string
     void clear() {
-        len_ = 0;
-        ensure_null_terminated();
+        set_len(0);
     }
     
     // Push a single character
     void push(char ch) {
-        if (len_ + 1 >= capacity_) {
-            grow(len_ + 2); // +1 for char, +1 for null
+        size_t length = len();
+        if (length + 1 >= cap_bytes()) {
+            grow(length + 2); // +1 for char, +1 for null
         }
-        data_[len_++] = ch;
-        ensure_null_terminated();
+        ptr()[length] = ch;
+        set_len(length + 1);
     }
     
     // Push a string slice
     void push_str(const char* str) {
         if (!str) return;
-        
-        size_t str_len = std::strlen(str);
-        if (len_ + str_len >= capacity_) {
-            grow(len_ + str_len + 1);
-        }
-        std::memcpy(data_ + len_, str, str_len);
-        len_ += str_len;
-        ensure_null_terminated();
+        push_bytes(str, std::strlen(str));
     }
     
     void push_str(const String& other) {
-        if (!other.data_) return;
-        
-        if (len_ + other.len_ >= capacity_) {
-            grow(len_ + other.len_ + 1);
-        }
-        std::memcpy(data_ + len_, other.data_, other.len_);
-        len_ += other.len_;
-        ensure_null_terminated();
+        push_bytes(other.ptr(), other.len());
+    }
+    
+    void push_str(str s) {
+        push_bytes(s.as_ptr(), s.len());
     }
     
     // Pop character from end
     char pop() {
-        if (len_ == 0) {
-            throw std::out_of_range("pop from empty String");
-        }
-        char ch = data_[--len_];
-        ensure_null_terminated();
+        size_t length = len();
+        RUSTY_BOUNDS_CHECK(length > 0, "pop from empty String");
+        char ch = ptr()[length - 1];
+        set_len(length - 1);
         return ch;
     }
     
     // Truncate to new length
     void truncate(size_t new_len) {
-        if (new_len < len_) {
-            len_ = new_len;
-            ensure_null_terminated();
+        if (new_len < len()) {
+            set_len(new_len);
         }
     }
     
     // Insert string at position
     void insert(size_t idx, const char* str) {
         if (!str) return;
-        if (idx > len_) {
-            throw std::out_of_range("insert index out of bounds");
-        }
+        size_t length = len();
+        RUSTY_BOUNDS_CHECK(idx <= length, "insert index out of bounds");
         
         size_t str_len = std::strlen(str);
-        if (len_ + str_len >= capacity_) {
-            grow(len_ + str_len + 1);
+        if (length + str_len >= cap_bytes()) {
+            grow(length + str_len + 1);
         }
         
         // Move existing data
-        if (idx < len_) {
-            std::memmove(data_ + idx + str_len, data_ + idx, len_ - idx);
+        char* data = ptr();
+        if (idx < length) {
+            std::memmove(data + idx + str_len, data + idx, length - idx);
         }
         
         // Insert new data
-        std::memcpy(data_ + idx, str, str_len);
-        len_ += str_len;
-        ensure_null_terminated();
+        std::memcpy(data + idx, str, str_len);
+        set_len(length + str_len);
     }
     
     // Remove range [start, end)
     void drain(size_t start, size_t end) {
-        if (start > end || end > len_) {
-            throw std::out_of_range("drain range out of bounds");
-        }
+        size_t length = len();
+        RUSTY_BOUNDS_CHECK(start <= end && end <= length, "drain range out of bounds");
         
         size_t remove_len = end - start;
         if (remove_len == 0) return;
         
         // Move data after the range
-        if (end < len_) {
-            std::memmove(data_ + start, data_ + end, len_ - end);
+        char* data = ptr();
+        if (end < length) {
+            std::memmove(data + start, data + end, length - end);
         }
         
-        len_ -= remove_len;
-        ensure_null_terminated();
+        set_len(length - remove_len);
     }
     
     // Get C string (null-terminated)
     // @lifetime: (&'a) -> &'a
     const char* as_ptr() const {
-        return data_ ? data_ : "";
+        return ptr();
     }
     
     // @lifetime: (&'a) -> &'a
@@ -272,96 +870,85 @@ public:
     // Get as string_view
     // @lifetime: (&'a) -> &'a
     std::string_view as_str() const {
-        return data_ ? std::string_view(data_, len_) : std::string_view();
+        return std::string_view(ptr(), len());
     }
     
     // Convert to std::string (copies data)
     // @lifetime: owned
     std::string to_string() const {
-        return data_ ? std::string(data_, len_) : std::string();
+        return std::string(ptr(), len());
     }
     
     // Character access
     // @lifetime: (&'a) -> &'a
     const char& operator[](size_t idx) const {
-        if (idx >= len_) {
-            throw std::out_of_range("index out of bounds");
-        }
-        return data_[idx];
+        RUSTY_BOUNDS_CHECK(idx < len(), "index out of bounds");
+        return ptr()[idx];
     }
     
     // @lifetime: (&'a mut) -> &'a mut
     char& operator[](size_t idx) {
-        if (idx >= len_) {
-            throw std::out_of_range("index out of bounds");
-        }
-        return data_[idx];
+        RUSTY_BOUNDS_CHECK(idx < len(), "index out of bounds");
+        return ptr()[idx];
     }
     
+    // Byte access without a bounds check, in any build
+    // @unsafe
+    // @lifetime: (&'a) -> &'a
+    const char& get_unchecked(size_t idx) const { return ptr()[idx]; }
+    
+    // @unsafe
+    // @lifetime: (&'a mut) -> &'a mut
+    char& get_unchecked_mut(size_t idx) { return ptr()[idx]; }
+    
     // Get slice of string
     // @lifetime: (&'a) -> &'a
     std::string_view slice(size_t start, size_t end) const {
-        if (start > end || end > len_) {
-            throw std::out_of_range("slice range out of bounds");
-        }
-        return std::string_view(data_ + start, end - start);
+        RUSTY_BOUNDS_CHECK(start <= end && end <= len(), "slice range out of bounds");
+        return std::string_view(ptr() + start, end - start);
     }
     
     // Iterators
     // @lifetime: (&'a) -> &'a
-    const char* begin() const { return data_ ? data_ : ""; }
+    const char* begin() const { return ptr(); }
     // @lifetime: (&'a) -> &'a
-    const char* end() const { return data_ ? data_ + len_ : ""; }
+    const char* end() const { return ptr() + len(); }
     
     // @lifetime: (&'a mut) -> &'a mut
-    char* begin() { return data_; }
+    char* begin() { return ptr(); }
     // @lifetime: (&'a mut) -> &'a mut  
-    char* end() { return data_ ? data_ + len_ : nullptr; }
+    char* end() { return ptr() + len(); }
     
     // Comparison operators
     bool operator==(const String& other) const {
-        if (len_ != other.len_) return false;
-        if (!data_ && !other.data_) return true;
-        if (!data_ || !other.data_) return false;
-        return std::memcmp(data_, other.data_, len_) == 0;
+        size_t length = len();
+        return length == other.len() && std::memcmp(ptr(), other.ptr(), length) == 0;
     }
     
     bool operator==(const char* cstr) const {
-        if (!cstr) return !data_ || len_ == 0;
-        if (!data_) return std::strlen(cstr) == 0;  // Empty string equals empty cstring
-        
+        if (!cstr) return is_empty();
         size_t cstr_len = std::strlen(cstr);
-        if (len_ != cstr_len) return false;
-        if (len_ == 0) return true;  // Both empty
-        return std::memcmp(data_, cstr, len_) == 0;
+        return len() == cstr_len && std::memcmp(ptr(), cstr, cstr_len) == 0;
     }
     
     bool operator!=(const String& other) const { return !(*this == other); }
     bool operator!=(const char* cstr) const { return !(*this == cstr); }
     
     bool operator<(const String& other) const {
-        if (!data_ && !other.data_) return false;
-        if (!data_) return true;
-        if (!other.data_) return false;
-        
-        int cmp = std::memcmp(data_, other.data_, std::min(len_, other.len_));
+        size_t length = len();
+        size_t other_len = other.len();
+        int cmp = std::memcmp(ptr(), other.ptr(), std::min(length, other_len));
         if (cmp != 0) return cmp < 0;
-        return len_ < other.len_;
+        return length < other_len;
     }
     
     // String concatenation
     // @lifetime: owned
     String operator+(const String& other) const {
-        String result;
-        result.grow(len_ + other.len_ + 1);
-        if (data_) {
-            std::memcpy(result.data_, data_, len_);
-        }
-        if (other.data_) {
-            std::memcpy(result.data_ + len_, other.data_, other.len_);
-        }
-        result.len_ = len_ + other.len_;
-        result.ensure_null_terminated();
+        String result(this->alloc());
+        result.grow(len() + other.len() + 1);
+        result.push_bytes(ptr(), len());
+        result.push_bytes(other.ptr(), other.len());
         return result;
     }
     
@@ -381,242 +968,221 @@ public:
         return *this;
     }
     
-    // Check if string contains substring
-    bool contains(const char* needle) const {
-        if (!needle || !data_) return false;
-        return std::strstr(data_, needle) != nullptr;
-    }
+    // Substring search over the bytes (embedded NULs included)
+    bool contains(str needle) const { return str(*this).contains(needle); }
+    bool contains(char ch) const { return str(*this).contains(ch); }
     
-    bool starts_with(const char* prefix) const {
-        if (!prefix || !data_) return !prefix;
-        size_t prefix_len = std::strlen(prefix);
-        if (prefix_len > len_) return false;
-        return std::memcmp(data_, prefix, prefix_len) == 0;
-    }
+    bool starts_with(str prefix) const { return str(*this).starts_with(prefix); }
+    bool ends_with(str suffix) const { return str(*this).ends_with(suffix); }
     
-    bool ends_with(const char* suffix) const {
-        if (!suffix || !data_) return !suffix;
-        size_t suffix_len = std::strlen(suffix);
-        if (suffix_len > len_) return false;
-        return std::memcmp(data_ + len_ - suffix_len, suffix, suffix_len) == 0;
-    }
+    // Offset of the first match, or npos (size_t(-1))
+    size_t find(str needle) const { return str(*this).find(needle); }
+    size_t find(char ch) const { return str(*this).find(ch); }
     
-    // Find substring
-    size_t find(const char* needle) const {
-        if (!needle || !data_) return static_cast<size_t>(-1);
-        const char* pos = std::strstr(data_, needle);
-        if (!pos) return static_cast<size_t>(-1);
-        return pos - data_;
+    // Replace all occurrences; borrows this String when nothing matches
+    // (or from is empty), so a no-op replace never allocates
+    // @lifetime: (&'a) -> &'a
+    Cow<str, String> replace(str from, str to) const& {
+        size_t count = count_matches(from);
+        if (count == 0) return Cow<str, String>::Borrowed(*this);
+        return Cow<str, String>::Owned(replaced(from, to, count));
     }
     
-    // Replace all occurrences
+    // A temporary is handed back as the owned value when nothing matches
     // @lifetime: owned
-    String replace(const char* from, const char* to) const {
-        if (!from || !to || !data_) return clone();
-        
-        size_t from_len = std::strlen(from);
-        size_t to_len = std::strlen(to);
-        if (from_len == 0) return clone();
-        
-        // Count occurrences
-        size_t count = 0;
-        const char* pos = data_;
-        while ((pos = std::strstr(pos, from)) != nullptr) {
-            count++;
-            pos += from_len;
-        }
-        
-        if (count == 0) return clone();
-        
-        // Calculate new length
-        size_t new_len = len_ + count * (to_len - from_len);
-        
-        String result;
-        result.grow(new_len + 1);
-        
-        const char* src = data_;
-        char* dst = result.data_;
-        
-        while ((pos = std::strstr(src, from)) != nullptr) {
-            size_t prefix_len = pos - src;
-            std::memcpy(dst, src, prefix_len);
-            dst += prefix_len;
-            std::memcpy(dst, to, to_len);
-            dst += to_len;
-            src = pos + from_len;
-        }
-        
-        // Copy remainder
-        size_t remainder = data_ + len_ - src;
-        std::memcpy(dst, src, remainder);
-        
-        result.len_ = new_len;
-        result.ensure_null_terminated();
-        return result;
+    Cow<str, String> replace(str from, str to) && {
+        size_t count = count_matches(from);
+        if (count == 0) return Cow<str, String>::Owned(std::move(*this));
+        return Cow<str, String>::Owned(replaced(from, to, count));
     }
     
-    // Trim whitespace
-    // @lifetime: owned
-    String trim() const {
-        if (!data_ || len_ == 0) return String();
-        
-        size_t start = 0;
-        while (start < len_ && std::isspace(data_[start])) {
-            start++;
-        }
-        
-        if (start == len_) return String();
-        
-        size_t end = len_;
-        while (end > start && std::isspace(data_[end - 1])) {
-            end--;
-        }
-        
-        String result;
-        size_t new_len = end - start;
-        if (new_len > 0) {  // Check for valid length
-            result.grow(new_len + 1);
-            std::memcpy(result.data_, data_ + start, new_len);
-            result.len_ = new_len;
-            result.ensure_null_terminated();
+    // Whitespace trimming; the result borrows from this String
+    // @lifetime: (&'a) -> &'a
+    str trim() const { return str(*this).trim(); }
+    
+    // @lifetime: (&'a) -> &'a
+    str trim_start() const { return str(*this).trim_start(); }
+    
+    // @lifetime: (&'a) -> &'a
+    str trim_end() const { return str(*this).trim_end(); }
+    
+    // Lazy splitting; no piece is copied or allocated
+    // @lifetime: (&'a) -> &'a
+    Split<char> split(char delim) const { return str(*this).split(delim); }
+    
+    // @lifetime: (&'a) -> &'a
+    Split<str> split(str pattern) const { return str(*this).split(pattern); }
+    
+    // @lifetime: (&'a) -> &'a
+    SplitWhitespace split_whitespace() const { return str(*this).split_whitespace(); }
+    
+    // @lifetime: (&'a) -> &'a
+    Lines lines() const { return str(*this).lines(); }
+    
+    // In-place ASCII case conversion (bytes >= 0x80 are left alone)
+    void make_ascii_uppercase() {
+        char* data = ptr();
+        for (size_t i = 0, n = len(); i < n; i++) {
+            if (data[i] >= 'a' && data[i] <= 'z') data[i] = static_cast<char>(data[i] - ('a' - 'A'));
         }
-        return result;
     }
     
-    // Split string by delimiter
-    // @lifetime: owned
-    std::vector<String> split(char delim) const {
-        std::vector<String> result;
-        if (!data_ || len_ == 0) return result;
-        
-        size_t start = 0;
-        for (size_t i = 0; i < len_; i++) {
-            if (data_[i] == delim) {
-                String part;
-                size_t part_len = i - start;
-                if (part_len > 0) {
-                    part.grow(part_len + 1);
-                    std::memcpy(part.data_, data_ + start, part_len);
-                    part.len_ = part_len;
-                    part.ensure_null_terminated();
-                }
-                result.push_back(std::move(part));
-                start = i + 1;
-            }
-        }
-        
-        // Add last part
-        if (start < len_) {
-            String part;
-            size_t part_len = len_ - start;
-            if (part_len > 0) {  // Check for valid length
-                part.grow(part_len + 1);
-                std::memcpy(part.data_, data_ + start, part_len);
-                part.len_ = part_len;
-                part.ensure_null_terminated();
-            }
-            result.push_back(std::move(part));
-        } else if (start == len_ && len_ > 0 && data_[len_ - 1] == delim) {
-            // If string ends with delimiter, add empty part
-            result.push_back(String());
+    void make_ascii_lowercase() {
+        char* data = ptr();
+        for (size_t i = 0, n = len(); i < n; i++) {
+            if (data[i] >= 'A' && data[i] <= 'Z') data[i] = static_cast<char>(data[i] + ('a' - 'A'));
         }
-        
-        return result;
     }
     
-    // Convert to uppercase
-    // @lifetime: owned
-    String to_uppercase() const {
+    // Convert to uppercase; borrows this String when it has no ASCII
+    // lowercase letter
+    // @lifetime: (&'a) -> &'a
+    Cow<str, String> to_uppercase() const& {
+        if (!contains_byte_in('a', 'z')) return Cow<str, String>::Borrowed(*this);
         String result = clone();
-        for (size_t i = 0; i < result.len_; i++) {
-            result.data_[i] = std::toupper(result.data_[i]);
-        }
-        return result;
+        result.make_ascii_uppercase();
+        return Cow<str, String>::Owned(std::move(result));
     }
     
-    // Convert to lowercase
+    // Converts a temporary in place
     // @lifetime: owned
-    String to_lowercase() const {
+    Cow<str, String> to_uppercase() && {
+        make_ascii_uppercase();
+        return Cow<str, String>::Owned(std::move(*this));
+    }
+    
+    // Convert to lowercase; borrows this String when it has no ASCII
+    // uppercase letter
+    // @lifetime: (&'a) -> &'a
+    Cow<str, String> to_lowercase() const& {
+        if (!contains_byte_in('A', 'Z')) return Cow<str, String>::Borrowed(*this);
         String result = clone();
-        for (size_t i = 0; i < result.len_; i++) {
-            result.data_[i] = std::tolower(result.data_[i]);
-        }
-        return result;
+        result.make_ascii_lowercase();
+        return Cow<str, String>::Owned(std::move(result));
+    }
+    
+    // Converts a temporary in place
+    // @lifetime: owned
+    Cow<str, String> to_lowercase() && {
+        make_ascii_lowercase();
+        return Cow<str, String>::Owned(std::move(*this));
     }
     
     // Friend function for stream output
-    friend std::ostream& operator<<(std::ostream& os, const String& s) {
-        if (s.data_) {
-            os.write(s.data_, s.len_);
-        }
+    template<typename Traits>
+    friend std::basic_ostream<char, Traits>& operator<<(std::basic_ostream<char, Traits>& os,
+                                                        const String& s) {
+        os.write(s.ptr(), s.len());
         return os;
     }
-};
 
-// str - borrowed string slice (similar to Rust's &str)
-// This is a non-owning view into a string
-class str {
 private:
-    const char* data_;
-    size_t len_;
-    
-public:
-    // Constructors
-    str() : data_(nullptr), len_(0) {}
-    str(const char* s) : data_(s), len_(s ? std::strlen(s) : 0) {}
-    str(const char* s, size_t len) : data_(s), len_(len) {}
-    str(const String& s) : data_(s.as_ptr()), len_(s.len()) {}
-    str(std::string_view sv) : data_(sv.data()), len_(sv.length()) {}
-    
-    // Length and emptiness
-    size_t len() const { return len_; }
-    bool is_empty() const { return len_ == 0; }
-    
-    // Get as C string (may not be null-terminated!)
-    // @lifetime: (&'a) -> &'a
-    const char* as_ptr() const { return data_; }
-    
-    // Get as string_view
-    // @lifetime: (&'a) -> &'a
-    std::string_view as_str() const {
-        return data_ ? std::string_view(data_, len_) : std::string_view();
+    // Non-overlapping occurrences of from; 0 when from is empty
+    size_t count_matches(str from) const {
+        if (from.is_empty()) return 0;
+        const char* data = ptr();
+        size_t length = len();
+        size_t count = 0;
+        size_t pos = 0;
+        for (;;) {
+            size_t at = find_bytes(data + pos, length - pos, from.as_ptr(), from.len());
+            if (at == BYTES_NPOS) break;
+            count++;
+            pos += at + from.len();
+        }
+        return count;
     }
     
-    // Convert to owned String
-    // @lifetime: owned
-    String to_string() const {
-        String s;
-        if (data_ && len_ > 0) {
-            s = String::with_capacity(len_);
-            s.push_str(std::string_view(data_, len_).data());
+    // Copy with every occurrence of from replaced, sized once from count
+    String replaced(str from, str to, size_t count) const {
+        const char* data = ptr();
+        size_t length = len();
+        String result(this->alloc());
+        result.grow(length - count * from.len() + count * to.len() + 1);
+        
+        size_t pos = 0;
+        for (;;) {
+            size_t at = find_bytes(data + pos, length - pos, from.as_ptr(), from.len());
+            if (at == BYTES_NPOS) break;
+            result.push_bytes(data + pos, at);
+            result.push_bytes(to.as_ptr(), to.len());
+            pos += at + from.len();
         }
-        return s;
+        
+        // Copy remainder
+        result.push_bytes(data + pos, length - pos);
+        return result;
     }
     
-    // Character access
-    // @lifetime: (&'a) -> &'a
-    const char& operator[](size_t idx) const {
-        if (idx >= len_) {
-            throw std::out_of_range("index out of bounds");
+    bool contains_byte_in(char lo, char hi) const {
+        const char* data = ptr();
+        for (size_t i = 0, n = len(); i < n; i++) {
+            if (data[i] >= lo && data[i] <= hi) return true;
         }
-        return data_[idx];
+        return false;
     }
-    
-    // Iterators
-    // @lifetime: (&'a) -> &'a
-    const char* begin() const { return data_; }
+};
+
+inline String str::to_string() const {
+    return String::from(as_str());
+}
+
+// A borrowed str becomes owned with a default-constructed allocator
+template<typename Alloc>
+struct cow_traits<str, BasicString<Alloc>> {
     // @lifetime: (&'a) -> &'a
-    const char* end() const { return data_ ? data_ + len_ : nullptr; }
+    static str borrow(const BasicString<Alloc>& owned) { return owned; }
+
+    // @lifetime: owned
+    static BasicString<Alloc> to_owned(str borrowed) {
+        BasicString<Alloc> s;
+        s.push_str(borrowed);
+        return s;
+    }
+};
+
+// String holds either inline bytes or a pointer to its heap buffer (plus its
+// allocator), never a pointer into itself, so it can be relocated bitwise
+// whenever the allocator can
+template<typename Alloc>
+struct is_trivially_relocatable<BasicString<Alloc>> : is_trivially_relocatable<Alloc> {};
+
+// Transparent hashing and comparison for string keys
+// They take any String, str, std::string_view or const char*, so maps with
+// String keys can be queried without allocating a temporary String:
+//   HashMap<String, int, StringHash, StringEq> counts;
+//   counts.get("key");
+//   BTreeMap<String, int, StringLess> sorted;
+//   sorted.get(std::string_view("key"));
+struct StringHash {
+    using is_transparent = void;
     
-    // Comparison
-    bool operator==(const str& other) const {
-        if (len_ != other.len_) return false;
-        if (!data_ && !other.data_) return true;
-        if (!data_ || !other.data_) return false;
-        return std::memcmp(data_, other.data_, len_) == 0;
+    size_t operator()(str s) const noexcept {
+        return hash_bytes(s.as_ptr(), s.len());
+    }
+};
+
+// FxHash for strings is the transparent byte hash
+template<typename Alloc>
+struct FxHash<BasicString<Alloc>> : StringHash {};
+
+template<>
+struct FxHash<str> : StringHash {};
+
+struct StringEq {
+    using is_transparent = void;
+    
+    bool operator()(str a, str b) const noexcept {
+        return a == b;
     }
+};
+
+struct StringLess {
+    using is_transparent = void;
     
-    bool operator!=(const str& other) const { return !(*this == other); }
+    bool operator()(str a, str b) const noexcept {
+        return a.as_str() < b.as_str();
+    }
 };
 
 // Factory functions
@@ -639,16 +1205,10 @@ inline String string(std::string_view sv) {
 
 // Specialization of std::hash for rusty::String
 namespace std {
-    template<>
-    struct hash<rusty::String> {
-        size_t operator()(const rusty::String& s) const noexcept {
-            // Simple hash using djb2 algorithm
-            size_t hash = 5381;
-            std::string_view sv = s.as_str();
-            for (char c : sv) {
-                hash = ((hash << 5) + hash) + c; // hash * 33 + c
-            }
-            return hash;
+    template<typename Alloc>
+    struct hash<rusty::BasicString<Alloc>> {
+        size_t operator()(const rusty::BasicString<Alloc>& s) const noexcept {
+            return rusty::StringHash()(s);
         }
     };
 }
@@ -0,0 +1,534 @@
+#ifndef RUSTY_SYNC_HPP
+#define RUSTY_SYNC_HPP
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>  // for size_t
+#include <cstdint>
+#include <mutex>
+#include <utility>  // for std::move, std::forward
+#include "marker.hpp"
+#include "niche.hpp"
+#include "option.hpp"
+
+// Mutex<T> / RwLock<T> - Locks that own the data they protect
+// Equivalent to Rust's std::sync::Mutex<T> and std::sync::RwLock<T>
+//
+// Guarantees:
+// - The data is reachable only through a guard, so it cannot be touched
+//   without holding the lock; guards borrow the lock and the checker
+//   rejects any reference that outlives its guard
+// - Guards are move-only and unlock when dropped
+// - get_mut() and into_inner() skip locking when the caller has exclusive
+//   access to the lock itself
+//
+// Both locks spin briefly with a pause instruction and then park the
+// thread. Parked threads wait on one of a fixed set of condition variables
+// chosen by the lock's address, so a lock costs one word (Mutex) and
+// waiting needs no per-lock kernel object.
+//
+// RwLock spreads readers over READER_SLOTS cache-line-sized counters,
+// chosen per thread, so concurrent readers never write the same line.
+// A writer raises a flag that turns away new readers and then waits for
+// every counter to drain; read-heavy workloads scale with the number of
+// reader threads at the cost of more expensive writes.
+//
+// Unlike Rust, a panic (exception) while a guard is held does not poison
+// the lock.
+
+// @safe
+namespace rusty {
+namespace detail {
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// Address-keyed wait queues shared by every lock
+struct ParkBucket {
+    std::mutex lock;
+    std::condition_variable cv;
+};
+
+constexpr size_t PARK_BUCKETS = 64;
+
+// Intentionally never destroyed: locks in static objects may still be
+// used after this header's statics would have been torn down
+inline ParkBucket& park_bucket(const void* addr) {
+    static ParkBucket* buckets = new ParkBucket[PARK_BUCKETS];
+    uintptr_t key = reinterpret_cast<uintptr_t>(addr);
+    return buckets[(key >> 6 ^ key >> 12) & (PARK_BUCKETS - 1)];
+}
+
+// Block while word still holds expected (may return spuriously)
+template<typename V>
+void park(const std::atomic<V>& word, V expected) {
+    ParkBucket& bucket = park_bucket(&word);
+    std::unique_lock<std::mutex> guard(bucket.lock);
+    if (word.load(std::memory_order_seq_cst) == expected) {
+        bucket.cv.wait(guard);
+    }
+}
+
+// Wake every thread parked on word; call after changing it
+inline void unpark_all(const void* word) {
+    ParkBucket& bucket = park_bucket(word);
+    { std::lock_guard<std::mutex> guard(bucket.lock); }
+    bucket.cv.notify_all();
+}
+
+constexpr int SPIN_LIMIT = 100;
+
+// Three-state lock word: unlocked, locked, locked with parked waiters
+class RawMutex {
+private:
+    static constexpr uint32_t UNLOCKED = 0;
+    static constexpr uint32_t LOCKED = 1;
+    static constexpr uint32_t CONTENDED = 2;
+
+    std::atomic<uint32_t> state_;
+
+    void lock_slow() {
+        for (int spin = 0; spin < SPIN_LIMIT; spin++) {
+            uint32_t expected = UNLOCKED;
+            if (state_.load(std::memory_order_relaxed) == UNLOCKED &&
+                state_.compare_exchange_weak(expected, LOCKED, std::memory_order_acquire,
+                                             std::memory_order_relaxed)) {
+                return;
+            }
+            cpu_relax();
+        }
+        // Taking the lock as CONTENDED makes our unlock wake the others
+        while (state_.exchange(CONTENDED, std::memory_order_acquire) != UNLOCKED) {
+            park(state_, CONTENDED);
+        }
+    }
+
+public:
+    RawMutex() : state_(UNLOCKED) {}
+
+    RawMutex(const RawMutex&) = delete;
+    RawMutex& operator=(const RawMutex&) = delete;
+
+    void lock() {
+        uint32_t expected = UNLOCKED;
+        if (!state_.compare_exchange_weak(expected, LOCKED, std::memory_order_acquire,
+                                          std::memory_order_relaxed)) {
+            lock_slow();
+        }
+    }
+
+    bool try_lock() {
+        uint32_t expected = UNLOCKED;
+        return state_.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire,
+                                              std::memory_order_relaxed);
+    }
+
+    void unlock() {
+        if (state_.exchange(UNLOCKED, std::memory_order_release) == CONTENDED) {
+            unpark_all(&state_);
+        }
+    }
+
+    bool is_locked() const {
+        return state_.load(std::memory_order_relaxed) != UNLOCKED;
+    }
+};
+
+// Reader-striped readers-writer lock
+class RawRwLock {
+public:
+    static constexpr size_t READER_SLOTS = 16;
+
+private:
+    struct alignas(64) ReaderSlot {
+        std::atomic<size_t> count;
+        ReaderSlot() : count(0) {}
+    };
+
+    ReaderSlot readers_[READER_SLOTS];
+    std::atomic<bool> writer_;   // a writer holds or is acquiring the lock
+    RawMutex writers_;           // serializes writers
+
+    // Threads take slots round-robin, so up to READER_SLOTS readers
+    // never share a counter
+    static size_t my_slot() {
+        static std::atomic<size_t> next(0);
+        static thread_local size_t slot =
+            next.fetch_add(1, std::memory_order_relaxed) % READER_SLOTS;
+        return slot;
+    }
+
+    void wait_for_writer() {
+        for (int spin = 0; spin < SPIN_LIMIT; spin++) {
+            if (!writer_.load(std::memory_order_acquire)) return;
+            cpu_relax();
+        }
+        while (writer_.load(std::memory_order_acquire)) {
+            park(writer_, true);
+        }
+    }
+
+    void drain(ReaderSlot& slot) {
+        for (int spin = 0; spin < SPIN_LIMIT; spin++) {
+            if (slot.count.load(std::memory_order_seq_cst) == 0) return;
+            cpu_relax();
+        }
+        size_t seen;
+        while ((seen = slot.count.load(std::memory_order_seq_cst)) != 0) {
+            park(slot.count, seen);
+        }
+    }
+
+public:
+    RawRwLock() : writer_(false) {}
+
+    RawRwLock(const RawRwLock&) = delete;
+    RawRwLock& operator=(const RawRwLock&) = delete;
+
+    // Returns the slot to pass to unlock_shared
+    size_t lock_shared() {
+        size_t slot = my_slot();
+        for (;;) {
+            readers_[slot].count.fetch_add(1, std::memory_order_seq_cst);
+            if (!writer_.load(std::memory_order_seq_cst)) return slot;
+            // Back off so the writer can drain, then retry
+            unlock_shared(slot);
+            wait_for_writer();
+        }
+    }
+
+    bool try_lock_shared(size_t& slot) {
+        slot = my_slot();
+        readers_[slot].count.fetch_add(1, std::memory_order_seq_cst);
+        if (!writer_.load(std::memory_order_seq_cst)) return true;
+        unlock_shared(slot);
+        return false;
+    }
+
+    void unlock_shared(size_t slot) {
+        readers_[slot].count.fetch_sub(1, std::memory_order_seq_cst);
+        if (writer_.load(std::memory_order_seq_cst)) {
+            unpark_all(&readers_[slot].count);
+        }
+    }
+
+    void lock() {
+        writers_.lock();
+        writer_.store(true, std::memory_order_seq_cst);
+        for (auto& slot : readers_) drain(slot);
+    }
+
+    bool try_lock() {
+        if (!writers_.try_lock()) return false;
+        writer_.store(true, std::memory_order_seq_cst);
+        for (auto& slot : readers_) {
+            if (slot.count.load(std::memory_order_seq_cst) != 0) {
+                unlock();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void unlock() {
+        writer_.store(false, std::memory_order_seq_cst);
+        unpark_all(&writer_);
+        writers_.unlock();
+    }
+};
+
+} // namespace detail
+
+template<typename T>
+class Mutex;
+
+template<typename T>
+class RwLock;
+
+// Exclusive access to a Mutex's data; unlocks when dropped
+template<typename T>
+class MutexGuard {
+private:
+    friend class Mutex<T>;
+
+    Mutex<T>* lock_;
+
+    explicit MutexGuard(Mutex<T>* lock) : lock_(lock) {}
+
+public:
+    MutexGuard(const MutexGuard&) = delete;
+    MutexGuard& operator=(const MutexGuard&) = delete;
+
+    MutexGuard(MutexGuard&& other) noexcept : lock_(other.lock_) {
+        other.lock_ = nullptr;
+    }
+
+    MutexGuard& operator=(MutexGuard&& other) noexcept {
+        if (this != &other) {
+            if (lock_) lock_->raw_.unlock();
+            lock_ = other.lock_;
+            other.lock_ = nullptr;
+        }
+        return *this;
+    }
+
+    ~MutexGuard() {
+        if (lock_) lock_->raw_.unlock();
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    T& operator*() {
+        assert(lock_ != nullptr);
+        return lock_->data_;
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const T& operator*() const {
+        assert(lock_ != nullptr);
+        return lock_->data_;
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    T* operator->() {
+        assert(lock_ != nullptr);
+        return &lock_->data_;
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const T* operator->() const {
+        assert(lock_ != nullptr);
+        return &lock_->data_;
+    }
+};
+
+template<typename T>
+class Mutex {
+private:
+    friend class MutexGuard<T>;
+
+    detail::RawMutex raw_;
+    T data_;
+
+public:
+    Mutex() : data_() {}
+
+    explicit Mutex(T value) : data_(std::move(value)) {}
+
+    // Not movable: guards point at the lock; share it by reference or Arc
+    Mutex(const Mutex&) = delete;
+    Mutex& operator=(const Mutex&) = delete;
+
+    // Block until the lock is free
+    // @lifetime: (&'a) -> &'a mut
+    MutexGuard<T> lock() {
+        raw_.lock();
+        return MutexGuard<T>(this);
+    }
+
+    // Take the lock only if it is free right now
+    // @lifetime: (&'a) -> &'a mut
+    Option<MutexGuard<T>> try_lock() {
+        if (raw_.try_lock()) {
+            return Option<MutexGuard<T>>(MutexGuard<T>(this));
+        }
+        return None;
+    }
+
+    bool is_locked() const { return raw_.is_locked(); }
+
+    // Exclusive access to the Mutex itself means no guard exists
+    // @lifetime: (&'a mut) -> &'a mut
+    T& get_mut() { return data_; }
+
+    // @lifetime: owned
+    T into_inner() { return std::move(data_); }
+};
+
+// Shared access to an RwLock's data; releases its read lock when dropped
+template<typename T>
+class RwLockReadGuard {
+private:
+    friend class RwLock<T>;
+
+    RwLock<T>* lock_;
+    size_t slot_;
+
+    RwLockReadGuard(RwLock<T>* lock, size_t slot) : lock_(lock), slot_(slot) {}
+
+public:
+    RwLockReadGuard(const RwLockReadGuard&) = delete;
+    RwLockReadGuard& operator=(const RwLockReadGuard&) = delete;
+
+    RwLockReadGuard(RwLockReadGuard&& other) noexcept
+        : lock_(other.lock_), slot_(other.slot_) {
+        other.lock_ = nullptr;
+    }
+
+    RwLockReadGuard& operator=(RwLockReadGuard&& other) noexcept {
+        if (this != &other) {
+            if (lock_) lock_->raw_.unlock_shared(slot_);
+            lock_ = other.lock_;
+            slot_ = other.slot_;
+            other.lock_ = nullptr;
+        }
+        return *this;
+    }
+
+    ~RwLockReadGuard() {
+        if (lock_) lock_->raw_.unlock_shared(slot_);
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const T& operator*() const {
+        assert(lock_ != nullptr);
+        return lock_->data_;
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const T* operator->() const {
+        assert(lock_ != nullptr);
+        return &lock_->data_;
+    }
+};
+
+// Exclusive access to an RwLock's data; unlocks when dropped
+template<typename T>
+class RwLockWriteGuard {
+private:
+    friend class RwLock<T>;
+
+    RwLock<T>* lock_;
+
+    explicit RwLockWriteGuard(RwLock<T>* lock) : lock_(lock) {}
+
+public:
+    RwLockWriteGuard(const RwLockWriteGuard&) = delete;
+    RwLockWriteGuard& operator=(const RwLockWriteGuard&) = delete;
+
+    RwLockWriteGuard(RwLockWriteGuard&& other) noexcept : lock_(other.lock_) {
+        other.lock_ = nullptr;
+    }
+
+    RwLockWriteGuard& operator=(RwLockWriteGuard&& other) noexcept {
+        if (this != &other) {
+            if (lock_) lock_->raw_.unlock();
+            lock_ = other.lock_;
+            other.lock_ = nullptr;
+        }
+        return *this;
+    }
+
+    ~RwLockWriteGuard() {
+        if (lock_) lock_->raw_.unlock();
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    T& operator*() {
+        assert(lock_ != nullptr);
+        return lock_->data_;
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const T& operator*() const {
+        assert(lock_ != nullptr);
+        return lock_->data_;
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    T* operator->() {
+        assert(lock_ != nullptr);
+        return &lock_->data_;
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const T* operator->() const {
+        assert(lock_ != nullptr);
+        return &lock_->data_;
+    }
+};
+
+template<typename T>
+class RwLock {
+private:
+    friend class RwLockReadGuard<T>;
+    friend class RwLockWriteGuard<T>;
+
+    detail::RawRwLock raw_;
+    T data_;
+
+public:
+    RwLock() : data_() {}
+
+    explicit RwLock(T value) : data_(std::move(value)) {}
+
+    // Not movable: guards point at the lock; share it by reference or Arc
+    RwLock(const RwLock&) = delete;
+    RwLock& operator=(const RwLock&) = delete;
+
+    // Shared access; blocks while a writer holds or waits for the lock
+    // @lifetime: (&'a) -> &'a
+    RwLockReadGuard<T> read() const {
+        RwLock* self = const_cast<RwLock*>(this);
+        size_t slot = self->raw_.lock_shared();
+        return RwLockReadGuard<T>(self, slot);
+    }
+
+    // @lifetime: (&'a) -> &'a
+    Option<RwLockReadGuard<T>> try_read() const {
+        RwLock* self = const_cast<RwLock*>(this);
+        size_t slot;
+        if (self->raw_.try_lock_shared(slot)) {
+            return Option<RwLockReadGuard<T>>(RwLockReadGuard<T>(self, slot));
+        }
+        return None;
+    }
+
+    // Exclusive access; waits for current readers to finish
+    // @lifetime: (&'a) -> &'a mut
+    RwLockWriteGuard<T> write() {
+        raw_.lock();
+        return RwLockWriteGuard<T>(this);
+    }
+
+    // @lifetime: (&'a) -> &'a mut
+    Option<RwLockWriteGuard<T>> try_write() {
+        if (raw_.try_lock()) {
+            return Option<RwLockWriteGuard<T>>(RwLockWriteGuard<T>(this));
+        }
+        return None;
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    T& get_mut() { return data_; }
+
+    // @lifetime: owned
+    T into_inner() { return std::move(data_); }
+};
+
+// A guard with no lock is the moved-from state, never a live guard
+template<typename T>
+struct niche_traits<MutexGuard<T>> : null_pointer_niche {};
+
+template<typename T>
+struct niche_traits<RwLockWriteGuard<T>> : null_pointer_niche {};
+
+template<typename T>
+struct niche_traits<RwLockReadGuard<T>> : null_pointer_niche {};
+
+// A Mutex hands its value to one thread at a time, so sharing it only needs
+// T to be Send; an RwLock also lets readers share T itself
+template<typename T>
+struct is_sync<Mutex<T>> : is_send<T> {};
+
+template<typename T>
+struct is_sync<RwLock<T>> : detail::all_of<is_send<T>::value, is_sync<T>::value> {};
+
+} // namespace rusty
+
+#endif // RUSTY_SYNC_HPP
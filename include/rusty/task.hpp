@@ -0,0 +1,682 @@
+#ifndef RUSTY_TASK_HPP
+#define RUSTY_TASK_HPP
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#include <atomic>
+#include <cassert>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "io.hpp"
+#include "option.hpp"
+#include "pool.hpp"
+#include "result.hpp"
+#include "sync.hpp"
+#include "thread_pool.hpp"
+#include "vec.hpp"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+// Task<T> - A lazily started coroutine producing a T (C++20)
+// Runtime - Runs tasks on a ThreadPool, with an epoll reactor for I/O
+// Equivalent to Rust's async fn / Future, tokio::Runtime and AsyncFd
+//
+//   rusty::Task<rusty::Result<size_t, rusty::io::Error>> echo(rusty::io::AsyncFd& conn) {
+//       rusty::Vec<uint8_t> buf;
+//       size_t total = 0;
+//       for (;;) {
+//           buf.clear();
+//           auto n = co_await conn.read(buf);       // suspends until readable
+//           if (n.is_err() || n.unwrap() == 0) co_return n;
+//           auto w = co_await conn.write_all(buf.as_slice());
+//           if (w.is_err()) co_return rusty::Result<size_t, rusty::io::Error>::Err(w.unwrap_err());
+//           total += buf.len();
+//       }
+//   }
+//   rusty::Runtime::global().spawn(serve(std::move(listener)));
+//   auto r = rusty::Runtime::global().block_on(echo(conn));
+//
+// A Task does nothing until it is awaited, spawned or passed to
+// block_on. Awaiting a task runs it on the awaiting thread and resumes
+// the awaiter directly when it finishes (symmetric transfer), so a chain
+// of awaits uses no scheduler and no stack. Errors are values: await a
+// Task<Result<T, E>> and inspect it. An exception escaping a task is
+// rethrown by whoever awaits it (or block_on); one escaping a spawned
+// task calls std::terminate, as with ThreadPool::spawn.
+//
+// Coroutine frames are allocated from per-size-class Pools (thread-local
+// free lists, see pool.hpp) and spawned tasks are queued through a job
+// stored in their own frame, so spawning and awaiting do not call malloc
+// once the pools are warm. Frames above 2 KiB use operator new.
+//
+// The reactor is one thread blocked in epoll_wait. An AsyncFd that would
+// block registers the suspended coroutine for one-shot readiness, and the
+// reactor queues it back on the runtime's pool when the descriptor is
+// ready. Regular files cannot be polled, so their reads and writes simply
+// run on the worker that makes them. AsyncFd and the reactor are Linux
+// only; Task and Runtime work wherever coroutines do.
+
+// @safe
+namespace rusty {
+
+template<typename T = void>
+class Task;
+
+class Runtime;
+
+#if defined(__linux__)
+namespace io {
+class AsyncFd;
+}
+#endif
+
+namespace detail {
+
+// Frame storage in a few size classes
+template<size_t N>
+struct alignas(alignof(std::max_align_t)) FrameBlock {
+    unsigned char bytes[N];
+};
+
+constexpr size_t FRAME_POOL_MAX = 2048;
+
+inline void* frame_allocate(size_t n) {
+    if (n <= 128) return Pool<FrameBlock<128>>::allocate_raw();
+    if (n <= 256) return Pool<FrameBlock<256>>::allocate_raw();
+    if (n <= 512) return Pool<FrameBlock<512>>::allocate_raw();
+    if (n <= 1024) return Pool<FrameBlock<1024>>::allocate_raw();
+    if (n <= FRAME_POOL_MAX) return Pool<FrameBlock<FRAME_POOL_MAX>>::allocate_raw();
+    return ::operator new(n);
+}
+
+inline void frame_deallocate(void* p, size_t n) {
+    if (n <= 128) return Pool<FrameBlock<128>>::deallocate_raw(p);
+    if (n <= 256) return Pool<FrameBlock<256>>::deallocate_raw(p);
+    if (n <= 512) return Pool<FrameBlock<512>>::deallocate_raw(p);
+    if (n <= 1024) return Pool<FrameBlock<1024>>::deallocate_raw(p);
+    if (n <= FRAME_POOL_MAX) return Pool<FrameBlock<FRAME_POOL_MAX>>::deallocate_raw(p);
+    ::operator delete(p);
+}
+
+// Base of every promise here: frames come from the pools
+struct PooledFrame {
+    static void* operator new(size_t n) { return frame_allocate(n); }
+    static void operator delete(void* p, size_t n) { frame_deallocate(p, n); }
+};
+
+// A pool job that resumes a suspended coroutine; kept in the frame or an
+// awaiter, which outlive the suspension
+struct ResumeJob {
+    PoolJob base;
+    std::coroutine_handle<> handle;
+
+    ResumeJob() : handle(nullptr) { base.run = &execute; }
+
+    static void execute(PoolJob* job) {
+        std::coroutine_handle<> h = reinterpret_cast<ResumeJob*>(job)->handle;
+        h.resume();
+    }
+};
+
+struct TaskPromiseBase : PooledFrame {
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+    ResumeJob job;  // For spawn
+    bool detached = false;
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+
+        template<typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+            TaskPromiseBase& p = h.promise();
+            if (p.detached) {
+                if (p.error) std::terminate();
+                h.destroy();
+                return std::noop_coroutine();
+            }
+            return p.continuation ? p.continuation : std::noop_coroutine();
+        }
+
+        void await_resume() noexcept {}
+    };
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    void unhandled_exception() { error = std::current_exception(); }
+};
+
+template<typename T>
+struct TaskPromise : TaskPromiseBase {
+    Option<T> value;
+
+    Task<T> get_return_object();
+
+    template<typename U>
+    void return_value(U&& v) {
+        value = Option<T>(T(std::forward<U>(v)));
+    }
+
+    T take() {
+        if (error) std::rethrow_exception(error);
+        return value.take().unwrap();
+    }
+};
+
+template<>
+struct TaskPromise<void> : TaskPromiseBase {
+    Task<void> get_return_object();
+
+    void return_void() {}
+
+    void take() {
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+// The coroutine block_on drives; signals the blocked caller when done
+struct BlockOnTask {
+    struct promise_type : PooledFrame {
+        std::atomic<bool>* done = nullptr;
+
+        BlockOnTask get_return_object() {
+            return BlockOnTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+
+            void await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                // The caller destroys the frame once done is set: touch
+                // nothing in it afterwards
+                std::atomic<bool>* done = h.promise().done;
+                done->store(true, std::memory_order_release);
+                unpark_all(done);
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void unhandled_exception() { std::terminate(); }  // drive() catches
+        void return_void() {}
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+} // namespace detail
+
+template<typename T>
+class Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+private:
+    friend class Runtime;
+    friend struct detail::TaskPromise<T>;
+
+    std::coroutine_handle<promise_type> handle_;
+
+    explicit Task(std::coroutine_handle<promise_type> h) : handle_(h) {}
+
+public:
+    Task(Task&& other) noexcept : handle_(other.handle_) { other.handle_ = nullptr; }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = other.handle_;
+            other.handle_ = nullptr;
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    // A task dropped without running never runs
+    ~Task() {
+        if (handle_) handle_.destroy();
+    }
+
+    // Has run to completion (only after it was awaited)
+    bool is_ready() const { return handle_ && handle_.done(); }
+
+    struct Awaiter {
+        std::coroutine_handle<promise_type> handle;
+
+        bool await_ready() const noexcept { return handle.done(); }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+            handle.promise().continuation = awaiting;
+            return handle;
+        }
+
+        T await_resume() { return handle.promise().take(); }
+    };
+
+    // Run the task and produce its value; the task must not be empty
+    // @lifetime: owned
+    Awaiter operator co_await() && {
+        assert(handle_ && "awaiting a moved-from Task");
+        return Awaiter{handle_};
+    }
+};
+
+namespace detail {
+
+template<typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+template<typename T>
+BlockOnTask drive(Task<T>& task, Option<T>& out, std::exception_ptr& error) {
+    try {
+        out = Option<T>(co_await std::move(task));
+    } catch (...) {
+        error = std::current_exception();
+    }
+}
+
+inline BlockOnTask drive(Task<void>& task, std::exception_ptr& error) {
+    try {
+        co_await std::move(task);
+    } catch (...) {
+        error = std::current_exception();
+    }
+}
+
+#if defined(__linux__)
+
+class Reactor;
+
+// Per-descriptor registration; freed by the reactor (see retire)
+struct FdState {
+    int fd;
+    std::mutex lock;
+    ResumeJob* reader = nullptr;
+    ResumeJob* writer = nullptr;
+    bool registered = false;
+    FdState* next_retired = nullptr;
+
+    explicit FdState(int f) : fd(f) {}
+};
+
+// One thread in epoll_wait, resuming waiters on the pool
+class Reactor {
+private:
+    ThreadPool* pool_;
+    int epoll_fd_;
+    int wake_fd_;  // eventfd: wakes epoll_wait for shutdown
+    std::atomic<bool> stop_;
+    std::mutex retire_lock_;
+    FdState* retired_;
+    std::thread thread_;
+
+    static uint32_t interest(const FdState& s) {
+        uint32_t events = EPOLLONESHOT;
+        if (s.reader) events |= EPOLLIN | EPOLLRDHUP;
+        if (s.writer) events |= EPOLLOUT;
+        return events;
+    }
+
+    FdState* take_retired() {
+        std::lock_guard<std::mutex> guard(retire_lock_);
+        FdState* list = retired_;
+        retired_ = nullptr;
+        return list;
+    }
+
+    void dispatch(FdState* s, uint32_t events) {
+        ResumeJob* ready[2] = {nullptr, nullptr};
+        {
+            std::lock_guard<std::mutex> guard(s->lock);
+            bool failed = (events & (EPOLLERR | EPOLLHUP)) != 0;
+            if (s->reader && (failed || (events & (EPOLLIN | EPOLLRDHUP)))) {
+                ready[0] = s->reader;
+                s->reader = nullptr;
+            }
+            if (s->writer && (failed || (events & EPOLLOUT))) {
+                ready[1] = s->writer;
+                s->writer = nullptr;
+            }
+            if (s->reader || s->writer) {
+                epoll_event ev = {};
+                ev.events = interest(*s);
+                ev.data.ptr = s;
+                epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, s->fd, &ev);
+            }
+        }
+        for (ResumeJob* job : ready) {
+            if (job) pool_->spawn_job(&job->base);
+        }
+    }
+
+    void run() {
+        epoll_event events[64];
+        while (!stop_.load(std::memory_order_acquire)) {
+            // Retired before this wait began, so no event below names them
+            FdState* retired = take_retired();
+            int n = epoll_wait(epoll_fd_, events, 64, -1);
+            for (int i = 0; i < n; i++) {
+                if (events[i].data.ptr) dispatch(static_cast<FdState*>(events[i].data.ptr), events[i].events);
+            }
+            while (retired) {
+                FdState* next = retired->next_retired;
+                delete retired;
+                retired = next;
+            }
+        }
+    }
+
+public:
+    explicit Reactor(ThreadPool& pool)
+        : pool_(&pool), epoll_fd_(epoll_create1(EPOLL_CLOEXEC)),
+          wake_fd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)), stop_(false), retired_(nullptr) {
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.ptr = nullptr;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+        thread_ = std::thread([this] { run(); });
+    }
+
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    ~Reactor() {
+        stop_.store(true, std::memory_order_release);
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wake_fd_, &one, sizeof(one));
+        (void)ignored;
+        thread_.join();
+        FdState* retired = take_retired();
+        while (retired) {
+            FdState* next = retired->next_retired;
+            delete retired;
+            retired = next;
+        }
+        ::close(wake_fd_);
+        ::close(epoll_fd_);
+    }
+
+    // Resume job when s is ready in the given direction. Returns false if
+    // the descriptor cannot be polled (a regular file): it is always ready.
+    bool wait(FdState* s, ResumeJob* job, bool write) {
+        std::lock_guard<std::mutex> guard(s->lock);
+        (write ? s->writer : s->reader) = job;
+        epoll_event ev = {};
+        ev.events = interest(*s);
+        ev.data.ptr = s;
+        int rc = epoll_ctl(epoll_fd_, s->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, s->fd, &ev);
+        if (rc == 0) {
+            s->registered = true;
+            return true;
+        }
+        (write ? s->writer : s->reader) = nullptr;
+        return false;
+    }
+
+    // Stop watching s and free it once no event can still name it
+    void retire(FdState* s) {
+        if (s->registered) epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, s->fd, nullptr);
+        std::lock_guard<std::mutex> guard(retire_lock_);
+        s->next_retired = retired_;
+        retired_ = s;
+    }
+};
+
+#endif
+
+} // namespace detail
+
+class Runtime {
+private:
+    ThreadPool* pool_;
+#if defined(__linux__)
+    detail::Reactor reactor_;
+#endif
+
+#if defined(__linux__)
+    friend class io::AsyncFd;
+#endif
+
+    void run_blocking(detail::BlockOnTask root, std::atomic<bool>& done) {
+        root.handle.promise().done = &done;
+        detail::ResumeJob job;
+        job.handle = root.handle;
+        pool_->spawn_job(&job.base);
+        while (!done.load(std::memory_order_acquire)) detail::park(done, false);
+        root.handle.destroy();
+    }
+
+public:
+    // A runtime scheduling onto pool (which must outlive it)
+    explicit Runtime(ThreadPool& pool)
+        : pool_(&pool)
+#if defined(__linux__)
+          , reactor_(pool)
+#endif
+    {
+    }
+
+    Runtime(const Runtime&) = delete;
+    Runtime& operator=(const Runtime&) = delete;
+
+    // Shared by the process; schedules onto ThreadPool::global()
+    static Runtime& global() {
+        static Runtime runtime(ThreadPool::global());
+        return runtime;
+    }
+
+    ThreadPool& pool() { return *pool_; }
+
+    // Run task on the pool and block the calling thread until it is done.
+    // Do not call from inside a task: it would block a worker.
+    // @lifetime: owned
+    template<typename T>
+    T block_on(Task<T> task) {
+        Option<T> out;
+        std::exception_ptr error;
+        std::atomic<bool> done(false);
+        run_blocking(detail::drive(task, out, error), done);
+        if (error) std::rethrow_exception(error);
+        return out.take().unwrap();
+    }
+
+    void block_on(Task<void> task) {
+        std::exception_ptr error;
+        std::atomic<bool> done(false);
+        run_blocking(detail::drive(task, error), done);
+        if (error) std::rethrow_exception(error);
+    }
+
+    // Run task on the pool without waiting; it owns its frame and frees it
+    // when done. No allocation beyond the frame itself.
+    void spawn(Task<void> task) {
+        std::coroutine_handle<detail::TaskPromise<void>> h = task.handle_;
+        task.handle_ = nullptr;
+        h.promise().detached = true;
+        h.promise().job.handle = h;
+        pool_->spawn_job(&h.promise().job.base);
+    }
+
+    // co_await rt.yield_now() requeues the calling task on the pool, to
+    // let other tasks run or to move off a thread outside the pool
+    struct YieldAwaiter {
+        ThreadPool* pool;
+        detail::ResumeJob job;
+
+        bool await_ready() const noexcept { return false; }
+
+        void await_suspend(std::coroutine_handle<> h) {
+            job.handle = h;
+            pool->spawn_job(&job.base);
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    YieldAwaiter yield_now() { return YieldAwaiter{pool_, detail::ResumeJob()}; }
+};
+
+#if defined(__linux__)
+namespace io {
+
+// A non-blocking descriptor (socket, pipe, or file) driven by a Runtime's
+// reactor. Its reads and writes suspend the calling task instead of the
+// thread. At most one task may read, and one write, at a time; the
+// AsyncFd must not be dropped while one is suspended on it.
+class AsyncFd {
+private:
+    File file_;
+    Runtime* runtime_;
+    rusty::detail::FdState* state_;
+
+    AsyncFd(File file, Runtime* runtime)
+        : file_(std::move(file)), runtime_(runtime), state_(new rusty::detail::FdState(file_.as_raw_fd())) {}
+
+public:
+    AsyncFd(AsyncFd&& other) noexcept
+        : file_(std::move(other.file_)), runtime_(other.runtime_), state_(other.state_) {
+        other.state_ = nullptr;
+    }
+
+    AsyncFd& operator=(AsyncFd&& other) noexcept {
+        if (this != &other) {
+            if (state_) runtime_->reactor_.retire(state_);
+            file_ = std::move(other.file_);
+            runtime_ = other.runtime_;
+            state_ = other.state_;
+            other.state_ = nullptr;
+        }
+        return *this;
+    }
+
+    AsyncFd(const AsyncFd&) = delete;
+    AsyncFd& operator=(const AsyncFd&) = delete;
+
+    ~AsyncFd() {
+        if (state_) {
+            assert(!state_->reader && !state_->writer && "AsyncFd dropped with a task waiting on it");
+            runtime_->reactor_.retire(state_);
+        }
+    }
+
+    // Adopt file, switching it to non-blocking mode
+    // @lifetime: owned
+    static Result<AsyncFd, Error> new_(File file, Runtime& runtime = Runtime::global()) {
+        int fd = file.as_raw_fd();
+        int flags = fcntl(fd, F_GETFL);
+        if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+            return Result<AsyncFd, Error>::Err(detail::error(errno));
+        }
+        return Result<AsyncFd, Error>::Ok(AsyncFd(std::move(file), &runtime));
+    }
+
+    int as_raw_fd() const { return file_.as_raw_fd(); }
+
+    // @lifetime: (&'a) -> &'a
+    const File& get_ref() const { return file_; }
+
+    // Awaitable: suspends until the descriptor is readable (or writable)
+    struct Readiness {
+        AsyncFd* fd;
+        bool write;
+        rusty::detail::ResumeJob job;
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> h) {
+            job.handle = h;
+            return fd->runtime_->reactor_.wait(fd->state_, &job, write);
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    Readiness readable() { return Readiness{this, false, rusty::detail::ResumeJob()}; }
+    Readiness writable() { return Readiness{this, true, rusty::detail::ResumeJob()}; }
+
+    // Append up to max bytes to buf; 0 at end of input
+    // @lifetime: (&'a mut, &'b mut) -> owned
+    Task<Result<size_t, Error>> read(Vec<uint8_t>& buf, size_t max = DEFAULT_BUF_SIZE) {
+        size_t len = buf.len();
+        if (buf.capacity() - len < max) buf.reserve(len + max);
+        buf.resize(len + max, 0);
+        for (;;) {
+            Result<size_t, Error> n = file_.read(SliceMut<uint8_t>(buf.as_mut_ptr() + len, max));
+            if (n.is_err() && (n.unwrap_err().code == EAGAIN || n.unwrap_err().code == EWOULDBLOCK)) {
+                co_await readable();
+                continue;
+            }
+            buf.truncate(n.is_ok() ? len + n.unwrap() : len);
+            co_return n;
+        }
+    }
+
+    // Write some of bytes; returns how many were written
+    // @lifetime: (&'a mut, &'b) -> owned
+    Task<Result<size_t, Error>> write(Slice<uint8_t> bytes) {
+        for (;;) {
+            Result<size_t, Error> n = file_.write(bytes);
+            if (n.is_err() && (n.unwrap_err().code == EAGAIN || n.unwrap_err().code == EWOULDBLOCK)) {
+                co_await writable();
+                continue;
+            }
+            co_return n;
+        }
+    }
+
+    // @lifetime: (&'a mut, &'b) -> owned
+    Task<Result<void, Error>> write_all(Slice<uint8_t> bytes) {
+        const uint8_t* p = bytes.as_ptr();
+        size_t left = bytes.len();
+        while (left > 0) {
+            Result<size_t, Error> n = co_await write(Slice<uint8_t>(p, left));
+            if (n.is_err()) co_return Result<void, Error>::Err(n.unwrap_err());
+            if (n.unwrap() == 0) co_return Result<void, Error>::Err(detail::error(EIO));
+            p += n.unwrap();
+            left -= n.unwrap();
+        }
+        co_return Result<void, Error>::Ok();
+    }
+
+    // Read until end of input, appending to buf; returns bytes read
+    // @lifetime: (&'a mut, &'b mut) -> owned
+    Task<Result<size_t, Error>> read_to_end(Vec<uint8_t>& buf) {
+        size_t start = buf.len();
+        for (;;) {
+            Result<size_t, Error> n = co_await read(buf);
+            if (n.is_err()) co_return n;
+            if (n.unwrap() == 0) co_return Result<size_t, Error>::Ok(buf.len() - start);
+        }
+    }
+};
+
+} // namespace io
+#endif
+
+} // namespace rusty
+
+#endif // __cpp_impl_coroutine
+
+#endif // RUSTY_TASK_HPP
@@ -0,0 +1,272 @@
+#ifndef RUSTY_THREAD_HPP
+#define RUSTY_THREAD_HPP
+
+#include <atomic>
+#include <cassert>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "marker.hpp"
+#include "option.hpp"
+#include "sync.hpp"
+#include "vec.hpp"
+
+// thread::scope - OS threads that may borrow from the caller's stack
+// Equivalent to Rust's std::thread::scope
+//
+//   rusty::Vec<int> data = ...;
+//   rusty::thread::scope([&](rusty::thread::Scope& s) {
+//       auto sum = s.spawn([&] { return total(data.as_slice(0, half)); });
+//       s.spawn([&] { normalize(data.as_mut_slice(half, data.len())); });
+//       use(sum.join());
+//   });  // every thread spawned in the scope has been joined here
+//
+// scope() joins every thread before it returns, so spawned closures can
+// use references to anything that outlives the scope instead of cloning
+// an Arc into each thread. A ScopedJoinHandle must not outlive its scope.
+//
+// Values passed as extra arguments to spawn() are moved into the new
+// thread and must be Send (marker.hpp), as must the thread's result:
+//   s.spawn([](Arc<Config> c) { ... }, config.clone());  // compiles
+//   s.spawn([](Rc<Config> c) { ... }, local);            // static_assert
+// Pass std::ref(x) to share x, which must then be Sync. What a lambda
+// captures is invisible to the compiler; rusty-cpp-checker rejects
+// non-Send captures at spawn sites instead.
+//
+// An exception escaping a thread is rethrown by join(). If the thread is
+// never joined, scope() rethrows the first such exception after joining
+// everything, unless the scope's own closure threw, which wins.
+
+// @safe
+namespace rusty {
+namespace thread {
+
+class Scope;
+
+template<typename T>
+class ScopedJoinHandle;
+
+namespace detail {
+
+template<typename R>
+struct ScopeBody;
+
+// What a scoped thread leaves behind; owned by its Scope
+struct PacketBase {
+    std::thread thread;
+    std::atomic<bool> finished;
+    bool joined;  // Set by ScopedJoinHandle::join, which then owns error
+    std::exception_ptr error;
+
+    PacketBase() : finished(false), joined(false) {}
+    virtual ~PacketBase() {}
+
+    void finish() {
+        finished.store(true, std::memory_order_release);
+        rusty::detail::unpark_all(&finished);
+    }
+
+    void wait() {
+        while (!finished.load(std::memory_order_acquire)) rusty::detail::park(finished, false);
+    }
+};
+
+template<typename T>
+struct Packet : PacketBase {
+    Option<T> result;
+
+    template<typename F, typename... Args>
+    void run(F& f, Args&&... args) {
+        result = Option<T>(f(std::forward<Args>(args)...));
+    }
+
+    T take() { return result.take().unwrap(); }
+};
+
+template<>
+struct Packet<void> : PacketBase {
+    template<typename F, typename... Args>
+    void run(F& f, Args&&... args) {
+        f(std::forward<Args>(args)...);
+    }
+
+    void take() {}
+};
+
+template<typename T, typename F, typename... Args>
+void run_scoped(Packet<T>* packet, F f, Args... args) {
+    try {
+        packet->run(f, std::move(args)...);
+    } catch (...) {
+        packet->error = std::current_exception();
+    }
+    packet->finish();
+}
+
+} // namespace detail
+
+// Returned by Scope::spawn; joining is optional, the scope joins the rest
+template<typename T>
+class ScopedJoinHandle {
+private:
+    friend class Scope;
+
+    detail::Packet<T>* packet_;
+
+    explicit ScopedJoinHandle(detail::Packet<T>* packet) : packet_(packet) {}
+
+public:
+    ScopedJoinHandle(const ScopedJoinHandle&) = delete;
+    ScopedJoinHandle& operator=(const ScopedJoinHandle&) = delete;
+
+    ScopedJoinHandle(ScopedJoinHandle&& other) : packet_(other.packet_) {
+        other.packet_ = nullptr;
+    }
+
+    ScopedJoinHandle& operator=(ScopedJoinHandle&& other) {
+        packet_ = other.packet_;
+        other.packet_ = nullptr;
+        return *this;
+    }
+
+    bool is_finished() const {
+        return packet_->finished.load(std::memory_order_acquire);
+    }
+
+    // Wait for the thread and take its result, rethrowing its exception.
+    // The handle is empty afterwards.
+    // @lifetime: owned
+    T join() {
+        assert(packet_ && "ScopedJoinHandle::join on an empty handle");
+        detail::Packet<T>* packet = packet_;
+        packet_ = nullptr;
+        packet->wait();
+        packet->joined = true;
+        if (packet->error) {
+            std::exception_ptr error = packet->error;
+            packet->error = nullptr;
+            std::rethrow_exception(error);
+        }
+        return packet->take();
+    }
+};
+
+// Spawns threads that may borrow anything that outlives the scope
+class Scope {
+private:
+    template<typename F>
+    friend auto scope(F&& f) -> decltype(f(std::declval<Scope&>()));
+    template<typename R>
+    friend struct detail::ScopeBody;
+
+    std::mutex mutex_;
+    Vec<detail::PacketBase*> threads_;  // Guarded by mutex_
+
+    Scope() {}
+
+    ~Scope() {
+        for (size_t i = 0; i < threads_.len(); i++) delete threads_[i];
+    }
+
+    // Join every thread, including ones spawned by threads being joined
+    void wait_all() {
+        for (size_t i = 0;; i++) {
+            detail::PacketBase* packet;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (i == threads_.len()) return;
+                packet = threads_[i];
+            }
+            if (packet->thread.joinable()) packet->thread.join();
+        }
+    }
+
+    void join_all() {
+        wait_all();
+        for (size_t i = 0; i < threads_.len(); i++) {
+            if (!threads_[i]->joined && threads_[i]->error) std::rethrow_exception(threads_[i]->error);
+        }
+    }
+
+public:
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    // Start a thread running f(args...). The arguments are moved into the
+    // thread; they and the result must be Send. May be called from any
+    // thread of the scope.
+    // @lifetime: (&'scope) -> owned
+    template<typename F, typename... Args>
+    ScopedJoinHandle<decltype(std::declval<typename std::decay<F>::type&>()(
+        std::declval<typename std::decay<Args>::type>()...))>
+    spawn(F&& f, Args&&... args) {
+        typedef typename std::decay<F>::type Fn;
+        typedef decltype(std::declval<Fn&>()(std::declval<typename std::decay<Args>::type>()...)) R;
+        static_assert(rusty::detail::all_of<is_send<Fn>::value, is_send<typename std::decay<Args>::type>::value...>::value,
+                      "thread::Scope::spawn: arguments must be Send (an Rc cannot leave its thread; use Arc)");
+        static_assert(is_send<R>::value, "thread::Scope::spawn: the result must be Send");
+
+        detail::Packet<R>* packet = new detail::Packet<R>();
+        try {
+            packet->thread = std::thread(&detail::run_scoped<R, Fn, typename std::decay<Args>::type...>,
+                                         packet, std::forward<F>(f), std::forward<Args>(args)...);
+        } catch (...) {
+            delete packet;
+            throw;
+        }
+        // Listed only once it is joinable, so wait_all never misses it
+        try {
+            std::lock_guard<std::mutex> lock(mutex_);
+            threads_.push(packet);
+        } catch (...) {
+            packet->thread.join();
+            delete packet;
+            throw;
+        }
+        return ScopedJoinHandle<R>(packet);
+    }
+};
+
+namespace detail {
+
+template<typename R>
+struct ScopeBody {
+    template<typename F>
+    static R run(Scope& s, F& f) {
+        R result = f(s);
+        s.join_all();
+        return result;
+    }
+};
+
+template<>
+struct ScopeBody<void> {
+    template<typename F>
+    static void run(Scope& s, F& f) {
+        f(s);
+        s.join_all();
+    }
+};
+
+} // namespace detail
+
+// Call f(scope) and join every thread it spawned before returning f's result
+// @lifetime: (&'a) -> owned
+template<typename F>
+auto scope(F&& f) -> decltype(f(std::declval<Scope&>())) {
+    typedef decltype(f(std::declval<Scope&>())) R;
+    Scope s;
+    try {
+        return detail::ScopeBody<R>::run(s, f);
+    } catch (...) {
+        s.wait_all();
+        throw;
+    }
+}
+
+} // namespace thread
+} // namespace rusty
+
+#endif // RUSTY_THREAD_HPP
@@ -0,0 +1,761 @@
+#ifndef RUSTY_THREAD_POOL_HPP
+#define RUSTY_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>  // for getenv, strtoul
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "sync.hpp"
+#include "vec.hpp"
+#include "vecdeque.hpp"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// ThreadPool - A work-stealing task scheduler
+// Equivalent to Rust's rayon::ThreadPool (spawn, scope, join)
+//
+//   rusty::ThreadPool& pool = rusty::ThreadPool::global();
+//   pool.join([&] { sort(left); }, [&] { sort(right); });
+//   pool.scope([&](rusty::Scope& s) {
+//       for (auto& chunk : chunks) s.spawn([&chunk] { process(chunk); });
+//   });  // every task spawned in the scope has finished here
+//   pool.spawn([msg = std::move(msg)]() mutable { send(std::move(msg)); });
+//
+// Every worker owns a Chase-Lev deque: it pushes and pops its own jobs at
+// the bottom, and idle workers steal from the top of another's deque, so
+// the oldest (largest) pieces of a recursive split move between threads
+// and the rest stay in the cache of the worker that made them. Calls from
+// outside the pool are queued on a shared injector and the caller blocks.
+//
+// join(a, b) offers b to thieves, runs a itself and then either takes b
+// back (no synchronisation beyond the deque) or, if b was stolen, runs
+// other jobs until the thief is done. Closures passed to join and
+// Scope::spawn may borrow from the caller's stack: join and scope return
+// only after they have run. Closures passed to ThreadPool::spawn must own
+// everything they use; they run at some point before the pool is dropped.
+//
+// Exceptions thrown by join or scoped closures are rethrown by join or
+// scope (the first one, after every closure has finished). An exception
+// escaping a detached spawn calls std::terminate, as there is no one to
+// report it to.
+//
+// Placement::Compact and Placement::Spread pin worker i to one CPU of the
+// process's affinity mask. CPUs are grouped by NUMA node (from sysfs):
+// Compact fills a node before moving to the next, Spread deals workers
+// round-robin across nodes. Thieves look for work on their own node
+// first. Pinning is a no-op off Linux.
+
+// @safe
+namespace rusty {
+
+class ThreadPool;
+class Scope;
+
+namespace detail {
+
+// A unit of work; run is called exactly once
+struct PoolJob {
+    void (*run)(PoolJob*);
+};
+
+// Chase-Lev deque of jobs (Le et al., "Correct and Efficient Work-Stealing
+// for Weak Memory Models", 2013). Only the owner calls push and pop; any
+// thread may steal. Grown rings are kept until the deque is dropped, since
+// a thief may still be reading the one it loaded.
+class WorkDeque {
+private:
+    struct Ring {
+        int64_t cap;
+        std::atomic<PoolJob*>* slots;
+        Ring* older;
+
+        Ring(int64_t c, Ring* o) : cap(c), slots(new std::atomic<PoolJob*>[size_t(c)]), older(o) {}
+        ~Ring() { delete[] slots; }
+
+        PoolJob* get(int64_t i) const { return slots[i & (cap - 1)].load(std::memory_order_relaxed); }
+        void put(int64_t i, PoolJob* job) { slots[i & (cap - 1)].store(job, std::memory_order_relaxed); }
+    };
+
+    alignas(64) std::atomic<int64_t> top_;
+    alignas(64) std::atomic<int64_t> bottom_;
+    std::atomic<Ring*> ring_;
+
+    Ring* grow(Ring* ring, int64_t bottom, int64_t top) {
+        Ring* bigger = new Ring(ring->cap * 2, ring);
+        for (int64_t i = top; i < bottom; i++) bigger->put(i, ring->get(i));
+        ring_.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+public:
+    WorkDeque() : top_(0), bottom_(0), ring_(new Ring(64, nullptr)) {}
+
+    WorkDeque(const WorkDeque&) = delete;
+    WorkDeque& operator=(const WorkDeque&) = delete;
+
+    ~WorkDeque() {
+        Ring* ring = ring_.load(std::memory_order_relaxed);
+        while (ring) {
+            Ring* older = ring->older;
+            delete ring;
+            ring = older;
+        }
+    }
+
+    void push(PoolJob* job) {
+        int64_t b = bottom_.load(std::memory_order_relaxed);
+        int64_t t = top_.load(std::memory_order_acquire);
+        Ring* ring = ring_.load(std::memory_order_relaxed);
+        if (b - t > ring->cap - 1) ring = grow(ring, b, t);
+        ring->put(b, job);
+        bottom_.store(b + 1, std::memory_order_release);  // Publishes the job to thieves
+    }
+
+    // The most recently pushed job, or null
+    PoolJob* pop() {
+        int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        Ring* ring = ring_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top_.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        PoolJob* job = ring->get(b);
+        if (t == b) {
+            // Last job: race the thieves for it
+            if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                              std::memory_order_relaxed)) {
+                job = nullptr;
+            }
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    // The oldest job, or null if there is none or another thief won it
+    PoolJob* steal() {
+        int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) return nullptr;
+        PoolJob* job = ring_.load(std::memory_order_acquire)->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return job;
+    }
+
+    bool is_empty() const {
+        return bottom_.load(std::memory_order_seq_cst) <= top_.load(std::memory_order_seq_cst);
+    }
+};
+
+struct PoolWorker {
+    WorkDeque deque;
+    ThreadPool* pool;
+    size_t index;
+    size_t node;
+    uint64_t rng;
+};
+
+inline PoolWorker*& current_pool_worker() {
+    static thread_local PoolWorker* worker = nullptr;
+    return worker;
+}
+
+// Set once by whoever finishes the job; its owner waits on it
+struct PoolLatch {
+    std::atomic<bool> done;
+
+    PoolLatch() : done(false) {}
+
+    bool probe() const { return done.load(std::memory_order_acquire); }
+};
+
+// A borrowed closure run by join or install; lives on the waiter's stack
+template<typename F>
+struct StackJob {
+    PoolJob base;
+    F* f;
+    ThreadPool* pool;
+    PoolLatch latch;
+    std::exception_ptr error;
+
+    StackJob(F& fn, ThreadPool* p) : f(&fn), pool(p) { base.run = &execute; }
+
+    void run_inline() {
+        try {
+            (*f)();
+        } catch (...) {
+            error = std::current_exception();
+        }
+    }
+
+    static void execute(PoolJob* job);
+};
+
+template<typename F>
+struct HeapJob {
+    PoolJob base;
+    F f;
+
+    explicit HeapJob(F fn) : f(std::move(fn)) { base.run = &execute; }
+
+    static void execute(PoolJob* job) {
+        HeapJob* self = reinterpret_cast<HeapJob*>(job);
+        F fn(std::move(self->f));
+        delete self;
+        try {
+            fn();
+        } catch (...) {
+            std::terminate();
+        }
+    }
+};
+
+template<typename F>
+struct ScopeJob {
+    PoolJob base;
+    F f;
+    Scope* scope;
+
+    ScopeJob(F fn, Scope* s) : f(std::move(fn)), scope(s) { base.run = &execute; }
+
+    static void execute(PoolJob* job);
+};
+
+// Allowed CPUs grouped by NUMA node: (cpu, node) pairs, node by node
+struct PoolCpu {
+    int cpu;
+    size_t node;
+};
+
+#if defined(__linux__)
+// Parse a sysfs cpulist such as "0-3,8-11" into the set bits of mask
+inline void parse_cpulist(const char* text, cpu_set_t& mask) {
+    CPU_ZERO(&mask);
+    const char* p = text;
+    while (*p >= '0' && *p <= '9') {
+        char* end = nullptr;
+        unsigned long lo = std::strtoul(p, &end, 10);
+        unsigned long hi = lo;
+        p = end;
+        if (*p == '-') {
+            hi = std::strtoul(p + 1, &end, 10);
+            p = end;
+        }
+        for (unsigned long c = lo; c <= hi && c < CPU_SETSIZE; c++) CPU_SET(c, &mask);
+        if (*p == ',') p++;
+    }
+}
+
+inline Vec<PoolCpu> pool_cpus() {
+    Vec<PoolCpu> cpus;
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return cpus;
+    cpu_set_t placed;
+    CPU_ZERO(&placed);
+    size_t nodes = 0;
+    for (int node = 0; node < 1024; node++) {
+        char path[64];
+        std::snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        std::FILE* f = std::fopen(path, "r");
+        if (!f) {
+            if (node >= 64) break;  // node ids can be sparse, but not this sparse
+            continue;
+        }
+        char text[4096];
+        size_t got = std::fread(text, 1, sizeof(text) - 1, f);
+        std::fclose(f);
+        text[got] = '\0';
+        cpu_set_t on_node;
+        parse_cpulist(text, on_node);
+        bool any = false;
+        for (int c = 0; c < CPU_SETSIZE; c++) {
+            if (CPU_ISSET(c, &on_node) && CPU_ISSET(c, &allowed) && !CPU_ISSET(c, &placed)) {
+                cpus.push(PoolCpu{c, nodes});
+                CPU_SET(c, &placed);
+                any = true;
+            }
+        }
+        if (any) nodes++;
+    }
+    // CPUs sysfs did not list (or no sysfs at all) go on a node of their own
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (CPU_ISSET(c, &allowed) && !CPU_ISSET(c, &placed)) cpus.push(PoolCpu{c, nodes});
+    }
+    return cpus;
+}
+#endif
+
+} // namespace detail
+
+// Where a pool's workers run
+enum class Placement {
+    Unpinned,  // Left to the OS scheduler
+    Compact,   // Pinned, filling one NUMA node before the next
+    Spread,    // Pinned, round-robin across NUMA nodes
+};
+
+class ThreadPool {
+private:
+    friend class Scope;
+    template<typename F> friend struct detail::StackJob;
+
+    static constexpr int SPIN_ROUNDS = 64;
+
+    Vec<detail::PoolWorker*> workers_;
+    Vec<std::thread> threads_;
+
+    std::mutex inject_mutex_;
+    VecDeque<detail::PoolJob*> injected_;
+    std::atomic<size_t> injected_len_;
+
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    std::atomic<size_t> sleepers_;
+    uint64_t epoch_;  // Guarded by sleep_mutex_; bumped to wake sleepers
+    std::atomic<bool> shutdown_;
+
+    // Wake one sleeper after publishing a job
+    void notify_one() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_seq_cst) == 0) return;
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            epoch_++;
+        }
+        sleep_cv_.notify_one();
+    }
+
+    // Wake every sleeper after setting a latch, which only its owner can see
+    void notify_all() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_seq_cst) == 0) return;
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            epoch_++;
+        }
+        sleep_cv_.notify_all();
+    }
+
+    // Safe to call from a job that has just finished: touches no job state
+    void set_latch(detail::PoolLatch& latch) {
+        latch.done.store(true, std::memory_order_seq_cst);
+        detail::unpark_all(&latch.done);  // A waiter outside the pool
+        notify_all();
+    }
+
+    void push_job(detail::PoolJob* job) {
+        detail::PoolWorker* w = detail::current_pool_worker();
+        if (w && w->pool == this) {
+            w->deque.push(job);
+        } else {
+            std::lock_guard<std::mutex> lock(inject_mutex_);
+            injected_.push_back(job);
+            injected_len_.fetch_add(1, std::memory_order_seq_cst);
+        }
+        notify_one();
+    }
+
+    detail::PoolJob* pop_injected() {
+        if (injected_len_.load(std::memory_order_relaxed) == 0) return nullptr;
+        std::lock_guard<std::mutex> lock(inject_mutex_);
+        if (injected_.is_empty()) return nullptr;
+        injected_len_.fetch_sub(1, std::memory_order_relaxed);
+        return injected_.pop_front().unwrap();
+    }
+
+    detail::PoolJob* steal_for(detail::PoolWorker& w) {
+        size_t n = workers_.len();
+        if (n > 1) {
+            w.rng ^= w.rng << 13;
+            w.rng ^= w.rng >> 7;
+            w.rng ^= w.rng << 17;
+            size_t start = static_cast<size_t>(w.rng % n);
+            // Same node first, then anyone
+            for (int pass = 0; pass < 2; pass++) {
+                for (size_t k = 0; k < n; k++) {
+                    detail::PoolWorker* victim = workers_[(start + k) % n];
+                    if (victim == &w || (pass == 0 && victim->node != w.node)) continue;
+                    if (detail::PoolJob* job = victim->deque.steal()) return job;
+                }
+            }
+        }
+        return pop_injected();
+    }
+
+    detail::PoolJob* find_work(detail::PoolWorker& w) {
+        if (detail::PoolJob* job = w.deque.pop()) return job;
+        return steal_for(w);
+    }
+
+    bool has_work() const {
+        if (injected_len_.load(std::memory_order_seq_cst) != 0) return true;
+        for (const detail::PoolWorker* w : workers_) {
+            if (!w->deque.is_empty()) return true;
+        }
+        return false;
+    }
+
+    void sleep(const detail::PoolLatch* latch) {
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        uint64_t seen = epoch_;
+        if (!has_work() && !(latch && latch->probe()) && !shutdown_.load(std::memory_order_seq_cst)) {
+            sleep_cv_.wait(lock, [&] { return epoch_ != seen; });
+        }
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Run other jobs until latch is set
+    void wait_until(detail::PoolWorker& w, const detail::PoolLatch& latch) {
+        int idle = 0;
+        while (!latch.probe()) {
+            if (detail::PoolJob* job = find_work(w)) {
+                job->run(job);
+                idle = 0;
+            } else if (++idle < SPIN_ROUNDS) {
+                std::this_thread::yield();
+            } else {
+                sleep(&latch);
+                idle = 0;
+            }
+        }
+    }
+
+    void worker_loop(detail::PoolWorker* w) {
+        detail::current_pool_worker() = w;
+        int idle = 0;
+        for (;;) {
+            if (detail::PoolJob* job = find_work(*w)) {
+                job->run(job);
+                idle = 0;
+            } else if (shutdown_.load(std::memory_order_acquire)) {
+                break;
+            } else if (++idle < SPIN_ROUNDS) {
+                std::this_thread::yield();
+            } else {
+                sleep(nullptr);
+                idle = 0;
+            }
+        }
+        detail::current_pool_worker() = nullptr;
+    }
+
+    // Run f on a worker of this pool and wait for it
+    template<typename F>
+    void in_worker(F& f) {
+        detail::PoolWorker* w = detail::current_pool_worker();
+        if (w && w->pool == this) {
+            f();
+            return;
+        }
+        detail::StackJob<F> job(f, this);
+        push_job(&job.base);
+        while (!job.latch.probe()) detail::park(job.latch.done, false);
+        if (job.error) std::rethrow_exception(job.error);
+    }
+
+    static size_t default_threads() {
+        if (const char* env = std::getenv("RUSTY_NUM_THREADS")) {
+            size_t n = std::strtoul(env, nullptr, 10);
+            if (n > 0) return n;
+        }
+        size_t n = std::thread::hardware_concurrency();
+        return n > 0 ? n : 1;
+    }
+
+    static Placement default_placement() {
+        const char* env = std::getenv("RUSTY_THREAD_PLACEMENT");
+        if (env && std::strcmp(env, "compact") == 0) return Placement::Compact;
+        if (env && std::strcmp(env, "spread") == 0) return Placement::Spread;
+        return Placement::Unpinned;
+    }
+
+    // The CPU each worker is pinned to, or an empty Vec when unpinned
+    static Vec<detail::PoolCpu> placement_cpus(size_t threads, Placement placement) {
+        Vec<detail::PoolCpu> order;
+#if defined(__linux__)
+        if (placement == Placement::Unpinned) return order;
+        Vec<detail::PoolCpu> cpus = detail::pool_cpus();
+        if (cpus.is_empty()) return order;
+        if (placement == Placement::Compact) return cpus;
+        // Spread: the first CPU of every node, then the second, ...
+        size_t nodes = cpus[cpus.len() - 1].node + 1;
+        Vec<size_t> next = Vec<size_t>::with_capacity(nodes);
+        for (size_t k = 0; k < nodes; k++) next.push(0);
+        while (order.len() < cpus.len() && order.len() < threads) {
+            for (size_t node = 0; node < nodes; node++) {
+                size_t seen = 0;
+                for (size_t i = 0; i < cpus.len(); i++) {
+                    if (cpus[i].node != node) continue;
+                    if (seen++ == next[node]) {
+                        order.push(cpus[i]);
+                        next[node]++;
+                        break;
+                    }
+                }
+            }
+        }
+#else
+        (void)threads;
+        (void)placement;
+#endif
+        return order;
+    }
+
+public:
+    // A pool of `threads` workers (at least one)
+    explicit ThreadPool(size_t threads, Placement placement = Placement::Unpinned)
+        : injected_len_(0), sleepers_(0), epoch_(0), shutdown_(false) {
+        if (threads == 0) threads = 1;
+        Vec<detail::PoolCpu> cpus = placement_cpus(threads, placement);
+        workers_.reserve(threads);
+        for (size_t i = 0; i < threads; i++) {
+            detail::PoolWorker* w = new detail::PoolWorker();
+            w->pool = this;
+            w->index = i;
+            w->node = cpus.is_empty() ? 0 : cpus[i % cpus.len()].node;
+            w->rng = 0x9e3779b97f4a7c15ULL * (i + 1);
+            workers_.push(w);
+        }
+        threads_.reserve(threads);
+        for (size_t i = 0; i < threads; i++) {
+            detail::PoolWorker* w = workers_[i];
+            threads_.push(std::thread([this, w] { worker_loop(w); }));
+#if defined(__linux__)
+            if (!cpus.is_empty()) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(cpus[i % cpus.len()].cpu, &set);
+                pthread_setaffinity_np(threads_[i].native_handle(), sizeof(set), &set);
+            }
+#endif
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Runs every job already spawned, then stops the workers
+    ~ThreadPool() {
+        shutdown_.store(true, std::memory_order_seq_cst);
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            epoch_++;
+        }
+        sleep_cv_.notify_all();
+        for (std::thread& t : threads_) t.join();
+        for (detail::PoolWorker* w : workers_) delete w;
+    }
+
+    // The process-wide pool: RUSTY_NUM_THREADS workers (default: hardware
+    // concurrency), placed by RUSTY_THREAD_PLACEMENT (compact or spread)
+    static ThreadPool& global() {
+        static ThreadPool pool(default_threads(), default_placement());
+        return pool;
+    }
+
+    // The pool whose worker is calling, or the global pool
+    static ThreadPool& current() {
+        detail::PoolWorker* w = detail::current_pool_worker();
+        return w ? *w->pool : global();
+    }
+
+    size_t num_threads() const { return workers_.len(); }
+
+    // Index of the calling worker in this pool, or None outside it
+    Option<size_t> current_thread_index() const {
+        detail::PoolWorker* w = detail::current_pool_worker();
+        if (w && w->pool == this) return Option<size_t>(w->index);
+        return Option<size_t>();
+    }
+
+    // Run f on the pool and return once it has finished; parallel calls
+    // inside f (par_iter, join, scope) use this pool
+    template<typename F>
+    void install(F f) {
+        in_worker(f);
+    }
+
+    // Run f on the pool without waiting. f must own what it uses.
+    // @lifetime: (F: 'static)
+    template<typename F>
+    void spawn(F f) {
+        static_assert(is_send<F>::value, "ThreadPool::spawn: f must be Send");
+        push_job(&(new detail::HeapJob<F>(std::move(f)))->base);
+    }
+
+    // Queue a job whose storage the caller owns (a runtime can keep it in
+    // a coroutine frame); it must stay alive until job->run is called
+    void spawn_job(detail::PoolJob* job) { push_job(job); }
+
+    // Run a and b, potentially in parallel, and return when both are done
+    // @lifetime: (&'a, &'a) -> ()
+    template<typename A, typename B>
+    void join(A&& a, B&& b) {
+        detail::PoolWorker* w = detail::current_pool_worker();
+        if (!w || w->pool != this) {
+            auto both = [&] { join(a, b); };
+            in_worker(both);
+            return;
+        }
+        typedef typename std::remove_reference<B>::type BF;
+        detail::StackJob<BF> job_b(b, this);
+        w->deque.push(&job_b.base);
+        notify_one();
+
+        std::exception_ptr error_a;
+        try {
+            a();
+        } catch (...) {
+            error_a = std::current_exception();
+        }
+
+        // b is still below anything a left behind, unless it was stolen
+        for (;;) {
+            detail::PoolJob* job = w->deque.pop();
+            if (job == &job_b.base) {
+                job_b.run_inline();
+                break;
+            }
+            if (!job) {
+                wait_until(*w, job_b.latch);
+                break;
+            }
+            job->run(job);
+        }
+        if (error_a) std::rethrow_exception(error_a);
+        if (job_b.error) std::rethrow_exception(job_b.error);
+    }
+
+    // Call f(scope) on the pool; every closure spawned on the scope has
+    // finished when this returns
+    // @lifetime: (&'a) -> ()
+    template<typename F>
+    void scope(F f);
+};
+
+// Spawns closures that may borrow anything that outlives the scope
+class Scope {
+private:
+    friend class ThreadPool;
+    template<typename F> friend struct detail::ScopeJob;
+
+    ThreadPool* pool_;
+    std::atomic<size_t> pending_;  // Unfinished jobs, plus one for the body
+    detail::PoolLatch latch_;
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+
+    explicit Scope(ThreadPool* pool) : pool_(pool), pending_(1) {}
+
+    void record(std::exception_ptr error) {
+        std::lock_guard<std::mutex> lock(error_mutex_);
+        if (!error_) error_ = error;
+    }
+
+    void finish_one() {
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            ThreadPool* pool = pool_;
+            pool->set_latch(latch_);
+        }
+    }
+
+public:
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    // f runs before the enclosing scope() returns; to spawn more work
+    // from inside f, capture the Scope by reference
+    // @lifetime: (&'scope) -> ()
+    template<typename F>
+    void spawn(F f) {
+        static_assert(is_send<F>::value, "Scope::spawn: f must be Send");
+        pending_.fetch_add(1, std::memory_order_relaxed);
+        pool_->push_job(&(new detail::ScopeJob<F>(std::move(f), this))->base);
+    }
+};
+
+template<typename F>
+void ThreadPool::scope(F f) {
+    auto body = [this, &f] {
+        detail::PoolWorker* w = detail::current_pool_worker();
+        Scope s(this);
+        try {
+            f(s);
+        } catch (...) {
+            s.record(std::current_exception());
+        }
+        s.finish_one();
+        wait_until(*w, s.latch_);
+        if (s.error_) std::rethrow_exception(s.error_);
+    };
+    in_worker(body);
+}
+
+namespace detail {
+
+template<typename F>
+void StackJob<F>::execute(PoolJob* job) {
+    StackJob* self = reinterpret_cast<StackJob*>(job);
+    ThreadPool* pool = self->pool;
+    self->run_inline();
+    pool->set_latch(self->latch);
+}
+
+template<typename F>
+void ScopeJob<F>::execute(PoolJob* job) {
+    ScopeJob* self = reinterpret_cast<ScopeJob*>(job);
+    Scope* scope = self->scope;
+    F fn(std::move(self->f));
+    delete self;
+    try {
+        fn();
+    } catch (...) {
+        scope->record(std::current_exception());
+    }
+    scope->finish_one();
+}
+
+} // namespace detail
+
+// Run a and b on the current pool (see ThreadPool::join)
+// @lifetime: (&'a, &'a) -> ()
+template<typename A, typename B>
+void join(A&& a, B&& b) {
+    ThreadPool::current().join(std::forward<A>(a), std::forward<B>(b));
+}
+
+// Open a scope on the current pool (see ThreadPool::scope)
+// @lifetime: (&'a) -> ()
+template<typename F>
+void scope(F f) {
+    ThreadPool::current().scope(std::move(f));
+}
+
+// Run f on the global pool without waiting
+// @lifetime: (F: 'static)
+template<typename F>
+void spawn(F f) {
+    ThreadPool::global().spawn(std::move(f));
+}
+
+} // namespace rusty
+
+#endif // RUSTY_THREAD_POOL_HPP
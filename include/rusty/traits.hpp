@@ -0,0 +1,47 @@
+#ifndef RUSTY_TRAITS_HPP
+#define RUSTY_TRAITS_HPP
+
+#include <type_traits>
+
+// Internal type traits shared by the rusty containers
+
+// @safe
+namespace rusty {
+namespace detail {
+
+// C++11 stand-in for std::void_t
+template<typename...>
+struct make_void {
+    typedef void type;
+};
+
+// True when T declares `using is_transparent = ...`, i.e. it accepts any
+// key-like argument (a borrowed form of the key, like str for String)
+template<typename T, typename = void>
+struct is_transparent : std::false_type {};
+
+template<typename T>
+struct is_transparent<T, typename make_void<typename T::is_transparent>::type>
+    : std::true_type {};
+
+// Explicit copy: the copy constructor when there is one, otherwise the
+// Rust-style clone() member (String, Vec, Box, ...)
+template<typename T>
+T clone_value(const T& value, std::true_type) {
+    return value;
+}
+
+template<typename T>
+T clone_value(const T& value, std::false_type) {
+    return value.clone();
+}
+
+template<typename T>
+T clone_value(const T& value) {
+    return clone_value(value, std::is_copy_constructible<T>());
+}
+
+} // namespace detail
+} // namespace rusty
+
+#endif // RUSTY_TRAITS_HPP
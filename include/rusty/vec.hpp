@@ -4,71 +4,232 @@
 #include <memory>
 #include <algorithm>
 #include <initializer_list>
+#include <iterator>  // for std::distance, std::iterator_traits
 #include <cassert>
 #include <utility>  // for std::move, std::forward
 #include <cstddef>  // for size_t
-#include <cstring>  // for memcpy
+#include <cstdint>  // for SIZE_MAX
+#include <cstring>  // for memcpy, memmove
+#include <type_traits>
+#include "alloc.hpp"
+#include "bounds.hpp"
+#include "cow.hpp"
+#include "fwd.hpp"
+#include "iter.hpp"
+#include "relocate.hpp"
+#include "result.hpp"
+#include "slice.hpp"
+#include "stats.hpp"
+#include "traits.hpp"
 
 // Vec<T> - A growable array with owned elements
-// Equivalent to Rust's Vec<T>
+// Equivalent to Rust's Vec<T, A>
 //
 // Guarantees:
 // - Single ownership of the container
 // - Elements are owned by the Vec
 // - Automatic memory management
 // - Move semantics for the container
+//
+// Storage comes from the Alloc parameter (see alloc.hpp, default Global).
+// When T is trivially relocatable (see relocate.hpp), growing relocates all
+// elements with a single reallocate instead of moving and destroying them
+// one at a time.
 
 // @safe
 namespace rusty {
 
-template<typename T>
-class Vec {
+template<typename T, typename Alloc>
+class VecIntoIter;
+
+template<typename T, typename Alloc>
+class Vec : private detail::AllocHolder<Alloc> {
 private:
     T* data_;
     size_t size_;
     size_t capacity_;
+#if defined(RUSTY_STATS)
+    stats::GrowthCounters growth_stats_;
+#endif
+    
+    // First allocation size, as in Rust's RawVec: tiny buffers are never
+    // worth a trip to the allocator, big elements stay conservative
+    static constexpr size_t MIN_NON_ZERO_CAP =
+        sizeof(T) == 1 ? 8 : (sizeof(T) <= 1024 ? 4 : 1);
     
     void grow() {
-        size_t new_capacity = capacity_ == 0 ? 1 : capacity_ * 2;
-        T* new_data = static_cast<T*>(::operator new(new_capacity * sizeof(T)));
+        grow_for(1);
+    }
+    
+    // Make room for additional more elements with a single reallocation,
+    // keeping pushes afterwards amortized O(1)
+    void grow_for(size_t additional) {
+        if (try_grow_for(additional).is_err()) throw std::bad_alloc();
+    }
+    
+    Result<void, AllocError> try_grow_for(size_t additional) {
+        if (additional > SIZE_MAX - size_) {
+            return Result<void, AllocError>::Err(AllocError::capacity_overflow());
+        }
+        size_t needed = size_ + additional;
+        if (needed <= capacity_) return Result<void, AllocError>::Ok();
+        size_t doubled = capacity_ == 0 ? MIN_NON_ZERO_CAP : capacity_ * 2;
+        return try_relocate_to(needed > doubled ? needed : doubled);
+    }
+    
+    // Copy n elements from src into uninitialized dst
+    static void copy_n(T* dst, const T* src, size_t n, std::true_type) {
+        if (n > 0) {
+            std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), n * sizeof(T));
+        }
+    }
+    
+    static void copy_n(T* dst, const T* src, size_t n, std::false_type) {
+        for (size_t i = 0; i < n; ++i) {
+            new (&dst[i]) T(src[i]);
+        }
+    }
+    
+    T* allocate(size_t capacity) {
+        void* ptr = alloc_or_throw(this->alloc(), capacity * sizeof(T), alignof(T));
+        detail::observe_alloc(AllocKind::Vec, ptr, capacity * sizeof(T));
+        return static_cast<T*>(ptr);
+    }
+    
+    void deallocate() {
+        if (data_) {
+            detail::observe_dealloc(AllocKind::Vec, data_, capacity_ * sizeof(T));
+            this->alloc().deallocate(data_, capacity_ * sizeof(T), alignof(T));
+        }
+    }
+    
+    // Move storage to a new buffer of new_capacity elements
+    void relocate_to(size_t new_capacity) {
+        if (try_relocate_to(new_capacity).is_err()) throw std::bad_alloc();
+    }
+    
+    // As relocate_to, but reports failure; the Vec is unchanged on Err
+    Result<void, AllocError> try_relocate_to(size_t new_capacity) {
+        if (new_capacity > SIZE_MAX / sizeof(T)) {
+            return Result<void, AllocError>::Err(AllocError::capacity_overflow());
+        }
+        return try_relocate_to(new_capacity, is_trivially_relocatable<T>());
+    }
+    
+    // Fast path: bits can be copied, let the allocator extend in place or memcpy
+    Result<void, AllocError> try_relocate_to(size_t new_capacity, std::true_type) {
+        void* grown = detail::alloc_reallocate(this->alloc(), static_cast<void*>(data_),
+                                               capacity_ * sizeof(T), new_capacity * sizeof(T),
+                                               alignof(T), alloc_has_reallocate<Alloc>());
+        if (!grown) {
+            AllocError err = {new_capacity * sizeof(T), alignof(T)};
+            return Result<void, AllocError>::Err(err);
+        }
+        detail::observe_realloc(AllocKind::Vec, data_, capacity_ * sizeof(T), grown,
+                                new_capacity * sizeof(T));
+#if defined(RUSTY_STATS)
+        if (capacity_ != 0) {
+            growth_stats_.record(grown == data_ ? 0 : size_ * sizeof(T), stats::totals().vec);
+        }
+#endif
+        data_ = static_cast<T*>(grown);
+        capacity_ = new_capacity;
+        return Result<void, AllocError>::Ok();
+    }
+    
+    // Slow path: move-construct each element, then destroy the source
+    Result<void, AllocError> try_relocate_to(size_t new_capacity, std::false_type) {
+        T* new_data = static_cast<T*>(this->alloc().allocate(new_capacity * sizeof(T), alignof(T)));
+        if (!new_data) {
+            AllocError err = {new_capacity * sizeof(T), alignof(T)};
+            return Result<void, AllocError>::Err(err);
+        }
+        detail::observe_alloc(AllocKind::Vec, new_data, new_capacity * sizeof(T));
         
         // Move existing elements
         for (size_t i = 0; i < size_; ++i) {
             new (&new_data[i]) T(std::move(data_[i]));
             data_[i].~T();
         }
+#if defined(RUSTY_STATS)
+        if (capacity_ != 0) growth_stats_.record(size_ * sizeof(T), stats::totals().vec);
+#endif
         
-        ::operator delete(data_);
+        deallocate();
         data_ = new_data;
         capacity_ = new_capacity;
+        return Result<void, AllocError>::Ok();
+    }
+    
+    template<typename It>
+    void extend(It first, It last, std::input_iterator_tag) {
+        for (; first != last; ++first) {
+            push(*first);
+        }
+    }
+    
+    template<typename It>
+    void extend(It first, It last, std::forward_iterator_tag) {
+        grow_for(static_cast<size_t>(std::distance(first, last)));
+        for (; first != last; ++first) {
+            new (&data_[size_]) T(*first);
+            ++size_;
+        }
     }
     
 public:
     // Default constructor - empty vec
     Vec() : data_(nullptr), size_(0), capacity_(0) {}
     
+    // Empty vec using the given allocator
+    explicit Vec(const Alloc& alloc)
+        : detail::AllocHolder<Alloc>(alloc), data_(nullptr), size_(0), capacity_(0) {}
+    
     // Rust-idiomatic factory method - Vec::new()
     // @lifetime: owned
-    static Vec<T> new_() {
-        return Vec<T>();
+    static Vec new_() {
+        return Vec();
+    }
+    
+    // Vec::new_in()
+    // @lifetime: owned
+    static Vec new_in(const Alloc& alloc) {
+        return Vec(alloc);
     }
     
     // Rust-idiomatic factory with capacity - Vec::with_capacity()
     // @lifetime: owned
-    static Vec<T> with_capacity(size_t cap) {
-        Vec<T> v;
+    static Vec with_capacity(size_t cap) {
+        return with_capacity_in(cap, Alloc());
+    }
+    
+    // Vec::with_capacity_in()
+    // @lifetime: owned
+    static Vec with_capacity_in(size_t cap, const Alloc& alloc) {
+        Vec v(alloc);
         if (cap > 0) {
-            v.data_ = static_cast<T*>(::operator new(cap * sizeof(T)));
+            v.data_ = v.allocate(cap);
             v.capacity_ = cap;
         }
         return v;
     }
     
+    // Vec::try_with_capacity(): Err instead of throwing std::bad_alloc
+    // @lifetime: owned
+    static Result<Vec, AllocError> try_with_capacity(size_t cap) {
+        Vec v;
+        Result<void, AllocError> reserved = v.try_reserve(cap);
+        if (reserved.is_err()) {
+            return Result<Vec, AllocError>::Err(reserved.unwrap_err());
+        }
+        return Result<Vec, AllocError>::Ok(std::move(v));
+    }
+    
     // Constructor with initial capacity (C++ style)
     explicit Vec(size_t initial_capacity) 
         : data_(nullptr), size_(0), capacity_(0) {
         if (initial_capacity > 0) {
-            data_ = static_cast<T*>(::operator new(initial_capacity * sizeof(T)));
+            data_ = allocate(initial_capacity);
             capacity_ = initial_capacity;
         }
     }
@@ -88,7 +249,12 @@ public:
     
     // Move constructor
     Vec(Vec&& other) noexcept 
-        : data_(other.data_), size_(other.size_), capacity_(other.capacity_) {
+        : detail::AllocHolder<Alloc>(std::move(other.alloc())),
+          data_(other.data_), size_(other.size_), capacity_(other.capacity_)
+#if defined(RUSTY_STATS)
+          , growth_stats_(other.growth_stats_)
+#endif
+    {
         other.data_ = nullptr;
         other.size_ = 0;
         other.capacity_ = 0;
@@ -99,12 +265,16 @@ public:
         if (this != &other) {
             // Clean up existing data
             clear();
-            ::operator delete(data_);
+            deallocate();
             
-            // Take ownership
+            // Take ownership (the allocator moves with its storage)
+            this->alloc() = std::move(other.alloc());
             data_ = other.data_;
             size_ = other.size_;
             capacity_ = other.capacity_;
+#if defined(RUSTY_STATS)
+            growth_stats_ = other.growth_stats_;
+#endif
             
             other.data_ = nullptr;
             other.size_ = 0;
@@ -116,7 +286,7 @@ public:
     // Destructor
     ~Vec() {
         clear();
-        ::operator delete(data_);
+        deallocate();
     }
     
     // Push element to the back
@@ -128,10 +298,22 @@ public:
         ++size_;
     }
     
+    // Push, or report allocation failure instead of throwing; the Vec is
+    // unchanged (and value dropped) on Err
+    Result<void, AllocError> try_push(T value) {
+        if (size_ >= capacity_) {
+            Result<void, AllocError> grown = try_grow_for(1);
+            if (grown.is_err()) return grown;
+        }
+        new (&data_[size_]) T(std::move(value));
+        ++size_;
+        return Result<void, AllocError>::Ok();
+    }
+    
     // Pop element from the back
     // Returns empty Option-like type if vec is empty
     T pop() {
-        assert(size_ > 0);
+        RUSTY_BOUNDS_CHECK(size_ > 0, "pop from empty Vec");
         --size_;
         T result = std::move(data_[size_]);
         data_[size_].~T();
@@ -141,39 +323,48 @@ public:
     // Access element by index
     // @lifetime: (&'a) -> &'a
     T& operator[](size_t index) {
-        assert(index < size_);
+        RUSTY_BOUNDS_CHECK(index < size_, "Vec index out of bounds");
         return data_[index];
     }
     
     // @lifetime: (&'a) -> &'a
     const T& operator[](size_t index) const {
-        assert(index < size_);
+        RUSTY_BOUNDS_CHECK(index < size_, "Vec index out of bounds");
         return data_[index];
     }
     
+    // Access element by index without a bounds check, in any build
+    // @unsafe
+    // @lifetime: (&'a) -> &'a
+    const T& get_unchecked(size_t index) const { return data_[index]; }
+    
+    // @unsafe
+    // @lifetime: (&'a mut) -> &'a mut
+    T& get_unchecked_mut(size_t index) { return data_[index]; }
+    
     // Get first element
     // @lifetime: (&'a) -> &'a
     T& front() {
-        assert(size_ > 0);
+        RUSTY_BOUNDS_CHECK(size_ > 0, "front of empty Vec");
         return data_[0];
     }
     
     // @lifetime: (&'a) -> &'a
     const T& front() const {
-        assert(size_ > 0);
+        RUSTY_BOUNDS_CHECK(size_ > 0, "front of empty Vec");
         return data_[0];
     }
     
     // Get last element
     // @lifetime: (&'a) -> &'a
     T& back() {
-        assert(size_ > 0);
+        RUSTY_BOUNDS_CHECK(size_ > 0, "back of empty Vec");
         return data_[size_ - 1];
     }
     
     // @lifetime: (&'a) -> &'a
     const T& back() const {
-        assert(size_ > 0);
+        RUSTY_BOUNDS_CHECK(size_ > 0, "back of empty Vec");
         return data_[size_ - 1];
     }
     
@@ -184,34 +375,329 @@ public:
     // Check if empty
     bool is_empty() const { return size_ == 0; }
     
+    // Get the allocator
+    const Alloc& allocator() const { return this->alloc(); }
+    
     // Get capacity
     size_t capacity() const { return capacity_; }
+    size_t cap() const { return capacity_; }
+    
+    // Length and capacity; reallocations and bytes_copied need RUSTY_STATS
+    stats::GrowthStats stats() const {
+        stats::GrowthStats s = stats::GrowthStats();
+        s.len = size_;
+        s.capacity = capacity_;
+#if defined(RUSTY_STATS)
+        s.reallocations = growth_stats_.reallocations;
+        s.bytes_copied = growth_stats_.bytes_copied;
+#endif
+        return s;
+    }
     
     // Reserve capacity
     void reserve(size_t new_capacity) {
         if (new_capacity > capacity_) {
-            T* new_data = static_cast<T*>(::operator new(new_capacity * sizeof(T)));
-            
-            // Move existing elements
-            for (size_t i = 0; i < size_; ++i) {
-                new (&new_data[i]) T(std::move(data_[i]));
-                data_[i].~T();
-            }
-            
-            ::operator delete(data_);
-            data_ = new_data;
-            capacity_ = new_capacity;
+            relocate_to(new_capacity);
+        }
+    }
+    
+    // Reserve capacity, reporting failure instead of throwing
+    Result<void, AllocError> try_reserve(size_t new_capacity) {
+        if (new_capacity <= capacity_) return Result<void, AllocError>::Ok();
+        return try_relocate_to(new_capacity);
+    }
+    
+    // Drop the spare capacity, freeing the buffer when empty
+    void shrink_to_fit() {
+        if (capacity_ == size_) return;
+        if (size_ == 0) {
+            deallocate();
+            data_ = nullptr;
+            capacity_ = 0;
+            return;
         }
+        relocate_to(size_);
     }
     
     // Clear all elements
     void clear() {
+        truncate(0);
+    }
+    
+    // Drop the elements past len, keeping the capacity
+    void truncate(size_t len) {
+        while (size_ > len) {
+            --size_;
+            data_[size_].~T();
+        }
+    }
+    
+    // Append copies of n elements, reserving once; memcpy when T is
+    // trivially copyable. src may point into this Vec.
+    void extend_from_slice(const T* src, size_t n) {
+        if (n == 0) return;
+        if (src >= data_ && src < data_ + size_) {
+            size_t offset = static_cast<size_t>(src - data_);
+            grow_for(n);
+            src = data_ + offset;
+        } else {
+            grow_for(n);
+        }
+        if (std::is_trivially_copyable<T>::value) {
+            copy_n(data_ + size_, src, n, std::true_type());
+            size_ += n;
+        } else {
+            // One at a time so a throwing copy leaves a valid Vec
+            for (size_t i = 0; i < n; ++i) {
+                new (&data_[size_]) T(src[i]);
+                ++size_;
+            }
+        }
+    }
+    
+    void extend_from_slice(std::initializer_list<T> items) {
+        extend_from_slice(items.begin(), items.size());
+    }
+    
+    void extend_from_slice(Slice<T> items) {
+        extend_from_slice(items.as_ptr(), items.len());
+    }
+    
+    // Append [first, last), reserving once when the length is known up front
+    template<typename It>
+    void extend(It first, It last) {
+        extend(first, last, typename std::iterator_traits<It>::iterator_category());
+    }
+    
+    // Move all of other's elements to the end of this Vec, leaving other empty
+    void append(Vec& other) {
+        if (this == &other || other.size_ == 0) return;
+        grow_for(other.size_);
+        relocate_n(data_ + size_, other.data_, other.size_);
+        size_ += other.size_;
+        other.size_ = 0;
+    }
+    
+    // Grow with copies of value, or truncate, to exactly len elements
+    void resize(size_t len, const T& value) {
+        if (len <= size_) {
+            truncate(len);
+            return;
+        }
+        T fill(value);  // value may be one of our elements
+        grow_for(len - size_);
+        while (size_ < len) {
+            new (&data_[size_]) T(fill);
+            ++size_;
+        }
+    }
+    
+    // Insert value at index, shifting the tail right
+    void insert(size_t index, T value) {
+        RUSTY_BOUNDS_CHECK(index <= size_, "Vec insert index out of bounds");
+        if (size_ >= capacity_) {
+            grow();
+        }
+        relocate_n(data_ + index + 1, data_ + index, size_ - index);
+        new (&data_[index]) T(std::move(value));
+        ++size_;
+    }
+    
+    // Insert copies of n elements at index, reserving once.
+    // src must not point into this Vec.
+    void insert_from_slice(size_t index, const T* src, size_t n) {
+        RUSTY_BOUNDS_CHECK(index <= size_, "Vec insert index out of bounds");
+        assert(src + n <= data_ || src >= data_ + size_);
+        if (n == 0) return;
+        grow_for(n);
+        if (std::is_trivially_copyable<T>::value) {
+            std::memmove(static_cast<void*>(data_ + index + n),
+                         static_cast<const void*>(data_ + index), (size_ - index) * sizeof(T));
+            copy_n(data_ + index, src, n, std::true_type());
+            size_ += n;
+        } else {
+            // Copy to the end, then rotate into place: a throwing copy
+            // leaves the original elements untouched
+            size_t old_size = size_;
+            try {
+                extend_from_slice(src, n);
+            } catch (...) {
+                truncate(old_size);
+                throw;
+            }
+            std::rotate(data_ + index, data_ + old_size, data_ + size_);
+        }
+    }
+    
+    // Remove and return the element at index, shifting the tail left
+    // @lifetime: owned
+    T remove(size_t index) {
+        RUSTY_BOUNDS_CHECK(index < size_, "Vec remove index out of bounds");
+        T result = std::move(data_[index]);
+        data_[index].~T();
+        relocate_n(data_ + index, data_ + index + 1, size_ - index - 1);
+        --size_;
+        return result;
+    }
+    
+    // Remove and return the element at index, filling the gap with the last
+    // element: O(1), does not preserve order
+    // @lifetime: owned
+    T swap_remove(size_t index) {
+        RUSTY_BOUNDS_CHECK(index < size_, "Vec swap_remove index out of bounds");
+        T result = std::move(data_[index]);
+        data_[index].~T();
+        --size_;
+        if (index != size_) {
+            relocate_n(data_ + index, data_ + size_, 1);
+        }
+        return result;
+    }
+    
+    // Remove the elements in [start, end) and return them, in order, as a
+    // new Vec
+    // @lifetime: owned
+    Vec drain(size_t start, size_t end) {
+        RUSTY_BOUNDS_CHECK(start <= end && end <= size_, "Vec drain range out of bounds");
+        size_t n = end - start;
+        Vec out = Vec::with_capacity_in(n, this->alloc());
+        relocate_n(out.data_, data_ + start, n);
+        out.size_ = n;
+        relocate_n(data_ + start, data_ + end, size_ - end);
+        size_ -= n;
+        return out;
+    }
+    
+    // Keep only the elements for which pred returns true, in order
+    template<typename Pred>
+    void retain(Pred pred) {
+        size_t kept = 0;
         for (size_t i = 0; i < size_; ++i) {
-            data_[i].~T();
+            if (pred(static_cast<const T&>(data_[i]))) {
+                if (kept != i) {
+                    data_[kept] = std::move(data_[i]);
+                }
+                ++kept;
+            }
+        }
+        truncate(kept);
+    }
+    
+    // Remove consecutive elements for which same(element, previous kept)
+    // returns true
+    template<typename Same>
+    void dedup_by(Same same) {
+        if (size_ < 2) return;
+        size_t kept = 1;
+        for (size_t i = 1; i < size_; ++i) {
+            if (!same(static_cast<const T&>(data_[i]), static_cast<const T&>(data_[kept - 1]))) {
+                if (kept != i) {
+                    data_[kept] = std::move(data_[i]);
+                }
+                ++kept;
+            }
         }
+        truncate(kept);
+    }
+    
+    // Remove consecutive elements that map to the same key
+    template<typename Key>
+    void dedup_by_key(Key key) {
+        dedup_by([&key](const T& a, const T& b) { return key(a) == key(b); });
+    }
+    
+    // Remove consecutive repeated elements
+    void dedup() {
+        dedup_by([](const T& a, const T& b) { return a == b; });
+    }
+    
+    // Raw access to the buffer
+    // @lifetime: (&'a) -> &'a
+    const T* as_ptr() const { return data_; }
+    
+    // @lifetime: (&'a mut) -> &'a mut
+    T* as_mut_ptr() { return data_; }
+    
+    // Set the length without dropping or constructing anything: the first
+    // len elements must be live, and any past it are forgotten
+    // @unsafe
+    void set_len(size_t len) {
+        assert(len <= capacity_);
+        size_ = len;
+    }
+    
+    // Give up the buffer and its elements, leaving the Vec empty; they are
+    // owned by the caller until handed back to from_raw_parts
+    // @unsafe
+    T* into_raw_parts(size_t& len, size_t& capacity) {
+        T* data = data_;
+        len = size_;
+        capacity = capacity_;
+        data_ = nullptr;
         size_ = 0;
+        capacity_ = 0;
+        return data;
+    }
+    
+    // Adopt a buffer from into_raw_parts of a Vec with an equal allocator
+    // @unsafe
+    // @lifetime: owned
+    static Vec from_raw_parts(T* data, size_t len, size_t capacity, const Alloc& alloc = Alloc()) {
+        Vec v(alloc);
+        v.data_ = data;
+        v.size_ = len;
+        v.capacity_ = capacity;
+        return v;
+    }
+    
+    // Borrow the elements as a slice; the Vec must not grow while it lives
+    // @lifetime: (&'a) -> &'a
+    Slice<T> as_slice() const { return Slice<T>(data_, size_); }
+    
+    // @lifetime: (&'a mut) -> &'a mut
+    SliceMut<T> as_mut_slice() { return SliceMut<T>(data_, size_); }
+    
+    // Sorting; see SliceMut for the algorithms
+    void sort_unstable() { as_mut_slice().sort_unstable(); }
+    
+    template<typename Less>
+    void sort_unstable_by(Less less) { as_mut_slice().sort_unstable_by(less); }
+    
+    template<typename F>
+    void sort_unstable_by_key(F key) { as_mut_slice().sort_unstable_by_key(key); }
+    
+    void sort() { as_mut_slice().sort(); }
+    
+    template<typename Less>
+    void sort_by(Less less) { as_mut_slice().sort_by(less); }
+    
+    template<typename F>
+    void sort_by_key(F key) { as_mut_slice().sort_by_key(key); }
+    
+    template<typename F>
+    void sort_by_cached_key(F key) { as_mut_slice().sort_by_cached_key(key); }
+    
+    void radix_sort() { as_mut_slice().radix_sort(); }
+    
+    template<typename F>
+    void radix_sort_by_key(F key) { as_mut_slice().radix_sort_by_key(key); }
+    
+    // Ok(index) of a match in a sorted Vec, or Err(index) to insert at
+    Result<size_t, size_t> binary_search(const T& value) const {
+        return as_slice().binary_search(value);
     }
     
+    // Lazy iterators (see iter.hpp)
+    // @lifetime: (&'a) -> &'a
+    SliceIter<T> iter() const { return SliceIter<T>(data_, data_ + size_); }
+    
+    // @lifetime: (&'a mut) -> &'a mut
+    SliceIterMut<T> iter_mut() { return SliceIterMut<T>(data_, data_ + size_); }
+    
+    // Consume the Vec, yielding its elements by value
+    // @lifetime: owned
+    VecIntoIter<T, Alloc> into_iter() && { return VecIntoIter<T, Alloc>(std::move(*this)); }
+    
     // Iterator support
     // @lifetime: (&'a) -> &'a
     T* begin() { return data_; }
@@ -221,12 +707,19 @@ public:
     T* end() { return data_ + size_; }
     const T* end() const { return data_ + size_; }
     
-    // Clone the Vec (explicit deep copy)
+    // Clone the Vec (explicit deep copy). The clone's capacity is len();
+    // trivially copyable elements are copied with one memcpy
     // @lifetime: owned
     Vec clone() const {
-        Vec result = Vec::with_capacity(capacity_);
+        Vec result = Vec::with_capacity_in(size_, this->alloc());
+        if (std::is_trivially_copyable<T>::value) {
+            if (size_ > 0) std::memcpy(static_cast<void*>(result.data_), data_, size_ * sizeof(T));
+            result.size_ = size_;
+            return result;
+        }
         for (size_t i = 0; i < size_; ++i) {
-            result.push(data_[i]);  // Requires T to be copyable
+            new (&result.data_[i]) T(detail::clone_value(data_[i]));
+            result.size_++;
         }
         return result;
     }
@@ -245,6 +738,51 @@ public:
     }
 };
 
+template<typename T, typename Alloc>
+constexpr size_t Vec<T, Alloc>::MIN_NON_ZERO_CAP;
+
+// Vec only holds a pointer to its heap buffer (plus its allocator), so it can
+// be relocated bitwise whenever the allocator can
+template<typename T, typename Alloc>
+struct is_trivially_relocatable<Vec<T, Alloc>> : is_trivially_relocatable<Alloc> {};
+
+// A borrowed Slice becomes owned by copying its elements into a Vec with a
+// default-constructed allocator
+template<typename T, typename Alloc>
+struct cow_traits<Slice<T>, Vec<T, Alloc>> {
+    // @lifetime: (&'a) -> &'a
+    static Slice<T> borrow(const Vec<T, Alloc>& owned) { return owned.as_slice(); }
+
+    // @lifetime: owned
+    static Vec<T, Alloc> to_owned(Slice<T> borrowed) {
+        Vec<T, Alloc> v = Vec<T, Alloc>::with_capacity(borrowed.len());
+        v.extend_from_slice(borrowed.as_ptr(), borrowed.len());
+        return v;
+    }
+};
+
+// Iterator returned by Vec::into_iter(): owns the elements and moves each
+// one out in turn; those not reached are dropped with the iterator
+template<typename T, typename Alloc>
+class VecIntoIter : public Iterator<VecIntoIter<T, Alloc>, T> {
+private:
+    Vec<T, Alloc> vec_;
+    size_t pos_;
+
+public:
+    explicit VecIntoIter(Vec<T, Alloc> vec) : vec_(std::move(vec)), pos_(0) {}
+
+    template<typename F>
+    bool next_with(F&& f) {
+        if (pos_ == vec_.len()) return false;
+        f(std::move(vec_[pos_++]));
+        return true;
+    }
+
+    size_t len() const { return vec_.len() - pos_; }
+    size_t size_hint() const { return len(); }
+};
+
 // Helper function to create a Vec
 template<typename T>
 // @lifetime: owned
@@ -0,0 +1,679 @@
+#ifndef RUSTY_VECDEQUE_HPP
+#define RUSTY_VECDEQUE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include "alloc.hpp"
+#include "bounds.hpp"
+#include "fwd.hpp"
+#include "iter.hpp"
+#include "option.hpp"
+#include "relocate.hpp"
+#include "result.hpp"
+#include "slice.hpp"
+#include "vec.hpp"
+
+// VecDeque<T> - A double-ended queue in a growable ring buffer
+// Equivalent to Rust's VecDeque<T, A>
+//
+// Guarantees:
+// - push/pop at either end are amortized O(1); indexing is O(1)
+// - The capacity is always a power of two, so a logical index maps to a
+//   slot with one add and one mask
+// - as_slices() exposes the contents as at most two contiguous runs, for
+//   scatter/gather I/O without copying
+//
+// Storage comes from the Alloc parameter (see alloc.hpp, default Global).
+// As with Vec, growing a buffer of trivially relocatable elements is a
+// single reallocate; afterwards only the shorter of the two wrapped
+// segments is moved to reconnect the ring (as Rust's
+// handle_capacity_increase does).
+
+// @safe
+namespace rusty {
+
+template<typename T, typename Alloc>
+class VecDequeIntoIter;
+
+template<typename T, typename Alloc>
+class VecDeque : private detail::AllocHolder<Alloc> {
+private:
+    T* data_;
+    size_t head_;      // Slot of the first element
+    size_t len_;
+    size_t capacity_;  // Zero or a power of two
+
+    static constexpr size_t MIN_NON_ZERO_CAP = sizeof(T) <= 1024 ? 4 : 1;
+
+    // Slot of logical index i (which may be one past either end)
+    size_t slot(size_t i) const {
+        return (head_ + i) & (capacity_ - 1);
+    }
+
+    T* at(size_t i) { return data_ + slot(i); }
+    const T* at(size_t i) const { return data_ + slot(i); }
+
+    static size_t next_power_of_two(size_t n) {
+        size_t cap = 1;
+        while (cap < n) cap <<= 1;
+        return cap;
+    }
+
+    void grow() {
+        grow_for(1);
+    }
+
+    void grow_for(size_t additional) {
+        if (try_grow_for(additional).is_err()) throw std::bad_alloc();
+    }
+
+    Result<void, AllocError> try_grow_for(size_t additional) {
+        if (additional > SIZE_MAX / 2 - len_) {
+            return Result<void, AllocError>::Err(AllocError::capacity_overflow());
+        }
+        size_t needed = len_ + additional;
+        if (needed <= capacity_) return Result<void, AllocError>::Ok();
+        size_t doubled = capacity_ == 0 ? MIN_NON_ZERO_CAP : capacity_ * 2;
+        return try_relocate_to(next_power_of_two(needed > doubled ? needed : doubled));
+    }
+
+    void deallocate() {
+        if (data_) {
+            this->alloc().deallocate(data_, capacity_ * sizeof(T), alignof(T));
+        }
+    }
+
+    Result<void, AllocError> try_relocate_to(size_t new_capacity) {
+        if (new_capacity > SIZE_MAX / sizeof(T)) {
+            return Result<void, AllocError>::Err(AllocError::capacity_overflow());
+        }
+        return try_relocate_to(new_capacity, is_trivially_relocatable<T>());
+    }
+
+    // Fast path: reallocate the buffer as is, then reconnect the ring by
+    // moving whichever wrapped segment is shorter
+    Result<void, AllocError> try_relocate_to(size_t new_capacity, std::true_type) {
+        size_t old_capacity = capacity_;
+        void* grown = detail::alloc_reallocate(this->alloc(), static_cast<void*>(data_),
+                                               old_capacity * sizeof(T), new_capacity * sizeof(T),
+                                               alignof(T), alloc_has_reallocate<Alloc>());
+        if (!grown) {
+            AllocError err = {new_capacity * sizeof(T), alignof(T)};
+            return Result<void, AllocError>::Err(err);
+        }
+        data_ = static_cast<T*>(grown);
+        capacity_ = new_capacity;
+
+        if (head_ + len_ > old_capacity) {
+            size_t head_len = old_capacity - head_;
+            size_t tail_len = len_ - head_len;
+            if (tail_len < head_len) {
+                // [0, tail_len) continues right after the old end
+                relocate_n(data_ + old_capacity, data_, tail_len);
+            } else {
+                // [head_, old_capacity) moves up against the new end
+                size_t new_head = new_capacity - head_len;
+                relocate_n(data_ + new_head, data_ + head_, head_len);
+                head_ = new_head;
+            }
+        }
+        return Result<void, AllocError>::Ok();
+    }
+
+    // Slow path: move the elements, in order, to the front of a new buffer
+    Result<void, AllocError> try_relocate_to(size_t new_capacity, std::false_type) {
+        T* new_data = static_cast<T*>(this->alloc().allocate(new_capacity * sizeof(T), alignof(T)));
+        if (!new_data) {
+            AllocError err = {new_capacity * sizeof(T), alignof(T)};
+            return Result<void, AllocError>::Err(err);
+        }
+        for (size_t i = 0; i < len_; ++i) {
+            T* src = at(i);
+            new (&new_data[i]) T(std::move(*src));
+            src->~T();
+        }
+        deallocate();
+        data_ = new_data;
+        head_ = 0;
+        capacity_ = new_capacity;
+        return Result<void, AllocError>::Ok();
+    }
+
+    // Remove the front element; the deque must not be empty
+    T take_front() {
+        T* src = data_ + head_;
+        T value(std::move(*src));
+        src->~T();
+        head_ = slot(1);
+        --len_;
+        return value;
+    }
+
+    T take_back() {
+        T* src = at(len_ - 1);
+        T value(std::move(*src));
+        src->~T();
+        --len_;
+        return value;
+    }
+
+    // Move the live element at logical index from to the empty slot at to
+    void shift(size_t to, size_t from) {
+        T* src = at(from);
+        new (at(to)) T(std::move(*src));
+        src->~T();
+    }
+
+    template<typename It>
+    void extend(It first, It last, std::input_iterator_tag) {
+        for (; first != last; ++first) {
+            push_back(*first);
+        }
+    }
+
+    template<typename It>
+    void extend(It first, It last, std::forward_iterator_tag) {
+        grow_for(static_cast<size_t>(std::distance(first, last)));
+        for (; first != last; ++first) {
+            new (at(len_)) T(*first);
+            ++len_;
+        }
+    }
+
+    template<bool Const>
+    class Cursor {
+    private:
+        typedef typename std::conditional<Const, const VecDeque, VecDeque>::type Deque;
+        typedef typename std::conditional<Const, const T, T>::type Elem;
+        Deque* deque_;
+        size_t index_;
+
+    public:
+        Cursor(Deque* deque, size_t index) : deque_(deque), index_(index) {}
+
+        Elem& operator*() const { return *deque_->at(index_); }
+        Elem* operator->() const { return deque_->at(index_); }
+
+        Cursor& operator++() {
+            ++index_;
+            return *this;
+        }
+
+        bool operator!=(const Cursor& other) const { return index_ != other.index_; }
+        bool operator==(const Cursor& other) const { return index_ == other.index_; }
+    };
+
+public:
+    typedef Cursor<false> iterator;
+    typedef Cursor<true> const_iterator;
+
+    // Empty deque; allocates nothing
+    VecDeque() : data_(nullptr), head_(0), len_(0), capacity_(0) {}
+
+    explicit VecDeque(const Alloc& alloc)
+        : detail::AllocHolder<Alloc>(alloc), data_(nullptr), head_(0), len_(0), capacity_(0) {}
+
+    VecDeque(std::initializer_list<T> init) : VecDeque() {
+        extend(init.begin(), init.end());
+    }
+
+    // @lifetime: owned
+    static VecDeque new_() {
+        return VecDeque();
+    }
+
+    // @lifetime: owned
+    static VecDeque new_in(const Alloc& alloc) {
+        return VecDeque(alloc);
+    }
+
+    // Room for at least cap elements (rounded up to a power of two)
+    // @lifetime: owned
+    static VecDeque with_capacity(size_t cap) {
+        return with_capacity_in(cap, Alloc());
+    }
+
+    // @lifetime: owned
+    static VecDeque with_capacity_in(size_t cap, const Alloc& alloc) {
+        VecDeque deque(alloc);
+        deque.reserve(cap);
+        return deque;
+    }
+
+    // @lifetime: owned
+    static Result<VecDeque, AllocError> try_with_capacity(size_t cap) {
+        VecDeque deque;
+        Result<void, AllocError> reserved = deque.try_reserve(cap);
+        if (reserved.is_err()) {
+            return Result<VecDeque, AllocError>::Err(reserved.unwrap_err());
+        }
+        return Result<VecDeque, AllocError>::Ok(std::move(deque));
+    }
+
+    // Take over a Vec's elements, in order (Rust: From<Vec<T>>)
+    // @lifetime: owned
+    static VecDeque from_vec(Vec<T, Alloc> vec) {
+        VecDeque deque(vec.allocator());
+        deque.reserve(vec.len());
+        for (size_t i = 0; i < vec.len(); ++i) {
+            new (deque.at(deque.len_)) T(std::move(vec[i]));
+            ++deque.len_;
+        }
+        return deque;
+    }
+
+    VecDeque(const VecDeque&) = delete;
+    VecDeque& operator=(const VecDeque&) = delete;
+
+    VecDeque(VecDeque&& other) noexcept
+        : detail::AllocHolder<Alloc>(std::move(other.alloc())),
+          data_(other.data_), head_(other.head_), len_(other.len_), capacity_(other.capacity_) {
+        other.data_ = nullptr;
+        other.head_ = 0;
+        other.len_ = 0;
+        other.capacity_ = 0;
+    }
+
+    VecDeque& operator=(VecDeque&& other) noexcept {
+        if (this != &other) {
+            clear();
+            deallocate();
+            this->alloc() = std::move(other.alloc());
+            data_ = other.data_;
+            head_ = other.head_;
+            len_ = other.len_;
+            capacity_ = other.capacity_;
+
+            other.data_ = nullptr;
+            other.head_ = 0;
+            other.len_ = 0;
+            other.capacity_ = 0;
+        }
+        return *this;
+    }
+
+    ~VecDeque() {
+        clear();
+        deallocate();
+    }
+
+    // Size and capacity
+    size_t len() const { return len_; }
+    bool is_empty() const { return len_ == 0; }
+    size_t capacity() const { return capacity_; }
+
+    // Get the allocator
+    const Alloc& allocator() const { return this->alloc(); }
+
+    // Reserve room for at least additional more elements
+    void reserve(size_t additional) {
+        grow_for(additional);
+    }
+
+    // Reserve, reporting failure instead of throwing; the deque is
+    // unchanged on Err
+    Result<void, AllocError> try_reserve(size_t additional) {
+        return try_grow_for(additional);
+    }
+
+    void push_back(T value) {
+        if (len_ == capacity_) {
+            grow();
+        }
+        new (at(len_)) T(std::move(value));
+        ++len_;
+    }
+
+    void push_front(T value) {
+        if (len_ == capacity_) {
+            grow();
+        }
+        head_ = slot(capacity_ - 1);
+        new (data_ + head_) T(std::move(value));
+        ++len_;
+    }
+
+    // Push, or report allocation failure instead of throwing; the deque
+    // is unchanged (and value dropped) on Err
+    Result<void, AllocError> try_push_back(T value) {
+        if (len_ == capacity_) {
+            Result<void, AllocError> grown = try_grow_for(1);
+            if (grown.is_err()) return grown;
+        }
+        push_back(std::move(value));
+        return Result<void, AllocError>::Ok();
+    }
+
+    Result<void, AllocError> try_push_front(T value) {
+        if (len_ == capacity_) {
+            Result<void, AllocError> grown = try_grow_for(1);
+            if (grown.is_err()) return grown;
+        }
+        push_front(std::move(value));
+        return Result<void, AllocError>::Ok();
+    }
+
+    // @lifetime: owned
+    Option<T> pop_front() {
+        if (len_ == 0) return None;
+        return Option<T>(take_front());
+    }
+
+    // @lifetime: owned
+    Option<T> pop_back() {
+        if (len_ == 0) return None;
+        return Option<T>(take_back());
+    }
+
+    // Element access
+    // @lifetime: (&'a) -> &'a
+    T& operator[](size_t index) {
+        RUSTY_BOUNDS_CHECK(index < len_, "VecDeque index out of bounds");
+        return *at(index);
+    }
+
+    // @lifetime: (&'a) -> &'a
+    const T& operator[](size_t index) const {
+        RUSTY_BOUNDS_CHECK(index < len_, "VecDeque index out of bounds");
+        return *at(index);
+    }
+
+    // Access element by index without a bounds check, in any build
+    // @unsafe
+    // @lifetime: (&'a) -> &'a
+    const T& get_unchecked(size_t index) const { return *at(index); }
+
+    // @unsafe
+    // @lifetime: (&'a mut) -> &'a mut
+    T& get_unchecked_mut(size_t index) { return *at(index); }
+
+    // @lifetime: (&'a) -> &'a
+    Option<const T&> get(size_t index) const {
+        if (index >= len_) return None;
+        return Option<const T&>(*at(index));
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    Option<T&> get_mut(size_t index) {
+        if (index >= len_) return None;
+        return Option<T&>(*at(index));
+    }
+
+    // @lifetime: (&'a) -> &'a
+    Option<const T&> front() const { return get(0); }
+
+    // @lifetime: (&'a) -> &'a
+    Option<const T&> back() const { return len_ ? get(len_ - 1) : Option<const T&>(None); }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    Option<T&> front_mut() { return get_mut(0); }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    Option<T&> back_mut() { return len_ ? get_mut(len_ - 1) : Option<T&>(None); }
+
+    void swap(size_t i, size_t j) {
+        RUSTY_BOUNDS_CHECK(i < len_ && j < len_, "VecDeque swap index out of bounds");
+        using std::swap;
+        swap(*at(i), *at(j));
+    }
+
+    // Drop all elements, keeping the capacity
+    void clear() {
+        truncate(0);
+        head_ = 0;
+    }
+
+    // Drop the elements from index len on, keeping the capacity
+    void truncate(size_t len) {
+        while (len_ > len) {
+            at(len_ - 1)->~T();
+            --len_;
+        }
+    }
+
+    // Insert value at index, shifting whichever side is shorter
+    void insert(size_t index, T value) {
+        RUSTY_BOUNDS_CHECK(index <= len_, "VecDeque insert index out of bounds");
+        if (len_ == capacity_) {
+            grow();
+        }
+        if (index < len_ - index) {
+            // Open a slot at the front and move [0, index) down by one
+            head_ = slot(capacity_ - 1);
+            for (size_t i = 0; i < index; ++i) {
+                shift(i, i + 1);
+            }
+        } else {
+            for (size_t i = len_; i > index; --i) {
+                shift(i, i - 1);
+            }
+        }
+        new (at(index)) T(std::move(value));
+        ++len_;
+    }
+
+    // Remove and return the element at index, shifting whichever side is
+    // shorter to close the gap
+    // @lifetime: owned
+    Option<T> remove(size_t index) {
+        if (index >= len_) return None;
+        T* src = at(index);
+        Option<T> value(T(std::move(*src)));
+        src->~T();
+        if (index < len_ - 1 - index) {
+            for (size_t i = index; i > 0; --i) {
+                shift(i, i - 1);
+            }
+            head_ = slot(1);
+        } else {
+            for (size_t i = index; i + 1 < len_; ++i) {
+                shift(i, i + 1);
+            }
+        }
+        --len_;
+        return value;
+    }
+
+    // Keep only the elements for which pred returns true, in order
+    template<typename Pred>
+    void retain(Pred pred) {
+        size_t kept = 0;
+        for (size_t i = 0; i < len_; ++i) {
+            if (pred(static_cast<const T&>(*at(i)))) {
+                if (kept != i) {
+                    *at(kept) = std::move(*at(i));
+                }
+                ++kept;
+            }
+        }
+        truncate(kept);
+    }
+
+    // Append [first, last), reserving once when the length is known up front
+    template<typename It>
+    void extend(It first, It last) {
+        extend(first, last, typename std::iterator_traits<It>::iterator_category());
+    }
+
+    // Move all of other's elements to the back, leaving other empty
+    void append(VecDeque& other) {
+        if (this == &other) return;
+        grow_for(other.len_);
+        while (other.len_ > 0) {
+            new (at(len_)) T(other.take_front());
+            ++len_;
+        }
+        other.head_ = 0;
+    }
+
+    // Rotate so that the element at index mid becomes the first; moves
+    // min(mid, len - mid) elements, or none when the ring is full
+    void rotate_left(size_t mid) {
+        RUSTY_BOUNDS_CHECK(mid <= len_, "VecDeque rotate out of bounds");
+        if (len_ == capacity_) {
+            head_ = slot(mid);
+        } else if (mid <= len_ - mid) {
+            for (size_t i = 0; i < mid; ++i) {
+                push_back(take_front());
+            }
+        } else {
+            for (size_t i = mid; i < len_; ++i) {
+                push_front(take_back());
+            }
+        }
+    }
+
+    // Rotate so that the last k elements come first
+    void rotate_right(size_t k) {
+        RUSTY_BOUNDS_CHECK(k <= len_, "VecDeque rotate out of bounds");
+        rotate_left(len_ - k);
+    }
+
+    // The contents as two contiguous runs, front part first; the second
+    // is empty unless the ring wraps
+    // @lifetime: (&'a) -> &'a
+    std::pair<Slice<T>, Slice<T>> as_slices() const {
+        if (head_ + len_ <= capacity_) {
+            return std::make_pair(Slice<T>(data_ + head_, len_), Slice<T>(data_, 0));
+        }
+        size_t head_len = capacity_ - head_;
+        return std::make_pair(Slice<T>(data_ + head_, head_len), Slice<T>(data_, len_ - head_len));
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    std::pair<SliceMut<T>, SliceMut<T>> as_mut_slices() {
+        if (head_ + len_ <= capacity_) {
+            return std::make_pair(SliceMut<T>(data_ + head_, len_), SliceMut<T>(data_, 0));
+        }
+        size_t head_len = capacity_ - head_;
+        return std::make_pair(SliceMut<T>(data_ + head_, head_len),
+                              SliceMut<T>(data_, len_ - head_len));
+    }
+
+    // Rearrange the buffer so the elements are one contiguous run, and
+    // return it; O(len) only when the ring wraps (as in Rust, the shorter
+    // segment is moved when the free space allows, else one is rotated)
+    // @lifetime: (&'a mut) -> &'a mut
+    SliceMut<T> make_contiguous() {
+        if (head_ + len_ <= capacity_) {
+            return SliceMut<T>(data_ + head_, len_);
+        }
+        size_t head_len = capacity_ - head_;
+        size_t tail_len = len_ - head_len;
+        size_t free = capacity_ - len_;
+        
+        if (free >= head_len) {
+            // Shift the tail up, then put the head segment in front of it
+            relocate_n(data_ + head_len, data_, tail_len);
+            relocate_n(data_, data_ + head_, head_len);
+            head_ = 0;
+        } else if (free >= tail_len) {
+            // Shift the head segment down, then put the tail after it
+            relocate_n(data_ + head_ - tail_len, data_ + head_, head_len);
+            relocate_n(data_ + capacity_ - tail_len, data_, tail_len);
+            head_ -= tail_len;
+        } else if (head_len > tail_len) {
+            // Close the gap below the head segment, then rotate the run
+            relocate_n(data_ + free, data_, tail_len);
+            std::rotate(data_ + free, data_ + free + tail_len, data_ + capacity_);
+            head_ = free;
+        } else {
+            // Close the gap above the tail, then rotate the run
+            relocate_n(data_ + tail_len, data_ + head_, head_len);
+            std::rotate(data_, data_ + tail_len, data_ + len_);
+            head_ = 0;
+        }
+        return SliceMut<T>(data_ + head_, len_);
+    }
+
+    // Lazy iterators (see iter.hpp), front to back
+    typedef Chain<SliceIter<T>, SliceIter<T>> Iter;
+    typedef Chain<SliceIterMut<T>, SliceIterMut<T>> IterMut;
+
+    // @lifetime: (&'a) -> &'a
+    Iter iter() const {
+        std::pair<Slice<T>, Slice<T>> parts = as_slices();
+        return Iter(parts.first.iter(), parts.second.iter());
+    }
+
+    // @lifetime: (&'a mut) -> &'a mut
+    IterMut iter_mut() {
+        std::pair<SliceMut<T>, SliceMut<T>> parts = as_mut_slices();
+        return IterMut(parts.first.iter_mut(), parts.second.iter_mut());
+    }
+
+    // Consume the deque, yielding its elements front to back by value
+    // @lifetime: owned
+    VecDequeIntoIter<T, Alloc> into_iter() && { return VecDequeIntoIter<T, Alloc>(std::move(*this)); }
+
+    // Range-for support
+    // @lifetime: (&'a) -> &'a
+    iterator begin() { return iterator(this, 0); }
+    // @lifetime: (&'a) -> &'a
+    iterator end() { return iterator(this, len_); }
+    // @lifetime: (&'a) -> &'a
+    const_iterator begin() const { return const_iterator(this, 0); }
+    // @lifetime: (&'a) -> &'a
+    const_iterator end() const { return const_iterator(this, len_); }
+
+    // Clone the deque (explicit deep copy); the copy is contiguous
+    // @lifetime: owned
+    VecDeque clone() const {
+        VecDeque result = VecDeque::with_capacity_in(len_, this->alloc());
+        for (size_t i = 0; i < len_; ++i) {
+            new (result.at(i)) T(*at(i));  // Requires T to be copyable
+            ++result.len_;
+        }
+        return result;
+    }
+
+    bool operator==(const VecDeque& other) const {
+        if (len_ != other.len_) return false;
+        for (size_t i = 0; i < len_; ++i) {
+            if (!(*at(i) == *other.at(i))) return false;
+        }
+        return true;
+    }
+
+    bool operator!=(const VecDeque& other) const {
+        return !(*this == other);
+    }
+};
+
+template<typename T, typename Alloc>
+constexpr size_t VecDeque<T, Alloc>::MIN_NON_ZERO_CAP;
+
+// Like Vec, a VecDeque only points at its buffer
+template<typename T, typename Alloc>
+struct is_trivially_relocatable<VecDeque<T, Alloc>> : is_trivially_relocatable<Alloc> {};
+
+// Iterator returned by VecDeque::into_iter(): pops from the front in turn;
+// elements not reached are dropped with the iterator
+template<typename T, typename Alloc>
+class VecDequeIntoIter : public Iterator<VecDequeIntoIter<T, Alloc>, T> {
+private:
+    VecDeque<T, Alloc> deque_;
+
+public:
+    explicit VecDequeIntoIter(VecDeque<T, Alloc> deque) : deque_(std::move(deque)) {}
+
+    template<typename F>
+    bool next_with(F&& f) {
+        if (deque_.is_empty()) return false;
+        f(deque_.pop_front().unwrap());
+        return true;
+    }
+
+    size_t len() const { return deque_.len(); }
+    size_t size_hint() const { return len(); }
+};
+
+} // namespace rusty
+
+#endif // RUSTY_VECDEQUE_HPP
@@ -36,16 +36,6 @@ case "$PLATFORM" in
         if ! brew list llvm &> /dev/null; then
             echo "Warning: LLVM not found. Install with: brew install llvm"
         fi
-        if ! brew list z3 &> /dev/null; then
-            echo "Warning: Z3 not found. Install with: brew install z3"
-        fi
-        
-        # Set environment variables for macOS
-        export Z3_SYS_Z3_HEADER="/opt/homebrew/include/z3.h"
-        if [ ! -f "$Z3_SYS_Z3_HEADER" ]; then
-            # Try alternative location
-            export Z3_SYS_Z3_HEADER="/usr/local/include/z3.h"
-        fi
         ;;
     Linux*)
         echo "Detected Linux"
@@ -55,14 +45,6 @@ case "$PLATFORM" in
             echo "  Ubuntu/Debian: sudo apt-get install libclang-dev"
             echo "  Fedora: sudo dnf install clang-devel"
         fi
-        if ! ldconfig -p | grep -q libz3; then
-            echo "Warning: Z3 not found. Install with:"
-            echo "  Ubuntu/Debian: sudo apt-get install libz3-dev"
-            echo "  Fedora: sudo dnf install z3-devel"
-        fi
-        
-        # Set environment variables for Linux
-        export Z3_SYS_Z3_HEADER="/usr/include/z3.h"
         ;;
     *)
         echo "Warning: Unknown platform $PLATFORM"
@@ -7,6 +7,7 @@
 #include <csignal>
 #include <execinfo.h>
 #include <iostream>
+#include "include/rusty/marker.hpp"
 namespace rust {
 
 // Macros for custom error handling
@@ -45,11 +46,71 @@ namespace rust {
 
 
 
-template<class T>
+// Borrow-count policies
+//
+// AtomicChecked     counts borrows with std::atomic (the historic default)
+// NonAtomicChecked  same checks on a plain int32_t, for single-threaded cells
+// Unchecked         no counter and no checks; every borrow compiles down to
+//                   a pointer copy. Only for code rusty-cpp-checker verified.
+//
+// Each policy provides a Count type and the handful of operations below;
+// fetch_add returns the previous value, like std::atomic.
+struct AtomicChecked {
+  static constexpr bool checked = true;
+  typedef std::atomic<int32_t> Count;
+  static int32_t fetch_add(Count& c, int32_t d) { return c.fetch_add(d); }
+  static int32_t load(const Count& c) { return c.load(); }
+  static void store(Count& c, int32_t v) { c.store(v); }
+  static int32_t exchange(Count& c, int32_t v) { return c.exchange(v); }
+};
+
+struct NonAtomicChecked {
+  static constexpr bool checked = true;
+  typedef int32_t Count;
+  static int32_t fetch_add(Count& c, int32_t d) { int32_t old = c; c += d; return old; }
+  static int32_t load(const Count& c) { return c; }
+  static void store(Count& c, int32_t v) { c = v; }
+  static int32_t exchange(Count& c, int32_t v) { int32_t old = c; c = v; return old; }
+};
+
+struct Unchecked {
+  static constexpr bool checked = false;
+  struct Count {
+    Count(int32_t = 0) {}
+  };
+  static int32_t fetch_add(Count&, int32_t) { return 0; }
+  static int32_t load(const Count&) { return 0; }
+  static void store(Count&, int32_t) {}
+  static int32_t exchange(Count&, int32_t) { return 0; }
+};
+
+// Policy used when RefCell<T> is named without one: unchecked in release
+// builds of translation units the checker has verified (mark_safe() in
+// cmake defines BORROW_CHECKER_SAFE), atomic checked everywhere else.
+// Define RUST_REFCELL_DEFAULT_POLICY to override; keep it consistent
+// across translation units that share RefCell<T> objects.
+#ifndef RUST_REFCELL_DEFAULT_POLICY
+#if defined(BORROW_CHECKER_SAFE) && defined(NDEBUG)
+#define RUST_REFCELL_DEFAULT_POLICY ::rust::Unchecked
+#else
+#define RUST_REFCELL_DEFAULT_POLICY ::rust::AtomicChecked
+#endif
+#endif
+
+// Check cond only under a checking policy; Unchecked folds it away
+#define borrow_verify_policy(Policy, x, errmsg) \
+    do { \
+        if (Policy::checked) { \
+            borrow_verify(x, errmsg); \
+        } \
+    } while(0)
+
+template<class T, class Policy = RUST_REFCELL_DEFAULT_POLICY>
 class Ref {
  public:
+  typedef typename Policy::Count Count;
   const T* raw_{nullptr};
-  std::atomic<int32_t>* p_cnt_{nullptr};
+  Count* p_cnt_{nullptr};
   Ref() = default;
   Ref(const Ref&) = delete;
   Ref(Ref&& p) {
@@ -61,31 +122,32 @@ class Ref {
   Ref(Ref& p) {
     raw_ = p.raw_;
     p_cnt_ = p.p_cnt_;
-    auto i = (*p_cnt_)++;
-    borrow_verify(i > 0, "error in Ref constructor");
+    auto i = Policy::fetch_add(*p_cnt_, 1);
+    borrow_verify_policy(Policy, i > 0, "error in Ref constructor");
   }
   const T* operator->() {
     return raw_;
   }
   void reset() {
-    auto i = (*p_cnt_)--;
-    borrow_verify(i > 0, "Trying to reset null pointer");
+    auto i = Policy::fetch_add(*p_cnt_, -1);
+    borrow_verify_policy(Policy, i > 0, "Trying to reset null pointer");
     raw_ = nullptr;
     p_cnt_ = nullptr;
   }
   ~Ref() {
     if (p_cnt_ != nullptr) {
-      auto i = (*p_cnt_)--;
-      borrow_verify(i > 0, "Trying to dereference null pointer"); // failure means - count became negative which is not possible
+      auto i = Policy::fetch_add(*p_cnt_, -1);
+      borrow_verify_policy(Policy, i > 0, "Trying to dereference null pointer"); // failure means - count became negative which is not possible
     }
   }
 };
 
-template <typename T>
+template <typename T, class Policy = RUST_REFCELL_DEFAULT_POLICY>
 class RefMut {
  public:
-  T* raw_;
-  std::atomic<int32_t>* p_cnt_;
+  typedef typename Policy::Count Count;
+  T* raw_{nullptr};
+  Count* p_cnt_{nullptr};
   RefMut() = default;
   RefMut(const RefMut&) = delete;
   RefMut(RefMut&& p) : raw_(p.raw_), p_cnt_(p.p_cnt_) {
@@ -97,72 +159,71 @@ class RefMut {
     return raw_;
   }
   void reset() {
-    auto i = (*p_cnt_)++;
-    borrow_verify(i == -1, "error in RefMut reset");
+    auto i = Policy::fetch_add(*p_cnt_, 1);
+    borrow_verify_policy(Policy, i == -1, "error in RefMut reset");
     p_cnt_ = nullptr;
     raw_ = nullptr;
   }
   ~RefMut() {
     if (p_cnt_) {
-      auto i = (*p_cnt_)++;
-      borrow_verify(i == -1, "error in checking just single reference of RefMut");
+      auto i = Policy::fetch_add(*p_cnt_, 1);
+      borrow_verify_policy(Policy, i == -1, "error in checking just single reference of RefMut");
     }
   }
 };
 
-template <class T>
+template <class T, class Policy = RUST_REFCELL_DEFAULT_POLICY>
 class RefCell {
  public:
+  typedef typename Policy::Count Count;
   RefCell(const RefCell&) = delete;
   RefCell(): raw_(nullptr), cnt_(0) {
   }
   explicit RefCell(T* p) : raw_(p), cnt_(0) {
   };
-  RefCell(RefCell&& p) {
-    auto i = p.cnt_.exchange(-2);
-    borrow_verify(i==0, "verify failed in RefCell move constructor");
-    borrow_verify(cnt_ == 0, "verify failed in RefCell move constructor");
-    cnt_ = i;
+  RefCell(RefCell&& p) : cnt_(0) {
+    auto i = Policy::exchange(p.cnt_, -2);
+    borrow_verify_policy(Policy, i==0, "verify failed in RefCell move constructor");
+    Policy::store(cnt_, i);
     raw_ = p.raw_;
     p.raw_ = nullptr;
-    p.cnt_ = 0;
+    Policy::store(p.cnt_, 0);
   };
 
   inline void reset(T* p) {
-    borrow_verify(cnt_ == 0, "error in RefCell reset");
+    borrow_verify_policy(Policy, Policy::load(cnt_) == 0, "error in RefCell reset");
     raw_ = p;
-    borrow_verify(cnt_ == 0, "error in RefCell reset"); // is this enough to capture data race?
+    borrow_verify_policy(Policy, Policy::load(cnt_) == 0, "error in RefCell reset"); // is this enough to capture data race?
   }
   T* raw_{nullptr};
-  std::atomic<int32_t> cnt_{0};
+  Count cnt_{0};
 
-  inline RefMut<T> borrow_mut() {
-    RefMut<T> mut;
-    borrow_verify(cnt_ == 0, "verify failed in borrow_mut");
-    cnt_--;
+  inline RefMut<T, Policy> borrow_mut() {
+    RefMut<T, Policy> mut;
+    borrow_verify_policy(Policy, Policy::load(cnt_) == 0, "verify failed in borrow_mut");
+    Policy::fetch_add(cnt_, -1);
     mut.p_cnt_ = &cnt_;
     mut.raw_ = raw_;
-    raw_ = nullptr;
     return mut;
   }
 
-  inline Ref<T> borrow_const() {
+  inline Ref<T, Policy> borrow_const() {
     // *raw_; // for refer static analysis
-    auto i = cnt_++;
-    borrow_verify(i >= 0, "verify failed in borrow_const");
-    Ref<T> ref;
+    auto i = Policy::fetch_add(cnt_, 1);
+    borrow_verify_policy(Policy, i >= 0, "verify failed in borrow_const");
+    Ref<T, Policy> ref;
     ref.raw_ = raw_;
     ref.p_cnt_ = &cnt_;
     return ref;
   }
 
   T* operator->() {
-    borrow_verify(cnt_==0, "verify failed in ->");
+    borrow_verify_policy(Policy, Policy::load(cnt_)==0, "verify failed in ->");
     return raw_;
   }
 
   void reset() {
-    borrow_verify(cnt_ == 0, "verify failed in RefCell reset");
+    borrow_verify_policy(Policy, Policy::load(cnt_) == 0, "verify failed in RefCell reset");
     delete raw_;
     raw_ = nullptr;
   }
@@ -174,33 +235,65 @@ class RefCell {
   }
 };
 
+// Cells with an explicit policy, independent of RUST_REFCELL_DEFAULT_POLICY
 template <typename T>
-inline RefMut<T> borrow_mut(RefCell<T>& RefCell) {
-  return std::forward<RefMut<T>>(RefCell.borrow_mut());
-}
+using SyncRefCell = RefCell<T, AtomicChecked>;
 
 template <typename T>
-inline Ref<T> borrow_const(RefCell<T>& RefCell) {
-  return std::forward<Ref<T>>(RefCell.borrow_const());
-}
+using LocalRefCell = RefCell<T, NonAtomicChecked>;
 
 template <typename T>
-inline void reset_ptr(RefCell<T>& ptr) {
+using UncheckedRefCell = RefCell<T, Unchecked>;
+
+template <typename T, class Policy>
+inline RefMut<T, Policy> borrow_mut(RefCell<T, Policy>& RefCell) {
+  return std::forward<RefMut<T, Policy>>(RefCell.borrow_mut());
+}
+
+template <typename T, class Policy>
+inline Ref<T, Policy> borrow_const(RefCell<T, Policy>& RefCell) {
+  return std::forward<Ref<T, Policy>>(RefCell.borrow_const());
+}
+
+template <typename T, class Policy>
+inline void reset_ptr(RefCell<T, Policy>& ptr) {
   return ptr.reset();
 }
 
-template <typename T>
-inline void reset_ptr(RefMut<T>& ptr) {
+template <typename T, class Policy>
+inline void reset_ptr(RefMut<T, Policy>& ptr) {
   return ptr.reset();
 }
 
-template <typename T>
-inline void reset_ptr(Ref<T>& ptr) {
+template <typename T, class Policy>
+inline void reset_ptr(Ref<T, Policy>& ptr) {
   return ptr.reset();
 }
 
 } // namespace borrow;
 
+// The borrow count is a check, not a lock: a RefCell may move to another
+// thread along with its value, but never be shared between threads. Ref and
+// RefMut point back at the count, so they stay on the thread that borrowed.
+namespace rusty {
+
+template <typename T, class Policy>
+struct is_sync<rust::RefCell<T, Policy>> : std::false_type {};
+
+template <typename T, class Policy>
+struct is_send<rust::Ref<T, Policy>> : std::false_type {};
+
+template <typename T, class Policy>
+struct is_sync<rust::Ref<T, Policy>> : std::false_type {};
+
+template <typename T, class Policy>
+struct is_send<rust::RefMut<T, Policy>> : std::false_type {};
+
+template <typename T, class Policy>
+struct is_sync<rust::RefMut<T, Policy>> : std::false_type {};
+
+} // namespace rusty
+
 // infer run --pulse-only -- clang++ -x c++ -std=c++11 -O0 borrow.h -D BORROW_TEST=1 -D BORROW_INFER_CHECK=1
 #ifdef BORROW_TEST
 using namespace borrow;
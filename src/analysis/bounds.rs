@@ -0,0 +1,73 @@
+use crate::parser::Function;
+
+/// Check the get_unchecked / get_unchecked_mut calls of a safe function.
+/// They skip the bounds check in every build, so safe code may only make
+/// the ones the parser proved in range (see parser::bounds): an index
+/// bounded by the container's len() in the enclosing for loop.
+pub fn check_parsed_function_for_unchecked_access(function: &Function) -> Vec<String> {
+    function
+        .unchecked_accesses
+        .iter()
+        .filter(|access| !access.proven)
+        .map(|access| {
+            format!(
+                "In function '{}': Unchecked access {}.{}({}) at line {}: index is not provably in range; use operator[] or get(), or mark the function @unsafe",
+                function.name, access.container, access.method, access.index, access.location.line
+            )
+        })
+        .collect()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::parser::bounds::UncheckedAccess;
+    use crate::parser::SourceLocation;
+
+    fn access(container: &str, index: &str, proven: bool, line: u32) -> UncheckedAccess {
+        UncheckedAccess {
+            method: "get_unchecked".to_string(),
+            container: container.to_string(),
+            index: index.to_string(),
+            proven,
+            location: SourceLocation {
+                file: "test.cpp".to_string(),
+                line,
+                column: 5,
+            },
+        }
+    }
+
+    fn function(accesses: Vec<UncheckedAccess>) -> Function {
+        Function {
+            name: "sum".to_string(),
+            parameters: vec![],
+            return_type: "int".to_string(),
+            body: vec![],
+            location: SourceLocation {
+                file: "test.cpp".to_string(),
+                line: 1,
+                column: 1,
+            },
+            unchecked_accesses: accesses,
+        }
+    }
+
+    #[test]
+    fn test_proven_access_allowed() {
+        let errors = check_parsed_function_for_unchecked_access(&function(vec![access("v", "i", true, 4)]));
+        assert!(errors.is_empty(), "A proven index needs no unsafe context: {:?}", errors);
+    }
+
+    #[test]
+    fn test_unproven_access_rejected() {
+        let errors = check_parsed_function_for_unchecked_access(&function(vec![
+            access("v", "i", true, 4),
+            access("w", "i", false, 5),
+            access("v", "...", false, 9),
+        ]));
+        assert_eq!(errors.len(), 2);
+        assert!(errors[0].contains("w.get_unchecked(i) at line 5"));
+        assert!(errors[1].contains("line 9") && errors[1].contains("@unsafe"));
+    }
+}
@@ -0,0 +1,359 @@
+use std::collections::{HashSet, VecDeque};
+
+use crate::ir::cfg::{BlockId, Cfg, ENTRY};
+use crate::ir::{IrExpression, IrStatement};
+use super::id_map::{Interner, VarId};
+
+/// A set of variable ids, one bit each
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct BitSet {
+    words: Vec<u64>,
+}
+
+impl BitSet {
+    pub fn empty(len: usize) -> Self {
+        BitSet { words: vec![0; (len + 63) / 64] }
+    }
+
+    pub fn full(len: usize) -> Self {
+        let mut set = Self::empty(len);
+        for i in 0..len {
+            set.insert(i);
+        }
+        set
+    }
+
+    pub fn insert(&mut self, i: usize) {
+        self.words[i / 64] |= 1 << (i % 64);
+    }
+
+    pub fn remove(&mut self, i: usize) {
+        self.words[i / 64] &= !(1 << (i % 64));
+    }
+
+    pub fn contains(&self, i: usize) -> bool {
+        self.words[i / 64] & (1 << (i % 64)) != 0
+    }
+
+    pub fn union_with(&mut self, other: &BitSet) {
+        for (a, b) in self.words.iter_mut().zip(&other.words) {
+            *a |= b;
+        }
+    }
+
+    pub fn intersect_with(&mut self, other: &BitSet) {
+        for (a, b) in self.words.iter_mut().zip(&other.words) {
+            *a &= b;
+        }
+    }
+
+    pub fn subtract(&mut self, other: &BitSet) {
+        for (a, b) in self.words.iter_mut().zip(&other.words) {
+            *a &= !b;
+        }
+    }
+}
+
+/// How the states flowing into a block are combined
+#[derive(Debug, Clone, Copy, PartialEq)]
+#[allow(dead_code)]
+pub enum Join {
+    /// A fact holds if it holds on some path ("may")
+    Union,
+    /// A fact holds if it holds on every path ("must")
+    Intersection,
+}
+
+/// A block's effect on the state: out = (in - kill) ∪ gen
+#[derive(Debug, Clone)]
+pub struct Transfer {
+    pub gen: BitSet,
+    pub kill: BitSet,
+}
+
+impl Transfer {
+    pub fn identity(len: usize) -> Self {
+        Transfer { gen: BitSet::empty(len), kill: BitSet::empty(len) }
+    }
+
+    pub fn apply(&self, state: &mut BitSet) {
+        state.subtract(&self.kill);
+        state.union_with(&self.gen);
+    }
+
+    /// Follow this transfer with a statement that generates `gen`, then
+    /// kills `kill`
+    pub fn then(&mut self, gen: Option<usize>, kill: Option<usize>) {
+        if let Some(g) = gen {
+            self.kill.remove(g);
+            self.gen.insert(g);
+        }
+        if let Some(k) = kill {
+            self.gen.remove(k);
+            self.kill.insert(k);
+        }
+    }
+}
+
+/// Solve a forward problem over the blocks of `within` reachable from
+/// `start`, whose in-state is fixed to `start_state`. Edges from blocks
+/// outside `within` are ignored. Returns each block's in-state, or None
+/// for blocks that were not reached.
+///
+/// Blocks are visited in reverse postorder from a worklist and revisited
+/// only when an input changes, so acyclic code converges in one pass and
+/// each loop adds a pass per nesting level.
+pub fn solve_forward(
+    cfg: &Cfg,
+    within: &[bool],
+    start: BlockId,
+    start_state: BitSet,
+    transfers: &[Transfer],
+    join: Join,
+    len: usize,
+) -> Vec<Option<BitSet>> {
+    let order = cfg.reverse_postorder(start, within);
+    let mut reached = vec![false; cfg.blocks.len()];
+    for &block in &order {
+        reached[block] = true;
+    }
+
+    let mut ins: Vec<Option<BitSet>> = vec![None; cfg.blocks.len()];
+    // Out-states start at the identity of the join, so unvisited
+    // predecessors do not constrain their successors
+    let top = match join {
+        Join::Union => BitSet::empty(len),
+        Join::Intersection => BitSet::full(len),
+    };
+    let mut outs: Vec<BitSet> = vec![top.clone(); cfg.blocks.len()];
+
+    let mut queued = vec![false; cfg.blocks.len()];
+    let mut worklist: VecDeque<BlockId> = order.iter().copied().collect();
+    for &block in &order {
+        queued[block] = true;
+    }
+    while let Some(block) = worklist.pop_front() {
+        queued[block] = false;
+        let state = if block == start {
+            start_state.clone()
+        } else {
+            let mut state = top.clone();
+            for &pred in &cfg.blocks[block].predecessors {
+                if !reached[pred] {
+                    continue;
+                }
+                match join {
+                    Join::Union => state.union_with(&outs[pred]),
+                    Join::Intersection => state.intersect_with(&outs[pred]),
+                }
+            }
+            state
+        };
+        let mut out = state.clone();
+        transfers[block].apply(&mut out);
+        ins[block] = Some(state);
+        if out != outs[block] {
+            outs[block] = out;
+            for &succ in &cfg.blocks[block].successors {
+                if reached[succ] && succ != start && !queued[succ] {
+                    queued[succ] = true;
+                    worklist.push_back(succ);
+                }
+            }
+        }
+    }
+    ins
+}
+
+/// The variable a statement moves out of, and the one it (re)initializes
+fn move_effect(statement: &IrStatement) -> (Option<&str>, Option<&str>) {
+    match statement {
+        IrStatement::Move { from, to } => {
+            // Temporary move markers only consume the source
+            if to.starts_with("_temp_move_") || to.starts_with("_moved_") || to == from {
+                (Some(from), None)
+            } else {
+                (Some(from), Some(to))
+            }
+        }
+        _ => (None, None),
+    }
+}
+
+/// The variables a statement reads, which must not have been moved
+fn uses(statement: &IrStatement) -> Option<&str> {
+    match statement {
+        IrStatement::Move { from, .. } => Some(from),
+        IrStatement::Borrow { from, .. } => Some(from),
+        IrStatement::Assign { rhs: IrExpression::Variable(var), .. } => Some(var),
+        _ => None,
+    }
+}
+
+/// Find uses of variables that a previous iteration of an enclosing loop
+/// has moved. A variable is moved on entry to the next iteration if every
+/// path through the body moves it; the set is found by a must-moved
+/// dataflow over the function's CFG, then carried from each loop's back
+/// edge through its body. Checks are skipped in unsafe blocks.
+pub fn check_loop_carried_moves(statements: &[IrStatement]) -> Vec<String> {
+    let cfg = Cfg::build(statements);
+    if cfg.loops.is_empty() {
+        return Vec::new();
+    }
+
+    let mut names = Interner::new();
+    let mut transfers = Vec::with_capacity(cfg.blocks.len());
+    let mut effects: Vec<Vec<(Option<VarId>, Option<VarId>, Option<VarId>)>> = Vec::new();
+    for block in &cfg.blocks {
+        let effect: Vec<_> = block.statements.iter().map(|s| {
+            let (moved, initialized) = move_effect(s);
+            (moved.map(|v| names.intern(v)), initialized.map(|v| names.intern(v)), uses(s).map(|v| names.intern(v)))
+        }).collect();
+        effects.push(effect);
+    }
+    let len = names.len();
+    let index = |id: VarId| id.index();
+    for effect in &effects {
+        let mut transfer = Transfer::identity(len);
+        for (moved, initialized, _) in effect {
+            transfer.then(moved.map(index), initialized.map(index));
+        }
+        transfers.push(transfer);
+    }
+
+    let everywhere = vec![true; cfg.blocks.len()];
+    let moved_on_entry = solve_forward(&cfg, &everywhere, ENTRY, BitSet::empty(len), &transfers, Join::Intersection, len);
+
+    let mut errors = Vec::new();
+    let mut reported = HashSet::new();
+    for lp in &cfg.loops {
+        let latch_in = match &moved_on_entry[lp.latch] {
+            Some(state) => state,
+            None => continue, // The body never reaches its end
+        };
+        let mut carried = latch_in.clone();
+        transfers[lp.latch].apply(&mut carried);
+
+        let mut body = vec![false; cfg.blocks.len()];
+        for &block in &lp.body {
+            body[block] = true;
+        }
+        let carried_in = solve_forward(&cfg, &body, lp.header, carried, &transfers, Join::Intersection, len);
+
+        for (block, state) in carried_in.iter().enumerate() {
+            let mut state = match state {
+                Some(state) => state.clone(),
+                None => continue,
+            };
+            let mut unsafe_depth = cfg.blocks[block].unsafe_depth;
+            for (statement, (moved, initialized, used)) in cfg.blocks[block].statements.iter().zip(&effects[block]) {
+                match statement {
+                    IrStatement::EnterUnsafe => unsafe_depth += 1,
+                    IrStatement::ExitUnsafe => unsafe_depth = unsafe_depth.saturating_sub(1),
+                    _ => {}
+                }
+                if let Some(var) = used {
+                    if unsafe_depth == 0 && state.contains(index(*var)) && reported.insert(*var) {
+                        errors.push(format!(
+                            "Use after move in loop: variable '{}' was moved in first iteration and used again in second iteration",
+                            names.name(*var)
+                        ));
+                    }
+                }
+                if let Some(var) = moved {
+                    state.insert(index(*var));
+                }
+                if let Some(var) = initialized {
+                    state.remove(index(*var));
+                }
+            }
+        }
+    }
+    errors
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::ir::BorrowKind;
+
+    fn mv(from: &str, to: &str) -> IrStatement {
+        IrStatement::Move { from: from.to_string(), to: to.to_string() }
+    }
+
+    fn lp(body: Vec<IrStatement>) -> Vec<IrStatement> {
+        let mut statements = vec![IrStatement::EnterLoop];
+        statements.extend(body);
+        statements.push(IrStatement::ExitLoop);
+        statements
+    }
+
+    #[test]
+    fn test_bitset() {
+        let mut a = BitSet::empty(130);
+        a.insert(3);
+        a.insert(129);
+        let mut b = BitSet::full(130);
+        b.remove(3);
+        assert!(b.contains(129) && !b.contains(3));
+        b.intersect_with(&a);
+        assert_eq!(b, { let mut c = BitSet::empty(130); c.insert(129); c });
+        a.subtract(&b);
+        assert!(a.contains(3) && !a.contains(129));
+    }
+
+    #[test]
+    fn test_move_in_loop_is_reported_once() {
+        let errors = check_loop_carried_moves(&lp(vec![mv("x", "y"), mv("x", "z")]));
+        assert_eq!(errors.len(), 1);
+        assert!(errors[0].contains("'x'") && errors[0].contains("in loop"));
+    }
+
+    #[test]
+    fn test_reinitialized_before_next_iteration() {
+        // x is moved, then given w's value before the iteration ends; w is
+        // moved in every iteration
+        let errors = check_loop_carried_moves(&lp(vec![mv("x", "y"), mv("w", "x")]));
+        assert_eq!(errors.len(), 1);
+        assert!(errors[0].contains("'w'"));
+    }
+
+    #[test]
+    fn test_move_on_one_branch_is_not_carried() {
+        let body = vec![IrStatement::If { then_branch: vec![mv("x", "y")], else_branch: None }];
+        assert!(check_loop_carried_moves(&lp(body)).is_empty());
+    }
+
+    #[test]
+    fn test_borrow_after_move_in_nested_loop() {
+        let inner = lp(vec![
+            IrStatement::Borrow { from: "x".to_string(), to: "r".to_string(), kind: BorrowKind::Immutable },
+            mv("x", "_moved_x"),
+        ]);
+        let errors = check_loop_carried_moves(&lp(inner));
+        assert_eq!(errors.len(), 1);
+    }
+
+    #[test]
+    fn test_inner_loop_may_run_zero_times() {
+        // The inner loop moves x at most once and may not run at all, so
+        // the borrow at the top of the outer loop is not certainly a use of
+        // a moved value
+        let inner = lp(vec![mv("x", "y"), IrStatement::Return { value: None }]);
+        let mut outer = vec![IrStatement::Borrow { from: "x".to_string(), to: "r".to_string(), kind: BorrowKind::Immutable }];
+        outer.extend(inner);
+        assert!(check_loop_carried_moves(&lp(outer)).is_empty());
+    }
+
+    #[test]
+    fn test_return_ends_the_path() {
+        let body = vec![mv("x", "y"), IrStatement::Return { value: None }];
+        assert!(check_loop_carried_moves(&lp(body)).is_empty());
+    }
+
+    #[test]
+    fn test_unsafe_blocks_are_skipped() {
+        let body = vec![IrStatement::EnterUnsafe, mv("x", "y"), IrStatement::ExitUnsafe];
+        assert!(check_loop_carried_moves(&lp(body)).is_empty());
+    }
+}
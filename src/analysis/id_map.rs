@@ -0,0 +1,209 @@
+use std::collections::HashMap;
+use std::rc::Rc;
+
+/// A variable name interned by `Interner`
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash, PartialOrd, Ord)]
+pub struct VarId(u32);
+
+impl VarId {
+    /// The id as a dense index, from 0 to the interner's len
+    pub fn index(self) -> usize {
+        self.0 as usize
+    }
+}
+
+/// Gives each distinct variable name a small dense id, so the analysis
+/// state is keyed by integers instead of cloned strings
+#[derive(Debug, Default)]
+pub struct Interner {
+    ids: HashMap<String, VarId>,
+    names: Vec<String>,
+}
+
+impl Interner {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// The id of `name`, assigning one the first time it is seen
+    pub fn intern(&mut self, name: &str) -> VarId {
+        if let Some(id) = self.ids.get(name) {
+            return *id;
+        }
+        let id = VarId(self.names.len() as u32);
+        self.names.push(name.to_string());
+        self.ids.insert(name.to_string(), id);
+        id
+    }
+
+    /// The id of `name`, if it has been interned
+    pub fn get(&self, name: &str) -> Option<VarId> {
+        self.ids.get(name).copied()
+    }
+
+    pub fn name(&self, id: VarId) -> &str {
+        &self.names[id.0 as usize]
+    }
+
+    /// The number of names interned
+    pub fn len(&self) -> usize {
+        self.names.len()
+    }
+}
+
+const CHUNK: usize = 32;
+
+/// A map from VarId to `T` that shares its storage with its clones. Ids are
+/// dense, so entries live in fixed-size chunks behind reference counts:
+/// cloning the map is O(1), and the first write to a chunk after a clone
+/// copies only that chunk and the table of chunk pointers.
+#[derive(Debug)]
+pub struct IdMap<T: Clone> {
+    chunks: Rc<Vec<Rc<Vec<Option<T>>>>>,
+}
+
+impl<T: Clone> Clone for IdMap<T> {
+    fn clone(&self) -> Self {
+        IdMap { chunks: Rc::clone(&self.chunks) }
+    }
+}
+
+impl<T: Clone> Default for IdMap<T> {
+    fn default() -> Self {
+        IdMap { chunks: Rc::new(Vec::new()) }
+    }
+}
+
+impl<T: Clone> IdMap<T> {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    pub fn get(&self, id: VarId) -> Option<&T> {
+        let (chunk, slot) = Self::position(id);
+        self.chunks.get(chunk).and_then(|c| c[slot].as_ref())
+    }
+
+    pub fn contains_key(&self, id: VarId) -> bool {
+        self.get(id).is_some()
+    }
+
+    pub fn get_mut(&mut self, id: VarId) -> Option<&mut T> {
+        if !self.contains_key(id) {
+            return None;
+        }
+        self.slot_mut(id).as_mut()
+    }
+
+    pub fn insert(&mut self, id: VarId, value: T) {
+        *self.slot_mut(id) = Some(value);
+    }
+
+    /// The entry of `id`, inserting `T::default()` if there is none
+    pub fn entry_or_default(&mut self, id: VarId) -> &mut T
+    where
+        T: Default,
+    {
+        self.slot_mut(id).get_or_insert_with(T::default)
+    }
+
+    pub fn remove(&mut self, id: VarId) -> Option<T> {
+        if !self.contains_key(id) {
+            return None;
+        }
+        self.slot_mut(id).take()
+    }
+
+    pub fn clear(&mut self) {
+        self.chunks = Rc::new(Vec::new());
+    }
+
+    pub fn iter(&self) -> impl Iterator<Item = (VarId, &T)> {
+        self.chunks.iter().enumerate().flat_map(|(c, chunk)| {
+            chunk
+                .iter()
+                .enumerate()
+                .filter_map(move |(s, value)| value.as_ref().map(|v| (VarId((c * CHUNK + s) as u32), v)))
+        })
+    }
+
+    /// Keep only the entries `f` accepts; chunks with nothing to drop stay
+    /// shared
+    pub fn retain(&mut self, mut f: impl FnMut(VarId, &T) -> bool) {
+        let dropped: Vec<VarId> = self.iter().filter(|(id, v)| !f(*id, v)).map(|(id, _)| id).collect();
+        for id in dropped {
+            self.remove(id);
+        }
+    }
+
+    fn position(id: VarId) -> (usize, usize) {
+        (id.0 as usize / CHUNK, id.0 as usize % CHUNK)
+    }
+
+    fn slot_mut(&mut self, id: VarId) -> &mut Option<T> {
+        let (chunk, slot) = Self::position(id);
+        let chunks = Rc::make_mut(&mut self.chunks);
+        while chunks.len() <= chunk {
+            chunks.push(Rc::new(vec![None; CHUNK]));
+        }
+        &mut Rc::make_mut(&mut chunks[chunk])[slot]
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_interner() {
+        let mut names = Interner::new();
+        let x = names.intern("x");
+        let y = names.intern("y");
+        assert_ne!(x, y);
+        assert_eq!(names.intern("x"), x);
+        assert_eq!(names.get("y"), Some(y));
+        assert_eq!(names.get("z"), None);
+        assert_eq!(names.name(y), "y");
+    }
+
+    #[test]
+    fn test_clones_are_independent() {
+        let mut names = Interner::new();
+        let ids: Vec<VarId> = (0..100).map(|i| names.intern(&format!("v{}", i))).collect();
+        let mut map = IdMap::new();
+        for (i, id) in ids.iter().enumerate() {
+            map.insert(*id, i);
+        }
+
+        let saved = map.clone();
+        map.insert(ids[3], 1000);
+        map.remove(ids[70]);
+        *map.entry_or_default(ids[99]) += 1;
+        assert_eq!(saved.get(ids[3]), Some(&3));
+        assert_eq!(saved.get(ids[70]), Some(&70));
+        assert_eq!(saved.get(ids[99]), Some(&99));
+        assert_eq!(map.get(ids[3]), Some(&1000));
+        assert_eq!(map.get(ids[70]), None);
+        assert_eq!(map.get(ids[99]), Some(&100));
+        // Chunks that were not written stay shared
+        assert!(Rc::ptr_eq(&saved.chunks[1], &map.chunks[1]));
+        assert!(!Rc::ptr_eq(&saved.chunks[0], &map.chunks[0]));
+    }
+
+    #[test]
+    fn test_iter_and_retain() {
+        let mut map = IdMap::new();
+        for i in [2u32, 40, 7] {
+            map.insert(VarId(i), i);
+        }
+        let entries: Vec<_> = map.iter().map(|(id, v)| (id, *v)).collect();
+        assert_eq!(entries, vec![(VarId(2), 2), (VarId(7), 7), (VarId(40), 40)]);
+
+        map.retain(|_, v| *v > 5);
+        assert!(!map.contains_key(VarId(2)));
+        assert_eq!(map.iter().count(), 2);
+        assert_eq!(map.get_mut(VarId(2)), None);
+        map.clear();
+        assert_eq!(map.iter().count(), 0);
+    }
+}
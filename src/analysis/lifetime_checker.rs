@@ -1,6 +1,7 @@
 use crate::parser::annotations::{LifetimeAnnotation, FunctionSignature, LifetimeBound};
 use crate::parser::HeaderCache;
 use crate::ir::{IrProgram, IrStatement, IrFunction};
+use crate::solver::ConstraintSolver;
 use std::collections::{HashMap, HashSet};
 
 /// Tracks lifetime information for variables in the current scope
@@ -9,7 +10,7 @@ pub struct LifetimeScope {
     /// Maps variable names to their lifetimes
     variable_lifetimes: HashMap<String, String>,
     /// Active lifetime constraints
-    constraints: Vec<LifetimeBound>,
+    constraints: ConstraintSolver,
     /// Variables that own their data (not references)
     owned_variables: HashSet<String>,
 }
@@ -18,7 +19,7 @@ impl LifetimeScope {
     pub fn new() -> Self {
         Self {
             variable_lifetimes: HashMap::new(),
-            constraints: Vec::new(),
+            constraints: ConstraintSolver::new(),
             owned_variables: HashSet::new(),
         }
     }
@@ -46,52 +47,13 @@ impl LifetimeScope {
     /// Add a lifetime constraint
     #[allow(dead_code)]
     pub fn add_constraint(&mut self, constraint: LifetimeBound) {
-        self.constraints.push(constraint);
+        self.constraints.add_outlives(&constraint.longer, &constraint.shorter);
     }
     
-    /// Check if lifetime 'a outlives lifetime 'b
+    /// Check if lifetime 'a outlives lifetime 'b, directly or through
+    /// other constraints
     pub fn check_outlives(&self, longer: &str, shorter: &str) -> bool {
-        // If they're the same lifetime, it trivially outlives itself
-        if longer == shorter {
-            return true;
-        }
-        
-        // Check explicit constraints
-        for constraint in &self.constraints {
-            if constraint.longer == longer && constraint.shorter == shorter {
-                return true;
-            }
-        }
-        
-        // Implement transitive outlives checking
-        // If 'a: 'b and 'b: 'c, then 'a: 'c
-        self.check_outlives_transitive(longer, shorter, &mut HashSet::new())
-    }
-    
-    /// Check outlives relationship with transitive closure
-    fn check_outlives_transitive(&self, longer: &str, shorter: &str, visited: &mut HashSet<String>) -> bool {
-        // Avoid infinite recursion
-        if visited.contains(longer) {
-            return false;
-        }
-        visited.insert(longer.to_string());
-        
-        // Find all lifetimes that 'longer' outlives directly
-        for constraint in &self.constraints {
-            if constraint.longer == longer {
-                // Check if we found the target
-                if constraint.shorter == shorter {
-                    return true;
-                }
-                
-                // Try transitively through this intermediate lifetime
-                if self.check_outlives_transitive(&constraint.shorter, shorter, visited) {
-                    return true;
-                }
-            }
-        }
-        
-        false
+        self.constraints.outlives(longer, shorter)
     }
 }
 
@@ -103,14 +65,22 @@ pub fn check_lifetimes_with_annotations(
     let mut errors = Vec::new();
     
     for function in &program.functions {
-        let mut scope = LifetimeScope::new();
-        let function_errors = check_function_lifetimes(function, &mut scope, header_cache)?;
+        let function_errors = check_function_with_annotations(function, header_cache)?;
         errors.extend(function_errors);
     }
     
     Ok(errors)
 }
 
+/// Check lifetime constraints in one function using header annotations
+pub fn check_function_with_annotations(
+    function: &IrFunction,
+    header_cache: &HeaderCache
+) -> Result<Vec<String>, String> {
+    let mut scope = LifetimeScope::new();
+    check_function_lifetimes(function, &mut scope, header_cache)
+}
+
 fn check_function_lifetimes(
     function: &IrFunction, 
     scope: &mut LifetimeScope,
@@ -148,6 +118,7 @@ fn check_function_lifetimes(
                             args,
                             result.as_ref(),
                             signature,
+                            &header_cache.solved_bounds(signature),
                             scope
                         );
                         errors.extend(call_errors);
@@ -186,6 +157,7 @@ fn check_function_call(
     args: &[String],
     result: Option<&String>,
     signature: &FunctionSignature,
+    bounds: &ConstraintSolver,
     scope: &LifetimeScope
 ) -> Vec<String> {
     let mut errors = Vec::new();
@@ -235,18 +207,25 @@ fn check_function_call(
         }
     }
     
-    // Check lifetime bounds
-    for bound in &signature.lifetime_bounds {
-        // Map lifetime names from signature to actual argument lifetimes
-        let longer_lifetime = map_lifetime_to_actual(&bound.longer, &arg_lifetimes);
-        let shorter_lifetime = map_lifetime_to_actual(&bound.shorter, &arg_lifetimes);
-        
-        if let (Some(longer), Some(shorter)) = (longer_lifetime, shorter_lifetime) {
-            if !scope.check_outlives(&longer, &shorter) {
-                errors.push(format!(
-                    "Lifetime constraint violated in call to '{}': '{}' must outlive '{}'",
-                    func_name, longer, shorter
-                ));
+    // Check lifetime bounds, including those implied through lifetimes
+    // that no argument is bound to
+    let mut checked = HashSet::new();
+    for bound_longer in bounds.lifetimes() {
+        for bound_shorter in bounds.outlived_by(bound_longer) {
+            // Map lifetime names from signature to actual argument lifetimes
+            let longer_lifetime = map_lifetime_to_actual(bound_longer, &arg_lifetimes);
+            let shorter_lifetime = map_lifetime_to_actual(bound_shorter, &arg_lifetimes);
+            
+            if let (Some(longer), Some(shorter)) = (longer_lifetime, shorter_lifetime) {
+                if !checked.insert((longer.clone(), shorter.clone())) {
+                    continue;
+                }
+                if !scope.check_outlives(&longer, &shorter) {
+                    errors.push(format!(
+                        "Lifetime constraint violated in call to '{}': '{}' must outlive '{}'",
+                        func_name, longer, shorter
+                    ));
+                }
             }
         }
     }
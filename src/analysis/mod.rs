@@ -1,6 +1,9 @@
 use crate::ir::{IrProgram, IrFunction, OwnershipState, BorrowKind};
 use crate::parser::HeaderCache;
-use std::collections::{HashMap, HashSet};
+use std::collections::HashSet;
+use rayon::prelude::*;
+use id_map::{IdMap, Interner, VarId};
+use crate::timing::PhaseTimes;
 
 pub mod ownership;
 pub mod borrows;
@@ -10,6 +13,10 @@ pub mod scope_lifetime;
 pub mod lifetime_inference;
 pub mod pointer_safety;
 pub mod unsafe_propagation;
+pub mod thread_safety;
+pub mod bounds;
+pub mod id_map;
+pub mod dataflow;
 
 #[derive(Debug, Clone)]
 #[allow(dead_code)]
@@ -48,69 +55,149 @@ pub fn check_borrows_with_annotations_and_safety(
     file_safe: bool
 ) -> Result<Vec<String>, String> {
     // If file is marked unsafe and no functions are marked safe, skip checking
-    if !file_safe && !has_any_safe_functions(&program, &header_cache) {
+    if !file_safe && !has_any_safe_functions(program.functions.iter().map(|f| &f.name), &header_cache) {
         return Ok(Vec::new()); // No checking for unsafe code
     }
     
     check_borrows_with_annotations(program, header_cache)
 }
 
-pub fn check_borrows_with_safety_context(
-    program: IrProgram,
-    header_cache: HeaderCache,
-    safety_context: crate::parser::safety_annotations::SafetyContext
-) -> Result<Vec<String>, String> {
-    use crate::parser::safety_annotations::SafetyMode;
-    
-    // If the file default is unsafe and no functions are marked safe, skip checking
-    if safety_context.file_default != SafetyMode::Safe && 
-       !safety_context.function_overrides.iter().any(|(_, mode)| *mode == SafetyMode::Safe) &&
-       !has_any_safe_functions(&program, &header_cache) {
-        return Ok(Vec::new()); // No checking for unsafe code
+/// The diagnostics of one function, kept apart by pass. A file's report
+/// lists them pass by pass, so per-function results (fresh or cached) can
+/// be merged back into the usual order.
+#[derive(Debug, Clone, Default, PartialEq)]
+pub struct FunctionDiagnostics {
+    /// Pointer, unsafe call, Send and bounds checks on the parsed function
+    pub parsed: Vec<String>,
+    pub borrows: Vec<String>,
+    pub inference: Vec<String>,
+    /// Checks against header lifetime annotations
+    pub annotated_lifetimes: Vec<String>,
+    pub scoped_lifetimes: Vec<String>,
+}
+
+impl FunctionDiagnostics {
+    pub fn groups(&self) -> [&Vec<String>; 5] {
+        [&self.parsed, &self.borrows, &self.inference, &self.annotated_lifetimes, &self.scoped_lifetimes]
     }
-    
-    let mut errors = Vec::new();
-    
-    // Check each function based on its safety mode
-    for function in &program.functions {
-        eprintln!("DEBUG: Checking function '{}'", function.name);
-        // Check if this function should be checked
-        if !safety_context.should_check_function(&function.name) {
-            eprintln!("DEBUG: Skipping unsafe function '{}'", function.name);
-            continue; // Skip unsafe functions
+
+    pub fn from_groups(mut groups: Vec<Vec<String>>) -> Option<Self> {
+        if groups.len() != 5 {
+            return None;
         }
-        eprintln!("DEBUG: Function '{}' is safe, checking...", function.name);
-        
-        let function_errors = check_function(function)?;
-        errors.extend(function_errors);
+        let scoped_lifetimes = groups.pop()?;
+        let annotated_lifetimes = groups.pop()?;
+        let inference = groups.pop()?;
+        let borrows = groups.pop()?;
+        let parsed = groups.pop()?;
+        Some(FunctionDiagnostics { parsed, borrows, inference, annotated_lifetimes, scoped_lifetimes })
     }
-    
-    // Run lifetime inference and validation for safe functions
-    for function in &program.functions {
-        if safety_context.should_check_function(&function.name) {
-            let inference_errors = lifetime_inference::infer_and_validate_lifetimes(function)?;
-            errors.extend(inference_errors);
+}
+
+/// Flatten per-function diagnostics: every function's diagnostics of one
+/// pass, then the next pass
+pub fn merge_diagnostics(per_function: &[FunctionDiagnostics]) -> Vec<String> {
+    let mut errors = Vec::new();
+    for group in 0..5 {
+        for diagnostics in per_function {
+            errors.extend(diagnostics.groups()[group].iter().cloned());
         }
     }
+    errors
+}
+
+/// Run the checks that work on a safe function's parsed AST
+pub fn check_parsed_function(
+    function: &crate::parser::Function,
+    safety_context: &crate::parser::safety_annotations::SafetyContext,
+    known_safe_functions: &HashSet<String>,
+) -> Vec<String> {
+    let mut violations = Vec::new();
+
+    // Check for pointer operations
+    violations.extend(pointer_safety::check_parsed_function_for_pointers(function));
+
+    // Check for calls to unsafe functions
+    violations.extend(unsafe_propagation::check_unsafe_propagation(
+        function,
+        safety_context,
+        known_safe_functions,
+    ));
+
+    // Check that nothing non-Send is handed to another thread
+    violations.extend(thread_safety::check_parsed_function_for_send(function));
+
+    // Check that unchecked element accesses have a proven index
+    violations.extend(bounds::check_parsed_function_for_unchecked_access(function));
+
+    violations
+}
+
+/// Whether the program has anything to borrow check. If the file default
+/// is unsafe and no function is marked safe (here or in a header), it does
+/// not.
+pub fn should_check_program<'a>(
+    function_names: impl IntoIterator<Item = &'a String>,
+    header_cache: &HeaderCache,
+    safety_context: &crate::parser::safety_annotations::SafetyContext,
+) -> bool {
+    safety_context.has_safe_functions() || has_any_safe_functions(function_names, header_cache)
+}
+
+/// Run the IR checks on one function of a program that should be checked.
+/// Borrow checking and lifetime inference only run on safe functions; the
+/// header annotation checks run on every function.
+pub fn check_ir_function(
+    function: &IrFunction,
+    safe: bool,
+    header_cache: &HeaderCache,
+    times: &mut PhaseTimes,
+) -> Result<FunctionDiagnostics, String> {
+    let mut diagnostics = FunctionDiagnostics::default();
+    if safe {
+        diagnostics.borrows = times.time("ownership analysis", || check_function(function))?;
+        diagnostics.inference = times.time("lifetime inference", || lifetime_inference::infer_and_validate_lifetimes(function))?;
+    }
     
     // If we have header annotations, also check lifetime constraints
     if header_cache.has_signatures() {
-        let lifetime_errors = lifetime_checker::check_lifetimes_with_annotations(&program, &header_cache)?;
-        errors.extend(lifetime_errors);
+        diagnostics.annotated_lifetimes = times.time("annotated lifetime checks", || lifetime_checker::check_function_with_annotations(function, header_cache))?;
         
         // Also run scope-based lifetime checking
-        let scope_errors = scope_lifetime::check_scoped_lifetimes(&program, &header_cache)?;
-        errors.extend(scope_errors);
+        diagnostics.scoped_lifetimes = times.time("scope lifetime checks", || scope_lifetime::analyze_function_scopes(function, header_cache))?;
+    }
+    Ok(diagnostics)
+}
+
+#[allow(dead_code)]
+pub fn check_borrows_with_safety_context(
+    program: IrProgram,
+    header_cache: HeaderCache,
+    safety_context: crate::parser::safety_annotations::SafetyContext
+) -> Result<Vec<String>, String> {
+    // If the file default is unsafe and no functions are marked safe, skip checking
+    if !should_check_program(program.functions.iter().map(|f| &f.name), &header_cache, &safety_context) {
+        return Ok(Vec::new()); // No checking for unsafe code
     }
     
-    Ok(errors)
+    // Functions are checked independently, so check them in parallel
+    let per_function = program.functions
+        .par_iter()
+        .map(|function| {
+            let safe = safety_context.should_check_function(&function.name);
+            debug_trace!("DEBUG: Function '{}' is {}", function.name, if safe { "safe, checking..." } else { "unsafe, skipping" });
+            check_ir_function(function, safe, &header_cache, &mut PhaseTimes::default())
+        })
+        .collect::<Result<Vec<_>, String>>()?;
+    
+    Ok(merge_diagnostics(&per_function))
 }
 
-fn has_any_safe_functions(program: &IrProgram, header_cache: &HeaderCache) -> bool {
+fn has_any_safe_functions<'a>(function_names: impl IntoIterator<Item = &'a String>, header_cache: &HeaderCache) -> bool {
     use crate::parser::annotations::SafetyAnnotation;
     
-    for function in &program.functions {
-        if let Some(sig) = header_cache.get_signature(&function.name) {
+    for name in function_names {
+        if let Some(sig) = header_cache.get_signature(name) {
             if let Some(SafetyAnnotation::Safe) = sig.safety {
                 return true;
             }
@@ -165,15 +252,15 @@ fn check_function(function: &IrFunction) -> Result<Vec<String>, String> {
     
     // Initialize ownership for parameters and variables
     for (name, var_info) in &function.variables {
-        ownership_tracker.set_ownership(name.clone(), var_info.ownership.clone());
+        ownership_tracker.set_ownership(name, var_info.ownership.clone());
         
         // Track reference types
         match &var_info.ty {
             crate::ir::VariableType::Reference(_) => {
-                ownership_tracker.mark_as_reference(name.clone(), false);
+                ownership_tracker.mark_as_reference(name, false);
             }
             crate::ir::VariableType::MutableReference(_) => {
-                ownership_tracker.mark_as_reference(name.clone(), true);
+                ownership_tracker.mark_as_reference(name, true);
             }
             _ => {}
         }
@@ -202,10 +289,9 @@ fn check_function(function: &IrFunction) -> Result<Vec<String>, String> {
                     loop_end += 1;
                 }
                 
-                // Process the loop body twice to simulate 2 iterations
+                // The body is checked once here. Uses of what an earlier
+                // iteration moved are found by the dataflow check below.
                 let loop_body = &block.statements[i+1..loop_end-1];
-                
-                // First iteration
                 ownership_tracker.enter_loop();
                 
                 // Track variables declared in the loop
@@ -219,21 +305,7 @@ fn check_function(function: &IrFunction) -> Result<Vec<String>, String> {
                     process_statement(loop_stmt, &mut ownership_tracker, &mut errors);
                 }
                 
-                // Save state after first iteration (but only for non-loop-local variables)
-                let state_after_first = ownership_tracker.ownership.clone();
-                
-                // Clear loop-local borrows at end of first iteration
-                ownership_tracker.clear_loop_locals(&loop_local_vars);
-                
-                // Second iteration - check for use-after-move
-                for loop_stmt in loop_body {
-                    // Before processing each statement in second iteration,
-                    // check if it would cause use-after-move (but only for non-loop-local vars)
-                    check_statement_for_loop_errors(loop_stmt, &state_after_first, &mut errors);
-                    process_statement(loop_stmt, &mut ownership_tracker, &mut errors);
-                }
-                
-                // Clear loop-local borrows at end of second iteration
+                // Loop-local borrows end with the iteration
                 ownership_tracker.clear_loop_locals(&loop_local_vars);
                 
                 ownership_tracker.exit_loop();
@@ -246,44 +318,14 @@ fn check_function(function: &IrFunction) -> Result<Vec<String>, String> {
                 i += 1;
             }
         }
+        
+        // Uses, in any loop, of variables a previous iteration moved
+        errors.extend(dataflow::check_loop_carried_moves(&block.statements));
     }
     
     Ok(errors)
 }
 
-// Helper function to check for loop-specific errors in second iteration
-fn check_statement_for_loop_errors(
-    statement: &crate::ir::IrStatement,
-    state_after_first: &HashMap<String, OwnershipState>,
-    errors: &mut Vec<String>,
-) {
-    match statement {
-        crate::ir::IrStatement::Move { from, .. } => {
-            if let Some(state) = state_after_first.get(from) {
-                if *state == OwnershipState::Moved {
-                    errors.push(format!(
-                        "Use after move in loop: variable '{}' was moved in first iteration and used again in second iteration",
-                        from
-                    ));
-                }
-            }
-        }
-        crate::ir::IrStatement::Assign { rhs, .. } => {
-            if let crate::ir::IrExpression::Variable(var) = rhs {
-                if let Some(state) = state_after_first.get(var) {
-                    if *state == OwnershipState::Moved {
-                        errors.push(format!(
-                            "Use after move in loop: variable '{}' was moved in first iteration and used again in second iteration",
-                            var
-                        ));
-                    }
-                }
-            }
-        }
-        _ => {}
-    }
-}
-
 // Extract statement processing logic into a separate function
 fn process_statement(
     statement: &crate::ir::IrStatement,
@@ -292,18 +334,18 @@ fn process_statement(
 ) {
     match statement {
         crate::ir::IrStatement::Move { from, to } => {
-            eprintln!("DEBUG ANALYSIS: Processing Move from '{}' to '{}'", from, to);
+            debug_trace!("DEBUG ANALYSIS: Processing Move from '{}' to '{}'", from, to);
             // Skip checks if we're in an unsafe block
             if ownership_tracker.is_in_unsafe_block() {
                 // Still update ownership state for consistency
-                ownership_tracker.set_ownership(from.clone(), OwnershipState::Moved);
-                ownership_tracker.set_ownership(to.clone(), OwnershipState::Owned);
+                ownership_tracker.set_ownership(from, OwnershipState::Moved);
+                ownership_tracker.set_ownership(to, OwnershipState::Owned);
                 return;
             }
             
             // Check if 'from' is owned and not moved
             let from_state = ownership_tracker.get_ownership(from);
-            eprintln!("DEBUG ANALYSIS: '{}' state: {:?}", from, from_state);
+            debug_trace!("DEBUG ANALYSIS: '{}' state: {:?}", from, from_state);
             
             // Can't move from a reference
             if ownership_tracker.is_reference(from) {
@@ -324,11 +366,11 @@ fn process_statement(
             // Handle temporary move markers (from std::move in function calls)
             if to.starts_with("_temp_move_") || to.starts_with("_moved_") {
                 // Just mark the source as moved, don't create the temporary
-                ownership_tracker.set_ownership(from.clone(), OwnershipState::Moved);
+                ownership_tracker.set_ownership(from, OwnershipState::Moved);
             } else {
                 // Transfer ownership for regular moves
-                ownership_tracker.set_ownership(from.clone(), OwnershipState::Moved);
-                ownership_tracker.set_ownership(to.clone(), OwnershipState::Owned);
+                ownership_tracker.set_ownership(from, OwnershipState::Moved);
+                ownership_tracker.set_ownership(to, OwnershipState::Owned);
             }
         }
         
@@ -336,8 +378,8 @@ fn process_statement(
             // Skip checks if we're in an unsafe block
             if ownership_tracker.is_in_unsafe_block() {
                 // Still record the borrow for consistency
-                ownership_tracker.add_borrow(from.clone(), to.clone(), kind.clone());
-                ownership_tracker.mark_as_reference(to.clone(), *kind == BorrowKind::Mutable);
+                ownership_tracker.add_borrow(from, to, kind.clone());
+                ownership_tracker.mark_as_reference(to, *kind == BorrowKind::Mutable);
                 return;
             }
             
@@ -384,8 +426,8 @@ fn process_statement(
             }
             
             // Record the borrow
-            ownership_tracker.add_borrow(from.clone(), to.clone(), kind.clone());
-            ownership_tracker.mark_as_reference(to.clone(), *kind == BorrowKind::Mutable);
+            ownership_tracker.add_borrow(from, to, kind.clone());
+            ownership_tracker.mark_as_reference(to, *kind == BorrowKind::Mutable);
         }
         
         crate::ir::IrStatement::Assign { lhs, rhs } => {
@@ -477,9 +519,10 @@ fn process_statement(
 }
 
 struct OwnershipTracker {
-    ownership: HashMap<String, OwnershipState>,
-    borrows: HashMap<String, BorrowInfo>,
-    reference_info: HashMap<String, ReferenceInfo>,
+    names: Interner,
+    ownership: IdMap<OwnershipState>,
+    borrows: IdMap<BorrowInfo>,
+    reference_info: IdMap<ReferenceInfo>,
     // Stack of scopes, each scope tracks borrows created in it
     scope_stack: Vec<ScopeInfo>,
     // Loop tracking
@@ -490,34 +533,35 @@ struct OwnershipTracker {
     unsafe_depth: usize,
 }
 
+// Snapshots share their maps with the tracker, so taking one is O(1)
 #[derive(Clone)]
 struct TrackerState {
-    ownership: HashMap<String, OwnershipState>,
-    borrows: HashMap<String, BorrowInfo>,
-    reference_info: HashMap<String, ReferenceInfo>,
+    ownership: IdMap<OwnershipState>,
+    borrows: IdMap<BorrowInfo>,
+    reference_info: IdMap<ReferenceInfo>,
 }
 
 #[derive(Clone)]
 struct LoopEntryState {
-    ownership: HashMap<String, OwnershipState>,
+    ownership: IdMap<OwnershipState>,
     #[allow(dead_code)]
-    borrows: HashMap<String, BorrowInfo>,
+    borrows: IdMap<BorrowInfo>,
 }
 
 #[derive(Default, Clone)]
 struct ScopeInfo {
     // Borrows created in this scope (to be cleaned up on exit)
-    local_borrows: HashSet<String>,
+    local_borrows: HashSet<VarId>,
 }
 
-#[derive(Default, Clone)]
+#[derive(Debug, Default, Clone)]
 struct BorrowInfo {
     immutable_count: usize,
     has_mutable: bool,
-    borrowers: HashSet<String>,
+    borrowers: HashSet<VarId>,
 }
 
-#[derive(Clone)]
+#[derive(Debug, Clone)]
 struct ReferenceInfo {
     is_reference: bool,
     is_mutable: bool,
@@ -526,9 +570,10 @@ struct ReferenceInfo {
 impl OwnershipTracker {
     fn new() -> Self {
         let mut tracker = Self {
-            ownership: HashMap::new(),
-            borrows: HashMap::new(),
-            reference_info: HashMap::new(),
+            names: Interner::new(),
+            ownership: IdMap::new(),
+            borrows: IdMap::new(),
+            reference_info: IdMap::new(),
             scope_stack: Vec::new(),
             loop_depth: 0,
             loop_entry_states: Vec::new(),
@@ -543,21 +588,24 @@ impl OwnershipTracker {
         self.unsafe_depth > 0
     }
     
-    fn set_ownership(&mut self, var: String, state: OwnershipState) {
-        self.ownership.insert(var, state);
+    fn set_ownership(&mut self, var: &str, state: OwnershipState) {
+        let id = self.names.intern(var);
+        self.ownership.insert(id, state);
     }
     
     fn get_ownership(&self, var: &str) -> Option<&OwnershipState> {
-        self.ownership.get(var)
+        self.names.get(var).and_then(|id| self.ownership.get(id))
     }
     
     fn get_borrows(&self, var: &str) -> BorrowInfo {
-        self.borrows.get(var).cloned().unwrap_or_default()
+        self.names.get(var).and_then(|id| self.borrows.get(id)).cloned().unwrap_or_default()
     }
     
-    fn add_borrow(&mut self, from: String, to: String, kind: BorrowKind) {
-        let borrow_info = self.borrows.entry(from).or_default();
-        borrow_info.borrowers.insert(to.clone());
+    fn add_borrow(&mut self, from: &str, to: &str, kind: BorrowKind) {
+        let from = self.names.intern(from);
+        let to = self.names.intern(to);
+        let borrow_info = self.borrows.entry_or_default(from);
+        borrow_info.borrowers.insert(to);
         
         // Track this borrow in the current scope
         if let Some(current_scope) = self.scope_stack.last_mut() {
@@ -577,40 +625,55 @@ impl OwnershipTracker {
     fn exit_scope(&mut self) {
         if let Some(scope) = self.scope_stack.pop() {
             // Clean up all borrows created in this scope
-            for borrow_name in scope.local_borrows {
+            for borrow_name in &scope.local_borrows {
                 // Remove from reference info
-                self.reference_info.remove(&borrow_name);
-                
-                // Remove from all borrow tracking
-                for borrow_info in self.borrows.values_mut() {
-                    borrow_info.borrowers.remove(&borrow_name);
-                    // Note: In a more complete implementation, we'd also
-                    // decrement counts based on the borrow kind
-                }
+                self.reference_info.remove(*borrow_name);
             }
-            
-            // Clean up empty borrow entries
-            self.borrows.retain(|_, info| !info.borrowers.is_empty());
+            // Remove from all borrow tracking
+            // Note: In a more complete implementation, we'd also
+            // decrement counts based on the borrow kind
+            self.remove_borrowers(&scope.local_borrows);
         }
     }
     
-    fn mark_as_reference(&mut self, var: String, is_mutable: bool) {
-        self.reference_info.insert(var, ReferenceInfo {
+    /// Forget `borrowers` in every borrow entry, and drop entries left with
+    /// no borrowers. Only entries that change are written, so the rest stay
+    /// shared with saved states.
+    fn remove_borrowers(&mut self, borrowers: &HashSet<VarId>) {
+        let affected: Vec<VarId> = self.borrows
+            .iter()
+            .filter(|(_, info)| info.borrowers.iter().any(|b| borrowers.contains(b)))
+            .map(|(id, _)| id)
+            .collect();
+        for id in affected {
+            let info = self.borrows.get_mut(id).unwrap();
+            info.borrowers.retain(|b| !borrowers.contains(b));
+            if info.borrowers.is_empty() {
+                self.borrows.remove(id);
+            }
+        }
+    }
+    
+    fn mark_as_reference(&mut self, var: &str, is_mutable: bool) {
+        let id = self.names.intern(var);
+        self.reference_info.insert(id, ReferenceInfo {
             is_reference: true,
             is_mutable,
         });
     }
     
     fn is_reference(&self, var: &str) -> bool {
-        self.reference_info
+        self.names
             .get(var)
+            .and_then(|id| self.reference_info.get(id))
             .map(|info| info.is_reference)
             .unwrap_or(false)
     }
     
     fn is_mutable_reference(&self, var: &str) -> bool {
-        self.reference_info
+        self.names
             .get(var)
+            .and_then(|id| self.reference_info.get(id))
             .map(|info| info.is_reference && info.is_mutable)
             .unwrap_or(false)
     }
@@ -638,7 +701,7 @@ impl OwnershipTracker {
                 // will be moved at the START of the second iteration
                 // So check if any variables that are currently Moved
                 // were NOT moved at loop entry
-                for (var, current_state) in &self.ownership {
+                for (var, current_state) in self.ownership.iter() {
                     if *current_state == OwnershipState::Moved {
                         // If this variable was Owned at loop entry,
                         // it means it was moved during the loop body
@@ -674,18 +737,22 @@ impl OwnershipTracker {
     fn merge_states(&mut self, then_state: &TrackerState, else_state: &TrackerState) {
         // Merge ownership states conservatively
         // A variable is considered moved only if moved in BOTH branches
-        for (var, then_ownership) in &then_state.ownership {
+        for (var, then_ownership) in then_state.ownership.iter() {
             if let Some(else_ownership) = else_state.ownership.get(var) {
-                if *then_ownership == OwnershipState::Moved && *else_ownership == OwnershipState::Moved {
+                let merged = if *then_ownership == OwnershipState::Moved && *else_ownership == OwnershipState::Moved {
                     // Moved in both branches - stays moved
-                    self.ownership.insert(var.clone(), OwnershipState::Moved);
+                    OwnershipState::Moved
                 } else if *then_ownership == OwnershipState::Moved || *else_ownership == OwnershipState::Moved {
                     // Moved in only one branch - mark as "maybe moved" (for now, treat as owned)
                     // In a more sophisticated analysis, we'd track MaybeMoved state
-                    self.ownership.insert(var.clone(), OwnershipState::Owned);
+                    OwnershipState::Owned
                 } else {
                     // Not moved in either branch - use the common state
-                    self.ownership.insert(var.clone(), then_ownership.clone());
+                    then_ownership.clone()
+                };
+                // Unchanged entries are not written, to keep chunks shared
+                if self.ownership.get(var) != Some(&merged) {
+                    self.ownership.insert(var, merged);
                 }
             }
         }
@@ -693,7 +760,7 @@ impl OwnershipTracker {
         // Merge borrows - a borrow exists only if it exists in BOTH branches
         // This is conservative: if a borrow doesn't exist in one branch, it's not guaranteed after the if
         self.borrows.clear();
-        for (var, then_borrow) in &then_state.borrows {
+        for (var, then_borrow) in then_state.borrows.iter() {
             if let Some(else_borrow) = else_state.borrows.get(var) {
                 // Borrow exists in both branches - keep it
                 let mut merged_borrow = then_borrow.clone();
@@ -704,58 +771,39 @@ impl OwnershipTracker {
                 merged_borrow.has_mutable = merged_borrow.has_mutable && else_borrow.has_mutable;
                 
                 if !merged_borrow.borrowers.is_empty() {
-                    self.borrows.insert(var.clone(), merged_borrow);
+                    self.borrows.insert(var, merged_borrow);
                 }
             }
             // If borrow doesn't exist in else branch, don't include it
         }
         
         // Also clear reference info for references that don't exist in both branches
-        let mut refs_to_keep = HashSet::new();
-        for (var, _) in &then_state.reference_info {
-            if else_state.reference_info.contains_key(var) {
-                refs_to_keep.insert(var.clone());
-            }
-        }
-        self.reference_info.retain(|var, _| refs_to_keep.contains(var));
+        self.reference_info.retain(|var, _| {
+            then_state.reference_info.contains_key(var) && else_state.reference_info.contains_key(var)
+        });
     }
     
     fn clear_loop_locals(&mut self, loop_locals: &HashSet<String>) {
-        // Clear borrows for loop-local variables
-        for local_var in loop_locals {
+        let loop_locals: HashSet<VarId> = loop_locals.iter().filter_map(|v| self.names.get(v)).collect();
+        for local_var in &loop_locals {
             // Remove from reference info
-            self.reference_info.remove(local_var);
-            
-            // Remove from all borrow tracking
-            for borrow_info in self.borrows.values_mut() {
-                borrow_info.borrowers.remove(local_var);
-                // We should also decrement counts, but need to track the kind
-                // For simplicity, we'll rebuild the counts
-            }
+            self.reference_info.remove(*local_var);
             
             // Remove the ownership entry for loop-local variables
-            self.ownership.remove(local_var);
-        }
-        
-        // Clean up empty borrow entries and recalculate counts
-        for (_, borrow_info) in self.borrows.iter_mut() {
-            // Reset counts based on remaining borrowers
-            // This is a simplification - in a real implementation we'd track
-            // the kind of each borrow
-            if borrow_info.borrowers.is_empty() {
-                borrow_info.immutable_count = 0;
-                borrow_info.has_mutable = false;
-            }
+            self.ownership.remove(*local_var);
         }
         
-        // Remove empty entries
-        self.borrows.retain(|_, info| !info.borrowers.is_empty());
+        // Remove from all borrow tracking, and remove empty entries.
+        // Counts are not decremented: we'd need to track the kind of each
+        // borrow. An entry left with no borrowers is dropped, counts and all.
+        self.remove_borrowers(&loop_locals);
     }
 }
 
 #[cfg(test)]
 mod tests {
     use super::*;
+    use std::collections::HashMap;
     use crate::ir::{IrProgram, IrFunction, BasicBlock, IrStatement};
     use petgraph::graph::DiGraph;
 
@@ -795,7 +843,7 @@ mod tests {
     #[test]
     fn test_ownership_tracker_initialization() {
         let mut tracker = OwnershipTracker::new();
-        tracker.set_ownership("x".to_string(), OwnershipState::Owned);
+        tracker.set_ownership("x", OwnershipState::Owned);
         
         assert_eq!(tracker.get_ownership("x"), Some(&OwnershipState::Owned));
         assert_eq!(tracker.get_ownership("y"), None);
@@ -806,12 +854,12 @@ mod tests {
         let mut tracker = OwnershipTracker::new();
         
         // Start with owned
-        tracker.set_ownership("x".to_string(), OwnershipState::Owned);
+        tracker.set_ownership("x", OwnershipState::Owned);
         assert_eq!(tracker.get_ownership("x"), Some(&OwnershipState::Owned));
         
         // Move to another variable
-        tracker.set_ownership("x".to_string(), OwnershipState::Moved);
-        tracker.set_ownership("y".to_string(), OwnershipState::Owned);
+        tracker.set_ownership("x", OwnershipState::Moved);
+        tracker.set_ownership("y", OwnershipState::Owned);
         
         assert_eq!(tracker.get_ownership("x"), Some(&OwnershipState::Moved));
         assert_eq!(tracker.get_ownership("y"), Some(&OwnershipState::Owned));
@@ -820,16 +868,16 @@ mod tests {
     #[test]
     fn test_borrow_tracking() {
         let mut tracker = OwnershipTracker::new();
-        tracker.set_ownership("x".to_string(), OwnershipState::Owned);
+        tracker.set_ownership("x", OwnershipState::Owned);
         
         // Add immutable borrow
-        tracker.add_borrow("x".to_string(), "ref1".to_string(), BorrowKind::Immutable);
+        tracker.add_borrow("x", "ref1", BorrowKind::Immutable);
         let borrows = tracker.get_borrows("x");
         assert_eq!(borrows.immutable_count, 1);
         assert!(!borrows.has_mutable);
         
         // Add another immutable borrow
-        tracker.add_borrow("x".to_string(), "ref2".to_string(), BorrowKind::Immutable);
+        tracker.add_borrow("x", "ref2", BorrowKind::Immutable);
         let borrows = tracker.get_borrows("x");
         assert_eq!(borrows.immutable_count, 2);
         assert!(!borrows.has_mutable);
@@ -838,10 +886,10 @@ mod tests {
     #[test]
     fn test_mutable_borrow_tracking() {
         let mut tracker = OwnershipTracker::new();
-        tracker.set_ownership("x".to_string(), OwnershipState::Owned);
+        tracker.set_ownership("x", OwnershipState::Owned);
         
         // Add mutable borrow
-        tracker.add_borrow("x".to_string(), "mut_ref".to_string(), BorrowKind::Mutable);
+        tracker.add_borrow("x", "mut_ref", BorrowKind::Mutable);
         let borrows = tracker.get_borrows("x");
         assert_eq!(borrows.immutable_count, 0);
         assert!(borrows.has_mutable);
@@ -975,6 +1023,39 @@ mod tests {
         assert!(errors[0].contains("mutable"));
     }
 
+    #[test]
+    fn test_move_in_loop_detected_once_per_variable() {
+        let mut program = create_test_program();
+        let mut func = create_test_function("test");
+        
+        func.variables.insert(
+            "x".to_string(),
+            crate::ir::VariableInfo {
+                name: "x".to_string(),
+                ty: crate::ir::VariableType::Owned("int".to_string()),
+                ownership: OwnershipState::Owned,
+                lifetime: None,
+            },
+        );
+        
+        // for (...) { for (...) { y = std::move(x); } }
+        let block = &mut func.cfg[petgraph::graph::NodeIndex::new(0)];
+        block.statements.push(IrStatement::EnterLoop);
+        block.statements.push(IrStatement::EnterLoop);
+        block.statements.push(IrStatement::Move {
+            from: "x".to_string(),
+            to: "y".to_string(),
+        });
+        block.statements.push(IrStatement::ExitLoop);
+        block.statements.push(IrStatement::ExitLoop);
+        
+        program.functions.push(func);
+        
+        let errors = check_borrows(program).unwrap();
+        assert_eq!(errors.len(), 1);
+        assert!(errors[0].contains("Use after move in loop"));
+    }
+
     #[test]
     fn test_const_reference_cannot_modify() {
         let mut program = create_test_program();
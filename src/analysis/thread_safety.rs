@@ -0,0 +1,422 @@
+use crate::parser::{Capture, CaptureKind, Expression, Function, Statement};
+use std::collections::HashMap;
+
+/// Calls whose arguments run on another thread: std::thread's constructor,
+/// std::async, rusty::thread::Scope::spawn, ThreadPool::spawn and join
+const THREAD_ENTRY_POINTS: &[&str] = &["spawn", "join", "thread", "async"];
+
+/// Whether values of a type may move to another thread (Send) and be shared
+/// between threads (Sync); the rules mirror include/rusty/marker.hpp
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct ThreadTraits {
+    pub send: bool,
+    pub sync: bool,
+}
+
+impl ThreadTraits {
+    const BOTH: ThreadTraits = ThreadTraits { send: true, sync: true };
+
+    fn and(self, other: ThreadTraits) -> ThreadTraits {
+        ThreadTraits {
+            send: self.send && other.send,
+            sync: self.sync && other.sync,
+        }
+    }
+}
+
+/// Check that nothing a function hands to another thread is non-Send: the
+/// variables passed to a spawn-like call and the variables captured by
+/// closures passed to one. A by-reference capture shares the variable, so it
+/// must be Sync instead. Closures nested in arguments (the body of a
+/// thread::scope) are checked too.
+pub fn check_parsed_function_for_send(function: &Function) -> Vec<String> {
+    let mut checker = SendChecker {
+        types: HashMap::new(),
+        closures: HashMap::new(),
+        errors: Vec::new(),
+    };
+    for param in &function.parameters {
+        checker.types.insert(param.name.clone(), param.type_name.clone());
+    }
+    checker.check_statements(&function.body);
+
+    checker
+        .errors
+        .into_iter()
+        .map(|error| format!("In function '{}': {}", function.name, error))
+        .collect()
+}
+
+struct SendChecker {
+    types: HashMap<String, String>,
+    // Captures of closures stored in a variable before being spawned
+    closures: HashMap<String, Vec<Capture>>,
+    errors: Vec<String>,
+}
+
+impl SendChecker {
+    fn check_statements(&mut self, statements: &[Statement]) {
+        for stmt in statements {
+            self.check_statement(stmt);
+        }
+    }
+
+    fn check_statement(&mut self, stmt: &Statement) {
+        match stmt {
+            Statement::VariableDecl(var) => {
+                self.types.insert(var.name.clone(), var.type_name.clone());
+            }
+            Statement::Assignment { lhs, rhs, location } => {
+                if let Expression::Lambda { captures, .. } = rhs {
+                    self.closures.insert(lhs.clone(), captures.clone());
+                }
+                self.check_expression(rhs, location.line);
+            }
+            Statement::FunctionCall { name, args, location } => {
+                self.check_call(name, args, location.line);
+            }
+            Statement::Return(Some(expr)) => {
+                self.check_expression(expr, 0);
+            }
+            Statement::If { condition, then_branch, else_branch, location } => {
+                self.check_expression(condition, location.line);
+                self.check_statements(then_branch);
+                if let Some(else_stmts) = else_branch {
+                    self.check_statements(else_stmts);
+                }
+            }
+            Statement::Block(statements) => {
+                self.check_statements(statements);
+            }
+            _ => {}
+        }
+    }
+
+    fn check_expression(&mut self, expr: &Expression, line: u32) {
+        match expr {
+            Expression::FunctionCall { name, args } => {
+                self.check_call(name, args, line);
+            }
+            Expression::Lambda { body, .. } => {
+                self.check_statements(body);
+            }
+            Expression::Move(inner) | Expression::Dereference(inner) | Expression::AddressOf(inner) => {
+                self.check_expression(inner, line);
+            }
+            Expression::BinaryOp { left, right, .. } => {
+                self.check_expression(left, line);
+                self.check_expression(right, line);
+            }
+            _ => {}
+        }
+    }
+
+    fn check_call(&mut self, name: &str, args: &[Expression], line: u32) {
+        let base_name = name.rsplit("::").next().unwrap_or(name);
+        if THREAD_ENTRY_POINTS.contains(&base_name) {
+            for arg in args {
+                self.check_sent(arg, base_name, line);
+            }
+        }
+        for arg in args {
+            self.check_expression(arg, line);
+        }
+    }
+
+    fn check_sent(&mut self, arg: &Expression, call: &str, line: u32) {
+        match arg {
+            Expression::Variable(var) => {
+                if let Some(captures) = self.closures.get(var).cloned() {
+                    self.check_captures(&captures, call, line);
+                } else {
+                    self.require_send(var, "passed to", call, line);
+                }
+            }
+            Expression::Move(inner) => {
+                if let Expression::Variable(var) = inner.as_ref() {
+                    self.require_send(var, "moved into", call, line);
+                }
+            }
+            Expression::Lambda { captures, .. } => {
+                self.check_captures(captures, call, line);
+            }
+            _ => {}
+        }
+    }
+
+    fn check_captures(&mut self, captures: &[Capture], call: &str, line: u32) {
+        for capture in captures {
+            match capture.kind {
+                CaptureKind::ByValue => {
+                    self.require_send(&capture.name, "captured by a closure passed to", call, line)
+                }
+                CaptureKind::ByRef => self.require_sync(&capture.name, call, line),
+            }
+        }
+    }
+
+    fn require_send(&mut self, var: &str, how: &str, call: &str, line: u32) {
+        let type_name = match self.types.get(var) {
+            Some(type_name) => type_name,
+            None => return,  // Not a local variable (a function, a global)
+        };
+        if !thread_traits(type_name).send {
+            self.errors.push(format!(
+                "'{}' of type '{}' is not Send: {} '{}' at line {}, which may run it on another thread (use Arc instead of Rc)",
+                var, type_name, how, call, line
+            ));
+        }
+    }
+
+    fn require_sync(&mut self, var: &str, call: &str, line: u32) {
+        let type_name = match self.types.get(var) {
+            Some(type_name) => type_name,
+            None => return,
+        };
+        if !thread_traits(type_name).sync {
+            self.errors.push(format!(
+                "'{}' of type '{}' is not Sync, so a reference to it is not Send: captured by reference by a closure passed to '{}' at line {}, which may share it with another thread",
+                var, type_name, call, line
+            ));
+        }
+    }
+}
+
+/// Work out Send and Sync for a C++ type spelling such as
+/// `const rusty::Vec<rusty::Rc<int>> &`
+pub fn thread_traits(type_name: &str) -> ThreadTraits {
+    let mut ty = type_name.trim();
+    let mut is_reference = false;
+    while let Some(rest) = ty.strip_suffix('&') {
+        is_reference = true;
+        ty = rest.trim_end();
+    }
+    if ty.ends_with('*') {
+        return ThreadTraits::BOTH;  // Raw pointers are unchecked, as in marker.hpp
+    }
+    for qualifier in ["const ", "volatile "] {
+        if let Some(rest) = ty.strip_prefix(qualifier) {
+            ty = rest.trim_start();
+        }
+    }
+    for qualifier in [" const", " volatile"] {
+        if let Some(rest) = ty.strip_suffix(qualifier) {
+            ty = rest.trim_end();
+        }
+    }
+
+    let traits = match ty.find('<') {
+        Some(open) if ty.ends_with('>') => {
+            let name = ty[..open].rsplit("::").next().unwrap_or("").trim();
+            let args: Vec<ThreadTraits> = split_template_args(&ty[open + 1..ty.len() - 1])
+                .into_iter()
+                .map(thread_traits)
+                .collect();
+            template_traits(name, &args)
+        }
+        _ => ThreadTraits::BOTH,
+    };
+
+    if is_reference {
+        // Sending a reference shares the referent
+        ThreadTraits { send: traits.sync, sync: traits.sync }
+    } else {
+        traits
+    }
+}
+
+fn template_traits(name: &str, args: &[ThreadTraits]) -> ThreadTraits {
+    let first = args.first().copied().unwrap_or(ThreadTraits::BOTH);
+    let all = args.iter().fold(ThreadTraits::BOTH, |acc, t| acc.and(*t));
+    match name {
+        "Rc" | "Weak" | "Ref" | "RefMut" => ThreadTraits { send: false, sync: false },
+        "RefCell" | "SyncRefCell" | "LocalRefCell" | "UncheckedRefCell" | "Cell" | "UnsafeCell" => {
+            ThreadTraits { send: first.send, sync: false }
+        }
+        "Arc" | "ArcWeak" | "ArcSwap" | "CacheAlignedArc" => {
+            let shared = first.send && first.sync;
+            ThreadTraits { send: shared, sync: shared }
+        }
+        "Mutex" => ThreadTraits { send: first.send, sync: first.send },
+        "RwLock" => ThreadTraits { send: first.send, sync: first.send && first.sync },
+        "Sender" => ThreadTraits { send: first.send, sync: first.send },
+        "Receiver" => ThreadTraits { send: first.send, sync: false },
+        "Slice" | "reference_wrapper" => ThreadTraits { send: first.sync, sync: first.sync },
+        _ => all,
+    }
+}
+
+/// Split template arguments at top-level commas
+fn split_template_args(args: &str) -> Vec<&str> {
+    let mut parts = Vec::new();
+    let mut depth = 0i32;
+    let mut start = 0;
+    for (i, c) in args.char_indices() {
+        match c {
+            '<' | '(' => depth += 1,
+            '>' | ')' => depth -= 1,
+            ',' if depth == 0 => {
+                parts.push(args[start..i].trim());
+                start = i + 1;
+            }
+            _ => {}
+        }
+    }
+    let last = args[start..].trim();
+    if !last.is_empty() {
+        parts.push(last);
+    }
+    parts
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::parser::{SourceLocation, Variable};
+
+    fn location(line: u32) -> SourceLocation {
+        SourceLocation {
+            file: "test.cpp".to_string(),
+            line,
+            column: 1,
+        }
+    }
+
+    fn variable(name: &str, type_name: &str) -> Variable {
+        Variable {
+            name: name.to_string(),
+            type_name: type_name.to_string(),
+            is_reference: type_name.ends_with('&'),
+            is_pointer: false,
+            is_const: false,
+            is_unique_ptr: false,
+            is_shared_ptr: false,
+            location: location(1),
+        }
+    }
+
+    fn function(body: Vec<Statement>) -> Function {
+        Function {
+            name: "fork_join".to_string(),
+            parameters: vec![variable("shared", "rusty::Arc<int>")],
+            return_type: "void".to_string(),
+            body,
+            location: location(1),
+            unchecked_accesses: vec![],
+        }
+    }
+
+    fn captured(captures: &[&str], kind: CaptureKind, body: Vec<Statement>) -> Expression {
+        Expression::Lambda {
+            captures: captures.iter().map(|c| Capture { name: c.to_string(), kind }).collect(),
+            body,
+        }
+    }
+
+    fn lambda(captures: &[&str], body: Vec<Statement>) -> Expression {
+        captured(captures, CaptureKind::ByValue, body)
+    }
+
+    fn call(name: &str, args: Vec<Expression>, line: u32) -> Statement {
+        Statement::FunctionCall {
+            name: name.to_string(),
+            args,
+            location: location(line),
+        }
+    }
+
+    #[test]
+    fn test_thread_traits() {
+        assert!(thread_traits("int").send);
+        assert!(!thread_traits("rusty::Rc<int>").send);
+        assert!(!thread_traits("const rusty::Rc<int> &").send);
+        assert!(thread_traits("rusty::Arc<int>").send);
+        assert!(!thread_traits("rusty::Arc<rusty::Rc<int>>").send);
+        assert!(!thread_traits("rusty::Vec<rusty::Rc<int>>").send);
+        assert!(thread_traits("rusty::Vec<rusty::Arc<int>, rusty::Global>").send);
+        assert!(!thread_traits("rusty::HashMap<int, rusty::Weak<int>>").send);
+        assert!(thread_traits("rusty::SmallVec<int, 8>").send);
+
+        // RefCell moves but does not share; a Mutex makes it shareable
+        assert!(thread_traits("rust::RefCell<int>").send);
+        assert!(!thread_traits("rust::RefCell<int> &").send);
+        assert!(!thread_traits("rusty::Arc<rust::RefCell<int>>").send);
+        assert!(thread_traits("rusty::Arc<rusty::Mutex<rust::RefCell<int>>>").send);
+        assert!(thread_traits("Cell<int>").send && !thread_traits("Cell<int>").sync);
+        assert!(!thread_traits("rusty::mpsc::Receiver<int> &").send);
+        assert!(thread_traits("rusty::mpsc::Receiver<int>").send);
+    }
+
+    #[test]
+    fn test_rc_captured_by_spawned_closure() {
+        let body = vec![
+            Statement::VariableDecl(variable("local", "rusty::Rc<int>")),
+            call("spawn", vec![lambda(&["local", "shared"], vec![])], 12),
+        ];
+        let errors = check_parsed_function_for_send(&function(body));
+        assert_eq!(errors.len(), 1);
+        assert!(errors[0].contains("'local'") && errors[0].contains("not Send"));
+        assert!(errors[0].contains("line 12"));
+    }
+
+    #[test]
+    fn test_spawn_inside_scope_closure() {
+        // thread::scope([&](Scope& s) { s.spawn([&] { use(rc); }); });
+        let inner = call("spawn", vec![lambda(&["rc"], vec![])], 7);
+        let body = vec![
+            Statement::VariableDecl(variable("rc", "rusty::Rc<rusty::Vec<int>>")),
+            Statement::VariableDecl(variable("data", "rusty::Vec<int>")),
+            call("rusty::thread::scope", vec![lambda(&["rc", "data"], vec![inner])], 6),
+        ];
+        let errors = check_parsed_function_for_send(&function(body));
+        assert_eq!(errors.len(), 1, "scope itself runs on this thread: {:?}", errors);
+        assert!(errors[0].contains("line 7"));
+    }
+
+    #[test]
+    fn test_arc_and_borrowed_data_allowed() {
+        let body = vec![
+            Statement::VariableDecl(variable("data", "rusty::Vec<int>")),
+            Statement::VariableDecl(variable("cell", "rust::RefCell<int>")),
+            call("spawn", vec![lambda(&["data", "shared"], vec![])], 3),
+            call("spawn", vec![Expression::Move(Box::new(Expression::Variable("cell".to_string())))], 4),
+        ];
+        assert!(check_parsed_function_for_send(&function(body)).is_empty());
+    }
+
+    #[test]
+    fn test_refcell_captured_by_reference() {
+        // A copy of a RefCell may move to another thread; a reference to it
+        // may not, since both threads could then borrow it
+        let body = vec![
+            Statement::VariableDecl(variable("cell", "rust::RefCell<int>")),
+            Statement::VariableDecl(variable("data", "rusty::Vec<int>")),
+            call("spawn", vec![lambda(&["cell"], vec![])], 3),
+            call("spawn", vec![captured(&["cell", "data"], CaptureKind::ByRef, vec![])], 4),
+        ];
+        let errors = check_parsed_function_for_send(&function(body));
+        assert_eq!(errors.len(), 1, "{:?}", errors);
+        assert!(errors[0].contains("'cell'") && errors[0].contains("not Sync"));
+        assert!(errors[0].contains("line 4"));
+    }
+
+    #[test]
+    fn test_rc_argument_and_stored_closure() {
+        let body = vec![
+            Statement::VariableDecl(variable("rc", "rusty::Rc<int>")),
+            Statement::VariableDecl(variable("task", "(lambda at test.cpp:3:17)")),
+            Statement::Assignment {
+                lhs: "task".to_string(),
+                rhs: lambda(&["rc"], vec![]),
+                location: location(3),
+            },
+            call("join", vec![Expression::Variable("task".to_string()), lambda(&[], vec![])], 4),
+            call("thread", vec![Expression::Variable("rc".to_string())], 5),
+            call("push", vec![Expression::Variable("rc".to_string())], 6),
+        ];
+        let errors = check_parsed_function_for_send(&function(body));
+        assert_eq!(errors.len(), 2, "{:?}", errors);
+        assert!(errors[0].contains("captured by a closure passed to 'join'"));
+        assert!(errors[1].contains("passed to 'thread'"));
+    }
+}
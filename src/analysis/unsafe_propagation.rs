@@ -1,4 +1,5 @@
 use crate::parser::{Function, Statement, Expression};
+use crate::parser::bounds::UNCHECKED_METHODS;
 use crate::parser::safety_annotations::SafetyContext;
 use std::collections::HashSet;
 
@@ -145,6 +146,12 @@ fn is_function_safe(
     safety_context: &SafetyContext,
     known_safe_functions: &HashSet<String>,
 ) -> bool {
+    // get_unchecked is @unsafe, but analysis::bounds decides each call on
+    // whether its index is proven in range
+    if UNCHECKED_METHODS.contains(&func_name) {
+        return true;
+    }
+    
     // Check if it's explicitly marked as safe
     // Only functions with explicit @safe annotation are considered safe
     if known_safe_functions.contains(func_name) {
@@ -248,6 +255,25 @@ mod tests {
         assert!(error.is_none(), "Known safe function should be allowed");
     }
     
+    #[test]
+    fn test_unchecked_access_left_to_bounds_check() {
+        let stmt = Statement::FunctionCall {
+            name: "get_unchecked".to_string(),
+            args: vec![Expression::Variable("i".to_string())],
+            location: SourceLocation {
+                file: "test.cpp".to_string(),
+                line: 12,
+                column: 5,
+            },
+        };
+        
+        let safety_context = SafetyContext::new();
+        let known_safe = HashSet::new();
+        
+        let error = check_statement_for_unsafe_calls(&stmt, &safety_context, &known_safe);
+        assert!(error.is_none(), "get_unchecked is checked by analysis::bounds");
+    }
+    
     #[test]
     fn test_unsafe_call_in_expression() {
         let stmt = Statement::Assignment {
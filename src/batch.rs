@@ -0,0 +1,276 @@
+use rayon::prelude::*;
+use std::path::{Path, PathBuf};
+use std::process::Command;
+
+/// One translation unit from compile_commands.json, with the include paths,
+/// defines and language standard of its compile command
+#[derive(Debug, Clone, PartialEq)]
+pub struct CompileCommand {
+    pub directory: PathBuf,
+    pub file: PathBuf,
+    pub include_paths: Vec<PathBuf>,
+    pub defines: Vec<String>,
+    /// The value of the last -std= flag
+    pub std: Option<String>,
+}
+
+/// The outcome of checking one translation unit
+#[derive(Debug)]
+pub struct UnitResult {
+    pub file: PathBuf,
+    pub outcome: Result<Vec<String>, String>,
+    /// The unit's "time_report", with --time-report
+    pub time_report: Option<serde_json::Value>,
+}
+
+/// Parse one entry; it may give its command line as "arguments" (an array)
+/// or "command" (a string split on whitespace). Relative paths are resolved
+/// against "directory".
+pub fn parse_compile_command(entry: &serde_json::Value) -> Option<CompileCommand> {
+    let directory = PathBuf::from(entry.get("directory").and_then(|d| d.as_str()).unwrap_or("."));
+    let file = directory.join(entry.get("file")?.as_str()?);
+
+    let words: Vec<String> = if let Some(arguments) = entry.get("arguments").and_then(|a| a.as_array()) {
+        arguments.iter().filter_map(|a| a.as_str()).map(|a| a.to_string()).collect()
+    } else {
+        let command = entry.get("command").and_then(|c| c.as_str()).unwrap_or("");
+        command.split_whitespace().map(|w| w.to_string()).collect()
+    };
+
+    let mut include_paths = Vec::new();
+    let mut defines = Vec::new();
+    let mut std = None;
+    let mut i = 0;
+    while i < words.len() {
+        let word = &words[i];
+        if let Some(value) = word.strip_prefix("-std=") {
+            std = Some(value.to_string());
+            i += 1;
+            continue;
+        }
+        let (flag, value) = if (word == "-I" || word == "-D") && i + 1 < words.len() {
+            i += 1;
+            (word.as_str(), words[i].as_str())
+        } else if word.len() > 2 && (word.starts_with("-I") || word.starts_with("-D")) {
+            (&word[..2], &word[2..])
+        } else {
+            i += 1;
+            continue;
+        };
+        if flag == "-I" {
+            include_paths.push(directory.join(value));
+        } else {
+            defines.push(value.to_string());
+        }
+        i += 1;
+    }
+
+    Some(CompileCommand { directory, file, include_paths, defines, std })
+}
+
+/// Check every unit on a pool of `jobs` threads, passing on the per-file
+/// options of `args`. libclang (through the clang crate) allows one Clang
+/// instance per process, so each unit is parsed and checked by a child
+/// checker process; the pool bounds how many run at once. Results come back
+/// in the order of `commands`.
+pub fn check_units(commands: &[CompileCommand], args: &crate::Args, jobs: usize) -> Result<Vec<UnitResult>, String> {
+    let exe = std::env::current_exe()
+        .map_err(|e| format!("Failed to find the checker executable: {}", e))?;
+    // Units run in their own directories, so pass shared files by absolute
+    // path
+    let cwd = std::env::current_dir().map_err(|e| e.to_string())?;
+    let header_cache = args.header_cache.as_ref().map(|path| cwd.join(path));
+    let pch = args.pch.as_ref().map(|path| cwd.join(path));
+    let pool = rayon::ThreadPoolBuilder::new()
+        .num_threads(jobs)
+        .build()
+        .map_err(|e| format!("Failed to start thread pool: {}", e))?;
+
+    Ok(pool.install(|| {
+        commands
+            .par_iter()
+            .map(|command| {
+                let mut child = Command::new(&exe);
+                child.current_dir(&command.directory).arg(&command.file);
+                for path in args.include_paths.iter().chain(&command.include_paths) {
+                    child.arg("-I").arg(path);
+                }
+                for define in args.defines.iter().chain(&command.defines) {
+                    child.arg("-D").arg(define);
+                }
+                if let Some(std) = args.std.as_ref().or(command.std.as_ref()) {
+                    child.arg(format!("--std={}", std));
+                }
+                if let Some(path) = &header_cache {
+                    child.arg("--header-cache").arg(path);
+                }
+                if let Some(path) = &pch {
+                    child.arg("--pch").arg(path);
+                }
+                if args.incremental {
+                    child.arg("--incremental");
+                }
+                if let Some(n) = args.time_report {
+                    child.arg(format!("--time-report={}", n));
+                }
+                // The pool already keeps every core busy
+                child.args(["--jobs", "1", "--format", "json"]);
+
+                let (outcome, time_report) = match child.output() {
+                    Ok(output) => {
+                        let stdout = String::from_utf8_lossy(&output.stdout);
+                        (parse_unit_report(&stdout), parse_unit_time_report(&stdout))
+                    }
+                    Err(e) => (Err(format!("Failed to run checker: {}", e)), None),
+                };
+                UnitResult { file: command.file.clone(), outcome, time_report }
+            })
+            .collect()
+    }))
+}
+
+/// The name of the stamp --stamp-dir keeps for `file`: its absolute path
+/// with every byte other than an ASCII letter, digit, '_', '.' or '-'
+/// replaced by '_'. CppBorrowChecker.cmake derives the same names.
+pub fn stamp_name(file: &Path) -> String {
+    let path = crate::compile_db::absolute(file);
+    let name: String = path
+        .to_string_lossy()
+        .bytes()
+        .map(|b| if b.is_ascii_alphanumeric() || b"_.-".contains(&b) { b as char } else { '_' })
+        .collect();
+    format!("{}.stamp", name)
+}
+
+/// Touch the stamp of every unit in `results` without violations, and
+/// remove the stamps of the others, so they are checked again
+pub fn touch_stamps(dir: &Path, results: &[UnitResult]) -> Result<(), String> {
+    std::fs::create_dir_all(dir).map_err(|e| format!("Failed to create {}: {}", dir.display(), e))?;
+    for result in results {
+        let stamp = dir.join(stamp_name(&result.file));
+        if matches!(&result.outcome, Ok(violations) if violations.is_empty()) {
+            // Rewriting the file updates its modification time
+            std::fs::write(&stamp, b"")
+        } else {
+            std::fs::remove_file(&stamp).or_else(|e| if e.kind() == std::io::ErrorKind::NotFound { Ok(()) } else { Err(e) })
+        }
+        .map_err(|e| format!("Failed to update {}: {}", stamp.display(), e))?;
+    }
+    Ok(())
+}
+
+/// Read the JSON report a checker run with --format json prints last
+pub fn parse_unit_report(stdout: &str) -> Result<Vec<String>, String> {
+    let report = report_line(stdout)
+        .ok_or_else(|| "Checker produced no report".to_string())?;
+    let report: serde_json::Value = serde_json::from_str(report)
+        .map_err(|e| format!("Unreadable checker report: {}", e))?;
+    if let Some(error) = report.get("error").and_then(|e| e.as_str()) {
+        return Err(error.to_string());
+    }
+    let violations = report
+        .get("violations")
+        .and_then(|v| v.as_array())
+        .ok_or_else(|| "Checker report has no violations list".to_string())?;
+    Ok(violations.iter().filter_map(|v| v.as_str()).map(|v| v.to_string()).collect())
+}
+
+/// The "time_report" of a report read by `parse_unit_report`
+pub fn parse_unit_time_report(stdout: &str) -> Option<serde_json::Value> {
+    let mut report: serde_json::Value = serde_json::from_str(report_line(stdout)?).ok()?;
+    report.get_mut("time_report").map(|t| t.take())
+}
+
+fn report_line(stdout: &str) -> Option<&str> {
+    stdout.lines().rev().find(|l| l.starts_with('{'))
+}
+
+/// The one-line report --format json prints for a single file
+pub fn unit_report_json(file: &Path, outcome: &Result<Vec<String>, String>, time_report: Option<&serde_json::Value>) -> String {
+    let mut report = match outcome {
+        Ok(violations) => serde_json::json!({ "file": file.display().to_string(), "violations": violations }),
+        Err(error) => serde_json::json!({ "file": file.display().to_string(), "error": error }),
+    };
+    if let Some(time_report) = time_report {
+        report["time_report"] = time_report.clone();
+    }
+    report.to_string()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_parse_command_string() {
+        let entry = serde_json::json!({
+            "directory": "/build",
+            "file": "../src/a.cpp",
+            "command": "clang++ -std=c++14 -I/abs/include -Iinclude -I third_party -DNDEBUG -D LEVEL=2 -std=c++20 -c ../src/a.cpp"
+        });
+        let command = parse_compile_command(&entry).unwrap();
+        assert_eq!(command.file, PathBuf::from("/build/../src/a.cpp"));
+        assert_eq!(command.include_paths, vec![
+            PathBuf::from("/abs/include"),
+            PathBuf::from("/build/include"),
+            PathBuf::from("/build/third_party"),
+        ]);
+        assert_eq!(command.defines, vec!["NDEBUG".to_string(), "LEVEL=2".to_string()]);
+        assert_eq!(command.std.as_deref(), Some("c++20"));
+    }
+
+    #[test]
+    fn test_parse_arguments_array() {
+        let entry = serde_json::json!({
+            "directory": "/build",
+            "file": "/src/b.cpp",
+            "arguments": ["g++", "-I", "/src/with space", "-DNAME=\"x y\"", "/src/b.cpp"]
+        });
+        let command = parse_compile_command(&entry).unwrap();
+        assert_eq!(command.file, PathBuf::from("/src/b.cpp"));
+        assert_eq!(command.include_paths, vec![PathBuf::from("/src/with space")]);
+        assert_eq!(command.defines, vec!["NAME=\"x y\"".to_string()]);
+        assert_eq!(command.std, None);
+    }
+
+    #[test]
+    fn test_entry_without_file_is_skipped() {
+        assert!(parse_compile_command(&serde_json::json!({ "directory": "/build" })).is_none());
+    }
+
+    #[test]
+    fn test_stamps() {
+        assert_eq!(stamp_name(Path::new("/src/my lib/a.cpp")), "_src_my_lib_a.cpp.stamp");
+        assert_eq!(stamp_name(Path::new("/src/x/../a.cpp")), "_src_a.cpp.stamp");
+
+        let dir = tempfile::tempdir().unwrap();
+        let unit = |file: &str, outcome| UnitResult { file: PathBuf::from(file), outcome, time_report: None };
+        let clean = dir.path().join(stamp_name(Path::new("/src/a.cpp")));
+        let failing = dir.path().join(stamp_name(Path::new("/src/b.cpp")));
+        std::fs::write(&failing, b"").unwrap();
+        touch_stamps(dir.path(), &[
+            unit("/src/a.cpp", Ok(vec![])),
+            unit("/src/b.cpp", Ok(vec!["violation".to_string()])),
+            unit("/src/c.cpp", Err("parse error".to_string())),
+        ]).unwrap();
+        assert!(clean.exists());
+        assert!(!failing.exists());
+    }
+
+    #[test]
+    fn test_unit_report_round_trip() {
+        let file = Path::new("a.cpp");
+        let violations = vec!["In function 'f': use after move".to_string()];
+        let stdout = format!("DEBUG noise\n{}\n", unit_report_json(file, &Ok(violations.clone()), None));
+        assert_eq!(parse_unit_report(&stdout), Ok(violations));
+        assert_eq!(parse_unit_time_report(&stdout), None);
+
+        let timed = unit_report_json(file, &Ok(vec![]), Some(&serde_json::json!({ "wall_ms": 1.5 })));
+        assert_eq!(parse_unit_report(&timed), Ok(vec![]));
+        assert_eq!(parse_unit_time_report(&timed).unwrap()["wall_ms"], 1.5);
+
+        let failed = unit_report_json(file, &Err("Fatal parsing errors encountered".to_string()), None);
+        assert_eq!(parse_unit_report(&failed), Err("Fatal parsing errors encountered".to_string()));
+        assert!(parse_unit_report("Segmentation fault").is_err());
+    }
+}
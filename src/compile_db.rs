@@ -0,0 +1,256 @@
+use std::collections::HashMap;
+use std::ffi::OsString;
+use std::fs;
+use std::io::{BufReader, BufWriter, Read};
+use std::path::{Component, Path, PathBuf};
+use std::time::UNIX_EPOCH;
+
+use crate::batch::{parse_compile_command, CompileCommand};
+use crate::parser::{signature_store::content_hash, CACHE_DIR};
+
+/// Bumped whenever the cached index changes shape
+const INDEX_VERSION: u64 = 1;
+
+/// The compile commands of a compile_commands.json, indexed by source file.
+///
+/// The database is read as a stream, one entry at a time, keeping only
+/// the flags the checker uses, so memory follows the number of files
+/// rather than the size of the JSON. The index is cached in CACHE_DIR and
+/// reused for as long as the database is unchanged.
+#[derive(Debug, Default)]
+pub struct CompileDb {
+    commands: Vec<CompileCommand>,
+    /// The normalized absolute path of each command's file
+    paths: Vec<PathBuf>,
+    by_path: HashMap<PathBuf, usize>,
+    /// Commands by file name, for files named by a partial path
+    by_name: HashMap<OsString, Vec<usize>>,
+}
+
+impl CompileDb {
+    /// Load the database at `path`, from the cached index when it is up to
+    /// date
+    pub fn load(path: &Path) -> Result<Self, String> {
+        let metadata = fs::metadata(path)
+            .map_err(|e| format!("Failed to read compile_commands.json: {}", e))?;
+        let stamp = serde_json::json!([
+            INDEX_VERSION,
+            metadata.len(),
+            metadata.modified().ok().and_then(|m| m.duration_since(UNIX_EPOCH).ok()).map(|d| d.as_nanos() as u64),
+        ]);
+        let cache_path = index_path(path);
+        if let Some(db) = Self::load_index(&cache_path, &stamp) {
+            debug_trace!("DEBUG: compile commands from {}", cache_path.display());
+            return Ok(db);
+        }
+
+        let file = fs::File::open(path)
+            .map_err(|e| format!("Failed to read compile_commands.json: {}", e))?;
+        let db = Self::parse(BufReader::with_capacity(1 << 20, file))?;
+        if let Err(e) = db.save_index(&cache_path, stamp) {
+            debug_trace!("DEBUG: compile command index not saved: {}", e);
+        }
+        Ok(db)
+    }
+
+    /// Read a compile_commands.json from `reader`. A file listed more than
+    /// once keeps its first command.
+    pub fn parse(reader: impl Read) -> Result<Self, String> {
+        let mut db = CompileDb::default();
+        let mut deserializer = serde_json::Deserializer::from_reader(reader);
+        serde::Deserializer::deserialize_seq(&mut deserializer, Entries(&mut |command| db.insert(command)))
+            .and_then(|_| deserializer.end())
+            .map_err(|e| format!("Failed to parse compile_commands.json: {}", e))?;
+        Ok(db)
+    }
+
+    /// Every command, in database order
+    pub fn into_commands(self) -> Vec<CompileCommand> {
+        self.commands
+    }
+
+    /// The command compiling `file`: the one for exactly this file, or else
+    /// one whose path ends with it (or that it ends with)
+    pub fn lookup(&self, file: &Path) -> Option<&CompileCommand> {
+        if let Some(&i) = self.by_path.get(&absolute(file)) {
+            return Some(&self.commands[i]);
+        }
+        let file = normalize(file);
+        self.by_name
+            .get(file.file_name()?)?
+            .iter()
+            .find(|&&i| self.paths[i].ends_with(&file) || file.ends_with(&self.paths[i]))
+            .map(|&i| &self.commands[i])
+    }
+
+    fn insert(&mut self, command: CompileCommand) {
+        let path = absolute(&command.file);
+        if self.by_path.contains_key(&path) {
+            return;
+        }
+        let i = self.commands.len();
+        if let Some(name) = path.file_name() {
+            self.by_name.entry(name.to_os_string()).or_default().push(i);
+        }
+        self.by_path.insert(path.clone(), i);
+        self.paths.push(path);
+        self.commands.push(command);
+    }
+
+    fn load_index(cache_path: &Path, stamp: &serde_json::Value) -> Option<Self> {
+        let file = fs::File::open(cache_path).ok()?;
+        let index: serde_json::Value = serde_json::from_reader(BufReader::new(file)).ok()?;
+        if &index["stamp"] != stamp {
+            return None;
+        }
+        let strings = |value: &serde_json::Value| -> Option<Vec<String>> {
+            value.as_array()?.iter().map(|s| s.as_str().map(str::to_string)).collect()
+        };
+        let mut db = CompileDb::default();
+        for entry in index["commands"].as_array()? {
+            db.insert(CompileCommand {
+                directory: PathBuf::from(entry[0].as_str()?),
+                file: PathBuf::from(entry[1].as_str()?),
+                include_paths: strings(&entry[2])?.into_iter().map(PathBuf::from).collect(),
+                defines: strings(&entry[3])?,
+                std: entry[4].as_str().map(str::to_string),
+            });
+        }
+        Some(db)
+    }
+
+    fn save_index(&self, cache_path: &Path, stamp: serde_json::Value) -> Result<(), String> {
+        let commands: Vec<_> = self
+            .commands
+            .iter()
+            .map(|c| serde_json::json!([
+                c.directory.to_string_lossy(),
+                c.file.to_string_lossy(),
+                c.include_paths.iter().map(|p| p.to_string_lossy()).collect::<Vec<_>>(),
+                c.defines,
+                c.std,
+            ]))
+            .collect();
+        if let Some(dir) = cache_path.parent() {
+            fs::create_dir_all(dir).map_err(|e| e.to_string())?;
+        }
+        // Checkers running in parallel may write the same index; each
+        // writes its own and renames it into place
+        let tmp = cache_path.with_extension(format!("tmp{}", std::process::id()));
+        let file = fs::File::create(&tmp).map_err(|e| e.to_string())?;
+        serde_json::to_writer(BufWriter::new(file), &serde_json::json!({ "stamp": stamp, "commands": commands }))
+            .map_err(|e| e.to_string())?;
+        fs::rename(&tmp, cache_path).map_err(|e| e.to_string())
+    }
+}
+
+/// Where the index of the database at `path` is cached
+fn index_path(path: &Path) -> PathBuf {
+    let path = fs::canonicalize(path).unwrap_or_else(|_| absolute(path));
+    let key = content_hash(path.to_string_lossy().as_bytes());
+    Path::new(CACHE_DIR).join(format!("compile-db-{:016x}.json", key))
+}
+
+/// Hands each entry of a JSON array to a callback as it is read, so the
+/// array is never held in memory
+struct Entries<'a>(&'a mut dyn FnMut(CompileCommand));
+
+impl<'de, 'a> serde::de::Visitor<'de> for Entries<'a> {
+    type Value = ();
+
+    fn expecting(&self, formatter: &mut std::fmt::Formatter) -> std::fmt::Result {
+        formatter.write_str("an array of compile commands")
+    }
+
+    fn visit_seq<A: serde::de::SeqAccess<'de>>(self, mut seq: A) -> Result<(), A::Error> {
+        while let Some(entry) = seq.next_element::<serde_json::Value>()? {
+            if let Some(command) = parse_compile_command(&entry) {
+                (self.0)(command);
+            }
+        }
+        Ok(())
+    }
+}
+
+/// `path` made absolute against the working directory, and normalized
+pub fn absolute(path: &Path) -> PathBuf {
+    if path.is_absolute() {
+        return normalize(path);
+    }
+    match std::env::current_dir() {
+        Ok(cwd) => normalize(&cwd.join(path)),
+        Err(_) => normalize(path),
+    }
+}
+
+/// `path` without "." components, and with each ".." removing the
+/// component before it
+fn normalize(path: &Path) -> PathBuf {
+    let mut normalized = PathBuf::new();
+    for component in path.components() {
+        match component {
+            Component::CurDir => {}
+            Component::ParentDir => {
+                if !normalized.pop() {
+                    normalized.push("..");
+                }
+            }
+            component => normalized.push(component),
+        }
+    }
+    normalized
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const DATABASE: &str = r#"[
+        {"directory": "/build", "file": "../src/a.cpp", "command": "c++ -Iinc -DA=1 -std=c++20 -c ../src/a.cpp"},
+        {"directory": "/build", "file": "/src/lib/b.cpp", "arguments": ["c++", "-I", "/src/lib", "/src/lib/b.cpp"]},
+        {"directory": "/build", "file": "/src/a.cpp", "command": "c++ -DSECOND"},
+        {"directory": "/build"}
+    ]"#;
+
+    #[test]
+    fn test_lookup_by_path_and_suffix() {
+        let db = CompileDb::parse(DATABASE.as_bytes()).unwrap();
+        let a = db.lookup(Path::new("/src/a.cpp")).unwrap();
+        assert_eq!(a.defines, vec!["A=1".to_string()]); // The first command wins
+        assert_eq!(a.include_paths, vec![PathBuf::from("/build/inc")]);
+        assert_eq!(a.std.as_deref(), Some("c++20"));
+
+        let b = db.lookup(Path::new("lib/b.cpp")).unwrap();
+        assert_eq!(b.include_paths, vec![PathBuf::from("/src/lib")]);
+        assert_eq!(b.std, None);
+        assert!(db.lookup(Path::new("other/b.cpp")).is_none());
+        assert_eq!(db.into_commands().len(), 2);
+    }
+
+    #[test]
+    fn test_malformed_database() {
+        assert!(CompileDb::parse("{}".as_bytes()).unwrap_err().starts_with("Failed to parse"));
+        assert!(CompileDb::parse("[{} ".as_bytes()).is_err());
+        assert!(CompileDb::parse("[] []".as_bytes()).is_err());
+    }
+
+    #[test]
+    fn test_index_round_trip() {
+        let dir = tempfile::tempdir().unwrap();
+        let cache_path = dir.path().join("index.json");
+        let db = CompileDb::parse(DATABASE.as_bytes()).unwrap();
+        let stamp = serde_json::json!([INDEX_VERSION, 1, 2]);
+        db.save_index(&cache_path, stamp.clone()).unwrap();
+
+        let loaded = CompileDb::load_index(&cache_path, &stamp).unwrap();
+        assert_eq!(loaded.commands, db.commands);
+        assert!(loaded.lookup(Path::new("/src/lib/b.cpp")).is_some());
+        assert!(CompileDb::load_index(&cache_path, &serde_json::json!([INDEX_VERSION, 1, 3])).is_none());
+    }
+
+    #[test]
+    fn test_normalize() {
+        assert_eq!(normalize(Path::new("/build/../src/./a.cpp")), PathBuf::from("/src/a.cpp"));
+        assert_eq!(normalize(Path::new("../a.cpp")), PathBuf::from("../a.cpp"));
+    }
+}
@@ -0,0 +1,175 @@
+use std::collections::HashMap;
+use std::fs;
+use std::path::{Path, PathBuf};
+
+use crate::analysis::FunctionDiagnostics;
+use crate::parser::safety_annotations::SafetyContext;
+use crate::parser::signature_store::{content_hash, put_str, put_u32, put_u64, Reader};
+use crate::parser::{Function, HeaderCache};
+
+const MAGIC: &[u8; 4] = b"RCIN";
+const VERSION: u32 = 1;
+
+/// The state file of `source`, in the checker's cache directory
+pub fn state_path(source: &Path) -> PathBuf {
+    let source = fs::canonicalize(source).unwrap_or_else(|_| source.to_path_buf());
+    let stem = source.file_name().map(|n| n.to_string_lossy().to_string()).unwrap_or_default();
+    let hash = content_hash(source.to_string_lossy().as_bytes());
+    PathBuf::from(crate::parser::CACHE_DIR).join(format!("{}-{:016x}.bin", stem, hash))
+}
+
+/// A hash of everything outside a function its diagnostics depend on: the
+/// checker version, the file's safety annotations (which decide whether each
+/// callee may be called from safe code), the header signatures of callees,
+/// and whether the program is checked at all. Any change re-checks every
+/// function.
+pub fn environment_fingerprint(safety_context: &SafetyContext, header_cache: &HeaderCache, check_program: bool) -> u64 {
+    let text = format!(
+        "{}\n{:?}\n{:016x}\n{}",
+        env!("CARGO_PKG_VERSION"),
+        safety_context,
+        header_cache.fingerprint(),
+        check_program
+    );
+    content_hash(text.as_bytes())
+}
+
+/// A hash of one function's parsed body, signature and location. Its IR is
+/// built from these alone, so it is the IR's hash too; IrFunction itself
+/// keeps variables in a HashMap, whose order changes from run to run.
+pub fn function_fingerprint(function: &Function, safe: bool, environment: u64) -> u64 {
+    content_hash(format!("{:016x}\n{}\n{:?}", environment, safe, function).as_bytes())
+}
+
+/// The diagnostics of each function in the last run, by fingerprint
+#[derive(Debug, Default)]
+pub struct IncrementalState {
+    functions: HashMap<u64, FunctionDiagnostics>,
+}
+
+impl IncrementalState {
+    /// Read the state at `path`. A missing, unreadable or outdated file
+    /// gives an empty state, so every function is checked.
+    pub fn load(path: &Path) -> Self {
+        let functions = fs::read(path).ok().and_then(|bytes| decode(&bytes)).unwrap_or_default();
+        IncrementalState { functions }
+    }
+
+    /// A state holding `functions`, as `save` writes them
+    pub fn from_functions(functions: &[(u64, &FunctionDiagnostics)]) -> Self {
+        let functions = functions.iter().map(|(fingerprint, d)| (*fingerprint, (*d).clone())).collect();
+        IncrementalState { functions }
+    }
+
+    /// The diagnostics last found for a function with this fingerprint
+    pub fn get(&self, fingerprint: u64) -> Option<&FunctionDiagnostics> {
+        self.functions.get(&fingerprint)
+    }
+
+    /// Replace the state at `path` with this run's functions
+    pub fn save(path: &Path, functions: &[(u64, &FunctionDiagnostics)]) -> Result<(), String> {
+        let write = || -> std::io::Result<()> {
+            if let Some(dir) = path.parent() {
+                fs::create_dir_all(dir)?;
+            }
+            let tmp = path.with_extension(format!("tmp{}", std::process::id()));
+            fs::write(&tmp, encode(functions))?;
+            fs::rename(&tmp, path)
+        };
+        write().map_err(|e| format!("Failed to write incremental state {}: {}", path.display(), e))
+    }
+}
+
+fn encode(functions: &[(u64, &FunctionDiagnostics)]) -> Vec<u8> {
+    let mut out = Vec::new();
+    out.extend_from_slice(MAGIC);
+    put_u32(&mut out, VERSION);
+    put_u32(&mut out, functions.len() as u32);
+    for (fingerprint, diagnostics) in functions {
+        put_u64(&mut out, *fingerprint);
+        for group in diagnostics.groups() {
+            put_u32(&mut out, group.len() as u32);
+            for diagnostic in group {
+                put_str(&mut out, diagnostic);
+            }
+        }
+    }
+    out
+}
+
+fn decode(bytes: &[u8]) -> Option<HashMap<u64, FunctionDiagnostics>> {
+    let mut r = Reader::new(bytes);
+    if r.take(4)? != MAGIC || r.u32()? != VERSION {
+        return None;
+    }
+    let mut functions = HashMap::new();
+    for _ in 0..r.u32()? {
+        let fingerprint = r.u64()?;
+        let mut groups = Vec::new();
+        for _ in 0..5 {
+            let mut group = Vec::new();
+            for _ in 0..r.u32()? {
+                group.push(r.string()?);
+            }
+            groups.push(group);
+        }
+        functions.insert(fingerprint, FunctionDiagnostics::from_groups(groups)?);
+    }
+    if !r.at_end() {
+        return None;
+    }
+    Some(functions)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::parser::SourceLocation;
+    use tempfile::TempDir;
+
+    fn function(name: &str, line: u32) -> Function {
+        Function {
+            name: name.to_string(),
+            parameters: vec![],
+            return_type: "void".to_string(),
+            body: vec![],
+            location: SourceLocation {
+                file: "test.cpp".to_string(),
+                line,
+                column: 1,
+            },
+            unchecked_accesses: vec![],
+        }
+    }
+
+    #[test]
+    fn test_state_round_trip() {
+        let dir = TempDir::new().unwrap();
+        let path = dir.path().join("nested").join("state.bin");
+        let diagnostics = FunctionDiagnostics {
+            borrows: vec!["In function 'f': Use after move".to_string()],
+            scoped_lifetimes: vec!["a".to_string(), "b".to_string()],
+            ..FunctionDiagnostics::default()
+        };
+        let clean = FunctionDiagnostics::default();
+        IncrementalState::save(&path, &[(1, &diagnostics), (2, &clean)]).unwrap();
+
+        let state = IncrementalState::load(&path);
+        assert_eq!(state.get(1), Some(&diagnostics));
+        assert_eq!(state.get(2), Some(&clean));
+        assert_eq!(state.get(3), None);
+
+        fs::write(&path, b"RCIN\x01\x00\x00\x00\x01").unwrap();
+        assert_eq!(IncrementalState::load(&path).get(1), None);
+    }
+
+    #[test]
+    fn test_function_fingerprint() {
+        let f = function("f", 3);
+        assert_eq!(function_fingerprint(&f, true, 7), function_fingerprint(&f.clone(), true, 7));
+        assert_ne!(function_fingerprint(&f, true, 7), function_fingerprint(&f, false, 7));
+        assert_ne!(function_fingerprint(&f, true, 7), function_fingerprint(&f, true, 8));
+        // Diagnostics carry line numbers, so a moved function is re-checked
+        assert_ne!(function_fingerprint(&f, true, 7), function_fingerprint(&function("f", 4), true, 7));
+    }
+}
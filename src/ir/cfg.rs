@@ -0,0 +1,267 @@
+use super::IrStatement;
+
+/// A block exit: the index of the block it leads to
+pub type BlockId = usize;
+
+/// The control flow graph of a statement list, for dataflow analysis.
+///
+/// The IR keeps a function body as one list, with conditionals nested in
+/// `If` statements and loops delimited by `EnterLoop`/`ExitLoop` markers.
+/// This splits the list into basic blocks with an edge for every branch,
+/// loop back edge, loop exit and early return. Block 0 is the entry and
+/// block 1 the exit; blocks after a return are unreachable.
+#[derive(Debug)]
+pub struct Cfg<'a> {
+    pub blocks: Vec<Block<'a>>,
+    pub loops: Vec<Loop>,
+}
+
+#[derive(Debug, Default)]
+pub struct Block<'a> {
+    /// Straight-line statements; never `If` or loop markers
+    pub statements: Vec<&'a IrStatement>,
+    pub successors: Vec<BlockId>,
+    pub predecessors: Vec<BlockId>,
+    /// Unsafe blocks open when this block starts
+    pub unsafe_depth: usize,
+}
+
+/// A loop: its header, the block ending its body (the source of the back
+/// edge), and every block of its body, nested loops included
+#[derive(Debug)]
+pub struct Loop {
+    pub header: BlockId,
+    pub latch: BlockId,
+    pub body: Vec<BlockId>,
+}
+
+pub const ENTRY: BlockId = 0;
+pub const EXIT: BlockId = 1;
+
+impl<'a> Cfg<'a> {
+    pub fn build(statements: &'a [IrStatement]) -> Self {
+        let mut builder = Builder {
+            cfg: Cfg { blocks: Vec::new(), loops: Vec::new() },
+            current: ENTRY,
+            unsafe_depth: 0,
+        };
+        builder.new_block();
+        builder.new_block();
+        builder.lower(statements);
+        builder.edge(builder.current, EXIT);
+        builder.cfg
+    }
+
+    /// Blocks reachable from `start` without leaving `within`, in reverse
+    /// postorder
+    pub fn reverse_postorder(&self, start: BlockId, within: &[bool]) -> Vec<BlockId> {
+        let mut visited = vec![false; self.blocks.len()];
+        let mut order = Vec::new();
+        // Iterative DFS: (block, index of the next successor to visit)
+        let mut stack = vec![(start, 0)];
+        visited[start] = true;
+        while let Some((block, next)) = stack.pop() {
+            match self.blocks[block].successors.get(next) {
+                Some(&succ) => {
+                    stack.push((block, next + 1));
+                    if within[succ] && !visited[succ] {
+                        visited[succ] = true;
+                        stack.push((succ, 0));
+                    }
+                }
+                None => order.push(block),
+            }
+        }
+        order.reverse();
+        order
+    }
+}
+
+struct Builder<'a> {
+    cfg: Cfg<'a>,
+    current: BlockId,
+    unsafe_depth: usize,
+}
+
+impl<'a> Builder<'a> {
+    fn new_block(&mut self) -> BlockId {
+        self.cfg.blocks.push(Block { unsafe_depth: self.unsafe_depth, ..Block::default() });
+        self.cfg.blocks.len() - 1
+    }
+
+    fn edge(&mut self, from: BlockId, to: BlockId) {
+        self.cfg.blocks[from].successors.push(to);
+        self.cfg.blocks[to].predecessors.push(from);
+    }
+
+    /// Start a new block that `self.current` falls through to
+    fn begin_block(&mut self) -> BlockId {
+        let block = self.new_block();
+        self.edge(self.current, block);
+        self.current = block;
+        block
+    }
+
+    fn lower(&mut self, statements: &'a [IrStatement]) {
+        let mut i = 0;
+        while i < statements.len() {
+            match &statements[i] {
+                IrStatement::EnterLoop => {
+                    let end = matching_exit_loop(statements, i);
+                    // The header holds no statements: it branches to the
+                    // body and to the exit, so the body may run zero times
+                    let header = self.begin_block();
+                    self.begin_block();
+                    self.lower(&statements[i + 1..end]);
+                    let latch = self.current;
+                    self.edge(latch, header);
+                    let body = (header..self.cfg.blocks.len()).collect();
+                    self.cfg.loops.push(Loop { header, latch, body });
+                    let exit = self.new_block();
+                    self.edge(header, exit);
+                    self.current = exit;
+                    i = end + 1;
+                    continue;
+                }
+                IrStatement::If { then_branch, else_branch } => {
+                    let condition = self.current;
+                    self.begin_block();
+                    self.lower(then_branch);
+                    let then_end = self.current;
+                    let else_end = match else_branch {
+                        Some(else_branch) => {
+                            self.current = condition;
+                            self.begin_block();
+                            self.lower(else_branch);
+                            self.current
+                        }
+                        None => condition,
+                    };
+                    let join = self.new_block();
+                    self.edge(then_end, join);
+                    self.edge(else_end, join);
+                    self.current = join;
+                }
+                IrStatement::Return { .. } => {
+                    self.cfg.blocks[self.current].statements.push(&statements[i]);
+                    self.edge(self.current, EXIT);
+                    self.current = self.new_block();
+                }
+                IrStatement::EnterUnsafe => {
+                    self.cfg.blocks[self.current].statements.push(&statements[i]);
+                    self.unsafe_depth += 1;
+                }
+                IrStatement::ExitUnsafe => {
+                    self.cfg.blocks[self.current].statements.push(&statements[i]);
+                    self.unsafe_depth = self.unsafe_depth.saturating_sub(1);
+                }
+                // An ExitLoop without its EnterLoop ends nothing
+                IrStatement::ExitLoop => {}
+                statement => self.cfg.blocks[self.current].statements.push(statement),
+            }
+            i += 1;
+        }
+    }
+}
+
+/// The index of the ExitLoop closing the EnterLoop at `start`, or the end
+/// of the list if it is never closed
+fn matching_exit_loop(statements: &[IrStatement], start: usize) -> usize {
+    let mut depth = 0;
+    for (i, statement) in statements.iter().enumerate().skip(start) {
+        match statement {
+            IrStatement::EnterLoop => depth += 1,
+            IrStatement::ExitLoop => {
+                depth -= 1;
+                if depth == 0 {
+                    return i;
+                }
+            }
+            _ => {}
+        }
+    }
+    statements.len()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn moved(from: &str) -> IrStatement {
+        IrStatement::Move { from: from.to_string(), to: "_moved_".to_string() }
+    }
+
+    #[test]
+    fn test_loop_has_back_edge_and_exit() {
+        let statements = vec![moved("a"), IrStatement::EnterLoop, moved("b"), IrStatement::ExitLoop, moved("c")];
+        let cfg = Cfg::build(&statements);
+        assert_eq!(cfg.loops.len(), 1);
+        let lp = &cfg.loops[0];
+        assert!(cfg.blocks[lp.header].statements.is_empty());
+        assert_eq!(cfg.blocks[lp.header].successors.len(), 2);
+        assert_eq!(cfg.blocks[lp.header].successors[0], lp.latch);
+        assert_eq!(cfg.blocks[lp.latch].statements.len(), 1);
+        assert!(cfg.blocks[lp.latch].successors.contains(&lp.header));
+        assert_eq!(cfg.blocks[ENTRY].successors, vec![lp.header]);
+        let after = cfg.blocks[lp.header].successors[1];
+        assert!(!lp.body.contains(&after));
+        assert_eq!(cfg.blocks[after].statements.len(), 1);
+        assert_eq!(cfg.blocks[after].successors, vec![EXIT]);
+    }
+
+    #[test]
+    fn test_if_branches_join() {
+        let statements = vec![IrStatement::If {
+            then_branch: vec![moved("a")],
+            else_branch: Some(vec![moved("b"), IrStatement::Return { value: None }, moved("c")]),
+        }];
+        let cfg = Cfg::build(&statements);
+        assert_eq!(cfg.blocks[ENTRY].successors.len(), 2);
+        let all = vec![true; cfg.blocks.len()];
+        let reachable = cfg.reverse_postorder(ENTRY, &all);
+        // The statement after the return is unreachable
+        let dead = cfg.blocks.iter().position(|b| {
+            matches!(b.statements.first(), Some(IrStatement::Move { from, .. }) if from == "c")
+        }).unwrap();
+        assert!(!reachable.contains(&dead));
+        assert_eq!(reachable[0], ENTRY);
+        assert!(reachable.contains(&EXIT));
+    }
+
+    #[test]
+    fn test_nested_loop_body_includes_inner_loop() {
+        let statements = vec![
+            IrStatement::EnterLoop,
+            IrStatement::EnterLoop,
+            moved("a"),
+            IrStatement::ExitLoop,
+            IrStatement::ExitLoop,
+        ];
+        let cfg = Cfg::build(&statements);
+        assert_eq!(cfg.loops.len(), 2);
+        let (inner, outer) = (&cfg.loops[0], &cfg.loops[1]);
+        assert!(inner.body.iter().all(|b| outer.body.contains(b)));
+        assert!(outer.body.len() > inner.body.len());
+    }
+
+    #[test]
+    fn test_nested_loop_can_be_skipped() {
+        // Each header reaches its exit without running any body statement
+        let statements = vec![
+            IrStatement::EnterLoop,
+            moved("a"),
+            IrStatement::EnterLoop,
+            moved("b"),
+            IrStatement::ExitLoop,
+            IrStatement::ExitLoop,
+        ];
+        let cfg = Cfg::build(&statements);
+        let (inner, outer) = (&cfg.loops[0], &cfg.loops[1]);
+        for lp in [inner, outer] {
+            assert!(cfg.blocks[lp.header].statements.is_empty());
+            assert!(cfg.blocks[lp.header].successors.iter().any(|b| !lp.body.contains(b)));
+        }
+        // The outer latch is the inner exit, reached straight from the inner header
+        assert!(cfg.blocks[inner.header].successors.contains(&outer.latch));
+    }
+}
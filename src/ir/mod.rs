@@ -2,6 +2,8 @@ use crate::parser::CppAst;
 use petgraph::graph::{DiGraph, NodeIndex};
 use std::collections::HashMap;
 
+pub mod cfg;
+
 #[derive(Debug, Clone)]
 pub struct IrProgram {
     pub functions: Vec<IrFunction>,
@@ -340,10 +342,10 @@ fn convert_statement(
                     }
                 }
                 crate::parser::Expression::Move(inner) => {
-                    eprintln!("DEBUG IR: Processing Move expression in assignment");
+                    debug_trace!("DEBUG IR: Processing Move expression in assignment");
                     // This is an explicit std::move call
                     if let crate::parser::Expression::Variable(var) = inner.as_ref() {
-                        eprintln!("DEBUG IR: Creating IrStatement::Move from '{}' to '{}'", var, lhs);
+                        debug_trace!("DEBUG IR: Creating IrStatement::Move from '{}' to '{}'", var, lhs);
                         // Transfer type from source if needed
                         let source_type = variables.get(var).map(|info| info.ty.clone());
                         if let Some(var_info) = variables.get_mut(lhs) {
@@ -356,7 +358,7 @@ fn convert_statement(
                             to: lhs.clone(),
                         }]))
                     } else {
-                        eprintln!("DEBUG IR: Move expression doesn't contain a variable");
+                        debug_trace!("DEBUG IR: Move expression doesn't contain a variable");
                         // Handle nested expressions if needed
                         Ok(None)
                     }
@@ -505,6 +507,7 @@ mod tests {
                 line: 1,
                 column: 1,
             },
+            unchecked_accesses: vec![],
         }
     }
 
@@ -1,15 +1,37 @@
 use clap::Parser;
 use colored::*;
-use std::path::PathBuf;
-use std::fs;
+use std::path::{Path, PathBuf};
 use std::env;
-use serde_json;
+use rayon::prelude::*;
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::time::Instant;
+
+/// Whether the analysis trace is written to stderr (-v)
+static TRACE: AtomicBool = AtomicBool::new(false);
+
+fn trace_enabled() -> bool {
+    TRACE.load(Ordering::Relaxed)
+}
+
+/// eprintln! for the analysis trace, which is only written with -v
+macro_rules! debug_trace {
+    ($($arg:tt)*) => {
+        if crate::trace_enabled() {
+            eprintln!($($arg)*);
+        }
+    };
+}
 
 mod parser;
 mod ir;
 mod analysis;
 mod solver;
 mod diagnostics;
+mod batch;
+mod compile_db;
+mod incremental;
+mod server;
+mod timing;
 
 #[derive(clap::Parser, Debug)]
 #[command(name = "rusty-cpp-checker")]
@@ -22,9 +44,10 @@ C_INCLUDE_PATH      : Colon-separated list of C include directories\n  \
 CPATH               : Colon-separated list of C/C++ include directories\n  \
 CPP_INCLUDE_PATH    : Custom include paths for this tool")]
 struct Args {
-    /// C++ source file to analyze
-    #[arg(value_name = "FILE")]
-    input: PathBuf,
+    /// C++ source file to analyze. Without it, every file in
+    /// --compile-commands is analyzed.
+    #[arg(value_name = "FILE", required_unless_present_any = ["compile_commands", "serve"])]
+    input: Option<PathBuf>,
 
     /// Include paths for header files (can be specified multiple times)
     #[arg(short = 'I', value_name = "DIR")]
@@ -35,26 +58,124 @@ struct Args {
     #[arg(short = 'D', value_name = "DEFINE")]
     defines: Vec<String>,
 
-    /// Path to compile_commands.json for extracting include paths
+    /// Path to compile_commands.json for the include paths, defines and
+    /// -std of each file
     #[arg(long, value_name = "FILE")]
     compile_commands: Option<PathBuf>,
 
-    /// Verbosity level
+    /// With --compile-commands and no FILE, touch DIR/<path>.stamp for each
+    /// file without violations, so build tools can track files one by one
+    #[arg(long, value_name = "DIR")]
+    stamp_dir: Option<PathBuf>,
+
+    /// C++ standard to parse as, e.g. c++20 (default: the file's -std in
+    /// --compile-commands, else c++17)
+    #[arg(long, value_name = "STD")]
+    std: Option<String>,
+
+    /// Verbosity level; -v also traces the analysis to stderr
     #[arg(short, long, action = clap::ArgAction::Count)]
     verbose: u8,
 
     /// Output format (text, json)
     #[arg(long, default_value = "text")]
     format: String,
+
+    /// Cache file for header signatures, reused across runs and files
+    /// while the headers and flags are unchanged
+    #[arg(long, value_name = "FILE")]
+    header_cache: Option<PathBuf>,
+
+    /// Header included by most files (e.g. rusty/rusty.hpp) to precompile
+    /// once and load, instead of parsing it for every file
+    #[arg(long, value_name = "HEADER")]
+    pch: Option<PathBuf>,
+
+    /// Re-check only the functions that changed since the last run, reusing
+    /// the rest from .rusty-cpp-cache in the working directory
+    #[arg(long)]
+    incremental: bool,
+
+    /// Number of files and functions to analyze in parallel
+    /// (default: number of CPUs)
+    #[arg(short = 'j', long, value_name = "N")]
+    jobs: Option<usize>,
+
+    /// Stay running and answer check requests on ADDR (host:port), or on
+    /// stdin and stdout with "-", keeping libclang, header signatures and
+    /// translation units warm between requests
+    #[arg(long, value_name = "ADDR")]
+    serve: Option<String>,
+
+    /// Report the time of each phase and the N slowest functions
+    /// (default 10), and peak memory: on stderr, or as "time_report" in
+    /// --format json
+    #[arg(long, value_name = "N", num_args = 0..=1, require_equals = true, default_missing_value = "10")]
+    time_report: Option<usize>,
+}
+
+/// What the analyses of one checker process share: the header signature
+/// store, the --compile-commands index once loaded and, with
+/// --incremental, the last diagnostics of each file
+#[derive(Default)]
+struct Session {
+    header_store: Option<parser::signature_store::SignatureStore>,
+    compile_db: Option<compile_db::CompileDb>,
+    states: std::collections::HashMap<PathBuf, incremental::IncrementalState>,
+}
+
+impl Session {
+    fn new(header_cache: Option<&Path>) -> Self {
+        Session {
+            header_store: header_cache.map(parser::signature_store::SignatureStore::load),
+            ..Self::default()
+        }
+    }
 }
 
 fn main() {
     let args = Args::parse();
-    
+    TRACE.store(args.verbose > 0, Ordering::Relaxed);
+    let jobs = args.jobs.unwrap_or_else(|| {
+        std::thread::available_parallelism().map(|n| n.get()).unwrap_or(1)
+    }).max(1);
+    // Functions of a file are checked on the global pool
+    let _ = rayon::ThreadPoolBuilder::new().num_threads(jobs).build_global();
+
+    if let Some(address) = &args.serve {
+        if let Err(e) = server::serve(address, &args) {
+            eprintln!("{}: {}", "Error".red().bold(), e);
+            std::process::exit(1);
+        }
+        std::process::exit(0);
+    }
+
+    let input = match &args.input {
+        Some(input) => input,
+        None => {
+            // clap requires FILE unless --compile-commands is given
+            let cc_path = args.compile_commands.as_ref().unwrap();
+            check_compile_commands(cc_path, &args, jobs);
+        }
+    };
+
+    let mut session = Session::new(args.header_cache.as_deref());
+    let mut report = timing::TimeReport::default();
+    let result = analyze_file(input, &args.include_paths, &args.defines, args.std.as_deref(), &args, &mut session, None, &mut report);
+    if args.format == "json" {
+        let time_report = args.time_report.map(|n| report.to_json(n));
+        println!("{}", batch::unit_report_json(input, &result, time_report.as_ref()));
+        let failed = !matches!(&result, Ok(v) if v.is_empty());
+        std::process::exit(if failed { 1 } else { 0 });
+    }
+
     println!("{}", "Rusty C++ Checker".bold().blue());
-    println!("Analyzing: {}", args.input.display());
+    println!("Analyzing: {}", input.display());
+    if let Some(n) = args.time_report {
+        report.print(input, n);
+    }
     
-    match analyze_file(&args.input, &args.include_paths, &args.defines, args.compile_commands.as_ref()) {
+    match result {
         Ok(results) => {
             if results.is_empty() {
                 println!("{}", "✓ No borrow checking violations found!".green());
@@ -73,29 +194,138 @@ fn main() {
     }
 }
 
-fn analyze_file(path: &PathBuf, include_paths: &[PathBuf], defines: &[String], compile_commands: Option<&PathBuf>) -> Result<Vec<String>, String> {
+/// Analyze every translation unit of a compile_commands.json, `jobs` at a
+/// time, and exit with the combined result
+fn check_compile_commands(cc_path: &PathBuf, args: &Args, jobs: usize) -> ! {
+    println!("{}", "Rusty C++ Checker".bold().blue());
+
+    let results = compile_db::CompileDb::load(cc_path)
+        .map(compile_db::CompileDb::into_commands)
+        .and_then(|commands| {
+            println!("Analyzing {} file(s) from {} with {} job(s)", commands.len(), cc_path.display(), jobs);
+            batch::check_units(&commands, args, jobs)
+        });
+    let results = match results {
+        Ok(results) => results,
+        Err(e) => {
+            eprintln!("{}: {}", "Error".red().bold(), e);
+            std::process::exit(1);
+        }
+    };
+
+    if let Some(dir) = &args.stamp_dir {
+        if let Err(e) = batch::touch_stamps(dir, &results) {
+            eprintln!("{}: {}", "Error".red().bold(), e);
+            std::process::exit(1);
+        }
+    }
+
+    let mut violation_count = 0;
+    let mut failed_count = 0;
+    for result in &results {
+        match &result.outcome {
+            Ok(violations) if violations.is_empty() => {
+                println!("{} {}", "✓".green(), result.file.display());
+            }
+            Ok(violations) => {
+                violation_count += violations.len();
+                println!("{}", format!("✗ {}: {} violation(s):", result.file.display(), violations.len()).red());
+                for error in violations {
+                    println!("{}", error);
+                }
+            }
+            Err(e) => {
+                failed_count += 1;
+                eprintln!("{} {}: {}", "Error".red().bold(), result.file.display(), e);
+            }
+        }
+    }
+
+    if let Some(n) = args.time_report {
+        print_slowest_units(&results, n);
+    }
+
+    if violation_count == 0 && failed_count == 0 {
+        println!("{}", format!("✓ No borrow checking violations found in {} file(s)!", results.len()).green());
+        std::process::exit(0);
+    }
+    println!("{}", format!("✗ Found {} violation(s) in {} file(s); {} file(s) could not be analyzed",
+                           violation_count, results.len(), failed_count).red());
+    std::process::exit(1);
+}
+
+/// Print the `n` translation units that took longest to stderr, each with
+/// its slowest function
+fn print_slowest_units(results: &[batch::UnitResult], n: usize) {
+    let wall = |r: &batch::UnitResult| r.time_report.as_ref().and_then(|t| t["wall_ms"].as_f64()).unwrap_or(0.0);
+    let mut timed: Vec<&batch::UnitResult> = results.iter().filter(|r| r.time_report.is_some()).collect();
+    timed.sort_by(|a, b| wall(b).total_cmp(&wall(a)));
+    eprintln!("Slowest of {} timed file(s):", timed.len());
+    for result in timed.into_iter().take(n) {
+        let report = result.time_report.as_ref().unwrap();
+        let slowest = &report["slowest_functions"][0];
+        let peak = report["peak_memory_kb"].as_u64().map(|kb| format!(", peak {} KB", kb)).unwrap_or_default();
+        match slowest["name"].as_str() {
+            Some(name) => eprintln!("  {:>10.2} ms  {}{}  (slowest function {}: {:.2} ms)",
+                                    wall(result), result.file.display(), peak, name, slowest["total_ms"].as_f64().unwrap_or(0.0)),
+            None => eprintln!("  {:>10.2} ms  {}{}", wall(result), result.file.display(), peak),
+        }
+    }
+}
+
+/// Analyze one file with the given include paths, defines and C++
+/// standard, and the other per-file options of `args`. With `warm`, the file is parsed on
+/// that index instead of a fresh libclang instance.
+/// Where the time went is added to `report`.
+fn analyze_file(path: &PathBuf, include_paths: &[PathBuf], defines: &[String], std: Option<&str>, args: &Args, session: &mut Session, warm: Option<&mut parser::WarmIndex>, report: &mut timing::TimeReport) -> Result<Vec<String>, String> {
+    let start = Instant::now();
+    let result = analyze_file_timed(path, include_paths, defines, std, args, session, warm, report);
+    report.wall += start.elapsed();
+    result
+}
+
+fn analyze_file_timed(path: &PathBuf, include_paths: &[PathBuf], defines: &[String], std: Option<&str>, args: &Args, session: &mut Session, warm: Option<&mut parser::WarmIndex>, report: &mut timing::TimeReport) -> Result<Vec<String>, String> {
     // Start with CLI-provided include paths
     let mut all_include_paths = include_paths.to_vec();
     
     // Add include paths from environment variables
     all_include_paths.extend(extract_include_paths_from_env());
     
-    // Extract include paths from compile_commands.json if provided
-    if let Some(cc_path) = compile_commands {
-        let extracted_paths = extract_include_paths_from_compile_commands(cc_path, path)?;
-        all_include_paths.extend(extracted_paths);
+    // Add the flags of the file's command in compile_commands.json, if provided
+    let mut all_defines = defines.to_vec();
+    let mut std = std.map(str::to_string);
+    if let Some(cc_path) = &args.compile_commands {
+        if session.compile_db.is_none() {
+            session.compile_db = Some(report.phases.time("compile commands", || compile_db::CompileDb::load(cc_path))?);
+        }
+        if let Some(command) = session.compile_db.as_ref().and_then(|db| db.lookup(path)) {
+            all_include_paths.extend(command.include_paths.iter().cloned());
+            all_defines.extend(command.defines.iter().cloned());
+            std = std.or_else(|| command.std.clone());
+        }
     }
     
-    // Parse included headers for lifetime annotations
+    // Parse the C++ file with include paths and defines once. The parse
+    // gives the AST, the lifetime annotations of every included header and
+    // the safety annotations.
     let mut header_cache = parser::HeaderCache::new();
-    header_cache.set_include_paths(all_include_paths.clone());
-    header_cache.parse_includes_from_source(path)?;
-    
-    // Parse the C++ file with include paths and defines
-    let ast = parser::parse_cpp_file_with_includes_and_defines(path, &all_include_paths, defines)?;
-    
-    // Parse safety annotations using the unified rule
-    let safety_context = parser::safety_annotations::parse_safety_annotations(path)?;
+    if let Some(mut store) = session.header_store.take() {
+        store.forget_file_hashes();
+        header_cache.set_store(store);
+    }
+    let parse_start = Instant::now();
+    let parsed = match warm {
+        Some(warm) => warm.parse_file(path, &all_include_paths, &all_defines, std.as_deref(), &mut header_cache),
+        None => parser::parse_file(path, &all_include_paths, &all_defines, std.as_deref(), args.pch.as_deref(), &mut header_cache),
+    };
+    let parse_time = parse_start.elapsed();
+    let saved = header_cache.save_persistent_cache();
+    session.header_store = header_cache.take_store();
+    let parser::ParsedFile { ast, safety_context, header_time, lowering_time } = parsed?;
+    saved?;
+    report.phases.add("clang parse", parse_time.saturating_sub(header_time + lowering_time));
+    report.phases.add("header signatures", header_time);
+    report.phases.add("AST lowering", lowering_time);
     
     // Build a set of known safe functions from the safety context
     let mut known_safe_functions = std::collections::HashSet::new();
@@ -105,81 +335,91 @@ fn analyze_file(path: &PathBuf, include_paths: &[PathBuf], defines: &[String], c
         }
     }
     
+    let check_program = analysis::should_check_program(ast.functions.iter().map(|f| &f.name), &header_cache, &safety_context);
+    
+    // In incremental mode, reuse what the last run found for every function
+    // whose fingerprint is unchanged
+    let state_path = if args.incremental { Some(incremental::state_path(path)) } else { None };
+    let fingerprints: Vec<u64> = match &state_path {
+        Some(_) => {
+            let environment = incremental::environment_fingerprint(&safety_context, &header_cache, check_program);
+            ast.functions
+                .iter()
+                .map(|f| incremental::function_fingerprint(f, safety_context.should_check_function(&f.name), environment))
+                .collect()
+        }
+        None => Vec::new(),
+    };
+    let previous = match &state_path {
+        Some(state_path) => session.states.remove(state_path).unwrap_or_else(|| incremental::IncrementalState::load(state_path)),
+        None => incremental::IncrementalState::default(),
+    };
+    let mut per_function: Vec<Option<analysis::FunctionDiagnostics>> = (0..ast.functions.len())
+        .map(|i| fingerprints.get(i).and_then(|f| previous.get(*f)).cloned())
+        .collect();
+    
     // Check for unsafe pointer operations and unsafe propagation in safe functions
-    let mut violations = Vec::new();
-    eprintln!("DEBUG: Found {} functions in AST", ast.functions.len());
-    for function in &ast.functions {
-        eprintln!("DEBUG: Processing function '{}' with {} statements", function.name, function.body.len());
+    debug_trace!("DEBUG: Found {} functions in AST", ast.functions.len());
+    let mut stale = Vec::new();
+    let mut stale_times = Vec::new();
+    let mut stale_ast = parser::CppAst::new();
+    for (i, function) in ast.functions.into_iter().enumerate() {
+        if per_function[i].is_some() {
+            debug_trace!("DEBUG: Function '{}' is unchanged, reusing its diagnostics", function.name);
+            continue;
+        }
+        debug_trace!("DEBUG: Processing function '{}' with {} statements", function.name, function.body.len());
+        let mut diagnostics = analysis::FunctionDiagnostics::default();
+        let mut times = timing::PhaseTimes::default();
         if safety_context.should_check_function(&function.name) {
-            eprintln!("DEBUG: Function '{}' is marked safe, performing checks", function.name);
-            // Check for pointer operations
-            let pointer_errors = analysis::pointer_safety::check_parsed_function_for_pointers(function);
-            violations.extend(pointer_errors);
-            
-            // Check for calls to unsafe functions
-            let propagation_errors = analysis::unsafe_propagation::check_unsafe_propagation(
-                function,
-                &safety_context,
-                &known_safe_functions
-            );
-            violations.extend(propagation_errors);
+            debug_trace!("DEBUG: Function '{}' is marked safe, performing checks", function.name);
+            diagnostics.parsed = times.time("safety checks", || {
+                analysis::check_parsed_function(&function, &safety_context, &known_safe_functions)
+            });
         }
+        per_function[i] = Some(diagnostics);
+        stale.push(i);
+        stale_times.push(times);
+        stale_ast.functions.push(function);
     }
     
     // Build intermediate representation with safety context
-    let ir = ir::build_ir_with_safety_context(ast, safety_context.clone())?;
-    
-    // Perform borrow checking analysis with header knowledge and safety context
-    let borrow_violations = analysis::check_borrows_with_safety_context(ir, header_cache, safety_context)?;
-    violations.extend(borrow_violations);
+    let ir = report.phases.time("IR build", || ir::build_ir_with_safety_context(stale_ast, safety_context.clone()))?;
     
-    Ok(violations)
-}
-
-fn extract_include_paths_from_compile_commands(cc_path: &PathBuf, source_file: &PathBuf) -> Result<Vec<PathBuf>, String> {
-    let content = fs::read_to_string(cc_path)
-        .map_err(|e| format!("Failed to read compile_commands.json: {}", e))?;
-    
-    let commands: Vec<serde_json::Value> = serde_json::from_str(&content)
-        .map_err(|e| format!("Failed to parse compile_commands.json: {}", e))?;
-    
-    let source_str = source_file.to_string_lossy();
-    
-    // Find the entry for our source file
-    for entry in commands {
-        if let Some(file) = entry.get("file").and_then(|f| f.as_str()) {
-            if file.ends_with(&*source_str) || source_str.ends_with(file) {
-                if let Some(command) = entry.get("command").and_then(|c| c.as_str()) {
-                    return extract_include_paths_from_command(command);
-                }
-            }
+    // Perform borrow checking analysis with header knowledge and safety
+    // context. Functions are checked independently, so check them in parallel.
+    if check_program {
+        let ir_diagnostics = report.phases.time("function checks (wall)", || {
+            ir.functions
+                .par_iter()
+                .zip(stale_times.par_iter_mut())
+                .map(|(function, times)| {
+                    let safe = safety_context.should_check_function(&function.name);
+                    analysis::check_ir_function(function, safe, &header_cache, times)
+                })
+                .collect::<Result<Vec<_>, String>>()
+        })?;
+        for (i, found) in stale.iter().copied().zip(ir_diagnostics) {
+            let diagnostics = per_function[i].as_mut().unwrap();
+            diagnostics.borrows = found.borrows;
+            diagnostics.inference = found.inference;
+            diagnostics.annotated_lifetimes = found.annotated_lifetimes;
+            diagnostics.scoped_lifetimes = found.scoped_lifetimes;
         }
     }
     
-    Ok(Vec::new()) // No matching entry found
-}
-
-fn extract_include_paths_from_command(command: &str) -> Result<Vec<PathBuf>, String> {
-    let mut paths = Vec::new();
-    let parts: Vec<&str> = command.split_whitespace().collect();
+    for (function, times) in ir.functions.iter().zip(stale_times) {
+        report.add_function(&function.name, times);
+    }
     
-    let mut i = 0;
-    while i < parts.len() {
-        if parts[i] == "-I" && i + 1 < parts.len() {
-            // -I /path/to/include
-            paths.push(PathBuf::from(parts[i + 1]));
-            i += 2;
-        } else if parts[i].starts_with("-I") {
-            // -I/path/to/include
-            let path = &parts[i][2..];
-            paths.push(PathBuf::from(path));
-            i += 1;
-        } else {
-            i += 1;
-        }
+    let per_function: Vec<analysis::FunctionDiagnostics> = per_function.into_iter().map(|d| d.unwrap()).collect();
+    if let Some(state_path) = &state_path {
+        let entries: Vec<_> = fingerprints.iter().copied().zip(per_function.iter()).collect();
+        report.phases.time("incremental state", || incremental::IncrementalState::save(state_path, &entries))?;
+        session.states.insert(state_path.clone(), incremental::IncrementalState::from_functions(&entries));
     }
     
-    Ok(paths)
+    Ok(analysis::merge_diagnostics(&per_function))
 }
 
 fn extract_include_paths_from_env() -> Vec<PathBuf> {
@@ -1,5 +1,7 @@
 use clang::{Entity, EntityKind, Type, TypeKind};
 
+use super::bounds::{collect_unchecked_accesses, UncheckedAccess};
+
 #[derive(Debug, Clone)]
 pub struct CppAst {
     pub functions: Vec<Function>,
@@ -25,6 +27,8 @@ pub struct Function {
     pub body: Vec<Statement>,
     #[allow(dead_code)]
     pub location: SourceLocation,
+    // get_unchecked calls, each marked proven or not
+    pub unchecked_accesses: Vec<UncheckedAccess>,
 }
 
 #[derive(Debug, Clone)]
@@ -99,6 +103,24 @@ pub enum Expression {
         op: String,
         right: Box<Expression>,
     },
+    // Outer variables the lambda refers to, and its body
+    Lambda {
+        captures: Vec<Capture>,
+        body: Vec<Statement>,
+    },
+}
+
+// How a lambda holds an outer variable: [x] copies it, [&x] refers to it
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum CaptureKind {
+    ByValue,
+    ByRef,
+}
+
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct Capture {
+    pub name: String,
+    pub kind: CaptureKind,
 }
 
 #[derive(Debug, Clone)]
@@ -112,6 +134,20 @@ pub struct SourceLocation {
 }
 
 pub fn extract_function(entity: &Entity) -> Function {
+    let mut function = extract_function_declaration(entity);
+    function.body = extract_function_body(entity);
+    
+    for child in entity.get_children() {
+        if child.get_kind() == EntityKind::CompoundStmt {
+            function.unchecked_accesses.extend(collect_unchecked_accesses(&child));
+        }
+    }
+    
+    function
+}
+
+/// A function's name, parameters and return type, without its body
+pub fn extract_function_declaration(entity: &Entity) -> Function {
     let name = entity.get_name().unwrap_or_else(|| "anonymous".to_string());
     let location = extract_location(entity);
     
@@ -127,14 +163,13 @@ pub fn extract_function(entity: &Entity) -> Function {
         .map(|t| type_to_string(&t))
         .unwrap_or_else(|| "void".to_string());
     
-    let body = extract_function_body(entity);
-    
     Function {
         name,
         parameters,
         return_type,
-        body,
+        body: Vec::new(),
         location,
+        unchecked_accesses: Vec::new(),
     }
 }
 
@@ -246,6 +281,12 @@ fn extract_compound_statement(entity: &Entity) -> Vec<Statement> {
                 
                 for c in children {
                     match c.get_kind() {
+                        EntityKind::MemberRefExpr if name == "unknown" => {
+                            // obj.method(...): the callee names the method
+                            if let Some(n) = c.get_name() {
+                                name = n;
+                            }
+                        }
                         EntityKind::DeclRefExpr | EntityKind::UnexposedExpr => {
                             if name == "unknown" {
                                 if let Some(n) = c.get_name() {
@@ -345,9 +386,16 @@ fn extract_expression(entity: &Entity) -> Option<Expression> {
             let children: Vec<Entity> = entity.get_children().into_iter().collect();
             let mut name = "unknown".to_string();
             let mut args = Vec::new();
+            let mut is_method = false;
             
             for c in children {
                 match c.get_kind() {
+                    EntityKind::MemberRefExpr if name == "unknown" => {
+                        if let Some(n) = c.get_name() {
+                            name = n;
+                            is_method = true;
+                        }
+                    }
                     EntityKind::DeclRefExpr | EntityKind::UnexposedExpr => {
                         if name == "unknown" {
                             if let Some(n) = c.get_name() {
@@ -367,13 +415,14 @@ fn extract_expression(entity: &Entity) -> Option<Expression> {
                 }
             }
             
-            // Check if this is std::move
-            eprintln!("DEBUG: Found function call: name='{}', args_count={}", name, args.len());
-            if name == "move" || name == "std::move" || name.ends_with("::move") || name.contains("move") {
-                eprintln!("DEBUG: Detected move function!");
+            // Check if this is std::move. Only a free function named move counts:
+            // methods such as map.remove(key) must not move their argument.
+            debug_trace!("DEBUG: Found function call: name='{}', args_count={}", name, args.len());
+            if !is_method && (name == "move" || name.ends_with("::move")) {
+                debug_trace!("DEBUG: Detected move function!");
                 // std::move takes one argument and we treat it as a Move expression
                 if args.len() == 1 {
-                    eprintln!("DEBUG: Creating Move expression");
+                    debug_trace!("DEBUG: Creating Move expression");
                     return Some(Expression::Move(Box::new(args.into_iter().next().unwrap())));
                 }
             }
@@ -409,6 +458,36 @@ fn extract_expression(entity: &Entity) -> Option<Expression> {
         EntityKind::IntegerLiteral => {
             entity.get_name().map(Expression::Literal)
         }
+        EntityKind::LambdaExpr => {
+            let mut captures = Vec::new();
+            let mut declared = Vec::new();
+            collect_lambda_names(entity, &mut captures, &mut declared);
+            captures.retain(|name| !declared.contains(name));
+            let tokens: Vec<String> = entity
+                .get_range()
+                .map(|range| range.tokenize().iter().map(|t| t.get_spelling()).collect())
+                .unwrap_or_default();
+            let (default, explicit) = capture_modes(&tokens);
+            let captures = captures
+                .into_iter()
+                .map(|name| {
+                    let kind = explicit
+                        .iter()
+                        .find(|(listed, _)| *listed == name)
+                        .map(|(_, kind)| *kind)
+                        .unwrap_or(default);
+                    Capture { name, kind }
+                })
+                .collect();
+
+            let mut body = Vec::new();
+            for child in entity.get_children() {
+                if child.get_kind() == EntityKind::CompoundStmt {
+                    body.extend(extract_compound_statement(&child));
+                }
+            }
+            Some(Expression::Lambda { captures, body })
+        }
         EntityKind::UnaryOperator => {
             // Check if it's address-of (&) or dereference (*)
             let children: Vec<Entity> = entity.get_children().into_iter().collect();
@@ -442,7 +521,81 @@ fn extract_expression(entity: &Entity) -> Option<Expression> {
     }
 }
 
-fn extract_location(entity: &Entity) -> SourceLocation {
+// The capture default and the explicitly listed captures of a lambda, read
+// from its tokens: `[&, n]` gives (ByRef, [n: ByValue]). Names used in an
+// init-capture's initializer (`[v = std::move(x)]`) are moved or copied in,
+// so they count as by-value. Without a default, what is not listed is not a
+// capture at all (a global, a function), so ByValue is as good as any.
+fn capture_modes(tokens: &[String]) -> (CaptureKind, Vec<(String, CaptureKind)>) {
+    let mut default = CaptureKind::ByValue;
+    let mut explicit = Vec::new();
+    if tokens.first().map(String::as_str) != Some("[") {
+        return (default, explicit);
+    }
+
+    // Split the capture list at top-level commas
+    let mut entries: Vec<Vec<&str>> = vec![Vec::new()];
+    let mut depth = 0usize;
+    for token in &tokens[1..] {
+        match token.as_str() {
+            "]" if depth == 0 => break,
+            "," if depth == 0 => {
+                entries.push(Vec::new());
+                continue;
+            }
+            "(" | "[" | "{" => depth += 1,
+            ")" | "]" | "}" => depth = depth.saturating_sub(1),
+            _ => {}
+        }
+        entries.last_mut().unwrap().push(token.as_str());
+    }
+
+    let is_name = |t: &str| t.chars().next().map_or(false, |c| c.is_alphabetic() || c == '_');
+    for entry in entries {
+        match entry.as_slice() {
+            ["&"] => default = CaptureKind::ByRef,
+            ["="] => default = CaptureKind::ByValue,
+            ["&", name, ..] => explicit.push((name.to_string(), CaptureKind::ByRef)),
+            [name, rest @ ..] if is_name(name) && *name != "this" => {
+                explicit.push((name.to_string(), CaptureKind::ByValue));
+                if rest.first() == Some(&"=") {
+                    for t in &rest[1..] {
+                        if is_name(t) {
+                            explicit.push((t.to_string(), CaptureKind::ByValue));
+                        }
+                    }
+                }
+            }
+            _ => {}
+        }
+    }
+    (default, explicit)
+}
+
+// Names a lambda refers to (captures, but also functions it calls) and the
+// names it declares itself (parameters, locals), which shadow outer ones
+fn collect_lambda_names(entity: &Entity, referenced: &mut Vec<String>, declared: &mut Vec<String>) {
+    for child in entity.get_children() {
+        match child.get_kind() {
+            EntityKind::DeclRefExpr | EntityKind::VariableRef => {
+                if let Some(name) = child.get_name() {
+                    if !referenced.contains(&name) {
+                        referenced.push(name);
+                    }
+                }
+            }
+            EntityKind::ParmDecl | EntityKind::VarDecl => {
+                if let Some(name) = child.get_name() {
+                    declared.push(name);
+                }
+            }
+            _ => {}
+        }
+        collect_lambda_names(&child, referenced, declared);
+    }
+}
+
+pub(crate) fn extract_location(entity: &Entity) -> SourceLocation {
     let location = entity.get_location().unwrap();
     let file_location = location.get_file_location();
     
@@ -466,4 +619,27 @@ fn check_for_unsafe_annotation(_entity: &Entity) -> bool {
     // differently using comment annotations that are scanned separately
     // Always return false
     false
-}
\ No newline at end of file
+}
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn tokens(s: &str) -> Vec<String> {
+        s.split_whitespace().map(|t| t.to_string()).collect()
+    }
+
+    #[test]
+    fn test_capture_modes() {
+        use CaptureKind::{ByRef, ByValue};
+        let (default, explicit) = capture_modes(&tokens("[ & ] { f ( x ) ; }"));
+        assert_eq!((default, explicit.len()), (ByRef, 0));
+        let (default, explicit) = capture_modes(&tokens("[ = , & out ] ( int i ) { }"));
+        assert_eq!((default, explicit), (ByValue, vec![("out".to_string(), ByRef)]));
+        let (default, explicit) = capture_modes(&tokens("[ & , n , this ] { }"));
+        assert_eq!((default, explicit), (ByRef, vec![("n".to_string(), ByValue)]));
+        // The initializer's names are moved in; brackets inside do not end the list
+        let (_, explicit) = capture_modes(&tokens("[ & , v = std :: move ( xs [ 0 ] ) ] { }"));
+        assert!(explicit.contains(&("xs".to_string(), ByValue)));
+        assert!(explicit.contains(&("v".to_string(), ByValue)));
+    }
+}
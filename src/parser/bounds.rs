@@ -0,0 +1,274 @@
+use clang::{Entity, EntityKind};
+
+use super::ast_visitor::{extract_location, SourceLocation};
+
+/// Accessors that skip the bounds check (see include/rusty/bounds.hpp)
+pub const UNCHECKED_METHODS: &[&str] = &["get_unchecked", "get_unchecked_mut"];
+
+/// Methods that read a container, or one element of it, without changing
+/// its length
+const READ_ONLY_METHODS: &[&str] = &[
+    "len", "size", "is_empty", "get", "get_mut", "get_unchecked", "get_unchecked_mut",
+    "operator[]", "first", "last", "contains",
+];
+
+/// Methods and functions that can shrink a container. A call to one of
+/// these on any receiver defeats the proof, since the receiver may alias
+/// the loop's container.
+const SHRINKING_CALLS: &[&str] = &[
+    "pop", "pop_back", "pop_front", "truncate", "clear", "remove", "swap_remove", "drain",
+    "retain", "resize", "split_off", "dedup", "erase", "swap", "operator=",
+];
+
+const INTEGRAL_TYPES: &[&str] = &[
+    "char", "signed char", "unsigned char", "short", "unsigned short", "int", "unsigned int",
+    "long", "unsigned long", "long long", "unsigned long long",
+];
+
+/// A call to get_unchecked / get_unchecked_mut, and whether its index is
+/// known to be in range
+#[derive(Debug, Clone)]
+pub struct UncheckedAccess {
+    pub method: String,
+    // Receiver and index variable names, or "..." when they are not plain
+    // variables
+    pub container: String,
+    pub index: String,
+    pub proven: bool,
+    pub location: SourceLocation,
+}
+
+/// Find the unchecked accesses in a function body. One is proven when it
+/// sits in the body of `for (T i = ...; i < c.len(); ...)` (or `c.size()`,
+/// or `c.len() > i`), is `c.get_unchecked(i)` for that same c and i, and the
+/// body keeps the bound: it never writes or aliases i, uses c only through
+/// read-only methods, declares neither name again and calls nothing that
+/// can shrink a container. Closures are never proven: they may run after
+/// the loop.
+pub fn collect_unchecked_accesses(body: &Entity) -> Vec<UncheckedAccess> {
+    let mut accesses = Vec::new();
+    collect(body, &mut Vec::new(), &mut accesses);
+    accesses
+}
+
+fn collect(entity: &Entity, bounds: &mut Vec<(String, String)>, out: &mut Vec<UncheckedAccess>) {
+    match entity.get_kind() {
+        EntityKind::ForStmt => {
+            let children = entity.get_children();
+            if let (Some(bound), Some(body)) = (index_loop_bound(entity), children.last()) {
+                for child in &children[..children.len() - 1] {
+                    collect(child, bounds, out);
+                }
+                bounds.push(bound);
+                collect(body, bounds, out);
+                bounds.pop();
+                return;
+            }
+        }
+        EntityKind::LambdaExpr => {
+            for child in entity.get_children() {
+                collect(&child, &mut Vec::new(), out);
+            }
+            return;
+        }
+        EntityKind::CallExpr => {
+            if let Some(access) = unchecked_access(entity, bounds) {
+                out.push(access);
+            }
+        }
+        _ => {}
+    }
+    for child in entity.get_children() {
+        collect(&child, bounds, out);
+    }
+}
+
+fn unchecked_access(call: &Entity, bounds: &[(String, String)]) -> Option<UncheckedAccess> {
+    let children = call.get_children();
+    let callee = children.first()?;
+    let method = callee.get_name()?;
+    if callee.get_kind() != EntityKind::MemberRefExpr || !UNCHECKED_METHODS.contains(&method.as_str()) {
+        return None;
+    }
+
+    let container = callee.get_children().first().and_then(variable_name);
+    let index = children.get(1).and_then(variable_name);
+    let proven = match (&container, &index) {
+        (Some(c), Some(i)) => bounds.iter().any(|(bi, bc)| bi == i && bc == c),
+        _ => false,
+    };
+    Some(UncheckedAccess {
+        method,
+        container: container.unwrap_or_else(|| "...".to_string()),
+        index: index.unwrap_or_else(|| "...".to_string()),
+        proven,
+        location: extract_location(call),
+    })
+}
+
+/// The (index, container) a for loop keeps in range for its body
+fn index_loop_bound(for_stmt: &Entity) -> Option<(String, String)> {
+    let children = for_stmt.get_children();
+    if children.len() < 3 {
+        return None;
+    }
+
+    // The index must be declared by the loop, with an integer type
+    let init = &children[0];
+    if init.get_kind() != EntityKind::DeclStmt {
+        return None;
+    }
+    let decls = init.get_children();
+    if decls.len() != 1 || decls[0].get_kind() != EntityKind::VarDecl {
+        return None;
+    }
+    let declared = decls[0].get_name()?;
+    let type_name = decls[0].get_type()?.get_canonical_type().get_display_name();
+    if !INTEGRAL_TYPES.contains(&type_name.as_str()) {
+        return None;
+    }
+
+    let condition = children.iter().find(|c| c.get_kind() == EntityKind::BinaryOperator)?;
+    let tokens: Vec<String> = condition
+        .get_range()?
+        .tokenize()
+        .iter()
+        .map(|t| t.get_spelling())
+        .collect();
+    let (index, container) = match_bound_condition(&tokens)?;
+    if index != declared {
+        return None;
+    }
+
+    let body = children.last()?;
+    if body_keeps_bound(body, &index, &container, EntityKind::CompoundStmt) {
+        Some((index, container))
+    } else {
+        None
+    }
+}
+
+/// Match `i < c.len()`, `i < c.size()` and `c.len() > i` (and the same
+/// with size), returning (i, c)
+pub fn match_bound_condition(tokens: &[String]) -> Option<(String, String)> {
+    let t: Vec<&str> = tokens.iter().map(|s| s.as_str()).collect();
+    let is_len = |m: &str| m == "len" || m == "size";
+    match t.as_slice() {
+        [i, "<", c, ".", m, "(", ")"] if is_len(m) && is_identifier(i) && is_identifier(c) => {
+            Some((i.to_string(), c.to_string()))
+        }
+        [c, ".", m, "(", ")", ">", i] if is_len(m) && is_identifier(i) && is_identifier(c) => {
+            Some((i.to_string(), c.to_string()))
+        }
+        _ => None,
+    }
+}
+
+fn is_identifier(s: &str) -> bool {
+    let mut chars = s.chars();
+    matches!(chars.next(), Some(c) if c.is_ascii_alphabetic() || c == '_')
+        && chars.all(|c| c.is_ascii_alphanumeric() || c == '_')
+}
+
+/// Whether a loop body leaves `index < container.len()` true wherever it
+/// holds on entry. libclang wraps an lvalue that is only read in an
+/// implicit cast (an UnexposedExpr), so a DeclRefExpr of the index with any
+/// other parent is a write, a reference binding or an address taken.
+fn body_keeps_bound(entity: &Entity, index: &str, container: &str, parent: EntityKind) -> bool {
+    let name = entity.get_name();
+    let named = |n: &str| name.as_deref() == Some(n);
+    match entity.get_kind() {
+        EntityKind::DeclRefExpr => {
+            if named(container) {
+                return false;
+            }
+            if named(index) && parent != EntityKind::UnexposedExpr {
+                return false;
+            }
+        }
+        EntityKind::VarDecl | EntityKind::ParmDecl => {
+            if named(index) || named(container) {
+                return false;
+            }
+        }
+        EntityKind::MemberRefExpr => {
+            let method = name.unwrap_or_default();
+            if SHRINKING_CALLS.contains(&method.as_str()) {
+                return false;
+            }
+            let receiver = entity.get_children();
+            if let Some(r) = receiver.first() {
+                if variable_name(r).as_deref() == Some(container) {
+                    // Reading the container itself is the one allowed use
+                    return READ_ONLY_METHODS.contains(&method.as_str());
+                }
+            }
+        }
+        EntityKind::CallExpr => {
+            let callee = name.unwrap_or_default();
+            if SHRINKING_CALLS.contains(&callee.as_str()) {
+                return false;
+            }
+            if callee == "operator[]" {
+                let children = entity.get_children();
+                let on_container = children
+                    .first()
+                    .map_or(false, |r| variable_name(r).as_deref() == Some(container));
+                let rest = if on_container { &children[1..] } else { &children[..] };
+                return rest
+                    .iter()
+                    .all(|c| body_keeps_bound(c, index, container, EntityKind::CallExpr));
+            }
+        }
+        _ => {}
+    }
+    let kind = entity.get_kind();
+    entity
+        .get_children()
+        .iter()
+        .all(|c| body_keeps_bound(c, index, container, kind))
+}
+
+/// The variable an expression names, looking through implicit casts
+fn variable_name(entity: &Entity) -> Option<String> {
+    match entity.get_kind() {
+        EntityKind::DeclRefExpr => entity.get_name(),
+        EntityKind::UnexposedExpr => {
+            let children = entity.get_children();
+            if children.len() == 1 {
+                variable_name(&children[0])
+            } else {
+                None
+            }
+        }
+        _ => None,
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn tokens(s: &str) -> Vec<String> {
+        s.split_whitespace().map(|t| t.to_string()).collect()
+    }
+
+    #[test]
+    fn test_match_bound_condition() {
+        let bound = Some(("i".to_string(), "v".to_string()));
+        assert_eq!(match_bound_condition(&tokens("i < v . len ( )")), bound);
+        assert_eq!(match_bound_condition(&tokens("i < v . size ( )")), bound);
+        assert_eq!(match_bound_condition(&tokens("v . len ( ) > i")), bound);
+    }
+
+    #[test]
+    fn test_match_bound_condition_rejects_other_bounds() {
+        // <= lets the index reach len
+        assert_eq!(match_bound_condition(&tokens("i <= v . len ( )")), None);
+        assert_eq!(match_bound_condition(&tokens("i < v . len ( ) + 1")), None);
+        assert_eq!(match_bound_condition(&tokens("i < v . capacity ( )")), None);
+        assert_eq!(match_bound_condition(&tokens("i < n")), None);
+        assert_eq!(match_bound_condition(&tokens("i < v -> len ( )")), None);
+        assert_eq!(match_bound_condition(&tokens("i < a [ 0 ] . len ( )")), None);
+    }
+}
@@ -1,10 +1,12 @@
-use std::collections::HashMap;
+use std::collections::{HashMap, HashSet};
 use std::path::{Path, PathBuf};
 use std::fs;
 use regex::Regex;
 use clang::{Clang, Index};
 
 use super::annotations::{FunctionSignature, extract_annotations};
+use super::signature_store::{content_hash, SignatureStore};
+use crate::solver::{ConstraintSolver, SignatureCache};
 
 /// Cache for storing function signatures from header files
 #[derive(Debug, Default)]
@@ -12,9 +14,13 @@ pub struct HeaderCache {
     /// Map from function name to its lifetime signature
     signatures: HashMap<String, FunctionSignature>,
     /// Paths of headers that have been processed
-    processed_headers: Vec<PathBuf>,
+    processed_headers: HashSet<PathBuf>,
     /// Include paths to search for headers
     include_paths: Vec<PathBuf>,
+    /// Signatures of headers parsed by earlier runs
+    store: Option<SignatureStore>,
+    /// Lifetime bounds of signatures, solved at their first call
+    solved_bounds: SignatureCache,
 }
 
 impl HeaderCache {
@@ -23,49 +29,178 @@ impl HeaderCache {
     }
     
     /// Set the include paths for header file resolution
+    #[allow(dead_code)]
     pub fn set_include_paths(&mut self, paths: Vec<PathBuf>) {
         self.include_paths = paths;
     }
     
+    /// Reuse and record header signatures in `store`
+    pub fn set_store(&mut self, store: SignatureStore) {
+        self.store = Some(store);
+    }
+    
+    /// Give back the store set with `set_store`
+    pub fn take_store(&mut self) -> Option<SignatureStore> {
+        self.store.take()
+    }
+    
+    /// Write newly parsed headers to the cache file, if there is one
+    pub fn save_persistent_cache(&mut self) -> Result<(), String> {
+        match &mut self.store {
+            Some(store) => store.save(),
+            None => Ok(()),
+        }
+    }
+    
     /// Get a function signature by name
     pub fn get_signature(&self, func_name: &str) -> Option<&FunctionSignature> {
         self.signatures.get(func_name)
     }
     
+    /// The outlives relations `signature`'s lifetime bounds imply, solved
+    /// once per signature
+    pub fn solved_bounds(&self, signature: &FunctionSignature) -> std::sync::Arc<ConstraintSolver> {
+        let bounds: Vec<(&str, &str)> = signature
+            .lifetime_bounds
+            .iter()
+            .map(|bound| (bound.longer.as_str(), bound.shorter.as_str()))
+            .collect();
+        self.solved_bounds.bounds(&signature.name, &bounds)
+    }
+    
     /// Parse a header file and extract all annotated function signatures
+    #[allow(dead_code)]
     pub fn parse_header(&mut self, header_path: &Path) -> Result<(), String> {
         // Skip if already processed
-        if self.processed_headers.iter().any(|p| p == header_path) {
+        let header_path = fs::canonicalize(header_path).unwrap_or_else(|_| header_path.to_path_buf());
+        if !self.processed_headers.insert(header_path.clone()) {
             return Ok(());
         }
         
-        // Initialize Clang
-        let clang = Clang::new()
-            .map_err(|e| format!("Failed to initialize Clang: {:?}", e))?;
-        let index = Index::new(&clang, false, false);
-        
         // Build arguments with include paths
         let mut args = vec!["-std=c++17".to_string(), "-xc++".to_string()];
         for include_path in &self.include_paths {
             args.push(format!("-I{}", include_path.display()));
         }
+        let flags_hash = content_hash(args.join("\0").as_bytes());
+        
+        if let Some(store) = &mut self.store {
+            if let Some(signatures) = store.lookup(&header_path, flags_hash) {
+                for sig in signatures {
+                    self.signatures.insert(sig.name.clone(), sig);
+                }
+                return Ok(());
+            }
+        }
+        
+        // Initialize Clang
+        let clang = Clang::new()
+            .map_err(|e| format!("Failed to initialize Clang: {:?}", e))?;
+        let index = Index::new(&clang, false, false);
         
-        // Parse the header file
+        // Parse the header file, recording inclusion directives so the
+        // cache entry knows every file the signatures came from
         let tu = index
-            .parser(header_path)
+            .parser(&header_path)
             .arguments(&args.iter().map(|s| s.as_str()).collect::<Vec<_>>())
+            .detailed_preprocessing_record(true)
             .parse()
             .map_err(|e| format!("Failed to parse header {}: {:?}", header_path.display(), e))?;
         
         // Extract function signatures with annotations
         let root = tu.get_entity();
-        self.visit_entity_for_signatures(&root);
+        let mut signatures = Vec::new();
+        let mut files = HashSet::new();
+        files.insert(header_path.clone());
+        visit_entity_for_signatures(&root, &mut signatures, &mut files);
         
-        self.processed_headers.push(header_path.to_path_buf());
+        if let Some(store) = &mut self.store {
+            let mut files: Vec<_> = files.into_iter().collect();
+            files.sort();
+            store.insert(&header_path, flags_hash, &files, signatures.clone());
+        }
+        for sig in signatures {
+            self.signatures.insert(sig.name.clone(), sig);
+        }
         Ok(())
     }
     
+    /// Take the annotated signatures of every header in a translation unit.
+    /// A header is part of the unit's inclusion graph, so nothing is parsed
+    /// again. With a persistent cache, a header whose content and parser
+    /// arguments are unchanged reuses its stored signatures, and its
+    /// declarations are not visited.
+    pub fn collect_signatures_from_translation_unit(&mut self, root: &clang::Entity, args: &[String]) {
+        let mut walk = SignatureWalk {
+            flags_hash: content_hash(args.join("\0").as_bytes()),
+            order: Vec::new(),
+            headers: HashMap::new(),
+        };
+        for child in root.get_children() {
+            self.visit_header_entity(&child, &mut walk);
+        }
+        
+        // Record headers in inclusion order, so a name declared in two
+        // headers resolves as it would with one parse per header
+        for header in walk.order {
+            let (reused, signatures) = walk.headers.remove(&header).unwrap_or_default();
+            if !reused {
+                if let Some(store) = &mut self.store {
+                    store.insert(&header, walk.flags_hash, &[header.clone()], signatures.clone());
+                }
+            }
+            for sig in signatures {
+                self.signatures.insert(sig.name.clone(), sig);
+            }
+            self.processed_headers.insert(header);
+        }
+    }
+    
+    fn visit_header_entity(&mut self, entity: &clang::Entity, walk: &mut SignatureWalk) {
+        use clang::EntityKind;
+        
+        let location = match entity.get_location() {
+            Some(location) => location,
+            None => return,
+        };
+        // Functions of the main file are checked, not trusted as signatures
+        if location.is_in_main_file() {
+            return;
+        }
+        let file = match location.get_file_location().file {
+            Some(file) => file.get_path(),
+            None => return,
+        };
+        
+        if !walk.headers.contains_key(&file) {
+            let stored = self.store.as_mut().and_then(|store| store.lookup(&file, walk.flags_hash));
+            walk.order.push(file.clone());
+            walk.headers.insert(file.clone(), match stored {
+                Some(signatures) => (true, signatures),
+                None => (false, Vec::new()),
+            });
+        }
+        let (reused, signatures) = walk.headers.get_mut(&file).unwrap();
+        if *reused {
+            return;
+        }
+        
+        match entity.get_kind() {
+            EntityKind::FunctionDecl | EntityKind::Method => {
+                if let Some(sig) = extract_annotations(entity) {
+                    signatures.push(sig);
+                }
+            }
+            _ => {}
+        }
+        
+        for child in entity.get_children() {
+            self.visit_header_entity(&child, walk);
+        }
+    }
+    
     /// Parse headers from a C++ source file's includes
+    #[allow(dead_code)]
     pub fn parse_includes_from_source(&mut self, cpp_file: &Path) -> Result<(), String> {
         let content = fs::read_to_string(cpp_file)
             .map_err(|e| format!("Failed to read {}: {}", cpp_file.display(), e))?;
@@ -90,6 +225,7 @@ impl HeaderCache {
     }
     
     /// Resolve an include path using standard C++ include resolution rules
+    #[allow(dead_code)]
     fn resolve_include(&self, include_path: &str, source_file: &Path, search_source_dir: bool) -> Option<PathBuf> {
         // For quoted includes, first try relative to the source file
         if search_source_dir {
@@ -118,31 +254,64 @@ impl HeaderCache {
         None
     }
     
-    fn visit_entity_for_signatures(&mut self, entity: &clang::Entity) {
-        use clang::EntityKind;
-        
-        match entity.get_kind() {
-            EntityKind::FunctionDecl | EntityKind::Method => {
-                if let Some(sig) = extract_annotations(entity) {
-                    self.signatures.insert(sig.name.clone(), sig);
-                }
+    /// Check if any signatures are cached
+    pub fn has_signatures(&self) -> bool {
+        !self.signatures.is_empty()
+    }
+    
+    /// A hash of all signatures, the same in every run that finds them
+    pub fn fingerprint(&self) -> u64 {
+        let mut names: Vec<&String> = self.signatures.keys().collect();
+        names.sort();
+        let mut text = String::new();
+        for name in names {
+            text.push_str(&format!("{:?}\n", self.signatures[name]));
+        }
+        content_hash(text.as_bytes())
+    }
+}
+
+/// Per-header state of collect_signatures_from_translation_unit
+struct SignatureWalk {
+    flags_hash: u64,
+    /// Headers in the order their first declaration appears
+    order: Vec<PathBuf>,
+    /// Whether each header's signatures came from the store, and the
+    /// signatures found so far
+    headers: HashMap<PathBuf, (bool, Vec<FunctionSignature>)>,
+}
+
+/// Collect the annotated signatures under `entity`, and the files of the
+/// entities and inclusion directives seen on the way
+#[allow(dead_code)]
+fn visit_entity_for_signatures(entity: &clang::Entity, signatures: &mut Vec<FunctionSignature>, files: &mut HashSet<PathBuf>) {
+    use clang::EntityKind;
+    
+    match entity.get_kind() {
+        EntityKind::FunctionDecl | EntityKind::Method => {
+            if let Some(sig) = extract_annotations(entity) {
+                signatures.push(sig);
             }
-            _ => {}
         }
-        
-        // Recursively visit children
-        for child in entity.get_children() {
-            self.visit_entity_for_signatures(&child);
+        EntityKind::InclusionDirective => {
+            if let Some(file) = entity.get_file() {
+                files.insert(file.get_path());
+            }
         }
+        _ => {}
+    }
+    if let Some(file) = entity.get_location().and_then(|l| l.get_file_location().file) {
+        files.insert(file.get_path());
     }
     
-    /// Check if any signatures are cached
-    pub fn has_signatures(&self) -> bool {
-        !self.signatures.is_empty()
+    // Recursively visit children
+    for child in entity.get_children() {
+        visit_entity_for_signatures(&child, signatures, files);
     }
 }
 
 /// Extract include paths from C++ source, separating quoted and angle bracket includes
+#[allow(dead_code)]
 fn extract_includes(content: &str) -> (Vec<String>, Vec<String>) {
     let mut quoted_includes = Vec::new();
     let mut angle_includes = Vec::new();
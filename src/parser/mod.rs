@@ -1,12 +1,15 @@
-use clang::{Clang, Entity, EntityKind, Index};
-use std::path::Path;
+use clang::{Clang, Entity, EntityKind, Index, TranslationUnit};
+use std::collections::HashMap;
+use std::path::{Path, PathBuf};
 
 pub mod ast_visitor;
+pub mod bounds;
 pub mod annotations;
 pub mod header_cache;
+pub mod signature_store;
 pub mod safety_annotations;
 
-pub use ast_visitor::{CppAst, Function, Statement, Expression};
+pub use ast_visitor::{Capture, CaptureKind, CppAst, Function, Statement, Expression};
 pub use header_cache::HeaderCache;
 #[allow(unused_imports)]
 pub use ast_visitor::{Variable, SourceLocation};
@@ -25,15 +28,182 @@ pub fn parse_cpp_file_with_includes(path: &Path, include_paths: &[std::path::Pat
 }
 
 pub fn parse_cpp_file_with_includes_and_defines(path: &Path, include_paths: &[std::path::PathBuf], defines: &[String]) -> Result<CppAst, String> {
+    with_translation_unit(path, include_paths, defines, None, None, false, |root, _| lower_translation_unit(root, &|_| true))
+}
+
+/// What the checker needs from one source file
+pub struct ParsedFile {
+    pub ast: CppAst,
+    pub safety_context: safety_annotations::SafetyContext,
+    /// Time spent collecting header signatures and lowering the AST; the
+    /// rest of the parse is libclang's
+    pub header_time: std::time::Duration,
+    pub lowering_time: std::time::Duration,
+}
+
+/// Parse a source file once and take everything from that one parse: the
+/// AST of its functions, the annotated signatures of every header in its
+/// inclusion graph (into `header_cache`), and its safety annotations.
+///
+/// Only functions the annotations mark safe are checked, so only their
+/// bodies are lowered; every other function keeps just its declaration.
+/// When nothing in the file is safe, libclang skips function bodies
+/// altogether.
+pub fn parse_file(
+    path: &Path,
+    include_paths: &[std::path::PathBuf],
+    defines: &[String],
+    std: Option<&str>,
+    pch: Option<&Path>,
+    header_cache: &mut HeaderCache,
+) -> Result<ParsedFile, String> {
+    let safety_context = scan_safety_annotations(path)?;
+    let skip_bodies = !safety_context.has_safe_functions();
+    let (ast, header_time, lowering_time) = with_translation_unit(path, include_paths, defines, std, pch, skip_bodies, |root, args| {
+        lower_parsed_file(root, args, header_cache, &safety_context)
+    })?;
+    
+    Ok(ParsedFile { ast, safety_context, header_time, lowering_time })
+}
+
+fn scan_safety_annotations(path: &Path) -> Result<safety_annotations::SafetyContext, String> {
+    // Annotations live in comments, which the AST does not keep in place,
+    // so they are scanned from the text first
+    let source = fs::read_to_string(path)
+        .map_err(|e| format!("Failed to open file for safety parsing: {}", e))?;
+    Ok(safety_annotations::parse_safety_annotations_from_source(&source))
+}
+
+/// Collect the header signatures and lower the AST of a parsed file, with
+/// the time each took
+fn lower_parsed_file(
+    root: &Entity,
+    args: &[String],
+    header_cache: &mut HeaderCache,
+    safety_context: &safety_annotations::SafetyContext,
+) -> (CppAst, std::time::Duration, std::time::Duration) {
+    let start = std::time::Instant::now();
+    header_cache.collect_signatures_from_translation_unit(root, args);
+    let header_time = start.elapsed();
+    let start = std::time::Instant::now();
+    let ast = lower_translation_unit(root, &|name| safety_context.should_check_function(name));
+    (ast, header_time, start.elapsed())
+}
+
+/// A libclang index that keeps the translation unit of every file it
+/// parses, for a long-running checker. A file parsed again with the same
+/// arguments is reparsed, which reuses its precompiled preamble: the
+/// headers it includes first are not parsed again unless they changed.
+pub struct WarmIndex<'c> {
+    index: &'c Index<'c>,
+    units: HashMap<PathBuf, WarmUnit<'c>>,
+}
+
+struct WarmUnit<'c> {
+    args: Vec<String>,
+    skip_function_bodies: bool,
+    tu: TranslationUnit<'c>,
+}
+
+impl<'c> WarmIndex<'c> {
+    pub fn new(index: &'c Index<'c>) -> Self {
+        WarmIndex { index, units: HashMap::new() }
+    }
+    
+    /// Like `parse_file`, reusing the last parse of `path`
+    pub fn parse_file(
+        &mut self,
+        path: &Path,
+        include_paths: &[PathBuf],
+        defines: &[String],
+        std: Option<&str>,
+        header_cache: &mut HeaderCache,
+    ) -> Result<ParsedFile, String> {
+        let safety_context = scan_safety_annotations(path)?;
+        let skip_function_bodies = !safety_context.has_safe_functions();
+        let args = clang_arguments(include_paths, defines, std);
+        
+        let key = fs::canonicalize(path).unwrap_or_else(|_| path.to_path_buf());
+        let tu = match self.units.remove(&key) {
+            Some(unit) if unit.args == args && unit.skip_function_bodies == skip_function_bodies => {
+                let tu = unit.tu
+                    .reparse(&[])
+                    .map_err(|e| format!("Failed to reparse file: {:?}", e))?;
+                check_diagnostics(&tu)?;
+                tu
+            }
+            _ => parse_checked(self.index, path, &args, skip_function_bodies, true)?,
+        };
+        
+        let (ast, header_time, lowering_time) = lower_parsed_file(&tu.get_entity(), &args, header_cache, &safety_context);
+        self.units.insert(key, WarmUnit { args, skip_function_bodies, tu });
+        Ok(ParsedFile { ast, safety_context, header_time, lowering_time })
+    }
+}
+
+/// Run `f` with a WarmIndex on this process's one Clang instance
+pub fn with_warm_index<R>(f: impl FnOnce(&mut WarmIndex) -> R) -> Result<R, String> {
+    let clang = Clang::new()
+        .map_err(|e| format!("Failed to initialize Clang: {:?}", e))?;
+    let index = Index::new(&clang, false, false);
+    let mut warm = WarmIndex::new(&index);
+    Ok(f(&mut warm))
+}
+
+/// Directory, under the working directory, for the checker's caches
+pub const CACHE_DIR: &str = ".rusty-cpp-cache";
+
+/// Parse `path` with libclang, as the C++ standard `std` (default c++17),
+/// and hand the translation unit's root entity, and the arguments it was
+/// parsed with, to `f`. With `pch`, that header
+/// is precompiled once for these arguments and loaded with -include-pch
+/// instead of being parsed again.
+fn with_translation_unit<R>(
+    path: &Path,
+    include_paths: &[std::path::PathBuf],
+    defines: &[String],
+    std: Option<&str>,
+    pch: Option<&Path>,
+    skip_function_bodies: bool,
+    f: impl FnOnce(&Entity, &[String]) -> R,
+) -> Result<R, String> {
     // Initialize Clang
     let clang = Clang::new()
         .map_err(|e| format!("Failed to initialize Clang: {:?}", e))?;
     
     let index = Index::new(&clang, false, false);
     
-    // Build arguments with include paths and defines
+    let args = clang_arguments(include_paths, defines, std);
+    
+    let tu = match pch {
+        Some(header) => {
+            // clang rejects a precompiled header whose inputs changed since
+            // it was built; rebuild it once, then fall back to a plain parse
+            let attempt = |rebuild: bool| -> Result<_, String> {
+                let pch_path = precompiled_header(&index, header, &args, rebuild)?;
+                let mut pch_args = args.clone();
+                pch_args.push("-include-pch".to_string());
+                pch_args.push(pch_path.display().to_string());
+                parse_checked(&index, path, &pch_args, skip_function_bodies, false)
+            };
+            match attempt(false).or_else(|_| attempt(true)) {
+                Ok(tu) => tu,
+                Err(e) => {
+                    eprintln!("Warning: not using precompiled {}: {}", header.display(), e);
+                    parse_checked(&index, path, &args, skip_function_bodies, false)?
+                }
+            }
+        }
+        None => parse_checked(&index, path, &args, skip_function_bodies, false)?,
+    };
+    
+    Ok(f(&tu.get_entity(), &args))
+}
+
+/// The libclang arguments for a source file
+fn clang_arguments(include_paths: &[PathBuf], defines: &[String], std: Option<&str>) -> Vec<String> {
     let mut args = vec![
-        "-std=c++17".to_string(), 
+        format!("-std={}", std.unwrap_or("c++17")),
         "-xc++".to_string(),
         // Add flags to make parsing more lenient
         "-fno-delayed-template-parsing".to_string(),
@@ -54,16 +224,31 @@ pub fn parse_cpp_file_with_includes_and_defines(path: &Path, include_paths: &[st
         args.push(format!("-D{}", define));
     }
     
+    args
+}
+
+fn parse_checked<'i>(
+    index: &'i Index,
+    path: &Path,
+    args: &[String],
+    skip_function_bodies: bool,
+    precompiled_preamble: bool,
+) -> Result<TranslationUnit<'i>, String> {
     // Parse the translation unit with skip function bodies option for better error recovery
     let tu = index
         .parser(path)
         .arguments(&args.iter().map(|s| s.as_str()).collect::<Vec<_>>())
         .detailed_preprocessing_record(true)
-        .skip_function_bodies(false)  // We need function bodies for analysis
+        .skip_function_bodies(skip_function_bodies)  // Checked functions need their bodies
         .incomplete(true)  // Allow incomplete translation units
+        .precompiled_preamble(precompiled_preamble)  // Kept for reparsing
         .parse()
         .map_err(|e| format!("Failed to parse file: {:?}", e))?;
-    
+    check_diagnostics(&tu)?;
+    Ok(tu)
+}
+
+fn check_diagnostics(tu: &TranslationUnit) -> Result<(), String> {
     // Check for diagnostics but only fail on fatal errors
     let diagnostics = tu.get_diagnostics();
     let mut has_fatal = false;
@@ -83,17 +268,60 @@ pub fn parse_cpp_file_with_includes_and_defines(path: &Path, include_paths: &[st
     if has_fatal {
         return Err("Fatal parsing errors encountered".to_string());
     }
+    Ok(())
+}
+
+/// The precompiled form of `header` for `args`, kept in CACHE_DIR and
+/// built when missing or when `rebuild` is set. The file name hashes the
+/// header path and the arguments, so every configuration gets its own.
+fn precompiled_header(index: &Index, header: &Path, args: &[String], rebuild: bool) -> Result<std::path::PathBuf, String> {
+    let header = fs::canonicalize(header)
+        .map_err(|e| format!("Failed to find header {}: {}", header.display(), e))?;
+    let key = format!("{}\0{}", header.display(), args.join("\0"));
+    let stem = header.file_name().map(|n| n.to_string_lossy().to_string()).unwrap_or_default();
+    let pch_path = Path::new(CACHE_DIR).join(format!("{}-{:016x}.pch", stem, signature_store::content_hash(key.as_bytes())));
+    if pch_path.exists() && !rebuild {
+        return Ok(pch_path);
+    }
     
+    let mut header_args: Vec<String> = args.iter().filter(|a| *a != "-xc++").cloned().collect();
+    header_args.push("-xc++-header".to_string());
+    let tu = index
+        .parser(&header)
+        .arguments(&header_args.iter().map(|s| s.as_str()).collect::<Vec<_>>())
+        .detailed_preprocessing_record(true)
+        .incomplete(true)  // A header is not a complete translation unit
+        .parse()
+        .map_err(|e| format!("Failed to parse header {}: {:?}", header.display(), e))?;
+    if tu.get_diagnostics().iter().any(|d| d.get_severity() >= clang::diagnostic::Severity::Fatal) {
+        return Err(format!("Fatal errors in {}", header.display()));
+    }
+    
+    // Checkers running in parallel may build the same file; each writes its
+    // own and renames it into place
+    fs::create_dir_all(CACHE_DIR).map_err(|e| format!("Failed to create {}: {}", CACHE_DIR, e))?;
+    let tmp = pch_path.with_extension(format!("tmp{}", std::process::id()));
+    tu.save(&tmp).map_err(|e| format!("Failed to save precompiled header: {:?}", e))?;
+    fs::rename(&tmp, &pch_path).map_err(|e| format!("Failed to save precompiled header: {}", e))?;
+    Ok(pch_path)
+}
+
+/// Lower a translation unit, with the bodies of the functions `lower_body`
+/// accepts by name
+fn lower_translation_unit(root: &Entity, lower_body: &dyn Fn(&str) -> bool) -> CppAst {
     // Visit the AST
     let mut ast = CppAst::new();
-    let root = tu.get_entity();
     let mut visited_files = std::collections::HashSet::new();
-    visit_entity(&root, &mut ast, &mut visited_files);
-    
-    Ok(ast)
+    visit_entity(root, &mut ast, &mut visited_files, lower_body);
+    ast
 }
 
-fn visit_entity(entity: &Entity, ast: &mut CppAst, visited_files: &mut std::collections::HashSet<String>) {
+fn visit_entity(
+    entity: &Entity,
+    ast: &mut CppAst,
+    visited_files: &mut std::collections::HashSet<String>,
+    lower_body: &dyn Fn(&str) -> bool,
+) {
     // Check location and filter files
     if let Some(location) = entity.get_location() {
         if let Some(file) = location.get_file_location().file {
@@ -146,7 +374,12 @@ fn visit_entity(entity: &Entity, ast: &mut CppAst, visited_files: &mut std::coll
     match entity.get_kind() {
         EntityKind::FunctionDecl | EntityKind::Method => {
             if entity.is_definition() {
-                let func = ast_visitor::extract_function(entity);
+                let name = entity.get_name().unwrap_or_else(|| "anonymous".to_string());
+                let func = if lower_body(&name) {
+                    ast_visitor::extract_function(entity)
+                } else {
+                    ast_visitor::extract_function_declaration(entity)
+                };
                 ast.functions.push(func);
             }
         }
@@ -159,7 +392,7 @@ fn visit_entity(entity: &Entity, ast: &mut CppAst, visited_files: &mut std::coll
     
     // Recursively visit children
     for child in entity.get_children() {
-        visit_entity(&child, ast, visited_files);
+        visit_entity(&child, ast, visited_files, lower_body);
     }
 }
 
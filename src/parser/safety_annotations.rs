@@ -1,6 +1,5 @@
 use std::path::Path;
-use std::fs::File;
-use std::io::{BufRead, BufReader};
+use std::fs;
 use clang::Entity;
 
 #[derive(Debug, Clone, Copy, PartialEq)]
@@ -37,15 +36,25 @@ impl SafetyContext {
         // Fall back to file default
         self.file_default == SafetyMode::Safe
     }
+    
+    /// Whether any function of the file can be checked
+    pub fn has_safe_functions(&self) -> bool {
+        self.file_default == SafetyMode::Safe ||
+            self.function_overrides.iter().any(|(_, mode)| *mode == SafetyMode::Safe)
+    }
 }
 
 /// Parse safety annotations from a C++ file using the unified rule:
 /// @safe/@unsafe attaches to the next statement/block/function/namespace
+#[allow(dead_code)]
 pub fn parse_safety_annotations(path: &Path) -> Result<SafetyContext, String> {
-    let file = File::open(path)
+    let source = fs::read_to_string(path)
         .map_err(|e| format!("Failed to open file for safety parsing: {}", e))?;
-    
-    let reader = BufReader::new(file);
+    Ok(parse_safety_annotations_from_source(&source))
+}
+
+/// Parse safety annotations from the text of a C++ file
+pub fn parse_safety_annotations_from_source(source: &str) -> SafetyContext {
     let mut context = SafetyContext::new();
     let mut pending_annotation: Option<SafetyMode> = None;
     let mut in_comment_block = false;
@@ -54,9 +63,8 @@ pub fn parse_safety_annotations(path: &Path) -> Result<SafetyContext, String> {
     let mut accumulated_line = String::new();
     let mut accumulating_for_annotation = false;
     
-    for line_result in reader.lines() {
+    for line in source.lines() {
         _current_line += 1;
-        let line = line_result.map_err(|e| format!("Failed to read line: {}", e))?;
         let trimmed = line.trim();
         
         // Handle multi-line comments
@@ -119,23 +127,23 @@ pub fn parse_safety_annotations(path: &Path) -> Result<SafetyContext, String> {
             // If we have a pending annotation and a complete declaration, apply it
             if should_check_annotation {
                 if let Some(annotation) = pending_annotation.take() {
-                    eprintln!("DEBUG SAFETY: Applying {:?} annotation to: {}", annotation, &accumulated_line);
+                    debug_trace!("DEBUG SAFETY: Applying {:?} annotation to: {}", annotation, &accumulated_line);
                     // Check what kind of code element follows
                     if accumulated_line.starts_with("namespace") || 
                        (accumulated_line.contains("namespace") && !accumulated_line.contains("using")) {
                         // Namespace declaration - applies to whole namespace contents
                         context.file_default = annotation;
-                        eprintln!("DEBUG SAFETY: Set file default to {:?} (namespace)", annotation);
+                        debug_trace!("DEBUG SAFETY: Set file default to {:?} (namespace)", annotation);
                     } else if is_function_declaration(&accumulated_line) {
                         // Function declaration - extract function name and apply ONLY to this function
                         if let Some(func_name) = extract_function_name(&accumulated_line) {
                             context.function_overrides.push((func_name.clone(), annotation));
-                            eprintln!("DEBUG SAFETY: Set function '{}' to {:?}", func_name, annotation);
+                            debug_trace!("DEBUG SAFETY: Set function '{}' to {:?}", func_name, annotation);
                         }
                     } else {
                         // Any other code - annotation was consumed but doesn't apply to whole file
                         // It only applied to this single statement/declaration
-                        eprintln!("DEBUG SAFETY: Annotation consumed by single statement: {}", &accumulated_line);
+                        debug_trace!("DEBUG SAFETY: Annotation consumed by single statement: {}", &accumulated_line);
                     }
                     accumulated_line.clear();
                     accumulating_for_annotation = false;
@@ -144,7 +152,7 @@ pub fn parse_safety_annotations(path: &Path) -> Result<SafetyContext, String> {
         }
     }
     
-    Ok(context)
+    context
 }
 
 /// Check if a line looks like a function declaration
@@ -260,4 +268,17 @@ void func() {}
         // @safe only applies to the next element (global_var), not the whole file
         assert_eq!(context.file_default, SafetyMode::Default);
     }
+    
+    #[test]
+    fn test_has_safe_functions() {
+        let legacy = parse_safety_annotations_from_source("void a() {}\n// @unsafe\nvoid b() {}\n");
+        assert!(!legacy.has_safe_functions());
+        
+        let mixed = parse_safety_annotations_from_source("void a() {}\n// @safe\nvoid b() {}\n");
+        assert!(mixed.has_safe_functions());
+        assert!(mixed.should_check_function("b") && !mixed.should_check_function("a"));
+        
+        let namespace = parse_safety_annotations_from_source("// @safe\nnamespace app {\nvoid a() {}\n}\n");
+        assert!(namespace.has_safe_functions());
+    }
 }
\ No newline at end of file
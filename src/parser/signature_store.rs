@@ -0,0 +1,397 @@
+use std::collections::HashMap;
+use std::fs;
+use std::path::{Path, PathBuf};
+
+use super::annotations::{FunctionSignature, LifetimeAnnotation, LifetimeBound, SafetyAnnotation};
+
+const MAGIC: &[u8; 4] = b"RCSC";
+// Bump when the encoding or FunctionSignature changes; older files are
+// then ignored and rebuilt
+const VERSION: u32 = 1;
+
+/// FNV-1a; stable across runs and toolchains, unlike DefaultHasher
+pub fn content_hash(bytes: &[u8]) -> u64 {
+    let mut hash: u64 = 0xcbf29ce484222325;
+    for b in bytes {
+        hash ^= *b as u64;
+        hash = hash.wrapping_mul(0x100000001b3);
+    }
+    hash
+}
+
+/// The signatures extracted from one header, and what they depend on
+#[derive(Debug, Clone)]
+pub struct StoredHeader {
+    /// Hash of the parser arguments the header was parsed with
+    pub flags_hash: u64,
+    /// The header itself and every file its parse read, with content hashes
+    pub dependencies: Vec<(PathBuf, u64)>,
+    pub signatures: Vec<FunctionSignature>,
+}
+
+/// Signatures of parsed headers, persisted in a binary file so a header
+/// is parsed once across runs and translation units. An entry is used only
+/// while its flags and the contents of all its dependencies are unchanged.
+#[derive(Debug, Default)]
+pub struct SignatureStore {
+    /// The file the store is saved to; none for an in-memory store
+    path: Option<PathBuf>,
+    entries: HashMap<PathBuf, StoredHeader>,
+    /// Content hashes computed by this process
+    file_hashes: HashMap<PathBuf, Option<u64>>,
+    dirty: bool,
+}
+
+impl SignatureStore {
+    /// Open the store at `path`. A missing, unreadable or outdated file
+    /// gives an empty store.
+    pub fn load(path: &Path) -> Self {
+        let entries = fs::read(path).ok().and_then(|bytes| decode(&bytes)).unwrap_or_default();
+        SignatureStore {
+            path: Some(path.to_path_buf()),
+            entries,
+            ..Self::default()
+        }
+    }
+
+    /// A store that lives only as long as this process
+    pub fn in_memory() -> Self {
+        Self::default()
+    }
+
+    /// Forget the content hashes computed so far, which a store assumes
+    /// unchanged. A long-running checker calls this before each file, since
+    /// headers may have been edited in between.
+    pub fn forget_file_hashes(&mut self) {
+        self.file_hashes.clear();
+    }
+
+    /// The stored signatures of `header`, if they are still valid
+    pub fn lookup(&mut self, header: &Path, flags_hash: u64) -> Option<Vec<FunctionSignature>> {
+        let entry = self.entries.get(header)?;
+        if entry.flags_hash != flags_hash {
+            return None;
+        }
+        let dependencies = entry.dependencies.clone();
+        for (file, hash) in &dependencies {
+            if self.file_hash(file) != Some(*hash) {
+                return None;
+            }
+        }
+        self.entries.get(header).map(|e| e.signatures.clone())
+    }
+
+    /// Record the signatures of a freshly parsed header
+    pub fn insert(&mut self, header: &Path, flags_hash: u64, files: &[PathBuf], signatures: Vec<FunctionSignature>) {
+        let mut dependencies = Vec::new();
+        for file in files {
+            if let Some(hash) = self.file_hash(file) {
+                dependencies.push((file.clone(), hash));
+            }
+        }
+        self.entries.insert(header.to_path_buf(), StoredHeader { flags_hash, dependencies, signatures });
+        self.dirty = true;
+    }
+
+    /// Write the store back if anything was added. Entries written by other
+    /// processes since load are kept, and the file is replaced atomically
+    /// so concurrent checkers never read a partial store.
+    pub fn save(&mut self) -> Result<(), String> {
+        let path = match &self.path {
+            Some(path) if self.dirty => path,
+            _ => return Ok(()),
+        };
+        if let Some(on_disk) = fs::read(path).ok().and_then(|bytes| decode(&bytes)) {
+            for (header, entry) in on_disk {
+                self.entries.entry(header).or_insert(entry);
+            }
+        }
+
+        let tmp = path.with_extension(format!("tmp{}", std::process::id()));
+        fs::write(&tmp, encode(&self.entries))
+            .and_then(|_| fs::rename(&tmp, path))
+            .map_err(|e| format!("Failed to write header cache {}: {}", path.display(), e))?;
+        self.dirty = false;
+        Ok(())
+    }
+
+    fn file_hash(&mut self, file: &Path) -> Option<u64> {
+        *self
+            .file_hashes
+            .entry(file.to_path_buf())
+            .or_insert_with(|| fs::read(file).ok().map(|bytes| content_hash(&bytes)))
+    }
+}
+
+fn encode(entries: &HashMap<PathBuf, StoredHeader>) -> Vec<u8> {
+    let mut out = Vec::new();
+    out.extend_from_slice(MAGIC);
+    put_u32(&mut out, VERSION);
+    put_u32(&mut out, entries.len() as u32);
+    for (header, entry) in entries {
+        put_str(&mut out, &header.to_string_lossy());
+        put_u64(&mut out, entry.flags_hash);
+        put_u32(&mut out, entry.dependencies.len() as u32);
+        for (file, hash) in &entry.dependencies {
+            put_str(&mut out, &file.to_string_lossy());
+            put_u64(&mut out, *hash);
+        }
+        put_u32(&mut out, entry.signatures.len() as u32);
+        for sig in &entry.signatures {
+            put_signature(&mut out, sig);
+        }
+    }
+    out
+}
+
+fn decode(bytes: &[u8]) -> Option<HashMap<PathBuf, StoredHeader>> {
+    let mut r = Reader::new(bytes);
+    if r.take(4)? != MAGIC || r.u32()? != VERSION {
+        return None;
+    }
+    let mut entries = HashMap::new();
+    for _ in 0..r.u32()? {
+        let header = PathBuf::from(r.string()?);
+        let flags_hash = r.u64()?;
+        let mut dependencies = Vec::new();
+        for _ in 0..r.u32()? {
+            dependencies.push((PathBuf::from(r.string()?), r.u64()?));
+        }
+        let mut signatures = Vec::new();
+        for _ in 0..r.u32()? {
+            signatures.push(r.signature()?);
+        }
+        entries.insert(header, StoredHeader { flags_hash, dependencies, signatures });
+    }
+    if !r.at_end() {
+        return None;
+    }
+    Some(entries)
+}
+
+pub(crate) fn put_u32(out: &mut Vec<u8>, v: u32) {
+    out.extend_from_slice(&v.to_le_bytes());
+}
+
+pub(crate) fn put_u64(out: &mut Vec<u8>, v: u64) {
+    out.extend_from_slice(&v.to_le_bytes());
+}
+
+pub(crate) fn put_str(out: &mut Vec<u8>, s: &str) {
+    put_u32(out, s.len() as u32);
+    out.extend_from_slice(s.as_bytes());
+}
+
+// Lifetimes are tagged 0 (none), 1 Lifetime, 2 Ref, 3 MutRef, 4 Owned
+fn put_lifetime(out: &mut Vec<u8>, lifetime: &Option<LifetimeAnnotation>) {
+    match lifetime {
+        None => out.push(0),
+        Some(LifetimeAnnotation::Lifetime(name)) => {
+            out.push(1);
+            put_str(out, name);
+        }
+        Some(LifetimeAnnotation::Ref(name)) => {
+            out.push(2);
+            put_str(out, name);
+        }
+        Some(LifetimeAnnotation::MutRef(name)) => {
+            out.push(3);
+            put_str(out, name);
+        }
+        Some(LifetimeAnnotation::Owned) => out.push(4),
+    }
+}
+
+fn put_signature(out: &mut Vec<u8>, sig: &FunctionSignature) {
+    put_str(out, &sig.name);
+    put_lifetime(out, &sig.return_lifetime);
+    put_u32(out, sig.param_lifetimes.len() as u32);
+    for param in &sig.param_lifetimes {
+        put_lifetime(out, param);
+    }
+    put_u32(out, sig.lifetime_bounds.len() as u32);
+    for bound in &sig.lifetime_bounds {
+        put_str(out, &bound.longer);
+        put_str(out, &bound.shorter);
+    }
+    out.push(match sig.safety {
+        None => 0,
+        Some(SafetyAnnotation::Safe) => 1,
+        Some(SafetyAnnotation::Unsafe) => 2,
+    });
+}
+
+/// Reads what the put_ functions write; every read fails past the end
+pub(crate) struct Reader<'a> {
+    bytes: &'a [u8],
+    pos: usize,
+}
+
+impl<'a> Reader<'a> {
+    pub(crate) fn new(bytes: &'a [u8]) -> Self {
+        Reader { bytes, pos: 0 }
+    }
+
+    pub(crate) fn at_end(&self) -> bool {
+        self.pos == self.bytes.len()
+    }
+
+    pub(crate) fn take(&mut self, n: usize) -> Option<&'a [u8]> {
+        let end = self.pos.checked_add(n)?;
+        let slice = self.bytes.get(self.pos..end)?;
+        self.pos = end;
+        Some(slice)
+    }
+
+    fn byte(&mut self) -> Option<u8> {
+        self.take(1).map(|b| b[0])
+    }
+
+    pub(crate) fn u32(&mut self) -> Option<u32> {
+        self.take(4).map(|b| u32::from_le_bytes(b.try_into().unwrap()))
+    }
+
+    pub(crate) fn u64(&mut self) -> Option<u64> {
+        self.take(8).map(|b| u64::from_le_bytes(b.try_into().unwrap()))
+    }
+
+    pub(crate) fn string(&mut self) -> Option<String> {
+        let len = self.u32()? as usize;
+        String::from_utf8(self.take(len)?.to_vec()).ok()
+    }
+
+    fn lifetime(&mut self) -> Option<Option<LifetimeAnnotation>> {
+        Some(match self.byte()? {
+            0 => None,
+            1 => Some(LifetimeAnnotation::Lifetime(self.string()?)),
+            2 => Some(LifetimeAnnotation::Ref(self.string()?)),
+            3 => Some(LifetimeAnnotation::MutRef(self.string()?)),
+            4 => Some(LifetimeAnnotation::Owned),
+            _ => return None,
+        })
+    }
+
+    fn signature(&mut self) -> Option<FunctionSignature> {
+        let name = self.string()?;
+        let return_lifetime = self.lifetime()?;
+        let mut param_lifetimes = Vec::new();
+        for _ in 0..self.u32()? {
+            param_lifetimes.push(self.lifetime()?);
+        }
+        let mut lifetime_bounds = Vec::new();
+        for _ in 0..self.u32()? {
+            lifetime_bounds.push(LifetimeBound { longer: self.string()?, shorter: self.string()? });
+        }
+        let safety = match self.byte()? {
+            0 => None,
+            1 => Some(SafetyAnnotation::Safe),
+            2 => Some(SafetyAnnotation::Unsafe),
+            _ => return None,
+        };
+        Some(FunctionSignature { name, return_lifetime, param_lifetimes, lifetime_bounds, safety })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use tempfile::TempDir;
+
+    fn signature(name: &str) -> FunctionSignature {
+        FunctionSignature {
+            name: name.to_string(),
+            return_lifetime: Some(LifetimeAnnotation::Ref("a".to_string())),
+            param_lifetimes: vec![Some(LifetimeAnnotation::MutRef("a".to_string())), None, Some(LifetimeAnnotation::Owned)],
+            lifetime_bounds: vec![LifetimeBound { longer: "a".to_string(), shorter: "b".to_string() }],
+            safety: Some(SafetyAnnotation::Safe),
+        }
+    }
+
+    #[test]
+    fn test_round_trip() {
+        let dir = TempDir::new().unwrap();
+        let header = dir.path().join("a.h");
+        fs::write(&header, "int& get(int& x);").unwrap();
+        let store_path = dir.path().join("headers.bin");
+
+        let mut store = SignatureStore::load(&store_path);
+        assert!(store.lookup(&header, 7).is_none());
+        store.insert(&header, 7, &[header.clone()], vec![signature("get")]);
+        store.save().unwrap();
+
+        let mut reloaded = SignatureStore::load(&store_path);
+        let sigs = reloaded.lookup(&header, 7).expect("stored entry should be valid");
+        assert_eq!(sigs.len(), 1);
+        assert_eq!(sigs[0].name, "get");
+        assert_eq!(sigs[0].return_lifetime, Some(LifetimeAnnotation::Ref("a".to_string())));
+        assert_eq!(sigs[0].param_lifetimes, signature("get").param_lifetimes);
+        assert_eq!(sigs[0].lifetime_bounds[0].shorter, "b");
+        assert_eq!(sigs[0].safety, Some(SafetyAnnotation::Safe));
+    }
+
+    #[test]
+    fn test_invalidated_by_flags_and_dependencies() {
+        let dir = TempDir::new().unwrap();
+        let header = dir.path().join("a.h");
+        let inner = dir.path().join("inner.h");
+        fs::write(&header, "#include \"inner.h\"").unwrap();
+        fs::write(&inner, "int f();").unwrap();
+        let store_path = dir.path().join("headers.bin");
+
+        let mut store = SignatureStore::load(&store_path);
+        store.insert(&header, 1, &[header.clone(), inner.clone()], vec![signature("f")]);
+        store.save().unwrap();
+
+        assert!(SignatureStore::load(&store_path).lookup(&header, 2).is_none());
+        assert!(SignatureStore::load(&store_path).lookup(&header, 1).is_some());
+        fs::write(&inner, "int f(); int g();").unwrap();
+        assert!(SignatureStore::load(&store_path).lookup(&header, 1).is_none());
+    }
+
+    #[test]
+    fn test_save_keeps_entries_of_other_processes() {
+        let dir = TempDir::new().unwrap();
+        let a = dir.path().join("a.h");
+        let b = dir.path().join("b.h");
+        fs::write(&a, "a").unwrap();
+        fs::write(&b, "b").unwrap();
+        let store_path = dir.path().join("headers.bin");
+
+        let mut first = SignatureStore::load(&store_path);
+        let mut second = SignatureStore::load(&store_path);
+        first.insert(&a, 0, &[a.clone()], vec![signature("fa")]);
+        second.insert(&b, 0, &[b.clone()], vec![signature("fb")]);
+        first.save().unwrap();
+        second.save().unwrap();
+
+        let mut merged = SignatureStore::load(&store_path);
+        assert!(merged.lookup(&a, 0).is_some() && merged.lookup(&b, 0).is_some());
+    }
+
+    #[test]
+    fn test_in_memory_store_sees_edits_after_forgetting_hashes() {
+        let dir = TempDir::new().unwrap();
+        let header = dir.path().join("a.h");
+        fs::write(&header, "int f();").unwrap();
+
+        let mut store = SignatureStore::in_memory();
+        store.insert(&header, 0, &[header.clone()], vec![signature("f")]);
+        store.save().unwrap();
+        assert!(store.lookup(&header, 0).is_some());
+        fs::write(&header, "int f(); int g();").unwrap();
+        // The hash computed before the edit is still assumed
+        assert!(store.lookup(&header, 0).is_some());
+        store.forget_file_hashes();
+        assert!(store.lookup(&header, 0).is_none());
+    }
+
+    #[test]
+    fn test_corrupt_file_is_ignored() {
+        assert!(decode(b"RCSC\x01\x00\x00\x00\x05").is_none());
+        assert!(decode(b"not a store").is_none());
+        let mut bytes = encode(&HashMap::new());
+        assert!(decode(&bytes).is_some());
+        bytes.push(0);
+        assert!(decode(&bytes).is_none());
+    }
+}
@@ -0,0 +1,90 @@
+use std::io::{BufRead, BufReader, Write};
+use std::net::TcpListener;
+
+use crate::batch;
+use crate::parser::signature_store::SignatureStore;
+use crate::parser::{self, WarmIndex};
+use crate::Session;
+
+/// Answer check requests on `address` (host:port), or on stdin and stdout
+/// when it is "-", until the input ends.
+///
+/// Every request is one line holding a compile_commands.json entry (only
+/// "file" is required); its answer is one line with the report
+/// `--format json` prints. Requests are answered in order on this
+/// process's one Clang instance, which keeps each file's translation unit
+/// for reparsing, along with the header signatures and, with
+/// --incremental, the diagnostics of unchanged functions.
+pub fn serve(address: &str, args: &crate::Args) -> Result<(), String> {
+    let mut session = Session::new(args.header_cache.as_deref());
+    session.header_store.get_or_insert_with(SignatureStore::in_memory);
+
+    parser::with_warm_index(|warm| {
+        if address == "-" {
+            let stdin = std::io::stdin();
+            return answer(stdin.lock(), std::io::stdout(), args, &mut session, warm);
+        }
+
+        let listener = TcpListener::bind(address)
+            .map_err(|e| format!("Failed to listen on {}: {}", address, e))?;
+        eprintln!("Listening on {}", listener.local_addr().map_err(|e| e.to_string())?);
+        for stream in listener.incoming() {
+            let result = stream
+                .and_then(|stream| Ok((BufReader::new(stream.try_clone()?), stream)))
+                .map_err(|e| e.to_string())
+                .and_then(|(input, output)| answer(input, output, args, &mut session, warm));
+            if let Err(e) = result {
+                eprintln!("Connection dropped: {}", e);
+            }
+        }
+        Ok(())
+    })?
+}
+
+/// Answer each request line of `input` on `output`
+fn answer(input: impl BufRead, mut output: impl Write, args: &crate::Args, session: &mut Session, warm: &mut WarmIndex) -> Result<(), String> {
+    for line in input.lines() {
+        let line = line.map_err(|e| e.to_string())?;
+        if line.trim().is_empty() {
+            continue;
+        }
+        let report = match parse_request(&line) {
+            Ok(command) => {
+                let include_paths: Vec<_> = args.include_paths.iter().chain(&command.include_paths).cloned().collect();
+                let defines: Vec<_> = args.defines.iter().chain(&command.defines).cloned().collect();
+                let mut time_report = crate::timing::TimeReport::default();
+                let std = args.std.as_deref().or(command.std.as_deref());
+                let outcome = crate::analyze_file(&command.file, &include_paths, &defines, std, args, session, Some(warm), &mut time_report);
+                let time_report = args.time_report.map(|n| time_report.to_json(n));
+                batch::unit_report_json(&command.file, &outcome, time_report.as_ref())
+            }
+            Err(error) => serde_json::json!({ "error": error }).to_string(),
+        };
+        writeln!(output, "{}", report).and_then(|_| output.flush()).map_err(|e| e.to_string())?;
+    }
+    Ok(())
+}
+
+fn parse_request(line: &str) -> Result<batch::CompileCommand, String> {
+    let entry: serde_json::Value = serde_json::from_str(line)
+        .map_err(|e| format!("Unreadable request: {}", e))?;
+    batch::parse_compile_command(&entry)
+        .ok_or_else(|| "Request has no \"file\"".to_string())
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::path::PathBuf;
+
+    #[test]
+    fn test_parse_request() {
+        let command = parse_request(r#"{"file": "a.cpp", "arguments": ["c++", "-Iinclude", "-DX=1"]}"#).unwrap();
+        assert_eq!(command.file, PathBuf::from("./a.cpp"));
+        assert_eq!(command.include_paths, vec![PathBuf::from("./include")]);
+        assert_eq!(command.defines, vec!["X=1".to_string()]);
+
+        assert!(parse_request("a.cpp").unwrap_err().starts_with("Unreadable request"));
+        assert_eq!(parse_request(r#"{"directory": "/build"}"#).unwrap_err(), "Request has no \"file\"");
+    }
+}
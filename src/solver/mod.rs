@@ -1,59 +1,224 @@
-use z3::{Context, Solver};
-use std::collections::HashMap;
+use std::collections::hash_map::DefaultHasher;
+use std::collections::{HashMap, VecDeque};
+use std::hash::{Hash, Hasher};
+use std::sync::{Arc, Mutex};
 
-#[allow(dead_code)]
-pub struct ConstraintSolver<'ctx> {
-    solver: Solver<'ctx>,
+/// Answers outlives queries over lifetime bounds such as `'a: 'b`.
+///
+/// Lifetimes that outlive each other in a cycle must be equal, so they are
+/// merged with union-find as the bounds arrive. That leaves an acyclic
+/// graph of outlives edges, and `'a` outlives `'b` exactly when the root of
+/// `'a` reaches the root of `'b`.
+#[derive(Debug, Default, Clone)]
+pub struct ConstraintSolver {
+    ids: HashMap<String, usize>,
+    names: Vec<String>,
+    /// Union-find parent of each lifetime
+    parent: Vec<usize>,
+    /// The lifetimes merged into each root
+    members: Vec<Vec<usize>>,
+    /// Lifetimes each lifetime outlives directly
+    outlives: Vec<Vec<usize>>,
 }
 
-impl<'ctx> ConstraintSolver<'ctx> {
-    #[allow(dead_code)]
-    pub fn new(context: &'ctx Context) -> Self {
-        let solver = Solver::new(context);
-        Self { solver }
-    }
-    
-    #[allow(dead_code)]
-    pub fn add_lifetime_constraint(&mut self, constraint: LifetimeConstraint) {
-        // Convert lifetime constraints to Z3 assertions
-        match constraint {
-            LifetimeConstraint::Outlives { longer: _, shorter: _ } => {
-                // Add SMT constraint: longer >= shorter
-            }
-            LifetimeConstraint::MustBeValid { lifetime: _, point: _ } => {
-                // Add SMT constraint: lifetime.start <= point <= lifetime.end
-            }
+impl ConstraintSolver {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Record that `longer` is live wherever `shorter` is
+    pub fn add_outlives(&mut self, longer: &str, shorter: &str) {
+        let (longer, shorter) = (self.intern(longer), self.intern(shorter));
+        self.add_edge(longer, shorter);
+    }
+
+    /// Whether the constraints so far force `longer` to outlive `shorter`
+    pub fn outlives(&self, longer: &str, shorter: &str) -> bool {
+        if longer == shorter {
+            return true;
+        }
+        match (self.ids.get(longer), self.ids.get(shorter)) {
+            (Some(&longer), Some(&shorter)) => self.reaches(self.find(longer), self.find(shorter)),
+            _ => false,
         }
     }
-    
-    #[allow(dead_code)]
-    pub fn solve(&self) -> Result<Solution, String> {
-        match self.solver.check() {
-            z3::SatResult::Sat => {
-                // Extract model and return solution
-                Ok(Solution {
-                    lifetimes: HashMap::new(),
-                })
-            }
-            z3::SatResult::Unsat => {
-                Err("Lifetime constraints are unsatisfiable".to_string())
+
+    /// The lifetimes that the constraints so far force `longer` to outlive,
+    /// itself excluded
+    pub fn outlived_by(&self, longer: &str) -> Vec<&str> {
+        let Some(&id) = self.ids.get(longer) else { return Vec::new() };
+        let reached = self.reachable(self.find(id));
+        let mut names: Vec<&str> = (0..self.names.len())
+            .filter(|&other| other != id && reached[self.find(other)])
+            .map(|other| self.names[other].as_str())
+            .collect();
+        names.sort_unstable();
+        names
+    }
+
+    /// Every lifetime the constraints mention
+    pub fn lifetimes(&self) -> impl Iterator<Item = &str> {
+        self.names.iter().map(String::as_str)
+    }
+
+    fn intern(&mut self, name: &str) -> usize {
+        if let Some(&id) = self.ids.get(name) {
+            return id;
+        }
+        let id = self.names.len();
+        self.ids.insert(name.to_string(), id);
+        self.names.push(name.to_string());
+        self.parent.push(id);
+        self.members.push(vec![id]);
+        self.outlives.push(Vec::new());
+        id
+    }
+
+    fn find(&self, mut id: usize) -> usize {
+        while self.parent[id] != id {
+            id = self.parent[id];
+        }
+        id
+    }
+
+    fn add_edge(&mut self, longer: usize, shorter: usize) {
+        let (root_longer, root_shorter) = (self.find(longer), self.find(shorter));
+        if root_longer == root_shorter {
+            return;
+        }
+        self.outlives[longer].push(shorter);
+        if !self.reaches(root_shorter, root_longer) {
+            return;
+        }
+        // The new edge closes a cycle: every lifetime on a path from
+        // `shorter` back to `longer` is equal to both
+        let from_shorter = self.reachable(root_shorter);
+        let to_longer = self.reaching(root_longer);
+        let cycle: Vec<usize> = (0..self.names.len())
+            .filter(|&id| self.parent[id] == id && from_shorter[id] && to_longer[id])
+            .collect();
+        for &root in &cycle[1..] {
+            let first = self.find(cycle[0]);
+            self.union(first, root);
+        }
+    }
+
+    /// Merge two roots, keeping the one with more members as the root
+    fn union(&mut self, a: usize, b: usize) {
+        let (root, child) = if self.members[a].len() >= self.members[b].len() { (a, b) } else { (b, a) };
+        self.parent[child] = root;
+        let moved = std::mem::take(&mut self.members[child]);
+        self.members[root].extend(moved);
+    }
+
+    /// The roots the members of `root` outlive directly
+    fn successors(&self, root: usize) -> impl Iterator<Item = usize> + '_ {
+        self.members[root].iter().flat_map(move |&m| self.outlives[m].iter().map(move |&s| self.find(s)))
+    }
+
+    fn reaches(&self, from: usize, to: usize) -> bool {
+        from == to || self.reachable(from)[to]
+    }
+
+    /// The roots `root` outlives, itself included
+    fn reachable(&self, root: usize) -> Vec<bool> {
+        let mut seen = vec![false; self.names.len()];
+        let mut queue = VecDeque::from([root]);
+        seen[root] = true;
+        while let Some(next) = queue.pop_front() {
+            for succ in self.successors(next) {
+                if !seen[succ] {
+                    seen[succ] = true;
+                    queue.push_back(succ);
+                }
             }
-            z3::SatResult::Unknown => {
-                Err("Could not determine satisfiability".to_string())
+        }
+        seen
+    }
+
+    /// The roots that outlive `root`, itself included
+    fn reaching(&self, root: usize) -> Vec<bool> {
+        let roots: Vec<usize> = (0..self.names.len()).filter(|&id| self.parent[id] == id).collect();
+        let mut seen = vec![false; self.names.len()];
+        seen[root] = true;
+        let mut changed = true;
+        while changed {
+            changed = false;
+            for &other in &roots {
+                if !seen[other] && self.successors(other).any(|succ| seen[succ]) {
+                    seen[other] = true;
+                    changed = true;
+                }
             }
         }
+        seen
     }
 }
 
-#[derive(Debug)]
-#[allow(dead_code)]
-pub enum LifetimeConstraint {
-    Outlives { longer: String, shorter: String },
-    MustBeValid { lifetime: String, point: usize },
+/// Outlives relations implied by a function signature's lifetime bounds,
+/// solved once per signature and shared between all its call sites
+#[derive(Debug, Default)]
+pub struct SignatureCache {
+    solved: Mutex<HashMap<(String, u64), Arc<ConstraintSolver>>>,
 }
 
-#[derive(Debug)]
-#[allow(dead_code)]
-pub struct Solution {
-    pub lifetimes: HashMap<String, (usize, usize)>,
-}
\ No newline at end of file
+impl SignatureCache {
+    /// The solver for the bounds `(longer, shorter)` of function `name`
+    pub fn bounds(&self, name: &str, bounds: &[(&str, &str)]) -> Arc<ConstraintSolver> {
+        let mut hasher = DefaultHasher::new();
+        bounds.hash(&mut hasher);
+        let key = (name.to_string(), hasher.finish());
+        let mut solved = self.solved.lock().unwrap();
+        Arc::clone(solved.entry(key).or_insert_with(|| {
+            let mut solver = ConstraintSolver::new();
+            for (longer, shorter) in bounds {
+                solver.add_outlives(longer, shorter);
+            }
+            Arc::new(solver)
+        }))
+    }
+
+    #[cfg(test)]
+    fn len(&self) -> usize {
+        self.solved.lock().unwrap().len()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_outlives_is_transitive() {
+        let mut solver = ConstraintSolver::new();
+        solver.add_outlives("a", "b");
+        solver.add_outlives("b", "c");
+        assert!(solver.outlives("a", "c"));
+        assert!(solver.outlives("a", "a"));
+        assert!(!solver.outlives("c", "a"));
+        assert!(!solver.outlives("a", "unknown"));
+        assert_eq!(solver.outlived_by("a"), vec!["b", "c"]);
+    }
+
+    #[test]
+    fn test_cycle_makes_lifetimes_equal() {
+        let mut solver = ConstraintSolver::new();
+        solver.add_outlives("a", "b");
+        solver.add_outlives("b", "c");
+        solver.add_outlives("c", "a");
+        assert!(solver.outlives("c", "b"));
+        assert_eq!(solver.find(0), solver.find(1));
+        assert_eq!(solver.find(1), solver.find(2));
+    }
+
+    #[test]
+    fn test_signature_cache_reuses_solutions() {
+        let cache = SignatureCache::default();
+        let first = cache.bounds("f", &[("a", "b"), ("b", "c")]);
+        let again = cache.bounds("f", &[("a", "b"), ("b", "c")]);
+        assert!(Arc::ptr_eq(&first, &again));
+        assert!(again.outlives("a", "c"));
+        cache.bounds("g", &[("a", "b")]);
+        assert_eq!(cache.len(), 2);
+    }
+}
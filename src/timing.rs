@@ -0,0 +1,168 @@
+use std::time::{Duration, Instant};
+
+/// Wall time spent in each named phase, in the order phases first ran
+#[derive(Debug, Default, Clone)]
+pub struct PhaseTimes {
+    phases: Vec<(&'static str, Duration)>,
+}
+
+impl PhaseTimes {
+    /// Run `f`, adding its wall time to `phase`
+    pub fn time<R>(&mut self, phase: &'static str, f: impl FnOnce() -> R) -> R {
+        let start = Instant::now();
+        let result = f();
+        self.add(phase, start.elapsed());
+        result
+    }
+
+    pub fn add(&mut self, phase: &'static str, duration: Duration) {
+        match self.phases.iter_mut().find(|(name, _)| *name == phase) {
+            Some((_, total)) => *total += duration,
+            None => self.phases.push((phase, duration)),
+        }
+    }
+
+    pub fn merge(&mut self, other: &PhaseTimes) {
+        for (phase, duration) in &other.phases {
+            self.add(phase, *duration);
+        }
+    }
+
+    pub fn total(&self) -> Duration {
+        self.phases.iter().map(|(_, d)| *d).sum()
+    }
+
+    fn to_json(&self) -> serde_json::Value {
+        let phases: serde_json::Map<String, serde_json::Value> = self
+            .phases
+            .iter()
+            .map(|(name, d)| (name.to_string(), serde_json::json!(millis(*d))))
+            .collect();
+        serde_json::Value::Object(phases)
+    }
+
+    fn describe(&self) -> String {
+        self.phases
+            .iter()
+            .map(|(name, d)| format!("{} {:.2} ms", name, millis(*d)))
+            .collect::<Vec<_>>()
+            .join(", ")
+    }
+}
+
+/// Where the time of checking one file went: its phases, and the checks
+/// of each function
+#[derive(Debug, Default)]
+pub struct TimeReport {
+    pub phases: PhaseTimes,
+    /// The function checks of `functions`, summed over all functions (so
+    /// over all threads)
+    pub function_phases: PhaseTimes,
+    pub functions: Vec<(String, PhaseTimes)>,
+    pub wall: Duration,
+}
+
+impl TimeReport {
+    pub fn add_function(&mut self, name: &str, times: PhaseTimes) {
+        self.function_phases.merge(&times);
+        self.functions.push((name.to_string(), times));
+    }
+
+    /// The `n` functions whose checks took longest
+    pub fn slowest(&self, n: usize) -> Vec<&(String, PhaseTimes)> {
+        let mut functions: Vec<_> = self.functions.iter().collect();
+        functions.sort_by(|a, b| b.1.total().cmp(&a.1.total()).then_with(|| a.0.cmp(&b.0)));
+        functions.truncate(n);
+        functions
+    }
+
+    /// The report as the "time_report" field of the JSON output, with the
+    /// `slowest` slowest functions; times are in milliseconds
+    pub fn to_json(&self, slowest: usize) -> serde_json::Value {
+        let functions: Vec<_> = self
+            .slowest(slowest)
+            .into_iter()
+            .map(|(name, times)| serde_json::json!({
+                "name": name,
+                "total_ms": millis(times.total()),
+                "phases_ms": times.to_json(),
+            }))
+            .collect();
+        serde_json::json!({
+            "wall_ms": millis(self.wall),
+            "phases_ms": self.phases.to_json(),
+            "function_phases_ms": self.function_phases.to_json(),
+            "functions_checked": self.functions.len(),
+            "slowest_functions": functions,
+            "peak_memory_kb": peak_memory_kb(),
+        })
+    }
+
+    /// Print the report for `file` to stderr, with the `slowest` slowest
+    /// functions
+    pub fn print(&self, file: &std::path::Path, slowest: usize) {
+        eprintln!("Time report for {} ({:.2} ms):", file.display(), millis(self.wall));
+        for (name, d) in &self.phases.phases {
+            eprintln!("  {:<28} {:>10.2} ms", name, millis(*d));
+        }
+        for (name, d) in &self.function_phases.phases {
+            eprintln!("  {:<28} {:>10.2} ms  (summed over functions)", name, millis(*d));
+        }
+        if let Some(kb) = peak_memory_kb() {
+            eprintln!("  {:<28} {:>10} KB", "peak memory", kb);
+        }
+        let functions = self.slowest(slowest);
+        if !functions.is_empty() {
+            eprintln!("  Slowest of {} function(s):", self.functions.len());
+            for (name, times) in functions {
+                eprintln!("    {:.2} ms  {}  ({})", millis(times.total()), name, times.describe());
+            }
+        }
+    }
+}
+
+pub fn millis(duration: Duration) -> f64 {
+    duration.as_secs_f64() * 1000.0
+}
+
+/// The peak resident set size of this process, where the OS reports it
+pub fn peak_memory_kb() -> Option<u64> {
+    let status = std::fs::read_to_string("/proc/self/status").ok()?;
+    let line = status.lines().find(|l| l.starts_with("VmHWM:"))?;
+    line.split_whitespace().nth(1)?.parse().ok()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_phase_times_accumulate() {
+        let mut times = PhaseTimes::default();
+        times.add("parse", Duration::from_millis(2));
+        times.add("check", Duration::from_millis(1));
+        times.add("parse", Duration::from_millis(3));
+        assert_eq!(times.total(), Duration::from_millis(6));
+        assert_eq!(times.phases[0], ("parse", Duration::from_millis(5)));
+        assert_eq!(times.time("check", || 7), 7);
+        assert_eq!(times.phases.len(), 2);
+    }
+
+    #[test]
+    fn test_slowest_functions() {
+        let mut report = TimeReport::default();
+        for (name, ms) in [("a", 1), ("b", 5), ("c", 3)] {
+            let mut times = PhaseTimes::default();
+            times.add("ownership analysis", Duration::from_millis(ms));
+            report.add_function(name, times);
+        }
+        let names: Vec<_> = report.slowest(2).iter().map(|(n, _)| n.as_str()).collect();
+        assert_eq!(names, vec!["b", "c"]);
+        assert_eq!(report.function_phases.total(), Duration::from_millis(9));
+
+        let json = report.to_json(1);
+        assert_eq!(json["functions_checked"], 3);
+        assert_eq!(json["slowest_functions"][0]["name"], "b");
+        assert_eq!(json["function_phases_ms"]["ownership analysis"], 9.0);
+    }
+}
@@ -1 +1 @@
-  Z3_SYS_Z3_HEADER=/opt/homebrew/include/z3.h DYLD_LIBRARY_PATH=/opt/homebrew/Cellar/llvm/19.1.7/lib:$DYLD_LIBRARY_PATH cargo test
+  DYLD_LIBRARY_PATH=/opt/homebrew/Cellar/llvm/19.1.7/lib:$DYLD_LIBRARY_PATH cargo test
@@ -8,7 +8,6 @@ use std::env;
 fn run_analyzer(cpp_file: &Path) -> (bool, String) {
     let output = Command::new("cargo")
         .args(&["run", "--quiet", "--", cpp_file.to_str().unwrap()])
-        .env("Z3_SYS_Z3_HEADER", "/opt/homebrew/include/z3.h")
         .env("DYLD_LIBRARY_PATH", "/opt/homebrew/Cellar/llvm/19.1.7/lib")
         .output()
         .expect("Failed to execute analyzer");
@@ -471,7 +470,6 @@ void test_env() {
     let output = Command::new("cargo")
         .args(&["run", "--quiet", "--", cpp_path.to_str().unwrap()])
         .env("CPLUS_INCLUDE_PATH", include_dir.to_str().unwrap())
-        .env("Z3_SYS_Z3_HEADER", "/opt/homebrew/include/z3.h")
         .env("DYLD_LIBRARY_PATH", "/opt/homebrew/Cellar/llvm/19.1.7/lib")
         .output()
         .expect("Failed to execute analyzer");
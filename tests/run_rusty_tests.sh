@@ -15,28 +15,84 @@ FAILED=0
 TOTAL=0
 
 # Compile flags
-CXX="clang++"
-CXXFLAGS="-std=c++11 -Wall -Wextra -I../include"
+CXX="${CXX:-clang++}"
+CXXFLAGS="-Wall -Wextra -I../include"
 
-# List of test files
+# List of test files (the core types must stay C++11-compatible)
 TESTS=(
     "rusty_box_test"
+    "rusty_pool_test"
     "rusty_arc_test"
+    "rusty_arc_swap_test"
+    "rusty_sync_test"
+    "rusty_mpsc_test"
+    "rusty_thread_test"
     "rusty_rc_test"
     "rusty_vec_test"
+    "rusty_smallvec_test"
+    "rusty_vecdeque_test"
+    "rusty_binaryheap_test"
+    "rusty_bitvec_test"
+    "rusty_slice_test"
+    "rusty_sort_test"
+    "rusty_iter_test"
     "rusty_option_test"
     "rusty_result_test"
+    "rusty_arena_test"
+    "rusty_slab_test"
+    "rusty_hashmap_test"
+    "rusty_hashmap_swar_test"
+    "rusty_smallmap_test"
+    "rusty_soavec_test"
+)
+
+# Tests for headers that need C++17 (string_view, structured bindings)
+CXX17_TESTS=(
+    "rusty_alloc_test"
+    "rusty_hashset_test"
+    "rusty_indexmap_test"
+    "rusty_frozen_test"
+    "rusty_concurrent_hashmap_test"
+    "rusty_lru_test"
+    "rusty_thread_pool_test"
+    "rusty_par_iter_test"
+    "rusty_btreemap_test"
+    "rusty_persistent_test"
+    "rusty_slice_ptr_test"
+    "rusty_archive_test"
+    "rusty_io_test"
+    "rusty_string_test"
+    "rusty_string_swar_test"
+    "rusty_rope_test"
+    "rusty_arrayvec_test"
+    "rusty_fwd_test"
+    "rusty_cow_test"
+    "rusty_format_test"
+    "rusty_interner_test"
+    "rusty_stats_test"
+    "rusty_stats_enabled_test"
+    "rusty_alloc_observer_test"
+    "rusty_bounds_test"
+    "rusty_bounds_unchecked_test"
+)
+
+# Tests for headers that need C++20 (coroutines)
+CXX20_TESTS=(
+    "rusty_task_test"
+    "rusty_constexpr_test"
 )
 
 # Create build directory if it doesn't exist
 mkdir -p build
 
 # Compile and run each test
-for test in "${TESTS[@]}"; do
+run_test() {
+    local test="$1"
+    local std="$2"
     echo ""
     echo "Building $test..."
     
-    if $CXX $CXXFLAGS "$test.cpp" -o "build/$test" -pthread 2>/dev/null; then
+    if $CXX -std=$std $CXXFLAGS "$test.cpp" -o "build/$test" -pthread 2>/dev/null; then
         echo "Running $test..."
         if "./build/$test"; then
             echo -e "${GREEN}✓ $test passed${NC}"
@@ -49,6 +105,18 @@ for test in "${TESTS[@]}"; do
         ((FAILED++))
     fi
     ((TOTAL++))
+}
+
+for test in "${TESTS[@]}"; do
+    run_test "$test" c++11
+done
+
+for test in "${CXX17_TESTS[@]}"; do
+    run_test "$test" c++17
+done
+
+for test in "${CXX20_TESTS[@]}"; do
+    run_test "$test" c++20
 done
 
 echo ""
@@ -0,0 +1,187 @@
+// Tests for the allocation observer hooks
+#include "../include/rusty/alloc_observer.hpp"
+#include "../include/rusty/arc.hpp"
+#include "../include/rusty/box.hpp"
+#include "../include/rusty/btreemap.hpp"
+#include "../include/rusty/hashmap.hpp"
+#include "../include/rusty/rc.hpp"
+#include "../include/rusty/string.hpp"
+#include "../include/rusty/vec.hpp"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+using namespace rusty;
+
+static const AllocKind KINDS[] = {AllocKind::Vec, AllocKind::String, AllocKind::HashMap,
+                                  AllocKind::BTreeMap, AllocKind::Box, AllocKind::Arc,
+                                  AllocKind::Rc};
+
+// Test that every container kind reports balanced events
+void test_alloc_observer_kinds() {
+    printf("test_alloc_observer_kinds: ");
+    {
+        AllocTally tally;
+        assert(set_alloc_observer(&tally) == nullptr);
+        {
+            Vec<int> v;
+            for (int i = 0; i < 1000; i++) v.push(i);
+            String s = String::from("a string that does not fit inline");
+            for (int i = 0; i < 100; i++) s.push_str("more");
+            HashMap<int, int> m;
+            for (int i = 0; i < 1000; i++) m.insert(i, i);
+            BTreeMap<int, int> t;
+            for (int i = 0; i < 1000; i++) t.insert(i, i);
+            Box<int> b = Box<int>::make(1);
+            Arc<int> a = Arc<int>::make(2);
+            Rc<int> r = Rc<int>::make(3);
+            Rc<int> r2 = r.clone();
+
+            for (AllocKind kind : KINDS) {
+                assert(tally.counts(kind).allocs > 0);
+                assert(tally.live_bytes(kind) > 0);
+            }
+            assert(tally.live_bytes(AllocKind::Vec) == int64_t(v.capacity() * sizeof(int)));
+            assert(tally.counts(AllocKind::Rc).allocs == 1);
+            assert(tally.counts(AllocKind::Box).live_bytes() == int64_t(sizeof(int)));
+            // Growth is a free of the old block plus a new one
+            assert(tally.counts(AllocKind::Vec).allocs > 1);
+            assert(tally.counts(AllocKind::Vec).live_blocks() == 1);
+        }
+        for (AllocKind kind : KINDS) {
+            AllocTally::Counts c = tally.counts(kind);
+            assert(c.live_blocks() == 0 && c.live_bytes() == 0);
+        }
+        assert(std::strcmp(alloc_kind_name(AllocKind::BTreeMap), "BTreeMap") == 0);
+
+        assert(set_alloc_observer(nullptr) == &tally);
+        Vec<int> unseen;
+        unseen.push(1);
+        assert(tally.counts(AllocKind::Vec).live_blocks() == 0);
+    }
+    printf("PASS\n");
+}
+
+// Test AllocSite labels and Box ownership transfer
+void test_alloc_observer_sites() {
+    printf("test_alloc_observer_sites: ");
+    {
+        static const char* const CACHE = "cache";
+        static const char* const INDEX = "index";
+        AllocTally tally;
+        set_alloc_observer(&tally);
+        {
+            HashMap<int, int> cache;
+            Vec<int> index;
+            Vec<int> loose;
+            loose.push(1);
+            {
+                AllocSite site(CACHE);
+                for (int i = 0; i < 100; i++) cache.insert(i, i);
+                {
+                    AllocSite inner(INDEX);
+                    assert(AllocSite::current() == INDEX);
+                    index.push(1);
+                }
+                assert(AllocSite::current() == CACHE);
+            }
+            assert(AllocSite::current() == nullptr);
+            assert(tally.site_counts(CACHE, AllocKind::HashMap).allocs > 0);
+            assert(tally.site_counts(CACHE, AllocKind::Vec).allocs == 0);
+            assert(tally.site_counts(INDEX, AllocKind::Vec).allocs == 1);
+            // A default-constructed map allocates on its first insert, so
+            // only loose's buffer is unlabeled
+            assert(tally.site_counts(nullptr, AllocKind::HashMap).allocs == 0);
+            assert(tally.site_counts(nullptr, AllocKind::Vec).allocs == 1);
+
+            size_t rows = 0;
+            tally.for_each_site([&](const AllocTally::SiteRow&) { rows++; });
+            assert(rows == 3);
+        }
+
+        // into_raw gives the block up, from_raw takes it back
+        Box<int> b = Box<int>::make(5);
+        int* raw = b.into_raw();
+        assert(tally.counts(AllocKind::Box).live_blocks() == 0);
+        Box<int> again(raw);
+        assert(tally.counts(AllocKind::Box).live_blocks() == 1);
+        again.reset(new int(6));
+        assert(tally.counts(AllocKind::Box).live_blocks() == 1);
+        again.reset();
+        assert(tally.counts(AllocKind::Box).live_blocks() == 0);
+        set_alloc_observer(nullptr);
+    }
+    printf("PASS\n");
+}
+
+// An observer that allocates through rusty containers itself
+class Recording : public AllocObserver {
+public:
+    Vec<size_t> sizes;
+
+    void on_alloc(const AllocEvent& event) override { sizes.push(event.size); }
+    void on_dealloc(const AllocEvent&) override {}
+};
+
+// Test that the observer's own allocations are not reported to it
+void test_alloc_observer_reentrancy() {
+    printf("test_alloc_observer_reentrancy: ");
+    {
+        Recording rec;
+        set_alloc_observer(&rec);
+        {
+            Vec<int> v;
+            for (int i = 0; i < 100; i++) v.push(i);
+        }
+        set_alloc_observer(nullptr);
+        // 4 -> 8 -> ... -> 128: six blocks, none of them rec.sizes' own
+        assert(rec.sizes.len() == 6);
+        assert(rec.sizes[0] == 4 * sizeof(int) && rec.sizes[5] == 128 * sizeof(int));
+    }
+    printf("PASS\n");
+}
+
+// Test events from several threads, each under its own site
+void test_alloc_observer_threads() {
+    printf("test_alloc_observer_threads: ");
+    {
+        static const char* const LABELS[] = {"t0", "t1", "t2", "t3"};
+        AllocTally tally;
+        set_alloc_observer(&tally);
+        std::thread threads[4];
+        for (int t = 0; t < 4; t++) {
+            threads[t] = std::thread([t] {
+                AllocSite site(LABELS[t]);
+                for (int round = 0; round < 50; round++) {
+                    HashMap<int, int> m;
+                    for (int i = 0; i < 100; i++) m.insert(i, i);
+                    Arc<int> a = Arc<int>::make(round);
+                }
+            });
+        }
+        for (std::thread& th : threads) th.join();
+        set_alloc_observer(nullptr);
+
+        for (int t = 0; t < 4; t++) {
+            AllocTally::Counts arc = tally.site_counts(LABELS[t], AllocKind::Arc);
+            assert(arc.allocs == 50 && arc.live_blocks() == 0);
+            AllocTally::Counts map = tally.site_counts(LABELS[t], AllocKind::HashMap);
+            assert(map.allocs >= 50 && map.live_bytes() == 0);
+        }
+        assert(tally.counts(AllocKind::Arc).allocs == 200);
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty allocation observer ===\n");
+
+    test_alloc_observer_kinds();
+    test_alloc_observer_sites();
+    test_alloc_observer_reentrancy();
+    test_alloc_observer_threads();
+
+    printf("\nAll allocation observer tests passed!\n");
+    return 0;
+}
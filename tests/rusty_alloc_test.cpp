@@ -0,0 +1,286 @@
+// Tests for allocator support in rusty containers
+#include "../include/rusty/vec.hpp"
+#include "../include/rusty/string.hpp"
+#include "../include/rusty/hashmap.hpp"
+#include "../include/rusty/hashset.hpp"
+#include "../include/rusty/btreemap.hpp"
+#include "../include/rusty/btreeset.hpp"
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <new>
+
+using namespace rusty;
+
+// Stateful allocator that counts live blocks in a shared counter
+struct CountingAlloc {
+    struct Stats {
+        long live_blocks = 0;
+        long total_allocs = 0;
+    };
+    Stats* stats;
+
+    CountingAlloc() : stats(nullptr) {}
+    explicit CountingAlloc(Stats* s) : stats(s) {}
+
+    void* allocate(size_t size, size_t align) {
+        stats->live_blocks++;
+        stats->total_allocs++;
+        return Global().allocate(size, align);
+    }
+
+    void deallocate(void* ptr, size_t size, size_t align) {
+        stats->live_blocks--;
+        Global().deallocate(ptr, size, align);
+    }
+
+    bool operator==(const CountingAlloc& other) const { return stats == other.stats; }
+};
+
+// Allocator without reallocate() to exercise the allocate+copy fallback
+struct NoReallocAlloc {
+    void* allocate(size_t size, size_t align) { return Global().allocate(size, align); }
+    void deallocate(void* ptr, size_t size, size_t align) { Global().deallocate(ptr, size, align); }
+};
+
+// Allocator that fails once a byte budget is used up
+struct BudgetAlloc {
+    size_t* remaining;
+
+    BudgetAlloc() : remaining(nullptr) {}
+    explicit BudgetAlloc(size_t* budget) : remaining(budget) {}
+
+    void* allocate(size_t size, size_t align) {
+        if (size > *remaining) return nullptr;
+        *remaining -= size;
+        return Global().allocate(size, align);
+    }
+
+    void deallocate(void* ptr, size_t size, size_t align) {
+        *remaining += size;
+        Global().deallocate(ptr, size, align);
+    }
+};
+
+void test_global_is_free() {
+    printf("test_global_is_free: ");
+    {
+        static_assert(sizeof(Vec<int>) == 3 * sizeof(void*), "Global takes no space in Vec");
+        static_assert(sizeof(String) == 3 * sizeof(void*), "Global takes no space in String");
+        static_assert(alloc_has_reallocate<Global>::value, "Global can reallocate");
+        static_assert(!alloc_has_reallocate<NoReallocAlloc>::value, "detects missing reallocate");
+    }
+    printf("PASS\n");
+}
+
+void test_vec_alloc() {
+    printf("test_vec_alloc: ");
+    CountingAlloc::Stats stats;
+    {
+        auto vec = Vec<int, CountingAlloc>::new_in(CountingAlloc(&stats));
+        for (int i = 0; i < 100; i++) {
+            vec.push(i);
+        }
+        assert(stats.live_blocks == 1);
+        assert(stats.total_allocs > 1);
+
+        auto copy = vec.clone();
+        assert(copy.allocator() == vec.allocator());
+        assert(stats.live_blocks == 2);
+
+        auto moved = std::move(vec);
+        assert(stats.live_blocks == 2);
+        assert(moved[99] == 99);
+
+        auto fallback = Vec<int, NoReallocAlloc>::new_();
+        for (int i = 0; i < 100; i++) {
+            fallback.push(i);
+        }
+        assert(fallback[50] == 50);
+    }
+    assert(stats.live_blocks == 0);
+    printf("PASS\n");
+}
+
+void test_string_alloc() {
+    printf("test_string_alloc: ");
+    CountingAlloc::Stats stats;
+    {
+        using AString = BasicString<CountingAlloc>;
+        auto s = AString::new_in(CountingAlloc(&stats));
+        s.push_str("hello");
+        s.push_str(" world, this is long enough to grow");
+        assert(s.starts_with("hello"));
+        assert(stats.live_blocks == 1);
+
+        auto up = s.to_uppercase();
+        assert(up.is_owned() && up.as_ref().starts_with("HELLO"));
+        assert(stats.live_blocks == 2);
+
+        // Nothing to replace: the result borrows s
+        auto same = s.replace("xyz", "abc");
+        assert(same.is_borrowed() && same == s);
+        assert(stats.live_blocks == 2);
+
+        auto parts = s.split(' ').collect();
+        assert(parts.size() == 8);
+        assert(parts[1] == "world,");
+        assert(stats.live_blocks == 2);
+    }
+    assert(stats.live_blocks == 0);
+    printf("PASS\n");
+}
+
+void test_hashmap_alloc() {
+    printf("test_hashmap_alloc: ");
+    CountingAlloc::Stats stats;
+    {
+        using Map = HashMap<int, int, std::hash<int>, std::equal_to<int>, CountingAlloc>;
+        auto map = Map::new_in(CountingAlloc(&stats));
+        for (int i = 0; i < 1000; i++) {
+            map.insert(i, i * 2);
+        }
+        assert(map.len() == 1000);
+        assert(map.get(500).unwrap() == 1000);
+        assert(stats.live_blocks > 0);
+
+        auto copy = map.clone();
+        assert(copy.allocator() == map.allocator());
+        assert(copy == map);
+
+        using Set = HashSet<int, std::hash<int>, std::equal_to<int>, CountingAlloc>;
+        auto set = Set::with_capacity_in(64, CountingAlloc(&stats));
+        set.insert(1);
+        set.insert(2);
+        auto other = Set::new_in(CountingAlloc(&stats));
+        other.insert(2);
+        auto both = set.intersection(other);
+        assert(both.len() == 1 && both.contains(2));
+    }
+    assert(stats.live_blocks == 0);
+    printf("PASS\n");
+}
+
+void test_btreemap_alloc() {
+    printf("test_btreemap_alloc: ");
+    CountingAlloc::Stats stats;
+    {
+        using Map = BTreeMap<int, int, std::less<int>, CountingAlloc>;
+        auto map = Map::new_in(CountingAlloc(&stats));
+        for (int i = 0; i < 1000; i++) {
+            map.insert(i, i);
+        }
+        assert(map.len() == 1000);
+        assert(map.get(777).unwrap() == 777);
+        assert(stats.live_blocks > 1);
+
+        auto copy = map.clone();
+        assert(copy == map);
+
+        using Set = BTreeSet<int, std::less<int>, CountingAlloc>;
+        auto set = Set::new_in(CountingAlloc(&stats));
+        set.insert(3);
+        set.insert(1);
+        assert(set.contains(1));
+
+        map.clear();
+        assert(map.is_empty());
+    }
+    assert(stats.live_blocks == 0);
+    printf("PASS\n");
+}
+
+// Test the try_* calls: Err with the request size, container unchanged
+void test_fallible_alloc() {
+    printf("test_fallible_alloc: ");
+    size_t budget = 1024;
+    {
+        auto vec = Vec<int, BudgetAlloc>::new_in(BudgetAlloc(&budget));
+        for (int i = 0; i < 100; i++) {
+            assert(vec.try_push(i).is_ok());
+        }
+        auto err = vec.try_reserve(1000);
+        assert(err.is_err());
+        AllocError e = err.unwrap_err();
+        assert(e.size == 1000 * sizeof(int) && !e.is_capacity_overflow());
+        assert(vec.len() == 100 && vec[99] == 99);
+
+        // Growing past the budget fails without losing elements
+        bool failed = false;
+        for (int i = 100; i < 1000 && !failed; i++) {
+            failed = vec.try_push(i).is_err();
+        }
+        assert(failed);
+        for (size_t i = 0; i < vec.len(); i++) assert(vec[i] == static_cast<int>(i));
+
+        assert(Vec<int>::try_with_capacity(16).unwrap().cap() == 16);
+        assert(Vec<int>::try_with_capacity(SIZE_MAX / 2).unwrap_err().is_capacity_overflow());
+
+        bool threw = false;
+        try {
+            vec.reserve(100000);
+        } catch (const std::bad_alloc&) {
+            threw = true;
+        }
+        assert(threw);
+    }
+    assert(budget == 1024);
+
+    budget = 4096;
+    {
+        using Map = HashMap<int, int, std::hash<int>, std::equal_to<int>, BudgetAlloc>;
+        auto map = Map::with_capacity_in(16, BudgetAlloc(&budget));
+        int inserted = 0;
+        while (map.try_insert(inserted, inserted).is_ok()) {
+            inserted++;
+        }
+        assert(inserted > 16);
+        assert(map.len() == static_cast<size_t>(inserted));
+        for (int i = 0; i < inserted; i++) assert(map.get(i).unwrap() == i);
+        // Updating an existing key never allocates
+        assert(map.try_insert(0, 42).is_ok());
+        assert(map.get(0).unwrap() == 42);
+        assert(map.try_reserve(100000).is_err());
+        using IntMap = HashMap<int, int>;
+        assert(IntMap::try_with_capacity(SIZE_MAX / 2).unwrap_err().is_capacity_overflow());
+        assert(IntMap::try_with_capacity(100).unwrap().capacity() >= 100);
+
+        using Set = HashSet<int, std::hash<int>, std::equal_to<int>, BudgetAlloc>;
+        size_t set_budget = 256;
+        auto set = Set::new_in(BudgetAlloc(&set_budget));
+        assert(set.try_insert(1).unwrap());
+        assert(!set.try_insert(1).unwrap());
+        assert(set.try_reserve(10000).is_err());
+    }
+    assert(budget == 4096);
+
+    budget = 256;
+    {
+        using AString = BasicString<BudgetAlloc>;
+        auto s = AString::new_in(BudgetAlloc(&budget));
+        assert(s.try_push_str("short").is_ok());
+        assert(s.try_push_str(" and then long enough to leave the inline buffer").is_ok());
+        size_t before = s.len();
+        auto err = s.try_reserve(1000);
+        assert(err.is_err() && s.len() == before);
+        assert(s.starts_with("short and"));
+        assert(String::try_with_capacity(100).unwrap().capacity() >= 100);
+        assert(String::try_with_capacity(SIZE_MAX).unwrap_err().is_capacity_overflow());
+    }
+    assert(budget == 256);
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty allocator support ===\n");
+
+    test_global_is_free();
+    test_vec_alloc();
+    test_string_alloc();
+    test_hashmap_alloc();
+    test_btreemap_alloc();
+    test_fallible_alloc();
+
+    printf("\nAll allocator tests passed!\n");
+    return 0;
+}
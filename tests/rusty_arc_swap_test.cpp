@@ -0,0 +1,156 @@
+// Tests for rusty::ArcSwap<T>
+#include "../include/rusty/arc_swap.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace rusty;
+
+static std::atomic<int> live_configs(0);
+
+struct Config {
+    int version;
+    int checksum;
+
+    explicit Config(int v) : version(v), checksum(v * 7) { live_configs++; }
+    Config(const Config& other) : version(other.version), checksum(other.checksum) {
+        live_configs++;
+    }
+    ~Config() {
+        checksum = -1;
+        live_configs--;
+    }
+};
+
+// Test load/store/swap on one thread
+void test_arc_swap_basic() {
+    printf("test_arc_swap_basic: ");
+    {
+        auto swap = ArcSwap<Config>::from_pointee(Config(1));
+        {
+            auto guard = swap.load();
+            assert(guard.is_valid());
+            assert(guard->version == 1);
+
+            // The guard keeps the old value alive across a store
+            swap.store(Arc<Config>::make(2));
+            assert(guard->version == 1);
+            assert(guard->checksum == 7);
+            assert(swap.load()->version == 2);
+            assert(live_configs.load() == 2);
+        }
+        assert(live_configs.load() == 1);
+
+        Arc<Config> old = swap.swap(Arc<Config>::make(3));
+        assert(old->version == 2);
+        assert(old.strong_count() == 1);
+        assert(swap.load_full()->version == 3);
+
+        auto full = swap.load_full();
+        assert(full.strong_count() == 2);
+        auto arc = swap.load().to_arc();
+        assert(full.strong_count() == 3);
+        assert(Arc<Config>::ptr_eq(full, arc));
+    }
+    assert(live_configs.load() == 0);
+    printf("PASS\n");
+}
+
+// Test empty ArcSwap and compare_and_swap
+void test_arc_swap_cas() {
+    printf("test_arc_swap_cas: ");
+    {
+        ArcSwap<Config> swap;
+        assert(!swap.load());
+        assert(!swap.load_full().is_valid());
+
+        Arc<Config> empty;
+        auto first = Arc<Config>::make(1);
+        auto prev = swap.compare_and_swap(empty, first.clone());
+        assert(!prev.is_valid());
+        assert(Arc<Config>::ptr_eq(swap.load_full(), first));
+
+        // Stale expectation: nothing changes, current value comes back
+        auto stale = Arc<Config>::make(9);
+        prev = swap.compare_and_swap(stale, Arc<Config>::make(10));
+        assert(Arc<Config>::ptr_eq(prev, first));
+        assert(swap.load()->version == 1);
+
+        swap.rcu([](const Config& c) { return Config(c.version + 1); });
+        assert(swap.load()->version == 2);
+    }
+    assert(live_configs.load() == 0);
+    printf("PASS\n");
+}
+
+// Test more guards alive than a thread has debt slots
+void test_arc_swap_many_guards() {
+    printf("test_arc_swap_many_guards: ");
+    {
+        auto swap = ArcSwap<Config>::from_pointee(Config(1));
+        std::vector<ArcSwap<Config>::Guard> guards;
+        for (int i = 0; i < 20; i++) {
+            guards.push_back(swap.load());
+        }
+        swap.store(Arc<Config>::make(2));
+        for (auto& g : guards) {
+            assert(g->version == 1);
+        }
+        assert(live_configs.load() == 2);
+        guards.clear();
+        assert(live_configs.load() == 1);
+    }
+    assert(live_configs.load() == 0);
+    printf("PASS\n");
+}
+
+// Test readers racing writers; every value must be intact when seen
+void test_arc_swap_threads() {
+    printf("test_arc_swap_threads: ");
+    {
+        auto swap = ArcSwap<Config>::from_pointee(Config(0));
+        std::atomic<bool> done(false);
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; t++) {
+            readers.emplace_back([&swap, &done]() {
+                int last = 0;
+                while (!done.load(std::memory_order_relaxed)) {
+                    auto guard = swap.load();
+                    assert(guard->checksum == guard->version * 7);
+                    assert(guard->version >= last);
+                    last = guard->version;
+                    auto full = swap.load_full();
+                    assert(full->checksum == full->version * 7);
+                }
+            });
+        }
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 2; t++) {
+            writers.emplace_back([&swap]() {
+                for (int i = 0; i < 2000; i++) {
+                    swap.rcu([](const Config& c) { return Config(c.version + 1); });
+                }
+            });
+        }
+        for (auto& w : writers) w.join();
+        done.store(true);
+        for (auto& r : readers) r.join();
+        assert(swap.load()->version == 4000);
+    }
+    assert(live_configs.load() == 0);
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::ArcSwap<T> ===\n");
+
+    test_arc_swap_basic();
+    test_arc_swap_cas();
+    test_arc_swap_many_guards();
+    test_arc_swap_threads();
+
+    printf("\nAll ArcSwap tests passed!\n");
+    return 0;
+}
@@ -1,6 +1,7 @@
 // Tests for rusty::Arc<T>
 #include "../include/rusty/arc.hpp"
 #include <cassert>
+#include <cstdint>
 #include <cstdio>
 #include <thread>
 #include <vector>
@@ -185,6 +186,169 @@ void test_arc_assignment() {
     printf("PASS\n");
 }
 
+// Counts constructions and moves to check in-place construction
+struct Probe {
+    static int constructed;
+    static int moved;
+    static int dropped;
+    int a;
+    int b;
+
+    Probe(int x, int y) : a(x), b(y) { constructed++; }
+    Probe(const Probe& other) : a(other.a), b(other.b) { constructed++; }
+    Probe(Probe&& other) : a(other.a), b(other.b) { moved++; }
+    ~Probe() { dropped++; }
+
+    static void reset() { constructed = moved = dropped = 0; }
+};
+int Probe::constructed = 0;
+int Probe::moved = 0;
+int Probe::dropped = 0;
+
+// Test in-place construction
+void test_arc_make_in_place() {
+    printf("test_arc_make_in_place: ");
+    {
+        Probe::reset();
+        {
+            auto p = Arc<Probe>::make(1, 2);
+            assert(p->a == 1 && p->b == 2);
+            auto q = make_arc<Probe>(3, 4);
+            auto r = arc<Probe>(5, 6);
+            assert(q->a == 3 && r->b == 6);
+            assert(Probe::constructed == 3 && Probe::moved == 0);
+        }
+        assert(Probe::dropped == 3);
+    }
+    printf("PASS\n");
+}
+
+// Test weak references
+void test_arc_weak() {
+    printf("test_arc_weak: ");
+    {
+        Probe::reset();
+        ArcWeak<Probe> weak;
+        assert(weak.upgrade().is_valid() == false);
+        assert(weak.expired());
+        {
+            auto strong = Arc<Probe>::make(7, 8);
+            weak = strong.downgrade();
+            ArcWeak<Probe> weak2(strong);
+            assert(strong.weak_count() == 2);
+            assert(weak.strong_count() == 1);
+
+            auto upgraded = weak.upgrade();
+            assert(upgraded.is_valid() && upgraded->a == 7);
+            assert(strong.strong_count() == 2);
+            assert(Arc<Probe>::ptr_eq(strong, upgraded));
+
+            // Weak references block get_mut
+            assert(strong.get_mut() == nullptr);
+        }
+        // Value dropped with the last Arc even though a weak remains
+        assert(Probe::dropped == 1);
+        assert(weak.expired());
+        assert(!weak.upgrade().is_valid());
+        assert(weak.weak_count() == 0);
+    }
+    printf("PASS\n");
+}
+
+// Test clone-on-write
+void test_arc_make_mut() {
+    printf("test_arc_make_mut: ");
+    {
+        auto a = Arc<int>::new_(1);
+        int* before = &a.make_mut();
+        assert(before == a.get());    // unique: no copy
+        *before = 2;
+
+        auto b = a.clone();
+        a.make_mut() = 3;             // shared: copies first
+        assert(*a == 3 && *b == 2);
+        assert(!Arc<int>::ptr_eq(a, b));
+        assert(a.strong_count() == 1 && b.strong_count() == 1);
+
+        // Sole owner with a weak: the value moves and the weak expires
+        auto weak = b.downgrade();
+        b.make_mut() = 4;
+        assert(*b == 4);
+        assert(weak.expired());
+        assert(b.get_mut() != nullptr);
+    }
+    printf("PASS\n");
+}
+
+// Test cache-aligned layout
+void test_arc_cache_aligned() {
+    printf("test_arc_cache_aligned: ");
+    {
+        auto a = CacheAlignedArc<int>::make(5);
+        auto addr = reinterpret_cast<uintptr_t>(a.get());
+        assert(addr % 64 == 0);
+        auto b = a.clone();
+        assert(*b == 5 && a.strong_count() == 2);
+        auto w = b.downgrade();
+        assert(w.upgrade().is_valid());
+    }
+    printf("PASS\n");
+}
+
+// Test weak upgrades racing with drops
+void test_arc_weak_threads() {
+    printf("test_arc_weak_threads: ");
+    {
+        for (int round = 0; round < 50; round++) {
+            auto strong = Arc<std::vector<int>>::make(100, round);
+            auto weak = strong.downgrade();
+            std::vector<std::thread> threads;
+            for (int t = 0; t < 4; t++) {
+                threads.emplace_back([weak, round]() {
+                    for (int i = 0; i < 100; i++) {
+                        auto up = weak.upgrade();
+                        if (up.is_valid()) {
+                            assert((*up)[99] == round);
+                        }
+                        auto w2 = weak.clone();
+                    }
+                });
+            }
+            strong = Arc<std::vector<int>>();
+            for (auto& t : threads) t.join();
+            assert(weak.expired());
+        }
+    }
+    printf("PASS\n");
+}
+
+// Test upgrading a thread-local Rc
+void test_arc_from_rc() {
+    printf("test_arc_from_rc: ");
+    {
+        // Sole owner: the vector's buffer moves, nothing is copied
+        auto rc = Rc<std::vector<int>>::new_(std::vector<int>(1000, 7));
+        const int* data = rc->data();
+        auto arc = Arc<std::vector<int>>::from_rc(std::move(rc));
+        assert(arc->data() == data);
+        assert(arc.strong_count() == 1);
+
+        // Shared: the others keep their value, the Arc gets a copy
+        auto shared = Rc<std::vector<int>>::new_(std::vector<int>(3, 1));
+        auto other = shared.clone();
+        auto copied = Arc<std::vector<int>>::from_rc(shared);
+        assert(copied->size() == 3);
+        assert(other->size() == 3);
+        assert(copied->data() != other->data());
+
+        std::thread t([copied]() { assert((*copied)[2] == 1); });
+        t.join();
+
+        assert(!Arc<int>::from_rc(Rc<int>()).is_valid());
+    }
+    printf("PASS\n");
+}
+
 int main() {
     printf("=== Testing rusty::Arc<T> ===\n");
     
@@ -196,6 +360,12 @@ int main() {
     test_arc_thread_safety();
     test_arc_empty();
     test_arc_assignment();
+    test_arc_make_in_place();
+    test_arc_weak();
+    test_arc_make_mut();
+    test_arc_cache_aligned();
+    test_arc_weak_threads();
+    test_arc_from_rc();
     
     printf("\nAll Arc tests passed!\n");
     return 0;
@@ -0,0 +1,300 @@
+// Tests for rusty::archive
+#include "../include/rusty/archive.hpp"
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+
+using namespace rusty;
+
+struct Point {
+    int32_t x;
+    int32_t y;
+};
+
+namespace rusty {
+template<>
+struct is_archive_pod<Point> : std::true_type {};
+}
+
+// Copy into a fresh buffer, as a read from disk would
+static Vec<uint8_t> reload(const Vec<uint8_t>& bytes) {
+    Vec<uint8_t> copy = Vec<uint8_t>::with_capacity(bytes.len());
+    copy.extend_from_slice(bytes.as_slice());
+    return copy;
+}
+
+// Test that every supported type survives to_bytes/from_bytes
+void test_archive_roundtrip() {
+    printf("test_archive_roundtrip: ");
+    {
+        Vec<int> ints = {1, -2, 3};
+        Vec<uint8_t> bytes = archive::to_bytes(ints);
+        assert(archive::from_bytes<Vec<int>>(reload(bytes).as_slice()).unwrap() == ints);
+
+        Vec<String> words;
+        words.push(String::from("alpha"));
+        words.push(String::from(""));
+        words.push(String::from("a longer string that does not fit inline"));
+        Vec<String> back = archive::from_bytes<Vec<String>>(archive::to_bytes(words).as_slice()).unwrap();
+        assert(back == words);
+
+        Vec<Vec<uint16_t>> nested;
+        for (int i = 0; i < 5; i++) {
+            Vec<uint16_t> row;
+            for (int j = 0; j < i; j++) row.push(uint16_t(i * 10 + j));
+            nested.push(std::move(row));
+        }
+        assert(archive::from_bytes<Vec<Vec<uint16_t>>>(archive::to_bytes(nested).as_slice()).unwrap() == nested);
+
+        std::pair<Option<String>, Option<bool>> pair(Option<String>(String::from("x")), Option<bool>(None));
+        auto pair_back =
+            archive::from_bytes<std::pair<Option<String>, Option<bool>>>(archive::to_bytes(pair).as_slice()).unwrap();
+        assert(pair_back.first.unwrap() == "x" && pair_back.second.is_none());
+
+        HashMap<String, Vec<Point>> shapes;
+        for (int i = 0; i < 300; i++) {
+            Vec<Point> pts;
+            for (int j = 0; j < i % 4; j++) pts.push(Point{i, j});
+            shapes.insert(String::from(std::to_string(i)), std::move(pts));
+        }
+        HashMap<String, Vec<Point>> shapes_back =
+            archive::from_bytes<HashMap<String, Vec<Point>>>(archive::to_bytes(shapes).as_slice()).unwrap();
+        assert(shapes_back.len() == 300);
+        for (int i = 0; i < 300; i++) {
+            const Vec<Point>& pts = shapes_back.get(String::from(std::to_string(i))).unwrap();
+            assert(pts.len() == size_t(i % 4) && (pts.is_empty() || pts[0].x == i));
+        }
+
+        BTreeMap<uint64_t, String> sorted;
+        for (uint64_t i = 0; i < 1000; i++) sorted.insert(i * 7 % 1000, String::from(std::to_string(i)));
+        BTreeMap<uint64_t, String> sorted_back =
+            archive::from_bytes<BTreeMap<uint64_t, String>>(archive::to_bytes(sorted).as_slice()).unwrap();
+        assert(sorted_back.len() == 1000 && sorted_back.get(7).unwrap() == "1");
+
+        HashMap<int, int> empty;
+        assert((archive::from_bytes<HashMap<int, int>>(archive::to_bytes(empty).as_slice()).unwrap().is_empty()));
+        BTreeMap<int, int> empty_tree;
+        assert((archive::from_bytes<BTreeMap<int, int>>(archive::to_bytes(empty_tree).as_slice()).unwrap().is_empty()));
+        assert(archive::from_bytes<Vec<String>>(archive::to_bytes(Vec<String>()).as_slice()).unwrap().is_empty());
+    }
+    printf("PASS\n");
+}
+
+// Test lookups directly against the archived bytes
+void test_archive_zero_copy() {
+    printf("test_archive_zero_copy: ");
+    {
+        HashMap<uint64_t, uint64_t> big;
+        for (uint64_t i = 0; i < 100000; i++) big.insert(i * 2654435761u, i);
+        Vec<uint8_t> bytes = reload(archive::to_bytes(big));
+        const ArchivedHashMap<uint64_t, uint64_t>& view =
+            *archive::access<HashMap<uint64_t, uint64_t>>(bytes.as_slice()).unwrap();
+        assert(view.len() == 100000);
+        for (uint64_t i = 0; i < 100000; i++) {
+            assert(view.get(i * 2654435761u).unwrap() == i);
+            assert(!view.contains_key(i * 2654435761u + 1));
+        }
+        assert(view.iter().count() == 100000);
+        assert((&archive::access_unchecked<HashMap<uint64_t, uint64_t>>(bytes.as_ptr()) == &view));
+
+        HashMap<String, uint32_t> routes;
+        routes.insert(String::from("api"), 8080);
+        routes.insert(String::from("admin"), 9000);
+        Vec<uint8_t> route_bytes = archive::to_bytes(routes);
+        auto route_view = archive::access<HashMap<String, uint32_t>>(route_bytes.as_slice()).unwrap();
+        assert(route_view->get("api").unwrap() == 8080);
+        assert(route_view->get(std::string("admin")).unwrap() == 9000);
+        assert(route_view->get("nope").is_none());
+        auto kv = route_view->get_key_value("admin").unwrap();
+        assert(*kv.first == "admin" && kv.first->as_ptr()[5] == '\0');
+
+        BTreeMap<String, int> tree;
+        for (int i = 0; i < 500; i++) {
+            char name[16];
+            snprintf(name, sizeof(name), "key%03d", i);
+            tree.insert(String::from(name), i);
+        }
+        Vec<uint8_t> tree_bytes = archive::to_bytes(tree);
+        const ArchivedBTreeMap<String, int>* tree_view =
+            archive::access<BTreeMap<String, int>>(tree_bytes.as_slice()).unwrap();
+        assert(tree_view->get("key123").unwrap() == 123 && tree_view->get("key5").is_none());
+        Slice<ArchivedBTreeMap<String, int>::Entry> mid = tree_view->range("key100", "key110");
+        assert(mid.len() == 10 && mid[0].second == 100 && mid[9].second == 109);
+        assert(tree_view->first_key_value().unwrap().second == 0);
+        assert(tree_view->last_key_value().unwrap().first == "key499");
+
+        Vec<String> words;
+        words.push(String::from("zero"));
+        words.push(String::from("copy"));
+        Vec<uint8_t> word_bytes = archive::to_bytes(words);
+        const ArchivedVec<ArchivedString>& word_view =
+            *archive::access<Vec<String>>(word_bytes.as_slice()).unwrap();
+        assert(word_view.len() == 2 && word_view[1] == "copy" && word_view.get(2).is_none());
+        assert(word_view.iter().count() == 2 && word_view[0].as_str() == "zero");
+    }
+    printf("PASS\n");
+}
+
+// Test that access() rejects damaged archives instead of reading out of
+// bounds (run under ASan to catch any stray read)
+void test_archive_validation() {
+    printf("test_archive_validation: ");
+    {
+        typedef HashMap<String, Vec<int>> Map;
+        Map map;
+        for (int i = 0; i < 40; i++) {
+            Vec<int> v;
+            v.push(i);
+            map.insert(String::from(std::to_string(i)), std::move(v));
+        }
+        Vec<uint8_t> good = archive::to_bytes(map);
+        assert(archive::access<Map>(good.as_slice()).is_ok());
+
+        Vec<uint8_t> short_bytes = reload(good);
+        short_bytes.truncate(good.len() - 1);
+        assert(archive::access<Map>(short_bytes.as_slice()).unwrap_err() == ArchiveError{"archive truncated"});
+        assert(archive::access<Map>(good.as_slice().slice(0, 10)).is_err());
+        Vec<uint8_t> bad_magic = reload(good);
+        bad_magic[0] = 'X';
+        assert(archive::access<Map>(bad_magic.as_slice()).is_err());
+
+        srand(47);
+        size_t accepted = 0;
+        for (int round = 0; round < 3000; round++) {
+            Vec<uint8_t> bytes = reload(good);
+            int flips = 1 + rand() % 3;
+            for (int f = 0; f < flips; f++) {
+                size_t at = sizeof(archive::Header) + rand() % (bytes.len() - sizeof(archive::Header));
+                bytes[at] ^= uint8_t(1 << (rand() % 8));
+            }
+            auto view = archive::access<Map>(bytes.as_slice());
+            if (view.is_err()) continue;
+            accepted++;
+            // Whatever passed must be safe to walk and query
+            const ArchivedHashMap<String, Vec<int>>* m = view.unwrap();
+            m->iter().for_each([](const ArchivedHashMap<String, Vec<int>>::Entry& e) {
+                volatile size_t sink = e.first.len() + e.second.len();
+                for (size_t i = 0; i < e.second.len(); i++) sink += size_t(e.second[i]);
+                (void)sink;
+            });
+            for (int i = 0; i < 40; i++) m->get(String::from(std::to_string(i)));
+        }
+        assert(accepted < 3000);
+    }
+    printf("PASS\n");
+}
+
+// Test the B-tree index of ArchivedBTreeMap against std::map, across
+// sizes that give zero to three index levels
+void test_archive_btree_index() {
+    printf("test_archive_btree_index: ");
+    {
+        size_t sizes[] = {1, 15, 16, 17, 255, 256, 257, 4097, 20000};
+        srand(48);
+        for (size_t size : sizes) {
+            BTreeMap<uint64_t, uint32_t> tree;
+            std::map<uint64_t, uint32_t> model;
+            while (tree.len() < size) {
+                uint64_t k = uint64_t(rand()) * 3;
+                tree.insert(k, uint32_t(k / 3));
+                model[k] = uint32_t(k / 3);
+            }
+            Vec<uint8_t> bytes = archive::to_bytes(tree);
+            const ArchivedBTreeMap<uint64_t, uint32_t>* view =
+                archive::access<BTreeMap<uint64_t, uint32_t>>(bytes.as_slice()).unwrap();
+            assert(view->len() == size);
+            for (const auto& kv : model) assert(view->get(kv.first).unwrap() == kv.second);
+            for (int i = 0; i < 2000; i++) {
+                uint64_t lo = uint64_t(rand()) * 3 + uint64_t(rand() % 3);
+                uint64_t hi = lo + uint64_t(rand() % 100000);
+                assert(view->contains_key(lo) == (model.count(lo) == 1));
+                Slice<ArchivedBTreeMap<uint64_t, uint32_t>::Entry> r = view->range(lo, hi);
+                auto first = model.lower_bound(lo);
+                size_t expected = size_t(std::distance(first, model.lower_bound(hi)));
+                assert(r.len() == expected);
+                if (expected) assert(r[0].first == first->first);
+            }
+            assert(view->get(0).is_none() || model.count(0));
+            assert(view->range(0, UINT64_MAX).len() == size);
+        }
+
+        // Damaged indexes are rejected or stay in bounds
+        BTreeMap<String, int> names;
+        for (int i = 0; i < 300; i++) names.insert(String::from(std::to_string(i)), i);
+        Vec<uint8_t> good = archive::to_bytes(names);
+        for (int round = 0; round < 2000; round++) {
+            Vec<uint8_t> bytes = reload(good);
+            size_t at = sizeof(archive::Header) + rand() % (bytes.len() - sizeof(archive::Header));
+            bytes[at] ^= uint8_t(1 << (rand() % 8));
+            auto damaged = archive::access<BTreeMap<String, int>>(bytes.as_slice());
+            if (damaged.is_err()) continue;
+            for (int i = 0; i < 300; i += 7) damaged.unwrap()->get(String::from(std::to_string(i)));
+            damaged.unwrap()->range("1", "5");
+        }
+    }
+    printf("PASS\n");
+}
+
+// Test writing archives to files and opening them by mmap
+void test_archive_mapped_file() {
+    printf("test_archive_mapped_file: ");
+    {
+        const char* path = "rusty_archive_test.bin";
+        HashMap<String, uint32_t> routes;
+        for (uint32_t i = 0; i < 5000; i++) routes.insert(String::from(std::to_string(i)), i * 2);
+        assert(archive::write_file(path, routes).is_ok());
+
+        typedef archive::MappedArchive<HashMap<String, uint32_t>> Mapped;
+        Mapped checked = Mapped::open(path).unwrap();
+        assert(checked->len() == 5000 && checked->get("4321").unwrap() == 8642);
+        Mapped fast = Mapped::open_unchecked(path).unwrap();
+        assert((*fast).get("17").unwrap() == 34 && fast->get("5000").is_none());
+        assert(fast.file().len() == archive::to_bytes(routes).len());
+        const uint8_t* root = reinterpret_cast<const uint8_t*>(&fast.get());
+        assert(root > fast.file().as_ptr() && root < fast.file().as_ptr() + fast.file().len());
+
+        // Replacing the file leaves existing mappings intact
+        routes.insert(String::from("new"), 1);
+        assert(archive::write_file(path, routes).is_ok());
+        assert(fast->get("new").is_none() && fast->get("4999").unwrap() == 9998);
+        assert(Mapped::open(path).unwrap()->get("new").unwrap() == 1);
+        Mapped moved = std::move(fast);
+        assert(moved->get("1").unwrap() == 2);
+
+        // The wrong root type fails the checks, not the process
+        assert(archive::MappedArchive<Vec<String>>::open(path).is_err());
+
+        BTreeMap<String, int> tree;
+        for (int i = 0; i < 1000; i++) tree.insert(String::from(std::to_string(i * 7)), i);
+        assert(archive::write_file(path, tree).is_ok());
+        auto tree_file = archive::MappedArchive<BTreeMap<String, int>>::open(path).unwrap();
+        assert(tree_file->get("693").unwrap() == 99 && tree_file->get("694").is_none());
+
+        FILE* f = fopen(path, "wb");
+        fclose(f);
+        MappedFile empty = MappedFile::open(path).unwrap();
+        assert(empty.is_empty() && empty.as_slice().len() == 0);
+        assert(Mapped::open_unchecked(path).unwrap_err() == ArchiveError{"archive too short"});
+
+        remove(path);
+        assert(MappedFile::open(path).unwrap_err() == IoError{ENOENT});
+        assert(Mapped::open(path).unwrap_err() == ArchiveError{"cannot open archive file"});
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::archive ===\n");
+
+    test_archive_roundtrip();
+    test_archive_zero_copy();
+    test_archive_validation();
+    test_archive_btree_index();
+    test_archive_mapped_file();
+
+    printf("\nAll archive tests passed!\n");
+    return 0;
+}
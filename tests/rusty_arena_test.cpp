@@ -0,0 +1,128 @@
+// Tests for rusty::Arena and rusty::ArenaBox
+#include "../include/rusty/arena.hpp"
+#include "../include/rusty/vec.hpp"
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+
+using namespace rusty;
+
+static int drops = 0;
+
+struct Tracked {
+    int value;
+    explicit Tracked(int v) : value(v) {}
+    ~Tracked() { drops++; }
+};
+
+struct alignas(64) Wide {
+    char bytes[64];
+};
+
+void test_arena_alloc() {
+    printf("test_arena_alloc: ");
+    {
+        Arena arena;
+        int& a = arena.alloc<int>(1);
+        int& b = arena.alloc<int>(2);
+        assert(a == 1 && b == 2);
+        assert(&b != &a);
+
+        Wide& w = arena.alloc<Wide>();
+        assert(reinterpret_cast<uintptr_t>(&w) % 64 == 0);
+
+        double* arr = arena.alloc_array<double>(16);
+        for (int i = 0; i < 16; i++) arr[i] = i;
+        assert(arr[15] == 15.0);
+        assert(arena.allocated_bytes() >= 2 * sizeof(int) + sizeof(Wide) + 16 * sizeof(double));
+    }
+    printf("PASS\n");
+}
+
+void test_arena_chunks() {
+    printf("test_arena_chunks: ");
+    {
+        Arena arena(64);
+        for (int i = 0; i < 1000; i++) {
+            arena.alloc<int>(i);
+        }
+        // Chunks grow geometrically, and oversized requests get their own chunk
+        size_t cap = arena.chunk_capacity();
+        assert(cap >= 1000 * sizeof(int));
+        arena.alloc_raw(100000, 8);
+        assert(arena.chunk_capacity() >= cap + 100000);
+
+        // reset keeps only the largest chunk for reuse
+        arena.reset();
+        assert(arena.allocated_bytes() == 0);
+        size_t kept = arena.chunk_capacity();
+        assert(kept >= 100000);
+        arena.alloc_raw(1000, 8);
+        assert(arena.chunk_capacity() == kept);
+
+        Arena moved = std::move(arena);
+        assert(moved.chunk_capacity() == kept);
+        assert(arena.chunk_capacity() == 0);
+    }
+    printf("PASS\n");
+}
+
+void test_arena_box() {
+    printf("test_arena_box: ");
+    drops = 0;
+    {
+        Arena arena;
+        {
+            ArenaBox<Tracked> box = arena.alloc_box<Tracked>(42);
+            assert(box.is_valid());
+            assert(box->value == 42);
+            (*box).value = 7;
+
+            ArenaBox<Tracked> moved = std::move(box);
+            assert(!box.is_valid());
+            assert(moved->value == 7);
+        }
+        // Destructor ran once, even though the memory is still in the arena
+        assert(drops == 1);
+
+        Tracked& plain = arena.alloc<Tracked>(1);
+        (void)plain;
+    }
+    // Values from alloc() are never destroyed
+    assert(drops == 1);
+    static_assert(is_trivially_relocatable<ArenaBox<Tracked>>::value, "ArenaBox relocates");
+    printf("PASS\n");
+}
+
+void test_arena_alloc_handle() {
+    printf("test_arena_alloc_handle: ");
+    {
+        Arena arena;
+        auto vec = Vec<int, ArenaAlloc>::new_in(ArenaAlloc(arena));
+        for (int i = 0; i < 500; i++) {
+            vec.push(i);
+        }
+        assert(vec.len() == 500);
+        assert(vec[499] == 499);
+
+        // Growing the last allocation happens in place, so little is wasted
+        assert(arena.allocated_bytes() < 2 * vec.capacity() * sizeof(int));
+
+        auto copy = vec.clone();
+        assert(copy.allocator() == vec.allocator());
+        assert(copy[250] == 250);
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::Arena ===\n");
+
+    test_arena_alloc();
+    test_arena_chunks();
+    test_arena_box();
+    test_arena_alloc_handle();
+
+    printf("\nAll arena tests passed!\n");
+    return 0;
+}
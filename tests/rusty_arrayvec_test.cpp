@@ -0,0 +1,160 @@
+// Tests for rusty::ArrayVec and rusty::ArrayString
+#include "../include/rusty/arrayvec.hpp"
+#include "../include/rusty/alloc_observer.hpp"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+using namespace rusty;
+
+struct Tracked {
+    static int instances;
+    int value;
+
+    explicit Tracked(int v) : value(v) { instances++; }
+    Tracked(const Tracked& other) : value(other.value) { instances++; }
+    Tracked(Tracked&& other) noexcept : value(other.value) { instances++; }
+    Tracked& operator=(const Tracked&) = default;
+    Tracked& operator=(Tracked&&) = default;
+    ~Tracked() { instances--; }
+    bool operator==(const Tracked& other) const { return value == other.value; }
+};
+
+int Tracked::instances = 0;
+
+// Counts every allocation
+struct AllocCounter : AllocObserver {
+    long allocs = 0;
+    void on_alloc(const AllocEvent&) override { allocs++; }
+    void on_dealloc(const AllocEvent&) override {}
+};
+
+void test_arrayvec_basic() {
+    printf("test_arrayvec_basic: ");
+    {
+        ArrayVec<int, 4> v;
+        assert(v.is_empty() && v.capacity() == 4 && v.remaining_capacity() == 4);
+        v.push(1);
+        v.push(2);
+        v.push(3);
+        assert(v.len() == 3 && v[2] == 3 && v.front() == 1 && v.back() == 3);
+        assert(v.try_push(4).is_ok() && v.is_full());
+        assert(v.try_push(5).is_err() && v.len() == 4 && v.back() == 4);
+
+        bool threw = false;
+        try { v.push(5); } catch (const std::length_error&) { threw = true; }
+        assert(threw && v.len() == 4);
+
+        assert(v.pop() == 4 && v.remove(0) == 1 && v.len() == 2);
+        v.insert(0, 10);
+        v.insert(3, 30);
+        assert(v[0] == 10 && v[1] == 2 && v[2] == 3 && v[3] == 30);
+        assert(v.swap_remove(0) == 10 && v[0] == 30 && v.len() == 3);
+        v.truncate(1);
+        assert(v.len() == 1 && v.as_slice().len() == 1);
+
+        const int more[] = {7, 8, 9, 10};
+        assert(v.try_extend_from_slice(more, 4).is_err() && v.len() == 1);
+        v.extend_from_slice(more, 3);
+        int sum = 0;
+        for (int x : v) sum += x;
+        assert(sum == 30 + 7 + 8 + 9);
+
+        ArrayVec<int, 4> copy = v.clone();
+        assert(copy == v);
+        copy[0] = 0;
+        assert(copy != v);
+        ArrayVec<int, 4> moved = std::move(copy);
+        assert(moved.len() == 4 && copy.is_empty());
+
+        ArrayVec<int, 3> list = {1, 2, 3};
+        assert(list.is_full() && list[1] == 2);
+    }
+    {
+        // Non-trivial elements are constructed and destroyed one by one
+        ArrayVec<Tracked, 8> v;
+        for (int i = 0; i < 6; i++) v.push(Tracked(i));
+        assert(Tracked::instances == 6);
+        assert(v.remove(1).value == 1);
+        assert(Tracked::instances == 5);
+        v.insert(0, Tracked(100));
+        assert(v[0].value == 100 && v[1].value == 0 && v[2].value == 2);
+        ArrayVec<Tracked, 8> other = std::move(v);
+        assert(v.is_empty() && other.len() == 6 && Tracked::instances == 6);
+        ArrayVec<Tracked, 8> copy = other.clone();
+        assert(copy == other && Tracked::instances == 12);
+        copy = std::move(other);
+        assert(Tracked::instances == 6);
+        copy.truncate(2);
+        assert(Tracked::instances == 2);
+    }
+    assert(Tracked::instances == 0);
+    printf("PASS\n");
+}
+
+void test_array_string() {
+    printf("test_array_string: ");
+    {
+        ArrayString<8> s;
+        assert(s.is_empty() && s.capacity() == 8 && s.c_str()[0] == '\0');
+        s.push_str("ab");
+        s.push('c');
+        assert(s == str("abc") && s.len() == 3 && std::strcmp(s.c_str(), "abc") == 0);
+        assert(s.try_push_str("defghi").is_err() && s == str("abc"));
+        assert(s.try_push_str("defgh").is_ok() && s.is_full());
+        assert(s.try_push('x').is_err());
+
+        bool threw = false;
+        try { s.push('x'); } catch (const std::length_error&) { threw = true; }
+        assert(threw && s == str("abcdefgh"));
+
+        assert(s.pop() == 'h' && s.c_str()[7] == '\0' && s[0] == 'a');
+        s.truncate(2);
+        assert(s == str("ab") && s.to_string() == "ab");
+
+        ArrayString<8> copy = s;
+        copy.push('!');
+        assert(s == str("ab") && copy == str("ab!") && copy != s);
+
+        auto parsed = ArrayString<4>::from("1234");
+        assert(parsed.is_ok() && parsed.unwrap() == str("1234"));
+        assert(ArrayString<4>::from("12345").is_err());
+        assert(ArrayString<4>::from("ab").unwrap() == s);
+
+        str view = s;
+        assert(view.len() == 2 && view.as_ptr() == s.c_str());
+    }
+    printf("PASS\n");
+}
+
+// Nothing here touches the heap
+void test_arrayvec_no_alloc() {
+    printf("test_arrayvec_no_alloc: ");
+    AllocCounter counter;
+    set_alloc_observer(&counter);
+    {
+        ArrayVec<long, 64> v;
+        for (long i = 0; i < 64; i++) v.push(i * i);
+        ArrayVec<long, 64> w = v.clone();
+        assert(w.pop() == 63 * 63);
+        ArrayString<32> s;
+        for (int i = 0; i < 32; i++) s.push(char('a' + i % 26));
+        assert(s.is_full());
+    }
+    set_alloc_observer(nullptr);
+    assert(counter.allocs == 0);
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::ArrayVec / ArrayString ===\n");
+
+    test_arrayvec_basic();
+    test_array_string();
+    test_arrayvec_no_alloc();
+
+    printf("\nAll ArrayVec tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,212 @@
+// Tests for rusty::BinaryHeap and rusty::IndexedBinaryHeap
+#include "../include/rusty/binaryheap.hpp"
+#include "../include/rusty/box.hpp"
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <queue>
+#include <vector>
+
+using namespace rusty;
+
+struct BoxLess {
+    bool operator()(const Box<int>& a, const Box<int>& b) const { return *a < *b; }
+};
+
+// Test push/pop ordering against std::priority_queue for several arities
+template<size_t D>
+static void check_against_priority_queue() {
+    BinaryHeap<int, std::less<int>, D> heap;
+    std::priority_queue<int> model;
+    for (int step = 0; step < 20000; step++) {
+        int op = rand() % 8;
+        if (op < 5) {
+            int x = rand() % 1000;
+            heap.push(x);
+            model.push(x);
+        } else if (op < 7) {
+            if (model.empty()) {
+                assert(heap.pop().is_none());
+            } else {
+                assert(heap.pop().unwrap() == model.top());
+                model.pop();
+            }
+        } else {
+            int x = rand() % 1000;
+            model.push(x);
+            assert(heap.push_pop(x) == model.top());
+            model.pop();
+        }
+        assert(heap.len() == model.size());
+        assert(model.empty() ? heap.peek().is_none() : heap.peek().unwrap() == model.top());
+    }
+}
+
+void test_binaryheap_push_pop() {
+    printf("test_binaryheap_push_pop: ");
+    {
+        srand(4242);
+        check_against_priority_queue<2>();
+        check_against_priority_queue<3>();
+        check_against_priority_queue<4>();
+        check_against_priority_queue<8>();
+
+        BinaryHeap<int, std::greater<int>> min_heap = {5, 1, 4};
+        assert(min_heap.peek().unwrap() == 1);
+        assert(min_heap.push_pop(0) == 0);
+        assert(min_heap.replace(9).unwrap() == 1);
+        assert(min_heap.pop().unwrap() == 4);
+        assert(min_heap.pop().unwrap() == 5);
+        assert(min_heap.pop().unwrap() == 9);
+        assert(min_heap.replace(3).is_none() && min_heap.len() == 1);
+    }
+    printf("PASS\n");
+}
+
+// Test heapify, into_sorted_vec, append and retain
+void test_binaryheap_bulk() {
+    printf("test_binaryheap_bulk: ");
+    {
+        Vec<int> values;
+        for (int i = 0; i < 1000; i++) values.push((i * 7919) % 1000);
+        const int* storage = values.as_ptr();
+        BinaryHeap<int, std::less<int>, 4> heap = BinaryHeap<int, std::less<int>, 4>::from_vec(std::move(values));
+        assert(heap.len() == 1000 && heap.peek().unwrap() == 999);
+        assert(heap.as_slice().as_ptr() == storage);  // heapified in place
+
+        Vec<int> sorted = heap.clone().into_sorted_vec();
+        assert(sorted.as_ptr() != storage && sorted.len() == 1000);
+        for (int i = 0; i < 1000; i++) assert(sorted[i] == i);
+
+        BinaryHeap<int, std::less<int>, 4> small = {2000, -1};
+        heap.append(small);
+        assert(small.is_empty() && heap.len() == 1002);
+        assert(heap.pop().unwrap() == 2000);
+
+        BinaryHeap<int, std::less<int>, 4> big;
+        for (int i = 0; i < 5000; i++) big.push(i);
+        heap.append(big);  // rebuilds instead of sifting each element
+        assert(heap.len() == 6001 && heap.peek().unwrap() == 4999);
+
+        heap.retain([](const int& x) { return x % 2 == 0; });
+        int prev = heap.pop().unwrap();
+        while (!heap.is_empty()) {
+            int x = heap.pop().unwrap();
+            assert(x % 2 == 0 && x <= prev);
+            prev = x;
+        }
+        assert(prev == 0);
+
+        BinaryHeap<Box<int>, BoxLess> boxes;
+        for (int i = 0; i < 100; i++) boxes.push(Box<int>::make((i * 37) % 100));
+        assert(*boxes.push_pop(Box<int>::make(50)) == 99);
+        assert(*boxes.pop().unwrap() == 98);
+        Vec<Box<int>> boxed = std::move(boxes).into_sorted_vec();
+        assert(boxed.len() == 99 && *boxed[0] == 0 && *boxed[98] == 97);
+    }
+    printf("PASS\n");
+}
+
+// Test the indexed heap with Dijkstra against a simple O(V^2) search
+void test_indexed_heap_dijkstra() {
+    printf("test_indexed_heap_dijkstra: ");
+    {
+        srand(777);
+        const size_t n = 300;
+        std::vector<std::vector<std::pair<size_t, int>>> edges(n);
+        for (size_t i = 0; i < n * 6; i++) {
+            edges[rand() % n].push_back(std::make_pair(size_t(rand() % n), rand() % 100 + 1));
+        }
+
+        const int INF = 1 << 30;
+        std::vector<int> expected(n, INF);
+        std::vector<bool> done(n, false);
+        expected[0] = 0;
+        for (size_t round = 0; round < n; round++) {
+            size_t u = n;
+            for (size_t v = 0; v < n; v++) {
+                if (!done[v] && expected[v] < INF && (u == n || expected[v] < expected[u])) u = v;
+            }
+            if (u == n) break;
+            done[u] = true;
+            for (size_t e = 0; e < edges[u].size(); e++) {
+                size_t v = edges[u][e].first;
+                expected[v] = std::min(expected[v], expected[u] + edges[u][e].second);
+            }
+        }
+
+        std::vector<int> dist(n, INF);
+        IndexedBinaryHeap<int, std::greater<int>, 4> queue = IndexedBinaryHeap<int, std::greater<int>, 4>::with_capacity(n);
+        dist[0] = 0;
+        queue.push(0, 0);
+        while (!queue.is_empty()) {
+            std::pair<size_t, int> top = queue.pop().unwrap();
+            size_t u = top.first;
+            assert(top.second == dist[u]);
+            for (size_t e = 0; e < edges[u].size(); e++) {
+                size_t v = edges[u][e].first;
+                int d = dist[u] + edges[u][e].second;
+                if (d >= dist[v]) continue;
+                if (queue.contains(v)) {
+                    assert(queue.decrease_key(v, d));
+                } else {
+                    queue.push(v, d);
+                }
+                dist[v] = d;
+            }
+        }
+        assert(dist == expected);
+    }
+    printf("PASS\n");
+}
+
+// Test lookups, change_key and remove on the indexed heap
+void test_indexed_heap_updates() {
+    printf("test_indexed_heap_updates: ");
+    {
+        IndexedBinaryHeap<int> heap;
+        for (size_t id = 0; id < 100; id++) assert(heap.push(id, int(id)).is_none());
+        assert(heap.peek().unwrap() == 99 && heap.peek_priority().unwrap() == 99);
+
+        assert(!heap.decrease_key(10, 5));  // would move it down
+        assert(heap.decrease_key(10, 500));
+        assert(heap.peek().unwrap() == 10);
+        assert(heap.change_key(10, 1) == 500);
+        assert(heap.priority(10).unwrap() == 1);
+        assert(heap.push(20, 1000).unwrap() == 20);
+        assert(heap.peek().unwrap() == 20);
+
+        assert(heap.remove(20).unwrap() == 1000);
+        assert(heap.remove(20).is_none() && !heap.contains(20));
+        for (size_t id = 0; id < 100; id += 3) heap.remove(id);
+        assert(!heap.contains(500) && heap.priority(500).is_none());
+        heap.push(500, 50);
+
+        int prev = INT32_MAX;
+        size_t count = 0;
+        while (!heap.is_empty()) {
+            std::pair<size_t, int> top = heap.pop().unwrap();
+            assert(top.second <= prev && !heap.contains(top.first));
+            prev = top.second;
+            count++;
+        }
+        assert(count == 100 - 34 - 1 + 1);
+
+        heap.push(3, 3);
+        heap.clear();
+        assert(heap.is_empty() && !heap.contains(3));
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::BinaryHeap ===\n");
+
+    test_binaryheap_push_pop();
+    test_binaryheap_bulk();
+    test_indexed_heap_dijkstra();
+    test_indexed_heap_updates();
+
+    printf("\nAll BinaryHeap tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,248 @@
+// Tests for rusty::BitVec and rusty::FixedBitSet
+#include "../include/rusty/bitvec.hpp"
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+using namespace rusty;
+
+// Every word past len() must keep its padding bits clear
+static bool tail_clear(const BitVec& bits) {
+    Slice<uint64_t> words = bits.as_raw_slice();
+    if (words.len() != (bits.len() + 63) / 64) return false;
+    if (bits.len() % 64 == 0) return true;
+    return (words[words.len() - 1] >> (bits.len() % 64)) == 0;
+}
+
+static bool same(const BitVec& bits, const std::vector<bool>& model) {
+    if (bits.len() != model.size() || !tail_clear(bits)) return false;
+    size_t ones = 0;
+    for (size_t i = 0; i < model.size(); i++) {
+        if (bits[i] != model[i]) return false;
+        ones += model[i];
+    }
+    return bits.count_ones() == ones;
+}
+
+// Test push/pop, element access and resizing against std::vector<bool>
+void test_bitvec_basic() {
+    printf("test_bitvec_basic: ");
+    {
+        BitVec bits;
+        assert(bits.is_empty() && bits.pop().is_none() && bits.get(0).is_none());
+        std::vector<bool> model;
+        for (int i = 0; i < 200; i++) {
+            bits.push(i % 3 == 0);
+            model.push_back(i % 3 == 0);
+        }
+        assert(same(bits, model));
+        assert(bits.get(3).unwrap() && !bits.get(4).unwrap() && bits.get(200).is_none());
+
+        bits.set(4, true);
+        bits.toggle(0);
+        assert(bits.replace(4, false) && !bits[0] && !bits[4]);
+        model[0] = false;
+        assert(same(bits, model));
+
+        while (bits.len() > 130) {
+            assert(bits.pop().unwrap() == model.back());
+            model.pop_back();
+        }
+        assert(same(bits, model));
+
+        bits.resize(300, true);
+        model.resize(300, true);
+        assert(same(bits, model));
+        bits.truncate(65);
+        model.resize(65);
+        assert(same(bits, model));
+        bits.resize(64, false);
+        model.resize(64);
+        assert(same(bits, model));
+
+        BitVec ones = BitVec::repeat(true, 77);
+        assert(ones.all() && ones.count_ones() == 77 && ones.count_zeros() == 0 && tail_clear(ones));
+        ones.negate();
+        assert(ones.none() && !ones.any() && tail_clear(ones));
+        ones.fill(true);
+        assert(ones.all() && tail_clear(ones));
+        assert(BitVec().all() && BitVec().none());
+
+        BitVec reserved = BitVec::with_capacity(1000);
+        assert(reserved.is_empty() && reserved.capacity() >= 1000);
+        BitVec copy = bits.clone();
+        assert(copy == bits && copy != ones);
+        copy.clear();
+        assert(copy.is_empty() && copy.count_ones() == 0);
+    }
+    printf("PASS\n");
+}
+
+// Test set_range, first/last and iter_ones over random lengths
+void test_bitvec_ranges() {
+    printf("test_bitvec_ranges: ");
+    {
+        srand(45);
+        for (int round = 0; round < 500; round++) {
+            size_t len = rand() % 400;
+            BitVec bits = BitVec::repeat(round % 2 == 0, len);
+            std::vector<bool> model(len, round % 2 == 0);
+            for (int step = 0; step < 8; step++) {
+                size_t a = len ? rand() % (len + 1) : 0;
+                size_t b = len ? rand() % (len + 1) : 0;
+                if (a > b) std::swap(a, b);
+                bool bit = rand() % 2 == 0;
+                bits.set_range(a, b, bit);
+                for (size_t i = a; i < b; i++) model[i] = bit;
+                assert(same(bits, model));
+            }
+
+            std::vector<size_t> expected;
+            for (size_t i = 0; i < len; i++) {
+                if (model[i]) expected.push_back(i);
+            }
+            std::vector<size_t> got;
+            bits.iter_ones().for_each([&](size_t i) { got.push_back(i); });
+            assert(got == expected);
+            assert(bits.iter_ones().count() == expected.size());
+            assert(bits.first_one().is_some() == !expected.empty());
+            if (!expected.empty()) {
+                assert(bits.first_one().unwrap() == expected.front());
+                assert(bits.last_one().unwrap() == expected.back());
+            } else {
+                assert(bits.last_one().is_none());
+            }
+        }
+
+        BitVec empty;
+        auto it = empty.iter_ones();
+        assert(it.next().is_none() && it.next().is_none());
+    }
+    printf("PASS\n");
+}
+
+// Test the bulk operators against bitwise models, including mismatched
+// lengths (the left operand's length wins)
+void test_bitvec_bulk() {
+    printf("test_bitvec_bulk: ");
+    {
+        srand(7);
+        for (int round = 0; round < 300; round++) {
+            size_t la = rand() % 700;
+            size_t lb = rand() % 700;
+            BitVec a, b;
+            std::vector<bool> ma, mb;
+            for (size_t i = 0; i < la; i++) {
+                bool bit = rand() % 3 == 0;
+                a.push(bit);
+                ma.push_back(bit);
+            }
+            for (size_t i = 0; i < lb; i++) {
+                bool bit = rand() % 2 == 0;
+                b.push(bit);
+                mb.push_back(bit);
+            }
+            std::vector<bool> m_and(la), m_or(la), m_xor(la), m_sub(la), m_not(la);
+            for (size_t i = 0; i < la; i++) {
+                bool y = i < lb && mb[i];
+                m_and[i] = ma[i] && y;
+                m_or[i] = ma[i] || y;
+                m_xor[i] = ma[i] != y;
+                m_sub[i] = ma[i] && !y;
+                m_not[i] = !ma[i];
+            }
+            assert(same(a & b, m_and));
+            assert(same(a | b, m_or));
+            assert(same(a ^ b, m_xor));
+            assert(same(a - b, m_sub));
+            assert(same(~a, m_not));
+
+            BitVec c = a.clone();
+            c |= b;
+            c ^= b;
+            c &= a;
+            assert(same(c, m_sub));
+        }
+    }
+    printf("PASS\n");
+}
+
+// Test FixedBitSet membership and set algebra against std::set
+void test_fixedbitset() {
+    printf("test_fixedbitset: ");
+    {
+        FixedBitSet set = FixedBitSet::with_capacity(100);
+        assert(set.len() == 100 && set.is_clear() && !set.contains(5000));
+        set.insert(3);
+        assert(set.put(3) && !set.put(64));
+        assert(set.contains(3) && set.contains(64) && set.count_ones() == 2);
+        assert(set.remove(3) && !set.remove(3) && !set.remove(5000));
+        set.insert_range(10, 20);
+        assert(set.count_ones() == 11 && set.minimum().unwrap() == 10 && set.maximum().unwrap() == 64);
+        set.grow(50);
+        assert(set.len() == 100);
+        set.grow(1000);
+        set.insert(999);
+        assert(set.len() == 1000 && set.maximum().unwrap() == 999);
+        set.clear();
+        assert(set.is_clear() && set.len() == 1000);
+
+        srand(11);
+        for (int round = 0; round < 200; round++) {
+            size_t na = rand() % 600 + 1;
+            size_t nb = rand() % 600 + 1;
+            FixedBitSet a = FixedBitSet::with_capacity(na);
+            FixedBitSet b = FixedBitSet::with_capacity(nb);
+            std::set<size_t> sa, sb;
+            for (int i = 0; i < 100; i++) {
+                size_t x = rand() % na;
+                size_t y = rand() % (round % 4 == 0 ? 1 : nb);
+                a.insert(x);
+                sa.insert(x);
+                b.insert(y);
+                sb.insert(y);
+            }
+
+            size_t common = 0;
+            for (size_t x : sa) common += sb.count(x);
+            assert(a.intersection_count(b) == common && b.intersection_count(a) == common);
+            assert(a.union_count(b) == sa.size() + sb.size() - common);
+            assert(a.is_disjoint(b) == (common == 0));
+            assert(a.is_subset(b) == (common == sa.size()));
+            assert(a.is_superset(b) == (common == sb.size()));
+
+            std::vector<size_t> ones;
+            a.ones().for_each([&](size_t x) { ones.push_back(x); });
+            assert(ones == std::vector<size_t>(sa.begin(), sa.end()));
+
+            FixedBitSet u = a.clone();
+            u.union_with(b);
+            assert(u.len() == (na > nb ? na : nb) && u.count_ones() == sa.size() + sb.size() - common);
+            FixedBitSet x = a.clone();
+            x.symmetric_difference_with(b);
+            assert(x.count_ones() == sa.size() + sb.size() - 2 * common);
+            FixedBitSet d = a.clone();
+            d.difference_with(b);
+            assert(d.count_ones() == sa.size() - common && d.len() == na);
+            FixedBitSet i = a.clone();
+            i.intersect_with(b);
+            assert(i.count_ones() == common && i.is_subset(a) && i.is_subset(b));
+            assert(a == a.clone() && (a != b || na == nb));
+        }
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::BitVec ===\n");
+
+    test_bitvec_basic();
+    test_bitvec_ranges();
+    test_bitvec_bulk();
+    test_fixedbitset();
+
+    printf("\nAll BitVec tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,113 @@
+// Tests for the bounds-check policy and the get_unchecked accessors
+#include "../include/rusty/bounds.hpp"
+#include "../include/rusty/slice.hpp"
+#include "../include/rusty/smallvec.hpp"
+#include "../include/rusty/string.hpp"
+#include "../include/rusty/vec.hpp"
+#include "../include/rusty/vecdeque.hpp"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+using namespace rusty;
+
+// Whether f throws std::out_of_range with a message containing what
+template<typename F>
+static bool throws_out_of_range(F f, const char* what) {
+    try {
+        f();
+    } catch (const std::out_of_range& e) {
+        return std::strstr(e.what(), what) != nullptr;
+    }
+    return false;
+}
+
+// Test that out-of-range access throws exactly when checks are on
+void test_bounds_checked_access() {
+    printf("test_bounds_checked_access: ");
+    {
+        Vec<int> v;
+        SmallVec<int, 2> sv;
+        VecDeque<int> dq;
+        String s = String::from("abc");
+        str view(s);
+        int arr[3] = {1, 2, 3};
+        SliceMut<int> sm(arr, 3);
+
+        if (BOUNDS_CHECKS) {
+            assert(throws_out_of_range([&] { v[0]; }, "Vec index"));
+            assert(throws_out_of_range([&] { v.pop(); }, "pop from empty Vec"));
+            assert(throws_out_of_range([&] { v.front(); }, "front of empty Vec"));
+            assert(throws_out_of_range([&] { v.insert(1, 5); }, "Vec insert"));
+            assert(throws_out_of_range([&] { v.drain(0, 1); }, "Vec drain"));
+            assert(throws_out_of_range([&] { sv.back(); }, "back of empty SmallVec"));
+            assert(throws_out_of_range([&] { dq[0]; }, "VecDeque index"));
+            assert(throws_out_of_range([&] { dq.rotate_left(1); }, "VecDeque rotate"));
+            assert(throws_out_of_range([&] { s[3]; }, "index out of bounds"));
+            assert(throws_out_of_range([&] { s.slice(2, 4); }, "slice range"));
+            assert(throws_out_of_range([&] { view[3]; }, "index out of bounds"));
+            assert(throws_out_of_range([&] { sm[3]; }, "SliceMut index"));
+            assert(throws_out_of_range([&] { sm.as_slice().slice(1, 4); }, "Slice range"));
+            assert(throws_out_of_range([&] { sm.split_at_mut(4); }, "SliceMut split"));
+
+            // A failed check leaves the container as it was
+            assert(v.is_empty() && s.len() == 3);
+        }
+
+        // The condition is not evaluated at all when checks are off
+        int evaluated = 0;
+        RUSTY_BOUNDS_CHECK(++evaluated > 0, "unused");
+        assert(evaluated == (BOUNDS_CHECKS ? 1 : 0));
+    }
+    printf("PASS\n");
+}
+
+// Test that get_unchecked reads and writes the same elements as operator[]
+void test_bounds_get_unchecked() {
+    printf("test_bounds_get_unchecked: ");
+    {
+        Vec<int> v;
+        SmallVec<int, 2> sv;
+        VecDeque<int> dq;
+        for (int i = 0; i < 10; i++) {
+            v.push(i);
+            sv.push(i);
+            dq.push_front(i);
+        }
+        for (size_t i = 0; i < v.len(); i++) {
+            assert(v.get_unchecked(i) == v[i]);
+            assert(sv.get_unchecked(i) == sv[i]);
+            assert(dq.get_unchecked(i) == dq[i]);
+            v.get_unchecked_mut(i) *= 2;
+            sv.get_unchecked_mut(i) += 1;
+            dq.get_unchecked_mut(i) -= 1;
+        }
+        assert(v[9] == 18 && sv[9] == 10 && dq[0] == 8);
+
+        Slice<int> slice = v.as_slice();
+        SliceMut<int> slice_mut = v.as_mut_slice();
+        slice_mut.get_unchecked_mut(0) = 7;
+        assert(slice.get_unchecked(0) == 7 && slice_mut.get_unchecked(0) == 7);
+
+        String s = String::from("hello, bounds");
+        size_t commas = 0;
+        for (size_t i = 0; i < s.len(); i++) commas += s.get_unchecked(i) == ',';
+        assert(commas == 1);
+        s.get_unchecked_mut(0) = 'H';
+        assert(s.as_str() == "Hello, bounds");
+        str view(s);
+        assert(view.get_unchecked(4) == 'o');
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty bounds checks (%s) ===\n", BOUNDS_CHECKS ? "checked" : "unchecked");
+
+    test_bounds_checked_access();
+    test_bounds_get_unchecked();
+
+    printf("\nAll bounds tests passed!\n");
+    return 0;
+}
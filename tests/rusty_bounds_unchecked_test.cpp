@@ -0,0 +1,3 @@
+// Runs the bounds tests with the checks compiled out
+#define RUSTY_BOUNDS_CHECKS 0
+#include "rusty_bounds_test.cpp"
@@ -0,0 +1,808 @@
+// Tests for rusty::BTreeMap
+#include "../include/rusty/btreemap.hpp"
+#include "../include/rusty/btreeset.hpp"
+#include "../include/rusty/string.hpp"
+#include <cassert>
+#include <cstdio>
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <set>
+#include <vector>
+
+using namespace rusty;
+
+// Not default-constructible; counts live objects to catch leaks and
+// double destruction in the uninitialized node storage
+struct Tracked {
+    static long live;
+    int value;
+
+    explicit Tracked(int v) : value(v) { live++; }
+    Tracked(const Tracked& other) : value(other.value) { live++; }
+    Tracked(Tracked&& other) noexcept : value(other.value) { live++; }
+    Tracked& operator=(const Tracked&) = default;
+    Tracked& operator=(Tracked&&) = default;
+    ~Tracked() { live--; }
+
+    bool operator==(const Tracked& other) const { return value == other.value; }
+    bool operator!=(const Tracked& other) const { return value != other.value; }
+};
+
+long Tracked::live = 0;
+
+void test_btreemap_basic() {
+    printf("test_btreemap_basic: ");
+    {
+        auto map = BTreeMap<int, int>::new_();
+        assert(map.is_empty());
+        assert(map.first_key_value().is_none());
+
+        for (int i = 0; i < 1000; i++) {
+            assert(map.insert((i * 37) % 1000, i).is_none());
+        }
+        assert(map.len() == 1000);
+        assert(map.insert(5, -1).is_some());
+        assert(map.get(5).unwrap() == -1);
+
+        int expected = 0;
+        for (auto kv : map) {
+            assert(kv.first == expected++);
+        }
+        assert(expected == 1000);
+
+        assert(*map.first_key_value().unwrap().first == 0);
+        assert(*map.last_key_value().unwrap().first == 999);
+        assert(map.pop_first().unwrap().first == 0);
+        assert(map.pop_last().unwrap().first == 999);
+        assert(*map.last_key_value().unwrap().first == 998);
+
+        for (int i = 1; i < 998; i += 2) {
+            assert(map.remove(i).is_some());
+        }
+        assert(map.remove(1).is_none());
+        assert(map.len() == 499);
+
+        expected = 2;
+        for (auto kv : map) {
+            assert(kv.first == expected);
+            expected += 2;
+        }
+
+        auto copy = map.clone();
+        assert(copy == map);
+        assert(copy.stats().leaf_nodes == map.stats().leaf_nodes);
+        map.clear();
+        assert(map.is_empty() && copy.len() == 499);
+        assert((map.clone().is_empty() && BTreeMap<int, int>(std::move(map)).len() == 0));
+        assert(map.clone().insert(1, 1).is_none());
+    }
+    printf("PASS\n");
+}
+
+void test_btreemap_uninit_storage() {
+    printf("test_btreemap_uninit_storage: ");
+    {
+        BTreeMap<int, Tracked> map;
+        // Empty nodes construct no values
+        assert(Tracked::live == 0);
+
+        for (int i = 0; i < 500; i++) {
+            map.insert(i, Tracked(i));
+        }
+        assert(Tracked::live == 500);
+
+        for (int i = 0; i < 500; i += 3) {
+            assert(map.remove(i).unwrap().value == i);
+        }
+        assert(Tracked::live == long(map.len()));
+        assert(map.get(1).unwrap().value == 1);
+
+        map.insert(1, Tracked(-1));
+        assert(Tracked::live == long(map.len()));
+
+        auto moved = std::move(map);
+        assert(Tracked::live == long(moved.len()));
+        map.insert(7, Tracked(7));  // Usable again after the move
+        assert(map.len() == 1);
+    }
+    assert(Tracked::live == 0);
+    printf("PASS\n");
+}
+
+void test_btreemap_string_keys() {
+    printf("test_btreemap_string_keys: ");
+    {
+        // String is move-only: separators are made with clone()
+        BTreeMap<String, int> map;
+        for (int i = 0; i < 200; i++) {
+            char buf[16];
+            snprintf(buf, sizeof(buf), "key%03d", i);
+            map.insert(String::from(buf), i);
+        }
+        assert(map.len() == 200);
+        assert(map.get(String::from("key123")).unwrap() == 123);
+        assert(map.remove(String::from("key000")).unwrap() == 0);
+        assert(*map.first_key_value().unwrap().first == "key001");
+
+        auto keys = map.keys();
+        assert(keys.len() == 199);
+        assert(keys[198] == "key199");
+
+        // The clone copies node for node, separators included
+        auto copy = map.clone();
+        stats::BTreeStats a = map.stats(), b = copy.stats();
+        assert(b.depth == a.depth && b.leaf_nodes == a.leaf_nodes);
+        assert(b.internal_keys == a.internal_keys && b.leaf_keys == a.leaf_keys);
+        map.clear();
+        assert(copy.len() == 199 && copy.get(String::from("key150")).unwrap() == 150);
+        assert(*copy.last_key_value().unwrap().first == "key199");
+        size_t n = 0;
+        for (auto it = copy.iter(); it.next_back().is_some(); ) n++;
+        assert(n == 199);
+        copy.insert(String::from("key000"), 0);
+        assert(*copy.first_key_value().unwrap().first == "key000");
+    }
+    printf("PASS\n");
+}
+
+void test_btreemap_random_ops() {
+    printf("test_btreemap_random_ops: ");
+    {
+        BTreeMap<int, Tracked> map;
+        std::map<int, int> model;
+        srand(12345);
+
+        for (int step = 0; step < 50000; step++) {
+            int key = rand() % 2000;
+            int op = rand() % 3;
+            if (op < 2) {
+                bool had = model.count(key) > 0;
+                assert(map.insert(key, Tracked(step)).is_some() == had);
+                model[key] = step;
+            } else {
+                auto removed = map.remove(key);
+                auto it = model.find(key);
+                assert(removed.is_some() == (it != model.end()));
+                if (it != model.end()) {
+                    assert(removed.unwrap().value == it->second);
+                    model.erase(it);
+                }
+            }
+        }
+
+        assert(map.len() == model.size());
+        assert(Tracked::live == long(model.size()));
+        auto it = model.begin();
+        for (auto kv : map) {
+            assert(kv.first == it->first && kv.second.value == it->second);
+            ++it;
+        }
+        assert(it == model.end());
+        assert(*map.last_key_value().unwrap().first == model.rbegin()->first);
+
+        // Drain from both ends
+        while (!model.empty()) {
+            assert(map.pop_first().unwrap().first == model.begin()->first);
+            model.erase(model.begin());
+            if (model.empty()) break;
+            assert(map.pop_last().unwrap().first == model.rbegin()->first);
+            model.erase(std::prev(model.end()));
+        }
+        assert(map.is_empty() && map.pop_first().is_none());
+    }
+    assert(Tracked::live == 0);
+    printf("PASS\n");
+}
+
+template<typename Map>
+static void check_against_model(Map& map, int key_range, int steps) {
+    std::map<int, int> model;
+    for (int step = 0; step < steps; step++) {
+        int key = rand() % key_range;
+        if (rand() % 3 < 2) {
+            map.insert(key, step);
+            model[key] = step;
+        } else {
+            assert(map.remove(key).is_some() == (model.erase(key) > 0));
+        }
+        if (step % 97 == 0) {
+            // Probe a few keys, present and absent
+            for (int probe = -1; probe <= key_range; probe += key_range / 7) {
+                auto it = model.find(probe);
+                auto got = map.get(probe);
+                assert(got.is_some() == (it != model.end()));
+                if (got.is_some()) assert(got.unwrap() == it->second);
+            }
+        }
+    }
+    assert(map.len() == model.size());
+    auto it = model.begin();
+    for (auto kv : map) {
+        assert(kv.first == it->first && kv.second == it->second);
+        ++it;
+    }
+}
+
+void test_btreemap_branching() {
+    printf("test_btreemap_branching: ");
+    {
+        // The default B fills the node budget, never below Rust's B = 6
+        static_assert(BTreeMap<int64_t, int64_t>::BRANCHING ==
+                      BTREE_NODE_CACHE_LINES * BTREE_CACHE_LINE / 16 / 2, "int64 nodes fill the budget");
+        static_assert(BTreeMap<int, Tracked[64]>::BRANCHING == BTREE_B, "huge entries fall back to B = 6");
+        static_assert(BTreeMap<int, int, std::less<int>, Global, 3>::MAX_LEN == 5, "explicit B");
+        static_assert(btree_b_for<int64_t, int64_t, 16>::value == 32, "64 int64 entries per node");
+
+        srand(777);
+        BTreeMap<int, int, std::less<int>, Global, 2> tiny;
+        check_against_model(tiny, 500, 20000);
+
+        BTreeMap<int, int, std::less<int>, Global, 64> wide;
+        check_against_model(wide, 20000, 60000);
+
+        // Transparent std::less<> and non-arithmetic keys take the binary search
+        BTreeMap<int, int, std::less<>> transparent;
+        check_against_model(transparent, 3000, 20000);
+
+        BTreeMap<double, int> doubles;
+        for (int i = 0; i < 1000; i++) {
+            doubles.insert(i * 0.5, i);
+        }
+        assert(doubles.get(250.0).unwrap() == 500);
+        assert(doubles.get(250.25).is_none());
+
+        BTreeSet<unsigned, std::less<unsigned>, Global, 64> set;
+        for (unsigned i = 0; i < 5000; i++) {
+            set.insert(i * 3);
+        }
+        assert(set.contains(2997) && !set.contains(2998));
+        assert(set.last().unwrap() == 14997);
+    }
+    printf("PASS\n");
+}
+
+void test_btreemap_range() {
+    printf("test_btreemap_range: ");
+    {
+        BTreeMap<int, int> map;
+        std::map<int, int> model;
+        for (int i = 0; i < 3000; i += 3) {
+            map.insert(i, i * 10);
+            model[i] = i * 10;
+        }
+
+        // Every bound kind on both ends, against std::map
+        srand(99);
+        for (int trial = 0; trial < 300; trial++) {
+            int a = rand() % 3100 - 50;
+            int b = a + rand() % 400;
+            int lo_kind = rand() % 3;
+            int hi_kind = rand() % 3;
+            Bound<int> lo = lo_kind == 0 ? Included(a) : lo_kind == 1 ? Excluded(a) : Bound<int>(Unbounded);
+            Bound<int> hi = hi_kind == 0 ? Included(b) : hi_kind == 1 ? Excluded(b) : Bound<int>(Unbounded);
+
+            auto first = lo_kind == 0 ? model.lower_bound(a) : lo_kind == 1 ? model.upper_bound(a) : model.begin();
+            auto last = hi_kind == 0 ? model.upper_bound(b) : hi_kind == 1 ? model.lower_bound(b) : model.end();
+
+            auto range = map.range(lo, hi);
+            for (auto it = first; it != last && it != model.end(); ++it) {
+                auto item = range.next();
+                assert(item.is_some());
+                auto kv = item.unwrap();
+                assert(*kv.first == it->first && *kv.second == it->second);
+            }
+            assert(range.next().is_none());
+        }
+
+        // Double-ended: alternate ends until they meet
+        auto range = map.range(Included(100), Excluded(200));
+        int front = 102, back = 198;
+        bool from_front = true;
+        for (;;) {
+            auto item = from_front ? range.next() : range.next_back();
+            if (item.is_none()) break;
+            int key = *item.unwrap().first;
+            if (from_front) {
+                assert(key == front);
+                front += 3;
+            } else {
+                assert(key == back);
+                back -= 3;
+            }
+            from_front = !from_front;
+        }
+        assert(front > back && range.is_empty());
+
+        // Range-for, mutable ranges and empty ranges
+        int count = 0;
+        for (auto kv : map.range(10, 20)) {
+            assert(kv.first >= 10 && kv.first <= 20);
+            count++;
+        }
+        assert(count == 3);
+        for (auto kv : map.range_mut(Unbounded, Excluded(9))) {
+            kv.second = -kv.first;
+        }
+        assert(map.get(6).unwrap() == -6 && map.get(9).unwrap() == 90);
+        assert(map.range(Excluded(3), Excluded(6)).is_empty());
+        assert(map.range(50, 10).is_empty());
+        assert(map.range(Included(5000), Unbounded).is_empty());
+        BTreeMap<int, int> empty;
+        assert(empty.iter().is_empty());
+
+        auto all = map.iter();
+        assert(*all.next_back().unwrap().first == 2997);
+        assert(*all.next().unwrap().first == 0);
+
+        BTreeSet<int> set;
+        for (int i = 0; i < 100; i++) {
+            set.insert(i * 2);
+        }
+        auto evens = set.range(Excluded(10), Included(20));
+        assert(evens.next().unwrap() == 12);
+        assert(evens.next_back().unwrap() == 20);
+        int sum = 0;
+        for (int v : set.range(0, 6)) {
+            sum += v;
+        }
+        assert(sum == 12);
+        int seen = 0;
+        for (int v : set) {
+            assert(v == seen * 2);
+            seen++;
+        }
+        assert(seen == 100);
+    }
+    printf("PASS\n");
+}
+
+void test_btreemap_bulk_load() {
+    printf("test_btreemap_bulk_load: ");
+    {
+        for (int n : {0, 1, 10, 11, 12, 100, 1000, 12345}) {
+            std::vector<std::pair<int, Tracked>> items;
+            for (int i = 0; i < n; i++) {
+                items.emplace_back(i * 2, Tracked(i));
+            }
+            auto map = BTreeMap<int, Tracked>::from_sorted_iter(
+                std::make_move_iterator(items.begin()), std::make_move_iterator(items.end()));
+            items.clear();
+            assert(map.len() == size_t(n));
+            assert(Tracked::live == n);
+
+            int expected = 0;
+            for (auto kv : map) {
+                assert(kv.first == expected * 2 && kv.second.value == expected);
+                expected++;
+            }
+            assert(expected == n);
+            if (n > 0) {
+                assert(*map.last_key_value().unwrap().first == (n - 1) * 2);
+                assert(map.get(2 * n).is_none() && map.get(-1).is_none());
+            }
+
+            // The packed tree still supports every operation
+            for (int i = 1; i < 2 * n; i += 2) {
+                map.insert(i, Tracked(-i));
+            }
+            for (int i = 0; i < 2 * n; i += 3) {
+                assert(map.remove(i).is_some());
+            }
+            assert(Tracked::live == long(map.len()));
+        }
+        assert(Tracked::live == 0);
+
+        // Duplicates keep the last value; stragglers are inserted
+        std::pair<int, int> dups[] = {{1, 1}, {2, 2}, {2, 3}, {5, 5}, {3, 3}, {6, 6}, {0, 0}};
+        auto map = BTreeMap<int, int>::from_sorted_iter(std::begin(dups), std::end(dups));
+        assert(map.len() == 6);
+        assert(map.get(2).unwrap() == 3);
+        int expected = 0;
+        for (auto kv : map) {
+            assert(kv.first >= expected);
+            expected = kv.first + 1;
+        }
+
+        std::vector<int> sorted;
+        for (int i = 0; i < 1000; i++) sorted.push_back(i);
+        auto set = BTreeSet<int>::from_sorted_iter(sorted.begin(), sorted.end());
+        assert(set.len() == 1000 && set.contains(999) && !set.contains(1000));
+    }
+    printf("PASS\n");
+}
+
+void test_btreemap_append() {
+    printf("test_btreemap_append: ");
+    {
+        BTreeMap<int, Tracked> a, b;
+        for (int i = 0; i < 3000; i += 2) a.insert(i, Tracked(i));
+        for (int i = 0; i < 3000; i += 3) b.insert(i, Tracked(-i));
+
+        a.append(b);
+        assert(b.is_empty());
+        assert(Tracked::live == long(a.len()));
+        assert(a.len() == 1500 + 1000 - 500);
+
+        int prev = -1;
+        for (auto kv : a) {
+            assert(kv.first > prev);
+            prev = kv.first;
+            // other's value wins for shared keys
+            assert(kv.second.value == (kv.first % 3 == 0 ? -kv.first : kv.first));
+        }
+
+        b.insert(5000, Tracked(5000));
+        a.append(b);
+        assert(*a.last_key_value().unwrap().first == 5000);
+        assert(a.remove(5000).unwrap().value == 5000);
+
+        BTreeMap<int, Tracked> empty;
+        empty.append(a);
+        assert(a.is_empty() && long(empty.len()) == Tracked::live);
+
+        BTreeSet<int> s1, s2;
+        for (int i = 0; i < 100; i++) {
+            s1.insert(i);
+            s2.insert(i + 50);
+        }
+        s1.append(s2);
+        assert(s1.len() == 150 && s2.is_empty());
+    }
+    assert(Tracked::live == 0);
+    printf("PASS\n");
+}
+
+void test_btreemap_split_off() {
+    printf("test_btreemap_split_off: ");
+    {
+        srand(4242);
+        for (int trial = 0; trial < 200; trial++) {
+            BTreeMap<int, Tracked, std::less<int>, Global, 2> map;
+            std::map<int, int> model;
+            int n = rand() % 400;
+            for (int i = 0; i < n; i++) {
+                int key = rand() % 1000;
+                map.insert(key, Tracked(key));
+                model[key] = key;
+            }
+            int cut = rand() % 1002 - 1;
+            auto right = map.split_off(cut);
+            auto lower = model.lower_bound(cut);
+            assert(map.len() == size_t(std::distance(model.begin(), lower)));
+            assert(right.len() == model.size() - map.len());
+            assert(Tracked::live == long(map.len() + right.len()));
+            for (auto kv : map) assert(kv.first < cut && kv.second.value == kv.first);
+            for (auto kv : right) assert(kv.first >= cut);
+            
+            // Both halves stay well formed for further use
+            for (int i = 0; i < 100; i++) {
+                int key = rand() % 1000;
+                map.insert(key, Tracked(key));
+                right.remove(key);
+            }
+            auto back = right.iter();
+            while (back.next_back().is_some()) {}
+            map.append(right);
+            assert(right.is_empty());
+        }
+        
+        BTreeSet<int> set;
+        for (int i = 0; i < 100; i++) set.insert(i);
+        BTreeSet<int> upper = set.split_off(60);
+        assert(set.len() == 60 && upper.len() == 40);
+        assert(set.last().unwrap() == 59 && upper.first().unwrap() == 60);
+        assert(upper.split_off(1000).is_empty());
+        assert(upper.split_off(0).len() == 40 && upper.is_empty());
+    }
+    assert(Tracked::live == 0);
+    printf("PASS\n");
+}
+
+void test_btreemap_retain() {
+    printf("test_btreemap_retain: ");
+    {
+        BTreeMap<int, Tracked> map;
+        for (int i = 0; i < 2000; i++) map.insert(i, Tracked(i));
+        map.retain([](const int& key, Tracked& value) {
+            value.value = -key;
+            return key % 7 == 0;
+        });
+        assert(map.len() == 286 && Tracked::live == 286);
+        int expected = 0;
+        for (auto kv : map) {
+            assert(kv.first == expected && kv.second.value == -expected);
+            expected += 7;
+        }
+        map.insert(1, Tracked(1));
+        assert(map.get(1).is_some());
+        
+        BTreeSet<int> set;
+        for (int i = 0; i < 100; i++) set.insert(i);
+        set.retain([](const int& x) { return x >= 90; });
+        assert(set.len() == 10 && set.first().unwrap() == 90);
+        std::vector<int> low = {1, 2};
+        set.extend(BTreeSet<int>::from_sorted_iter(low.begin(), low.end()));
+        assert(set.len() == 12 && set.first().unwrap() == 1);
+    }
+    assert(Tracked::live == 0);
+    printf("PASS\n");
+}
+
+// In-order appends fill every node, and other operations still work on
+// the short right border that leaves
+void test_btreemap_append_max() {
+    printf("test_btreemap_append_max: ");
+    {
+        BTreeMap<uint64_t, int> appended;
+        BTreeMap<uint64_t, int> inserted;
+        for (int i = 0; i < 100000; i++) {
+            uint64_t ts = 1700000000000ull + uint64_t(i) * 10;
+            assert(appended.append_max(ts, i).is_none());
+            inserted.insert(ts, i);
+        }
+        stats::BTreeStats a = appended.stats(), b = inserted.stats();
+        assert(a.len == 100000 && a.leaf_nodes * a.node_capacity < 100000 + a.node_capacity);
+        assert(a.leaf_fill() > 0.99 && b.leaf_fill() < 0.6);
+        assert(a.leaf_nodes < b.leaf_nodes && a.depth <= b.depth);
+        assert(appended.get(1700000000000ull + 500).unwrap() == 50);
+
+        BTreeSet<int> set;
+        for (int i = 0; i < 1000; i++) assert(set.append_max(i));
+        assert(!set.append_max(500) && set.len() == 1000 && set.last().unwrap() == 999);
+
+        // A late, out-of-order or repeated timestamp is inserted normally
+        assert(appended.append_max(1700000000005ull, -1).is_none());
+        assert(appended.append_max(1700000000010ull, -2).unwrap() == 1);
+        assert(appended.len() == 100001);
+        uint64_t prev = 0;
+        for (auto kv : appended) {
+            assert(kv.first > prev);
+            prev = kv.first;
+        }
+    }
+    {
+        srand(7070);
+        for (int trial = 0; trial < 200; trial++) {
+            BTreeMap<int, Tracked, std::less<int>, Global, 2> map;
+            std::map<int, int> model;
+            int n = rand() % 300;
+            for (int i = 0; i < n; i++) {
+                map.append_max(i * 2, Tracked(i));
+                model[i * 2] = i;
+            }
+            switch (trial % 4) {
+                case 0:
+                    while (map.pop_last().is_some()) {}
+                    model.clear();
+                    break;
+                case 1: {
+                    int cut = rand() % (2 * n + 2);
+                    auto right = map.split_off(cut);
+                    model.erase(model.lower_bound(cut), model.end());
+                    right.append_max(1 << 20, Tracked(0));
+                    assert(right.remove(1 << 20).is_some());
+                    break;
+                }
+                default:
+                    for (int i = 0; i < n; i++) {
+                        int key = rand() % (2 * n + 2);
+                        if (rand() % 3 == 0) {
+                            map.insert(key, Tracked(-key));
+                            model[key] = -key;
+                        } else {
+                            map.remove(key);
+                            model.erase(key);
+                        }
+                        if (rand() % 4 == 0) {
+                            int top = model.empty() ? 0 : model.rbegin()->first + 1;
+                            map.append_max(top, Tracked(top));
+                            model[top] = top;
+                        }
+                    }
+                    break;
+            }
+            assert(map.len() == model.size() && Tracked::live == long(model.size()));
+            auto it = model.begin();
+            for (auto kv : map) {
+                assert(kv.first == it->first && kv.second.value == it->second);
+                ++it;
+            }
+            for (auto kv : model) assert(map.get(kv.first).unwrap().value == kv.second);
+            auto copy = map.clone();
+            while (copy.pop_first().is_some()) {}
+        }
+    }
+    assert(Tracked::live == 0);
+    printf("PASS\n");
+}
+
+// Walking and editing a map through a cursor
+void test_btreemap_cursor() {
+    printf("test_btreemap_cursor: ");
+    {
+        BTreeMap<int, int> map;
+        for (int i = 0; i < 100; i += 10) map.insert(i, i);
+
+        auto cursor = map.lower_bound_mut(Included(35));
+        assert(*cursor.peek_next().unwrap().first == 40);
+        assert(*cursor.peek_prev().unwrap().first == 30);
+        *cursor.next().unwrap().second = 41;
+        assert(*cursor.prev().unwrap().first == 40 && *cursor.prev().unwrap().first == 30);
+        assert(map.get(40).unwrap() == 41);
+
+        auto end = map.upper_bound_mut(Unbounded);
+        assert(end.peek_next().is_none() && *end.peek_prev().unwrap().first == 90);
+        auto start = map.upper_bound_mut(Excluded(0));
+        assert(start.peek_prev().is_none() && *start.peek_next().unwrap().first == 0);
+
+        // Hints that fit go in place, wrong ones are still inserted
+        auto at = map.lower_bound_mut(Included(50));
+        assert(at.insert_hint(45, -45).is_none());
+        assert(*at.peek_prev().unwrap().first == 45 && *at.peek_next().unwrap().first == 50);
+        assert(at.insert_hint(50, -50).unwrap() == 50);
+        assert(*at.peek_prev().unwrap().first == 50);
+        assert(at.insert_hint(5, -5).is_none() && *at.peek_next().unwrap().first == 10);
+        assert(at.insert_hint(45, 0).unwrap() == -45);
+        assert(map.len() == 12 && map.get(5).unwrap() == -5);
+
+        auto gap = map.lower_bound_mut(Included(20));
+        assert(gap.remove_next().unwrap().first == 20);
+        assert(gap.remove_prev().unwrap().first == 10);
+        assert(*gap.peek_next().unwrap().first == 30 && *gap.peek_prev().unwrap().first == 5);
+        assert(map.len() == 10 && map.get(20).is_none());
+
+        BTreeMap<int, int> empty;
+        auto nothing = empty.lower_bound_mut(Unbounded);
+        assert(nothing.next().is_none() && nothing.remove_prev().is_none());
+        assert(nothing.insert_hint(1, 1).is_none() && empty.len() == 1);
+    }
+    {
+        // Events arrive nearly in order: each one is placed from a cursor
+        // left after the previous one, against std::map
+        srand(1234);
+        BTreeMap<int, Tracked, std::less<int>, Global, 2> map;
+        std::map<int, int> model;
+        auto cursor = map.upper_bound_mut(Unbounded);
+        for (int i = 0; i < 20000; i++) {
+            int key = i * 3 - rand() % 40;
+            Option<Tracked> old = cursor.insert_hint(key, Tracked(i));
+            assert(old.is_some() == (model.count(key) == 1));
+            model[key] = i;
+            assert(*cursor.peek_prev().unwrap().first == key);
+            if (i % 5 == 0) {
+                // Drop the entry before (sometimes after) the last one
+                auto removed = rand() % 2 ? cursor.remove_prev() : cursor.remove_next();
+                if (removed.is_some()) model.erase(removed.unwrap().first);
+            }
+        }
+        assert(map.len() == model.size() && Tracked::live == long(model.size()));
+        auto it = model.begin();
+        for (auto kv : map) {
+            assert(kv.first == it->first && kv.second.value == it->second);
+            ++it;
+        }
+
+        // Walk back to the front, removing every other entry
+        auto back = map.upper_bound_mut(Unbounded);
+        size_t kept = 0;
+        while (back.peek_prev().is_some()) {
+            int key = back.remove_prev().unwrap().first;
+            model.erase(key);
+            if (back.prev().is_some()) kept++;
+        }
+        assert(map.len() == kept && map.len() == model.size());
+        for (auto kv : model) assert(map.get(kv.first).unwrap().value == kv.second);
+    }
+    assert(Tracked::live == 0);
+    printf("PASS\n");
+}
+
+// Set operations against std::set_* over balanced and lopsided inputs
+void test_btreeset_set_ops() {
+    printf("test_btreeset_set_ops: ");
+    {
+        srand(99);
+        size_t sizes[][2] = {{0, 0}, {0, 50}, {300, 300}, {1000, 40}, {20, 5000}, {3000, 2500}};
+        for (auto& ab : sizes) {
+            BTreeSet<int> a, b;
+            std::set<int> ma, mb;
+            for (size_t i = 0; i < ab[0]; i++) {
+                int x = rand() % 6000;
+                a.insert(x);
+                ma.insert(x);
+            }
+            for (size_t i = 0; i < ab[1]; i++) {
+                int x = rand() % 6000;
+                b.insert(x);
+                mb.insert(x);
+            }
+            
+            std::vector<int> expect;
+            auto same = [](const BTreeSet<int>& got, const std::vector<int>& want) {
+                if (got.len() != want.size()) return false;
+                size_t i = 0;
+                for (int x : got) {
+                    if (x != want[i++]) return false;
+                }
+                return true;
+            };
+            
+            std::set_union(ma.begin(), ma.end(), mb.begin(), mb.end(), std::back_inserter(expect));
+            assert(same(a.union_with(b), expect));
+            assert(a.union_iter(b).count() == expect.size());
+            
+            expect.clear();
+            std::set_intersection(ma.begin(), ma.end(), mb.begin(), mb.end(), std::back_inserter(expect));
+            assert(same(a.intersection(b), expect) && same(b.intersection(a), expect));
+            assert(a.intersection_iter(b).count() == expect.size());
+            assert(a.is_disjoint(b) == expect.empty());
+            
+            expect.clear();
+            std::set_difference(ma.begin(), ma.end(), mb.begin(), mb.end(), std::back_inserter(expect));
+            assert(same(a.difference(b), expect));
+            assert(a.is_subset(b) == expect.empty());
+            
+            expect.clear();
+            std::set_symmetric_difference(ma.begin(), ma.end(), mb.begin(), mb.end(),
+                                          std::back_inserter(expect));
+            assert(same(a.symmetric_difference(b), expect));
+            
+            BTreeSet<int> both = a.intersection(b);
+            assert(both.is_subset(a) && a.is_superset(both));
+        }
+        
+        // Lazy forms yield in sorted order and plug into the adaptors
+        BTreeSet<int> evens, threes;
+        for (int i = 0; i < 100; i += 2) evens.insert(i);
+        for (int i = 0; i < 100; i += 3) threes.insert(i);
+        Vec<int> sixes = evens.intersection_iter(threes).collect();
+        assert(sixes.len() == 17 && sixes[1] == 6 && sixes[16] == 96);
+        int prev = -1;
+        for (const int& x : evens.symmetric_difference_iter(threes)) {
+            assert(x > prev && (x % 2 == 0) != (x % 3 == 0));
+            prev = x;
+        }
+    }
+    printf("PASS\n");
+}
+
+void test_btreeset_basic() {
+    printf("test_btreeset_basic: ");
+    {
+        BTreeSet<int> set;
+        for (int i = 10; i > 0; i--) {
+            assert(set.insert(i));
+        }
+        assert(!set.insert(3));
+        assert(set.first().unwrap() == 1);
+        assert(set.last().unwrap() == 10);
+        assert(set.pop_first().unwrap() == 1);
+        assert(set.pop_last().unwrap() == 10);
+        assert(set.len() == 8 && set.contains(5));
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::BTreeMap ===\n");
+
+    test_btreemap_basic();
+    test_btreemap_uninit_storage();
+    test_btreemap_string_keys();
+    test_btreemap_random_ops();
+    test_btreemap_branching();
+    test_btreemap_range();
+    test_btreemap_bulk_load();
+    test_btreemap_append();
+    test_btreemap_split_off();
+    test_btreemap_retain();
+    test_btreemap_append_max();
+    test_btreemap_cursor();
+    test_btreeset_set_ops();
+    test_btreeset_basic();
+
+    printf("\nAll BTreeMap tests passed!\n");
+    return 0;
+}
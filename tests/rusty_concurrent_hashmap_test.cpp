@@ -0,0 +1,134 @@
+// Tests for rusty::ConcurrentHashMap
+#include "../include/rusty/concurrent_hashmap.hpp"
+#include "../include/rusty/string.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace rusty;
+
+void test_concurrent_basic() {
+    printf("test_concurrent_basic: ");
+    {
+        ConcurrentHashMap<int, int> map(8);
+        assert(map.shard_count() == 8);
+        assert(map.is_empty());
+
+        for (int i = 0; i < 1000; i++) {
+            assert(map.insert(i, i * 2).is_none());
+        }
+        assert(map.len() == 1000);
+        assert(map.insert(7, 70).unwrap() == 14);
+
+        {
+            auto guard = map.get(7);
+            assert(guard.is_some());
+            assert(*guard.unwrap() == 70);
+        }
+        assert(map.get(5000).is_none());
+        assert(map.get_cloned(10).unwrap() == 20);
+        assert(map.contains_key(999));
+
+        {
+            auto guard = map.get_mut(3).unwrap();
+            *guard += 1;
+        }
+        assert(map.get_cloned(3).unwrap() == 7);
+        assert(map.update(3, [](int& v) { v = 0; }));
+        assert(!map.update(-1, [](int& v) { v = 0; }));
+        assert(map.get_cloned(3).unwrap() == 0);
+
+        assert(map.remove(999).unwrap() == 1998);
+        assert(map.remove(999).is_none());
+        assert(map.len() == 999);
+
+        map.retain([](const int& k, int&) { return k % 2 == 0; });
+        long sum = 0;
+        size_t count = 0;
+        map.for_each([&](const int& k, const int&) { sum += k; count++; });
+        assert(count == 500 && map.len() == 500);
+        assert(sum == 998L * 500 / 2);
+
+        map.clear();
+        assert(map.is_empty());
+
+        using Map = ConcurrentHashMap<int, int>;
+        assert(Map(3).shard_count() == 4);
+        assert(Map::new_().shard_count() == Map::default_shard_count());
+    }
+    printf("PASS\n");
+}
+
+void test_concurrent_transparent() {
+    printf("test_concurrent_transparent: ");
+    {
+        ConcurrentHashMap<String, int, StringHash, StringEq> map(4);
+        map.insert(String::from("alpha"), 1);
+        map.insert(String::from("beta"), 2);
+
+        assert(map.contains_key(str("alpha")));
+        assert(*map.get(str("beta")).unwrap() == 2);
+        assert(map.get_cloned(str("gamma")).is_none());
+        assert(map.remove(str("alpha")).unwrap() == 1);
+        assert(map.len() == 1);
+    }
+    printf("PASS\n");
+}
+
+void test_concurrent_threads() {
+    printf("test_concurrent_threads: ");
+    {
+        const int THREADS = 8;
+        const int PER_THREAD = 5000;
+        ConcurrentHashMap<int, int> map(16);
+
+        // Disjoint inserts from every thread
+        std::vector<std::thread> workers;
+        for (int t = 0; t < THREADS; t++) {
+            workers.emplace_back([&map, t]() {
+                for (int i = 0; i < PER_THREAD; i++) {
+                    map.insert(t * PER_THREAD + i, i);
+                }
+            });
+        }
+        for (auto& w : workers) w.join();
+        workers.clear();
+        assert(map.len() == size_t(THREADS * PER_THREAD));
+
+        // Readers and counters on shared keys at the same time
+        std::atomic<long> found(0);
+        for (int t = 0; t < THREADS; t++) {
+            workers.emplace_back([&map, &found, t]() {
+                for (int i = 0; i < PER_THREAD; i++) {
+                    if (t % 2 == 0) {
+                        if (map.get(i).is_some()) found++;
+                    } else {
+                        *map.get_or_insert_with(-1 - (i % 64), []() { return 0; }) += 1;
+                    }
+                }
+            });
+        }
+        for (auto& w : workers) w.join();
+        assert(found == long(THREADS / 2) * PER_THREAD);
+
+        long total = 0;
+        for (int k = 1; k <= 64; k++) {
+            total += map.get_cloned(-k).unwrap();
+        }
+        assert(total == long(THREADS / 2) * PER_THREAD);
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::ConcurrentHashMap ===\n");
+
+    test_concurrent_basic();
+    test_concurrent_transparent();
+    test_concurrent_threads();
+
+    printf("\nAll ConcurrentHashMap tests passed!\n");
+    return 0;
+}
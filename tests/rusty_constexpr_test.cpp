@@ -0,0 +1,139 @@
+// Tests for compile-time use of rusty::Option, Result, str, ArrayVec and
+// ArrayString (C++20)
+#include "../include/rusty/arrayvec.hpp"
+#include "../include/rusty/option.hpp"
+#include "../include/rusty/result.hpp"
+#include "../include/rusty/string.hpp"
+#include <cassert>
+#include <cstdio>
+
+using namespace rusty;
+
+constexpr Option<int> find_digit(str s) {
+    for (size_t i = 0; i < s.len(); i++) {
+        if (s[i] >= '0' && s[i] <= '9') return Some(int(s[i] - '0'));
+    }
+    return None;
+}
+
+enum class ParseError { Empty, BadDigit, Overflow };
+
+using ParseResult = Result<unsigned, ParseError>;
+
+constexpr ParseResult parse_u16(str s) {
+    if (s.is_empty()) return ParseResult::Err(ParseError::Empty);
+    unsigned value = 0;
+    for (char c : s) {
+        if (c < '0' || c > '9') return ParseResult::Err(ParseError::BadDigit);
+        value = value * 10 + unsigned(c - '0');
+        if (value > 65535) return ParseResult::Err(ParseError::Overflow);
+    }
+    return ParseResult::Ok(value);
+}
+
+// Ports from a "host:port,host:port" list, checked while compiling
+constexpr ArrayVec<unsigned, 8> parse_ports(str list) {
+    ArrayVec<unsigned, 8> ports;
+    size_t start = 0;
+    for (size_t i = 0; i <= list.len(); i++) {
+        if (i == list.len() || list[i] == ',') {
+            str entry = list.slice(start, i);
+            size_t colon = 0;
+            while (entry[colon] != ':') colon++;
+            ports.push(parse_u16(entry.slice(colon + 1, entry.len())).unwrap());
+            start = i + 1;
+        }
+    }
+    return ports;
+}
+
+constexpr int six = 6;
+
+constexpr bool is_prime(int n) {
+    for (int d = 2; d * d <= n; d++) if (n % d == 0) return false;
+    return n >= 2;
+}
+
+void test_constexpr_option_result() {
+    printf("test_constexpr_option_result: ");
+    static_assert(find_digit("abc7d").unwrap() == 7);
+    static_assert(find_digit("none").is_none());
+    static_assert(find_digit("x").unwrap_or(-1) == -1);
+    static_assert(find_digit("a1").map([](int d) { return d * 2; }).unwrap() == 2);
+    static_assert(Some(3) == Some(3) && Some(3) != Option<int>(None));
+
+    static_assert(parse_u16("8080").unwrap() == 8080);
+    static_assert(parse_u16("").unwrap_err() == ParseError::Empty);
+    static_assert(parse_u16("80a").unwrap_err() == ParseError::BadDigit);
+    static_assert(parse_u16("70000").unwrap_err() == ParseError::Overflow);
+    static_assert(parse_u16("12").map([](unsigned v) { return v + 1; }).unwrap_or(0) == 13);
+    static_assert(parse_u16("x").map_err([](ParseError) { return -1; }).unwrap_err() == -1);
+
+    int x = 5;
+    static_assert(Option<const int*>(&six).is_some() && *Option<const int*>(&six).unwrap() == 6);
+    assert(Option<int&>(x).unwrap() == 5);
+    // The same functions still run at runtime
+    str input = "port 9";
+    assert(find_digit(input).unwrap() == 9 && parse_u16(input).is_err());
+    printf("PASS\n");
+}
+
+void test_constexpr_str() {
+    printf("test_constexpr_str: ");
+    constexpr str name = "rusty::str";
+    static_assert(name.len() == 10 && name[0] == 'r');
+    static_assert(name.starts_with("rusty") && name.ends_with("::str"));
+    static_assert(name.slice(7, 10) == str("str"));
+    static_assert(str().is_empty() && str("").len() == 0);
+    printf("PASS\n");
+}
+
+void test_constexpr_containers() {
+    printf("test_constexpr_containers: ");
+    constexpr auto primes = [] {
+        ArrayVec<int, 8> v;
+        for (int n = 2; !v.is_full(); n++) if (is_prime(n)) v.push(n);
+        return v;
+    }();
+    static_assert(primes.len() == 8 && primes[0] == 2 && primes.back() == 19);
+
+    constexpr auto ports = parse_ports("db:5432,cache:6379,web:8080");
+    static_assert(ports.len() == 3 && ports[0] == 5432 && ports[2] == 8080);
+
+    static_assert([] {
+        ArrayVec<int, 4> v = {1, 2, 3};
+        v.insert(0, 0);
+        bool full = v.try_push(4).is_err();
+        return full && v.remove(1) == 1 && v.swap_remove(0) == 0 && v[0] == 3;
+    }());
+
+    constexpr auto greeting = [] {
+        ArrayString<16> s;
+        s.push_str("hello");
+        s.push(',');
+        s.push_str(" world");
+        return s;
+    }();
+    static_assert(greeting == str("hello, world") && greeting.len() == 12);
+    static_assert(greeting.c_str()[12] == '\0');
+    static_assert(ArrayString<4>::from("hello").is_err());
+    static_assert(ArrayString<8>::from("hello").unwrap().as_str().ends_with("llo"));
+
+    // Compile-time tables are ordinary values at runtime
+    int sum = 0;
+    for (int p : primes) sum += p;
+    assert(sum == 2 + 3 + 5 + 7 + 11 + 13 + 17 + 19);
+    assert(greeting.to_string() == "hello, world");
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing constexpr rusty types ===\n");
+
+    test_constexpr_option_result();
+    test_constexpr_str();
+    test_constexpr_containers();
+
+    printf("\nAll constexpr tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,159 @@
+// Tests for rusty::Cow and the String methods that return it
+#include "../include/rusty/cow.hpp"
+#include "../include/rusty/string.hpp"
+#include "../include/rusty/vec.hpp"
+#include "../include/rusty/format.hpp"
+#include "../include/rusty/alloc_observer.hpp"
+#include <cassert>
+#include <cstdio>
+#include <string>
+
+using namespace rusty;
+
+// Counts every allocation
+struct AllocCounter : AllocObserver {
+    long allocs = 0;
+    void on_alloc(const AllocEvent&) override { allocs++; }
+    void on_dealloc(const AllocEvent&) override {}
+};
+
+void test_cow_basic() {
+    printf("test_cow_basic: ");
+    {
+        String source = String::from("a long enough string to live on the heap");
+        auto borrowed = Cow<str, String>::Borrowed(source);
+        assert(borrowed.is_borrowed() && !borrowed.is_owned());
+        assert(borrowed.as_ref().as_ptr() == source.as_ptr());
+        assert(borrowed == source && borrowed == "a long enough string to live on the heap");
+
+        // to_mut copies once, then edits the copy
+        auto edited = borrowed.clone();
+        assert(edited.is_borrowed());
+        edited.to_mut().push_str("!");
+        assert(edited.is_owned() && edited.as_ref().as_ptr() != source.as_ptr());
+        edited.to_mut().push_str("!");
+        assert(edited.as_ref().ends_with("heap!!") && source.len() + 2 == edited.as_ref().len());
+        assert(edited != borrowed);
+
+        // into_owned moves an owned value out
+        const char* buffer = edited.as_ref().as_ptr();
+        String taken = std::move(edited).into_owned();
+        assert(taken.as_ptr() == buffer);
+        String copied = std::move(borrowed).into_owned();
+        assert(copied == source && copied.as_ptr() != source.as_ptr());
+
+        // Moves keep the state; clone of an owned Cow is a separate copy
+        auto owned = Cow<str, String>::Owned(String::from("x"));
+        Cow<str, String> moved = std::move(owned);
+        assert(moved.is_owned() && moved == "x");
+        auto twin = moved.clone();
+        assert(twin.is_owned() && twin == moved && twin.as_ref().as_ptr() != moved.as_ref().as_ptr());
+        moved = Cow<str, String>::Borrowed(source);
+        assert(moved.is_borrowed());
+
+        str view = twin;
+        assert(view == str("x"));
+        assert(format("[{}]", twin) == "[x]");
+    }
+    printf("PASS\n");
+}
+
+void test_cow_slice() {
+    printf("test_cow_slice: ");
+    {
+        Vec<int> data = vec_of({1, 2, 3});
+        auto cow = Cow<Slice<int>, Vec<int>>::Borrowed(data.as_slice());
+        assert(cow.as_ref().len() == 3 && cow.as_ref().as_ptr() == data.as_ptr());
+        cow.to_mut().push(4);
+        assert(cow.is_owned() && cow.as_ref().len() == 4 && data.len() == 3);
+        Vec<int> out = std::move(cow).into_owned();
+        assert(out.len() == 4 && out[3] == 4);
+    }
+    printf("PASS\n");
+}
+
+// The unchanged cases borrow and never touch the heap
+void test_string_cow_no_alloc() {
+    printf("test_string_cow_no_alloc: ");
+    String text = String::from("already lowercase, nothing to replace here");
+    String upper = String::from("ALREADY UPPERCASE, NO LETTERS TO CHANGE");
+    std::string valid = "caf\xc3\xa9 \xe2\x82\xac and plenty of ascii after it";
+
+    AllocCounter counter;
+    set_alloc_observer(&counter);
+    {
+        auto replaced = text.replace("xyz", "abc");
+        assert(replaced.is_borrowed() && replaced.as_ref().as_ptr() == text.as_ptr());
+        auto empty_pattern = text.replace("", "abc");
+        assert(empty_pattern.is_borrowed());
+        auto lower = text.to_lowercase();
+        assert(lower.is_borrowed() && lower == text);
+        auto same = upper.to_uppercase();
+        assert(same.is_borrowed() && same == upper);
+        auto lossy = String::from_utf8_lossy(str(valid));
+        assert(lossy.is_borrowed() && lossy.as_ref().as_ptr() == valid.data());
+    }
+    set_alloc_observer(nullptr);
+    assert(counter.allocs == 0);
+    printf("PASS\n");
+}
+
+void test_string_cow_changes() {
+    printf("test_string_cow_changes: ");
+    {
+        String s = String::from("Hello, World");
+        auto replaced = s.replace("o", "0");
+        assert(replaced.is_owned() && replaced == "Hell0, W0rld");
+        assert(s.to_lowercase() == "hello, world" && s.to_uppercase() == "HELLO, WORLD");
+        assert(s.to_lowercase().is_owned() && s == "Hello, World");
+
+        // Temporaries are reused: no copy when converting or replacing them
+        String big = String::from("MIXED case text that is long enough for the heap");
+        const char* buffer = big.as_ptr();
+        auto lowered = std::move(big).to_lowercase();
+        assert(lowered.is_owned() && lowered.as_ref().as_ptr() == buffer);
+        assert(lowered.as_ref().starts_with("mixed case"));
+        String kept = std::move(lowered).into_owned();
+        auto unchanged = std::move(kept).replace("zzz", "y");
+        assert(unchanged.is_owned() && unchanged.as_ref().as_ptr() == buffer);
+
+        // Assigning to a String still works
+        String r = s.replace("World", "Cow");
+        assert(r == "Hello, Cow");
+    }
+    printf("PASS\n");
+}
+
+void test_from_utf8_lossy() {
+    printf("test_from_utf8_lossy: ");
+    {
+        const std::string fffd = "\xEF\xBF\xBD";
+        auto check = [&](const std::string& input, const std::string& expected) {
+            auto out = String::from_utf8_lossy(str(input));
+            assert(out.is_owned());
+            assert(out.as_ref() == str(expected));
+        };
+        check("ab\xFF" "cd", "ab" + fffd + "cd");
+        check("\xFF\xFE", fffd + fffd);
+        check("ok\xE2\x82", "ok" + fffd);                 // truncated tail
+        check("\xE2\x82" "x\xC3\xA9", fffd + "x\xC3\xA9");  // truncated mid-string
+        check("\xED\xA0\x80", fffd + fffd + fffd);       // surrogate, one per byte
+        check("\xF0\x9F\x98" "!", fffd + "!");
+
+        assert(String::from_utf8_lossy(str("")).is_borrowed());
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::Cow ===\n");
+
+    test_cow_basic();
+    test_cow_slice();
+    test_string_cow_no_alloc();
+    test_string_cow_changes();
+    test_from_utf8_lossy();
+
+    printf("\nAll Cow tests passed!\n");
+    return 0;
+}
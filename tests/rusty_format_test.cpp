@@ -0,0 +1,135 @@
+// Tests for rusty::format and rusty::write_fmt
+#include "../include/rusty/format.hpp"
+#include <cassert>
+#include <cstdio>
+#include <stdexcept>
+
+using namespace rusty;
+
+// Allocator that counts allocations in a shared counter
+struct CountingAlloc {
+    long* allocs;
+
+    CountingAlloc() : allocs(nullptr) {}
+    explicit CountingAlloc(long* a) : allocs(a) {}
+
+    void* allocate(size_t size, size_t align) {
+        ++*allocs;
+        return Global().allocate(size, align);
+    }
+
+    void deallocate(void* ptr, size_t size, size_t align) {
+        Global().deallocate(ptr, size, align);
+    }
+};
+
+struct Point {
+    int x;
+    int y;
+};
+
+namespace rusty {
+template<>
+struct Display<Point> {
+    static void fmt(const Point& p, Formatter& f) {
+        f.write_fmt("({}, {})", p.x, p.y);
+    }
+};
+} // namespace rusty
+
+bool format_throws(str fmt) {
+    try {
+        format(fmt, 1);
+    } catch (const std::invalid_argument&) {
+        return true;
+    }
+    return false;
+}
+
+void test_format_values() {
+    printf("test_format_values: ");
+    {
+        assert(format("plain") == "plain");
+        assert(format("{} {} {}", 42, -7, 0u) == "42 -7 0");
+        assert(format("{}", static_cast<unsigned char>(200)) == "200");
+        assert(format("{}|{}", true, 'c') == "true|c");
+        assert(format("{} {}", 1.5, 0.1) == "1.5 0.1");
+        assert(format("{}", 1e21) == "1000000000000000000000");
+        assert(format("{:.3}", 3.14159) == "3.142");
+        assert(format("{:e}", 1234.5) == "1.2345e+03");
+        assert(format("{}", std::numeric_limits<double>::max()).len() == 309);
+
+        std::string std_text = "std";
+        auto owned = String::from("owned");
+        const char* cstr = "cstr";
+        assert(format("{}-{}-{}-{}-{}", owned, str("view"), std_text, cstr, "lit") ==
+               "owned-view-std-cstr-lit");
+        assert(format("{{{}}}", 5) == "{5}");
+        assert(format("{}", Point{1, -2}) == "(1, -2)");
+        assert(to_string(99) == "99");
+    }
+    printf("PASS\n");
+}
+
+void test_format_specs() {
+    printf("test_format_specs: ");
+    {
+        assert(format("{:x} {:X} {:o} {:b}", 255, 255, 8, 5) == "ff FF 10 101");
+        assert(format("[{:5}]", 42) == "[   42]");
+        assert(format("[{:5}]", "ab") == "[ab   ]");
+        assert(format("[{:<5}]", 42) == "[42   ]");
+        assert(format("[{:^6}]", "ab") == "[  ab  ]");
+        assert(format("[{:*>4}]", 'x') == "[***x]");
+        assert(format("[{:05}]", -42) == "[-0042]");
+        assert(format("[{:08.2}]", 3.14159) == "[00003.14]");
+        assert(format("[{:.2}]", "abcdef") == "[ab]");
+        assert(format("[{:2}]", "toolong") == "[toolong]");
+
+        assert(format_throws("{} {}"));
+        assert(format_throws("none"));
+        assert(format_throws("{"));
+        assert(format_throws("}"));
+        assert(format_throws("{0}"));
+        assert(format_throws("{:q}"));
+        assert(format_throws("{:.}"));
+        assert(format_throws("{:e}"));
+    }
+    printf("PASS\n");
+}
+
+void test_write_fmt_no_alloc() {
+    printf("test_write_fmt_no_alloc: ");
+    {
+        long allocs = 0;
+        auto out = BasicString<CountingAlloc>::with_capacity_in(256, CountingAlloc(&allocs));
+        assert(allocs == 1);
+
+        for (int i = 0; i < 3; i++) {
+            out.clear();
+            write_fmt(out, "{{\"id\":{},\"score\":{:.4},\"name\":\"{}\",\"ok\":{}}}",
+                      123456789L + i, 0.5 + i, str("widget"), i % 2 == 0);
+        }
+        assert(out == "{\"id\":123456791,\"score\":2.5000,\"name\":\"widget\",\"ok\":true}");
+        assert(allocs == 1);
+
+        // Appends after existing contents, growing only when needed
+        auto small = BasicString<CountingAlloc>::new_in(CountingAlloc(&allocs));
+        write_fmt(small, "{}", 7);
+        write_fmt(small, ",{}", 8);
+        assert(small == "7,8" && allocs == 1);
+        write_fmt(small, "{:>40}", "x");
+        assert(small.len() == 43 && allocs == 2);
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::format ===\n");
+
+    test_format_values();
+    test_format_specs();
+    test_write_fmt_no_alloc();
+
+    printf("\nAll format tests passed!\n");
+    return 0;
+}
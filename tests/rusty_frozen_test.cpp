@@ -0,0 +1,126 @@
+// Tests for rusty::FrozenMap and rusty::StaticFrozenMap
+#include "../include/rusty/frozen.hpp"
+#include "../include/rusty/string.hpp"
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <string_view>
+
+using namespace rusty;
+
+// Test lookups, misses and the minimal perfect index over many sizes
+void test_frozen_lookup() {
+    printf("test_frozen_lookup: ");
+    {
+        size_t sizes[] = {0, 1, 2, 3, 63, 64, 65, 1000, 100000};
+        srand(49);
+        for (size_t size : sizes) {
+            Vec<std::pair<uint64_t, uint32_t>> entries;
+            std::map<uint64_t, uint32_t> model;
+            while (model.size() < size) {
+                uint64_t k = uint64_t(rand()) << 20 ^ uint64_t(rand());
+                if (model.count(k)) continue;
+                model[k] = uint32_t(model.size());
+                entries.push(std::make_pair(k, model[k]));
+            }
+            FrozenMap<uint64_t, uint32_t> map = FrozenMap<uint64_t, uint32_t>::from_vec(std::move(entries));
+            assert(map.len() == size && map.is_empty() == (size == 0));
+
+            Vec<bool> seen;
+            seen.resize(size, false);
+            for (const auto& kv : model) {
+                assert(map.get(kv.first).unwrap() == kv.second);
+                size_t index = map.get_index_of(kv.first).unwrap();
+                assert(index < size && !seen[index]);
+                seen[index] = true;
+                assert(*map.get_index(index).unwrap().first == kv.first);
+            }
+            for (int i = 0; i < 1000; i++) {
+                uint64_t k = uint64_t(rand()) << 20 ^ uint64_t(rand());
+                assert(map.contains_key(k) == (model.count(k) == 1));
+            }
+            size_t total = 0;
+            for (const auto& e : map) total += e.second == model[e.first] ? 1 : 0;
+            assert(total == size && map.iter().count() == size);
+        }
+    }
+    printf("PASS\n");
+}
+
+// Test String keys, heterogeneous lookup, duplicates and mutation
+void test_frozen_strings() {
+    printf("test_frozen_strings: ");
+    {
+        typedef FrozenMap<String, int, StringHash, StringEq> Map;
+        Vec<std::pair<String, int>> entries;
+        for (int i = 0; i < 500; i++) entries.push(std::make_pair(String::from(std::to_string(i)), i));
+        entries.push(std::make_pair(String::from("7"), -7));  // last wins
+        entries.push(std::make_pair(String::from(""), 1000));
+        Map map = Map::from_vec(std::move(entries));
+        assert(map.len() == 501);
+        assert(map.get(str("7")).unwrap() == -7);
+        assert(map.get(str("")).unwrap() == 1000);
+        assert(map.get(String::from("499")).unwrap() == 499);
+        assert(map.get(str("500")).is_none() && !map.contains_key(str("x")));
+        auto kv = map.get_key_value(String::from("42")).unwrap();
+        assert(*kv.first == "42" && *kv.second == 42);
+
+        map.get_mut(str("42")).unwrap() = 4242;
+        Map copy = map.clone();
+        assert(copy == map && copy.get(str("42")).unwrap() == 4242);
+        copy.get_mut(String::from("1")).unwrap() = 0;
+        assert(copy != map);
+
+        Vec<std::pair<String, int>> back = std::move(copy).into_entries();
+        assert(back.len() == 501);
+
+        Map empty = Map::new_();
+        assert(empty.is_empty() && empty.get(str("a")).is_none());
+    }
+    printf("PASS\n");
+}
+
+// Test tables built at compile time
+constexpr auto COLORS = make_static_frozen_map<std::string_view, int>(
+    {{"red", 0xf00}, {"green", 0x0f0}, {"blue", 0x00f}, {"black", 0}, {"white", 0xfff}});
+static_assert(COLORS.len() == 5, "");
+static_assert(COLORS.get_or("green", -1) == 0x0f0, "");
+static_assert(COLORS.get_or("purple", -1) == -1, "");
+static_assert(COLORS.contains_key("black") && !COLORS.contains_key(""), "");
+
+enum class Flag { Alpha, Beta, Gamma };
+
+void test_frozen_static() {
+    printf("test_frozen_static: ");
+    {
+        assert(COLORS.get("white").unwrap() == 0xfff && COLORS.get("grey").is_none());
+        size_t index = COLORS.index_of("blue");
+        assert(index < 5 && COLORS.key_at(index) == "blue" && COLORS.value_at(index) == 0x00f);
+        assert(COLORS.index_of("pink") == 5);
+
+        constexpr auto FLAGS = make_static_frozen_map<Flag, bool>({{Flag::Alpha, true}, {Flag::Gamma, false}});
+        static_assert(FLAGS.get_or(Flag::Alpha, false), "");
+        static_assert(!FLAGS.contains_key(Flag::Beta), "");
+
+        constexpr auto SQUARES = make_static_frozen_map<int, int>(
+            {{1, 1},   {2, 4},   {3, 9},   {4, 16},  {5, 25},  {6, 36},  {7, 49},  {8, 64},  {9, 81},  {10, 100},
+             {11, 121}, {12, 144}, {13, 169}, {14, 196}, {15, 225}, {16, 256}, {17, 289}, {18, 324}, {19, 361},
+             {20, 400}, {-1, 1},  {-2, 4},  {-3, 9},  {100, 10000}, {1000, 1000000}});
+        for (int i = -3; i <= 20; i++) assert(SQUARES.get_or(i, -1) == (i == 0 ? -1 : i * i));
+        assert(SQUARES.get_or(1000, 0) == 1000000 && SQUARES.get_or(999, 0) == 0);
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::FrozenMap ===\n");
+
+    test_frozen_lookup();
+    test_frozen_strings();
+    test_frozen_static();
+
+    printf("\nAll FrozenMap tests passed!\n");
+    return 0;
+}
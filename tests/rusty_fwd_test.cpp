@@ -0,0 +1,93 @@
+// Tests for rusty/fwd.hpp: declarations made before any container header
+// must name the same types the headers define
+#include "../include/rusty/fwd.hpp"
+
+#include <type_traits>
+
+// Only names and defaults are visible here
+struct RouteTable;
+int count_routes(const rusty::HashMap<rusty::String, int>& routes);
+size_t total_len(const rusty::Vec<rusty::String>& names);
+rusty::Option<int> first_key(const rusty::BTreeMap<int, rusty::str>& map);
+
+struct Holder {
+    rusty::Box<RouteTable>* table;
+    rusty::Arc<int>* shared;
+    rusty::SmallVec<int, 4>* small;
+    rusty::BitVec* bits;
+};
+
+#include "../include/rusty/arc.hpp"
+#include "../include/rusty/binaryheap.hpp"
+#include "../include/rusty/bitvec.hpp"
+#include "../include/rusty/box.hpp"
+#include "../include/rusty/btreeset.hpp"
+#include "../include/rusty/hashmap.hpp"
+#include "../include/rusty/persistent.hpp"
+#include "../include/rusty/smallvec.hpp"
+#include "../include/rusty/string.hpp"
+#include <cassert>
+#include <cstdio>
+
+using namespace rusty;
+
+int count_routes(const HashMap<String, int>& routes) { return static_cast<int>(routes.len()); }
+
+size_t total_len(const Vec<String>& names) {
+    size_t n = 0;
+    for (const String& s : names) n += s.len();
+    return n;
+}
+
+Option<int> first_key(const BTreeMap<int, str>& map) {
+    auto first = map.first_key_value();
+    if (first.is_none()) return None;
+    return Some(*first.unwrap().first);
+}
+
+void test_fwd_defaults() {
+    printf("test_fwd_defaults: ");
+    static_assert(std::is_same<HashMap<int, int>,
+                               HashMap<int, int, FxHash<int>, std::equal_to<int>, Global,
+                                       SeparateSlots>>::value, "HashMap defaults");
+    static_assert(std::is_same<Vec<int>, Vec<int, Global>>::value, "Vec defaults");
+    static_assert(std::is_same<BTreeSet<int>, BTreeSet<int, std::less<int>, Global, 0>>::value,
+                  "BTreeSet defaults");
+    static_assert(std::is_same<BinaryHeap<int>, BinaryHeap<int, std::less<int>, 2, Global>>::value,
+                  "BinaryHeap defaults");
+    static_assert(std::is_same<Arc<int>, Arc<int, 0>>::value, "Arc defaults");
+    static_assert(std::is_same<String, BasicString<Global>>::value, "String");
+    static_assert(std::is_same<PersistentVec<int>, PersistentVec<int, RcNodes>>::value,
+                  "PersistentVec defaults");
+
+    HashMap<String, int> routes;
+    routes.insert(String::from("/"), 1);
+    routes.insert(String::from("/api"), 2);
+    assert(count_routes(routes) == 2);
+
+    Vec<String> names;
+    names.push(String::from("ab"));
+    names.push(String::from("cde"));
+    assert(total_len(names) == 5);
+
+    BTreeMap<int, str> map;
+    assert(first_key(map).is_none());
+    map.insert(7, "seven");
+    map.insert(3, "three");
+    assert(first_key(map).unwrap() == 3);
+
+    SmallVec<int, 4> small;
+    small.push(1);
+    Holder holder = {nullptr, nullptr, &small, nullptr};
+    assert(holder.small->len() == 1 && holder.table == nullptr);
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty/fwd.hpp ===\n");
+
+    test_fwd_defaults();
+
+    printf("\nAll fwd tests passed!\n");
+    return 0;
+}
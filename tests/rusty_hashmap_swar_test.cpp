@@ -0,0 +1,3 @@
+// Runs the HashMap tests on the portable SWAR group backend
+#define RUSTY_HASHMAP_SWAR
+#include "rusty_hashmap_test.cpp"
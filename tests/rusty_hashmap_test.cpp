@@ -0,0 +1,599 @@
+// Tests for rusty::HashMap
+#include "../include/rusty/hashmap.hpp"
+#include "../include/rusty/box.hpp"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+using namespace rusty;
+
+// Counts allocate() calls to check the table layout
+struct CountingAlloc {
+    long* allocs;
+
+    CountingAlloc() : allocs(nullptr) {}
+    explicit CountingAlloc(long* a) : allocs(a) {}
+
+    void* allocate(size_t size, size_t align) {
+        (*allocs)++;
+        return Global().allocate(size, align);
+    }
+
+    void deallocate(void* ptr, size_t size, size_t align) {
+        Global().deallocate(ptr, size, align);
+    }
+};
+
+// Collect the offsets in a mask
+static size_t mask_offsets(BitMask mask, size_t* out) {
+    size_t n = 0;
+    while (mask) {
+        out[n++] = mask.lowest();
+        mask.clear_lowest();
+    }
+    return n;
+}
+
+void test_group_match() {
+    printf("test_group_match (GROUP_SIZE=%zu): ", GROUP_SIZE);
+    // Pattern: EMPTY, DELETED, full(h2 = i), ...
+    uint8_t ctrl[GROUP_SIZE];
+    for (size_t i = 0; i < GROUP_SIZE; i++) {
+        ctrl[i] = i % 3 == 0 ? EMPTY : i % 3 == 1 ? DELETED : static_cast<uint8_t>(i);
+    }
+    Group g = Group::load(ctrl);
+    size_t offsets[GROUP_SIZE];
+
+    size_t n = mask_offsets(g.match_empty(), offsets);
+    for (size_t i = 0; i < n; i++) {
+        assert(offsets[i] % 3 == 0);
+    }
+    assert(n == (GROUP_SIZE + 2) / 3);
+
+    n = mask_offsets(g.match_empty_or_deleted(), offsets);
+    for (size_t i = 0; i < n; i++) {
+        assert(offsets[i] % 3 != 2);
+        assert(i == 0 || offsets[i] > offsets[i - 1]);
+    }
+
+    n = mask_offsets(g.match_byte(5), offsets);
+    assert(n >= 1 && offsets[0] == 5);
+    assert(!g.match_byte(0x7F));
+
+    n = mask_offsets(g.match_full(), offsets);
+    for (size_t i = 0; i < n; i++) {
+        assert(offsets[i] % 3 == 2);
+    }
+    assert(n == GROUP_SIZE / 3);
+    printf("PASS\n");
+}
+
+// Test that iteration, clear, clone and drop skip sparse groups correctly
+void test_hashmap_sparse_iteration() {
+    printf("test_hashmap_sparse_iteration: ");
+    {
+        HashMap<int, int> map;
+        for (int i = 0; i < 5000; i++) {
+            map.insert(i, i * 2);
+        }
+        for (int i = 0; i < 5000; i++) {
+            if (i % 97 != 0) map.remove(i);
+        }
+        size_t visited = 0;
+        long sum = 0;
+        for (auto kv : map) {
+            assert(kv.first % 97 == 0 && kv.second == kv.first * 2);
+            sum += kv.first;
+            visited++;
+        }
+        assert(visited == map.len() && visited == 52);
+        long expected = 0;
+        for (int i = 0; i < 5000; i += 97) expected += i;
+        assert(sum == expected);
+        assert(map.keys().len() == 52 && map.values().len() == 52);
+
+        auto copy = map.clone();
+        assert(copy == map);
+        map.retain([](const int& k, int&) { return k % 2 == 0; });
+        assert(map.len() == 26);
+        assert(copy != map);
+        copy.clear();
+        assert(copy.is_empty() && copy.iter().count() == 0);
+        assert(copy.begin() == copy.end());
+        copy.insert(1, 1);
+        assert(copy.len() == 1);
+
+        // Owning values are dropped from the surviving slots only
+        HashMap<int, Box<int>> boxes;
+        for (int i = 0; i < 2000; i++) boxes.insert(i, Box<int>::make(i));
+        for (int i = 0; i < 2000; i += 2) boxes.remove(i);
+        assert(boxes.iter().count() == 1000);
+        boxes.clear();
+        for (int i = 0; i < 10; i++) boxes.insert(i, Box<int>::make(i));
+    }
+    printf("PASS\n");
+}
+
+template<typename Layout>
+void check_basic_ops() {
+    HashMap<int, Box<int>, std::hash<int>, std::equal_to<int>, Global, Layout> map;
+    for (int i = 0; i < 1000; i++) {
+        map.insert(i, Box<int>::make(i * 3));
+    }
+    assert(map.len() == 1000);
+    for (int i = 0; i < 1000; i++) {
+        assert(*map.get(i).unwrap() == i * 3);
+    }
+    assert(map.get(1000).is_none());
+
+    for (int i = 0; i < 1000; i += 2) {
+        assert(map.remove(i).is_some());
+    }
+    assert(map.len() == 500);
+    assert(!map.contains_key(10));
+    assert(map.contains_key(11));
+
+    size_t count = 0;
+    for (auto kv : map) {
+        assert(kv.first % 2 == 1);
+        assert(*kv.second == kv.first * 3);
+        count++;
+    }
+    assert(count == 500);
+}
+
+void test_hashmap_basic() {
+    printf("test_hashmap_basic: ");
+    check_basic_ops<SeparateSlots>();
+    printf("PASS\n");
+}
+
+void test_hashmap_interleaved() {
+    printf("test_hashmap_interleaved: ");
+    check_basic_ops<InterleavedSlots>();
+
+    // Mixed alignments are padded per slot
+    HashMap<char, double, std::hash<char>, std::equal_to<char>, Global, InterleavedSlots> map;
+    for (char c = 'a'; c <= 'z'; c++) {
+        map.insert(c, c * 0.5);
+    }
+    assert(map.get('q').unwrap() == 'q' * 0.5);
+    printf("PASS\n");
+}
+
+void test_hashmap_single_allocation() {
+    printf("test_hashmap_single_allocation: ");
+    long allocs = 0;
+    {
+        using Map = HashMap<int, int, std::hash<int>, std::equal_to<int>, CountingAlloc>;
+        auto map = Map::new_in(CountingAlloc(&allocs));
+        assert(allocs == 0);
+
+        // Each resize is one new block
+        map.insert(0, 0);
+        assert(allocs == 1 && map.capacity() == MIN_BUCKETS);
+        int growth = static_cast<int>(map.capacity() - map.capacity() / 8);
+        for (int i = 1; i < growth; i++) {
+            map.insert(i, i);
+        }
+        assert(allocs == 1);
+        map.insert(growth, growth);
+        assert(allocs == 2);
+    }
+    printf("PASS\n");
+}
+
+void test_hashmap_empty_does_not_allocate() {
+    printf("test_hashmap_empty_does_not_allocate: ");
+    long allocs = 0;
+    {
+        using Map = HashMap<int, int, std::hash<int>, std::equal_to<int>, CountingAlloc>;
+        auto map = Map::new_in(CountingAlloc(&allocs));
+        Map sized = Map::with_capacity_in(0, CountingAlloc(&allocs));
+        assert(map.capacity() == 0 && sized.capacity() == 0);
+        assert(map.get(1).is_none() && map.remove(1).is_none());
+        assert(map.iter().next().is_none() && map.begin() == map.end());
+        map.clear();
+        map.reserve(0);
+        map.shrink_to_fit();
+        assert(map.stats().buckets == 0);
+        Map cloned = map.clone();
+        assert(allocs == 0);
+
+        // A moved-from map is empty and usable
+        map.insert(1, 10);
+        Map taken(std::move(map));
+        assert(map.is_empty() && map.capacity() == 0);
+        map.insert(2, 20);
+        assert(map.get(2).unwrap() == 20 && taken.get(1).unwrap() == 10);
+        assert(allocs == 2);
+
+        // Emptied and shrunk, the table is freed
+        taken.remove(1);
+        taken.shrink_to_fit();
+        assert(taken.capacity() == 0);
+        taken.entry(3).or_insert(30);
+        assert(taken.get(3).unwrap() == 30);
+    }
+    assert(allocs == 3);
+    printf("PASS\n");
+}
+
+// Few distinct probe starts, so groups fill up and removals leave tombstones
+struct ClusteredHash {
+    size_t operator()(int k) const {
+        return static_cast<size_t>(k % 5) * 3 + (static_cast<size_t>(k) << 57);
+    }
+};
+
+// A clone keeps the table: same buckets, tombstones and probe lengths
+void test_hashmap_clone_layout() {
+    printf("test_hashmap_clone_layout: ");
+    {
+        HashMap<int, int, ClusteredHash> map;
+        for (int i = 0; i < 300; i++) map.insert(i, i);
+        for (int i = 0; i < 300; i += 3) map.remove(i);
+        auto copy = map.clone();
+        stats::HashMapStats a = map.stats(), b = copy.stats();
+        assert(copy.capacity() == map.capacity() && b.tombstones == a.tombstones);
+        assert(b.growth_left == a.growth_left && b.hit_probes.max() == a.hit_probes.max());
+        assert(copy == map);
+        for (int i = 300; i < 400; i++) copy.insert(i, i);
+        assert(copy.len() == 300 && map.len() == 200);
+
+        // Elements that are not trivially copyable are copy-constructed in place
+        HashMap<std::string, std::string> names;
+        for (int i = 0; i < 100; i++) names.insert(std::to_string(i), std::string(40, 'a' + i % 26));
+        auto names_copy = names.clone();
+        names.clear();
+        assert(names_copy.len() == 100 && names_copy.get("27").unwrap() == std::string(40, 'b'));
+        assert((HashMap<int, int>().clone().capacity() == 0));
+
+        // Move-only values are cloned with their clone()
+        HashMap<int, Vec<int>> lists;
+        for (int i = 0; i < 50; i++) lists.insert(i, vec_of({i, i + 1}));
+        auto lists_copy = lists.clone();
+        lists.get_mut(7).unwrap().push(0);
+        assert(lists_copy.len() == 50 && lists_copy.get(7).unwrap().len() == 2);
+        assert(lists_copy.get(49).unwrap()[1] == 50);
+    }
+    printf("PASS\n");
+}
+
+void test_hashmap_tombstone_reuse() {
+    printf("test_hashmap_tombstone_reuse: ");
+    // std::hash<int> is the identity, so keys 0..111 fill consecutive slots
+    // and removing them leaves tombstones inside full groups
+    auto map = HashMap<int, int, std::hash<int>>::with_capacity(128);
+    size_t buckets = map.capacity();
+    int fill = static_cast<int>(buckets - buckets / 8);
+    for (int i = 0; i < fill; i++) {
+        map.insert(i, i);
+    }
+    for (int i = 0; i < fill - 10; i++) {
+        map.remove(i);
+    }
+
+    // Inserts reuse tombstones, then rehash in place instead of growing
+    for (int i = 0; i < fill - 10; i++) {
+        map.insert(1000 + 7 * i, i);
+    }
+    assert(map.len() == static_cast<size_t>(fill));
+    assert(map.capacity() == buckets);
+    for (int i = 0; i < fill - 10; i++) {
+        assert(map.get(1000 + 7 * i).unwrap() == i);
+    }
+    for (int i = fill - 10; i < fill; i++) {
+        assert(map.get(i).unwrap() == i);
+    }
+    printf("PASS\n");
+}
+
+void test_hashmap_churn() {
+    printf("test_hashmap_churn: ");
+    HashMap<int, int, ClusteredHash> map;
+    std::unordered_map<int, int> expected;
+    unsigned seed = 12345;
+    for (int step = 0; step < 200000; step++) {
+        seed = seed * 1103515245 + 12345;
+        int key = static_cast<int>((seed >> 8) % 300);
+        if ((seed >> 4) & 1) {
+            map.insert(key, step);
+            expected[key] = step;
+        } else {
+            bool removed = map.remove(key).is_some();
+            assert(removed == (expected.erase(key) == 1));
+        }
+    }
+    // At most 300 live keys: the table must not keep doubling
+    assert(map.len() == expected.size());
+    assert(map.capacity() <= 1024);
+    for (const auto& kv : expected) {
+        assert(map.get(kv.first).unwrap() == kv.second);
+    }
+    printf("PASS\n");
+}
+
+void test_hashmap_shrink() {
+    printf("test_hashmap_shrink: ");
+    HashMap<int, int> map;
+    for (int i = 0; i < 1000; i++) {
+        map.insert(i, i);
+    }
+    size_t big = map.capacity();
+    map.retain([](const int& k, int&) { return k < 10; });
+    assert(map.len() == 10);
+
+    map.shrink_to(100);
+    assert(map.capacity() < big);
+    assert(map.capacity() - map.capacity() / 8 >= 100);
+
+    map.shrink_to_fit();
+    assert(map.capacity() == MIN_BUCKETS);
+    for (int i = 0; i < 10; i++) {
+        assert(map.get(i).unwrap() == i);
+    }
+
+    map.reserve(500);
+    assert(map.capacity() - map.capacity() / 8 >= 510);
+    assert(map.len() == 10);
+    printf("PASS\n");
+}
+
+// Key type that counts how often it is constructed
+static int name_constructions = 0;
+
+struct Name {
+    std::string text;
+    explicit Name(const char* t) : text(t) { name_constructions++; }
+    bool operator==(const Name& other) const { return text == other.text; }
+};
+
+// Transparent hasher/equality: Name and const char* hash and compare alike
+struct NameHash {
+    using is_transparent = void;
+    size_t operator()(const char* s) const {
+        size_t h = 5381;
+        for (; *s; s++) h = h * 33 + static_cast<unsigned char>(*s);
+        return h;
+    }
+    size_t operator()(const Name& n) const { return (*this)(n.text.c_str()); }
+};
+
+struct NameEq {
+    using is_transparent = void;
+    bool operator()(const Name& a, const Name& b) const { return a == b; }
+    bool operator()(const Name& a, const char* b) const { return a.text == b; }
+};
+
+void test_hashmap_transparent_lookup() {
+    printf("test_hashmap_transparent_lookup: ");
+    HashMap<Name, int, NameHash, NameEq> map;
+    map.insert(Name("alpha"), 1);
+    map.insert(Name("beta"), 2);
+    name_constructions = 0;
+
+    assert(map.get("alpha").unwrap() == 1);
+    assert(map.contains_key("beta"));
+    assert(!map.contains_key("gamma"));
+    map.get_mut("beta").unwrap() += 10;
+    assert(*map.get_key_value("beta").unwrap().second == 12);
+    assert(map.remove("alpha").unwrap() == 1);
+    assert(map.remove_entry("beta").unwrap().second == 12);
+    assert(map.is_empty());
+
+    // No temporary keys were built
+    assert(name_constructions == 0);
+
+    // Lookups by K still work
+    map.insert(Name("delta"), 4);
+    assert(map.get(Name("delta")).unwrap() == 4);
+    printf("PASS\n");
+}
+
+void test_fxhash() {
+    printf("test_fxhash: ");
+    // Small integers get distinct H2 tags and spread over the buckets
+    bool tags[128] = {};
+    bool buckets[128] = {};
+    size_t distinct_tags = 0, distinct_buckets = 0;
+    FxHash<int> hash;
+    for (int i = 0; i < 128; i++) {
+        size_t h = hash(i);
+        uint8_t tag = h2_hash(h);
+        if (!tags[tag]) { tags[tag] = true; distinct_tags++; }
+        if (!buckets[h & 127]) { buckets[h & 127] = true; distinct_buckets++; }
+    }
+    assert(distinct_tags > 64);
+    assert(distinct_buckets > 64);
+
+    // Byte strings: every length and every byte matters
+    const char text[] = "the quick brown fox jumps over the lazy dog";
+    for (size_t len = 0; len < sizeof(text) - 1; len++) {
+        assert(hash_bytes(text, len) != hash_bytes(text, len + 1));
+    }
+    char a[40], b[40];
+    std::memset(a, 'x', sizeof(a));
+    std::memcpy(b, a, sizeof(b));
+    b[21] = 'y';
+    assert(hash_bytes(a, sizeof(a)) != hash_bytes(b, sizeof(b)));
+
+    // Non-integer keys fall back to finalizing std::hash
+    FxHash<std::string> string_hash;
+    assert(string_hash("abc") == string_hash(std::string("abc")));
+    int slots[2] = {0, 0};
+    FxHash<const int*> ptr_hash;
+    assert(ptr_hash(&slots[0]) != ptr_hash(&slots[1]));
+    printf("PASS\n");
+}
+
+void test_hashmap_precomputed_hash() {
+    printf("test_hashmap_precomputed_hash: ");
+    HashMap<int, int> a;
+    HashMap<int, int> b;
+    for (int i = 0; i < 100; i++) {
+        size_t h = a.hash_key(i);
+        a.insert_with_hash(i, i, h);
+        if (i % 2 == 0) b.insert_with_hash(i, -i, h);
+    }
+    // One hash serves lookups in both maps
+    size_t h = a.hash_key(42);
+    assert(h == b.hash_key(42));
+    assert(a.get_with_hash(42, h).unwrap() == 42);
+    assert(b.get_with_hash(42, h).unwrap() == -42);
+    assert(b.get_with_hash(43, b.hash_key(43)).is_none());
+    assert(a.get(99).unwrap() == 99);
+
+    // Inserting an existing key with its hash updates the value
+    a.insert_with_hash(42, 420, h);
+    assert(a.get(42).unwrap() == 420);
+    assert(a.len() == 100);
+    printf("PASS\n");
+}
+
+void test_hashmap_get_many() {
+    printf("test_hashmap_get_many: ");
+    HashMap<int, int> map;
+    for (int i = 0; i < 10000; i += 2) {
+        map.insert(i, i * 10);
+    }
+    int keys[100];
+    Option<const int&> out[100];
+    for (int i = 0; i < 100; i++) {
+        keys[i] = i * 37;
+    }
+    map.get_many(keys, 100, out);
+    for (int i = 0; i < 100; i++) {
+        if (keys[i] % 2 == 0) {
+            assert(out[i].unwrap() == keys[i] * 10);
+        } else {
+            assert(out[i].is_none());
+        }
+    }
+
+    HashMap<int, int> empty;
+    empty.get_many(keys, 3, out);
+    assert(out[0].is_none() && out[2].is_none());
+    printf("PASS\n");
+}
+
+// Value type that counts constructions
+static int widget_constructions = 0;
+
+struct Widget {
+    int uses;
+    Widget() : uses(0) { widget_constructions++; }
+    explicit Widget(int u) : uses(u) { widget_constructions++; }
+};
+
+// Compares Box keys by pointee, with an empty Box as a key of its own
+struct BoxHash {
+    size_t operator()(const Box<int>& b) const { return b ? std::hash<int>()(*b) : 0; }
+};
+struct BoxEq {
+    bool operator()(const Box<int>& a, const Box<int>& b) const {
+        return a && b ? *a == *b : !a && !b;
+    }
+};
+
+void test_hashmap_entry() {
+    printf("test_hashmap_entry: ");
+    HashMap<int, int> counts;
+    int words[] = {3, 1, 3, 3, 2, 1};
+    for (int w : words) {
+        counts.entry(w).or_insert(0) += 1;
+    }
+    assert(counts.get(3).unwrap() == 3);
+    assert(counts.get(1).unwrap() == 2);
+    assert(counts.get(2).unwrap() == 1);
+
+    // and_modify runs only on occupied entries
+    counts.entry(3).and_modify([](int& v) { v *= 10; }).or_insert(100);
+    counts.entry(4).and_modify([](int& v) { v *= 10; }).or_insert(100);
+    assert(counts.get(3).unwrap() == 30);
+    assert(counts.get(4).unwrap() == 100);
+
+    // or_insert_with only builds the value when the key is missing
+    HashMap<int, Widget> widgets;
+    widgets.entry(1).or_insert_with([] { return Widget(5); });
+    widget_constructions = 0;
+    widgets.entry(1).or_insert_with([] { return Widget(6); }).uses++;
+    assert(widget_constructions == 0);
+    assert(widgets.get(1).unwrap().uses == 6);
+    widgets.entry(2).or_default();
+    assert(widgets.get(2).unwrap().uses == 0);
+    assert(widgets.entry(7).or_insert_with_key([](const int& k) { return Widget(k); }).uses == 7);
+
+    // Specific handles
+    auto occupied = counts.entry(1);
+    assert(occupied.is_occupied() && occupied.key() == 1);
+    auto occ = occupied.into_occupied();
+    assert(occ.insert(11) == 2);
+    assert(occ.get() == 11);
+    assert(occ.remove() == 11);
+    assert(!counts.contains_key(1));
+
+    auto vacant = counts.entry(9);
+    assert(vacant.is_vacant() && vacant.key() == 9);
+    vacant.into_vacant().insert(90);
+    assert(counts.get(9).unwrap() == 90);
+
+    // Inserting through entries grows the map like insert()
+    HashMap<int, int> big;
+    for (int i = 0; i < 1000; i++) {
+        big.entry(i).or_insert(i);
+    }
+    assert(big.len() == 1000);
+    assert(big.get(999).unwrap() == 999);
+    assert(big.or_insert(5, -1) == 5);
+
+    // Null and empty keys are ordinary vacant keys
+    HashMap<const char*, int> by_name;
+    assert(by_name.entry(nullptr).is_vacant());
+    assert(by_name.entry(nullptr).or_insert(5) == 5);
+    assert(by_name.entry(nullptr).is_occupied() && by_name.get(nullptr).unwrap() == 5);
+
+    HashMap<Box<int>, int, BoxHash, BoxEq> boxed;
+    assert(boxed.entry(Box<int>()).is_vacant());
+    boxed.entry(Box<int>()).or_insert(1) += 1;
+    assert(boxed.entry(Box<int>()).or_insert(0) == 2 && boxed.len() == 1);
+    printf("PASS\n");
+}
+
+// A stored null pointer is a value: remove() hands it back as Some
+void test_hashmap_null_value() {
+    printf("test_hashmap_null_value: ");
+    HashMap<int, const char*> names;
+    names.insert(1, nullptr);
+    assert(names.get(1).is_some());
+    auto removed = names.remove(1);
+    assert(removed.is_some() && removed.unwrap() == nullptr);
+    assert(names.remove(1).is_none() && names.is_empty());
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::HashMap ===\n");
+
+    test_group_match();
+    test_hashmap_basic();
+    test_hashmap_interleaved();
+    test_hashmap_single_allocation();
+    test_hashmap_empty_does_not_allocate();
+    test_hashmap_clone_layout();
+    test_hashmap_tombstone_reuse();
+    test_hashmap_churn();
+    test_hashmap_sparse_iteration();
+    test_hashmap_shrink();
+    test_hashmap_transparent_lookup();
+    test_fxhash();
+    test_hashmap_precomputed_hash();
+    test_hashmap_get_many();
+    test_hashmap_entry();
+    test_hashmap_null_value();
+
+    printf("\nAll HashMap tests passed!\n");
+    return 0;
+}
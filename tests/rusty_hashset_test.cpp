@@ -0,0 +1,148 @@
+// Tests for rusty::HashSet set operations
+#include "../include/rusty/hashset.hpp"
+#include <cassert>
+#include <cstdio>
+
+using namespace rusty;
+
+static HashSet<int> range_set(int start, int end, int step = 1) {
+    HashSet<int> set;
+    for (int i = start; i < end; i += step) set.insert(i);
+    return set;
+}
+
+// Test the eager set operations and their operator forms
+void test_hashset_set_ops() {
+    printf("test_hashset_set_ops: ");
+    {
+        HashSet<int> a = range_set(0, 1000);      // 0..999
+        HashSet<int> b = range_set(500, 2000);    // 500..1999
+
+        HashSet<int> u = a.union_with(b);
+        assert(u.len() == 2000);
+        assert(u == range_set(0, 2000));
+
+        HashSet<int> i = a.intersection(b);
+        assert(i.len() == 500 && i == range_set(500, 1000));
+        // Sized for the smaller input, so no rehash happened on the way
+        assert(i.capacity() >= a.len());
+
+        HashSet<int> d = a.difference(b);
+        assert(d == range_set(0, 500));
+        assert(b.difference(a) == range_set(1000, 2000));
+
+        HashSet<int> s = a.symmetric_difference(b);
+        assert(s.len() == 1500);
+        assert(s.contains(0) && s.contains(1999) && !s.contains(700));
+
+        assert((a | b) == u && (a & b) == i && (a - b) == d && (a ^ b) == s);
+
+        HashSet<int> empty;
+        assert(a.intersection(empty).is_empty());
+        assert(a.union_with(empty) == a);
+        assert(empty.difference(a).is_empty());
+    }
+    printf("PASS\n");
+}
+
+// Test the in-place operators
+void test_hashset_in_place_ops() {
+    printf("test_hashset_in_place_ops: ");
+    {
+        HashSet<int> a = range_set(0, 100);
+        a |= range_set(50, 150);
+        assert(a == range_set(0, 150));
+
+        a &= range_set(0, 300, 2);
+        assert(a == range_set(0, 150, 2));
+
+        // A small right side is removed key by key, a large one filters self
+        a -= range_set(0, 10);
+        assert(a == range_set(10, 150, 2));
+        a -= range_set(0, 10000, 4);
+        assert(a == range_set(10, 150, 4));
+
+        HashSet<int> x = range_set(0, 10);
+        x ^= range_set(5, 15);
+        HashSet<int> expected = range_set(0, 5);
+        expected |= range_set(10, 15);
+        assert(x == expected);
+
+        HashSet<int> into_empty;
+        into_empty |= range_set(0, 64);
+        assert(into_empty.len() == 64);
+    }
+    printf("PASS\n");
+}
+
+// Test the lazy set-operation iterators
+void test_hashset_lazy_ops() {
+    printf("test_hashset_lazy_ops: ");
+    {
+        HashSet<int> a = range_set(0, 1000);
+        HashSet<int> b = range_set(0, 3000, 3);
+
+        assert(a.intersection_iter(b).count() == a.intersection(b).len());
+        assert(b.intersection_iter(a).count() == 334);
+        assert(a.difference_iter(b).count() == 666);
+        assert(a.union_iter(b).count() == a.union_with(b).len());
+        assert(a.symmetric_difference_iter(b).count() == a.symmetric_difference(b).len());
+
+        long sum = a.intersection_iter(b).fold(0L, [](long acc, const int& x) { return acc + x; });
+        long expected = 0;
+        for (int i = 0; i < 1000; i += 3) expected += i;
+        assert(sum == expected);
+
+        for (const int& x : a.difference_iter(b)) assert(x % 3 != 0 && x < 1000);
+        assert(a.intersection_iter(b).all([](const int& x) { return x % 3 == 0; }));
+
+        Vec<int> only_b = b.difference_iter(a).collect();
+        assert(only_b.len() == 1000 - 334);
+        only_b.sort_unstable();
+        assert(only_b[0] == 1002);
+
+        HashSet<int> collected = a.union_iter(b).collect<HashSet<int>>();
+        assert(collected == a.union_with(b));
+    }
+    printf("PASS\n");
+}
+
+// Test insert, get and take on owning elements
+void test_hashset_insert_get() {
+    printf("test_hashset_insert_get: ");
+    {
+        HashSet<int> set;
+        assert(set.insert(7));
+        assert(!set.insert(7));
+        assert(set.len() == 1);
+        assert(set.get(7).unwrap() == 7);
+        assert(set.get(8).is_none());
+        assert(set.take(7).unwrap() == 7);
+        assert(set.is_empty());
+
+        HashSet<int> big = HashSet<int>::with_capacity(10000);
+        size_t cap = big.capacity();
+        for (int i = 0; i < 10000; i++) assert(big.insert(i));
+        assert(big.capacity() == cap);
+        for (int i = 0; i < 10000; i++) assert(big.get(i).unwrap() == i);
+        big.retain([](const int& x) { return x < 10; });
+        big.shrink_to_fit();
+        assert(big.len() == 10 && big.capacity() < cap);
+
+        HashSet<int> from = hashset_from_vec(Vec<int>({3, 1, 3, 2}));
+        assert(from.len() == 3);
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::HashSet ===\n");
+
+    test_hashset_set_ops();
+    test_hashset_in_place_ops();
+    test_hashset_lazy_ops();
+    test_hashset_insert_get();
+
+    printf("\nAll HashSet tests passed!\n");
+    return 0;
+}
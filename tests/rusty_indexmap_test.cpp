@@ -0,0 +1,168 @@
+// Tests for rusty::IndexMap
+#include "../include/rusty/indexmap.hpp"
+#include "../include/rusty/box.hpp"
+#include "../include/rusty/string.hpp"
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace rusty;
+
+// Test insertion order, positional access and updates in place
+void test_indexmap_order() {
+    printf("test_indexmap_order: ");
+    {
+        IndexMap<int, int> map;
+        assert(map.is_empty() && map.capacity() == 0);
+        for (int i = 0; i < 1000; i++) assert(map.insert((i * 37) % 1000, i).is_none());
+        assert(map.len() == 1000);
+
+        size_t pos = 0;
+        for (const auto& kv : map) {
+            assert(kv.first == int((pos * 37) % 1000) && kv.second == int(pos));
+            pos++;
+        }
+
+        // Updating keeps the position
+        std::pair<size_t, Option<int>> full = map.insert_full(37, -1);
+        assert(full.first == 1 && full.second.unwrap() == 1);
+        assert(map.get_index(1).unwrap().first[0] == 37 && *map.get_index(1).unwrap().second == -1);
+        assert(map.get_index_of(74).unwrap() == 2 && map.get_index_of(5000).is_none());
+        assert(map.get_index(1000).is_none());
+        *map.get_index_mut(0).unwrap().second = 42;
+        assert(map.get(0).unwrap() == 42);
+        assert(*map.first().unwrap().first == 0 && *map.last().unwrap().first == (999 * 37) % 1000);
+
+        map.or_insert(5000, 1) += 1;
+        assert(map.get(5000).unwrap() == 2 && *map.last().unwrap().first == 5000);
+        assert(map.get_or_insert_with(5000, [] { return 0; }) == 2);
+
+        Slice<std::pair<int, int>> all = map.as_slice();
+        assert(all.len() == 1001 && all[1000].first == 5000);
+        assert(map.iter().count() == 1001);
+    }
+    printf("PASS\n");
+}
+
+// Test swap_remove, shift_remove and pop against a model
+void test_indexmap_remove() {
+    printf("test_indexmap_remove: ");
+    {
+        srand(99);
+        IndexMap<int, int> map = IndexMap<int, int>::with_capacity(16);
+        std::vector<std::pair<int, int>> model;
+        for (int step = 0; step < 20000; step++) {
+            int k = rand() % 300;
+            int op = rand() % 6;
+            size_t at = model.size();
+            for (size_t i = 0; i < model.size(); i++) {
+                if (model[i].first == k) at = i;
+            }
+            if (op < 3) {
+                Option<int> old = map.insert(k, step);
+                assert(old.is_some() == (at != model.size()));
+                if (at == model.size()) model.push_back(std::make_pair(k, step));
+                else model[at].second = step;
+            } else if (op == 3) {
+                Option<int> removed = map.swap_remove(k);
+                assert(removed.is_some() == (at != model.size()));
+                if (at != model.size()) {
+                    assert(removed.unwrap() == model[at].second);
+                    model[at] = model.back();
+                    model.pop_back();
+                }
+            } else if (op == 4) {
+                Option<int> removed = map.shift_remove(k);
+                assert(removed.is_some() == (at != model.size()));
+                if (at != model.size()) model.erase(model.begin() + at);
+            } else if (!model.empty()) {
+                size_t index = rand() % model.size();
+                if (rand() % 2) {
+                    assert(map.swap_remove_index(index).unwrap().first == model[index].first);
+                    model[index] = model.back();
+                    model.pop_back();
+                } else {
+                    assert(map.shift_remove_index(index).unwrap().first == model[index].first);
+                    model.erase(model.begin() + index);
+                }
+            }
+            assert(map.len() == model.size());
+            if (step % 100 == 0) {
+                for (size_t i = 0; i < model.size(); i++) {
+                    assert(map.as_slice()[i] == model[i]);
+                    assert(map.get_index_of(model[i].first).unwrap() == i);
+                }
+            }
+        }
+        while (!model.empty()) {
+            assert(map.pop().unwrap() == model.back());
+            model.pop_back();
+        }
+        assert(map.is_empty() && map.pop().is_none());
+    }
+    printf("PASS\n");
+}
+
+// Test retain, sorting, clone and equality
+void test_indexmap_bulk() {
+    printf("test_indexmap_bulk: ");
+    {
+        IndexMap<int, int> map = {{5, 50}, {3, 30}, {9, 90}, {1, 10}};
+        IndexMap<int, int> copy = map.clone();
+        assert(copy == map);
+
+        map.sort_keys();
+        assert(map.as_slice()[0].first == 1 && map.as_slice()[3].first == 9);
+        assert(map.get(9).unwrap() == 90 && map.get_index_of(5).unwrap() == 2);
+        assert(copy == map);  // order does not matter for ==
+
+        map.sort_by([](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+            return a.second > b.second;
+        });
+        assert(map.as_slice()[0].first == 9 && map.get_index_of(1).unwrap() == 3);
+
+        IndexMap<int, int> big;
+        for (int i = 0; i < 10000; i++) big.insert(i, i);
+        big.retain([](const int& k, int& v) { v++; return k % 3 == 0; });
+        assert(big.len() == 3334);
+        for (size_t i = 0; i < big.len(); i++) {
+            assert(big.as_slice()[i].first == int(i * 3));
+            assert(big.get(int(i * 3)).unwrap() == int(i * 3 + 1));
+        }
+        assert(!big.contains_key(1));
+        big.insert(1, 1);
+        assert(big.get_index_of(1).unwrap() == 3334);
+
+        Vec<std::pair<int, int>> entries = std::move(copy).into_entries();
+        assert(entries.len() == 4 && entries[0].first == 5);
+
+        IndexMap<String, Box<int>> owned;
+        owned.insert(String::from("b"), Box<int>::make(2));
+        owned.insert(String::from("a"), Box<int>::make(1));
+        owned.sort_keys();
+        assert(*owned.get(String::from("b")).unwrap() == 2);
+        assert(owned.shift_remove(String::from("a")).is_some());
+        auto it = std::move(owned).into_iter();
+        assert(*it.next().unwrap().second == 2);
+
+        big.clear();
+        assert(big.is_empty() && big.get(3).is_none());
+        big.insert(3, 3);
+        assert(big.get(3).unwrap() == 3);
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::IndexMap ===\n");
+
+    test_indexmap_order();
+    test_indexmap_remove();
+    test_indexmap_bulk();
+
+    printf("\nAll IndexMap tests passed!\n");
+    return 0;
+}
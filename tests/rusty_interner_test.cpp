@@ -0,0 +1,126 @@
+// Tests for rusty::Interner and rusty::SyncInterner
+#include "../include/rusty/interner.hpp"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace rusty;
+
+void test_interner_basic() {
+    printf("test_interner_basic: ");
+    {
+        static_assert(sizeof(Symbol) == 4, "Symbol is a 4-byte handle");
+
+        auto interner = Interner::new_();
+        assert(interner.is_empty());
+
+        Symbol a = interner.intern("alpha");
+        Symbol b = interner.intern(String::from("beta"));
+        Symbol a2 = interner.intern(std::string_view("alpha"));
+        assert(a == a2 && a != b);
+        assert(a.as_u32() == 0 && b.as_u32() == 1);
+        assert(interner.len() == 2);
+
+        assert(interner.resolve(a) == "alpha");
+        assert(std::strcmp(interner.resolve(b).as_ptr(), "beta") == 0);
+        assert(interner.get("beta").unwrap() == b);
+        assert(interner.get("gamma").is_none());
+        assert(interner.len() == 2);
+
+        // Empty strings and embedded NULs are ordinary keys
+        Symbol empty = interner.intern("");
+        Symbol nul = interner.intern(str("a\0b", 3));
+        assert(interner.resolve(empty).len() == 0);
+        assert(interner.resolve(nul).len() == 3);
+        assert(interner.intern(str("a\0b", 3)) == nul);
+        assert(interner.bytes_used() == 6 + 5 + 1 + 4);
+
+        bool threw = false;
+        try {
+            interner.resolve(Symbol(100));
+        } catch (const std::out_of_range&) {
+            threw = true;
+        }
+        assert(threw);
+
+        // Symbols key maps with integer hashing
+        HashMap<Symbol, int> counts;
+        counts.insert(a, 1);
+        counts.insert(b, 2);
+        assert(counts.get(a2).unwrap() == 1);
+
+        // Moving keeps the interned text in place
+        str before = interner.resolve(a);
+        Interner moved = std::move(interner);
+        assert(moved.resolve(a).as_ptr() == before.as_ptr());
+        assert(moved.len() == 4 && interner.len() == 0);
+    }
+    printf("PASS\n");
+}
+
+void test_interner_many() {
+    printf("test_interner_many: ");
+    {
+        auto interner = Interner::with_capacity(16);
+        std::vector<Symbol> syms;
+        for (int i = 0; i < 20000; i++) {
+            syms.push_back(interner.intern(std::to_string(i)));
+        }
+        assert(interner.len() == 20000);
+        for (int i = 0; i < 20000; i += 7) {
+            std::string text = std::to_string(i);
+            assert(interner.resolve(syms[i]) == str(text));
+            assert(interner.intern(text) == syms[i]);
+        }
+    }
+    printf("PASS\n");
+}
+
+void test_sync_interner() {
+    printf("test_sync_interner: ");
+    {
+        const int THREADS = 8;
+        const int WORDS = 2000;
+        SyncInterner interner;
+        std::vector<std::vector<Symbol>> seen(THREADS);
+
+        // Every thread interns the same words, resolving as it goes
+        std::vector<std::thread> workers;
+        for (int t = 0; t < THREADS; t++) {
+            workers.emplace_back([&interner, &seen, t]() {
+                for (int i = 0; i < WORDS; i++) {
+                    int word = (i * 7 + t * 13) % WORDS;
+                    std::string text = "w" + std::to_string(word);
+                    Symbol sym = interner.intern(text);
+                    assert(interner.resolve(sym) == str(text));
+                    seen[t].push_back(sym);
+                }
+            });
+        }
+        for (auto& w : workers) w.join();
+
+        assert(interner.len() == size_t(WORDS));
+        for (int t = 0; t < THREADS; t++) {
+            for (int i = 0; i < WORDS; i++) {
+                int word = (i * 7 + t * 13) % WORDS;
+                std::string text = "w" + std::to_string(word);
+                assert(interner.get(text).unwrap() == seen[t][i]);
+            }
+        }
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::Interner ===\n");
+
+    test_interner_basic();
+    test_interner_many();
+    test_sync_interner();
+
+    printf("\nAll Interner tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,207 @@
+// Tests for rusty::io
+#include "../include/rusty/io.hpp"
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sys/socket.h>
+
+using namespace rusty;
+
+static Slice<uint8_t> bytes_of(const char* s) {
+    return Slice<uint8_t>(reinterpret_cast<const uint8_t*>(s), std::strlen(s));
+}
+
+// A writer that takes at most three bytes per call, without vectored writes
+struct TrickleWriter {
+    Vec<uint8_t> bytes;
+    size_t calls = 0;
+
+    Result<size_t, io::Error> write(Slice<uint8_t> buf) {
+        calls++;
+        size_t n = buf.len() < 3 ? buf.len() : 3;
+        bytes.extend_from_slice(buf.as_ptr(), n);
+        return Result<size_t, io::Error>::Ok(n);
+    }
+
+    Result<void, io::Error> flush() { return Result<void, io::Error>::Ok(); }
+};
+
+// Test read_line and read_until across buffer refills
+void test_io_buf_reader() {
+    printf("test_io_buf_reader: ");
+    {
+        std::string text;
+        for (int i = 0; i < 200; i++) text += "line " + std::to_string(i) + " \xc3\xa9\n";
+        text += "no newline at the end";
+        Slice<uint8_t> input(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+
+        for (size_t cap : {size_t(1), size_t(7), size_t(64), io::DEFAULT_BUF_SIZE}) {
+            io::BufReader<io::SliceReader> reader(cap, io::SliceReader(input));
+            String line;
+            for (int i = 0; i < 200; i++) {
+                line.clear();
+                size_t n = reader.read_line(line).unwrap();
+                std::string expected = "line " + std::to_string(i) + " \xc3\xa9\n";
+                assert(n == expected.size() && line.as_str() == expected);
+            }
+            line.clear();
+            assert(reader.read_line(line).unwrap() == 21 && line == "no newline at the end");
+            assert(reader.read_line(line).unwrap() == 0 && line.len() == 21);
+        }
+
+        io::BufReader<io::SliceReader> fields(5, io::SliceReader(bytes_of("a,bb,,cccccccc")));
+        Vec<uint8_t> field;
+        assert(fields.read_until(',', field).unwrap() == 2 && field.len() == 2 && field[1] == ',');
+        assert(fields.read_until(',', field).unwrap() == 3 && field.len() == 5);
+        assert(fields.read_until(',', field).unwrap() == 1);
+        assert(fields.read_until(',', field).unwrap() == 8 && fields.read_until(',', field).unwrap() == 0);
+
+        // fill_buf/consume see the buffer without copying
+        io::BufReader<io::SliceReader> raw(4, io::SliceReader(bytes_of("abcdefg")));
+        assert(raw.buffer().is_empty());
+        Slice<uint8_t> seen = raw.fill_buf().unwrap();
+        assert(seen.len() == 4 && seen[0] == 'a');
+        raw.consume(3);
+        assert(raw.buffer().len() == 1 && raw.fill_buf().unwrap()[0] == 'd');
+        uint8_t out[16];
+        assert(raw.read(SliceMut<uint8_t>(out, 16)).unwrap() == 1);
+        assert(raw.read(SliceMut<uint8_t>(out, 16)).unwrap() == 3 && out[0] == 'e');  // bypasses the buffer
+        assert(raw.read(SliceMut<uint8_t>(out, 16)).unwrap() == 0);
+
+        // Invalid UTF-8 fails and leaves the line alone
+        io::BufReader<io::SliceReader> bad(io::SliceReader(bytes_of("ok\n\xff\xfe\nafter\n")));
+        String line;
+        bad.read_line(line).unwrap();
+        assert(bad.read_line(line).unwrap_err() == io::Error{EILSEQ} && line == "ok\n");
+        assert(bad.read_line(line).unwrap() == 6 && line == "ok\nafter\n");
+    }
+    printf("PASS\n");
+}
+
+// Test buffering, partial writes and vectored writes
+void test_io_buf_writer() {
+    printf("test_io_buf_writer: ");
+    {
+        io::BufWriter<io::VecWriter> w(8, io::VecWriter());
+        assert(w.write_all(bytes_of("abc")).is_ok() && w.buffer().len() == 3 && w.get_ref().get_ref().is_empty());
+        assert(w.write_str("defgh").is_ok() && w.buffer().len() == 8);
+        assert(w.write(bytes_of("i")).unwrap() == 1 && w.get_ref().get_ref().len() == 8);
+        assert(w.write(bytes_of("a long write skips the buffer")).unwrap() == 29);
+        assert(w.get_ref().get_ref().len() == 38 && w.buffer().is_empty());
+
+        io::IoSlice parts[3] = {io::IoSlice(bytes_of("x")), io::IoSlice(bytes_of("")), io::IoSlice(bytes_of("yz"))};
+        assert(w.write_vectored(Slice<io::IoSlice>(parts, 3)).unwrap() == 3 && w.buffer().len() == 3);
+        io::IoSlice big[2] = {io::IoSlice(bytes_of("0123456789")), io::IoSlice(bytes_of("!"))};
+        assert(w.write_vectored(Slice<io::IoSlice>(big, 2)).unwrap() == 11 && w.buffer().is_empty());
+        Vec<uint8_t> all = std::move(w).into_inner().unwrap().into_inner();
+        std::string got(reinterpret_cast<const char*>(all.as_ptr()), all.len());
+        assert(got == "abcdefghia long write skips the bufferxyz0123456789!");
+
+        // Partial writes are retried; non-vectored writers get one piece at a time
+        {
+            io::BufWriter<TrickleWriter> t(4, TrickleWriter());
+            assert(t.write_all(bytes_of("hello world")).is_ok());
+            io::IoSlice pieces[2] = {io::IoSlice(bytes_of("ab")), io::IoSlice(bytes_of("cdefg"))};
+            assert(t.write_vectored(Slice<io::IoSlice>(pieces, 2)).unwrap() == 7);
+            assert(t.flush().is_ok());
+            const Vec<uint8_t>& b = t.get_ref().bytes;
+            assert(std::string(reinterpret_cast<const char*>(b.as_ptr()), b.len()) == "hello worldabcdefg");
+        }
+
+        TrickleWriter direct;
+        io::IoSlice pieces[3] = {io::IoSlice(bytes_of("12345")), io::IoSlice(bytes_of("")), io::IoSlice(bytes_of("6789"))};
+        assert(io::write_all_vectored(direct, SliceMut<io::IoSlice>(pieces, 3)).is_ok());
+        assert(direct.bytes.len() == 9 && direct.bytes[8] == '9' && direct.calls == 4);
+    }
+    printf("PASS\n");
+}
+
+// Test files, sockets, readv/writev and MappedFile
+void test_io_file() {
+    printf("test_io_file: ");
+    {
+        const char* path = "rusty_io_test.txt";
+        {
+            io::BufWriter<io::File> out(io::File::create(path).unwrap());
+            for (int i = 0; i < 10000; i++) {
+                std::string s = std::to_string(i) + "\n";
+                assert(out.write_all(Slice<uint8_t>(reinterpret_cast<const uint8_t*>(s.data()), s.size())).is_ok());
+            }
+        }  // flushed on destruction
+        {
+            io::File appended = io::File::append(path).unwrap();
+            assert(io::write_all(appended, bytes_of("tail\n")).is_ok());
+            assert(appended.sync_all().is_ok());
+        }
+
+        io::BufReader<io::File> in(io::File::open(path).unwrap());
+        String line;
+        size_t lines = 0;
+        while (in.read_line(line).unwrap() != 0) {
+            if (lines < 10000) assert(line.as_str() == std::to_string(lines) + "\n");
+            lines++;
+            if (lines == 10001) assert(line == "tail\n");
+            line.clear();
+        }
+        assert(lines == 10001);
+
+        io::File again = io::File::open(path).unwrap();
+        Vec<uint8_t> everything;
+        size_t size = io::read_to_end(again, everything).unwrap();
+        assert(size == again.size().unwrap() && everything.len() == size);
+
+        io::MappedFile mapped = io::MappedFile::open(path).unwrap();
+        assert(mapped.len() == size && std::memcmp(mapped.as_ptr(), everything.as_ptr(), size) == 0);
+        io::BufReader<io::SliceReader> from_map(io::SliceReader(mapped.as_slice()));
+        line.clear();
+        from_map.read_line(line).unwrap();
+        assert(line == "0\n");
+
+        // Past the point where read_to_end stops growing its chunk size
+        {
+            io::BufWriter<io::File> big(io::File::create(path).unwrap());
+            for (int i = 0; i < 200000; i++) assert(big.write_str("0123456789\n").is_ok());
+        }
+        io::File big_in = io::File::open(path).unwrap();
+        Vec<uint8_t> large;
+        assert(io::read_to_end(big_in, large).unwrap() == 2200000 && large.len() == 2200000);
+
+        std::remove(path);
+        assert(io::File::open(path).unwrap_err() == io::Error{ENOENT});
+
+        // Sockets: writev on one end, readv on the other
+        int fds[2];
+        assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+        io::File a = io::File::from_raw_fd(fds[0]);
+        io::File b = io::File::from_raw_fd(fds[1]);
+        io::IoSlice header_body[2] = {io::IoSlice(bytes_of("HEAD")), io::IoSlice(bytes_of("body!"))};
+        assert(io::write_all_vectored(a, SliceMut<io::IoSlice>(header_body, 2)).is_ok());
+        uint8_t head[4], body[5];
+        io::IoSliceMut into[2] = {io::IoSliceMut(SliceMut<uint8_t>(head, 4)), io::IoSliceMut(SliceMut<uint8_t>(body, 5))};
+        assert(b.read_vectored(SliceMut<io::IoSliceMut>(into, 2)).unwrap() == 9);
+        assert(std::memcmp(head, "HEAD", 4) == 0 && std::memcmp(body, "body!", 5) == 0);
+        assert(into[1].as_mut_slice()[0] == 'b');
+
+        int raw = std::move(a).into_raw_fd();
+        assert(raw == fds[0]);
+        io::File::from_raw_fd(raw);  // closed again here
+        uint8_t tmp[4];
+        assert(b.read(SliceMut<uint8_t>(tmp, 4)).unwrap() == 0);  // peer closed
+
+        assert(io::stdout_().as_raw_fd() == 1 && io::stdin_().as_raw_fd() == 0);
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::io ===\n");
+
+    test_io_buf_reader();
+    test_io_buf_writer();
+    test_io_file();
+
+    printf("\nAll io tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,151 @@
+// Tests for rusty::Iterator adaptors
+#include "../include/rusty/vec.hpp"
+#include "../include/rusty/hashmap.hpp"
+#include "../include/rusty/box.hpp"
+#include <cassert>
+#include <cstdio>
+#include <utility>
+
+using namespace rusty;
+
+// Test map, filter and collect over Vec::iter()
+void test_iter_map_filter_collect() {
+    printf("test_iter_map_filter_collect: ");
+    {
+        Vec<int> v = {1, 2, 3, 4, 5, 6};
+        Vec<int> squares = v.iter()
+                               .filter([](const int& x) { return x % 2 == 0; })
+                               .map([](const int& x) { return x * x; })
+                               .collect();
+        assert(squares.len() == 3);
+        assert(squares[0] == 4 && squares[1] == 16 && squares[2] == 36);
+
+        // Exact size hints reserve once
+        Vec<long> widened = v.iter().map([](const int& x) { return long(x); }).collect();
+        assert(widened.len() == 6 && widened.capacity() == 6);
+
+        assert(v.iter().fold(0, [](int acc, const int& x) { return acc + x; }) == 21);
+        assert(v.iter().sum() == 21);
+        assert(v.iter().count() == 6);
+        assert(v.iter().any([](const int& x) { return x > 5; }));
+        assert(!v.iter().all([](const int& x) { return x > 1; }));
+        assert(v.iter().find([](const int& x) { return x > 3; }).unwrap() == 4);
+        assert(v.iter().find([](const int& x) { return x > 9; }).is_none());
+
+        auto it = v.iter();
+        assert(it.next().unwrap() == 1);
+        assert(it.next_back().unwrap() == 6);
+        assert(it.len() == 4);
+    }
+    printf("PASS\n");
+}
+
+// Test enumerate, zip, take, skip and chain
+void test_iter_combinators() {
+    printf("test_iter_combinators: ");
+    {
+        Vec<int> a = {10, 20, 30, 40};
+        Vec<int> b = {1, 2, 3};
+
+        size_t expected_index = 0;
+        for (auto& item : a.iter().enumerate()) {
+            assert(item.first == expected_index);
+            assert(item.second == a[expected_index]);
+            expected_index++;
+        }
+        assert(expected_index == 4);
+
+        Vec<int> sums = a.iter()
+                            .zip(b.iter())
+                            .map([](std::pair<const int&, const int&> p) {
+                                return p.first + p.second;
+                            })
+                            .collect();
+        assert(sums.len() == 3 && sums[0] == 11 && sums[2] == 33);
+
+        Vec<int> middle = a.iter().skip(1).take(2).collect();
+        assert(middle.len() == 2 && middle[0] == 20 && middle[1] == 30);
+        assert(a.iter().skip(10).count() == 0);
+        assert(a.iter().take(0).count() == 0);
+
+        Vec<int> both = a.iter().chain(b.iter()).collect();
+        assert(both.len() == 7 && both[3] == 40 && both[4] == 1);
+        assert(a.iter().chain(b.iter()).size_hint() == 7);
+    }
+    printf("PASS\n");
+}
+
+// Test iter_mut and into_iter
+void test_iter_mut_and_into_iter() {
+    printf("test_iter_mut_and_into_iter: ");
+    {
+        Vec<int> v = {1, 2, 3};
+        v.iter_mut().for_each([](int& x) { x *= 10; });
+        assert(v[0] == 10 && v[2] == 30);
+        for (int& x : v.as_mut_slice().iter_mut()) x += 1;
+        assert(v[0] == 11 && v[2] == 31);
+
+        Vec<Box<int>> boxes;
+        for (int i = 0; i < 5; i++) boxes.push(Box<int>::make(i));
+        Vec<Box<int>> odd = std::move(boxes)
+                                .into_iter()
+                                .filter([](const Box<int>& b) { return *b % 2 == 1; })
+                                .collect();
+        assert(boxes.is_empty());
+        assert(odd.len() == 2 && *odd[0] == 1 && *odd[1] == 3);
+
+        // Elements not reached are dropped with the iterator
+        auto it = std::move(odd).into_iter();
+        Box<int> first = it.next().unwrap();
+        assert(*first == 1 && it.len() == 1);
+
+        int total = 0;
+        Vec<int> w = {4, 5};
+        for (int& x : std::move(w).into_iter()) total += x;
+        assert(total == 9);
+    }
+    printf("PASS\n");
+}
+
+// Test lazy HashMap iterators and collecting into a map
+void test_iter_hashmap() {
+    printf("test_iter_hashmap: ");
+    {
+        HashMap<int, int> map;
+        for (int i = 0; i < 100; i++) map.insert(i, i * 2);
+        for (int i = 0; i < 100; i += 3) map.remove(i);
+
+        assert(map.iter().count() == map.len());
+        assert(map.keys_iter().fold(0, [](int acc, const int& k) { return acc + k; }) ==
+               map.keys().iter().sum());
+        assert(map.values_iter().all([](const int& v) { return v % 2 == 0; }));
+
+        map.values_iter_mut().for_each([](int& v) { v = -v; });
+        map.iter_mut().for_each([](std::pair<const int&, int&> kv) { kv.second -= kv.first; });
+        assert(map.get(1).unwrap() == -3);
+
+        HashMap<int, int> doubled = map.iter()
+                                        .map([](std::pair<const int&, const int&> kv) {
+                                            return std::make_pair(kv.first, kv.second * 2);
+                                        })
+                                        .collect<HashMap<int, int>>();
+        assert(doubled.len() == map.len());
+        assert(doubled.get(1).unwrap() == -6);
+
+        HashMap<int, int> empty;
+        assert(empty.iter().count() == 0);
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::Iterator ===\n");
+
+    test_iter_map_filter_collect();
+    test_iter_combinators();
+    test_iter_mut_and_into_iter();
+    test_iter_hashmap();
+
+    printf("\nAll iterator tests passed!\n");
+    return 0;
+}
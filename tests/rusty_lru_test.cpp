@@ -0,0 +1,212 @@
+// Tests for rusty::LruCache, rusty::ClockCache and rusty::ShardedCache
+#include "../include/rusty/lru.hpp"
+#include "../include/rusty/concurrent_cache.hpp"
+#include "../include/rusty/box.hpp"
+#include "../include/rusty/string.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace rusty;
+
+// Test recency order, eviction and the non-promoting lookups
+void test_lru_basic() {
+    printf("test_lru_basic: ");
+    {
+        LruCache<int, int> cache = LruCache<int, int>::new_(3);
+        assert(cache.is_empty() && cache.cap() == 3);
+        assert(cache.put(1, 10).is_none());
+        assert(cache.put(2, 20).is_none());
+        assert(cache.put(3, 30).is_none());
+        assert(cache.get(1).unwrap() == 10);  // order now 1 3 2
+
+        Option<std::pair<int, int>> evicted = cache.push(4, 40);
+        assert(evicted.is_some() && evicted.unwrap().first == 2);
+        assert(!cache.contains(2) && cache.len() == 3);
+
+        assert(cache.peek(3).unwrap() == 30);  // does not promote 3
+        cache.put(5, 50);
+        assert(!cache.contains(3));
+
+        assert(cache.put(1, 11).unwrap() == 10);
+        std::pair<int, int> replaced = cache.push(1, 12).unwrap();
+        assert(replaced.first == 1 && replaced.second == 11);
+
+        assert(*cache.peek_lru().unwrap().first == 4);
+        assert(cache.promote(4) && !cache.promote(99));
+        assert(*cache.peek_lru().unwrap().first == 5);
+
+        std::vector<int> order;
+        cache.for_each([&](const int& k, const int&) { order.push_back(k); });
+        assert(order.size() == 3 && order[0] == 4 && order[1] == 1 && order[2] == 5);
+
+        assert(cache.pop_lru().unwrap().first == 5);
+        assert(cache.remove(1).unwrap() == 12 && cache.remove(1).is_none());
+        assert(cache.len() == 1);
+
+        int& v = cache.get_or_insert_with(7, [] { return 70; });
+        v++;
+        assert(cache.get(7).unwrap() == 71);
+        cache.get_or_insert_with(7, []() -> int { assert(false); return 0; });
+
+        LruCache<int, int> none;
+        assert(none.push(1, 1).unwrap().second == 1 && none.is_empty());
+    }
+    printf("PASS\n");
+}
+
+// Test random operations against a std::list + std::unordered_map model,
+// with non-copyable keys and values
+void test_lru_model() {
+    printf("test_lru_model: ");
+    {
+        srand(2024);
+        LruCache<String, Box<int>> cache = LruCache<String, Box<int>>::new_(64);
+        std::list<std::pair<int, int>> model;  // front = most recent
+        std::unordered_map<int, std::list<std::pair<int, int>>::iterator> where;
+
+        for (int step = 0; step < 50000; step++) {
+            int k = rand() % 200;
+            String key = String::from(std::to_string(k).c_str());
+            int op = rand() % 8;
+            auto it = where.find(k);
+            if (op < 3) {
+                Option<Box<int>&> got = cache.get(key);
+                assert(got.is_some() == (it != where.end()));
+                if (it != where.end()) {
+                    assert(*got.unwrap() == it->second->second);
+                    model.splice(model.begin(), model, it->second);
+                }
+            } else if (op < 6) {
+                Option<std::pair<String, Box<int>>> out = cache.push(std::move(key), Box<int>::make(step));
+                if (it != where.end()) {
+                    assert(out.is_some() && *out.unwrap().second == it->second->second);
+                    it->second->second = step;
+                    model.splice(model.begin(), model, it->second);
+                } else {
+                    if (model.size() == 64) {
+                        assert(out.is_some() && *out.unwrap().second == model.back().second);
+                        where.erase(model.back().first);
+                        model.pop_back();
+                    } else {
+                        assert(out.is_none());
+                    }
+                    model.push_front(std::make_pair(k, step));
+                    where[k] = model.begin();
+                }
+            } else if (op < 7) {
+                Option<Box<int>> removed = cache.remove(key);
+                assert(removed.is_some() == (it != where.end()));
+                if (it != where.end()) {
+                    model.erase(it->second);
+                    where.erase(it);
+                }
+            } else if (!model.empty()) {
+                assert(**cache.peek_lru().unwrap().second == model.back().second);
+            }
+            assert(cache.len() == model.size());
+        }
+
+        cache.resize(16);
+        assert(cache.len() == 16 && cache.cap() == 16);
+        auto m = model.begin();
+        cache.for_each([&](const String&, const Box<int>& v) { assert(*v == (m++)->second); });
+        cache.clear();
+        assert(cache.is_empty());
+    }
+    printf("PASS\n");
+}
+
+// Test CLOCK eviction: referenced entries get a second chance
+void test_clock_cache() {
+    printf("test_clock_cache: ");
+    {
+        ClockCache<int, int> cache = ClockCache<int, int>::new_(4);
+        for (int i = 0; i < 4; i++) cache.put(i, i * 10);
+        assert(cache.get(0).unwrap() == 0 && cache.get(2).unwrap() == 20);
+
+        // The hand clears 0, takes 1
+        assert(cache.push(4, 40).unwrap().first == 1);
+        // Clears 2, takes 3
+        assert(cache.push(5, 50).unwrap().first == 3);
+        assert(cache.contains(0) && cache.contains(2) && cache.peek(4).unwrap() == 40);
+
+        assert(cache.remove(0).unwrap() == 0 && cache.len() == 3);
+        assert(cache.evict().is_some() && cache.len() == 2);
+
+        // A hot working set survives a scan of cold keys
+        ClockCache<int, int> hot = ClockCache<int, int>::new_(100);
+        for (int round = 0; round < 50; round++) {
+            for (int k = 0; k < 50; k++) hot.get_or_insert_with(k, [&] { return k; });
+            for (int k = 0; k < 20; k++) hot.put(1000000 + round * 20 + k, k);
+        }
+        for (int k = 0; k < 50; k++) assert(hot.contains(k));
+
+        size_t before = hot.len();
+        hot.resize(60);
+        assert(hot.len() == 60 && before == 100 && hot.cap() == 60);
+        int seen = 0;
+        hot.for_each([&](const int&, const int&) { seen++; });
+        assert(seen == 60);
+    }
+    printf("PASS\n");
+}
+
+// Test the sharded caches from several threads
+template<typename Cache>
+static void check_sharded() {
+    Cache cache = Cache::with_shards(4096, 16);
+    assert(cache.shard_count() == 16 && cache.cap() == 4096);
+    const int threads = 4;
+    std::atomic<int> hits(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.push_back(std::thread([&, t] {
+            for (int i = 0; i < 20000; i++) {
+                int k = (i * 7 + t) % 2000;
+                if (cache.get_cloned(k).is_some()) hits++;
+                else cache.put(k, k * 2);
+                cache.update(k, [](int& v) { v |= 1; });
+            }
+        }));
+    }
+    for (size_t i = 0; i < workers.size(); i++) workers[i].join();
+
+    assert(hits.load() > 0 && cache.len() == 2000);
+    cache.for_each([](const int& k, const int& v) { assert(v == ((k * 2) | 1)); });
+    assert(cache.get_or_insert_with(5000, [] { return 7; }) == 7);
+    assert(cache.get_or_insert_with(5000, [] { return 8; }) == 7);
+    assert(cache.remove(5000).unwrap() == 7 && !cache.contains(5000));
+    cache.clear();
+    assert(cache.is_empty());
+
+    // Small caches use fewer shards so each still has room to evict well
+    Cache small = Cache::new_(100);
+    assert(small.shard_count() == 1);
+}
+
+void test_sharded_cache() {
+    printf("test_sharded_cache: ");
+    {
+        check_sharded<ConcurrentLruCache<int, int>>();
+        check_sharded<ConcurrentClockCache<int, int>>();
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::LruCache ===\n");
+
+    test_lru_basic();
+    test_lru_model();
+    test_clock_cache();
+    test_sharded_cache();
+
+    printf("\nAll LruCache tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,177 @@
+// Tests for rusty::mpsc channels
+#include "../include/rusty/mpsc.hpp"
+#include "../include/rusty/box.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace rusty;
+
+static std::atomic<int> live_messages(0);
+
+struct Message {
+    int producer;
+    int seq;
+
+    Message(int p, int s) : producer(p), seq(s) { live_messages++; }
+    Message(const Message& other) : producer(other.producer), seq(other.seq) {
+        live_messages++;
+    }
+    ~Message() { live_messages--; }
+};
+
+// Test send/recv order, try_recv and disconnection on one thread
+void test_channel_basic() {
+    printf("test_channel_basic: ");
+    {
+        auto ch = mpsc::channel<int>();
+        auto tx = std::move(ch.first);
+        auto rx = std::move(ch.second);
+
+        assert(rx.try_recv().unwrap_err() == mpsc::TryRecvError::Empty);
+        // Enough values to cross several blocks
+        for (int i = 0; i < 100; i++) {
+            assert(tx.send(i).is_ok());
+        }
+        for (int i = 0; i < 100; i++) {
+            assert(rx.recv().unwrap() == i);
+        }
+
+        auto tx2 = tx.clone();
+        tx2.send(7);
+        { auto dropped = std::move(tx); }
+        assert(rx.try_recv().unwrap() == 7);
+        { auto dropped = std::move(tx2); }
+        assert(rx.try_recv().unwrap_err() == mpsc::TryRecvError::Disconnected);
+        assert(rx.recv().is_err());
+    }
+    printf("PASS\n");
+}
+
+// Test that values sent before the last Sender drops are still received
+void test_channel_drain_after_disconnect() {
+    printf("test_channel_drain_after_disconnect: ");
+    {
+        auto ch = mpsc::sync_channel<Box<Message>>(4);
+        auto rx = std::move(ch.second);
+        {
+            auto tx = std::move(ch.first);
+            tx.send(Box<Message>::make(Message(0, 1)));
+            tx.send(Box<Message>::make(Message(0, 2)));
+        }
+        assert(rx.recv().unwrap()->seq == 1);
+        assert(rx.recv().unwrap()->seq == 2);
+        assert(rx.recv().is_err());
+
+        // Values left in a channel are dropped with it
+        auto ch2 = mpsc::channel<Box<Message>>();
+        ch2.first.send(Box<Message>::make(Message(0, 3)));
+        assert(live_messages.load() == 1);
+    }
+    assert(live_messages.load() == 0);
+    printf("PASS\n");
+}
+
+// Test that send fails and returns the value once the Receiver is gone
+void test_channel_receiver_dropped() {
+    printf("test_channel_receiver_dropped: ");
+    {
+        auto ch = mpsc::sync_channel<Box<Message>>(2);
+        auto tx = std::move(ch.first);
+        assert(!tx.is_closed());
+        { auto rx = std::move(ch.second); }
+        assert(tx.is_closed());
+        auto result = tx.send(Box<Message>::make(Message(1, 9)));
+        assert(result.is_err());
+        Box<Message> back = result.unwrap_err().value;
+        assert(back->seq == 9);
+    }
+    assert(live_messages.load() == 0);
+    printf("PASS\n");
+}
+
+// Test bounded capacity and the batch calls
+void test_channel_bounded_batch() {
+    printf("test_channel_bounded_batch: ");
+    {
+        auto ch = mpsc::sync_channel<int>(3);  // rounded up to 4
+        auto tx = std::move(ch.first);
+        auto rx = std::move(ch.second);
+
+        int items[] = {1, 2, 3, 4};
+        assert(tx.send_many(items, 4) == 4);
+
+        Vec<int> out;
+        assert(rx.recv_many(out, 2) == 2);
+        assert(out.len() == 2 && out[0] == 1 && out[1] == 2);
+
+        // A producer blocked on a full channel resumes as we drain it
+        std::thread producer([&tx]() {
+            int more[] = {5, 6, 7, 8, 9, 10};
+            assert(tx.send_many(more, 6) == 6);
+        });
+        size_t total = out.len();
+        while (total < 10) {
+            total += rx.recv_many(out, 10);
+        }
+        producer.join();
+        for (size_t i = 0; i < out.len(); i++) {
+            assert(out[i] == static_cast<int>(i) + 1);
+        }
+    }
+    printf("PASS\n");
+}
+
+// Test many producers; each producer's messages must arrive in order
+void run_producers(bool bounded) {
+    const int PRODUCERS = 4;
+    const int PER_PRODUCER = 20000;
+    auto ch = bounded ? mpsc::sync_channel<Box<Message>>(64)
+                      : mpsc::channel<Box<Message>>();
+    auto rx = std::move(ch.second);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([p](mpsc::Sender<Box<Message>> tx) {
+            for (int i = 0; i < PER_PRODUCER; i++) {
+                assert(tx.send(Box<Message>::make(Message(p, i))).is_ok());
+            }
+        }, ch.first.clone());
+    }
+    { auto dropped = std::move(ch.first); }
+
+    int next[PRODUCERS] = {0, 0, 0, 0};
+    int received = 0;
+    for (;;) {
+        auto msg = rx.recv();
+        if (msg.is_err()) break;
+        Box<Message> m = msg.unwrap();
+        assert(m->seq == next[m->producer]);
+        next[m->producer]++;
+        received++;
+    }
+    for (auto& t : producers) t.join();
+    assert(received == PRODUCERS * PER_PRODUCER);
+}
+
+void test_channel_threads() {
+    printf("test_channel_threads: ");
+    run_producers(false);
+    run_producers(true);
+    assert(live_messages.load() == 0);
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::mpsc ===\n");
+
+    test_channel_basic();
+    test_channel_drain_after_disconnect();
+    test_channel_receiver_dropped();
+    test_channel_bounded_batch();
+    test_channel_threads();
+
+    printf("\nAll mpsc tests passed!\n");
+    return 0;
+}
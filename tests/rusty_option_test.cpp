@@ -1,8 +1,11 @@
 // Tests for rusty::Option<T>
 #include "../include/rusty/option.hpp"
+#include "../include/rusty/arc.hpp"
+#include "../include/rusty/box.hpp"
 #include <cassert>
 #include <cstdio>
 #include <string>
+#include <type_traits>
 
 using namespace rusty;
 
@@ -225,6 +228,104 @@ void test_option_bool() {
     printf("PASS\n");
 }
 
+// Test niche layout for pointers and owning handles
+void test_option_niche() {
+    printf("test_option_niche: ");
+    {
+        static_assert(sizeof(Option<int*>) > sizeof(int*), "null is a valid pointer");
+        static_assert(sizeof(Option<Box<int>>) == sizeof(void*), "Box niche");
+        static_assert(sizeof(Option<Arc<int>>) == sizeof(void*), "Arc niche");
+        static_assert(sizeof(Option<int>) > sizeof(int), "no niche in int");
+
+        int x = 5;
+        Option<int*> p = Some(&x);
+        assert(p.is_some());
+        Option<int*> copy = p;
+        assert(*copy.unwrap() == 5);
+        assert(p.is_some());
+        assert(Option<int*>().is_none());
+        // A null pointer is a value, not the None pattern
+        Option<int*> null = Some(static_cast<int*>(nullptr));
+        assert(null.is_some() && null.unwrap() == nullptr);
+
+        auto b = Some(Box<int>::new_(7));
+        assert(b.is_some());
+        assert(*b.unwrap_ref() == 7);
+        auto moved = std::move(b);
+        assert(b.is_none());
+        Box<int> inner = moved.unwrap();
+        assert(*inner == 7);
+        assert(moved.is_none());
+
+        auto shared = Arc<int>::new_(1);
+        {
+            Option<Arc<int>> a = Some(shared);
+            Option<Arc<int>> c = a;
+            assert(shared.strong_count() == 3);
+            auto taken = c.take();
+            assert(c.is_none());
+            assert(taken.is_some());
+            a = Option<Arc<int>>(None);
+            assert(shared.strong_count() == 2);
+        }
+        assert(shared.strong_count() == 1);
+
+        Option<Box<int>> slot;
+        slot.replace(Box<int>::new_(1));
+        slot.replace(Box<int>::new_(2));
+        assert(*slot.unwrap_ref() == 2);
+    }
+    printf("PASS\n");
+}
+
+// Test Option<T&>: a nullable borrow
+void test_option_ref() {
+    printf("test_option_ref: ");
+    {
+        static_assert(sizeof(Option<int&>) == sizeof(int*), "one pointer wide");
+        static_assert(std::is_trivially_copyable<Option<const int&>>::value,
+                      "trivially copyable");
+
+        int x = 5;
+        Option<int&> some(x);
+        assert(some.is_some());
+        some.unwrap() = 6;
+        assert(x == 6);
+        assert(&some.unwrap() == &x);
+
+        // Copies alias the same referent
+        Option<int&> copy = some;
+        copy.unwrap()++;
+        assert(some.unwrap() == 7);
+
+        Option<const int&> ro = some;
+        assert(ro.unwrap() == 7);
+
+        int fallback = 0;
+        Option<int&> none(None);
+        assert(none.is_none());
+        assert(&none.unwrap_or(fallback) == &fallback);
+        assert(none.as_ptr() == nullptr);
+
+        auto doubled = some.map([](int& v) { return v * 2; });
+        assert(doubled.unwrap() == 14);
+
+        Option<int> owned = some.cloned();
+        x = 100;
+        assert(owned.unwrap() == 7);
+
+        int y = 1;
+        Option<const int&> a(x), b(y), c(x);
+        assert(a != b);
+        assert(a == c);
+
+        auto taken = a.take();
+        assert(a.is_none());
+        assert(taken.unwrap() == 100);
+    }
+    printf("PASS\n");
+}
+
 int main() {
     printf("=== Testing rusty::Option<T> ===\n");
     
@@ -241,6 +342,8 @@ int main() {
     test_option_custom_type();
     test_option_nested();
     test_option_bool();
+    test_option_niche();
+    test_option_ref();
     
     printf("\nAll Option tests passed!\n");
     return 0;
@@ -0,0 +1,157 @@
+// Tests for rusty parallel iterators
+#include "../include/rusty/par_iter.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <stdexcept>
+
+using namespace rusty;
+
+// Test for_each, map, filter, sum and count against sequential loops
+void test_par_iter_vec() {
+    printf("test_par_iter_vec: ");
+    {
+        Vec<int> v;
+        for (int i = 0; i < 100000; i++) v.push(i);
+
+        long long total = par_iter(v).map([](const int& x) { return (long long)x; }).sum();
+        assert(total == 99999LL * 100000 / 2);
+
+        size_t evens = par_iter(v).filter([](const int& x) { return x % 2 == 0; }).count();
+        assert(evens == 50000);
+
+        long long squares = par_iter(v)
+                                .filter([](const int& x) { return x % 3 == 0; })
+                                .map([](const int& x) { return (long long)x * x; })
+                                .reduce(0LL, [](long long a, long long b) { return a + b; });
+        long long expected = 0;
+        for (int i = 0; i < 100000; i += 3) expected += (long long)i * i;
+        assert(squares == expected);
+
+        std::atomic<long long> seen(0);
+        par_iter(v).for_each([&seen](const int& x) { seen += x; });
+        assert(seen.load() == total);
+
+        par_iter_mut(v).for_each([](int& x) { x *= 2; });
+        for (size_t i = 0; i < v.len(); i++) assert(v[i] == static_cast<int>(i) * 2);
+
+        Vec<int> empty;
+        assert(par_iter(empty).count() == 0);
+        assert(par_iter(empty).sum() == 0);
+        assert(par_iter(empty).collect().is_empty());
+    }
+    printf("PASS\n");
+}
+
+// Test that collect keeps the source order
+void test_par_iter_collect() {
+    printf("test_par_iter_collect: ");
+    {
+        Vec<int> v;
+        for (int i = 0; i < 50000; i++) v.push(i);
+        Vec<int> odd = par_iter(v).filter([](const int& x) { return x % 2 == 1; }).collect();
+        assert(odd.len() == 25000);
+        for (size_t i = 0; i < odd.len(); i++) assert(odd[i] == static_cast<int>(2 * i + 1));
+
+        Vec<size_t> squares = par_range(0, 1000).map([](size_t i) { return i * i; }).collect();
+        assert(squares.len() == 1000 && squares[999] == 999 * 999);
+
+        // A minimum length above the input size runs as a single task
+        Vec<int> copy = par_iter(v.as_slice().slice(10, 20)).with_min_len(1000).collect();
+        assert(copy.len() == 10 && copy[0] == 10);
+    }
+    printf("PASS\n");
+}
+
+// Test par_chunks and par_chunks_mut
+void test_par_chunks() {
+    printf("test_par_chunks: ");
+    {
+        Vec<int> v;
+        v.resize(10003, 1);
+        assert(par_chunks(v, 100).count() == 101);
+        Vec<size_t> lens = par_chunks(v, 100).map([](Slice<int> c) { return c.len(); }).collect();
+        assert(lens[0] == 100 && lens[100] == 3);
+
+        par_chunks_mut(v, 64).for_each([](SliceMut<int> chunk) {
+            for (size_t i = 0; i < chunk.len(); i++) chunk[i] = static_cast<int>(i);
+        });
+        for (size_t i = 0; i < v.len(); i++) assert(v[i] == static_cast<int>(i % 64));
+
+        long long sum = par_chunks(v, 1000)
+                            .map([](Slice<int> c) {
+                                long long s = 0;
+                                for (int x : c) s += x;
+                                return s;
+                            })
+                            .sum();
+        long long expected = 0;
+        for (int x : v) expected += x;
+        assert(sum == expected);
+    }
+    printf("PASS\n");
+}
+
+// Test iterating a HashMap by control-byte groups
+void test_par_iter_hashmap() {
+    printf("test_par_iter_hashmap: ");
+    {
+        HashMap<int, int> map;
+        for (int i = 0; i < 20000; i++) map.insert(i, i);
+        for (int i = 0; i < 20000; i += 2) map.remove(i);
+
+        assert(par_iter(map).count() == 10000);
+        long long sum = par_iter(map)
+                            .map([](std::pair<const int&, const int&> kv) {
+                                return (long long)kv.second;
+                            })
+                            .sum();
+        assert(sum == 10000LL * 10000);  // sum of the odd numbers below 20000
+
+        par_iter_mut(map).for_each([](std::pair<const int&, int&> kv) { kv.second = -kv.first; });
+        for (int i = 1; i < 20000; i += 2) assert(map.get(i).unwrap() == -i);
+
+        HashMap<int, int> empty;
+        assert(par_iter(empty).count() == 0);
+    }
+    printf("PASS\n");
+}
+
+// Test that errors propagate and nested parallel calls finish
+void test_par_iter_errors_and_nesting() {
+    printf("test_par_iter_errors_and_nesting: ");
+    {
+        Vec<int> v;
+        for (int i = 0; i < 10000; i++) v.push(i);
+        bool threw = false;
+        try {
+            par_iter(v).for_each([](const int& x) {
+                if (x == 5000) throw std::runtime_error("boom");
+            });
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw);
+
+        // An inner parallel call runs on the worker that makes it
+        size_t total = par_range(0, 100)
+                           .map([&v](size_t) { return par_iter(v).count(); })
+                           .sum();
+        assert(total == 100 * 10000);
+        assert(current_num_threads() >= 1);
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty parallel iterators ===\n");
+
+    test_par_iter_vec();
+    test_par_iter_collect();
+    test_par_chunks();
+    test_par_iter_hashmap();
+    test_par_iter_errors_and_nesting();
+
+    printf("\nAll par_iter tests passed!\n");
+    return 0;
+}
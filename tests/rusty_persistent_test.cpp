@@ -0,0 +1,265 @@
+// Tests for rusty::PersistentMap and rusty::PersistentVec
+#include "../include/rusty/persistent.hpp"
+#include "../include/rusty/string.hpp"
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace rusty;
+
+struct Tracked {
+    static int instances;
+    int value;
+
+    explicit Tracked(int v) : value(v) { instances++; }
+    Tracked(const Tracked& other) : value(other.value) { instances++; }
+    Tracked(Tracked&& other) noexcept : value(other.value) { instances++; }
+    Tracked& operator=(const Tracked&) = default;
+    Tracked& operator=(Tracked&&) = default;
+    ~Tracked() { instances--; }
+    bool operator==(const Tracked& other) const { return value == other.value; }
+};
+
+int Tracked::instances = 0;
+
+// Every key collides, so they all end up in one collision node
+struct ConstantHash {
+    size_t operator()(int) const { return 42; }
+};
+
+void test_persistent_map_versions() {
+    printf("test_persistent_map_versions: ");
+    {
+        PersistentMap<int, int> empty;
+        auto one = empty.insert(1, 10);
+        auto two = one.insert(2, 20);
+        auto replaced = two.insert(1, 11);
+        assert(empty.is_empty() && one.len() == 1 && two.len() == 2 && replaced.len() == 2);
+        assert(one.get(1).unwrap() == 10 && one.get(2).is_none());
+        assert(two.get(1).unwrap() == 10 && replaced.get(1).unwrap() == 11);
+
+        auto removed = replaced.remove(2);
+        assert(removed.len() == 1 && !removed.contains_key(2) && replaced.contains_key(2));
+        assert(removed.remove(5).ptr_eq(removed));
+        assert(removed.remove(1).is_empty() && removed.len() == 1);
+
+        auto copy = two;
+        assert(copy.ptr_eq(two) && copy == two && two != replaced);
+    }
+    printf("PASS\n");
+}
+
+// Many keys against std::unordered_map, keeping old versions along the way
+void test_persistent_map_many_keys() {
+    printf("test_persistent_map_many_keys: ");
+    {
+        PersistentMap<int, int> map;
+        std::vector<PersistentMap<int, int>> versions;
+        for (int i = 0; i < 20000; i++) {
+            map = map.insert(i * 7919, i);
+            if (i % 2000 == 0) versions.push_back(map);
+        }
+        assert(map.len() == 20000);
+        for (int i = 0; i < 20000; i++) assert(map.get(i * 7919).unwrap() == i);
+        for (size_t v = 0; v < versions.size(); v++) {
+            assert(versions[v].len() == v * 2000 + 1);
+            assert(versions[v].contains_key(int(v * 2000) * 7919));
+            assert(!versions[v].contains_key(int(v * 2000 + 1) * 7919));
+        }
+
+        std::unordered_map<int, int> expected;
+        for (int i = 0; i < 20000; i++) expected[i * 7919] = i;
+        auto full = map;
+        for (int i = 0; i < 20000; i += 3) {
+            map = map.remove(i * 7919);
+            expected.erase(i * 7919);
+        }
+        assert(map.len() == expected.size() && full.len() == 20000);
+        size_t seen = 0;
+        map.for_each([&](const int& k, const int& v) {
+            assert(expected.at(k) == v);
+            seen++;
+        });
+        assert(seen == expected.size());
+
+        for (int i = 0; i < 20000; i++) map = map.remove(i * 7919);
+        assert(map.is_empty() && full.get(3 * 7919).unwrap() == 3);
+    }
+    printf("PASS\n");
+}
+
+// Hashes that agree in their top bits, so keys share long paths of
+// single-child nodes before they split
+struct LowBitsHash {
+    size_t operator()(int k) const { return static_cast<size_t>(k) & 0xFFFF; }
+};
+
+void test_persistent_map_deep_paths() {
+    printf("test_persistent_map_deep_paths: ");
+    {
+        PersistentMap<int, int, LowBitsHash> map;
+        std::unordered_map<int, int> expected;
+        unsigned seed = 7;
+        for (int step = 0; step < 20000; step++) {
+            seed = seed * 1103515245 + 12345;
+            int key = static_cast<int>((seed >> 8) % 3000) * 0x10001;  // Colliding pairs too
+            if ((seed >> 4) & 1) {
+                map = map.insert(key, step);
+                expected[key] = step;
+            } else {
+                map = map.remove(key);
+                expected.erase(key);
+            }
+            assert(map.len() == expected.size());
+        }
+        for (const auto& kv : expected) assert(map.get(kv.first).unwrap() == kv.second);
+        for (const auto& kv : expected) map = map.remove(kv.first);
+        assert(map.is_empty());
+    }
+    printf("PASS\n");
+}
+
+void test_persistent_map_collisions() {
+    printf("test_persistent_map_collisions: ");
+    {
+        PersistentMap<int, Tracked, ConstantHash> map;
+        for (int i = 0; i < 50; i++) map = map.insert(i, Tracked(i));
+        auto before = map;
+        map = map.insert(7, Tracked(70));
+        assert(map.len() == 50 && map.get(7).unwrap().value == 70);
+        assert(before.get(7).unwrap().value == 7);
+        for (int i = 0; i < 49; i++) map = map.remove(i);
+        assert(map.len() == 1 && map.get(49).unwrap().value == 49 && !map.contains_key(7));
+        map = map.remove(49);
+        assert(map.is_empty() && before.len() == 50);
+    }
+    assert(Tracked::instances == 0);
+    printf("PASS\n");
+}
+
+void test_persistent_map_move_only_keys() {
+    printf("test_persistent_map_move_only_keys: ");
+    {
+        // String is move-only: nodes are copied with clone()
+        PersistentMap<String, int> map;
+        for (int i = 0; i < 500; i++) {
+            char buf[16];
+            snprintf(buf, sizeof(buf), "key%d", i);
+            map = map.insert(String::from(buf), i);
+        }
+        assert(map.get(String::from("key250")).unwrap() == 250);
+        assert(map.remove(String::from("key250")).len() == 499);
+    }
+    printf("PASS\n");
+}
+
+void test_persistent_vec_push_pop_set() {
+    printf("test_persistent_vec_push_pop_set: ");
+    {
+        // Past 32 * 32 + 32 values the root grows a level, past 32^3 + 32 another
+        const size_t n = 40000;
+        PersistentVec<size_t> vec;
+        PersistentVec<size_t> at_1000;
+        for (size_t i = 0; i < n; i++) {
+            vec = vec.push_back(i);
+            if (i == 999) at_1000 = vec;
+        }
+        assert(vec.len() == n && at_1000.len() == 1000);
+        for (size_t i = 0; i < n; i++) assert(vec[i] == i);
+        assert(vec.get(n).is_none() && at_1000.get(999).unwrap() == 999);
+
+        auto changed = vec.set(5, 500).set(n - 1, 1).set(33000, 7);
+        assert(changed[5] == 500 && changed[n - 1] == 1 && changed[33000] == 7);
+        assert(vec[5] == 5 && vec[n - 1] == n - 1 && vec[33000] == 33000);
+        assert(changed != vec && vec.clone() == vec);
+
+        size_t sum = 0;
+        vec.for_each([&](const size_t& v) { sum += v; });
+        assert(sum == n * (n - 1) / 2);
+
+        // Pop back through every boundary down to empty
+        auto shrinking = vec;
+        for (size_t len = n; len > 0; len--) {
+            assert(shrinking.len() == len);
+            if (len % 997 == 0 || len < 70) {
+                for (size_t i = 0; i < len; i += len / 7 + 1) assert(shrinking[i] == i);
+                assert(shrinking[len - 1] == len - 1);
+            }
+            shrinking = shrinking.pop_back();
+        }
+        assert(shrinking.is_empty() && shrinking.pop_back().is_empty());
+        assert(vec.len() == n && vec[n - 1] == n - 1);
+
+        // Pushing again after popping reuses nothing that is still shared
+        auto regrown = at_1000.pop_back().pop_back().push_back(42);
+        assert(regrown.len() == 999 && regrown[998] == 42 && at_1000[998] == 998);
+    }
+    printf("PASS\n");
+}
+
+void test_persistent_vec_drops() {
+    printf("test_persistent_vec_drops: ");
+    {
+        PersistentVec<Tracked> vec;
+        for (int i = 0; i < 2000; i++) vec = vec.push_back(Tracked(i));
+        auto older = vec.set(100, Tracked(-1));
+        for (int i = 0; i < 1500; i++) vec = vec.pop_back();
+        assert(vec.len() == 500 && older[100].value == -1 && older[1999].value == 1999);
+    }
+    assert(Tracked::instances == 0);
+    printf("PASS\n");
+}
+
+// Arc-shared versions can be read from other threads while new ones are made
+void test_persistent_arc_nodes() {
+    printf("test_persistent_arc_nodes: ");
+    static_assert(!is_send<PersistentMap<int, int>>::value, "Rc nodes stay on their thread");
+    static_assert(is_send<PersistentMap<int, int, FxHash<int>, std::equal_to<int>, ArcNodes>>::value,
+                  "Arc nodes may be shared");
+    static_assert(!is_send<PersistentVec<Rc<int>, ArcNodes>>::value, "Rc values may not be shared");
+    static_assert(is_sync<PersistentVec<int, ArcNodes>>::value, "Arc nodes may be shared");
+    {
+        PersistentMap<int, int, FxHash<int>, std::equal_to<int>, ArcNodes> map;
+        PersistentVec<int, ArcNodes> vec;
+        for (int i = 0; i < 1000; i++) {
+            map = map.insert(i, i);
+            vec = vec.push_back(i);
+        }
+        auto map_snapshot = map;
+        auto vec_snapshot = vec;
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; t++) {
+            readers.emplace_back([map_snapshot, vec_snapshot]() {
+                for (int i = 0; i < 1000; i++) {
+                    assert(map_snapshot.get(i).unwrap() == i && vec_snapshot[i] == i);
+                }
+            });
+        }
+        for (int i = 0; i < 1000; i++) {
+            map = map.insert(i, -i);
+            vec = vec.set(i, -i);
+        }
+        for (auto& r : readers) r.join();
+        assert(map.get(10).unwrap() == -10 && map_snapshot.get(10).unwrap() == 10);
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::PersistentMap / PersistentVec ===\n");
+
+    test_persistent_map_versions();
+    test_persistent_map_many_keys();
+    test_persistent_map_deep_paths();
+    test_persistent_map_collisions();
+    test_persistent_map_move_only_keys();
+    test_persistent_vec_push_pop_set();
+    test_persistent_vec_drops();
+    test_persistent_arc_nodes();
+
+    printf("\nAll persistent collection tests passed!\n");
+    return 0;
+}
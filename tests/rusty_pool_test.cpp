@@ -0,0 +1,172 @@
+// Tests for rusty::Pool<T> / rusty::PoolBox<T>
+#include "../include/rusty/pool.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace rusty;
+
+static std::atomic<int> live_messages(0);
+
+struct Message {
+    int id;
+    char payload[40];
+
+    explicit Message(int i) : id(i) {
+        if (i < 0) throw std::runtime_error("bad id");
+        payload[0] = static_cast<char>(i);
+        live_messages++;
+    }
+    Message(const Message& other) : id(other.id) {
+        payload[0] = other.payload[0];
+        live_messages++;
+    }
+    ~Message() { live_messages--; }
+};
+
+// Test construction, access and move-only ownership
+void test_pool_box_basic() {
+    printf("test_pool_box_basic: ");
+    {
+        auto a = Pool<Message>::make(1);
+        assert(a.is_valid());
+        assert(a->id == 1);
+        (*a).id = 2;
+        assert(a->id == 2);
+
+        auto b = std::move(a);
+        assert(!a.is_valid());
+        assert(b->id == 2);
+
+        auto c = PoolBox<Message>::new_(Message(3));
+        auto d = pool_box<Message>(4);
+        assert(c->id == 3 && d->id == 4);
+        assert(live_messages.load() == 3);
+
+        c = std::move(d);
+        assert(c->id == 4);
+        assert(live_messages.load() == 2);
+
+        b.reset();
+        assert(!b);
+        assert(live_messages.load() == 1);
+    }
+    assert(live_messages.load() == 0);
+    printf("PASS\n");
+}
+
+// Test that freed memory is reused without new allocations
+void test_pool_reuse() {
+    printf("test_pool_reuse: ");
+    {
+        Message* first;
+        {
+            auto m = Pool<Message>::make(1);
+            first = m.get();
+        }
+        // LIFO free list: the slot just freed comes straight back
+        auto again = Pool<Message>::make(2);
+        assert(again.get() == first);
+
+        size_t free_before = Pool<Message>::local_free();
+        std::vector<PoolBox<Message>> batch;
+        for (int i = 0; i < 10; i++) {
+            batch.push_back(Pool<Message>::make(i));
+        }
+        batch.clear();
+        assert(Pool<Message>::local_free() == free_before);
+
+        Pool<Message>::reserve(500);
+        assert(Pool<Message>::local_free() >= 500);
+    }
+    printf("PASS\n");
+}
+
+// Test that a throwing constructor returns its slot
+void test_pool_throwing_ctor() {
+    printf("test_pool_throwing_ctor: ");
+    {
+        size_t free_before = Pool<Message>::local_free();
+        bool thrown = false;
+        try {
+            auto bad = Pool<Message>::make(-1);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+        assert(Pool<Message>::local_free() == free_before);
+        assert(live_messages.load() == 0);
+    }
+    printf("PASS\n");
+}
+
+struct alignas(64) Aligned {
+    int value;
+    explicit Aligned(int v) : value(v) {}
+};
+
+// Test over-aligned types
+void test_pool_alignment() {
+    printf("test_pool_alignment: ");
+    {
+        std::vector<PoolBox<Aligned>> boxes;
+        for (int i = 0; i < 100; i++) {
+            boxes.push_back(Pool<Aligned>::make(i));
+            assert(reinterpret_cast<uintptr_t>(boxes.back().get()) % 64 == 0);
+        }
+        assert(boxes[99]->value == 99);
+    }
+    printf("PASS\n");
+}
+
+// Test producer/consumer threads: boxes freed away from their allocating thread
+void test_pool_threads() {
+    printf("test_pool_threads: ");
+    {
+        const int PER_THREAD = 20000;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([t]() {
+                std::vector<PoolBox<Message>> held;
+                for (int i = 0; i < PER_THREAD; i++) {
+                    held.push_back(Pool<Message>::make(t * PER_THREAD + i));
+                    if (held.size() > 300) {
+                        held.erase(held.begin(), held.begin() + 150);
+                    }
+                }
+                for (auto& m : held) {
+                    assert(m->id >= t * PER_THREAD && m->id < (t + 1) * PER_THREAD);
+                }
+            });
+        }
+        // Hand boxes to another thread to drop
+        std::vector<PoolBox<Message>> handoff;
+        for (int i = 0; i < 1000; i++) {
+            handoff.push_back(Pool<Message>::make(i));
+        }
+        std::thread consumer([&handoff]() { handoff.clear(); });
+        consumer.join();
+        for (auto& t : threads) t.join();
+        assert(live_messages.load() == 0);
+        // Exited threads gave their slots back
+        assert(Pool<Message>::shared_free() >= 1000);
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::Pool<T> ===\n");
+
+    test_pool_box_basic();
+    test_pool_throwing_ctor();
+    test_pool_reuse();
+    test_pool_alignment();
+    test_pool_threads();
+
+    printf("\nAll Pool tests passed!\n");
+    return 0;
+}
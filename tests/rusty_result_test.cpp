@@ -1,8 +1,11 @@
 // Tests for rusty::Result<T, E>
 #include "../include/rusty/result.hpp"
+#include "../include/rusty/box.hpp"
 #include <cassert>
+#include <cstdint>
 #include <cstdio>
 #include <string>
+#include <type_traits>
 
 using namespace rusty;
 
@@ -259,6 +262,66 @@ void test_result_void() {
     printf("PASS\n");
 }
 
+enum class ErrorCode : uint8_t { Eof = 1, BadDigit = 2 };
+
+Result<uint32_t, ErrorCode> parse_digit(char c) {
+    if (c == 0) return Result<uint32_t, ErrorCode>::Err(ErrorCode::Eof);
+    if (c < '0' || c > '9') return Result<uint32_t, ErrorCode>::Err(ErrorCode::BadDigit);
+    return Result<uint32_t, ErrorCode>::Ok(static_cast<uint32_t>(c - '0'));
+}
+
+// Test layout: trivial payloads give a trivial, compact Result
+void test_result_layout() {
+    printf("test_result_layout: ");
+    {
+        using Parse = Result<uint32_t, ErrorCode>;
+        static_assert(std::is_trivially_copyable<Parse>::value, "trivially copyable");
+        static_assert(std::is_trivially_destructible<Parse>::value, "trivially destructible");
+        static_assert(sizeof(Parse) == 2 * sizeof(uint32_t), "flag packs after the union");
+        static_assert(!std::is_trivially_copyable<Result<std::string, int>>::value,
+                      "non-trivial payload");
+
+        // Ok is the null niche of a Box error; a raw pointer has none
+        static_assert(sizeof(Result<void, Box<int>>) == sizeof(void*), "Box niche");
+        static_assert(sizeof(Result<void, const char*>) > sizeof(const char*), "no pointer niche");
+
+        uint32_t sum = 0;
+        for (const char* p = "1234x"; ; p++) {
+            Parse r = parse_digit(*p);
+            Parse copy = r;
+            if (copy.is_err()) {
+                assert(copy.unwrap_err() == ErrorCode::BadDigit);
+                break;
+            }
+            sum += copy.unwrap();
+        }
+        assert(sum == 10);
+        assert(parse_digit(0).unwrap_err() == ErrorCode::Eof);
+
+        // Owning payloads are still copied and destroyed properly
+        auto a = Result<std::string, int>::Ok(std::string(100, 'a'));
+        auto b = a;
+        a = Result<std::string, int>::Err(7);
+        assert(b.unwrap().size() == 100);
+        b = a;
+        assert(b.unwrap_err() == 7);
+
+        using Status = Result<void, Box<int>>;
+        Status ok = Status::Ok();
+        assert(ok.is_ok());
+        Status bad = Status::Err(Box<int>::new_(5));
+        assert(bad.is_err());
+        Status moved = std::move(bad);
+        assert(moved.is_err());
+        assert(*moved.unwrap_err() == 5);
+
+        auto with_msg = Result<void, std::string>::Err("boom");
+        auto msg_copy = with_msg;
+        assert(msg_copy.unwrap_err() == "boom");
+    }
+    printf("PASS\n");
+}
+
 int main() {
     printf("=== Testing rusty::Result<T, E> ===\n");
     
@@ -275,6 +338,7 @@ int main() {
     test_result_bool();
     test_result_complex_chain();
     test_result_void();
+    test_result_layout();
     
     printf("\nAll Result tests passed!\n");
     return 0;
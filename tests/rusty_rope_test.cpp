@@ -0,0 +1,185 @@
+// Tests for rusty::Rope
+#include "../include/rusty/rope.hpp"
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace rusty;
+
+static size_t count_lines(const std::string& s) {
+    size_t n = 1;
+    for (char c : s) n += c == '\n';
+    return n;
+}
+
+// Text of n bytes with a newline every so often
+static std::string sample(size_t n, char base = 'a') {
+    std::string s;
+    for (size_t i = 0; i < n; i++) s += i % 61 == 60 ? '\n' : char(base + i % 26);
+    return s;
+}
+
+void test_rope_basic() {
+    printf("test_rope_basic: ");
+    {
+        Rope empty;
+        assert(empty.is_empty() && empty.len() == 0 && empty.len_lines() == 1);
+        assert(empty.to_string() == "" && empty == str(""));
+        assert(empty.chunks().next().is_none());
+
+        Rope rope = Rope::from("hello world");
+        rope.insert(5, ",");
+        rope.push_str("!");
+        assert(rope == str("hello, world!") && rope.len() == 13);
+        rope.remove(0, 7);
+        assert(rope.to_string() == "world!" && rope.byte(0) == 'w');
+        rope.insert(0, "");
+        rope.remove(3, 3);
+        assert(rope == Rope::from("world!") && rope != Rope::from("world?"));
+        rope.remove(0, rope.len());
+        assert(rope.is_empty());
+
+        // Multi-byte chars are never split between chunks
+        std::string text;
+        for (int i = 0; i < 3000; i++) text += "\xc3\xa9\xe2\x82\xac";  // é€
+        Rope utf8 = Rope::from(text);
+        for (str chunk : utf8.chunks()) {
+            assert(str::from_utf8(chunk.as_ptr(), chunk.len()).is_ok());
+        }
+        utf8.insert(5 * 1000, text);
+        for (str chunk : utf8.chunks()) {
+            assert(chunk.len() <= 1024 + 3 && str::from_utf8(chunk.as_ptr(), chunk.len()).is_ok());
+        }
+        assert(utf8.len() == 2 * text.size());
+    }
+    printf("PASS\n");
+}
+
+// Random edits of a large buffer against std::string
+void test_rope_random_edits() {
+    printf("test_rope_random_edits: ");
+    {
+        srand(2024);
+        std::string model = sample(200000);
+        Rope rope = Rope::from(model);
+        for (int step = 0; step < 3000; step++) {
+            int op = rand() % 3;
+            size_t at = model.empty() ? 0 : size_t(rand()) % (model.size() + 1);
+            if (op == 0 || model.size() < 1000) {
+                std::string piece = sample(rand() % (step % 50 == 0 ? 5000 : 40), char('A' + step % 26));
+                rope.insert(at, piece);
+                model.insert(at, piece);
+            } else {
+                size_t n = size_t(rand()) % (step % 100 == 0 ? 50000 : 300);
+                size_t end = std::min(model.size(), at + n);
+                rope.remove(at, end);
+                model.erase(at, end - at);
+            }
+            assert(rope.len() == model.size());
+            if (step % 250 == 0) {
+                assert(rope.to_string() == model.c_str());
+                for (str chunk : rope.chunks()) assert(!chunk.is_empty() && chunk.len() <= 1024);
+            }
+        }
+        assert(rope == str(model) && rope.len_lines() == count_lines(model));
+        for (size_t i = 0; i < model.size(); i += 997) assert(rope.byte(i) == model[i]);
+
+        // Emptying and refilling by edits alone
+        rope.remove(0, rope.len() / 2);
+        model.erase(0, model.size() / 2);
+        while (!rope.is_empty()) {
+            size_t n = std::min(rope.len(), size_t(700));
+            rope.remove(rope.len() - n, rope.len());
+        }
+        for (int i = 0; i < 2000; i++) rope.insert(rope.len() / 2, "xyz\n");
+        assert(rope.len() == 8000 && rope.len_lines() == 2001);
+    }
+    printf("PASS\n");
+}
+
+void test_rope_lines() {
+    printf("test_rope_lines: ");
+    {
+        std::string model;
+        for (int i = 0; i < 5000; i++) {
+            model += "line " + std::to_string(i);
+            model += std::string(i % 300, '.');
+            model += '\n';
+        }
+        model += "tail";
+        Rope rope = Rope::from(model);
+        assert(rope.len_lines() == 5001);
+
+        size_t offset = 0;
+        for (size_t line = 0; line < 5001; line++) {
+            assert(rope.line_to_byte(line) == offset);
+            assert(rope.byte_to_line(offset) == line);
+            size_t next = model.find('\n', offset);
+            if (next == std::string::npos) next = model.size() - 1;
+            if (line % 37 == 0) {
+                std::string expected = model.substr(offset, next + 1 - offset);
+                assert(rope.line(line) == str(expected));
+                assert(rope.byte_to_line(next) == line);
+            }
+            offset = next + 1;
+        }
+        assert(rope.line(5000) == str("tail") && rope.byte_to_line(rope.len()) == 5000);
+
+        Rope ends_with_newline = Rope::from("a\nb\n");
+        assert(ends_with_newline.len_lines() == 3 && ends_with_newline.line(2).is_empty());
+        assert(ends_with_newline.line_to_byte(2) == 4);
+    }
+    printf("PASS\n");
+}
+
+// Clones are snapshots: edits copy only the nodes they touch
+void test_rope_clone_and_slice() {
+    printf("test_rope_clone_and_slice: ");
+    {
+        std::string text = sample(1 << 20);
+        Rope original = Rope::from(text);
+        Rope edited = original.clone();
+        edited.insert(500000, "<inserted>");
+        edited.remove(10, 20);
+        assert(original == str(text));
+        assert(edited.len() == text.size() + 10 - 10);
+        std::string expected = text;
+        expected.insert(500000, "<inserted>");
+        expected.erase(10, 10);
+        assert(edited == str(expected));
+
+        Rope middle = original.slice(123456, 654321);
+        assert(middle == str(text.substr(123456, 654321 - 123456)));
+        assert(original.slice(0, 0).is_empty() && original.slice(0, text.size()) == original);
+        assert(middle.slice(1000, 1010) == str(text.substr(124456, 10)));
+
+        // Snapshots read from other threads while the owner keeps editing
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; t++) {
+            Rope snapshot = original.clone();
+            readers.emplace_back([snapshot, &text]() {
+                assert(snapshot == str(text));
+                assert(snapshot.len_lines() == count_lines(text));
+            });
+        }
+        for (int i = 0; i < 200; i++) original.insert(size_t(i) * 4000, "#");
+        for (auto& r : readers) r.join();
+        assert(original.len() == text.size() + 200);
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::Rope ===\n");
+
+    test_rope_basic();
+    test_rope_random_edits();
+    test_rope_lines();
+    test_rope_clone_and_slice();
+
+    printf("\nAll Rope tests passed!\n");
+    return 0;
+}
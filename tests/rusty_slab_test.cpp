@@ -0,0 +1,187 @@
+// Tests for rusty::Slab
+#include "../include/rusty/slab.hpp"
+#include "../include/rusty/box.hpp"
+#include "../include/rusty/hashmap.hpp"
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace rusty;
+
+static int live = 0;
+
+struct Counted {
+    int value;
+    explicit Counted(int v) : value(v) { live++; }
+    Counted(Counted&& other) : value(other.value) { live++; }
+    Counted(const Counted& other) : value(other.value) { live++; }
+    ~Counted() { live--; }
+};
+
+// Test insert/remove/lookup and that stale keys stop matching
+void test_slab_basic() {
+    printf("test_slab_basic: ");
+    {
+        Slab<std::string> slab;
+        assert(slab.is_empty() && !slab.contains(SlabKey()) && SlabKey().is_null());
+        SlabKey a = slab.insert("a");
+        SlabKey b = slab.insert("b");
+        SlabKey c = slab.emplace(3, 'c');
+        assert(slab.len() == 3 && slab[a] == "a" && slab.get(c).unwrap() == "ccc");
+        assert(a != b && !a.is_null());
+
+        assert(slab.remove(b).unwrap() == "b");
+        assert(!slab.contains(b) && slab.remove(b).is_none() && slab.get(b).is_none());
+
+        // The freed slot is reused, under a new generation
+        SlabKey d = slab.insert("d");
+        assert(d.index() == b.index() && d.generation() != b.generation());
+        assert(!slab.contains(b) && slab[d] == "d");
+
+        slab.get_mut(a).unwrap() += "!";
+        slab[d] += "?";
+        assert(slab[a] == "a!" && slab[d] == "d?");
+        assert(SlabKey::from_bits(d.to_bits()) == d);
+        assert(slab.get_disjoint_mut(a, a).is_none() && slab.get_disjoint_mut(a, b).is_none());
+        std::pair<std::string*, std::string*> both = slab.get_disjoint_mut(a, d).unwrap();
+        std::swap(*both.first, *both.second);
+        assert(slab[a] == "d?" && slab[d] == "a!");
+
+        SlabKey self = slab.insert_with_key([](SlabKey k) { return std::to_string(k.index()); });
+        assert(slab[self] == std::to_string(self.index()));
+
+        slab.clear();
+        assert(slab.is_empty() && !slab.contains(a) && !slab.contains(self));
+        SlabKey e = slab.insert("e");
+        assert(!slab.contains(a) && !slab.contains(c) && slab.contains(e));
+
+        HashMap<SlabKey, int> side;
+        side.insert(e, 1);
+        assert(side.get(e).unwrap() == 1 && side.get(a).is_none());
+    }
+    printf("PASS\n");
+}
+
+// Test random operations against a map model, with move-only values
+void test_slab_model() {
+    printf("test_slab_model: ");
+    {
+        srand(46);
+        Slab<Box<int>> slab = Slab<Box<int>>::with_capacity(8);
+        std::map<uint64_t, int> model;
+        std::vector<SlabKey> keys;  // Live and stale
+        for (int step = 0; step < 50000; step++) {
+            int op = rand() % 5;
+            if (op < 2 || keys.empty()) {
+                SlabKey k = slab.insert(Box<int>::make(step));
+                assert(model.count(k.to_bits()) == 0);
+                model[k.to_bits()] = step;
+                keys.push_back(k);
+            } else {
+                size_t at = rand() % keys.size();
+                SlabKey k = keys[at];
+                bool present = model.count(k.to_bits()) != 0;
+                assert(slab.contains(k) == present);
+                if (op == 2) {
+                    Option<Box<int>> out = slab.remove(k);
+                    assert(out.is_some() == present);
+                    if (present) {
+                        assert(*out.unwrap() == model[k.to_bits()]);
+                        model.erase(k.to_bits());
+                    }
+                } else if (present) {
+                    assert(*slab.get(k).unwrap() == model[k.to_bits()]);
+                }
+                if (!present && rand() % 2) {
+                    keys[at] = keys.back();
+                    keys.pop_back();
+                }
+            }
+            assert(slab.len() == model.size());
+        }
+        // Removals are reused, so slots stay close to the peak live count
+        assert(slab.capacity() < 4 * (model.size() + 1) + 64);
+
+        size_t seen = 0;
+        slab.iter().for_each([&](std::pair<SlabKey, const Box<int>&> kv) {
+            assert(*kv.second == model[kv.first.to_bits()]);
+            seen++;
+        });
+        assert(seen == model.size() && slab.iter().count() == model.size());
+
+        slab.iter_mut().for_each([](std::pair<SlabKey, Box<int>&> kv) { *kv.second += 1; });
+        slab.retain([](SlabKey, Box<int>& v) { return *v % 2 == 0; });
+        slab.iter().for_each([&](std::pair<SlabKey, const Box<int>&> kv) {
+            assert(*kv.second % 2 == 0 && *kv.second == model[kv.first.to_bits()] + 1);
+        });
+    }
+    printf("PASS\n");
+}
+
+// Test a doubly linked graph held together by keys, clone, and drops
+void test_slab_graph() {
+    printf("test_slab_graph: ");
+    {
+        struct Node {
+            Counted payload;
+            SlabKey prev;
+            SlabKey next;
+            explicit Node(int v) : payload(v) {}
+        };
+        {
+            Slab<Node> nodes;
+            SlabKey head = nodes.emplace(0);
+            SlabKey tail = head;
+            for (int i = 1; i < 100; i++) {
+                SlabKey k = nodes.emplace(i);
+                nodes[k].prev = tail;
+                nodes[tail].next = k;
+                tail = k;
+            }
+            assert(live == 100);
+
+            // Unlink every odd node
+            for (SlabKey k = head; !k.is_null();) {
+                SlabKey next = nodes[k].next;
+                if (nodes[k].payload.value % 2) {
+                    Node& n = nodes[k];
+                    if (!n.prev.is_null()) nodes[n.prev].next = n.next;
+                    if (!n.next.is_null()) nodes[n.next].prev = n.prev;
+                    nodes.remove(k);
+                }
+                k = next;
+            }
+            assert(nodes.len() == 50 && live == 50);
+
+            Slab<Node> copy = nodes.clone();
+            assert(live == 100);
+            int expect = 0;
+            for (SlabKey k = head; !k.is_null(); k = copy[k].next) {
+                assert(copy[k].payload.value == expect);
+                expect += 2;
+            }
+            assert(expect == 100);
+            SlabKey fresh = copy.emplace(7);
+            assert(nodes.emplace(8) == fresh);  // Same free list in both
+
+            Slab<Node> moved = std::move(nodes);
+            assert(nodes.is_empty() && moved.len() == 51);
+        }
+        assert(live == 0);
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::Slab ===\n");
+
+    test_slab_basic();
+    test_slab_model();
+    test_slab_graph();
+
+    printf("\nAll Slab tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,199 @@
+// Tests for rusty::BoxSlice, RcSlice, ArcSlice and ArcStr
+#include "../include/rusty/slice_ptr.hpp"
+#include "../include/rusty/alloc_observer.hpp"
+#include "../include/rusty/hashmap.hpp"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace rusty;
+
+struct Tracked {
+    static int instances;
+    static int copies;
+    int value;
+
+    explicit Tracked(int v) : value(v) { instances++; }
+    Tracked(const Tracked& other) : value(other.value) { instances++; copies++; }
+    Tracked(Tracked&& other) noexcept : value(other.value) { instances++; }
+    Tracked& operator=(const Tracked&) = default;
+    Tracked& operator=(Tracked&&) = default;
+    ~Tracked() { instances--; }
+    bool operator==(const Tracked& other) const { return value == other.value; }
+};
+
+int Tracked::instances = 0;
+int Tracked::copies = 0;
+
+// Counts allocations by kind
+struct KindCounter : AllocObserver {
+    long allocs[ALLOC_KINDS] = {};
+    long live[ALLOC_KINDS] = {};
+
+    void on_alloc(const AllocEvent& event) override {
+        allocs[static_cast<size_t>(event.kind)]++;
+        live[static_cast<size_t>(event.kind)]++;
+    }
+
+    void on_dealloc(const AllocEvent& event) override {
+        live[static_cast<size_t>(event.kind)]--;
+    }
+};
+
+// BoxSlice keeps the Vec's buffer, and gives it back
+void test_box_slice() {
+    printf("test_box_slice: ");
+    {
+        Vec<int> v = Vec<int>::with_capacity(16);
+        for (int i = 0; i < 10; i++) v.push(i);
+        BoxSlice<int> b = BoxSlice<int>::from_vec(std::move(v));
+        assert(b.len() == 10 && b[9] == 9 && v.is_empty());
+        b[0] = 100;
+        int sum = 0;
+        for (int x : b) sum += x;
+        assert(sum == 100 + 45 - 0);
+
+        // No spare capacity: the buffer is reused as is
+        Vec<int> exact = Vec<int>::with_capacity(3);
+        exact.push(1);
+        exact.push(2);
+        exact.push(3);
+        const int* buffer = exact.as_ptr();
+        BoxSlice<int> same = BoxSlice<int>::from_vec(std::move(exact));
+        assert(same.as_slice().as_ptr() == buffer);
+        Vec<int> back = same.into_vec();
+        assert(back.as_ptr() == buffer && back.len() == 3 && back.capacity() == 3 && same.is_empty());
+
+        BoxSlice<int> copy = b.clone();
+        assert(copy.as_slice() == b.as_slice() && copy.as_slice().as_ptr() != b.as_slice().as_ptr());
+        BoxSlice<int> empty = BoxSlice<int>::from_vec(Vec<int>());
+        assert(empty.is_empty());
+        empty = std::move(copy);
+        assert(empty.len() == 10 && copy.is_empty());
+    }
+    {
+        Vec<Tracked> v;
+        for (int i = 0; i < 5; i++) v.push(Tracked(i));
+        BoxSlice<Tracked> b = BoxSlice<Tracked>::from_vec(std::move(v));
+        assert(Tracked::instances == 5 && b[4].value == 4);
+    }
+    assert(Tracked::instances == 0);
+    printf("PASS\n");
+}
+
+// One allocation per shared slice, and the elements are relocated, not copied
+void test_rc_slice() {
+    printf("test_rc_slice: ");
+    KindCounter counter;
+    set_alloc_observer(&counter);
+    {
+        Vec<Tracked> v;
+        for (int i = 0; i < 8; i++) v.push(Tracked(i));
+        int copies = Tracked::copies;
+        RcSlice<Tracked> a = RcSlice<Tracked>::from_vec(std::move(v));
+        assert(Tracked::copies == copies && Tracked::instances == 8);
+        assert(counter.allocs[static_cast<size_t>(AllocKind::Rc)] == 1);
+        assert(counter.live[static_cast<size_t>(AllocKind::Vec)] == 0);
+
+        RcSlice<Tracked> b = a.clone();
+        RcSlice<Tracked> c = b;
+        assert(a.strong_count() == 3 && RcSlice<Tracked>::ptr_eq(a, c));
+        assert(&a[3] == &c[3] && c.len() == 8 && c[7].value == 7);
+        assert(counter.allocs[static_cast<size_t>(AllocKind::Rc)] == 1);
+
+        a = RcSlice<Tracked>();
+        b = std::move(c);
+        assert(b.strong_count() == 1 && c.is_empty() && Tracked::instances == 8);
+
+        RcSlice<Tracked> copy = RcSlice<Tracked>::copy_from_slice(b.as_slice());
+        assert(copy == b && !RcSlice<Tracked>::ptr_eq(copy, b) && Tracked::instances == 16);
+    }
+    assert(Tracked::instances == 0);
+    assert(counter.live[static_cast<size_t>(AllocKind::Rc)] == 0);
+    {
+        RcSlice<int> empty = RcSlice<int>::copy_from_slice(Slice<int>());
+        assert(empty.is_empty() && empty.strong_count() == 0 && empty.begin() == empty.end());
+    }
+    set_alloc_observer(nullptr);
+    printf("PASS\n");
+}
+
+// One payload fanned out to many consumer threads
+void test_arc_slice_fan_out() {
+    printf("test_arc_slice_fan_out: ");
+    static_assert(is_send<ArcSlice<int>>::value && is_sync<ArcSlice<int>>::value, "int is Send + Sync");
+    static_assert(!is_send<RcSlice<int>>::value, "RcSlice stays on its thread");
+    static_assert(!is_send<ArcSlice<RcSlice<int>>>::value, "an Rc element is not Send");
+    static_assert(sizeof(ArcSlice<int>) == sizeof(void*), "one pointer");
+    {
+        Vec<uint64_t> payload;
+        for (uint64_t i = 0; i < 4096; i++) payload.push(i * i);
+        ArcSlice<uint64_t> shared = ArcSlice<uint64_t>::from_vec(std::move(payload));
+        assert(reinterpret_cast<uintptr_t>(shared.as_ptr()) % alignof(uint64_t) == 0);
+
+        std::vector<std::thread> consumers;
+        std::vector<uint64_t> sums(8);
+        for (size_t t = 0; t < 8; t++) {
+            ArcSlice<uint64_t> mine = shared.clone();
+            consumers.emplace_back([mine, t, &sums]() mutable {
+                uint64_t sum = 0;
+                for (uint64_t x : mine) sum += x;
+                sums[t] = sum;
+                mine = ArcSlice<uint64_t>();
+            });
+        }
+        for (auto& c : consumers) c.join();
+        for (uint64_t s : sums) assert(s == sums[0] && s != 0);
+        assert(shared.strong_count() == 1);
+    }
+    {
+        // Alignment of over-aligned elements
+        struct alignas(32) Wide { double d[4]; };
+        const Wide w = {{1, 2, 3, 4}};
+        Vec<Wide> v;
+        v.resize(1, w);
+        ArcSlice<Wide> wide = ArcSlice<Wide>::from_vec(std::move(v));
+        assert(reinterpret_cast<uintptr_t>(wide.as_ptr()) % 32 == 0 && wide[0].d[3] == 4);
+    }
+    printf("PASS\n");
+}
+
+void test_arc_str() {
+    printf("test_arc_str: ");
+    {
+        ArcStr name = ArcStr::from(String::from("orders.eu-west"));
+        ArcStr other = name.clone();
+        assert(name.len() == 14 && name.as_str() == "orders.eu-west");
+        assert(std::strcmp(name.c_str(), "orders.eu-west") == 0);
+        assert(ArcStr::ptr_eq(name, other) && name.strong_count() == 2);
+        assert(name == str("orders.eu-west") && name == ArcStr::from("orders.eu-west"));
+        assert(name != ArcStr::from("orders"));
+
+        ArcStr empty = ArcStr::from("");
+        assert(empty.is_empty() && empty.len() == 0 && empty.c_str()[0] == '\0' && empty == ArcStr());
+
+        // Queried by str without building an ArcStr
+        HashMap<ArcStr, int, StringHash, StringEq> topics;
+        topics.insert(name.clone(), 1);
+        topics.insert(ArcStr::from("metrics"), 2);
+        assert(topics.get(str("metrics")).unwrap() == 2);
+        assert(topics.get(name).unwrap() == 1);
+        assert(name.to_string() == "orders.eu-west");
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::BoxSlice / RcSlice / ArcSlice / ArcStr ===\n");
+
+    test_box_slice();
+    test_rc_slice();
+    test_arc_slice_fan_out();
+    test_arc_str();
+
+    printf("\nAll slice pointer tests passed!\n");
+    return 0;
+}
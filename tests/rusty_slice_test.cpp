@@ -0,0 +1,193 @@
+// Tests for rusty::Slice<T> and rusty::SliceMut<T>
+#include "../include/rusty/slice.hpp"
+#include "../include/rusty/vec.hpp"
+#include "../include/rusty/smallvec.hpp"
+#include <cassert>
+#include <cstdio>
+#include <thread>
+
+using namespace rusty;
+
+// Test element access and sub-slicing
+void test_slice_basic() {
+    printf("test_slice_basic: ");
+    {
+        Vec<int> v = {1, 2, 3, 4, 5};
+        Slice<int> s = v.as_slice();
+        assert(s.len() == 5);
+        assert(s[0] == 1 && s[4] == 5);
+        assert(s.get(4).unwrap() == 5);
+        assert(s.get(5).is_none());
+        assert(s.first().unwrap() == 1);
+        assert(s.last().unwrap() == 5);
+
+        Slice<int> mid = s.slice(1, 4);
+        assert(mid.len() == 3 && mid[0] == 2 && mid[2] == 4);
+        assert(s.slice(5, 5).is_empty());
+        assert(Slice<int>().last().is_none());
+
+        auto halves = s.split_at(2);
+        assert(halves.first.len() == 2 && halves.second.len() == 3);
+        assert(halves.second[0] == 3);
+
+        int arr[] = {1, 2};
+        assert(s.starts_with(arr));
+        int tail[] = {4, 5};
+        assert(s.ends_with(tail));
+        assert(!s.ends_with(arr));
+        assert(s.contains(3) && !s.contains(9));
+        assert(mid == v.as_slice().slice(1, 4));
+
+        int sum = 0;
+        for (int x : s) sum += x;
+        assert(sum == 15);
+
+        auto it = s.iter();
+        assert(it.next().unwrap() == 1);
+        assert(it.next_back().unwrap() == 5);
+        assert(it.len() == 3);
+    }
+    printf("PASS\n");
+}
+
+// Test chunks() and windows()
+void test_slice_chunks_windows() {
+    printf("test_slice_chunks_windows: ");
+    {
+        int data[] = {0, 1, 2, 3, 4, 5, 6};
+        Slice<int> s(data);
+
+        size_t count = 0;
+        size_t total = 0;
+        for (Slice<int> chunk : s.chunks(3)) {
+            assert(chunk[0] == static_cast<int>(count * 3));
+            total += chunk.len();
+            count++;
+        }
+        assert(count == 3 && total == 7);
+
+        auto chunks = s.chunks(3);
+        chunks.next();
+        chunks.next();
+        assert(chunks.next().unwrap().len() == 1);
+        assert(chunks.next().is_none());
+
+        count = 0;
+        for (Slice<int> w : s.windows(3)) {
+            assert(w.len() == 3);
+            assert(w[0] + 1 == w[1] && w[1] + 1 == w[2]);
+            count++;
+        }
+        assert(count == 5);
+        assert(s.windows(8).next().is_none());
+        assert(Slice<int>().chunks(2).next().is_none());
+    }
+    printf("PASS\n");
+}
+
+// Test binary_search and partition_point
+void test_slice_binary_search() {
+    printf("test_slice_binary_search: ");
+    {
+        Vec<int> v = {1, 3, 5, 7, 9};
+        Slice<int> s = v.as_slice();
+        assert(s.binary_search(7).unwrap() == 3);
+        assert(s.binary_search(1).unwrap() == 0);
+        assert(s.binary_search(4).unwrap_err() == 2);
+        assert(s.binary_search(0).unwrap_err() == 0);
+        assert(s.binary_search(10).unwrap_err() == 5);
+        assert(Slice<int>().binary_search(1).unwrap_err() == 0);
+
+        assert(s.partition_point([](int x) { return x < 6; }) == 3);
+
+        struct Entry { int key; const char* name; };
+        Entry entries[] = {{1, "a"}, {4, "b"}, {9, "c"}};
+        Slice<Entry> es(entries);
+        auto found = es.binary_search_by_key(4, [](const Entry& e) { return e.key; });
+        assert(found.unwrap() == 1);
+        assert(es.binary_search_by([](const Entry& e) { return e.key - 5; }).unwrap_err() == 2);
+    }
+    printf("PASS\n");
+}
+
+// Test mutation through SliceMut
+void test_slice_mut() {
+    printf("test_slice_mut: ");
+    {
+        Vec<int> v = {5, 2, 4, 1, 3};
+        {
+            SliceMut<int> m = v.as_mut_slice();
+            m[0] = 6;
+            m.get_mut(1).unwrap() = 7;
+            assert(m.get_mut(5).is_none());
+            m.sort_unstable();
+            Slice<int> shared = m;
+            assert(shared == Slice<int>(v.as_ptr(), 5));
+        }
+        assert(v[0] == 1 && v[1] == 3 && v[2] == 4 && v[3] == 6 && v[4] == 7);
+
+        SliceMut<int> m = v.as_mut_slice();
+        m.sort_unstable_by([](int a, int b) { return a > b; });
+        assert(v[0] == 7 && v[4] == 1);
+        m.reverse();
+        assert(v[0] == 1 && v[4] == 7);
+        m.swap(0, 4);
+        assert(v[0] == 7 && v[4] == 1);
+
+        auto halves = m.split_at_mut(2);
+        halves.first.fill(0);
+        int src[] = {8, 8, 8};
+        halves.second.copy_from_slice(src);
+        assert(v[0] == 0 && v[1] == 0 && v[2] == 8 && v[4] == 8);
+
+        // Moving a SliceMut leaves the source empty
+        SliceMut<int> moved = std::move(m);
+        assert(m.is_empty() && moved.len() == 5);
+        moved.reborrow().slice_mut(1, 3).fill(2);
+        assert(v[1] == 2 && v[2] == 2 && v[3] == 8);
+
+        SmallVec<int, 4> sv = {3, 1, 2};
+        sv.as_mut_slice().sort_unstable();
+        assert(sv.as_slice().binary_search(2).unwrap() == 1);
+
+        Vec<int> w;
+        w.extend_from_slice(sv.as_slice());
+        assert(w.len() == 3 && w[2] == 3);
+    }
+    printf("PASS\n");
+}
+
+// Test that disjoint chunks can be mutated from different threads
+void test_slice_chunks_mut_threads() {
+    printf("test_slice_chunks_mut_threads: ");
+    {
+        Vec<int> v;
+        v.resize(1000, 0);
+        Vec<std::thread> threads;
+        int id = 0;
+        for (SliceMut<int>& chunk : v.as_mut_slice().chunks_mut(250)) {
+            threads.push(std::thread([id](SliceMut<int> part) {
+                part.fill(id);
+            }, std::move(chunk)));
+            id++;
+        }
+        for (std::thread& t : threads) t.join();
+        for (size_t i = 0; i < v.len(); i++) {
+            assert(v[i] == static_cast<int>(i / 250));
+        }
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::Slice ===\n");
+
+    test_slice_basic();
+    test_slice_chunks_windows();
+    test_slice_binary_search();
+    test_slice_mut();
+    test_slice_chunks_mut_threads();
+
+    printf("\nAll slice tests passed!\n");
+    return 0;
+}
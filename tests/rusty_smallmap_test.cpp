@@ -0,0 +1,149 @@
+// Tests for rusty::SmallMap<K, V, N>
+#include "../include/rusty/smallmap.hpp"
+#include <cassert>
+#include <cstdio>
+#include <string>
+
+using namespace rusty;
+
+// Counts the blocks it hands out
+struct CountingAlloc {
+    long* allocs;
+
+    CountingAlloc() : allocs(nullptr) {}
+    explicit CountingAlloc(long* a) : allocs(a) {}
+
+    void* allocate(size_t size, size_t align) {
+        (*allocs)++;
+        return Global().allocate(size, align);
+    }
+
+    void deallocate(void* ptr, size_t size, size_t align) {
+        Global().deallocate(ptr, size, align);
+    }
+};
+
+struct Tracked {
+    static int instances;
+    int value;
+
+    explicit Tracked(int v) : value(v) { instances++; }
+    Tracked(const Tracked& other) : value(other.value) { instances++; }
+    Tracked(Tracked&& other) noexcept : value(other.value) { instances++; }
+    Tracked& operator=(const Tracked&) = default;
+    Tracked& operator=(Tracked&&) = default;
+    ~Tracked() { instances--; }
+};
+
+int Tracked::instances = 0;
+
+using CountedMap = SmallMap<int, int, 4, FxHash<int>, std::equal_to<int>, CountingAlloc>;
+
+// Up to N entries stay inline without allocating; the next one spills
+void test_smallmap_inline_then_spill() {
+    printf("test_smallmap_inline_then_spill: ");
+    long allocs = 0;
+    {
+        auto map = CountedMap::new_in(CountingAlloc(&allocs));
+        for (int i = 0; i < 4; i++) map.insert(i, i * 10);
+        map.insert(2, 21);
+        assert(map.len() == 4 && !map.spilled());
+        assert(map.get(2).unwrap() == 21 && map.get(7).is_none());
+        assert(allocs == 0);
+
+        map.insert(4, 40);
+        assert(map.spilled() && allocs == 1);
+        for (int i = 5; i < 100; i++) map.insert(i, i * 10);
+        assert(map.len() == 100);
+        assert(map.get(2).unwrap() == 21 && map.get(99).unwrap() == 990);
+
+        // Emptying does not move entries back inline
+        map.clear();
+        assert(map.is_empty() && map.spilled());
+        map.insert(1, 1);
+        assert(map.get(1).unwrap() == 1);
+    }
+    printf("PASS\n");
+}
+
+void test_smallmap_remove_and_retain() {
+    printf("test_smallmap_remove_and_retain: ");
+    {
+        SmallMap<std::string, int, 4> map;
+        map.insert("a", 1);
+        map.insert("b", 2);
+        map.insert("c", 3);
+        assert(map.remove("a").unwrap() == 1);
+        assert(map.remove("a").is_none());
+        assert(map.len() == 2 && map.get("c").unwrap() == 3);
+
+        map.or_insert("d", 4) += 10;
+        assert(map.or_insert("d", 0) == 14);
+        map.retain([](const std::string& k, int&) { return k != "b"; });
+        assert(map.len() == 2 && !map.contains_key("b"));
+
+        int sum = 0;
+        map.for_each_mut([](const std::string&, int& v) { v *= 2; });
+        map.for_each([&](const std::string&, const int& v) { sum += v; });
+        assert(sum == 2 * (3 + 14));
+
+        // The same operations once spilled
+        for (int i = 0; i < 10; i++) map.insert(std::to_string(i), i);
+        assert(map.spilled() && map.len() == 12);
+        assert(map.remove("5").unwrap() == 5);
+        map.retain([](const std::string& k, int&) { return k.size() == 1 && k[0] <= '4'; });
+        sum = 0;
+        map.for_each([&](const std::string&, const int& v) { sum += v; });
+        assert(map.len() == 5 && sum == 0 + 1 + 2 + 3 + 4);
+        assert(map.or_insert("z", 26) == 26);
+    }
+    printf("PASS\n");
+}
+
+void test_smallmap_move_clone() {
+    printf("test_smallmap_move_clone: ");
+    {
+        SmallMap<int, Tracked, 2> a;
+        a.insert(1, Tracked(1));
+        a.insert(2, Tracked(2));
+        SmallMap<int, Tracked, 2> b(std::move(a));
+        assert(a.is_empty() && b.len() == 2 && b.get(2).unwrap().value == 2);
+
+        auto c = b.clone();
+        assert(!c.spilled() && c.get(1).unwrap().value == 1);
+        c.insert(3, Tracked(3));
+        assert(c.spilled() && b.len() == 2);
+
+        b = std::move(c);
+        assert(b.spilled() && b.len() == 3 && c.is_empty() && !c.spilled());
+        auto d = b.clone();
+        assert(d.spilled() && d.get(3).unwrap().value == 3);
+        d.remove(1);
+        assert(b.contains_key(1));
+
+        // Move-only values are cloned with their clone(), inline or spilled
+        SmallMap<int, Vec<int>, 2> lists;
+        lists.insert(1, vec_of({1, 2}));
+        auto inline_copy = lists.clone();
+        lists.insert(2, vec_of({3}));
+        lists.insert(3, vec_of({4}));
+        auto spilled_copy = lists.clone();
+        lists.get_mut(1).unwrap().push(9);
+        assert(!inline_copy.spilled() && inline_copy.get(1).unwrap().len() == 2);
+        assert(spilled_copy.spilled() && spilled_copy.get(1).unwrap().len() == 2);
+        assert(spilled_copy.get(3).unwrap()[0] == 4);
+    }
+    assert(Tracked::instances == 0);
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::SmallMap<K, V, N> ===\n");
+
+    test_smallmap_inline_then_spill();
+    test_smallmap_remove_and_retain();
+    test_smallmap_move_clone();
+
+    printf("\nAll SmallMap tests passed!\n");
+    return 0;
+}
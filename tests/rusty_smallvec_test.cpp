@@ -0,0 +1,143 @@
+// Tests for rusty::SmallVec<T, N>
+#include "../include/rusty/smallvec.hpp"
+#include "../include/rusty/box.hpp"
+#include "../include/rusty/vec.hpp"
+#include <cassert>
+#include <cstdio>
+#include <string>
+
+using namespace rusty;
+
+struct Tracked {
+    static int instances;
+    int value;
+
+    explicit Tracked(int v) : value(v) { instances++; }
+    Tracked(const Tracked& other) : value(other.value) { instances++; }
+    Tracked(Tracked&& other) noexcept : value(other.value) { instances++; }
+    ~Tracked() { instances--; }
+};
+
+int Tracked::instances = 0;
+
+// Test that small contents stay inline and larger ones spill
+void test_smallvec_inline_then_spill() {
+    printf("test_smallvec_inline_then_spill: ");
+    {
+        auto v = SmallVec<int, 4>::new_();
+        assert(v.cap() == 4 && !v.spilled());
+        for (int i = 0; i < 4; i++) v.push(i);
+        assert(!v.spilled());
+
+        v.push(4);
+        assert(v.spilled());
+        assert(v.cap() == 8);
+        for (int i = 0; i < 100; i++) v.push(i + 5);
+        for (int i = 0; i < 105; i++) assert(v[i] == i);
+        assert(v.len() == 105);
+
+        // Shrinking does not move elements back inline
+        v.clear();
+        assert(v.is_empty() && v.spilled());
+
+        auto reserved = SmallVec<int, 8>::with_capacity(8);
+        assert(!reserved.spilled());
+        auto big = SmallVec<int, 8>::with_capacity(9);
+        assert(big.spilled() && big.cap() >= 9);
+    }
+    printf("PASS\n");
+}
+
+// Test moves of inline and spilled contents
+void test_smallvec_move() {
+    printf("test_smallvec_move: ");
+    {
+        SmallVec<std::string, 2> a{"one", "two"};
+        assert(!a.spilled());
+        auto b = std::move(a);
+        assert(a.is_empty() && !a.spilled());
+        assert(b.len() == 2 && b[1] == "two");
+
+        b.push("three");
+        assert(b.spilled());
+        const std::string* heap = b.begin();
+        SmallVec<std::string, 2> c;
+        c = std::move(b);
+        // A spilled buffer is handed over, not copied
+        assert(c.begin() == heap);
+        assert(c.len() == 3 && c.back() == "three");
+        assert(b.is_empty() && !b.spilled());
+
+        assert(c.pop() == "three");
+        assert(c.front() == "one");
+    }
+    printf("PASS\n");
+}
+
+// Test element lifetimes and non-relocatable element types
+void test_smallvec_destructor() {
+    printf("test_smallvec_destructor: ");
+    Tracked::instances = 0;
+    {
+        SmallVec<Tracked, 3> v;
+        for (int i = 0; i < 10; i++) v.push(Tracked(i));
+        assert(Tracked::instances == 10);
+
+        SmallVec<Tracked, 3> inl;
+        inl.push(Tracked(1));
+        SmallVec<Tracked, 3> moved(std::move(inl));
+        assert(Tracked::instances == 11);
+        assert(moved[0].value == 1);
+
+        auto copy = v.clone();
+        assert(Tracked::instances == 21);
+        assert(copy[9].value == 9);
+    }
+    assert(Tracked::instances == 0);
+
+    {
+        SmallVec<Box<int>, 2> boxes;
+        for (int i = 0; i < 20; i++) boxes.push(Box<int>::new_(i));
+        int sum = 0;
+        for (auto& b : boxes) sum += *b;
+        assert(sum == 190);
+    }
+    printf("PASS\n");
+}
+
+// Test comparison and clone
+void test_smallvec_clone_eq() {
+    printf("test_smallvec_clone_eq: ");
+    {
+        SmallVec<int, 4> a{1, 2, 3};
+        auto b = a.clone();
+        assert(a == b);
+        b.push(4);
+        assert(a != b);
+        assert((SmallVec<int, 4>::inline_size() == 4));
+
+        // Move-only elements are cloned with their clone(), inline or spilled
+        SmallVec<Vec<int>, 2> rows;
+        rows.push(vec_of({1}));
+        auto inline_copy = rows.clone();
+        rows.push(vec_of({2, 3}));
+        rows.push(vec_of({4}));
+        auto spilled_copy = rows.clone();
+        rows[1].push(5);
+        assert(inline_copy.len() == 1 && inline_copy[0][0] == 1);
+        assert(spilled_copy.len() == 3 && spilled_copy[1].len() == 2 && spilled_copy[2][0] == 4);
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::SmallVec<T, N> ===\n");
+
+    test_smallvec_inline_then_spill();
+    test_smallvec_move();
+    test_smallvec_destructor();
+    test_smallvec_clone_eq();
+
+    printf("\nAll SmallVec tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,151 @@
+// Tests for rusty::SoaVec<Ts...>
+#include "../include/rusty/soavec.hpp"
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+using namespace rusty;
+
+struct Tracked {
+    static int instances;
+    int value;
+
+    explicit Tracked(int v) : value(v) { instances++; }
+    Tracked(const Tracked& other) : value(other.value) { instances++; }
+    Tracked(Tracked&& other) noexcept : value(other.value) { instances++; }
+    Tracked& operator=(const Tracked&) = default;
+    Tracked& operator=(Tracked&&) = default;
+    ~Tracked() { instances--; }
+};
+
+int Tracked::instances = 0;
+
+// Columns are contiguous, start on their own cache line, and a scan of one
+// reads back what was pushed
+void test_soavec_columns() {
+    printf("test_soavec_columns: ");
+    {
+        SoaVec<uint64_t, double, uint8_t> trades;
+        for (int i = 0; i < 1000; i++) {
+            trades.push(static_cast<uint64_t>(i), i * 0.5, static_cast<uint8_t>(i % 7));
+        }
+        assert(trades.len() == 1000 && trades.capacity() >= 1000);
+
+        Slice<uint64_t> ids = trades.column<0>();
+        Slice<double> prices = trades.column<1>();
+        Slice<uint8_t> venues = trades.column<2>();
+        assert(ids.len() == 1000 && prices.len() == 1000 && venues.len() == 1000);
+        assert(reinterpret_cast<uintptr_t>(ids.as_ptr()) % 64 == 0);
+        assert(reinterpret_cast<uintptr_t>(prices.as_ptr()) % 64 == 0);
+        assert(reinterpret_cast<uintptr_t>(venues.as_ptr()) % 64 == 0);
+        assert(prices.as_ptr() + 1 == &trades[1].get<1>());
+
+        double total = 0;
+        for (double p : prices) total += p;
+        assert(total == 0.5 * 999 * 1000 / 2);
+        for (size_t i = 0; i < 1000; i++) assert(venues[i] == i % 7);
+
+        // Mutating one column leaves the others alone
+        auto doubled = trades.column_mut<1>();
+        for (size_t i = 0; i < doubled.len(); i++) doubled[i] *= 2;
+        assert(trades[10].get<1>() == 10.0 && trades[10].get<0>() == 10);
+
+        SoaVec<int, char> empty;
+        assert(empty.column<0>().is_empty() && empty.capacity() == 0);
+    }
+    printf("PASS\n");
+}
+
+void test_soavec_rows() {
+    printf("test_soavec_rows: ");
+    {
+        SoaVec<int, std::string> v;
+        v.push(1, "one");
+        v.push(2, "two");
+        v.push(3, "three");
+
+        v[1].set(20, "twenty");
+        v.row(2).get<0>() += 30;
+        assert(v[1].get<1>() == "twenty" && v[2].get<0>() == 33);
+        assert(v[0].to_tuple() == std::make_tuple(1, std::string("one")));
+
+        const SoaVec<int, std::string>& view = v;
+        assert(view[2].get<1>() == "three" && view.row(0).index() == 0);
+
+        int sum = 0;
+        v.for_each_mut([](int& n, std::string& s) { n += static_cast<int>(s.size()); });
+        v.for_each([&](const int& n, const std::string&) { sum += n; });
+        assert(sum == (1 + 3) + (20 + 6) + (33 + 5));
+
+        auto last = v.pop();
+        assert(std::get<0>(last) == 38 && std::get<1>(last) == "three" && v.len() == 2);
+        auto first = v.swap_remove(0);
+        assert(std::get<1>(first) == "one" && v.len() == 1 && v[0].get<1>() == "twenty");
+    }
+    printf("PASS\n");
+}
+
+// Growth, moves, truncate and clone run every field's destructor once
+void test_soavec_ownership() {
+    printf("test_soavec_ownership: ");
+    {
+        SoaVec<Tracked, int, Tracked> v;
+        for (int i = 0; i < 100; i++) v.push(Tracked(i), i, Tracked(-i));
+        assert(Tracked::instances == 200);
+
+        auto copy = v.clone();
+        assert(Tracked::instances == 400 && copy[99].get<2>().value == -99);
+
+        SoaVec<Tracked, int, Tracked> moved(std::move(v));
+        assert(v.is_empty() && v.capacity() == 0 && moved.len() == 100);
+        moved.truncate(10);
+        assert(Tracked::instances == 220);
+        moved.swap_remove(3);
+        assert(moved.len() == 9 && moved[3].get<0>().value == 9 && moved[3].get<1>() == 9);
+
+        copy = std::move(moved);
+        assert(Tracked::instances == 18 && copy.len() == 9);
+
+        SoaVec<int, double> plain;
+        for (int i = 0; i < 50; i++) plain.push(i, i * 2.0);
+        auto plain_copy = plain.clone();
+        assert(plain_copy.len() == 50 && plain_copy[49].get<1>() == 98.0);
+        plain.clear();
+        assert(plain.is_empty() && plain_copy.column<0>()[7] == 7);
+    }
+    assert(Tracked::instances == 0);
+    printf("PASS\n");
+}
+
+void test_soavec_reserve() {
+    printf("test_soavec_reserve: ");
+    {
+        auto v = SoaVec<int, int>::with_capacity(100);
+        assert(v.capacity() == 100);
+        const int* before = v.column<0>().as_ptr();
+        for (int i = 0; i < 100; i++) v.push(i, -i);
+        assert(v.column<0>().as_ptr() == before);
+        v.push(100, -100);
+        assert(v.capacity() == 200 && v[50].get<1>() == -50);
+
+        auto huge = SoaVec<int, int>::try_with_capacity(SIZE_MAX / 4);
+        assert(huge.is_err());
+        assert(v.try_reserve(SIZE_MAX / 2).is_err() && v.len() == 101);
+        assert(v.try_push(1, 2).is_ok() && v.len() == 102);
+    }
+    static_assert(is_send<SoaVec<int, double>>::value, "fields are Send");
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::SoaVec<Ts...> ===\n");
+
+    test_soavec_columns();
+    test_soavec_rows();
+    test_soavec_ownership();
+    test_soavec_reserve();
+
+    printf("\nAll SoaVec tests passed!\n");
+    return 0;
+}
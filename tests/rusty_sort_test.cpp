@@ -0,0 +1,210 @@
+// Tests for the sort methods of rusty::Vec and rusty::SliceMut
+#include "../include/rusty/vec.hpp"
+#include "../include/rusty/box.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+using namespace rusty;
+
+static uint64_t rng_state = 88172645463325252ull;
+
+static uint64_t next_random() {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+// Inputs that trip up quicksorts and merge sorts
+static Vec<int> make_pattern(int pattern, size_t n) {
+    Vec<int> v;
+    for (size_t i = 0; i < n; i++) {
+        int x = 0;
+        switch (pattern) {
+            case 0: x = static_cast<int>(next_random()); break;       // random
+            case 1: x = static_cast<int>(i); break;                   // sorted
+            case 2: x = static_cast<int>(n - i); break;               // reversed
+            case 3: x = 7; break;                                     // all equal
+            case 4: x = static_cast<int>(next_random() % 4); break;   // few unique
+            case 5: x = static_cast<int>(i < n / 2 ? i : n - i); break;  // organ pipe
+            case 6: x = static_cast<int>(i % 16 == 0 ? next_random() % 100 : i); break;
+        }
+        v.push(x);
+    }
+    return v;
+}
+
+static bool matches_std(const Vec<int>& sorted, const Vec<int>& original) {
+    std::vector<int> expected(original.begin(), original.end());
+    std::sort(expected.begin(), expected.end());
+    for (size_t i = 0; i < sorted.len(); i++) {
+        if (sorted[i] != expected[i]) return false;
+    }
+    return sorted.len() == expected.size();
+}
+
+// Test sort_unstable and sort against std::sort over sizes and patterns
+void test_sort_patterns() {
+    printf("test_sort_patterns: ");
+    {
+        size_t sizes[] = {0, 1, 2, 3, 19, 20, 21, 24, 25, 100, 129, 1000, 20000};
+        for (size_t n : sizes) {
+            for (int pattern = 0; pattern < 7; pattern++) {
+                Vec<int> original = make_pattern(pattern, n);
+                Vec<int> a = original.clone();
+                a.sort_unstable();
+                assert(matches_std(a, original));
+                Vec<int> b = original.clone();
+                b.sort();
+                assert(matches_std(b, original));
+                Vec<int> c = original.clone();
+                c.radix_sort();
+                assert(matches_std(c, original));
+            }
+        }
+
+        Vec<int> desc = make_pattern(0, 500);
+        desc.sort_unstable_by([](int a, int b) { return a > b; });
+        for (size_t i = 1; i < desc.len(); i++) assert(desc[i - 1] >= desc[i]);
+    }
+    printf("PASS\n");
+}
+
+struct Row {
+    int key;
+    int seq;
+};
+
+// Test that the stable sorts keep equal keys in their original order
+void test_sort_stable() {
+    printf("test_sort_stable: ");
+    {
+        for (size_t n : {10, 100, 5000}) {
+            Vec<Row> rows;
+            for (size_t i = 0; i < n; i++) {
+                rows.push(Row{static_cast<int>(next_random() % 10) - 5, static_cast<int>(i)});
+            }
+            Vec<Row> by_key = rows.clone();
+            by_key.sort_by_key([](const Row& r) { return r.key; });
+            Vec<Row> cached = rows.clone();
+            cached.sort_by_cached_key([](const Row& r) { return r.key; });
+            Vec<Row> radix = rows.clone();
+            radix.radix_sort_by_key([](const Row& r) { return r.key; });
+
+            for (size_t i = 1; i < n; i++) {
+                const Vec<Row>* sorted[] = {&by_key, &cached, &radix};
+                for (const Vec<Row>* v : sorted) {
+                    const Row& prev = (*v)[i - 1];
+                    const Row& cur = (*v)[i];
+                    assert(prev.key < cur.key || (prev.key == cur.key && prev.seq < cur.seq));
+                }
+            }
+        }
+
+        // Strictly descending input is reversed, equal runs stay put
+        Vec<Row> rows = {{3, 0}, {2, 1}, {1, 2}};
+        rows.sort_by([](const Row& a, const Row& b) { return a.key < b.key; });
+        assert(rows[0].seq == 2 && rows[2].seq == 0);
+    }
+    printf("PASS\n");
+}
+
+// Test that sort_by_cached_key calls the key once per element
+void test_sort_cached_key() {
+    printf("test_sort_cached_key: ");
+    {
+        Vec<int> v = make_pattern(0, 1000);
+        Vec<int> original = v.clone();
+        size_t calls = 0;
+        v.sort_by_cached_key([&calls](int x) {
+            calls++;
+            return x;
+        });
+        assert(calls == 1000);
+        assert(matches_std(v, original));
+    }
+    printf("PASS\n");
+}
+
+// Test radix sort over key widths and signedness
+void test_radix_sort() {
+    printf("test_radix_sort: ");
+    {
+        Vec<int64_t> wide;
+        for (int i = 0; i < 3000; i++) wide.push(static_cast<int64_t>(next_random()));
+        wide.push(INT64_MIN);
+        wide.push(INT64_MAX);
+        wide.push(0);
+        wide.push(-1);
+        wide.radix_sort();
+        for (size_t i = 1; i < wide.len(); i++) assert(wide[i - 1] <= wide[i]);
+        assert(wide[0] == INT64_MIN && wide[wide.len() - 1] == INT64_MAX);
+
+        Vec<uint8_t> bytes;
+        for (int i = 0; i < 1000; i++) bytes.push(static_cast<uint8_t>(next_random()));
+        bytes.radix_sort();
+        for (size_t i = 1; i < bytes.len(); i++) assert(bytes[i - 1] <= bytes[i]);
+
+        // Only the low byte differs: one pass is enough
+        Vec<uint32_t> narrow;
+        for (uint32_t i = 0; i < 200; i++) narrow.push(0x12345600u | ((i * 37) & 0xff));
+        narrow.radix_sort();
+        for (size_t i = 1; i < narrow.len(); i++) assert(narrow[i - 1] <= narrow[i]);
+    }
+    printf("PASS\n");
+}
+
+// Test sorting elements that own memory (checked by ASan for leaks)
+void test_sort_owning_elements() {
+    printf("test_sort_owning_elements: ");
+    {
+        Vec<Box<int>> boxes;
+        for (int i = 0; i < 3000; i++) {
+            boxes.push(Box<int>::make(static_cast<int>(next_random() % 1000)));
+        }
+        auto by_value = [](const Box<int>& a, const Box<int>& b) { return *a < *b; };
+        boxes.sort_unstable_by(by_value);
+        for (size_t i = 1; i < boxes.len(); i++) assert(*boxes[i - 1] <= *boxes[i]);
+        boxes.sort_by([](const Box<int>& a, const Box<int>& b) { return *a > *b; });
+        for (size_t i = 1; i < boxes.len(); i++) assert(*boxes[i - 1] >= *boxes[i]);
+        boxes.radix_sort_by_key([](const Box<int>& b) { return *b; });
+        for (size_t i = 1; i < boxes.len(); i++) assert(*boxes[i - 1] <= *boxes[i]);
+        boxes.sort_by_cached_key([](const Box<int>& b) { return -*b; });
+        for (size_t i = 1; i < boxes.len(); i++) assert(*boxes[i - 1] >= *boxes[i]);
+
+        // A throwing comparison leaks nothing from the scratch buffer
+        Vec<Box<int>> partial;
+        for (int i = 0; i < 100; i++) partial.push(Box<int>::make(100 - i % 7));
+        int budget = 400;
+        bool threw = false;
+        try {
+            partial.sort_by([&budget](const Box<int>& a, const Box<int>& b) {
+                if (--budget == 0) throw 1;
+                return *a < *b;
+            });
+        } catch (int) {
+            threw = true;
+        }
+        assert(threw);
+        assert(partial.len() == 100);
+
+        assert(Vec<int>({1, 4, 9}).binary_search(4).unwrap() == 1);
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty sorting ===\n");
+
+    test_sort_patterns();
+    test_sort_stable();
+    test_sort_cached_key();
+    test_radix_sort();
+    test_sort_owning_elements();
+
+    printf("\nAll sort tests passed!\n");
+    return 0;
+}
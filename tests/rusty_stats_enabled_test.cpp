@@ -0,0 +1,3 @@
+// Runs the stats tests with the RUSTY_STATS counters compiled in
+#define RUSTY_STATS
+#include "rusty_stats_test.cpp"
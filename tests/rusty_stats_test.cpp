@@ -0,0 +1,179 @@
+// Tests for container stats() and the stats registry
+#include "../include/rusty/stats.hpp"
+#include "../include/rusty/btreemap.hpp"
+#include "../include/rusty/hashmap.hpp"
+#include "../include/rusty/hashset.hpp"
+#include "../include/rusty/string.hpp"
+#include "../include/rusty/vec.hpp"
+#include <cassert>
+#include <cstdio>
+#include <string>
+
+using namespace rusty;
+
+// Every key lands on the same probe sequence
+struct ConstantHash {
+    size_t operator()(int) const { return 0x9e3779b97f4a7c15ULL; }
+};
+
+static std::string dump_to_string() {
+    std::FILE* f = std::tmpfile();
+    stats::dump(f);
+    std::rewind(f);
+    std::string out;
+    char buf[256];
+    while (std::fgets(buf, sizeof(buf), f)) out += buf;
+    std::fclose(f);
+    return out;
+}
+
+// Test HashMap load, tombstones and probe lengths
+void test_stats_hashmap() {
+    printf("test_stats_hashmap: ");
+    {
+        HashMap<int, int> map;
+        for (int i = 0; i < 1000; i++) map.insert(i, i);
+        stats::HashMapStats s = map.stats();
+        assert(s.len == 1000 && s.buckets == map.capacity());
+        assert(s.load_factor() > 0.4 && s.load_factor() <= 0.875);
+        assert(s.tombstones == 0 && s.tombstone_ratio() == 0.0);
+        assert(s.hit_probes.total() == 1000 && s.hit_probes.mean() >= 1.0);
+        assert(s.miss_probes.total() == s.buckets / GROUP_SIZE);
+        assert(s.growth_left + s.len <= s.buckets);
+        if (stats::ENABLED) {
+            assert(s.resizes > 0 && s.rehashes_in_place == 0);
+        } else {
+            assert(s.resizes == 0);
+        }
+
+        // Presized: no resizes
+        HashMap<int, int> sized = HashMap<int, int>::with_capacity(1000);
+        for (int i = 0; i < 1000; i++) sized.insert(i, i);
+        assert(sized.stats().resizes == 0);
+
+        // Erasing leaves tombstones only where groups were full
+        for (int i = 0; i < 1000; i += 2) map.remove(i);
+        s = map.stats();
+        assert(s.len == 500 && s.hit_probes.total() == 500);
+        assert(s.tombstones <= s.buckets - s.len);
+
+        // A degenerate hash shows up as long probes
+        HashMap<int, int, ConstantHash> bad;
+        for (int i = 0; i < 200; i++) bad.insert(i, i);
+        stats::HashMapStats b = bad.stats();
+        assert(b.hit_probes.max() == stats::ProbeHistogram::BUCKETS);
+        assert(b.hit_probes.mean() > map.stats().hit_probes.mean());
+
+        // Moved-from maps report no table
+        HashMap<int, int> taken = std::move(sized);
+        assert(sized.stats().buckets == 0 && taken.stats().len == 1000);
+
+        HashSet<int> set;
+        set.insert(1);
+        assert(set.stats().len == 1 && set.stats().hit_probes.total() == 1);
+    }
+    printf("PASS\n");
+}
+
+// Test Vec and String growth counters
+void test_stats_growth() {
+    printf("test_stats_growth: ");
+    {
+        uint64_t vec_before = stats::totals().vec.reallocations.load();
+        Vec<int> v;
+        for (int i = 0; i < 100; i++) v.push(i);
+        stats::GrowthStats s = v.stats();
+        assert(s.len == 100 && s.capacity == v.capacity());
+        if (stats::ENABLED) {
+            // 4 -> 8 -> ... -> 128
+            assert(s.reallocations == 5);
+            assert(s.bytes_copied <= (4 + 8 + 16 + 32 + 64) * sizeof(int));
+            assert(stats::totals().vec.reallocations.load() == vec_before + 5);
+        } else {
+            assert(s.reallocations == 0 && s.bytes_copied == 0);
+        }
+
+        // The counters move with the buffer
+        Vec<int> moved = std::move(v);
+        assert(moved.stats().reallocations == s.reallocations);
+
+        Vec<int> sized = Vec<int>::with_capacity(100);
+        for (int i = 0; i < 100; i++) sized.push(i);
+        assert(sized.stats().reallocations == 0);
+
+        String str;
+        for (int i = 0; i < 100; i++) str.push_str("0123456789");
+        stats::GrowthStats t = str.stats();
+        assert(t.len == 1000 && t.capacity >= 1000);
+        if (stats::ENABLED) {
+            // Inline -> 48 -> 96 -> ... -> 1536
+            assert(t.reallocations == 6 && t.bytes_copied > 0);
+        }
+
+        // Empty strings and strings built to size never reallocate
+        String big = String::with_capacity(1000);
+        big.push_str("x");
+        assert(big.stats().reallocations == 0);
+    }
+    printf("PASS\n");
+}
+
+// Test BTreeMap depth and node fill
+void test_stats_btreemap() {
+    printf("test_stats_btreemap: ");
+    {
+        BTreeMap<int, int> empty;
+        stats::BTreeStats e = empty.stats();
+        assert(e.len == 0 && e.depth == 1 && e.leaf_nodes == 1 && e.internal_nodes == 0);
+
+        BTreeMap<int, int> map;
+        for (int i = 0; i < 10000; i++) map.insert(i, i);
+        stats::BTreeStats s = map.stats();
+        assert(s.len == 10000 && s.leaf_keys == 10000);
+        assert(s.depth >= 3 && s.internal_nodes > 0);
+        assert((s.node_capacity == BTreeMap<int, int>::MAX_LEN));
+        assert(s.leaf_fill() > 0.4 && s.leaf_fill() <= 1.0);
+        assert(s.internal_fill() > 0.0 && s.internal_fill() <= 1.0);
+
+        // Removing most keys leaves far fewer leaves
+        for (int i = 0; i < 10000; i++) {
+            if (i % 10 != 0) map.remove(i);
+        }
+        stats::BTreeStats r = map.stats();
+        assert(r.len == 1000 && r.leaf_keys == 1000 && r.leaf_nodes < s.leaf_nodes);
+    }
+    printf("PASS\n");
+}
+
+// Test the named registry behind stats::dump
+void test_stats_registry() {
+    printf("test_stats_registry: ");
+    {
+        HashMap<int, int> sessions;
+        sessions.insert(1, 2);
+        Vec<int> queue;
+        {
+            stats::Tracked<HashMap<int, int>> a("sessions", sessions);
+            stats::Tracked<Vec<int>> b("queue", queue);
+            std::string out = dump_to_string();
+            assert(out.find("sessions: len=1 ") != std::string::npos);
+            assert(out.find("queue: len=0 capacity=0") != std::string::npos);
+            assert((out.find("totals: ") != std::string::npos) == stats::ENABLED);
+        }
+        std::string out = dump_to_string();
+        assert(out.find("sessions") == std::string::npos && out.find("queue") == std::string::npos);
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::stats%s ===\n", stats::ENABLED ? " (RUSTY_STATS)" : "");
+
+    test_stats_hashmap();
+    test_stats_growth();
+    test_stats_btreemap();
+    test_stats_registry();
+
+    printf("\nAll stats tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,3 @@
+// Runs the String tests on the portable SWAR search backend
+#define RUSTY_MEMCHR_SWAR
+#include "rusty_string_test.cpp"
@@ -0,0 +1,261 @@
+// Tests for rusty::String
+#include "../include/rusty/string.hpp"
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace rusty;
+
+// Allocator that counts live blocks in a shared counter
+struct CountingAlloc {
+    long* live;
+
+    CountingAlloc() : live(nullptr) {}
+    explicit CountingAlloc(long* l) : live(l) {}
+
+    void* allocate(size_t size, size_t align) {
+        ++*live;
+        return Global().allocate(size, align);
+    }
+
+    void deallocate(void* ptr, size_t size, size_t align) {
+        --*live;
+        Global().deallocate(ptr, size, align);
+    }
+};
+
+using CountedString = BasicString<CountingAlloc>;
+
+void test_string_basic() {
+    printf("test_string_basic: ");
+    {
+        auto s = String::from("hello");
+        s.push(' ');
+        s.push_str("world");
+        assert(s == "hello world");
+        assert(s.len() == 11);
+        assert(s.starts_with("hello") && s.ends_with("world"));
+        assert(s.find("world") == 6);
+        assert(s.pop() == 'd');
+        s.insert(0, ">> ");
+        assert(s == ">> hello worl");
+        s.drain(0, 3);
+        s.truncate(5);
+        assert(s == "hello");
+        assert(s.replace("l", "LL") == "heLLLLo");
+        assert(String::from("  pad  ").trim() == "pad");
+        assert(s.to_uppercase() == "HELLO");
+        assert(s.split('l').collect().size() == 3);
+        assert(String::from("abc") < String::from("abd"));
+        assert(std::strcmp(String::new_().c_str(), "") == 0);
+    }
+    printf("PASS\n");
+}
+
+void test_string_sso() {
+    printf("test_string_sso: ");
+    {
+        // RUSTY_STATS builds append two counters
+        constexpr size_t words = stats::ENABLED ? 5 : 3;
+        static_assert(sizeof(String) == words * sizeof(void*), "SSO keeps String at three words");
+        static_assert(String::INLINE_CAPACITY == 3 * sizeof(void*) - 1, "inline buffer fills the object");
+        static_assert(is_trivially_relocatable<String>::value, "SSO stores no self pointer");
+
+        long live = 0;
+        auto s = CountedString::new_in(CountingAlloc(&live));
+        assert(s.is_inline() && s.capacity() == CountedString::INLINE_CAPACITY);
+
+        // Filling the inline buffer exactly keeps the terminator in the tag byte
+        for (size_t i = 0; i < CountedString::INLINE_CAPACITY; i++) {
+            s.push(static_cast<char>('a' + i % 26));
+            assert(s.len() == i + 1);
+            assert(s.c_str()[i + 1] == '\0');
+        }
+        assert(s.is_inline() && live == 0);
+        assert(std::strlen(s.c_str()) == CountedString::INLINE_CAPACITY);
+
+        // One more byte spills to the heap with the contents intact
+        s.push('!');
+        assert(!s.is_inline() && live == 1);
+        assert(s.len() == CountedString::INLINE_CAPACITY + 1);
+        assert(s[0] == 'a' && s[s.len() - 1] == '!');
+
+        // Short copies stay inline even when the source is on the heap
+        auto prefix = CountedString::new_in(CountingAlloc(&live));
+        prefix.push_str("abc");
+        auto copy = prefix.clone();
+        assert(copy.is_inline() && copy == prefix);
+        assert(live == 1);
+
+        // Moves hand over inline bytes and heap buffers alike
+        auto moved = std::move(s);
+        assert(s.is_empty() && s.is_inline());
+        assert(moved.len() == CountedString::INLINE_CAPACITY + 1);
+        auto moved_short = std::move(copy);
+        assert(moved_short == "abc" && copy.is_empty());
+        moved = std::move(moved_short);
+        assert(moved == "abc" && live == 0);
+
+        // Shrinking a heap string keeps its buffer
+        auto big = CountedString::new_in(CountingAlloc(&live));
+        big.reserve(100);
+        assert(!big.is_inline() && big.capacity() >= 100 && live == 1);
+        big.push_str("x");
+        big.clear();
+        assert(big.is_empty() && !big.is_inline());
+    }
+    printf("PASS\n");
+}
+
+void test_string_views() {
+    printf("test_string_views: ");
+    {
+        long live = 0;
+        auto line = CountedString::new_in(CountingAlloc(&live));
+        line.push_str("  2024-01-01 INFO  request=42,path=/index,,status=200  ");
+        assert(live == 1);
+
+        // Pieces borrow from the source without allocating
+        str trimmed = line.trim();
+        assert(trimmed.as_ptr() == line.as_ptr() + 2);
+        assert(trimmed.len() == line.len() - 4);
+        assert(line.trim_start().len() == line.len() - 2);
+        assert(line.trim_end().as_ptr() == line.as_ptr());
+
+        std::vector<str> words = line.split_whitespace().collect();
+        assert(words.size() == 3);
+        assert(words[0] == "2024-01-01" && words[1] == "INFO");
+
+        auto fields = words[2].split(',');
+        assert(fields.next().unwrap() == "request=42");
+        assert(fields.next().unwrap() == "path=/index");
+        assert(fields.next().unwrap() == "");
+        assert(fields.next().unwrap() == "status=200");
+        assert(fields.next().is_none());
+        assert(live == 1);
+
+        // Multi-byte patterns and Rust's edge cases
+        std::vector<str> parts = str("a::b::").split("::").collect();
+        assert(parts.size() == 3 && parts[0] == "a" && parts[2] == "");
+        assert(str("").split(',').collect().size() == 1);
+        assert(str("abc").split("").collect().size() == 1);
+        assert(str(" \t ").split_whitespace().next().is_none());
+
+        size_t count = 0;
+        for (str l : str("one\r\ntwo\n\nfour\n").lines()) {
+            assert(l.len() == 0 || l[l.len() - 1] != '\r');
+            count++;
+        }
+        assert(count == 4);
+        assert(str("").lines().next().is_none());
+        assert(str("x").lines().next().unwrap() == "x");
+
+        // Embedded separators inside a range-for
+        size_t total = 0;
+        for (str piece : line.split('=')) total += piece.len();
+        assert(total == line.len() - 3);
+
+        auto mixed = String::from("MiXeD 123 \xC3\xA9");
+        mixed.make_ascii_lowercase();
+        assert(mixed == "mixed 123 \xC3\xA9");
+        mixed.make_ascii_uppercase();
+        assert(mixed == "MIXED 123 \xC3\xA9");
+    }
+    printf("PASS\n");
+}
+
+void test_string_search() {
+    printf("test_string_search: ");
+    {
+        // Embedded NULs are ordinary bytes
+        auto s = String::from(std::string_view("key\0value\0key=2", 15));
+        assert(s.len() == 15);
+        assert(s.find(str("value", 5)) == 4);
+        assert(s.find(str("\0key", 4)) == 9);
+        assert(s.contains('='));
+        assert(!s.contains("missing"));
+        assert(s.split('\0').collect().size() == 3);
+        auto replaced = s.replace(str("\0", 1), ";");
+        assert(replaced == "key;value;key=2");
+
+        // Cross-check against std::string_view at every chunk boundary
+        srand(7);
+        for (int round = 0; round < 2000; round++) {
+            std::string hay(rand() % 100, 'a');
+            for (auto& c : hay) c = static_cast<char>('a' + rand() % 3);
+            std::string needle(1 + rand() % 6, 'a');
+            for (auto& c : needle) c = static_cast<char>('a' + rand() % 3);
+            std::string_view hv(hay), nv(needle);
+            assert(str(hv).find(str(nv)) == hv.find(nv));
+            assert(str(hv).find(needle[0]) == hv.find(needle[0]));
+        }
+        std::string wide(1000, 'x');
+        wide[997] = 'y';
+        assert(str(wide).find('y') == 997);
+        assert(str(wide).find("xy") == 996);
+        assert(str(wide).find("yx") == 997);
+        assert(str(wide).find("xyz") == BYTES_NPOS);
+        assert(str(wide).find("") == 0);
+
+        assert(s.starts_with("key") && s.ends_with("=2") && s.starts_with(""));
+        assert(str().starts_with("") && !str().contains('a'));
+        assert(str(wide).is_ascii() && !str("caf\xC3\xA9").is_ascii());
+    }
+    printf("PASS\n");
+}
+
+void test_string_utf8() {
+    printf("test_string_utf8: ");
+    {
+        auto ok = String::from_utf8("h\xC3\xA9llo \xE2\x82\xAC \xF0\x9F\x98\x80");
+        assert(ok.is_ok());
+        assert(ok.unwrap().len() == 15);
+
+        // A long ASCII run followed by an error past the first chunks
+        std::string text(100, 'a');
+        text += "\xC3";
+        auto truncated = String::from_utf8(std::string_view(text));
+        assert(truncated.is_err());
+        Utf8Error err = truncated.unwrap_err();
+        assert(err.valid_up_to() == 100 && err.error_len().is_none());
+
+        struct Case { const char* bytes; size_t valid_up_to; size_t error_len; };
+        const Case cases[] = {
+            {"ab\x80", 2, 1},              // stray continuation byte
+            {"\xC0\xAF", 0, 1},            // overlong two-byte form
+            {"\xE0\x80\xAF", 0, 1},        // overlong three-byte form
+            {"\xED\xA0\x80", 0, 1},        // UTF-16 surrogate
+            {"\xF4\x90\x80\x80", 0, 1},    // above U+10FFFF
+            {"x\xE2\x82x", 1, 2},          // bad third byte
+            {"\xF0\x9F\x98z", 0, 3},        // bad fourth byte
+            {"\xFF", 0, 1},
+        };
+        for (const Case& c : cases) {
+            auto r = str::from_utf8(c.bytes, std::strlen(c.bytes));
+            assert(r.is_err());
+            Utf8Error e = r.unwrap_err();
+            assert(e.valid_up_to() == c.valid_up_to);
+            assert(e.error_len().unwrap() == c.error_len);
+        }
+        auto partial = str::from_utf8("\xF0\x9F", 2);
+        assert(partial.unwrap_err().error_len().is_none());
+        assert(str::from_utf8("", 0).is_ok());
+        assert(str::from_utf8("\xF4\x8F\xBF\xBF", 4).is_ok());
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::String ===\n");
+
+    test_string_basic();
+    test_string_sso();
+    test_string_views();
+    test_string_search();
+    test_string_utf8();
+
+    printf("\nAll String tests passed!\n");
+    return 0;
+}
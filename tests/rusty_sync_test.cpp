@@ -0,0 +1,147 @@
+// Tests for rusty::Mutex<T> / rusty::RwLock<T>
+#include "../include/rusty/sync.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace rusty;
+
+// Test lock/try_lock and guard ownership on one thread
+void test_mutex_basic() {
+    printf("test_mutex_basic: ");
+    {
+        Mutex<std::vector<int>> m(std::vector<int>{1, 2});
+        assert(!m.is_locked());
+        {
+            auto guard = m.lock();
+            assert(m.is_locked());
+            guard->push_back(3);
+            assert((*guard).size() == 3);
+
+            // Already held: try_lock fails
+            assert(m.try_lock().is_none());
+
+            auto moved = std::move(guard);
+            assert(m.is_locked());
+            assert(moved->back() == 3);
+        }
+        assert(!m.is_locked());
+
+        auto maybe = m.try_lock();
+        assert(maybe.is_some());
+        maybe.unwrap()->push_back(4);
+        assert(!m.is_locked());
+
+        m.get_mut().push_back(5);
+        std::vector<int> inner = m.into_inner();
+        assert(inner.size() == 5 && inner[4] == 5);
+    }
+    // A guard is one pointer; Option of it uses the null niche
+    static_assert(sizeof(Option<MutexGuard<int>>) == sizeof(void*), "guard niche");
+    printf("PASS\n");
+}
+
+// Test that contended increments are never lost
+void test_mutex_threads() {
+    printf("test_mutex_threads: ");
+    {
+        Mutex<long> counter(0);
+        const int PER_THREAD = 20000;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([&counter]() {
+                for (int i = 0; i < PER_THREAD; i++) {
+                    auto guard = counter.lock();
+                    *guard += 1;
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+        assert(*counter.lock() == 4L * PER_THREAD);
+    }
+    printf("PASS\n");
+}
+
+// Test shared and exclusive access on one thread
+void test_rwlock_basic() {
+    printf("test_rwlock_basic: ");
+    {
+        RwLock<std::string> lock(std::string("hello"));
+        {
+            auto r1 = lock.read();
+            auto r2 = lock.read();
+            assert(*r1 == "hello" && r2->size() == 5);
+            // Readers block writers
+            assert(lock.try_write().is_none());
+            assert(lock.try_read().is_some());
+        }
+        {
+            auto w = lock.write();
+            *w += " world";
+            // A writer blocks readers and other writers
+            assert(lock.try_read().is_none());
+            assert(lock.try_write().is_none());
+        }
+        assert(*lock.read() == "hello world");
+
+        lock.get_mut() += "!";
+        assert(lock.into_inner() == "hello world!");
+    }
+    printf("PASS\n");
+}
+
+// Test readers racing writers; readers must never see a half-written pair
+void test_rwlock_threads() {
+    printf("test_rwlock_threads: ");
+    {
+        struct Pair {
+            long a;
+            long b;
+        };
+        RwLock<Pair> lock(Pair{0, 0});
+        std::atomic<bool> done(false);
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 6; t++) {
+            readers.emplace_back([&lock, &done]() {
+                long last = 0;
+                while (!done.load(std::memory_order_relaxed)) {
+                    auto guard = lock.read();
+                    assert(guard->a == guard->b);
+                    assert(guard->a >= last);
+                    last = guard->a;
+                }
+            });
+        }
+        const int WRITES = 5000;
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 2; t++) {
+            writers.emplace_back([&lock]() {
+                for (int i = 0; i < WRITES; i++) {
+                    auto guard = lock.write();
+                    guard->a++;
+                    guard->b++;
+                }
+            });
+        }
+        for (auto& w : writers) w.join();
+        done.store(true);
+        for (auto& r : readers) r.join();
+        assert(lock.read()->a == 2L * WRITES);
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::Mutex<T> / rusty::RwLock<T> ===\n");
+
+    test_mutex_basic();
+    test_mutex_threads();
+    test_rwlock_basic();
+    test_rwlock_threads();
+
+    printf("\nAll sync tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,171 @@
+// Tests for rusty::Task, rusty::Runtime and rusty::io::AsyncFd (C++20)
+#include "../include/rusty/task.hpp"
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <thread>
+
+using namespace rusty;
+
+typedef Result<int, const char*> ParseResult;
+
+static Task<int> add(int a, int b) { co_return a + b; }
+
+static Task<int> sum_to(int n) {
+    int total = 0;
+    for (int i = 1; i <= n; i++) total = co_await add(total, i);
+    co_return total;
+}
+
+static Task<ParseResult> parse_digit(char c) {
+    if (c < '0' || c > '9') co_return ParseResult::Err("not a digit");
+    co_return ParseResult::Ok(c - '0');
+}
+
+static Task<ParseResult> parse_number(const char* text) {
+    int value = 0;
+    for (const char* p = text; *p; p++) {
+        ParseResult digit = co_await parse_digit(*p);
+        if (digit.is_err()) co_return digit;
+        value = value * 10 + digit.unwrap();
+    }
+    co_return ParseResult::Ok(value);
+}
+
+static Task<int> fails() {
+    co_await add(1, 2);
+    throw std::runtime_error("task failed");
+}
+
+// Test awaiting, Result values, exceptions and the frame pools
+void test_task_await() {
+    printf("test_task_await: ");
+    {
+        ThreadPool pool(2);
+        Runtime rt(pool);
+        assert(rt.block_on(add(2, 3)) == 5);
+        assert(rt.block_on(sum_to(10000)) == 50005000);  // deep await chains need no stack
+        assert(rt.block_on(parse_number("1234")).unwrap() == 1234);
+        assert(std::strcmp(rt.block_on(parse_number("12x4")).unwrap_err(), "not a digit") == 0);
+
+        bool threw = false;
+        try {
+            rt.block_on(fails());
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw);
+
+        int seen = 0;
+        auto set = [](int& out) -> Task<void> {
+            out = co_await add(40, 2);
+        };
+        rt.block_on(set(seen));
+        assert(seen == 42);
+
+        // Never awaited: the frame is freed without running
+        { Task<int> dropped = add(1, 1); }
+
+        void* frame = detail::frame_allocate(100);
+        size_t free_before = Pool<detail::FrameBlock<128>>::local_free();
+        detail::frame_deallocate(frame, 100);
+        assert(Pool<detail::FrameBlock<128>>::local_free() == free_before + 1);
+        assert(detail::frame_allocate(120) == frame);
+        detail::frame_deallocate(frame, 120);
+    }
+    printf("PASS\n");
+}
+
+// Test detached tasks and yield_now
+void test_task_spawn() {
+    printf("test_task_spawn: ");
+    {
+        ThreadPool pool(3);
+        Runtime rt(pool);
+        std::atomic<int> done(0);
+        auto work = [](Runtime& r, std::atomic<int>& counter, int i) -> Task<void> {
+            int x = co_await add(i, 1);
+            co_await r.yield_now();
+            if (x > 0) counter++;
+        };
+        for (int i = 0; i < 10000; i++) rt.spawn(work(rt, done, i));
+        while (done.load() < 10000) std::this_thread::yield();
+    }
+    printf("PASS\n");
+}
+
+static Task<Result<size_t, io::Error>> send_all(io::AsyncFd& fd, const Vec<uint8_t>& data) {
+    Result<void, io::Error> r = co_await fd.write_all(data.as_slice());
+    if (r.is_err()) co_return Result<size_t, io::Error>::Err(r.unwrap_err());
+    co_return Result<size_t, io::Error>::Ok(data.len());
+}
+
+// Test non-blocking sockets and files through the reactor
+void test_task_async_fd() {
+    printf("test_task_async_fd: ");
+    {
+        ThreadPool pool(2);
+        Runtime rt(pool);
+
+        // A read that has to wait for the peer
+        int fds[2];
+        assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+        io::AsyncFd reader = io::AsyncFd::new_(io::File::from_raw_fd(fds[0]), rt).unwrap();
+        io::File peer = io::File::from_raw_fd(fds[1]);
+        std::thread later([&peer] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            assert(io::write_all(peer, Slice<uint8_t>(reinterpret_cast<const uint8_t*>("hello"), 5)).is_ok());
+        });
+        Vec<uint8_t> got;
+        assert(rt.block_on(reader.read(got)).unwrap() == 5 && got.len() == 5 && got[4] == 'o');
+        later.join();
+
+        // 4 MB through a socket buffer far smaller than that: both sides
+        // suspend many times
+        assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+        Vec<uint8_t> data;
+        for (size_t i = 0; i < 4 * 1024 * 1024; i++) data.push(uint8_t(i * 7 + i / 4096));
+        std::atomic<bool> sent(false);
+        {
+            io::AsyncFd out = io::AsyncFd::new_(io::File::from_raw_fd(fds[0]), rt).unwrap();
+            io::AsyncFd in = io::AsyncFd::new_(io::File::from_raw_fd(fds[1]), rt).unwrap();
+            auto producer = [](io::AsyncFd fd, const Vec<uint8_t>& bytes, std::atomic<bool>& flag) -> Task<void> {
+                Result<size_t, io::Error> r = co_await send_all(fd, bytes);
+                assert(r.is_ok() && r.unwrap() == bytes.len());
+                flag = true;
+            };  // fd is dropped at the end: the reader sees end of input
+            rt.spawn(producer(std::move(out), data, sent));
+            Vec<uint8_t> received;
+            assert(rt.block_on(in.read_to_end(received)).unwrap() == data.len());
+            assert(received.len() == data.len() && std::memcmp(received.as_ptr(), data.as_ptr(), data.len()) == 0);
+        }
+        assert(sent.load());
+
+        // Regular files are never "not ready"
+        const char* path = "rusty_task_test.txt";
+        {
+            io::AsyncFd file = io::AsyncFd::new_(io::File::create(path).unwrap(), rt).unwrap();
+            assert(rt.block_on(send_all(file, data)).unwrap() == data.len());
+        }
+        io::AsyncFd file = io::AsyncFd::new_(io::File::open(path).unwrap(), rt).unwrap();
+        Vec<uint8_t> back;
+        assert(rt.block_on(file.read_to_end(back)).unwrap() == data.len() && back[12345] == data[12345]);
+        std::remove(path);
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::Task ===\n");
+
+    test_task_await();
+    test_task_spawn();
+    test_task_async_fd();
+
+    printf("\nAll Task tests passed!\n");
+    return 0;
+}
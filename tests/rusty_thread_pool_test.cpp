@@ -0,0 +1,146 @@
+// Tests for rusty::ThreadPool
+#include "../include/rusty/thread_pool.hpp"
+#include "../include/rusty/par_iter.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <stdexcept>
+
+using namespace rusty;
+
+static long long fib(ThreadPool& pool, int n) {
+    if (n < 2) return n;
+    if (n < 12) return fib(pool, n - 1) + fib(pool, n - 2);
+    long long a = 0, b = 0;
+    pool.join([&] { a = fib(pool, n - 1); }, [&] { b = fib(pool, n - 2); });
+    return a + b;
+}
+
+// Test recursive join, from outside and inside the pool
+void test_thread_pool_join() {
+    printf("test_thread_pool_join: ");
+    {
+        ThreadPool pool(4);
+        assert(pool.num_threads() == 4 && pool.current_thread_index().is_none());
+        assert(fib(pool, 25) == 75025);
+
+        std::atomic<int> outside(0);
+        pool.install([&] {
+            assert(pool.current_thread_index().unwrap() < 4);
+            assert(&ThreadPool::current() == &pool);
+            outside = fib(pool, 20) == 6765 ? 1 : -1;
+        });
+        assert(outside.load() == 1);
+
+        // Exceptions from either side reach the caller after both finish
+        std::atomic<int> finished(0);
+        bool threw = false;
+        try {
+            pool.join([&] { finished++; }, [&] { finished++; throw std::runtime_error("b"); });
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw && finished.load() == 2);
+
+        ThreadPool single(1);
+        assert(fib(single, 18) == 2584);
+        assert(ThreadPool(0).num_threads() == 1);
+    }
+    printf("PASS\n");
+}
+
+// Test scope: borrowed tasks, nested spawns and error propagation
+void test_thread_pool_scope() {
+    printf("test_thread_pool_scope: ");
+    {
+        ThreadPool pool(3);
+        Vec<int> slots;
+        slots.resize(1000, 0);
+        std::atomic<int> nested(0);
+        pool.scope([&](Scope& s) {
+            for (size_t i = 0; i < slots.len(); i++) {
+                s.spawn([&slots, i] { slots[i] = static_cast<int>(i) * 2; });
+            }
+            s.spawn([&] {
+                for (int k = 0; k < 10; k++) s.spawn([&] { nested++; });
+            });
+        });
+        for (size_t i = 0; i < slots.len(); i++) assert(slots[i] == static_cast<int>(i) * 2);
+        assert(nested.load() == 10);
+
+        std::atomic<int> ran(0);
+        bool threw = false;
+        try {
+            pool.scope([&](Scope& s) {
+                for (int i = 0; i < 50; i++) {
+                    s.spawn([&, i] {
+                        ran++;
+                        if (i == 7) throw std::logic_error("task");
+                    });
+                }
+            });
+        } catch (const std::logic_error&) {
+            threw = true;
+        }
+        assert(threw && ran.load() == 50);
+
+        pool.scope([](Scope&) {});  // an empty scope returns
+    }
+    printf("PASS\n");
+}
+
+// Test detached spawns, which all run before the pool is dropped
+void test_thread_pool_spawn() {
+    printf("test_thread_pool_spawn: ");
+    {
+        std::atomic<int> count(0);
+        std::atomic<int> nested(0);
+        {
+            ThreadPool pool(2);
+            for (int i = 0; i < 1000; i++) {
+                pool.spawn([&count, &nested, &pool, i] {
+                    count++;
+                    if (i % 100 == 0) pool.spawn([&nested] { nested++; });
+                });
+            }
+        }
+        assert(count.load() == 1000 && nested.load() == 10);
+
+        std::atomic<bool> done(false);
+        spawn([&done] { done = true; });
+        while (!done.load()) std::this_thread::yield();
+    }
+    printf("PASS\n");
+}
+
+// Test pinned placement and running par_iter on a chosen pool
+void test_thread_pool_placement() {
+    printf("test_thread_pool_placement: ");
+    {
+        ThreadPool compact(3, Placement::Compact);
+        ThreadPool spread(3, Placement::Spread);
+        assert(fib(compact, 20) == 6765 && fib(spread, 20) == 6765);
+
+        Vec<int> v;
+        for (int i = 0; i < 10000; i++) v.push(i);
+        long long total = 0;
+        spread.install([&] {
+            assert(current_num_threads() == 3);
+            total = par_iter(v).map([](const int& x) { return (long long)x; }).sum();
+        });
+        assert(total == 9999LL * 10000 / 2);
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::ThreadPool ===\n");
+
+    test_thread_pool_join();
+    test_thread_pool_scope();
+    test_thread_pool_spawn();
+    test_thread_pool_placement();
+
+    printf("\nAll ThreadPool tests passed!\n");
+    return 0;
+}
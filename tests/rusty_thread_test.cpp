@@ -0,0 +1,168 @@
+// Tests for rusty::thread::scope and the Send/Sync markers
+#include "../include/rusty/thread.hpp"
+#include "../include/rusty/arc.hpp"
+#include "../include/rusty/box.hpp"
+#include "../include/rusty/hashmap.hpp"
+#include "../include/rusty/mpsc.hpp"
+#include "../include/rusty/rc.hpp"
+#include "../include/rusty/smallvec.hpp"
+#include "../ref_cell.h"
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <functional>
+#include <stdexcept>
+
+using namespace rusty;
+
+// Compile-time checks of the marker traits
+static_assert(is_send<int>::value && is_sync<int>::value, "scalars");
+static_assert(!is_send<Rc<int>>::value && !is_sync<Rc<int>>::value, "Rc");
+static_assert(!is_send<Weak<int>>::value, "Weak");
+static_assert(is_send<Arc<int>>::value && is_sync<Arc<int>>::value, "Arc");
+static_assert(!is_send<Arc<Rc<int>>>::value && !is_sync<Arc<Rc<int>>>::value, "Arc of Rc");
+static_assert(is_send<CacheAlignedArc<Vec<int>>>::value, "aligned Arc");
+static_assert(!is_send<Vec<Rc<int>>>::value && is_send<Vec<Arc<int>>>::value, "Vec");
+static_assert(!is_send<Box<Rc<int>>>::value && is_send<Box<int>>::value, "Box");
+static_assert(!is_send<Option<Rc<int>>>::value, "Option");
+static_assert(!is_send<HashMap<int, Rc<int>>>::value && is_sync<HashMap<int, int>>::value, "HashMap");
+static_assert(!is_send<SmallVec<Rc<int>, 4>>::value && is_send<SmallVec<int, 4>>::value, "SmallVec");
+static_assert(!is_send<const Rc<int>&>::value && is_send<const Vec<int>&>::value, "references");
+static_assert(!is_send<std::reference_wrapper<Rc<int>>>::value, "std::ref");
+static_assert(is_send<rust::RefCell<int>>::value && !is_sync<rust::RefCell<int>>::value, "RefCell");
+static_assert(!is_send<Arc<rust::RefCell<int>>>::value, "Arc of RefCell");
+static_assert(is_send<Arc<Mutex<rust::RefCell<int>>>>::value, "Arc of Mutex of RefCell");
+static_assert(!is_sync<RwLock<rust::RefCell<int>>>::value, "RwLock of RefCell");
+static_assert(!is_send<Slice<rust::RefCell<int>>>::value && is_send<SliceMut<rust::RefCell<int>>>::value, "slices");
+static_assert(is_send<mpsc::Receiver<int>>::value && !is_sync<mpsc::Receiver<int>>::value, "Receiver");
+
+static long long sum_range(const Vec<int>& v, size_t from, size_t to) {
+    long long total = 0;
+    for (size_t i = from; i < to; i++) total += v[i];
+    return total;
+}
+
+// Test borrowing stack data from scoped threads
+void test_thread_scope_borrow() {
+    printf("test_thread_scope_borrow: ");
+    {
+        Vec<int> data;
+        for (int i = 0; i < 100000; i++) data.push(i);
+        long long total = thread::scope([&](thread::Scope& s) {
+            thread::ScopedJoinHandle<long long> left = s.spawn([&] { return sum_range(data, 0, 50000); });
+            thread::ScopedJoinHandle<long long> right = s.spawn([&] { return sum_range(data, 50000, data.len()); });
+            return left.join() + right.join();
+        });
+        assert(total == 99999LL * 100000 / 2);
+
+        // Disjoint mutable borrows, left for the scope to join
+        Vec<int> out;
+        out.resize(8, 0);
+        thread::scope([&](thread::Scope& s) {
+            for (size_t i = 0; i < out.len(); i++) {
+                s.spawn([&out, i] { out[i] = static_cast<int>(i * i); });
+            }
+        });
+        for (size_t i = 0; i < out.len(); i++) assert(out[i] == static_cast<int>(i * i));
+
+        // Threads spawning more threads on the same scope
+        std::atomic<int> count(0);
+        thread::scope([&](thread::Scope& s) {
+            for (int i = 0; i < 4; i++) {
+                s.spawn([&] {
+                    for (int k = 0; k < 4; k++) s.spawn([&] { count++; });
+                    count++;
+                });
+            }
+        });
+        assert(count.load() == 20);
+    }
+    printf("PASS\n");
+}
+
+// Test values moved into threads through spawn's arguments
+void test_thread_scope_args() {
+    printf("test_thread_scope_args: ");
+    {
+        Arc<int> shared = Arc<int>::make(7);
+        Vec<int> owned;
+        owned.push(1);
+        owned.push(2);
+        int local = 5;
+        thread::scope([&](thread::Scope& s) {
+            thread::ScopedJoinHandle<int> a = s.spawn([](Arc<int> p, int x) { return *p + x; }, shared.clone(), 3);
+            thread::ScopedJoinHandle<size_t> b = s.spawn([](Vec<int> v) { return v.len(); }, std::move(owned));
+            s.spawn([](int& x) { x *= 2; }, std::ref(local));
+            assert(a.join() == 10 && b.join() == 2);
+        });
+        assert(shared.strong_count() == 1 && local == 10);
+
+        std::atomic<bool> go(false);
+        thread::scope([&](thread::Scope& s) {
+            thread::ScopedJoinHandle<void> h = s.spawn([&go] {
+                while (!go.load()) std::this_thread::yield();
+            });
+            assert(!h.is_finished());
+            go = true;
+            h.join();
+        });
+    }
+    printf("PASS\n");
+}
+
+// Test exceptions: join rethrows, scope rethrows for unjoined threads
+void test_thread_scope_exceptions() {
+    printf("test_thread_scope_exceptions: ");
+    {
+        bool caught = false;
+        thread::scope([&](thread::Scope& s) {
+            thread::ScopedJoinHandle<int> h = s.spawn([]() -> int { throw std::runtime_error("thread"); });
+            try {
+                h.join();
+            } catch (const std::runtime_error&) {
+                caught = true;
+            }
+        });  // joined and handled: nothing more is thrown
+        assert(caught);
+
+        std::atomic<int> ran(0);
+        bool threw = false;
+        try {
+            thread::scope([&](thread::Scope& s) {
+                for (int i = 0; i < 4; i++) {
+                    s.spawn([&, i] {
+                        ran++;
+                        if (i == 2) throw std::logic_error("unjoined");
+                    });
+                }
+            });
+        } catch (const std::logic_error&) {
+            threw = true;
+        }
+        assert(threw && ran.load() == 4);
+
+        // The closure's own exception wins, after every thread has finished
+        threw = false;
+        try {
+            thread::scope([&](thread::Scope& s) {
+                s.spawn([&] { ran++; throw std::logic_error("thread"); });
+                throw std::runtime_error("body");
+            });
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw && ran.load() == 5);
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::thread ===\n");
+
+    test_thread_scope_borrow();
+    test_thread_scope_args();
+    test_thread_scope_exceptions();
+
+    printf("\nAll thread tests passed!\n");
+    return 0;
+}
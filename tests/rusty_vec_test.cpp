@@ -1,7 +1,10 @@
 // Tests for rusty::Vec<T>
 #include "../include/rusty/vec.hpp"
+#include "../include/rusty/box.hpp"
 #include <cassert>
 #include <cstdio>
+#include <list>
+#include <string>
 
 using namespace rusty;
 
@@ -177,6 +180,24 @@ void test_vec_clone() {
         vec[0] = 15;
         // Clone is independent
         assert(vec2[0] == 10);
+
+        // Sized to the elements, not the source's capacity
+        vec.reserve(100);
+        assert(vec.clone().capacity() == 3);
+        auto strings = Vec<std::string>::new_();
+        for (int i = 0; i < 10; i++) strings.push(std::string(30, 'a' + i));
+        auto strings2 = strings.clone();
+        strings.clear();
+        assert(strings2.len() == 10 && strings2[9] == std::string(30, 'j'));
+        assert(Vec<int>::new_().clone().capacity() == 0);
+
+        // Move-only elements are cloned with their clone()
+        auto nested = Vec<Vec<int>>::new_();
+        nested.push(vec_of({1, 2}));
+        nested.push(vec_of({3}));
+        auto nested2 = nested.clone();
+        nested[0].push(9);
+        assert(nested2.len() == 2 && nested2[0].len() == 2 && nested2[1][0] == 3);
     }
     printf("PASS\n");
 }
@@ -269,6 +290,204 @@ void test_vec_size() {
     printf("PASS\n");
 }
 
+// Test growth through the trivially-relocatable fast path
+void test_vec_relocation() {
+    printf("test_vec_relocation: ");
+    {
+        static_assert(is_trivially_relocatable<int>::value, "int is relocatable");
+        static_assert(is_trivially_relocatable<Box<int>>::value, "Box is relocatable");
+        static_assert(is_trivially_relocatable<Vec<int>>::value, "Vec is relocatable");
+        static_assert(!is_trivially_relocatable<TestStruct>::value,
+                      "types with user-defined moves are not relocatable");
+        
+        auto ints = Vec<int>::new_();
+        for (int i = 0; i < 1000; i++) {
+            ints.push(i);
+        }
+        for (int i = 0; i < 1000; i++) {
+            assert(ints[i] == i);
+        }
+        
+        auto boxes = Vec<Box<int>>::new_();
+        for (int i = 0; i < 100; i++) {
+            boxes.push(Box<int>::new_(i));
+        }
+        boxes.reserve(1000);
+        assert(boxes.cap() >= 1000);
+        for (int i = 0; i < 100; i++) {
+            assert(*boxes[i] == i);
+        }
+    }
+    TestStruct::instances = 0;
+    {
+        auto vec = Vec<TestStruct>::new_();
+        for (int i = 0; i < 100; i++) {
+            vec.push(TestStruct(i));
+        }
+        vec.reserve(500);
+        assert(TestStruct::instances == 100);
+        assert(vec[99].value == 99);
+    }
+    assert(TestStruct::instances == 0);
+    printf("PASS\n");
+}
+
+// Test that the first push allocates more than one slot
+void test_vec_min_capacity() {
+    printf("test_vec_min_capacity: ");
+    {
+        auto bytes = Vec<char>::new_();
+        bytes.push('a');
+        assert(bytes.cap() == 8);
+
+        auto ints = Vec<int>::new_();
+        ints.push(1);
+        assert(ints.cap() == 4);
+        for (int i = 0; i < 4; i++) ints.push(i);
+        assert(ints.cap() == 8);
+
+        struct Big { char data[2048]; };
+        auto bigs = Vec<Big>::new_();
+        bigs.push(Big());
+        assert(bigs.cap() == 1);
+
+        // Explicit capacities are kept exactly
+        auto exact = Vec<int>::with_capacity(1);
+        assert(exact.cap() == 1);
+    }
+    printf("PASS\n");
+}
+
+// Test bulk appends: slices, iterator ranges, append, resize
+void test_vec_extend() {
+    printf("test_vec_extend: ");
+    {
+        auto v = Vec<int>::new_();
+        int src[] = {1, 2, 3, 4, 5};
+        v.extend_from_slice(src, 5);
+        assert(v.len() == 5 && v[4] == 5);
+        // One reservation for the whole slice
+        assert(v.cap() == 5);
+
+        // Appending from our own storage survives the reallocation
+        v.extend_from_slice(v.as_ptr(), v.len());
+        assert(v.len() == 10 && v[9] == 5);
+
+        std::list<int> more = {6, 7};
+        v.extend(more.begin(), more.end());
+        assert(v.back() == 7);
+
+        auto tail = vec_of({8, 9});
+        v.append(tail);
+        assert(tail.is_empty() && v.len() == 14 && v[13] == 9);
+
+        v.resize(16, -1);
+        assert(v.len() == 16 && v[15] == -1);
+        v.resize(3, 0);
+        assert(v.len() == 3 && v[2] == 3);
+        v.truncate(10);
+        assert(v.len() == 3);
+
+        auto words = Vec<std::string>::new_();
+        words.extend_from_slice({"a", "b"});
+        words.resize(4, words[0]);
+        assert(words[3] == "a");
+    }
+    printf("PASS\n");
+}
+
+// Test positional insert/remove and range drain
+void test_vec_insert_remove() {
+    printf("test_vec_insert_remove: ");
+    {
+        auto v = vec_of({1, 2, 5});
+        v.insert(2, 4);
+        v.insert(2, 3);
+        v.insert(0, 0);
+        v.insert(v.len(), 6);
+        for (int i = 0; i <= 6; i++) assert(v[i] == i);
+
+        int mid[] = {10, 11};
+        v.insert_from_slice(1, mid, 2);
+        assert(v.len() == 9 && v[0] == 0 && v[1] == 10 && v[2] == 11 && v[3] == 1);
+
+        assert(v.remove(1) == 10);
+        assert(v.remove(1) == 11);
+        assert(v.swap_remove(0) == 0);
+        assert(v[0] == 6 && v.len() == 6);
+
+        auto drained = v.drain(1, 4);
+        assert(drained.len() == 3);
+        assert(drained[0] == 1 && drained[2] == 3);
+        assert(v.len() == 3 && v[0] == 6 && v[1] == 4 && v[2] == 5);
+
+        auto names = Vec<std::string>::new_();
+        names.extend_from_slice({"x", "z"});
+        std::string y[] = {"y1", "y2"};
+        names.insert_from_slice(1, y, 2);
+        assert(names[1] == "y1" && names[2] == "y2" && names[3] == "z");
+        assert(names.remove(0) == "x");
+        auto tail = names.drain(1, 3);
+        assert(names.len() == 1 && names[0] == "y1" && tail[1] == "z");
+    }
+    TestStruct::instances = 0;
+    {
+        auto v = Vec<TestStruct>::new_();
+        for (int i = 0; i < 10; i++) v.push(TestStruct(i));
+        v.insert(5, TestStruct(100));
+        assert(v[5].value == 100 && v[6].value == 5);
+        v.remove(0);
+        auto gone = v.drain(0, 4);
+        assert(TestStruct::instances == 10);
+    }
+    assert(TestStruct::instances == 0);
+    printf("PASS\n");
+}
+
+// Test in-place filtering
+void test_vec_retain_dedup() {
+    printf("test_vec_retain_dedup: ");
+    {
+        auto v = vec_of({1, 1, 2, 3, 3, 3, 4, 1});
+        v.dedup();
+        assert(v.len() == 5);
+        assert(v[0] == 1 && v[1] == 2 && v[2] == 3 && v[3] == 4 && v[4] == 1);
+
+        v.retain([](const int& x) { return x % 2 == 1; });
+        assert(v.len() == 3 && v[0] == 1 && v[1] == 3 && v[2] == 1);
+
+        auto words = Vec<std::string>::new_();
+        words.extend_from_slice({"apple", "avocado", "banana", "blueberry", "cherry"});
+        words.dedup_by_key([](const std::string& s) { return s[0]; });
+        assert(words.len() == 3 && words[1] == "banana" && words[2] == "cherry");
+        words.retain([](const std::string& s) { return s.size() > 5; });
+        assert(words.len() == 2 && words[0] == "banana");
+    }
+    printf("PASS\n");
+}
+
+void test_vec_raw_parts() {
+    printf("test_vec_raw_parts: ");
+    {
+        auto v = Vec<std::string>::with_capacity(10);
+        v.push("a");
+        v.push("b");
+        v.shrink_to_fit();
+        assert(v.capacity() == 2 && v[1] == "b");
+
+        size_t len = 0, cap = 0;
+        std::string* raw = v.into_raw_parts(len, cap);
+        assert(v.is_empty() && v.capacity() == 0 && len == 2 && cap == 2);
+        auto back = Vec<std::string>::from_raw_parts(raw, len, cap);
+        assert(back.len() == 2 && back[0] == "a");
+
+        back.clear();
+        back.shrink_to_fit();
+        assert(back.capacity() == 0 && back.as_ptr() == nullptr);
+    }
+    printf("PASS\n");
+}
+
 int main() {
     printf("=== Testing rusty::Vec<T> ===\n");
     
@@ -284,6 +503,12 @@ int main() {
     test_vec_destructor();
     test_vec_of();
     test_vec_size();
+    test_vec_relocation();
+    test_vec_min_capacity();
+    test_vec_extend();
+    test_vec_insert_remove();
+    test_vec_retain_dedup();
+    test_vec_raw_parts();
     
     printf("\nAll Vec tests passed!\n");
     return 0;
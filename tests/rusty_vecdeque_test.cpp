@@ -0,0 +1,184 @@
+// Tests for rusty::VecDeque
+#include "../include/rusty/vecdeque.hpp"
+#include "../include/rusty/box.hpp"
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <string>
+
+using namespace rusty;
+
+// Test pushes and pops at both ends, with growth while wrapped
+void test_vecdeque_push_pop() {
+    printf("test_vecdeque_push_pop: ");
+    {
+        VecDeque<int> dq;
+        assert(dq.is_empty() && dq.capacity() == 0);
+        assert(dq.pop_front().is_none() && dq.pop_back().is_none());
+        assert(dq.front().is_none() && dq.back().is_none());
+
+        for (int i = 0; i < 3; i++) dq.push_back(i);
+        for (int i = 1; i <= 3; i++) dq.push_front(-i);
+        // -3 -2 -1 0 1 2, wrapped around the end of the buffer
+        assert(dq.len() == 6);
+        assert((dq.capacity() & (dq.capacity() - 1)) == 0);
+        assert(dq.front().unwrap() == -3 && dq.back().unwrap() == 2);
+        for (int i = 0; i < 6; i++) assert(dq[i] == i - 3);
+
+        assert(dq.pop_front().unwrap() == -3);
+        assert(dq.pop_back().unwrap() == 2);
+        dq.front_mut().unwrap() = 100;
+        assert(dq.get(0).unwrap() == 100 && dq.get(4).is_none());
+
+        // FIFO use: the ring never grows past its steady-state size
+        VecDeque<int> fifo = VecDeque<int>::with_capacity(16);
+        size_t cap = fifo.capacity();
+        for (int i = 0; i < 10000; i++) {
+            fifo.push_back(i);
+            if (fifo.len() > 10) assert(fifo.pop_front().unwrap() == i - 10);
+        }
+        assert(fifo.capacity() == cap);
+
+        // A stored null pointer pops as Some(nullptr), not None
+        VecDeque<int*> ptrs;
+        ptrs.push_back(nullptr);
+        auto popped = ptrs.pop_front();
+        assert(popped.is_some() && popped.unwrap() == nullptr && ptrs.is_empty());
+    }
+    printf("PASS\n");
+}
+
+// Test random operations against std::deque, for trivially relocatable
+// and non-trivial elements
+template<typename T, typename Make>
+static void check_against_model(Make make) {
+    VecDeque<T> dq;
+    std::deque<T> model;
+    for (int step = 0; step < 20000; step++) {
+        int op = rand() % 10;
+        T value = make(step);
+        if (op < 3) {
+            dq.push_back(value);
+            model.push_back(value);
+        } else if (op < 5) {
+            dq.push_front(value);
+            model.push_front(value);
+        } else if (op < 6 && !model.empty()) {
+            assert(dq.pop_front().unwrap() == model.front());
+            model.pop_front();
+        } else if (op < 7 && !model.empty()) {
+            assert(dq.pop_back().unwrap() == model.back());
+            model.pop_back();
+        } else if (op < 8) {
+            size_t index = rand() % (model.size() + 1);
+            dq.insert(index, value);
+            model.insert(model.begin() + index, value);
+        } else if (op < 9 && !model.empty()) {
+            size_t index = rand() % model.size();
+            assert(dq.remove(index).unwrap() == model[index]);
+            model.erase(model.begin() + index);
+        }
+        if (step % 500 == 0) {
+            assert(dq.len() == model.size());
+            size_t i = 0;
+            for (const T& x : dq) assert(x == model[i++]);
+        }
+    }
+    assert(dq.len() == model.size());
+    for (size_t i = 0; i < model.size(); i++) assert(dq[i] == model[i]);
+}
+
+void test_vecdeque_model() {
+    printf("test_vecdeque_model: ");
+    {
+        srand(31337);
+        check_against_model<int>([](int i) { return i; });
+        check_against_model<std::string>([](int i) { return std::to_string(i) + "-long-enough-to-allocate"; });
+    }
+    printf("PASS\n");
+}
+
+// Test as_slices and make_contiguous over every head position
+void test_vecdeque_slices() {
+    printf("test_vecdeque_slices: ");
+    {
+        for (size_t len = 0; len <= 8; len++) {
+            for (size_t shift = 0; shift < 8; shift++) {
+                VecDeque<std::string> dq = VecDeque<std::string>::with_capacity(8);
+                assert(dq.capacity() == 8);
+                for (size_t i = 0; i < shift; i++) dq.push_back("x");
+                for (size_t i = 0; i < shift; i++) dq.pop_front();
+                for (size_t i = 0; i < len; i++) dq.push_back(std::to_string(i));
+
+                std::pair<Slice<std::string>, Slice<std::string>> parts = dq.as_slices();
+                assert(parts.first.len() + parts.second.len() == len);
+                assert(parts.second.is_empty() || shift + len > 8);
+
+                SliceMut<std::string> run = dq.make_contiguous();
+                assert(run.len() == len && dq.as_slices().second.is_empty());
+                for (size_t i = 0; i < len; i++) assert(run[i] == std::to_string(i));
+                assert(dq.capacity() == 8);
+            }
+        }
+
+        VecDeque<int> dq = {1, 2, 3, 4, 5};
+        dq.rotate_left(2);
+        assert(dq[0] == 3 && dq[4] == 2);
+        dq.rotate_right(2);
+        assert(dq[0] == 1 && dq[4] == 5);
+    }
+    printf("PASS\n");
+}
+
+// Test iterators, retain, append, clone and ownership of elements
+void test_vecdeque_iter_and_ownership() {
+    printf("test_vecdeque_iter_and_ownership: ");
+    {
+        VecDeque<int> dq;
+        for (int i = 0; i < 10; i++) {
+            if (i % 2) dq.push_back(i);
+            else dq.push_front(i);
+        }
+        assert(dq.iter().count() == 10 && dq.iter().sum() == 45);
+        dq.iter_mut().for_each([](int& x) { x *= 10; });
+        assert(dq[0] == 80);
+
+        dq.retain([](const int& x) { return x >= 50; });
+        assert(dq.len() == 5);
+        VecDeque<int> copy = dq.clone();
+        assert(copy == dq);
+        VecDeque<int> more = {1, 2};
+        copy.append(more);
+        assert(more.is_empty() && copy.len() == 7 && copy.back().unwrap() == 2);
+        assert(copy != dq);
+
+        Vec<int> collected = std::move(copy).into_iter().collect();
+        assert(collected.len() == 7 && collected[6] == 2);
+
+        VecDeque<int> from = VecDeque<int>::from_vec(Vec<int>({7, 8, 9}));
+        assert(from.len() == 3 && from[2] == 9);
+
+        VecDeque<Box<int>> boxes;
+        for (int i = 0; i < 50; i++) boxes.push_front(Box<int>::make(i));
+        for (int i = 0; i < 20; i++) boxes.pop_back();
+        boxes.insert(3, Box<int>::make(-1));
+        assert(*boxes[3] == -1 && *boxes[0] == 49);
+        boxes.truncate(10);
+        auto it = std::move(boxes).into_iter();
+        assert(*it.next().unwrap() == 49);
+    }
+    printf("PASS\n");
+}
+
+int main() {
+    printf("=== Testing rusty::VecDeque ===\n");
+
+    test_vecdeque_push_pop();
+    test_vecdeque_model();
+    test_vecdeque_slices();
+    test_vecdeque_iter_and_ownership();
+
+    printf("\nAll VecDeque tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,127 @@
+use std::process::Command;
+use std::fs;
+
+// Just enough of rusty::Vec for the checker to see the accessors
+const PRELUDE: &str = r#"
+#include <cstddef>
+namespace rusty {
+template<typename T> class Vec {
+public:
+    size_t len() const { return 0; }
+    const T& get_unchecked(size_t i) const { return data_[i]; }
+    T& get_unchecked_mut(size_t i) { return data_[i]; }
+    T pop() { return data_[0]; }
+private:
+    T* data_;
+};
+}
+"#;
+
+fn run_checker(file: &str, code: &str) -> String {
+    fs::write(file, format!("{}{}", PRELUDE, code)).unwrap();
+
+    let output = Command::new("cargo")
+        .args(&["run", "--", file])
+        .env("DYLD_LIBRARY_PATH", "/opt/homebrew/Cellar/llvm/19.1.7/lib")
+        .output()
+        .expect("Failed to run borrow checker");
+
+    let _ = fs::remove_file(file);
+    String::from_utf8_lossy(&output.stdout).to_string()
+}
+
+#[test]
+fn test_unchecked_access_in_len_bounded_loop() {
+    let test_code = r#"
+// @safe
+int sum(const rusty::Vec<int>& v, rusty::Vec<int>& out) {
+    int total = 0;
+    for (size_t i = 0; i < v.len(); ++i) {
+        total += v.get_unchecked(i);
+    }
+    for (size_t j = 0; j < out.len(); j++) {
+        out.get_unchecked_mut(j) = total;
+    }
+    return total;
+}
+"#;
+
+    let stdout = run_checker("test_bounds_proven.cpp", test_code);
+
+    assert!(!stdout.contains("Unchecked access"),
+            "Indexes bounded by len() need no unsafe context. Output: {}", stdout);
+}
+
+#[test]
+fn test_unchecked_access_with_index_written_in_body() {
+    let test_code = r#"
+// @safe
+int skip(const rusty::Vec<int>& v) {
+    int total = 0;
+    for (size_t i = 0; i < v.len(); ++i) {
+        i++;
+        total += v.get_unchecked(i);  // ERROR: i may equal len
+    }
+    return total;
+}
+"#;
+
+    let stdout = run_checker("test_bounds_index_written.cpp", test_code);
+
+    assert!(stdout.contains("Unchecked access v.get_unchecked(i)"),
+            "Should reject an index the body writes. Output: {}", stdout);
+}
+
+#[test]
+fn test_unchecked_access_on_other_container() {
+    let test_code = r#"
+// @safe
+int mix(const rusty::Vec<int>& a, const rusty::Vec<int>& b) {
+    int total = 0;
+    for (size_t i = 0; i < a.len(); ++i) {
+        total += b.get_unchecked(i);  // ERROR: bounded by a, not b
+    }
+    return total;
+}
+"#;
+
+    let stdout = run_checker("test_bounds_other_container.cpp", test_code);
+
+    assert!(stdout.contains("Unchecked access b.get_unchecked(i)"),
+            "Should reject an index bounded by another container. Output: {}", stdout);
+}
+
+#[test]
+fn test_unchecked_access_after_shrink() {
+    let test_code = r#"
+// @safe
+int drain(rusty::Vec<int>& v) {
+    int total = 0;
+    for (size_t i = 0; i < v.len(); ++i) {
+        v.pop();
+        total += v.get_unchecked(i);  // ERROR: v shrank
+    }
+    return total;
+}
+"#;
+
+    let stdout = run_checker("test_bounds_shrink.cpp", test_code);
+
+    assert!(stdout.contains("Unchecked access v.get_unchecked(i)"),
+            "Should reject access after the container shrinks. Output: {}", stdout);
+}
+
+#[test]
+fn test_unchecked_access_outside_loop() {
+    let test_code = r#"
+// @safe
+int first(const rusty::Vec<int>& v) {
+    return v.get_unchecked(0);  // ERROR: nothing bounds the index
+}
+"#;
+
+    let stdout = run_checker("test_bounds_outside_loop.cpp", test_code);
+
+    assert!(stdout.contains("Unchecked access v.get_unchecked(...)"),
+            "Should reject an unbounded index. Output: {}", stdout);
+}
@@ -35,7 +35,6 @@ void test() {
     
     let output = Command::new("cargo")
         .args(&["run", "--", "test_if_both.cpp"])
-        .env("Z3_SYS_Z3_HEADER", "/opt/homebrew/include/z3.h")
         .env("DYLD_LIBRARY_PATH", "/opt/homebrew/Cellar/llvm/19.1.7/lib")
         .output()
         .expect("Failed to run borrow checker");
@@ -87,7 +86,6 @@ void test() {
     
     let output = Command::new("cargo")
         .args(&["run", "--", "test_if_one.cpp"])
-        .env("Z3_SYS_Z3_HEADER", "/opt/homebrew/include/z3.h")
         .env("DYLD_LIBRARY_PATH", "/opt/homebrew/Cellar/llvm/19.1.7/lib")
         .output()
         .expect("Failed to run borrow checker");
@@ -136,7 +134,6 @@ void test() {
     
     let output = Command::new("cargo")
         .args(&["run", "--", "test_if_no_else.cpp"])
-        .env("Z3_SYS_Z3_HEADER", "/opt/homebrew/include/z3.h")
         .env("DYLD_LIBRARY_PATH", "/opt/homebrew/Cellar/llvm/19.1.7/lib")
         .output()
         .expect("Failed to run borrow checker");
@@ -172,7 +169,6 @@ void test() {
     
     let output = Command::new("cargo")
         .args(&["run", "--", "test_nested_if.cpp"])
-        .env("Z3_SYS_Z3_HEADER", "/opt/homebrew/include/z3.h")
         .env("DYLD_LIBRARY_PATH", "/opt/homebrew/Cellar/llvm/19.1.7/lib")
         .output()
         .expect("Failed to run borrow checker");
@@ -212,7 +208,6 @@ void test() {
     
     let output = Command::new("cargo")
         .args(&["run", "--", "test_if_else_borrows.cpp"])
-        .env("Z3_SYS_Z3_HEADER", "/opt/homebrew/include/z3.h")
         .env("DYLD_LIBRARY_PATH", "/opt/homebrew/Cellar/llvm/19.1.7/lib")
         .output()
         .expect("Failed to run borrow checker");
@@ -17,7 +17,6 @@ void test() {
     
     let output = Command::new("cargo")
         .args(&["run", "--", "test_pointer_deref.cpp"])
-        .env("Z3_SYS_Z3_HEADER", "/opt/homebrew/include/z3.h")
         .env("DYLD_LIBRARY_PATH", "/opt/homebrew/Cellar/llvm/19.1.7/lib")
         .output()
         .expect("Failed to run borrow checker");
@@ -47,7 +46,6 @@ void test() {
     
     let output = Command::new("cargo")
         .args(&["run", "--", "test_address_of.cpp"])
-        .env("Z3_SYS_Z3_HEADER", "/opt/homebrew/include/z3.h")
         .env("DYLD_LIBRARY_PATH", "/opt/homebrew/Cellar/llvm/19.1.7/lib")
         .output()
         .expect("Failed to run borrow checker");
@@ -79,7 +77,6 @@ void test() {
     
     let output = Command::new("cargo")
         .args(&["run", "--", "test_unsafe_pointers.cpp"])
-        .env("Z3_SYS_Z3_HEADER", "/opt/homebrew/include/z3.h")
         .env("DYLD_LIBRARY_PATH", "/opt/homebrew/Cellar/llvm/19.1.7/lib")
         .output()
         .expect("Failed to run borrow checker");
@@ -111,7 +108,6 @@ void test() {
     
     let output = Command::new("cargo")
         .args(&["run", "--", "test_references_safe.cpp"])
-        .env("Z3_SYS_Z3_HEADER", "/opt/homebrew/include/z3.h")
         .env("DYLD_LIBRARY_PATH", "/opt/homebrew/Cellar/llvm/19.1.7/lib")
         .output()
         .expect("Failed to run borrow checker");
@@ -144,7 +140,6 @@ namespace myapp {
     
     let output = Command::new("cargo")
         .args(&["run", "--", "test_namespace_pointers.cpp"])
-        .env("Z3_SYS_Z3_HEADER", "/opt/homebrew/include/z3.h")
         .env("DYLD_LIBRARY_PATH", "/opt/homebrew/Cellar/llvm/19.1.7/lib")
         .output()
         .expect("Failed to run borrow checker");
@@ -181,7 +176,6 @@ void unsafe_func() {
     
     let output = Command::new("cargo")
         .args(&["run", "--", "test_mixed_pointers.cpp"])
-        .env("Z3_SYS_Z3_HEADER", "/opt/homebrew/include/z3.h")
         .env("DYLD_LIBRARY_PATH", "/opt/homebrew/Cellar/llvm/19.1.7/lib")
         .output()
         .expect("Failed to run borrow checker");